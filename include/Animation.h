@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ACG {
+
+// Camera pose at a point in time; fov <= 0 keeps the camera's current field of view
+struct CameraKeyframe {
+    float time = 0.0f;
+    glm::vec3 position = glm::vec3(0.0f, 1.0f, 3.0f);
+    glm::vec3 target = glm::vec3(0.0f, 1.0f, 0.0f);
+    float fov = 0.0f;
+};
+
+// Instance motion at a point in time, applied in the instance's object space on top of its
+// transform from the scene file. Rotation is in degrees (X, then Y, then Z) and interpolated
+// per axis, so a key of 0 followed by 360 spins the object once.
+struct TransformKeyframe {
+    float time = 0.0f;
+    glm::vec3 translation = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+/**
+ * @brief Camera and per-instance keyframes of an animated sequence
+ * Camera positions and targets follow a Catmull-Rom spline through the keys (smooth fly-throughs);
+ * a turntable replaces the camera keys with an orbit around a target. Instance keys are interpolated
+ * linearly. Times are in seconds; frame i is sampled at i / fps.
+ */
+class AnimationSequence {
+public:
+    void SetFramesPerSecond(float fps) { m_fps = fps; }
+    float GetFramesPerSecond() const { return m_fps; }
+    // 0 = up to (and including) the last keyframe
+    void SetFrameCount(int frames) { m_frameCount = frames; }
+    int GetFrameCount() const;
+    float GetFrameTime(int frame) const { return static_cast<float>(frame) / m_fps; }
+
+    // 关键帧按时间排序插入
+    void AddCameraKeyframe(const CameraKeyframe& key);
+    void AddInstanceKeyframe(uint32_t instanceIndex, const TransformKeyframe& key);
+    // Orbit around target (at the given radius and height above it); the sequence ends just before the start pose
+    void SetTurntable(float revolutions, const glm::vec3& target, float radius, float height);
+
+    bool HasCameraAnimation() const { return m_turntable || !m_cameraKeys.empty(); }
+    CameraKeyframe SampleCamera(float time) const;
+    const std::map<uint32_t, std::vector<TransformKeyframe>>& GetInstanceTracks() const { return m_instanceTracks; }
+    // Object space transform of the instance track at time (identity without keys)
+    glm::mat4 SampleInstance(uint32_t instanceIndex, float time) const;
+
+    // 每帧的输出文件: "out/spin.ppm" -> "out/spin.0007.ppm"
+    static std::string GetFramePath(const std::string& outputPath, int frame);
+
+private:
+    float m_fps = 24.0f;
+    int m_frameCount = 0;
+    std::vector<CameraKeyframe> m_cameraKeys;
+    std::map<uint32_t, std::vector<TransformKeyframe>> m_instanceTracks;
+
+    bool m_turntable = false;
+    float m_turntableRevolutions = 1.0f;
+    glm::vec3 m_turntableTarget = glm::vec3(0.0f);
+    float m_turntableRadius = 3.0f;
+    float m_turntableHeight = 0.0f;
+};
+
+} // namespace ACG
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ACG {
+
+class Renderer;
+class AnimationSequence;
+
+/**
+ * @brief One offline render of a headless batch
+ * Set on the command line (--scene, --spp, ...) or as one line of a job file:
+ *     scene=scenes/cloud/cloud.obj output=out/cloud.ppm spp=256 bounces=8 width=1280 height=720
+ *     camera=0,1,5,0,1,0 fov=45 env=skybox/sky.exr psnr=30
+ * Relative paths in a job file are resolved against the file's directory; values with spaces
+ * may be quoted. Keys that are omitted keep the values of the previous job, so a file can
+ * render several views of one scene while the scene stays resident on the GPU.
+ */
+struct RenderJob {
+    std::string scenePath;
+    std::string environmentMapPath;      // Empty = no environment map
+    std::string outputPath;              // .exr writes EXR, anything else PPM
+    std::string statsPath;               // Renderer::SaveFrameStats() after the render (empty = skip)
+    std::string animationPath;           // Sequence (BatchRenderer::LoadAnimationFile); frames go to output.0000.ext, ...
+    int width = 1280;
+    int height = 720;
+    int samplesPerPixel = 64;
+    int maxBounces = 5;
+    // Camera defaults match Camera::Camera()
+    glm::vec3 cameraPosition = glm::vec3(0.0f, 1.0f, 3.0f);
+    glm::vec3 cameraTarget = glm::vec3(0.0f, 1.0f, 0.0f);
+    float fov = 60.0f;
+    // Benchmark only: time to reach psnrTarget (dB) relative to a reference image
+    float psnrTarget = 0.0f;             // 0 = no time-to-PSNR measurement
+    std::string referencePath;           // PPM reference; empty = rendered at referenceSamples
+    int referenceSamples = 0;            // 0 = 16 x samplesPerPixel
+};
+
+/**
+ * @brief Runs render jobs without the GUI, reusing one device and the resident scene
+ * Used by --headless (render jobs, exit code 0 when all succeeded) and --benchmark (render
+ * jobs and report load time, acceleration structure build time, camera rays per second and
+ * time-to-PSNR). The renderer must be initialized; jobs run on the calling thread.
+ */
+class BatchRenderer {
+public:
+    struct Options {
+        std::vector<RenderJob> jobs;
+        bool benchmark = false;
+        std::string reportPath;          // Benchmark results as JSON (empty = console only)
+    };
+
+    // 解析命令行 (不含程序名); 参数错误时抛出 std::runtime_error
+    static Options ParseArguments(const std::vector<std::string>& args);
+    // 每个非空且不以 # 开头的行为一个任务
+    static std::vector<RenderJob> LoadJobFile(const std::string& path);
+    static const char* GetUsage();
+    /**
+     * @brief Keyframes of an animated sequence, one per line (same key=value syntax as job files):
+     *     fps=24 frames=96
+     *     camera=0 position=0,1,5 target=0,1,0 fov=45
+     *     camera=2 position=4,2,2 target=0,1,0
+     *     instance=3 time=0 rotate=0,0,0
+     *     instance=3 time=4 rotate=0,360,0 translate=0,0.5,0
+     *     turntable=1 target=0,1,0 radius=5 height=1
+     * The first key names the line; without frames= the sequence ends at the last keyframe.
+     */
+    static AnimationSequence LoadAnimationFile(const std::string& path);
+
+    explicit BatchRenderer(Renderer& renderer);
+
+    // 返回失败的任务数
+    int Run(const Options& options);
+
+private:
+    struct BenchmarkResult {
+        std::string scene;
+        int width = 0;
+        int height = 0;
+        int samplesPerPixel = 0;
+        double loadMs = 0.0;             // Wall time of LoadSceneAsync (near zero when the scene was resident)
+        bool sceneReused = false;        // Resident scene reused: import, builds and uploads are 0
+        double importMs = 0.0;           // Scene::LoadTimings::totalMs of this job's load
+        double accelerationStructureMs = 0.0; // GPU time of the builds (and compaction)
+        double textureUploadMs = 0.0;    // GPU (copy queue) or CPU time of the texture uploads
+        double renderMs = 0.0;
+        double pathTracingMs = 0.0;
+        double raysPerSecond = 0.0;      // Camera paths per second, see FrameStats::raysPerSecond
+        float psnrTarget = 0.0f;
+        double timeToPsnrMs = -1.0;      // -1 = target not reached within samplesPerPixel
+        int samplesToPsnr = 0;
+        std::vector<std::pair<int, double>> psnrCurve; // (spp, dB)
+    };
+
+    static void ApplyOption(RenderJob& job, const std::string& key, const std::string& value, const std::string& baseDirectory);
+    // 两张 8 位 RGB 图像 (PPM) 之间的 PSNR (dB); 尺寸不同或读取失败时返回负值
+    static double ComputePSNR(const std::string& imagePath, const std::string& referencePath);
+
+    void Prepare(const RenderJob& job);
+    void Render(const RenderJob& job, const std::string& outputPath, int samplesPerPixel);
+    void RenderAnimation(const RenderJob& job);
+    BenchmarkResult Benchmark(const RenderJob& job);
+    static void PrintResult(const BenchmarkResult& result);
+    static bool WriteReport(const std::string& path, const std::vector<BenchmarkResult>& results);
+
+    Renderer& m_renderer;
+    std::string m_environmentMapPath;    // Currently loaded environment map
+    double m_lastLoadMs;
+};
+
+} // namespace ACG
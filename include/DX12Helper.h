@@ -30,8 +30,8 @@ namespace ACG {
         }
     }
 
-    // Helper to get a hardware adapter
-    inline Microsoft::WRL::ComPtr<IDXGIAdapter4> GetAdapter(bool useWarp) {
+    // Hardware adapters that can create a feature level 12.0 device, in DXGI order (the first drives the display)
+    inline std::vector<Microsoft::WRL::ComPtr<IDXGIAdapter4>> EnumerateHardwareAdapters() {
         Microsoft::WRL::ComPtr<IDXGIFactory4> dxgiFactory;
         UINT createFactoryFlags = 0;
 #if defined(_DEBUG)
@@ -39,14 +39,7 @@ namespace ACG {
 #endif
         ThrowIfFailed(CreateDXGIFactory2(createFactoryFlags, IID_PPV_ARGS(&dxgiFactory)));
 
-        if (useWarp) {
-            Microsoft::WRL::ComPtr<IDXGIAdapter1> warpAdapter;
-            ThrowIfFailed(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)));
-            Microsoft::WRL::ComPtr<IDXGIAdapter4> warpAdapter4;
-            ThrowIfFailed(warpAdapter.As(&warpAdapter4));
-            return warpAdapter4;
-        }
-
+        std::vector<Microsoft::WRL::ComPtr<IDXGIAdapter4>> adapters;
         Microsoft::WRL::ComPtr<IDXGIAdapter1> hardwareAdapter;
         for (UINT i = 0; dxgiFactory->EnumAdapters1(i, &hardwareAdapter) != DXGI_ERROR_NOT_FOUND; ++i) {
             DXGI_ADAPTER_DESC1 desc;
@@ -55,11 +48,32 @@ namespace ACG {
                 if (SUCCEEDED(D3D12CreateDevice(hardwareAdapter.Get(), D3D_FEATURE_LEVEL_12_0, __uuidof(ID3D12Device), nullptr))) {
                     Microsoft::WRL::ComPtr<IDXGIAdapter4> hardwareAdapter4;
                     ThrowIfFailed(hardwareAdapter.As(&hardwareAdapter4));
-                    return hardwareAdapter4;
+                    adapters.push_back(hardwareAdapter4);
                 }
             }
         }
-        return nullptr;
+        return adapters;
+    }
+
+    // Helper to get a hardware adapter
+    inline Microsoft::WRL::ComPtr<IDXGIAdapter4> GetAdapter(bool useWarp) {
+        Microsoft::WRL::ComPtr<IDXGIFactory4> dxgiFactory;
+        UINT createFactoryFlags = 0;
+#if defined(_DEBUG)
+        createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
+#endif
+        ThrowIfFailed(CreateDXGIFactory2(createFactoryFlags, IID_PPV_ARGS(&dxgiFactory)));
+
+        if (useWarp) {
+            Microsoft::WRL::ComPtr<IDXGIAdapter1> warpAdapter;
+            ThrowIfFailed(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)));
+            Microsoft::WRL::ComPtr<IDXGIAdapter4> warpAdapter4;
+            ThrowIfFailed(warpAdapter.As(&warpAdapter4));
+            return warpAdapter4;
+        }
+
+        std::vector<Microsoft::WRL::ComPtr<IDXGIAdapter4>> adapters = EnumerateHardwareAdapters();
+        return adapters.empty() ? nullptr : adapters[0];
     }
 
     // Helper to create a default buffer
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
@@ -12,7 +13,9 @@ public:
     ~Denoiser();
 
     // 初始化降噪器
-    bool Initialize();
+    // adapterLuid: 可选的渲染适配器LUID (8字节); 存在匹配的OIDN物理设备 (CUDA/HIP/SYCL) 时在该GPU上降噪,
+    // 否则使用默认设备 (通常是CPU)
+    bool Initialize(const uint8_t* adapterLuid = nullptr);
 
     // 对图像进行降噪
     // input: RGB float数组 (width * height * 3)
@@ -29,6 +32,43 @@ public:
         const float* normal = nullptr
     );
 
+    // 对半精度RGB图像降噪, 输入可带任意像素/行步长 (例如映射的 RGBA16F 回读缓冲区, 多余的通道被跳过)
+    // albedo/normal: 可选的半精度引导图, 与input步长相同, 可为nullptr
+    //   两者都提供时先各自预滤波, 再以 cleanAux 模式引导降噪
+    // output: 紧密排列的RGB float数组 (width * height * 3)
+    bool DenoiseHalf(
+        const void* input,
+        const void* albedo,
+        const void* normal,
+        size_t pixelByteStride,
+        size_t rowByteStride,
+        float* output,
+        int width,
+        int height
+    );
+
+    // 设备能否导入 D3D12 共享的 committed resource (ExternalMemoryTypeFlag::D3D12Resource)
+    bool SupportsD3D12SharedBuffers() const;
+
+    // 导入 ID3D12Device::CreateSharedHandle 得到的共享缓冲区; 替换之前导入的缓冲区
+    // 句柄在导入后由调用者关闭
+    bool ImportD3D12SharedBuffer(void* sharedHandle, size_t byteSize);
+    void ReleaseSharedBuffer();
+
+    // 在共享缓冲区内降噪, 所有图像均为带步长的半精度RGB (例如 RGBA16F 纹理的拷贝布局), 以字节偏移给出
+    // albedo/normal 原地预滤波; output 不能与 color 重叠 (失败时 color 仍可用)
+    // 调用前写入缓冲区的GPU工作必须已完成; 返回时结果已写回显存
+    bool DenoiseSharedHalf(
+        size_t colorOffset,
+        size_t albedoOffset,
+        size_t normalOffset,
+        size_t outputOffset,
+        size_t pixelByteStride,
+        size_t rowByteStride,
+        int width,
+        int height
+    );
+
     // 获取错误信息
     std::string GetError() const { return m_errorMessage; }
 
@@ -19,6 +19,18 @@ struct GUIState {
     int height = 720;
     int samplesPerPixel = 100;
     int maxBounces = 5;
+    int russianRouletteDepth = 3;  // Bounces before Russian roulette may end a path, 0 = off
+    int samplerType = 1;           // ACG::SamplerType: 0 = PCG, 1 = Sobol + blue noise
+    int samplesPerDispatch = 4;  // Samples traced per DispatchRays in the shader loop
+    int bucketSize = 0;          // Bucket (tile) size for offline renders, 0 = automatic
+    bool adaptiveSampling = true;
+    float adaptiveThreshold = 0.01f; // Relative standard error at which a pixel stops sampling
+    int adaptiveMinSamples = 32;
+    bool interactivePreview = true;  // Progressive path-traced viewport behind the GUI
+    int toneMapOperator = 0;         // ACG::ToneMapOperator: 0 = clamp, 1 = Reinhard, 2 = ACES
+    float exposureEV = 0.0f;
+    int exrCompression = 0;          // ACG::ExrCompression: 0 = ZIP, 1 = PIZ
+    bool exrAovLayers = false;       // Also write albedo/normal layers into .exr output
     char modelPath[512] = "";
     char outputPath[512] = "";
     char envMapPath[512] = "";
@@ -55,9 +67,6 @@ struct GUIState {
     // Render result texture for display
     ID3D12Resource* renderResultTexture = nullptr;
     ID3D12DescriptorHeap* renderResultSRVHeap = nullptr;
-    
-    // Pointers to external data
-    std::vector<std::string>* pLogMessages = nullptr;
 };
 
 // Initialize GUI state with default values
@@ -78,6 +87,12 @@ void RenderSettingsWindow(ACG::Renderer* renderer, GUIState& state, HWND hwnd);
 void RenderControlsWindow(ACG::Renderer* renderer, GUIState& state);
 void RenderCameraWindow(ACG::Renderer* renderer, GUIState& state);
 void RenderResultWindow(ACG::Renderer* renderer, GUIState& state);
-void RenderLogWindow(const std::vector<std::string>& logMessages);
+// Capped history of the Logger (ACG::Logger::CopyHistory), filtered by level
+void RenderLogWindow();
+// Per-phase GPU/CPU times, throughput and video memory of the last load and render (Renderer::GetFrameStats)
+void RenderProfilerWindow(ACG::Renderer* renderer, GUIState& state);
+
+// Right mouse drag rotates the viewport camera, WASD/QE (while dragging) moves it
+void UpdateViewportNavigation(ACG::Renderer* renderer, GUIState& state);
 
 } // namespace GUI
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace ACG {
+
+/**
+ * @brief Timestamp query ranges on one command queue, summed per phase
+ * BeginRange/EndRange bracket work on a command list with two timestamps; the pair is resolved
+ * into a persistently mapped readback buffer right after the end query. Submit() tags the ranges
+ * recorded so far with the fence value their lists signal, and Collect() adds the durations of
+ * completed ranges to the phase totals without waiting. Query slots form a ring that is recycled
+ * in submission order. Not thread safe: record, submit and collect on the thread owning the queue.
+ */
+class GpuProfiler {
+public:
+    static const UINT INVALID_RANGE = UINT_MAX;
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    /**
+     * @brief Create the query heap and readback buffer
+     * @param type TIMESTAMP for direct/compute queues, COPY_QUEUE_TIMESTAMP for copy queues
+     *             (requires D3D12_FEATURE_DATA_D3D12_OPTIONS3::CopyQueueTimestampQueriesSupported)
+     * @param maxRanges Ranges that may be recorded but not yet collected
+     */
+    void Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, D3D12_QUERY_HEAP_TYPE type,
+                    UINT phaseCount, UINT maxRanges = 1024);
+    void Shutdown();
+    bool IsInitialized() const { return m_queryHeap != nullptr; }
+
+    // 返回区间 id; 未初始化或查询槽用尽时返回 INVALID_RANGE (EndRange 忽略它)
+    UINT BeginRange(ID3D12GraphicsCommandList* cmdList, UINT phase);
+    void EndRange(ID3D12GraphicsCommandList* cmdList, UINT range);
+
+    // Ranges recorded since the last Submit complete when fence reaches fenceValue
+    void Submit(ID3D12Fence* fence, UINT64 fenceValue);
+    // Drop ranges whose command lists were closed without being executed (e.g. a stopped render)
+    void DiscardUnsubmitted();
+    // Accumulate every completed range (non-blocking)
+    void Collect();
+
+    void ResetPhase(UINT phase);
+    double GetPhaseMs(UINT phase) const { return phase < m_phaseMs.size() ? m_phaseMs[phase] : 0.0; }
+    UINT GetPhaseRangeCount(UINT phase) const { return phase < m_phaseRanges.size() ? m_phaseRanges[phase] : 0; }
+
+private:
+    struct Range {
+        UINT phase;
+        UINT slot;                // Queries 2 * slot (begin) and 2 * slot + 1 (end)
+        ID3D12Fence* fence;       // Null until submitted
+        UINT64 fenceValue;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_queryHeap;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_readbackBuffer;
+    const UINT64* m_timestamps;   // Mapped readback buffer, two ticks per slot
+    UINT64 m_frequency;           // Ticks per second of the queue
+    UINT m_maxRanges;
+    UINT m_nextSlot;
+    std::deque<Range> m_ranges;   // Recorded, not yet collected; oldest first
+    size_t m_unsubmittedRanges;   // Trailing entries of m_ranges without a fence
+    bool m_overflowWarned;
+
+    std::vector<double> m_phaseMs;
+    std::vector<UINT> m_phaseRanges;
+};
+
+} // namespace ACG
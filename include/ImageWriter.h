@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ACG {
+
+// EXR scanline compression (both lossless)
+enum class ExrCompression : uint32_t {
+    Zip = 0,  // 16 scanlines per block, good general purpose ratio
+    Piz = 1   // Wavelet, usually smaller for noisy/grainy renders
+};
+
+/**
+ * @brief Writes rendered images on a background thread
+ * A render opens a job with Begin(), streams finished rows (e.g. one row of buckets) with
+ * WriteRows() and closes it with End(). Encoding and disk I/O happen on one worker thread,
+ * so the renderer returns as soon as the last rows are queued and the next job can start
+ * while the previous frame is still being written. Jobs complete in submission order.
+ *
+ * PPM receives 8-bit RGB rows. EXR receives linear float rows and is written as half float
+ * scanlines, compressed with OpenEXR's thread pool; with AOV layers the file also holds
+ * "albedo.R/G/B" and "normal.X/Y/Z" channels.
+ */
+class ImageWriter {
+public:
+    enum class FileFormat {
+        PPM,
+        EXR
+    };
+
+    // 按扩展名选择格式 (.exr 为 EXR, 其余为 PPM)
+    static FileFormat GetFileFormat(const std::string& path);
+
+    ImageWriter();
+    ~ImageWriter();  // Finishes all queued jobs
+
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    /**
+     * @brief Open a new job; any previous job must have been ended
+     * The file is opened on the calling thread, so an invalid path throws std::runtime_error here.
+     * @param aovLayers EXR only: rows carry albedo and normal planes after the color plane
+     */
+    void Begin(const std::string& path, int width, int height, FileFormat format,
+               bool aovLayers = false, ExrCompression compression = ExrCompression::Zip);
+
+    // PPM rows: width * rows * 3 bytes
+    void WriteRows(int rows, std::vector<uint8_t> rgb);
+    // EXR rows: planes of width * rows * 3 floats (color, then albedo and normal with AOV layers)
+    void WriteRows(int rows, std::vector<float> planes);
+
+    // Close the open job (no-op without one); the file is finished in the background
+    void End();
+    // Close the open job and delete its file once the worker is done with it (e.g. a stopped render)
+    void Abort();
+
+    // Block until every queued job is written
+    void WaitIdle();
+
+    // Error of the most recent failed job, empty if all succeeded
+    std::string GetLastError() const;
+    // Encoding and disk I/O time of the most recently finished job (time spent waiting for rows excluded)
+    double GetLastJobMs() const;
+
+private:
+    struct Job;
+
+    void QueueRows(int rows, std::vector<uint8_t>* rgb, std::vector<float>* planes);
+    void WorkerLoop();
+    void ProcessJob(Job& job);
+
+    std::thread m_worker;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_jobFinished;
+    std::deque<std::shared_ptr<Job>> m_jobs;  // Front is being written
+    std::shared_ptr<Job> m_openJob;           // Receives WriteRows until End
+    bool m_shutdown;
+    std::string m_lastError;
+    double m_lastJobMs;
+};
+
+} // namespace ACG
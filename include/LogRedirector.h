@@ -1,16 +1,22 @@
 #pragma once
 
+#include "Logger.h"
+
+#include <cstring>
 #include <iostream>
-#include <sstream>
-#include <functional>
+#include <string>
 
 namespace ACG {
 
+/**
+ * @brief Sends every line written to a stream (std::cout, std::cerr) to the Logger
+ * Install after Logger::Start(), remove before Logger::Stop().
+ */
 class LogRedirector : public std::streambuf {
 public:
-    LogRedirector(std::ostream& stream, std::function<void(const std::string&)> callback)
+    LogRedirector(std::ostream& stream, LogLevel level)
         : m_stream(stream)
-        , m_callback(callback)
+        , m_level(level)
         , m_oldBuf(stream.rdbuf(this))
     {
     }
@@ -20,33 +26,47 @@ public:
     }
 
 protected:
+    // 解码等工作线程也会写日志: 每个线程在自己的缓冲区里拼行, 整行交给 Logger 的无锁队列, 因此不需要加锁
     virtual int overflow(int c) override {
         if (c != EOF) {
-            if (c == '\n') {
-                if (m_callback && !m_buffer.str().empty()) {
-                    m_callback(m_buffer.str());
-                }
-                m_buffer.str("");
-                m_buffer.clear();
-            } else {
-                m_buffer << static_cast<char>(c);
-            }
+            char ch = static_cast<char>(c);
+            Append(&ch, 1);
         }
         return c;
     }
 
     virtual std::streamsize xsputn(const char* s, std::streamsize n) override {
-        for (std::streamsize i = 0; i < n; ++i) {
-            overflow(s[i]);
-        }
+        Append(s, static_cast<size_t>(n));
         return n;
     }
 
 private:
+    // Partial line of the calling thread (one per level, i.e. per redirected stream)
+    std::string& PendingLine() {
+        static thread_local std::string lines[LOG_LEVEL_COUNT];
+        return lines[static_cast<uint32_t>(m_level)];
+    }
+
+    void Append(const char* s, size_t n) {
+        std::string& line = PendingLine();
+        for (size_t start = 0; start < n; ) {
+            const char* newline = static_cast<const char*>(memchr(s + start, '\n', n - start));
+            const size_t end = newline ? static_cast<size_t>(newline - s) : n;
+            line.append(s + start, end - start);
+            if (!newline) {
+                break;
+            }
+            if (!line.empty() && Logger::Get().IsEnabled(m_level)) {
+                Logger::Get().Write(m_level, std::move(line));
+            }
+            line.clear();
+            start = end + 1;
+        }
+    }
+
     std::ostream& m_stream;
-    std::function<void(const std::string&)> m_callback;
+    LogLevel m_level;
     std::streambuf* m_oldBuf;
-    std::ostringstream m_buffer;
 };
 
 } // namespace ACG
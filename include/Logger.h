@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ACG {
+
+enum class LogLevel : uint32_t {
+    Trace = 0,    // Per dispatch / per sample batch
+    Debug = 1,    // Per bucket, per texture, streaming
+    Info = 2,     // std::cout
+    Warning = 3,
+    Error = 4     // std::cerr
+};
+
+static const uint32_t LOG_LEVEL_COUNT = 5;
+
+/**
+ * @brief Process-wide log with a bounded lock-free queue and a background writer
+ * Write() only moves the line into a ring buffer slot (multi-producer, no locks); the writer
+ * thread timestamps it into the log file (flushed once per batch) and a capped history for the
+ * GUI. When the ring is full, Trace to Info lines are dropped and counted; warnings and errors wait
+ * for a free slot. Before Start() (and after Stop()) lines go straight to stdout / stderr through
+ * C stdio, so a redirector installed on std::cout / std::cerr never receives them back.
+ */
+class Logger {
+public:
+    struct Line {
+        LogLevel level = LogLevel::Info;
+        std::chrono::system_clock::time_point time;
+        std::string text;
+    };
+
+    static Logger& Get();
+
+    // 启动后台写线程; filePath 为空时只保留 GUI 历史
+    void Start(const std::string& filePath);
+    // Writes everything still queued and joins the writer
+    void Stop();
+
+    // Lines below the level are discarded before they are formatted (see ACG_LOG)
+    void SetMinLevel(LogLevel level) { m_minLevel.store(static_cast<uint32_t>(level), std::memory_order_relaxed); }
+    LogLevel GetMinLevel() const { return static_cast<LogLevel>(m_minLevel.load(std::memory_order_relaxed)); }
+    bool IsEnabled(LogLevel level) const {
+        return static_cast<uint32_t>(level) >= m_minLevel.load(std::memory_order_relaxed);
+    }
+
+    void Write(LogLevel level, std::string text);
+
+    /**
+     * @brief Copy the GUI history if lines arrived since version (the caller keeps both between frames)
+     * @return true if lines was replaced
+     */
+    bool CopyHistory(std::vector<Line>& lines, uint64_t& version) const;
+    void ClearHistory();
+    uint64_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static const char* GetLevelName(LogLevel level);
+
+private:
+    Logger();
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // Power of two; about 1 MB of queued text at typical line lengths
+    static const size_t RING_CAPACITY = 8192;
+    static const size_t HISTORY_CAPACITY = 2000;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Line line;
+    };
+
+    bool TryPush(Line& line);
+    bool TryPop(Line& line);  // Writer thread only
+    void WriterLoop();
+    // Appends to the log file and the GUI history, then clears batch
+    void WriteBatch(std::vector<Line>& batch);
+    void WriteDirect(const Line& line) const;
+
+    std::unique_ptr<Slot[]> m_ring;
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) size_t m_dequeuePos;
+    std::atomic<uint32_t> m_minLevel;
+    std::atomic<uint64_t> m_dropped;
+
+    std::atomic<bool> m_running;
+    std::thread m_writer;
+    std::ofstream m_file;
+
+    mutable std::mutex m_historyMutex;
+    std::deque<Line> m_history;
+    uint64_t m_historyVersion;
+};
+
+} // namespace ACG
+
+// Messages below this level are compiled out of the ACG_LOG_* macros: Info and above in release
+// builds, Debug and above in debug builds
+#ifndef ACG_LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define ACG_LOG_COMPILE_LEVEL 2
+#else
+#define ACG_LOG_COMPILE_LEVEL 1
+#endif
+#endif
+
+// ACG_LOG(ACG::LogLevel::Info, "Bucket " << index << "/" << count): the stream expression is only
+// evaluated when the level is enabled at run time
+#define ACG_LOG(level, expression) \
+    do { \
+        if (ACG::Logger::Get().IsEnabled(level)) { \
+            std::ostringstream acgLogStream; \
+            acgLogStream << expression; \
+            ACG::Logger::Get().Write(level, acgLogStream.str()); \
+        } \
+    } while (0)
+
+#if ACG_LOG_COMPILE_LEVEL <= 0
+#define ACG_LOG_TRACE(expression) ACG_LOG(ACG::LogLevel::Trace, expression)
+#else
+#define ACG_LOG_TRACE(expression) do { } while (0)
+#endif
+#if ACG_LOG_COMPILE_LEVEL <= 1
+#define ACG_LOG_DEBUG(expression) ACG_LOG(ACG::LogLevel::Debug, expression)
+#else
+#define ACG_LOG_DEBUG(expression) do { } while (0)
+#endif
+#define ACG_LOG_INFO(expression) ACG_LOG(ACG::LogLevel::Info, expression)
+#define ACG_LOG_WARNING(expression) ACG_LOG(ACG::LogLevel::Warning, expression)
+#define ACG_LOG_ERROR(expression) ACG_LOG(ACG::LogLevel::Error, expression)
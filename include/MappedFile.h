@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace ACG {
+
+/**
+ * @brief Read-only memory-mapped file
+ * Used by the .acg v2/v3 loader so geometry chunks can be copied straight from the
+ * page cache into GPU upload heaps without an intermediate heap allocation.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射整个文件 (只读)
+    bool Open(const std::string& path);
+    void Close();
+
+    const uint8_t* GetData() const { return m_data; }
+    uint64_t GetSize() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+
+private:
+    const uint8_t* m_data;
+    uint64_t m_size;
+    void* m_fileHandle;     // HANDLE on Windows, fd on other platforms
+    void* m_mappingHandle;  // HANDLE on Windows, unused elsewhere
+};
+
+} // namespace ACG
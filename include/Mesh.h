@@ -34,6 +34,16 @@ public:
     int GetMaterialIndex() const { return m_materialIndex; }
     std::string GetName() const { return m_name; }
     
+    // 打包几何范围 (.acg v2/v3): 顶点/索引保存在Scene::GetPackedGeometry()中, 不复制到本网格
+    void SetPackedRange(uint64_t firstVertex, uint32_t vertexCount, uint64_t firstIndex, uint32_t indexCount);
+    bool HasPackedRange() const { return m_hasPackedRange; }
+    uint64_t GetPackedFirstVertex() const { return m_packedFirstVertex; }
+    uint64_t GetPackedFirstIndex() const { return m_packedFirstIndex; }
+    
+    // 顶点/索引数量 (对打包网格同样有效)
+    uint32_t GetVertexCount() const;
+    uint32_t GetIndexCount() const;
+    
     // 生成基本几何体
     static std::shared_ptr<Mesh> CreateSphere(float radius, int segments);
     static std::shared_ptr<Mesh> CreateBox(const glm::vec3& size);
@@ -44,6 +54,7 @@ public:
     
     // 计算包围盒
     void ComputeBoundingBox();
+    void SetBoundingBox(const glm::vec3& bboxMin, const glm::vec3& bboxMax) { m_bboxMin = bboxMin; m_bboxMax = bboxMax; }
     glm::vec3 GetBBoxMin() const { return m_bboxMin; }
     glm::vec3 GetBBoxMax() const { return m_bboxMax; }
 
@@ -53,6 +64,12 @@ private:
     std::vector<uint32_t> m_indices;
     int m_materialIndex;
     
+    bool m_hasPackedRange;
+    uint64_t m_packedFirstVertex;
+    uint64_t m_packedFirstIndex;
+    uint32_t m_packedVertexCount;
+    uint32_t m_packedIndexCount;
+    
     glm::vec3 m_bboxMin;
     glm::vec3 m_bboxMax;
 };
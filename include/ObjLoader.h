@@ -0,0 +1,31 @@
+/*
+ * Wavefront OBJ/MTL Loader
+ * 进程内OBJ导入器, 直接构建Scene/Mesh, 无需Python转换和临时.acg文件
+ *
+ * 语义与 loader/wavefront_loader.py 保持一致:
+ *   - 每个材质生成一个网格
+ *   - Phong/MTL参数按相同规则转换为PBR (illum 5 = 镜面, illum 7 = 玻璃)
+ *   - 缺少法线的面使用面法线
+ * 解析按行块分配到多个线程, 网格构建按材质并行
+ */
+
+#pragma once
+#include <memory>
+#include <string>
+#include "Scene.h"
+
+namespace ACG {
+
+class ObjLoader {
+public:
+    /**
+     * @brief Parse an OBJ file (and referenced MTL libraries) into a new scene
+     * @throws std::runtime_error on unreadable files or out-of-range face indices
+     */
+    static std::unique_ptr<Scene> Load(const std::string& filepath);
+
+    // 是否由本导入器处理 (按扩展名, 不区分大小写)
+    static bool CanLoad(const std::string& filepath);
+};
+
+} // namespace ACG
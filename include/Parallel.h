@@ -0,0 +1,64 @@
+/*
+ * Parallel helpers
+ * 轻量的批量并行执行, 供场景导入/纹理解码等CPU密集的加载阶段使用
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace ACG {
+
+// Set on ParallelFor workers: nested calls (e.g. per-row work inside per-texture tasks) run inline
+// instead of multiplying the thread count
+inline thread_local bool t_inParallelFor = false;
+
+/**
+ * @brief Run func(i) for every i in [0, count) on a bounded set of worker threads
+ * Workers pull indices from a shared counter, so uneven task costs balance out.
+ * The first exception thrown by a task is rethrown after all workers have joined.
+ * Called from inside another ParallelFor, the loop runs on the calling worker.
+ * @param maxThreads Upper bound on worker threads (0 = hardware concurrency)
+ */
+template <typename Func>
+void ParallelFor(size_t count, Func&& func, size_t maxThreads = 0) {
+    size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t threadCount = std::min(count, maxThreads > 0 ? std::min(maxThreads, hardwareThreads) : hardwareThreads);
+    if (threadCount <= 1 || t_inParallelFor) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&]() {
+            t_inParallelFor = true;
+            for (size_t i = next++; i < count && !failed; i = next++) {
+                try {
+                    func(i);
+                } catch (...) {
+                    if (!failed.exchange(true)) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace ACG
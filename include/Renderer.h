@@ -4,13 +4,21 @@
 #include "Scene.h"
 #include "Camera.h"
 #include "Denoiser.h"
+#include "ImageWriter.h"
 #include "VirtualTextureSystem.h"
+#include "UploadRing.h"
+#include "GpuProfiler.h"
+#include "TileScheduler.h"
+#include "Animation.h"
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <wrl.h>
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <glm/glm.hpp>
 
 // Forward declare DXC interfaces
@@ -28,12 +36,84 @@ struct alignas(16) GPUMaterial {
 };
 
 namespace ACG {
+    // Display transform of the resolve pass (shaders/Resolve.hlsl), values match the shader constant
+    enum class ToneMapOperator : uint32_t {
+        Clamp = 0,     // Linear, clamped to [0, 1]
+        Reinhard = 1,
+        ACES = 2       // Narkowicz filmic fit
+    };
+
+    // Sample generator of the path tracer, values match SAMPLER_* in Raytracing.hlsl
+    enum class SamplerType : uint32_t {
+        PCG = 0,       // Per-pixel hashed white noise
+        Sobol = 1      // Owen-scrambled Sobol, blue-noise dithered across pixels
+    };
+
+    // Timed phases of scene loads and offline renders (index into FrameStats::phases)
+    enum class RenderPhase : uint32_t {
+        AccelerationStructureBuild = 0,  // BLAS/TLAS builds, compaction and refits
+        TextureUpload,                   // Texture batches on the copy queue
+        PathTracing,                     // DispatchRays batches
+        Readback,                        // Resolve, copies into the readback heap and the CPU conversion
+        Denoise,                         // OIDN, host or GPU-resident (timed on the CPU)
+        FileWrite,                       // ImageWriter encoding and disk I/O (background thread)
+        Count
+    };
+    static const uint32_t RENDER_PHASE_COUNT = static_cast<uint32_t>(RenderPhase::Count);
+
+    /**
+     * @brief Per-phase timings, throughput and memory of the last scene load and offline render
+     * GPU times come from timestamp queries (available in every build configuration), CPU times
+     * from scoped timers on the thread doing the work.
+     */
+    struct FrameStats {
+        struct Phase {
+            double gpuMs = 0.0;   // Sum of the phase's timestamp ranges (0 for CPU-only phases)
+            double cpuMs = 0.0;   // Recording, waiting and host work
+            uint32_t ranges = 0;  // Timed GPU ranges (e.g. dispatch batches)
+        };
+        Phase phases[RENDER_PHASE_COUNT];
+        Scene::LoadTimings sceneLoad;   // CPU phases of the last scene load
+
+        // Last offline render
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t samplesPerPixel = 0;
+        uint64_t pathSamples = 0;       // Camera paths dispatched: pixels x samples, converged pixels included
+        double renderMs = 0.0;          // RenderToFile wall time (the file may still be written afterwards)
+        double raysPerSecond = 0.0;     // Camera rays (paths) per second of path tracing GPU time (wall time with several GPUs)
+        uint32_t deviceCount = 1;       // GPUs that rendered buckets; phases and memory are those of the primary device
+
+        // Device-local memory of committed resources in bytes, by category
+        struct Memory {
+            uint64_t geometry = 0;                // Vertex, index, material and alpha mask buffers
+            uint64_t textures = 0;                // Bindless textures and the virtual texture cache
+            uint64_t environment = 0;             // Environment map and its CDFs
+            uint64_t accelerationStructures = 0;  // BLAS, TLAS and build scratch
+            uint64_t renderTargets = 0;           // Accumulation, AOV, resolve, denoise and swap chain buffers
+            uint64_t other = 0;                   // Sampler tables, shader table, counters
+            uint64_t adapterUsage = 0;            // DXGI local segment: usage of this process
+            uint64_t adapterBudget = 0;           //   and the budget the OS grants it
+        } memory;
+    };
+
     class Renderer {
     public:
         Renderer(UINT width, UINT height);
         ~Renderer();
 
         void OnInit(HWND hwnd);
+        // 将所有着色器变体编译进 DXIL 缓存 (构建时目标 precompile_shaders 使用, 无需设备); 任一必需变体失败时返回 false
+        static bool PrecompileShaders();
+        // 光线追踪管线: 在 RayGen 中用 DXR 1.1 RayQuery 内联追踪 (需在 OnInit 之前设置, 不支持 Tier 1.1 时回退)
+        void SetInlineRayQuery(bool enabled) { m_inlineRayQuery = enabled; }
+        bool IsInlineRayQueryEnabled() const { return m_inlineRayQuery; }
+        // Shader Execution Reordering: 按材质重排线程后再着色 (需 SM 6.9, 不支持时自动关闭; 需在 OnInit 之前设置)
+        void SetShaderExecutionReordering(bool enabled) { m_shaderExecutionReordering = enabled; }
+        bool IsShaderExecutionReorderingEnabled() const { return m_shaderExecutionReordering; }
+        // 多GPU离线渲染: OnInit 时为其余支持 DXR 的显卡各创建一个无交换链的渲染器并复制场景, 分块在所有显卡间动态分配 (需在 OnInit 之前设置)
+        void SetMultiGpu(bool enabled) { m_multiGpu = enabled; }
+        UINT GetRenderDeviceCount() const { return static_cast<UINT>(1 + m_peers.size()); }
         void OnUpdate();
         void OnRender();
         void OnDestroy();
@@ -41,21 +121,59 @@ namespace ACG {
 
         void LoadScene(const std::string& path);
         void LoadSceneAsync(const std::string& path); // Async version using independent command resources
+        // 上一次 LoadScene/LoadSceneAsync 是否因场景未变而直接复用常驻资源 (此时加载阶段统计仍属于更早的加载)
+        bool WasLastLoadReused() const { return m_lastLoadReused; }
+        // 输出格式按扩展名: .exr 为线性 HDR (可含 AOV 层), 其余为 8 位 PPM
+        // 文件在后台线程编码写入, 返回时可能尚未写完 (见 WaitForOutputFiles)
         void RenderToFile(const std::string& outputPath, int samplesPerPixel, int maxBounces);
+        // 渲染动画序列 (每帧一个文件, 见 AnimationSequence::GetFramePath): 帧间只更新相机常量并 refit TLAS,
+        // 上一帧最后一个分块的回读/降噪/编码与下一帧的 DispatchRays 重叠; 结束后恢复实例变换
+        void RenderSequence(const AnimationSequence& sequence, const std::string& outputPath, int samplesPerPixel, int maxBounces);
+        void WaitForOutputFiles() { m_imageWriter.WaitIdle(); }
         void SetEnvironmentMap(const std::string& path);  // Load HDR/EXR environment map
         void ClearEnvironmentMap();  // Clear/unload environment map
+        // 环境贴图的 mip 链: 上传后由计算着色器在 GPU 上生成 (关闭或管线不可用时在 CPU 上生成并一并上传)
+        void SetGpuMipmaps(bool enabled) { m_gpuMipmaps = enabled; }
+        bool IsGpuMipmapsEnabled() const { return m_gpuMipmaps; }
         
         // GUI控制方法
         void SetSamplesPerPixel(int spp) { m_samplesPerPixel = spp; }
         void SetMaxBounces(int bounces) { m_maxBounces = bounces; }
+        // 俄罗斯轮盘赌: 前 depth 次弹射后按路径通量随机终止 (0 = 关闭, 改为通量阈值截断)
+        void SetRussianRouletteDepth(int depth) { m_russianRouletteDepth = depth < 0 ? 0 : depth; }
+        // 采样序列: PCG 白噪声, 或 Owen 扰乱的 Sobol 序列 (像素间以蓝噪声偏移, 低采样数下误差呈蓝噪声分布)
+        void SetSamplerType(SamplerType type) { m_samplerType = type; }
+        SamplerType GetSamplerType() const { return m_samplerType; }
+        // 每次DispatchRays在着色器内循环的采样数 (过大可能触发TDR)
+        void SetSamplesPerDispatch(int samples) { m_samplesPerDispatch = samples < 1 ? 1 : samples; }
         void SetEnvironmentLightIntensity(float intensity) { m_environmentLightIntensity = intensity; }
         void SetSunDirection(const glm::vec3& dir);
         void SetSunColor(const glm::vec3& color);
         void SetSunIntensity(float intensity);
-        void ResetAccumulation() { m_accumulatedSamples = 0; }
+        void ResetAccumulation() { m_accumulatedSamples = 0; m_previewResetRequested = true; }
         int GetAccumulatedSamples() const { return m_accumulatedSamples; }
         int GetSamplesPerPixel() const { return m_samplesPerPixel; }
         int GetMaxBounces() const { return m_maxBounces; }
+        int GetRussianRouletteDepth() const { return m_russianRouletteDepth; }
+        int GetSamplesPerDispatch() const { return m_samplesPerDispatch; }
+        // 分块渲染的块大小 (像素), 0 = 自动 (超过 BUCKET_AUTO_PIXELS 时才分块)
+        void SetBucketSize(int size) { m_bucketSize = size < 0 ? 0 : size; }
+        int GetBucketSize() const { return m_bucketSize; }
+        // 自适应采样: 像素亮度相对标准误差低于阈值后停止采样 (阈值 0 = 关闭)
+        void SetAdaptiveSampling(float threshold, int minSamples) { m_adaptiveThreshold = threshold; m_adaptiveMinSamples = minSamples; }
+        // 交互式预览: 每帧向累积纹理追踪少量采样并显示在窗口中, 直到达到 SamplesPerPixel
+        void SetInteractivePreview(bool enabled) { m_interactivePreview = enabled; m_previewResetRequested = true; }
+        bool IsInteractivePreviewEnabled() const { return m_interactivePreview; }
+        // 输出与预览的色调映射; 曝光以EV (stops) 指定
+        void SetToneMapping(ToneMapOperator op, float exposureEV);
+        // EXR输出: 压缩方式, 以及是否附带 albedo/normal 层
+        void SetExrOptions(ExrCompression compression, bool aovLayers) { m_exrCompression = compression; m_exrAovLayers = aovLayers; }
+        int GetPreviewSamples() const { return m_previewSamples; }
+        // 最近一次场景加载与离线渲染的分阶段耗时、吞吐量与显存统计 (可在任意线程调用)
+        FrameStats GetFrameStats() const;
+        // 以 JSON 写出 GetFrameStats(); 失败时返回 false
+        bool SaveFrameStats(const std::string& path) const;
+        static const char* GetRenderPhaseName(RenderPhase phase);
         Scene* GetScene() { return m_scene.get(); }
         Camera* GetCamera() { return &m_camera; }
         void StopRender() { m_stopRenderRequested = true; }
@@ -67,16 +185,25 @@ namespace ACG {
     private:
         struct CameraConstants {
             glm::mat4 viewInverse;
-            glm::mat4 projInverse;
+            glm::uvec2 tileOffset;       // Pixel of the full image at DispatchRaysIndex (0, 0) (bucket rendering)
+            glm::uvec2 imageSize;        // Full image resolution; DispatchRaysDimensions is the bucket size
             uint32_t frameIndex;
             uint32_t maxBounces;
             float environmentLightIntensity;
-            float padding;
+            uint32_t useVirtualTextures; // 1 = sample base color through the virtual texture cache
             // cameraParams: x = FOV (degrees), y = aspectRatio, z = aperture, w = focusDistance
             glm::vec4 cameraParams;
             // Sun parameters packed as vec4 for safe alignment
             glm::vec4 sunDirIntensity; // xyz = direction (toward light), w = intensity
             glm::vec4 sunColorEnabled; // rgb = color, a = enabled (0 or 1)
+            uint32_t samplesPerDispatch; // RayGen loops this many samples starting at frameIndex
+            float adaptiveThreshold;     // Relative standard error at which a pixel stops (0 = off)
+            uint32_t adaptiveMinSamples; // Samples before a pixel may be considered converged
+            uint32_t lightCount;         // Emissive triangles in the light list (0 = no next-event estimation)
+            float lightTotalPower;       // Sum of luminance(emission) * area, normalizes the light selection pdf
+            uint32_t environmentSampling; // 1 = importance sample the environment map (CDFs bound in root parameter 14)
+            uint32_t russianRouletteDepth; // Bounces before paths may be terminated by Russian roulette (0 = off)
+            uint32_t samplerType;        // SamplerType
         };
 
         void InitPipeline(HWND hwnd);
@@ -87,19 +214,24 @@ namespace ACG {
         void CreateRenderTargets();
         void CreateRaytracingPipeline();
         void CreateAccelerationStructures(ID3D12GraphicsCommandList4* cmdList);
+        void WriteInstanceDescs();
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS GetTopLevelASInputs(bool performUpdate) const;
+        void BuildTopLevelAS(ID3D12GraphicsCommandList4* cmdList, bool performUpdate);
+        void RefitTopLevelAS(ID3D12GraphicsCommandList4* cmdList);  // Transform-only TLAS update
+        void WriteLightList();  // World-space emissive triangles and their alias table (after WriteInstanceDescs)
+        void CompactBottomLevelAS();  // Runs after the build list has executed; rebuilds TLAS on compacted BLAS
+        ID3D12Resource* AcquireScratchBuffer(UINT64 size);
+        void ReleaseScratchPool();
+        void BuildAlphaMasks();  // 1-bit cutout masks from base color alpha, before the geometry range scan
         void CreateShaderResources(ID3D12GraphicsCommandList4* cmdList);
         void CreateShaderBindingTable();
-        // Resource creation (allocation only, no data upload)
-        void CreateTextureArrayResource(int totalTextures, UINT maxWidth, UINT maxHeight);
+        // Resource and descriptor creation (allocation only, no data upload)
+        void CreateBindlessTextures(const std::vector<std::shared_ptr<Texture>>& textures, float dimensionScale);
         
-        // Data upload (assumes resource already created)
-        void UploadTextureBatchData(ID3D12GraphicsCommandList4* cmdList, 
+        // Data upload (assumes resources already created)
+        void UploadTextureBatchData(ID3D12GraphicsCommandList* cmdList, 
                                     const std::vector<std::shared_ptr<Texture>>& textures, 
-                                    int startIndex, UINT maxWidth, UINT maxHeight,
-                                    std::vector<glm::vec2>* outUvScales = nullptr);
-        
-        // State transition and descriptor creation
-        void FinalizeTextureArray(ID3D12GraphicsCommandList4* cmdList, int totalTextures);
+                                    int startIndex);
         
         // Virtual Texture System SRV creation
         void CreateVirtualTextureSRVs();
@@ -107,12 +239,92 @@ namespace ACG {
         Microsoft::WRL::ComPtr<ID3D12Resource> UploadEnvironmentMap(ID3D12GraphicsCommandList4* cmdList, const std::shared_ptr<Texture>& envMap);
         
         void CheckRaytracingSupport();
-        Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(const std::wstring& filename);
+        // Default arguments compile a DXR library; pass an entry point and profile for other stages.
+        // defines are passed as -D (e.g. L"INLINE_RAY_QUERY=1"). Results come from the DXIL cache (ShaderCache)
+        // while the source tree, arguments and compiler are unchanged
+        static Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(const std::wstring& filename,
+                                                       const std::wstring& entryPoint = L"",
+                                                       const std::wstring& target = L"lib_6_6",
+                                                       const std::vector<std::wstring>& defines = {});
         void CreateRaytracingRootSignature();
+        // Compute pipelines go through m_pipelineLibrary: loaded when a matching entry exists, otherwise created and stored
+        void OpenPipelineLibrary();
+        HRESULT CreateComputePipeline(const wchar_t* name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+                                      Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipeline);
+        void SavePipelineLibrary();  // Writes the library back if pipelines were added
+        void CreateResolvePipeline();  // Accumulation -> display texture compute pass
+        void CreateEnvironmentCdfPipeline();  // Environment importance sampling distribution (EnvironmentCDF.hlsl)
+        // Records the CDF build for m_environmentMap; the map must be readable by non-pixel shaders
+        void BuildEnvironmentCdf(ID3D12GraphicsCommandList4* cmdList, UINT width, UINT height);
+        void CreateMipmapPipeline();  // 2x2 box downsample compute pass (Mipmap.hlsl)
+        // Fills mips 1.. of a UAV-capable float texture from mip 0. Expects mip 0 in ALL_SHADER_RESOURCE and the
+        // other mips in UNORDERED_ACCESS; every mip ends in ALL_SHADER_RESOURCE
+        void GenerateMipsOnGpu(ID3D12GraphicsCommandList4* cmdList, ID3D12Resource* texture);
 
         void WaitForGpu();
         void MoveToNextFrame();
-        void PopulateCommandList();
+        
+        // Copy queue uploads: m_copyCommandList is open between Begin and Submit
+        void BeginCopyCommands();
+        UINT64 SubmitCopyCommands();  // Returns the m_copyFence value of this submission
+        Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferOnCopyQueue(const void* data, UINT64 size);
+        // GPU-side wait of the direct queue for copy queue work (no CPU stall)
+        void QueueWaitForCopies(UINT64 copyFenceValue);
+        
+        // Offline render loop helpers
+        void WaitForOfflineFence(UINT64 fenceValue);
+        // Bucket edge length for this render, 0 = render the full frame at once
+        UINT GetEffectiveBucketSize() const;
+        // (Re)create m_outputTexture, the luminance moments and their UAVs when the accumulation size changes
+        void EnsureOutputTexture(UINT width, UINT height);
+        void ClearAccumulation(ID3D12GraphicsCommandList4* cmdList, const D3D12_RECT& rect);
+        // Copy the active pixel count of the batch to readback slot `slot` and reset it
+        void RecordActivePixelReadback(ID3D12GraphicsCommandList4* cmdList, UINT slot);
+        uint32_t ReadActivePixelCount(UINT slot);  // Batch in that slot must have completed
+        // Pipeline state, descriptor heap and root parameters 0-9; root arguments do not survive a list Reset
+        void BindRaytracingRootArguments(ID3D12GraphicsCommandList4* cmdList);
+        // Root constants for a full frame of width x height from the current camera and lighting
+        CameraConstants BuildCameraConstants(UINT width, UINT height, int maxBounces) const;
+        D3D12_DISPATCH_RAYS_DESC GetDispatchRaysDesc() const;  // Shader table ranges; Width/Height are set by the caller
+        
+        // Interactive preview: records this frame's samples and the resolve into m_commandList.
+        // Returns false when nothing can be shown (no scene, preview disabled)
+        bool RecordPreview();
+        // (Re)create a resolve target and its UAV when size or format change
+        void EnsureResolveTarget(Microsoft::WRL::ComPtr<ID3D12Resource>& texture, UINT uavIndex, DXGI_FORMAT format,
+                                 UINT width, UINT height, const wchar_t* name);
+        // Average the accumulation into the target at uavIndex: linear for HDR targets, tone mapped otherwise.
+        // resolveAOVs also averages the albedo/normal guides into m_resolveAlbedo/NormalTexture.
+        // Leaves the resolve pipeline bound
+        void RecordResolve(ID3D12GraphicsCommandList4* cmdList, UINT uavIndex, UINT width, UINT height, bool hdrOutput,
+                           bool resolveAOVs = false);
+        // Tone map the linear image at sourceUavIndex into the 8-bit target at targetUavIndex
+        void RecordToneMap(ID3D12GraphicsCommandList4* cmdList, UINT sourceUavIndex, UINT targetUavIndex, UINT width, UINT height);
+        // Buffer shared with the denoiser's device (GPU-resident denoising); false when the device cannot import it
+        bool EnsureDenoiseSharedBuffer(UINT64 size);
+        void PopulateCommandList(bool drawPreview);
+        
+        // Profiling: the loading/rendering thread accumulates into m_workStats and the profilers,
+        // PublishFrameStats() collects finished ranges and hands a snapshot to GetFrameStats()
+        void ResetPhaseStats(RenderPhase phase);
+        void PublishFrameStats();
+        FrameStats::Memory MeasureMemory() const;
+        
+        // Render one frame into the scheduler on this device and every peer; false if it was stopped.
+        // beforeFirstBucket runs before the first bucket is delivered (after the previous frame's last one)
+        bool RenderFrame(TileScheduler& scheduler, ImageWriter::FileFormat fileFormat, int samplesPerPixel, int maxBounces,
+                         const std::function<void()>& beforeFirstBucket);
+        // Offline render of the buckets this device takes from the scheduler (called on one thread per device).
+        // The last bucket may still be finishing on its worker when this returns, see FinishPendingBucket()
+        void RenderTiles(TileScheduler& scheduler, ImageWriter::FileFormat fileFormat, int samplesPerPixel, int maxBounces,
+                         const std::function<void()>& beforeFirstBucket);
+        // Wait for the bucket being read back/denoised/converted on the worker; rethrows its error
+        void FinishPendingBucket();
+        void DiscardPendingBucket();  // Same, errors ignored (unwinding)
+        // Multi-GPU: one renderer per additional DXR adapter, kept in sync with this one
+        void CreatePeerRenderers();
+        void LoadPeerScenes(const std::string& path);
+        void CopyRenderSettingsTo(Renderer& peer) const;
 
         UINT m_width;
         UINT m_height;
@@ -124,13 +336,27 @@ namespace ACG {
         Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
         UINT64 m_fenceValue;
 
+        UINT m_adapterIndex = 0;  // Position among the hardware adapters (EnumerateHardwareAdapters)
         Microsoft::WRL::ComPtr<IDXGIAdapter4> m_adapter;
         Microsoft::WRL::ComPtr<ID3D12Device5> m_device;
         Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_commandQueue;
         Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_commandAllocators[FrameCount]; // One per frame
         Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> m_commandList;
+        
+        // Copy queue for scene uploads: copies overlap decode on the CPU, and the direct queue
+        // waits on m_copyFence only before the first work that reads the data
+        Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_copyQueue;
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_copyCommandAllocators[2];
+        UINT64 m_copyAllocatorSubmissions[2];   // Upload ring submission that last used each allocator
+        UINT m_copyAllocatorIndex;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_copyCommandList;
+        Microsoft::WRL::ComPtr<ID3D12Fence> m_copyFence;
+        UINT64 m_copyFenceValue;                // Last value signaled on the copy queue
+        UINT64 m_copyFenceWaited;               // Last value the direct queue waited for
+        UINT64 m_geometryCopyFenceValue;        // Copy fence value of the current scene's geometry
 
         Microsoft::WRL::ComPtr<IDXGISwapChain3> m_swapChain;
+        HANDLE m_frameLatencyWaitableObject = nullptr;  // Signaled when the swap chain accepts the next frame
         Microsoft::WRL::ComPtr<ID3D12Resource> m_renderTargets[FrameCount];
         Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_rtvHeap;
         UINT m_rtvDescriptorSize;
@@ -141,47 +367,152 @@ namespace ACG {
         // DXR
         Microsoft::WRL::ComPtr<ID3D12RootSignature> m_raytracingGlobalRootSignature;
         Microsoft::WRL::ComPtr<ID3D12RootSignature> m_raytracingEmptyLocalRootSignature;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> m_raytracingMaterialLocalRootSignature;  // Hit groups: Material (b1)
         Microsoft::WRL::ComPtr<ID3D12StateObject> m_dxrStateObject;
+        D3D12_RAYTRACING_TIER m_raytracingTier = D3D12_RAYTRACING_TIER_NOT_SUPPORTED;
+        bool m_inlineRayQuery = false;  // RayGen traces with RayQuery instead of TraceRay (compiled in)
+        bool m_shaderModel69 = false;   // Device accepts SM 6.9 libraries (HitObject / MaybeReorderThread)
+        bool m_shaderExecutionReordering = true;  // Requested until pipeline creation, then whether it is active
+        
+        // Pipeline library cache; the serialized data must outlive the library
+        std::vector<uint8_t> m_pipelineLibraryData;
+        Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> m_pipelineLibrary;
+        bool m_pipelineLibraryDirty = false;
+        
+        // Resolve pass (shaders/Resolve.hlsl): averages the accumulation into an RGBA8 display texture
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> m_resolveRootSignature;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> m_resolvePipelineState;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> m_toneMapPipelineState;  // Same root signature, ToneMapCS
+
+        // Environment CDF pass: row CDFs, then the marginal CDF over rows (one dispatch each)
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> m_envCdfRootSignature;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> m_envRowCdfPipelineState;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> m_envMarginalCdfPipelineState;
+
+        // Mip generation pass: one dispatch per level, reading the previous level
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> m_mipmapRootSignature;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> m_mipmapPipelineState;
+        bool m_gpuMipmaps = true;
 
         // DXR Acceleration Structure
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_bottomLevelAS;
+        // Per-mesh geometry range inside the unified vertex/index buffers
+        struct MeshGeometryRange {
+            UINT baseVertex;
+            UINT vertexCount;
+            UINT firstIndex;
+            UINT indexCount;
+            UINT firstEmitter = 0;  // Range in m_emissiveTriangles (object space)
+            UINT emitterCount = 0;
+            UINT materialIndex = UINT_MAX;  // Material of every triangle, selects the hit group (UINT_MAX = mixed)
+            UINT faceMaterialOffset = 0;    // Mixed ranges: first entry in the per-face material buffer
+            bool alphaTested = false;       // A material has an alpha mask: non-opaque BLAS with any-hit cutout
+        };
+        std::vector<MeshGeometryRange> m_meshRanges;  // Indexed by scene mesh index (duplicates share a range)
+        std::vector<int> m_meshBlasIndex;             // Scene mesh index -> BLAS slot (-1 = no geometry)
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_bottomLevelAS;  // One BLAS per unique mesh
         Microsoft::WRL::ComPtr<ID3D12Resource> m_topLevelAS;
+        UINT m_tlasInstanceCount;
+        D3D12_RAYTRACING_INSTANCE_DESC* m_mappedInstanceDescs;  // Persistently mapped for refits
+        
+        // Next-event estimation: emissive triangles collected during geometry upload (object space),
+        // expanded per instance into the GPU light list (world space + alias table, matches Raytracing.hlsl)
+        struct EmissiveTriangle {
+            glm::vec3 p0, p1, p2;
+            glm::vec3 emission;
+        };
+        struct GPULight {
+            glm::vec3 p0; uint32_t alias;       // Alias table: entry taken when the draw fails probability
+            glm::vec3 edge1; float probability;
+            glm::vec3 edge2; float pmf;         // Selection probability, luminance(emission) * area / total
+            glm::vec3 emission; float area;
+        };
+        static_assert(sizeof(GPULight) == 64, "GPULight must match the HLSL EmissiveLight layout");
+        std::vector<EmissiveTriangle> m_emissiveTriangles;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_lightBuffer;  // Upload heap, rewritten by refits like the instance descs
+        GPULight* m_mappedLights = nullptr;
+        UINT m_lightCount = 0;
+        float m_lightTotalPower = 0.0f;
+        
+        // Scratch pool shared by all builds during a load, released once compaction has finished
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_scratchPoolBuffer;
+        UINT64 m_scratchPoolSize = 0;
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_retiredScratchBuffers;
+        UINT64 m_tlasBuildScratchSize = 0;
+        
+        // Post-build compacted sizes (GPU-written, then read back for compaction)
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_blasCompactedSizeBuffer;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_blasCompactedSizeReadback;
         
-        // Keep these temporary resources alive until GPU finishes using them
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_blasScratchBuffer;
+        // Kept alive for TLAS refits
         Microsoft::WRL::ComPtr<ID3D12Resource> m_tlasScratchBuffer;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_instanceMaterialBuffer;  // Upload heap, material id per TLAS instance
         Microsoft::WRL::ComPtr<ID3D12Resource> m_instanceDescBuffer;
         
         // Upload buffers - must be kept alive until GPU copy completes!
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_vertexUpload;
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_indexUpload;
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_triangleMaterialUpload;
+        // (geometry is staged in m_uploadRing and copied on the copy queue)
         Microsoft::WRL::ComPtr<ID3D12Resource> m_materialUpload;
         Microsoft::WRL::ComPtr<ID3D12Resource> m_materialLayersUpload;  // Upload heap for material layers (新增)
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_textureUpload;  // Upload heap for textures
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_textureUpload;  // Upload heap for textures too large for the ring
+        
+        // Persistent staging memory shared by texture uploads and VT tile streaming
+        UploadRing m_uploadRing;
 
         // DXR Shader Resources
         Microsoft::WRL::ComPtr<ID3D12Resource> m_outputTexture;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_luminanceMomentsTexture;  // Adaptive sampling moments (RG32F)
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_aovAlbedoTexture;         // First-hit albedo sum, denoiser guide (RGBA32F)
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_aovNormalTexture;         // First-hit normal sum, denoiser guide (RGBA32F)
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_activePixelCounter;       // Pixels still sampled by the current batch
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_activePixelReadback;      // One count per offline allocator
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_displayTexture;           // Resolved preview, copied to the back buffer
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_resolveTexture;           // Resolved offline bucket, the only data read back
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_resolveAlbedoTexture;     // Resolved guides, read back with a denoised bucket
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_resolveNormalTexture;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_toneMappedTexture;        // Denoised bucket tone mapped on the GPU (RGBA8)
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_denoiseSharedBuffer;      // Color, guides and denoised output, imported by OIDN
+        bool m_denoiseSharedBufferUnsupported = false;                     // Import failed once: stay on the host path
         Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_srvUavHeap;
         // Geometry buffers
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_vertexBuffer;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_vertexBuffer;           // float3 positions (BLAS input, t1)
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_vertexAttributeBuffer;  // Octahedral normal + half UV per vertex (t15)
         Microsoft::WRL::ComPtr<ID3D12Resource> m_indexBuffer;
         Microsoft::WRL::ComPtr<ID3D12Resource> m_triangleBuffer;
         Microsoft::WRL::ComPtr<ID3D12Resource> m_materialBuffer;
         Microsoft::WRL::ComPtr<ID3D12Resource> m_materialLayersBuffer;  // Extended material layers (新增)
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_triangleMaterialBuffer; // Material index per triangle
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_textureAtlas;
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_textureScalesBuffer;  // UV scale factors (float2 per texture)
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_textureScalesUpload;  // Upload heap for texture scales
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_alphaMaskBuffer;      // Cutout mask bits, 1 per texel
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_alphaMaskInfoBuffer;  // AlphaMaskInfo per material
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_alphaMaskUpload;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_alphaMaskInfoUpload;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_triangleMaterialBuffer; // Material index per face of multi-material meshes
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_textures;  // Bindless scene textures, SRVs from m_srvIndex_Textures
         Microsoft::WRL::ComPtr<ID3D12Resource> m_environmentMap;  // HDR environment map
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_envConditionalCdf;  // width * height floats, per-row CDFs
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_envMarginalCdf;     // height + 1 floats, row CDF + total weight
+        bool m_envImportanceSampling = false;  // CDFs are valid for the current environment map
 
         // Descriptor indices in the shader-visible heap
         UINT m_srvUavDescriptorSize;
-        UINT m_srvIndex_Vertices; // SRV index for vertex buffer
+        UINT m_srvIndex_Vertices = 1; // SRV index for vertex positions
         UINT m_srvIndex_Indices;  // SRV index for index buffer
         UINT m_srvIndex_Materials; // SRV index for materials
         UINT m_srvIndex_MaterialLayers; // SRV index for material layers (新增)
         UINT m_uavIndex_Output;    // UAV index for output texture
+        UINT m_uavIndex_Moments = 13;       // UAV index for luminance moments (adaptive sampling table start)
+        UINT m_uavIndex_ActivePixels = 14;  // UAV index for the active pixel counter
+        UINT m_uavIndex_Display = 15;       // UAV index for the preview display texture
+        UINT m_uavIndex_Resolve = 16;       // UAV index for the offline resolve texture
+        UINT m_uavIndex_AovAlbedo = 17;     // UAV index for the albedo guide sum (AOV table start)
+        UINT m_uavIndex_AovNormal = 18;     // UAV index for the normal guide sum
+        UINT m_uavIndex_ResolveAlbedo = 19; // UAV index for the resolved albedo guide
+        UINT m_uavIndex_ResolveNormal = 20; // UAV index for the resolved normal guide
+        UINT m_uavIndex_ToneMapped = 21;    // UAV index for the tone mapped denoised bucket
+        UINT m_srvIndex_EnvCdf = 22;        // SRV index for the environment conditional CDF (marginal CDF at 23)
+        UINT m_srvIndex_AlphaMasks = 24;    // SRV index for the alpha mask bits (per-material mask info at 25)
+        UINT m_srvIndex_VertexAttributes = 26;  // SRV index for the quantized vertex attributes
+        UINT m_srvIndex_TriangleMaterials = 3;   // SRV index for the per-face material ids (mixed meshes only)
+        UINT m_srvIndex_InstanceMaterials = 27;  // SRV index for the per-instance material ids
+        UINT m_srvIndex_SamplerTables = 28;      // SRV index for the Sobol matrices and blue-noise ranks
+        UINT m_srvIndex_Textures = 29;           // First bindless texture SRV (ResourceDescriptorHeap), heap slots end here
 
         // DXR Shader Binding Table
         Microsoft::WRL::ComPtr<ID3D12Resource> m_sbtBuffer;
@@ -189,6 +520,23 @@ namespace ACG {
         UINT m_sbtRayGenOffset;
         UINT m_sbtMissOffset;
         UINT m_sbtHitGroupOffset;
+        UINT m_sbtHitGroupStride = 0;  // Identifier + MaterialData, one record per BLAS slot
+        UINT m_sbtHitGroupCount = 0;
+        std::vector<MaterialData> m_hitGroupMaterials;  // Copy of the material buffer for the hit group records
+        
+        // Alpha cutout (matches AlphaMask in Structures.hlsli): width 0 = material has no mask
+        struct AlphaMaskInfo {
+            uint32_t offset;  // First word in m_alphaMaskBits
+            uint32_t width;
+            uint32_t height;
+            uint32_t _pad;
+        };
+        std::vector<AlphaMaskInfo> m_alphaMaskInfos;  // Indexed by material
+        std::vector<uint32_t> m_alphaMaskBits;        // Row-major, bit set = opaque texel
+        
+        // Sobol matrices + blue-noise ranks (t17), built and uploaded with the first scene, kept across scenes
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_samplerTableBuffer;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_samplerTableUpload;
         
         // DXR Shader Library
         Microsoft::WRL::ComPtr<IDxcBlob> m_raytracingShaderLibrary;
@@ -196,6 +544,14 @@ namespace ACG {
         std::unique_ptr<Scene> m_scene;
         Camera m_camera;
         
+        // Resident scene cache: buffers, BLAS/TLAS and textures are kept while the source file and
+        // the files it references are unchanged
+        bool IsSceneResident(const std::string& path, uint64_t contentHash) const;
+        std::string m_residentScenePath;
+        uint64_t m_residentSceneHash = 0;
+        uint64_t m_residentSourceFilesStamp = 0;  // Scene::ComputeFileStamp of m_scene->GetSourceFiles()
+        bool m_lastLoadReused = false;
+        
         bool m_dxrSupported;
         
         // Virtual Texture System
@@ -203,24 +559,76 @@ namespace ACG {
         bool m_useVirtualTextures;
         
         // Offline rendering resources (independent from real-time rendering)
-        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_offlineCommandAllocator;
+        // Batches are submitted without CPU waits; an allocator is reused once its batch's fence completed
+        static const UINT OFFLINE_BATCHES_IN_FLIGHT = 3;
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_offlineCommandAllocators[OFFLINE_BATCHES_IN_FLIGHT];
+        UINT64 m_offlineAllocatorFences[OFFLINE_BATCHES_IN_FLIGHT] = {};  // m_offlineFence value of each allocator's last batch
         Microsoft::WRL::ComPtr<ID3D12Fence> m_offlineFence;
         UINT64 m_offlineFenceValue;
         HANDLE m_offlineFenceEvent;
         std::atomic<bool> m_stopRenderRequested;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> m_offlineCommandList;
+        // Bucket readback: two buffers alternate, so one bucket is denoised and converted on a worker
+        // while the next one (possibly of the next frame) renders
+        struct BucketFinishResult {
+            double denoiseMs = 0.0;
+            double conversionMs = 0.0;
+            std::string denoiseError;  // Non-empty if the CPU denoiser failed (the noisy image was kept)
+        };
+        static const UINT BUCKET_READBACK_BUFFERS = 2;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_bucketReadbackBuffers[BUCKET_READBACK_BUFFERS];
+        UINT64 m_bucketReadbackSizes[BUCKET_READBACK_BUFFERS] = {};
+        UINT m_bucketReadbackIndex = 0;
+        std::future<BucketFinishResult> m_pendingBucket;
+        UINT m_pendingBucketBuffer = 0;  // Readback buffer mapped by m_pendingBucket
+        bool m_bucketDenoiseWarned = false;
         
         // 渲染参数
         int m_samplesPerPixel = 1;
         int m_maxBounces = 5;
+        int m_russianRouletteDepth = 3;
+        SamplerType m_samplerType = SamplerType::Sobol;
+        int m_samplesPerDispatch = 4;
+        int m_bucketSize = 0;
+        float m_adaptiveThreshold = 0.01f;
+        int m_adaptiveMinSamples = 32;
         int m_accumulatedSamples = 0;
         float m_environmentLightIntensity = 0.5f;
+        ToneMapOperator m_toneMapOperator = ToneMapOperator::Clamp;
+        float m_exposure = 1.0f;  // Linear multiplier
+        ExrCompression m_exrCompression = ExrCompression::Zip;
+        bool m_exrAovLayers = false;
         // Sun parameters (CPU-side, controlled via intensity)
         glm::vec3 m_sunDirection = glm::vec3(0.0f, 1.0f, 0.0f);
         glm::vec3 m_sunColor = glm::vec3(1.0f, 1.0f, 1.0f);
         float m_sunIntensity = 0.0f;  // 0 = disabled
         std::atomic<bool> m_isRendering;
         
+        // Scene, environment map and offline renders hold this lock; the preview skips frames while it is taken
+        std::mutex m_sceneMutex;
+        
+        // 交互式预览状态
+        bool m_interactivePreview = true;
+        std::atomic<bool> m_previewResetRequested{ true };
+        int m_previewSamples = 0;                // Samples accumulated for the current view
+        CameraConstants m_previewConstants = {}; // Constants of the accumulated view (frameIndex unused)
+        bool m_previewFeedbackPending = false;   // VT feedback readback recorded in the last preview frame
+        
         // OIDN降噪器
         std::unique_ptr<Denoiser> m_denoiser;
+        
+        // 离线渲染结果的后台编码/写入 (析构时等待队列中的文件写完)
+        ImageWriter m_imageWriter;
+        
+        // Timestamp profilers of the direct queue and (when it supports timestamps) the copy queue
+        GpuProfiler m_gpuProfiler;
+        GpuProfiler m_copyProfiler;
+        FrameStats m_workStats;               // CPU times and counters of the current load/render
+        mutable std::mutex m_frameStatsMutex;
+        FrameStats m_frameStats;              // Last published snapshot
+        
+        // Multi-GPU: renderers of the other adapters (no window), each with its own copy of the scene
+        bool m_multiGpu = false;
+        std::vector<std::unique_ptr<Renderer>> m_peers;
     };
 }
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <random>
+#include <vector>
 
 namespace ACG {
 
@@ -66,6 +67,32 @@ namespace SamplingUtils {
     float GGX_D(float cosTheta, float roughness);
     float GGX_G(float cosTheta, float roughness);
     glm::vec3 GGX_Sample(float u1, float u2, float roughness);
+    
+    /**
+     * @brief Build a Walker/Vose alias table for discrete sampling proportional to weights
+     * Sampling picks i = floor(u * n), keeps it if frac(u * n) < probabilities[i], otherwise takes aliases[i].
+     * Zero total weight yields a uniform table.
+     * @param pmf Output normalized probability of each entry (weight / total)
+     */
+    void BuildAliasTable(const std::vector<float>& weights, std::vector<float>& probabilities,
+                         std::vector<uint32_t>& aliases, std::vector<float>& pmf);
+    
+    // Dimensions of one Sobol point; the GPU sampler pads longer paths with independently shuffled points
+    static const uint32_t SOBOL_DIMENSIONS = 4;
+    
+    /**
+     * @brief Sobol generator matrices of the first SOBOL_DIMENSIONS dimensions (Joe-Kuo direction numbers)
+     * Column b of dimension d (matrices[d * 32 + b]) is XOR-ed into the sample when bit b of the index is set.
+     * Dimension 0 is the van der Corput sequence.
+     */
+    void BuildSobolMatrices(std::vector<uint32_t>& matrices);
+    
+    /**
+     * @brief Blue-noise ranks of a toroidal size x size tile (void-and-cluster, Ulichney 1993)
+     * Every rank in [0, size * size) appears once; the pixels below any rank threshold form a blue-noise point set.
+     * Deterministic, so every run dithers the same way.
+     */
+    void BuildBlueNoiseRanks(uint32_t size, std::vector<uint32_t>& ranks);
 }
 
 } // namespace ACG
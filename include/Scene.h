@@ -25,6 +25,36 @@ struct SceneLoadConfig {
     LoadProgressCallback progressCallback = nullptr;
 };
 
+class MappedFile;
+
+/**
+ * @brief GPU-ready geometry chunks of a memory-mapped .acg v2/v3 file
+ * v3 files hold the two vertex streams of the shaders (float3 positions, 8-byte attributes) and
+ * indices already include each mesh's base vertex, so the renderer copies these ranges straight
+ * into upload heaps. v2 files hold 48-byte vertices that are quantized on upload.
+ */
+struct PackedGeometry {
+    std::shared_ptr<MappedFile> file;           // Keeps the mapping alive
+    const float* positions = nullptr;           // v3: vertexCount * float3
+    const void* attributes = nullptr;           // v3: vertexCount * 8 bytes (octahedral normal, half uv)
+    const void* vertices = nullptr;             // v2: vertexCount * vertexStride bytes
+    uint64_t vertexCount = 0;
+    uint32_t vertexStride = 0;
+    const uint32_t* indices = nullptr;          // Global (base vertex applied)
+    uint64_t indexCount = 0;
+    const uint32_t* triangleMaterials = nullptr; // One material index per triangle
+    uint64_t triangleCount = 0;
+};
+
+/**
+ * @brief Placement of a mesh in the scene (one TLAS instance)
+ * Several instances may reference the same mesh so its BLAS is built only once
+ */
+struct MeshInstance {
+    uint32_t meshIndex = 0;                 // Index into Scene::GetMeshes()
+    glm::mat4 transform = glm::mat4(1.0f);  // Object-to-world transform
+};
+
 /**
  * @brief Scene container holding all geometry, materials, and lights
  */
@@ -51,6 +81,17 @@ public:
     const std::vector<std::shared_ptr<Material>>& GetMaterials() const { return m_materials; }
     const std::vector<std::shared_ptr<Light>>& GetLights() const { return m_lights; }
     
+    // 打包几何 (.acg v2/v3 零拷贝加载; 为空时网格自带顶点数据)
+    void SetPackedGeometry(const PackedGeometry& geometry) { m_packedGeometry = geometry; }
+    const PackedGeometry* GetPackedGeometry() const { return m_packedGeometry.indices ? &m_packedGeometry : nullptr; }
+    
+    // 网格实例 (空列表时渲染器为每个网格创建一个单位变换实例)
+    void AddInstance(uint32_t meshIndex, const glm::mat4& transform = glm::mat4(1.0f));
+    void SetInstanceTransform(size_t instanceIndex, const glm::mat4& transform);
+    const std::vector<MeshInstance>& GetInstances() const { return m_instances; }
+    bool AreInstanceTransformsDirty() const { return m_instanceTransformsDirty; }
+    void ClearInstanceTransformsDirty() { m_instanceTransformsDirty = false; }
+    
     // 场景名称
     std::string GetName() const { return m_name; }
     void SetName(const std::string& name) { m_name = name; }
@@ -65,6 +106,16 @@ public:
     const std::vector<MaterialExtendedData>& GetMaterialLayers() const { return m_materialLayers; }
     uint32_t AddMaterialLayer(const MaterialExtendedData& layer);
     
+    // 文件内容哈希 (FNV-1a 64), 用于判断场景是否需要重新上传GPU
+    static uint64_t ComputeFileHash(const std::string& filename);
+    
+    // 场景文件引用的外部文件 (材质库, 纹理), 由加载器在解析时记录
+    void AddSourceFile(const std::string& path) { m_sourceFiles.push_back(path); }
+    const std::vector<std::string>& GetSourceFiles() const { return m_sourceFiles; }
+    // Hash of the path, size and modification time of every file (as the .texcache entries check
+    // their source); a missing file still contributes its path
+    static uint64_t ComputeFileStamp(const std::vector<std::string>& files);
+    
     // 获取加载统计信息
     struct LoadStats {
         int totalMeshes = 0;
@@ -76,6 +127,18 @@ public:
         int totalMaterialLayers = 0;  // 新增
     };
     const LoadStats& GetLoadStats() const { return m_loadStats; }
+    
+    // 加载各阶段的CPU耗时 (毫秒, SceneLoader 中的 ScopedTimer 累加)
+    struct LoadTimings {
+        double conversionMs = 0.0;  // Python 转换为 .acg (命中缓存时为 0)
+        double importMs = 0.0;      // SceneLoader::Load / ObjLoader::Load 整体
+        double materialsMs = 0.0;   // 材质记录解析
+        double texturesMs = 0.0;    // 纹理解码与压缩缓存 (TextureManager::LoadBatch)
+        double geometryMs = 0.0;    // 网格与顶点数据 (.acg v2/v3 只做映射)
+        double totalMs = 0.0;       // LoadFromFile 全部, 含包围盒与材质层等后处理
+    };
+    const LoadTimings& GetLoadTimings() const { return m_loadTimings; }
+    LoadTimings& GetLoadTimings() { return m_loadTimings; }
 
 private:
     void CalculateBoundingBox();
@@ -84,15 +147,20 @@ private:
     std::vector<std::shared_ptr<Mesh>> m_meshes;
     std::vector<std::shared_ptr<Material>> m_materials;
     std::vector<std::shared_ptr<Light>> m_lights;
+    std::vector<MeshInstance> m_instances;
+    PackedGeometry m_packedGeometry;
+    bool m_instanceTransformsDirty = false;  // Only transforms changed -> TLAS refit is enough
     
     // 材质层数据 (新增)
     std::vector<MaterialExtendedData> m_materialLayers;
     
     std::string m_name;
+    std::vector<std::string> m_sourceFiles;
     glm::vec3 m_bboxMin;
     glm::vec3 m_bboxMax;
     
     LoadStats m_loadStats;
+    LoadTimings m_loadTimings;
 };
 
 } // namespace ACG
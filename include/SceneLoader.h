@@ -2,6 +2,14 @@
  * Scene Loader - Binary Format
  * 高性能二进制场景加载器
  * 直接从.acg二进制文件加载场景数据
+ *
+ * VERSION 1: 顺序流式布局 (材质 -> 纹理 -> 网格, 每个网格内嵌顶点/索引)
+ * VERSION 2: 分块布局 + 段表, 几何段按256字节对齐且为GPU格式, 通过内存映射零拷贝读取
+ *   Header   { u32 magic, u32 version, u32 sectionCount, u32 reserved }
+ *   Section  { u32 type, u32 count, u64 offset, u64 size } x sectionCount
+ *   MATERIALS / TEXTURES 段沿用 VERSION 1 的记录编码
+ * VERSION 3: 同 VERSION 2 的布局, 但顶点拆为着色器使用的两个流 (POSITIONS + VERTEX_ATTRIBUTES)
+ *   代替48字节的VERTICES段, 渲染器直接拷贝而无需重新量化; VERSION 2 文件仍可读取
  */
 
 #pragma once
@@ -14,18 +22,73 @@
 #include <memory>
 #include <iostream>
 #include <type_traits>
+#include <cstring>
 #include "Scene.h"
 #include "Material.h"
 #include "MaterialLayers.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "MappedFile.h"
+#include "ScopedTimer.h"
 
 namespace ACG {
 
 class SceneLoader {
 public:
     static constexpr uint32_t MAGIC = 0x53474341;  // 'ACGS' in little-endian
-    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t VERSION = 3;
+    static constexpr uint32_t VERSION_INTERLEAVED = 2;
+    static constexpr uint32_t VERSION_STREAMED = 1;
+
+    // VERSION 2/3 段类型
+    enum SectionType : uint32_t {
+        SECTION_MATERIALS = 1,           // VERSION 1 材质编码 (含数量前缀)
+        SECTION_TEXTURES = 2,            // VERSION 1 纹理路径编码 (含数量前缀)
+        SECTION_MESHES = 3,              // MeshRecord[count]
+        SECTION_MESH_NAMES = 4,          // 长度前缀字符串, 与MESHES顺序一致
+        SECTION_VERTICES = 5,            // 48字节顶点[count] (仅 VERSION 2)
+        SECTION_INDICES = 6,             // u32[count], 已加上网格的基顶点
+        SECTION_TRIANGLE_MATERIALS = 7,  // u32[count], 每个三角形一个材质索引
+        SECTION_INSTANCES = 8,           // InstanceRecord[count] (可选)
+        SECTION_POSITIONS = 9,           // float3[count] (VERSION 3)
+        SECTION_VERTEX_ATTRIBUTES = 10   // 8字节[count]: 八面体法线 2 x unorm16 + 纹理坐标 2 x half (VERSION 3)
+    };
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t sectionCount;
+        uint32_t reserved;
+    };
+    struct SectionEntry {
+        uint32_t type;
+        uint32_t count;
+        uint64_t offset;
+        uint64_t size;
+    };
+    struct MeshRecord {
+        uint32_t materialIndex;
+        uint32_t vertexCount;
+        uint64_t firstVertex;
+        uint64_t firstIndex;
+        uint32_t indexCount;
+        uint32_t reserved;
+        float bboxMin[3];
+        float bboxMax[3];
+    };
+    struct InstanceRecord {
+        uint32_t meshIndex;
+        float transform[12];  // Row-major 3x4 object-to-world
+    };
+#pragma pack(pop)
+    static_assert(sizeof(FileHeader) == 16, "FileHeader layout must match the exporter");
+    static_assert(sizeof(SectionEntry) == 24, "SectionEntry layout must match the exporter");
+    static_assert(sizeof(MeshRecord) == 56, "MeshRecord layout must match the exporter");
+    static_assert(sizeof(InstanceRecord) == 52, "InstanceRecord layout must match the exporter");
+    static constexpr uint32_t PACKED_VERTEX_STRIDE = 48;
+    static constexpr uint32_t PACKED_POSITION_STRIDE = 12;
+    static constexpr uint32_t PACKED_ATTRIBUTE_STRIDE = 8;
 
     static std::unique_ptr<Scene> Load(const std::string& filepath) {
         std::ifstream file(filepath, std::ios::binary);
@@ -41,7 +104,11 @@ public:
         if (magic != MAGIC) {
             throw std::runtime_error("Invalid binary scene file format");
         }
-        if (version != VERSION) {
+        if (version == VERSION || version == VERSION_INTERLEAVED) {
+            file.close();
+            return LoadChunked(filepath);
+        }
+        if (version != VERSION_STREAMED) {
             throw std::runtime_error("Unsupported binary scene version");
         }
 
@@ -50,9 +117,26 @@ public:
         // 读取材质、纹理、网格(先加载纹理,再关联到材质)
         std::vector<std::shared_ptr<Texture>> textures;
         std::vector<std::array<int32_t, 4>> materialTexIndices;  // 暂存材质的纹理索引
-        LoadMaterials(file, scene.get(), materialTexIndices);
-        LoadTextures(file, scene.get(), textures);
-        
+        Scene::LoadTimings& timings = scene->GetLoadTimings();
+        {
+            ScopedTimer timer(timings.materialsMs);
+            LoadMaterials(file, scene.get(), materialTexIndices);
+        }
+        {
+            ScopedTimer timer(timings.texturesMs);
+            LoadTextures(file, scene.get(), textures);
+            BindMaterialTextures(scene.get(), textures, materialTexIndices);
+        }
+        {
+            ScopedTimer timer(timings.geometryMs);
+            LoadMeshes(file, scene.get());
+        }
+
+        return scene;
+    }
+
+    static void BindMaterialTextures(Scene* scene, const std::vector<std::shared_ptr<Texture>>& textures,
+                                     const std::vector<std::array<int32_t, 4>>& materialTexIndices) {
         // 关联纹理到材质
         const auto& materials = scene->GetMaterials();
         for (size_t i = 0; i < materials.size() && i < materialTexIndices.size(); ++i) {
@@ -64,21 +148,173 @@ public:
             }
             if (texIndices[1] >= 0 && texIndices[1] < static_cast<int32_t>(textures.size())) {
                 mat->SetNormalTexture(textures[texIndices[1]], texIndices[1]);
+                textures[texIndices[1]]->SetType(TextureType::Normal);  // 决定压缩格式
             }
             if (texIndices[2] >= 0 && texIndices[2] < static_cast<int32_t>(textures.size())) {
                 mat->SetMetallicRoughnessTexture(textures[texIndices[2]], texIndices[2]);
+                textures[texIndices[2]]->SetType(TextureType::Roughness);  // 决定压缩格式
             }
             if (texIndices[3] >= 0 && texIndices[3] < static_cast<int32_t>(textures.size())) {
                 mat->SetEmissionTexture(textures[texIndices[3]], texIndices[3]);
+                textures[texIndices[3]]->SetType(TextureType::Emissive);  // 决定压缩格式
             }
         }
-        
-        LoadMeshes(file, scene.get());
+    }
 
-        return scene;
+    // 按路径加载纹理, 顺序与路径列表一致 (缺失文件仍占位, 保持材质中的纹理索引有效)
+    // 解码由TextureManager在线程池中并行完成, 相同路径共享同一纹理; 路径记入场景的外部文件
+    static void LoadTextureFiles(Scene* scene, const std::vector<std::string>& paths,
+                                 std::vector<std::shared_ptr<Texture>>& textures) {
+        for (const auto& path : paths) {
+            if (!path.empty()) {
+                scene->AddSourceFile(path);
+            }
+        }
+        auto loaded = TextureManager::Instance().LoadBatch(paths);
+        textures.insert(textures.end(), loaded.begin(), loaded.end());
     }
 
 private:
+    static const SectionEntry* FindSection(const std::vector<SectionEntry>& sections, uint32_t type) {
+        for (const auto& section : sections) {
+            if (section.type == type) {
+                return &section;
+            }
+        }
+        return nullptr;
+    }
+
+    static std::unique_ptr<Scene> LoadChunked(const std::string& filepath) {
+        auto mapped = std::make_shared<MappedFile>();
+        if (!mapped->Open(filepath)) {
+            throw std::runtime_error("Failed to map binary scene file: " + filepath);
+        }
+        const uint8_t* base = mapped->GetData();
+        const uint64_t fileSize = mapped->GetSize();
+
+        if (fileSize < sizeof(FileHeader)) {
+            throw std::runtime_error("Truncated binary scene file");
+        }
+        FileHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        uint64_t tableEnd = sizeof(FileHeader) + static_cast<uint64_t>(header.sectionCount) * sizeof(SectionEntry);
+        if (tableEnd > fileSize) {
+            throw std::runtime_error("Truncated section table in binary scene file");
+        }
+
+        std::vector<SectionEntry> sections(header.sectionCount);
+        std::memcpy(sections.data(), base + sizeof(FileHeader), sections.size() * sizeof(SectionEntry));
+        for (const auto& section : sections) {
+            if (section.offset + section.size > fileSize) {
+                throw std::runtime_error("Section extends past end of binary scene file");
+            }
+        }
+
+        auto scene = std::make_unique<Scene>();
+
+        // 材质与纹理段很小, 复用 VERSION 1 的流式解析
+        std::ifstream file(filepath, std::ios::binary);
+        std::vector<std::shared_ptr<Texture>> textures;
+        std::vector<std::array<int32_t, 4>> materialTexIndices;
+        Scene::LoadTimings& timings = scene->GetLoadTimings();
+        if (const SectionEntry* section = FindSection(sections, SECTION_MATERIALS)) {
+            ScopedTimer timer(timings.materialsMs);
+            file.seekg(static_cast<std::streamoff>(section->offset));
+            LoadMaterials(file, scene.get(), materialTexIndices);
+        }
+        {
+            ScopedTimer timer(timings.texturesMs);
+            if (const SectionEntry* section = FindSection(sections, SECTION_TEXTURES)) {
+                file.seekg(static_cast<std::streamoff>(section->offset));
+                LoadTextures(file, scene.get(), textures);
+            }
+            BindMaterialTextures(scene.get(), textures, materialTexIndices);
+        }
+
+        // 几何段: 只记录映射指针, 不复制
+        ScopedTimer geometryTimer(timings.geometryMs);
+        const SectionEntry* meshSection = FindSection(sections, SECTION_MESHES);
+        const SectionEntry* positionSection = FindSection(sections, SECTION_POSITIONS);
+        const SectionEntry* attributeSection = FindSection(sections, SECTION_VERTEX_ATTRIBUTES);
+        const SectionEntry* vertexSection = FindSection(sections, SECTION_VERTICES);
+        const SectionEntry* indexSection = FindSection(sections, SECTION_INDICES);
+        const SectionEntry* triMatSection = FindSection(sections, SECTION_TRIANGLE_MATERIALS);
+        const bool splitStreams = positionSection && attributeSection;
+        if (!meshSection || (!splitStreams && !vertexSection) || !indexSection || !triMatSection) {
+            throw std::runtime_error("Binary scene file is missing geometry sections");
+        }
+        const uint64_t vertexCount = splitStreams ? positionSection->count : vertexSection->count;
+        const bool vertexSizesValid = splitStreams ?
+            (attributeSection->count == positionSection->count &&
+             positionSection->size >= vertexCount * PACKED_POSITION_STRIDE &&
+             attributeSection->size >= vertexCount * PACKED_ATTRIBUTE_STRIDE) :
+            vertexSection->size >= vertexCount * PACKED_VERTEX_STRIDE;
+        if (!vertexSizesValid ||
+            indexSection->size < static_cast<uint64_t>(indexSection->count) * sizeof(uint32_t) ||
+            triMatSection->size < static_cast<uint64_t>(triMatSection->count) * sizeof(uint32_t) ||
+            meshSection->size < static_cast<uint64_t>(meshSection->count) * sizeof(MeshRecord) ||
+            static_cast<uint64_t>(triMatSection->count) * 3 != indexSection->count) {
+            throw std::runtime_error("Inconsistent geometry section sizes in binary scene file");
+        }
+
+        PackedGeometry packed;
+        packed.file = mapped;
+        if (splitStreams) {
+            packed.positions = reinterpret_cast<const float*>(base + positionSection->offset);
+            packed.attributes = base + attributeSection->offset;
+        } else {
+            packed.vertices = base + vertexSection->offset;
+            packed.vertexStride = PACKED_VERTEX_STRIDE;
+        }
+        packed.vertexCount = vertexCount;
+        packed.indices = reinterpret_cast<const uint32_t*>(base + indexSection->offset);
+        packed.indexCount = indexSection->count;
+        packed.triangleMaterials = reinterpret_cast<const uint32_t*>(base + triMatSection->offset);
+        packed.triangleCount = triMatSection->count;
+
+        const SectionEntry* nameSection = FindSection(sections, SECTION_MESH_NAMES);
+        if (nameSection) {
+            file.seekg(static_cast<std::streamoff>(nameSection->offset));
+        }
+        for (uint32_t i = 0; i < meshSection->count; ++i) {
+            MeshRecord record;
+            std::memcpy(&record, base + meshSection->offset + i * sizeof(MeshRecord), sizeof(record));
+            if (record.firstVertex + record.vertexCount > packed.vertexCount ||
+                record.firstIndex + record.indexCount > packed.indexCount ||
+                record.indexCount == 0 || record.indexCount % 3 != 0) {
+                throw std::runtime_error("Invalid mesh record in binary scene file");
+            }
+
+            auto mesh = std::make_shared<Mesh>();
+            mesh->SetName(nameSection ? ReadString(file) : ("mesh_" + std::to_string(i)));
+            mesh->SetMaterialIndex(static_cast<int>(record.materialIndex));
+            mesh->SetPackedRange(record.firstVertex, record.vertexCount, record.firstIndex, record.indexCount);
+            mesh->SetBoundingBox(glm::vec3(record.bboxMin[0], record.bboxMin[1], record.bboxMin[2]),
+                                 glm::vec3(record.bboxMax[0], record.bboxMax[1], record.bboxMax[2]));
+            scene->AddMesh(mesh);
+        }
+        scene->SetPackedGeometry(packed);
+
+        // 可选实例段
+        if (const SectionEntry* section = FindSection(sections, SECTION_INSTANCES)) {
+            for (uint32_t i = 0; i < section->count; ++i) {
+                InstanceRecord record;
+                std::memcpy(&record, base + section->offset + i * sizeof(InstanceRecord), sizeof(record));
+                glm::mat4 transform(1.0f);
+                for (int row = 0; row < 3; ++row) {
+                    for (int col = 0; col < 4; ++col) {
+                        transform[col][row] = record.transform[row * 4 + col];
+                    }
+                }
+                scene->AddInstance(record.meshIndex, transform);
+            }
+        }
+
+        std::cout << "Mapped .acg v" << header.version << ": " << packed.vertexCount << " vertices, " 
+                  << packed.triangleCount << " triangles (zero-copy)" << std::endl;
+        return scene;
+    }
+
     static std::string ReadString(std::ifstream& file) {
         uint32_t length;
         file.read(reinterpret_cast<char*>(&length), sizeof(length));
@@ -169,27 +405,12 @@ private:
         uint32_t count;
         file.read(reinterpret_cast<char*>(&count), sizeof(count));
 
-        textures.reserve(count);
-        
+        std::vector<std::string> paths;
+        paths.reserve(count);
         for (uint32_t i = 0; i < count; ++i) {
-            std::string texPath = ReadString(file);
-            
-            // 创建纹理对象并加载
-            auto texture = std::make_shared<Texture>();
-            
-            // 检查文件是否存在
-            std::filesystem::path fullPath = texPath;
-            if (!std::filesystem::exists(fullPath)) {
-                std::cerr << "Warning: Texture not found: " << texPath << std::endl;
-            } else {
-                // 立即加载纹理数据
-                if (!texture->LoadFromFile(texPath)) {
-                    std::cerr << "Error: Failed to load texture: " << texPath << std::endl;
-                }
-            }
-            
-            textures.push_back(texture);
+            paths.push_back(ReadString(file));
         }
+        LoadTextureFiles(scene, paths, textures);
     }
 
     static void LoadMeshes(std::ifstream& file, Scene* scene) {
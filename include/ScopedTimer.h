@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+
+namespace ACG {
+
+/**
+ * @brief Adds the wall time of its scope to a millisecond counter
+ * Used for the CPU phases of scene loading and rendering; nested timers each add their own span.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(double& accumulatorMs)
+        : m_accumulatorMs(accumulatorMs), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { m_accumulatorMs += ElapsedMs(); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    double ElapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    double& m_accumulatorMs;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace ACG
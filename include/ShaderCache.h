@@ -0,0 +1,58 @@
+/*
+ * Shader Cache
+ * 编译后的DXIL与D3D12管线库缓存在工作目录的 shadercache 目录 (与 shaders 目录同级)
+ *
+ * DXIL按内容寻址: 键为源文件及其全部 #include 文件内容、编译参数和DXC版本的哈希,
+ * 任一项变化都会得到新键, 旧条目不再命中 (无需手动失效)
+ *
+ * Hash/HashFile 与 WriteFileAtomically 也是场景内容哈希 (Scene::ComputeFileHash) 和
+ * 压缩纹理缓存 (.texcache) 使用的同一实现
+ */
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace ACG {
+
+class ShaderCache {
+public:
+    static constexpr uint64_t HASH_SEED = 0xcbf29ce484222325ull;  // FNV-1a offset basis
+
+    // 缓存目录 (空 = 禁用缓存)
+    static void SetCacheDirectory(const std::string& directory);
+    static std::string GetCacheDirectory();
+
+    // 64-bit FNV-1a; pass a previous result as seed to chain several inputs
+    static uint64_t Hash(const void* data, size_t size, uint64_t seed = HASH_SEED);
+    // Hash of a file's bytes, streamed in 1 MB chunks; false if it cannot be opened
+    static bool HashFile(const std::filesystem::path& filename, uint64_t& hash, uint64_t seed = HASH_SEED);
+
+    /**
+     * @brief Write header (optional) and data to path.partial, then rename it over path
+     * An interrupted or failed write never leaves a truncated file under the final name.
+     * @return false if the directory, the write or the rename failed (the partial file is removed)
+     */
+    static bool WriteFileAtomically(const std::filesystem::path& path, const void* header, size_t headerSize,
+                                    const void* data, size_t size);
+
+    /**
+     * @brief Hash of a shader source and every file it includes, recursively
+     * Quoted includes resolve against the including file's directory, then includeDirectory.
+     * A missing file only contributes its name (the compiler reports it).
+     */
+    static uint64_t HashSourceTree(const std::filesystem::path& filename, const std::filesystem::path& includeDirectory,
+                                   uint64_t seed = HASH_SEED);
+
+    // 按键读写DXIL; 写入失败时静默忽略 (缓存只是加速手段)
+    static bool LoadShader(uint64_t key, std::vector<uint8_t>& dxil);
+    static void StoreShader(uint64_t key, const void* dxil, size_t size);
+
+    // 缓存目录中的整文件数据 (如序列化的 ID3D12PipelineLibrary)
+    static bool LoadBlob(const std::string& name, std::vector<uint8_t>& data);
+    static void StoreBlob(const std::string& name, const void* data, size_t size);
+};
+
+} // namespace ACG
@@ -4,6 +4,8 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
 #include <glm/glm.hpp>
 
 namespace ACG {
@@ -54,6 +56,9 @@ public:
     // Load texture from file
     bool LoadFromFile(const std::string& filename);
     
+    // Decoded size in bytes, read from the file header without decoding (0 if unknown)
+    static size_t EstimateDecodedSize(const std::string& filename);
+    
     // Load HDR/EXR environment map
     bool LoadHDR(const std::string& filename);
     bool LoadEXR(const std::string& filename);
@@ -67,9 +72,9 @@ public:
     glm::vec4 SampleBilinear(float u, float v, float mipLevel = 0.0f) const;
     glm::vec4 SampleTrilinear(float u, float v, float mipLevel = 0.0f) const;
     
-    // Generate mipmaps
-    void GenerateMipmaps();
-    void GenerateAdaptiveMipmaps();  // Advanced: adaptive mipmap algorithm
+    // Generate mipmaps (8-bit and HDR chains, rows filtered in parallel; called again it rebuilds from level 0)
+    void GenerateMipmaps();          // 2x2 box filter
+    void GenerateAdaptiveMipmaps();  // Kaiser-windowed sinc for color content, box filter for data maps
     
     // Getters
     int GetWidth() const { return m_width; }
@@ -77,9 +82,19 @@ public:
     int GetChannels() const { return m_channels; }
     int GetMipLevels() const { return static_cast<int>(m_mipLevels.size()); }
     const unsigned char* GetRawData() const { return m_mipLevels.empty() ? nullptr : m_mipLevels[0].data.data(); }
+    // Mip level access (level 0 = GetRawData); levels exist after GenerateMipmaps
+    const unsigned char* GetMipData(int level) const { return level < GetMipLevels() ? m_mipLevels[level].data.data() : nullptr; }
+    int GetMipWidth(int level) const { return level < GetMipLevels() ? m_mipLevels[level].width : 0; }
+    int GetMipHeight(int level) const { return level < GetMipLevels() ? m_mipLevels[level].height : 0; }
     const float* GetHDRData() const { return m_hdrMipLevels.empty() ? nullptr : m_hdrMipLevels[0].data.data(); }
+    int GetHDRMipLevels() const { return static_cast<int>(m_hdrMipLevels.size()); }
+    const float* GetHDRMipData(int level) const { return level < GetHDRMipLevels() ? m_hdrMipLevels[level].data.data() : nullptr; }
+    int GetHDRMipWidth(int level) const { return level < GetHDRMipLevels() ? m_hdrMipLevels[level].width : 0; }
+    int GetHDRMipHeight(int level) const { return level < GetHDRMipLevels() ? m_hdrMipLevels[level].height : 0; }
     bool IsHDR() const { return m_format == TextureFormat::Float32; }
     TextureFormat GetFormat() const { return m_format; }
+    TextureType GetType() const { return m_type; }
+    const std::string& GetSourcePath() const { return m_sourcePath; }  // Empty for generated textures
     
     // Settings
     void SetFilter(TextureFilter filter) { m_filter = filter; }
@@ -103,6 +118,7 @@ private:
     int m_height;
     int m_channels;
     TextureFormat m_format;
+    std::string m_sourcePath;
     
     std::vector<MipLevel> m_mipLevels;
     std::vector<HDRMipLevel> m_hdrMipLevels;
@@ -119,17 +135,39 @@ private:
 
 /**
  * @brief Texture manager for loading and caching textures
+ * Textures are cached by path for as long as something (typically a scene's materials) still
+ * holds them, so reloading or sharing a path never decodes the same file twice.
  */
 class TextureManager {
 public:
     static TextureManager& Instance();
     
     std::shared_ptr<Texture> Load(const std::string& filename);
+    
+    // 批量加载: 结果与路径一一对应 (相同路径共享同一对象), 未缓存的文件在工作线程中并行解码
+    // 缺失或解码失败的路径得到空纹理占位, 以保持调用方的纹理索引不变
+    std::vector<std::shared_ptr<Texture>> LoadBatch(const std::vector<std::string>& filenames);
+    
+    // 同时解码中的纹理内存上限 (估算值), 避免大量4K贴图同时解码占满内存
+    void SetDecodeMemoryBudget(size_t bytes) { m_decodeMemoryBudget = bytes; }
+    size_t GetDecodeMemoryBudget() const { return m_decodeMemoryBudget; }
+    
     void Clear();
 
 private:
     TextureManager() = default;
-    std::map<std::string, std::shared_ptr<Texture>> m_textures;
+    
+    std::shared_ptr<Texture> FindCached(const std::string& filename);
+    void AcquireDecodeMemory(size_t bytes);
+    void ReleaseDecodeMemory(size_t bytes);
+    
+    std::map<std::string, std::weak_ptr<Texture>> m_textures;
+    std::mutex m_cacheMutex;
+    
+    size_t m_decodeMemoryBudget = size_t(1) << 30;  // 1 GB
+    size_t m_decodeMemoryInFlight = 0;
+    std::mutex m_budgetMutex;
+    std::condition_variable m_budgetCondition;
 };
 
 } // namespace ACG
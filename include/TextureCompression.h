@@ -0,0 +1,78 @@
+/*
+ * Block Compression (BC1/BC4/BC5/BC7) Encoder
+ * 加载时将RGBA8纹理编码为GPU块压缩格式, 结果缓存在场景文件旁的 <场景名>.texcache 目录
+ *
+ * 每种格式按4x4像素块编码:
+ *   BC1 - RGB 565 端点 + 2位索引, 8字节/块 (颜色/打包的通道贴图)
+ *   BC4 - 单通道 (R), 8字节/块 (粗糙度/金属度/AO)
+ *   BC5 - 双通道 (RG), 16字节/块 (切线空间法线)
+ *   BC7 - RGBA mode 6 (7位端点 + p位, 4位索引), 16字节/块 (基础色)
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dxgiformat.h>
+#include "Texture.h"
+
+namespace ACG {
+
+enum class BlockFormat {
+    BC1,
+    BC4,
+    BC5,
+    BC7
+};
+
+class TextureCompressor {
+public:
+    static DXGI_FORMAT GetDXGIFormat(BlockFormat format);
+    static const char* GetFormatName(BlockFormat format);
+
+    // Bytes per 4x4 block (8 for BC1/BC4, 16 for BC5/BC7)
+    static uint32_t GetBlockBytes(BlockFormat format);
+    // Bytes per row of blocks for an image of the given pixel width
+    static uint32_t GetRowPitch(BlockFormat format, uint32_t width);
+    static size_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+    // Bytes of mipLevels levels stored back to back, each level half the previous one (at least 1 pixel)
+    static size_t GetCompressedChainSize(BlockFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+    // 按纹理用途选择格式; channels 区分单通道贴图(BC4)和打包的多通道贴图(BC1)
+    static BlockFormat SelectFormat(TextureType type, int channels);
+
+    /**
+     * @brief Encode a tightly packed 8-bit image into blocks, row-major by block
+     * Partial edge blocks replicate the last row/column. Grayscale sources are expanded
+     * to RGB, missing alpha is treated as 255.
+     * @param channels 1-4 interleaved channels per pixel
+     * @param parallel Encode block rows on worker threads (disable when the caller is already parallel)
+     */
+    static std::vector<uint8_t> Compress(BlockFormat format, const uint8_t* pixels,
+                                         uint32_t width, uint32_t height, int channels,
+                                         bool parallel = true);
+
+    // 磁盘缓存目录 (空 = 禁用缓存), 由Renderer在加载场景时设置
+    static void SetCacheDirectory(const std::string& directory);
+    static std::string GetCacheDirectory();
+    static std::string GetCacheDirectoryForScene(const std::string& scenePath);
+
+    /**
+     * @brief Look up previously compressed data for a source image file
+     * An entry is valid while the source file's size and modification time match the
+     * ones recorded when it was stored. A full mip chain and a single level of the same
+     * size are separate entries.
+     * @param mipLevels Levels expected in blocks, starting at width x height
+     * @return false if caching is disabled, the entry is missing or stale
+     */
+    static bool LoadCached(const std::string& sourcePath, BlockFormat format,
+                           uint32_t width, uint32_t height, uint32_t mipLevels,
+                           std::vector<uint8_t>& blocks);
+
+    // 写入失败时静默忽略 (缓存只是加速手段); blocks 的大小必须与 mipLevels 层一致
+    static void StoreCached(const std::string& sourcePath, BlockFormat format,
+                            uint32_t width, uint32_t height, uint32_t mipLevels,
+                            const std::vector<uint8_t>& blocks);
+};
+
+} // namespace ACG
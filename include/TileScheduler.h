@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ImageWriter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace ACG {
+
+/**
+ * @brief Hands out the buckets of an offline render and reassembles them into image rows
+ * Every device rendering the frame (one per adapter with multi-GPU) pulls bucket indices with
+ * AcquireTile() until none are left, so faster GPUs simply render more buckets. Finished buckets
+ * deliver their core pixels (without the denoise overlap) to SubmitTile(), which copies them into
+ * the row of buckets they belong to; complete rows go to the ImageWriter in top-to-bottom order.
+ * Thread safe: any number of render threads may acquire and submit concurrently.
+ */
+class TileScheduler {
+public:
+    /**
+     * @param coreWidth, coreHeight Bucket size; the last column and row may be smaller
+     * @param imageLayers EXR planes per pixel (1, or 3 with albedo/normal layers); ignored for PPM
+     */
+    TileScheduler(ImageWriter& writer, uint32_t width, uint32_t height, uint32_t coreWidth, uint32_t coreHeight,
+                  bool hdr, uint32_t imageLayers);
+
+    TileScheduler(const TileScheduler&) = delete;
+    TileScheduler& operator=(const TileScheduler&) = delete;
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+    uint32_t GetCoreWidth() const { return m_coreWidth; }
+    uint32_t GetCoreHeight() const { return m_coreHeight; }
+    uint32_t GetTilesX() const { return m_tilesX; }
+    uint32_t GetTilesY() const { return m_tilesY; }
+    int GetTileCount() const { return static_cast<int>(m_tilesX * m_tilesY); }
+    bool IsHdr() const { return m_hdr; }
+    uint32_t GetImageLayers() const { return m_imageLayers; }
+
+    // 下一个待渲染的分块; 已全部分发或已中止时返回 -1
+    int AcquireTile();
+    /**
+     * @brief Deliver the core pixels of a finished bucket
+     * PPM: coreW * coreH RGB bytes; EXR: imageLayers planes of coreW * coreH RGB floats, rows tightly packed
+     */
+    void SubmitTile(int tileIndex, const uint8_t* pixels, const float* planes);
+    int GetCompletedTileCount() const { return m_completedTiles.load(); }
+
+    // Stops handing out buckets (user stop or a failed device); the caller aborts the image
+    void Abort() { m_aborted.store(true); }
+    bool IsAborted() const { return m_aborted.load(); }
+    // All rows were handed to the writer
+    bool IsComplete() const;
+
+private:
+    struct Band {
+        std::vector<uint8_t> pixels;
+        std::vector<float> planes;
+        uint32_t tilesDone = 0;
+    };
+
+    ImageWriter& m_writer;
+    const uint32_t m_width;
+    const uint32_t m_height;
+    const uint32_t m_coreWidth;
+    const uint32_t m_coreHeight;
+    const uint32_t m_tilesX;
+    const uint32_t m_tilesY;
+    const bool m_hdr;
+    const uint32_t m_imageLayers;
+
+    std::atomic<int> m_nextTile;
+    std::atomic<int> m_completedTiles;
+    std::atomic<bool> m_aborted;
+
+    mutable std::mutex m_mutex;
+    std::map<uint32_t, Band> m_bands;  // Rows of buckets started but not yet written
+    uint32_t m_nextBandToWrite;
+};
+
+} // namespace ACG
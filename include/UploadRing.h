@@ -0,0 +1,96 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace ACG {
+
+/**
+ * @brief Persistently mapped upload heap used as a ring of staging memory
+ * Callers carve sub-allocations out of one committed buffer and record copies from it;
+ * Submit() tags everything allocated so far with a fence on the queue the copies run on
+ * (one fence per queue, so direct and copy queue submissions can be mixed). Space is
+ * reclaimed in submission order once those fences complete, so uploads never create
+ * resources or stall unless the ring is full.
+ */
+class UploadRing {
+public:
+    struct Allocation {
+        ID3D12Resource* resource = nullptr;
+        UINT64 offset = 0;          // Offset into resource, for CopyBufferRegion/placed footprints
+        uint8_t* cpuAddress = nullptr;
+
+        explicit operator bool() const { return cpuAddress != nullptr; }
+    };
+
+    UploadRing();
+    ~UploadRing();
+
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    // capacity 会向上取整到纹理数据对齐 (512字节)
+    void Initialize(ID3D12Device* device, UINT64 capacity);
+    void Shutdown();
+
+    /**
+     * @brief Allocate staging memory
+     * Blocks on the oldest submission when the ring is full.
+     * @return Empty allocation if size exceeds the capacity, or if the space is held by
+     *         allocations that have not been submitted yet (submit them and retry)
+     */
+    Allocation Allocate(UINT64 size, UINT64 alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+    /**
+     * @brief Mark all allocations so far as used by work already executed on queue
+     * Must be called after ExecuteCommandLists of the lists that read them.
+     * @return Submission id, completes when that work (and every earlier submission) is done
+     */
+    UINT64 Submit(ID3D12CommandQueue* queue);
+
+    // 等待某次Submit完成 (也可用于回收与之同批提交的命令分配器); id 0 视为已完成
+    void WaitForSubmission(UINT64 submissionId);
+    bool IsSubmissionComplete(UINT64 submissionId) const;
+    void WaitIdle();
+
+    bool IsInitialized() const { return m_buffer != nullptr; }
+    UINT64 GetCapacity() const { return m_capacity; }
+    UINT64 GetPendingBytes() const { return m_head - m_submittedHead; }
+
+private:
+    struct QueueFence {
+        ID3D12CommandQueue* queue;
+        Microsoft::WRL::ComPtr<ID3D12Fence> fence;
+        UINT64 value;             // Last signaled value
+    };
+    struct Submission {
+        UINT64 id;
+        size_t queueIndex;
+        UINT64 fenceValue;
+        UINT64 head;              // m_head at submission; becomes the tail once retired
+    };
+
+    void RetireCompleted();
+    bool IsComplete(const Submission& submission) const;
+    void Wait(const Submission& submission);
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_buffer;
+    uint8_t* m_mappedData;
+    UINT64 m_capacity;
+
+    // Monotonic byte counters; physical offset = counter % capacity
+    UINT64 m_head;            // Next free byte
+    UINT64 m_tail;            // Oldest byte still read by the GPU
+    UINT64 m_submittedHead;   // m_head at the last Submit
+
+    Microsoft::WRL::ComPtr<ID3D12Device> m_device;
+    std::vector<QueueFence> m_queueFences;
+    HANDLE m_fenceEvent;
+    UINT64 m_nextSubmissionId;
+    std::deque<Submission> m_inFlight;
+};
+
+} // namespace ACG
@@ -6,11 +6,13 @@
 #include <vector>
 #include <unordered_map>
 #include <queue>
+#include <cstdint>
 
 namespace ACG {
 
 // Forward declarations
 class Texture;
+class UploadRing;
 
 /**
  * @brief Virtual Texture Tile Information
@@ -33,6 +35,7 @@ struct VirtualTextureConfig {
     uint32_t maxPhysicalPages = 4096;     // Maximum physical memory pages (256MB at 256x256 RGBA)
     uint32_t maxVirtualTextures = 1024;   // Maximum number of virtual textures
     uint32_t feedbackBufferSize = 1024;   // Size of feedback buffer for streaming
+    uint32_t maxTileUploadsPerUpdate = 128; // Tiles streamed per feedback update (64KB each as BC7)
     bool enableTiledResources = true;     // Use DX12 tiled resources
     bool enableSparseBinding = true;      // Use sparse binding for better memory efficiency
 };
@@ -47,8 +50,12 @@ public:
     VirtualTextureSystem();
     ~VirtualTextureSystem();
 
-    // Initialize the virtual texture system
-    bool Initialize(ID3D12Device* device, const VirtualTextureConfig& config);
+    /**
+     * @brief Initialize the virtual texture system
+     * @param uploadRing Staging memory for tile and indirection uploads (shared with the renderer,
+     *        which submits it after executing the lists UpdateStreaming recorded into)
+     */
+    bool Initialize(ID3D12Device* device, const VirtualTextureConfig& config, UploadRing* uploadRing);
     
     // Check if tiled resources are supported
     bool CheckTiledResourcesSupport(ID3D12Device* device);
@@ -57,12 +64,38 @@ public:
     // Returns virtual texture index
     int32_t AddVirtualTexture(const std::shared_ptr<Texture>& texture);
     
-    // Upload all tiles for all textures (after all textures added)
+    /**
+     * @brief Build mip levels, compress them and prefill the physical cache (after all textures added)
+     * Tiles are made resident coarsest level first until the cache is full; the rest stream in
+     * on demand through the feedback buffer, so this only fails on device errors.
+     */
     bool UploadAllTiles(ID3D12GraphicsCommandList* cmdList, ID3D12CommandQueue* commandQueue);
     
-    // Create indirection texture for shader access
+    // Create indirection buffer (tile -> physical page, t6) for shader access
     bool CreateIndirectionTexture(ID3D12GraphicsCommandList* cmdList, ID3D12CommandQueue* commandQueue);
     
+    // Create the tile request feedback buffer (u1) and per-texture info buffer (t9)
+    bool CreateFeedbackResources(ID3D12CommandQueue* commandQueue);
+    
+    /**
+     * @brief Copy the feedback buffer to the CPU readback buffer and clear it
+     * Record at the end of a render batch; the copy completes with the batch's own fence,
+     * so reading the requests costs no extra GPU synchronization.
+     */
+    void RecordFeedbackReadback(ID3D12GraphicsCommandList* cmdList);
+    
+    /**
+     * @brief Process the last feedback readback and record uploads for missing tiles
+     * Must be called after the command list holding RecordFeedbackReadback has completed,
+     * and before the VT descriptor tables are bound on cmdList (the copies are recorded first).
+     * Least recently requested pages are evicted when the cache is full.
+     * @return Number of tiles uploaded in this update
+     */
+    uint32_t UpdateStreaming(ID3D12GraphicsCommandList* cmdList);
+    
+    // Tiles requested by the last processed feedback that are still not resident
+    uint32_t GetPendingTileCount() const { return static_cast<uint32_t>(m_pendingRequests.size()); }
+    
     // Upload texture data for a specific tile
     void UploadTile(ID3D12GraphicsCommandList* cmdList, 
                     uint32_t virtualTextureIndex,
@@ -72,32 +105,46 @@ public:
                     const void* data,
                     size_t dataSize);
     
-    // Make a tile resident in GPU memory
-    bool MakeTileResident(ID3D12CommandQueue* commandQueue,
+    // Outcome of MakeTileResident: OutOfSpace may succeed on a later update, Invalid never will
+    // (the tile is out of range or its level has no compressed blocks)
+    enum class TileResidency {
+        Resident,
+        OutOfSpace,
+        Invalid
+    };
+    
+    /**
+     * @brief Make a tile resident in the physical cache
+     * Allocates a page (evicting the least recently used one if the cache is full), stages the
+     * tile's blocks in the upload ring and records the copy on cmdList. The physical cache must be in COPY_DEST.
+     * @return OutOfSpace if no page could be freed or the upload ring has no space left for this submission
+     */
+    TileResidency MakeTileResident(ID3D12GraphicsCommandList* cmdList,
                          uint32_t virtualTextureIndex,
                          uint32_t mipLevel,
                          uint32_t tileX,
                          uint32_t tileY);
     
-    // Evict a tile from GPU memory
-    void EvictTile(ID3D12CommandQueue* commandQueue,
-                   uint32_t virtualTextureIndex,
+    // Evict a tile from GPU memory (its page is returned to the free list)
+    void EvictTile(uint32_t virtualTextureIndex,
                    uint32_t mipLevel,
                    uint32_t tileX,
                    uint32_t tileY);
     
-    // Create SRV for shader access
+    // Create SRVs/UAV for shader access
     void CreateShaderResourceView(ID3D12Device* device,
                                   D3D12_CPU_DESCRIPTOR_HANDLE srvHandle,
-                                  D3D12_CPU_DESCRIPTOR_HANDLE indirectionSrvHandle);
+                                  D3D12_CPU_DESCRIPTOR_HANDLE indirectionSrvHandle,
+                                  D3D12_CPU_DESCRIPTOR_HANDLE textureInfoSrvHandle,
+                                  D3D12_CPU_DESCRIPTOR_HANDLE feedbackUavHandle);
     
     // Get virtual texture resources for binding
     ID3D12Resource* GetVirtualTexture(uint32_t index) const {
         return (index < m_virtualTextures.size()) ? m_virtualTextures[index].Get() : nullptr;
     }
     
-    ID3D12Resource* GetIndirectionTexture() const {
-        return m_indirectionTexture.Get();
+    ID3D12Resource* GetIndirectionBuffer() const {
+        return m_indirectionBuffer.Get();
     }
     
     // Get virtual texture info for shader
@@ -119,7 +166,7 @@ public:
     };
     Statistics GetStatistics() const;
     
-    // Feedback-based streaming (for future optimization)
+    // Mark requested tiles as used and queue the non-resident ones (one uint per tile)
     void ProcessFeedback(const void* feedbackData, size_t dataSize);
     
 private:
@@ -128,17 +175,30 @@ private:
     Microsoft::WRL::ComPtr<ID3D12Heap> m_physicalMemoryHeap;
     std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_virtualTextures;
     Microsoft::WRL::ComPtr<ID3D12Resource> m_physicalCacheTexture;  // Single large texture for all physical pages
-    Microsoft::WRL::ComPtr<ID3D12Resource> m_indirectionTexture;  // Maps virtual coords to physical tiles
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_indirectionBuffer;  // Maps virtual tiles (feedback order) to physical pages
+    
+    // One mip level of a virtual texture; its tiles are stored contiguously in `tiles`
+    struct VirtualTextureMip {
+        uint32_t width;
+        uint32_t height;
+        uint32_t numTilesX;
+        uint32_t numTilesY;
+        uint32_t firstTile;                    // Index of the level's first tile in `tiles`
+        std::vector<uint8_t> compressedBlocks; // Whole level, source for streamed tiles
+    };
     
     // Virtual texture metadata
     struct VirtualTextureMetadata {
         uint32_t width;
         uint32_t height;
-        uint32_t numMipLevels;
+        uint32_t numMipLevels;                 // Down to the first level that fits in one tile
         uint32_t numTilesX;
         uint32_t numTilesY;
-        std::vector<VirtualTextureTile> tiles;
+        std::vector<VirtualTextureMip> mips;
+        std::vector<VirtualTextureTile> tiles; // All levels, finest first
         std::shared_ptr<Texture> sourceTexture;
+        uint32_t feedbackOffset;              // First entry in the feedback/indirection buffers
+        float fallbackColor[4];               // Average color shown while no level is resident
     };
     std::vector<VirtualTextureMetadata> m_virtualTextureMetadata;
     
@@ -149,10 +209,39 @@ private:
         uint32_t mipLevel;
         uint32_t tileX;
         uint32_t tileY;
+        uint64_t lastUsedFrame;       // Feedback update that last requested this page (LRU)
     };
     std::vector<PhysicalPage> m_physicalPages;
     std::queue<uint32_t> m_freePhysicalPages;
     
+    // Per-texture layout for the shader (32 bytes, matches VirtualTextureInfo in Structures.hlsli)
+    struct GPUTextureInfo {
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t feedbackOffset;
+        float fallbackColor[4];
+    };
+    
+    // Feedback streaming
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_feedbackBuffer;      // u1, one uint per tile
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_feedbackReadback;    // CPU copy of the last batch's requests
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_feedbackClearBuffer; // Zeros, copied over the feedback buffer
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_textureInfoBuffer;   // t9, GPUTextureInfo per texture
+    uint32_t m_totalTiles;
+    bool m_feedbackPending;                 // A readback was recorded but not processed yet
+    uint64_t m_feedbackFrame;               // Incremented per processed feedback (LRU clock)
+    std::vector<uint32_t> m_pendingRequests; // Global tile indices (feedbackOffset + tile)
+    
+    // Streaming staging memory (owned by the renderer)
+    UploadRing* m_uploadRing;
+    uint32_t m_streamingUploadUsed;         // Tiles staged in the current update
+    
+    // CPU copy of the indirection buffer (one page index per tile, same order as the feedback)
+    std::vector<uint32_t> m_indirectionData;
+    uint32_t m_indirectionDirtyBegin;       // Range of entries changed since the last upload
+    uint32_t m_indirectionDirtyEnd;
+    
     // Configuration
     VirtualTextureConfig m_config;
     
@@ -165,9 +254,10 @@ private:
     void FreePhysicalPage(uint32_t pageIndex);
     uint32_t CalculateNumTiles(uint32_t dimension, uint32_t tileSize) const;
     void CreateTiledResource(uint32_t width, uint32_t height, uint32_t mipLevels);
-    
-    // Upload buffer management (kept alive until GPU finishes)
-    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_uploadBuffers;
+    uint32_t EvictLeastRecentlyUsedPage();
+    void SetIndirectionEntry(uint32_t virtualTextureIndex, uint32_t tileIndex, uint32_t pageIndex);
+    void RecordIndirectionUpdate(ID3D12GraphicsCommandList* cmdList, bool transition);
+    void ExecuteAndWait(ID3D12CommandQueue* commandQueue, ID3D12GraphicsCommandList* cmdList);
 };
 
 } // namespace ACG
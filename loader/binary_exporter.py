@@ -3,7 +3,10 @@ Binary Scene Exporter - 高性能二进制格式
 相比JSON减少90%文件大小和解析时间
 """
 
+import io
+import math
 import struct
+from array import array
 from pathlib import Path
 from typing import BinaryIO
 from data_structures import SceneData, Mesh, Material, Vertex
@@ -14,20 +17,158 @@ class BinarySceneExporter:
     
     # 文件魔数和版本
     MAGIC = b'ACGS'  # ACG Scene
-    VERSION = 1
+    VERSION = 3              # 分块布局 + 段表, 顶点为着色器的两个流 (C++端内存映射零拷贝读取)
+    VERSION_INTERLEAVED = 2  # 同上, 但顶点为48字节记录 (由渲染器上传时量化)
+    VERSION_STREAMED = 1     # 旧版顺序布局
     
-    def export(self, scene: SceneData, output_path: str):
+    # VERSION 2/3 段类型 (与 SceneLoader.h 中 SectionType 一致)
+    SECTION_MATERIALS = 1
+    SECTION_TEXTURES = 2
+    SECTION_MESHES = 3
+    SECTION_MESH_NAMES = 4
+    SECTION_VERTICES = 5
+    SECTION_INDICES = 6
+    SECTION_TRIANGLE_MATERIALS = 7
+    SECTION_POSITIONS = 9
+    SECTION_VERTEX_ATTRIBUTES = 10
+    
+    SECTION_ALIGNMENT = 256  # 几何段对齐, 便于直接拷贝到上传堆
+    
+    def export(self, scene: SceneData, output_path: str, version: int = VERSION):
         """导出场景到二进制文件"""
+        if version == self.VERSION_STREAMED:
+            with open(output_path, 'wb') as f:
+                self._write_header(f, self.VERSION_STREAMED)
+                self._write_materials(f, scene.materials)
+                self._write_textures(f, scene.textures)
+                self._write_meshes(f, scene.meshes)
+            return
+        
+        sections = self._build_sections(scene, version)
         with open(output_path, 'wb') as f:
-            self._write_header(f)
-            self._write_materials(f, scene.materials)
-            self._write_textures(f, scene.textures)
-            self._write_meshes(f, scene.meshes)
+            self._write_header(f, version)
+            f.write(struct.pack('2I', len(sections), 0))
+            
+            # 段表之后按对齐布局各段
+            table_size = len(sections) * 24
+            offset = self._align(16 + table_size)
+            layout = []
+            for section_type, count, payload in sections:
+                layout.append((section_type, count, offset, len(payload)))
+                offset = self._align(offset + len(payload))
+            
+            for section_type, count, section_offset, size in layout:
+                f.write(struct.pack('<IIQQ', section_type, count, section_offset, size))
+            
+            for (section_type, count, payload), (_, _, section_offset, _) in zip(sections, layout):
+                f.write(b'\0' * (section_offset - f.tell()))
+                f.write(payload)
+    
+    def _align(self, value: int) -> int:
+        alignment = self.SECTION_ALIGNMENT
+        return (value + alignment - 1) // alignment * alignment
+    
+    @staticmethod
+    def _encode_octahedral(normal) -> int:
+        """与 Renderer.cpp 的 EncodeOctahedralNormal 相同: 两个unorm16, x在低16位"""
+        length1 = max(abs(normal[0]) + abs(normal[1]) + abs(normal[2]), 1e-20)
+        x = normal[0] / length1
+        y = normal[1] / length1
+        if normal[2] < 0.0:
+            x, y = ((1.0 - abs(y)) * (1.0 if x >= 0.0 else -1.0),
+                    (1.0 - abs(x)) * (1.0 if y >= 0.0 else -1.0))
+        
+        def quantize(e):
+            return int(math.floor(min(max(e * 0.5 + 0.5, 0.0), 1.0) * 65535.0 + 0.5))
+        return quantize(x) | (quantize(y) << 16)
+    
+    @staticmethod
+    def _clamp_half(value: float) -> float:
+        """half的最大有限值为65504, struct 'e' 对超出范围的值抛异常"""
+        return min(max(value, -65504.0), 65504.0)
+    
+    def _build_sections(self, scene: SceneData, version: int = VERSION) -> list:
+        """构建 VERSION 2/3 各段: [(type, count, bytes)]"""
+        materials = io.BytesIO()
+        self._write_materials(materials, scene.materials)
+        textures = io.BytesIO()
+        self._write_textures(textures, scene.textures)
+        
+        # 材质/纹理段沿用 VERSION 1 编码 (含开头的数量字段), C++端复用同一解析函数
+        material_bytes = materials.getvalue()
+        texture_bytes = textures.getvalue()
+        
+        split_streams = version != self.VERSION_INTERLEAVED
+        attribute_struct = struct.Struct('<Iee')
+        
+        mesh_records = bytearray()
+        mesh_names = bytearray()
+        vertices = array('f')           # VERSION 2: 48字节记录
+        positions = array('f')          # VERSION 3: float3
+        attributes = bytearray()        # VERSION 3: 八面体法线 + half纹理坐标, 8字节
+        indices = array('I')
+        triangle_materials = array('I')
+        vertex_count = 0
+        
+        for mesh in scene.meshes:
+            first_vertex = vertex_count
+            first_index = len(indices)
+            vertex_count += len(mesh.vertices)
+            
+            bbox_min = [float('inf')] * 3
+            bbox_max = [float('-inf')] * 3
+            for v in mesh.vertices:
+                if split_streams:
+                    positions.extend(v.position)
+                    attributes += attribute_struct.pack(self._encode_octahedral(v.normal),
+                                                        self._clamp_half(v.texcoord[0]),
+                                                        self._clamp_half(v.texcoord[1]))
+                else:
+                    # 48字节顶点: position, normal, texcoord, tangent, padding
+                    vertices.extend(v.position)
+                    vertices.extend(v.normal)
+                    vertices.extend(v.texcoord)
+                    vertices.extend(v.tangent)
+                    vertices.append(0.0)
+                for axis in range(3):
+                    bbox_min[axis] = min(bbox_min[axis], v.position[axis])
+                    bbox_max[axis] = max(bbox_max[axis], v.position[axis])
+            if not mesh.vertices:
+                bbox_min = [0.0] * 3
+                bbox_max = [0.0] * 3
+            
+            # 索引加上基顶点, 使渲染器可直接使用
+            indices.extend(first_vertex + i for i in mesh.indices)
+            triangle_materials.extend([mesh.material_index] * (len(mesh.indices) // 3))
+            
+            mesh_records += struct.pack('<IIQQII3f3f',
+                mesh.material_index, len(mesh.vertices),
+                first_vertex, first_index, len(mesh.indices), 0,
+                *bbox_min, *bbox_max)
+            name_bytes = mesh.name.encode('utf-8')
+            mesh_names += struct.pack('I', len(name_bytes)) + name_bytes
+        
+        if split_streams:
+            vertex_sections = [
+                (self.SECTION_POSITIONS, vertex_count, positions.tobytes()),
+                (self.SECTION_VERTEX_ATTRIBUTES, vertex_count, bytes(attributes)),
+            ]
+        else:
+            vertex_sections = [(self.SECTION_VERTICES, vertex_count, vertices.tobytes())]
+        return [
+            (self.SECTION_MATERIALS, len(scene.materials), material_bytes),
+            (self.SECTION_TEXTURES, len(scene.textures), texture_bytes),
+            (self.SECTION_MESHES, len(scene.meshes), bytes(mesh_records)),
+            (self.SECTION_MESH_NAMES, len(scene.meshes), bytes(mesh_names)),
+            *vertex_sections,
+            (self.SECTION_INDICES, len(indices), indices.tobytes()),
+            (self.SECTION_TRIANGLE_MATERIALS, len(triangle_materials), triangle_materials.tobytes()),
+        ]
     
-    def _write_header(self, f: BinaryIO):
+    def _write_header(self, f: BinaryIO, version: int):
         """写入文件头：魔数(4字节) + 版本(4字节)"""
         f.write(self.MAGIC)
-        f.write(struct.pack('I', self.VERSION))
+        f.write(struct.pack('I', version))
     
     def _write_materials(self, f: BinaryIO, materials: list):
         """写入材质数据"""
@@ -121,7 +262,7 @@ class BinarySceneExporter:
 
 
 class BinarySceneImporter:
-    """C++端对应的导入器示例（Python参考实现）"""
+    """C++端对应的导入器示例（Python参考实现, 仅 VERSION 1）"""
     
     def load(self, file_path: str) -> SceneData:
         """从二进制文件加载场景"""
@@ -134,7 +275,7 @@ class BinarySceneImporter:
                 raise ValueError(f"Invalid file format: {magic}")
             
             version = struct.unpack('I', f.read(4))[0]
-            if version != BinarySceneExporter.VERSION:
+            if version != BinarySceneExporter.VERSION_STREAMED:
                 raise ValueError(f"Unsupported version: {version}")
             
             # 读取数据
@@ -0,0 +1,449 @@
+"""
+glTF 2.0 Loader
+Parses .gltf (JSON + external or embedded buffers) and .glb files with the standard library only.
+Node transforms are baked into the vertices; metallic-roughness materials map directly to PBR.
+"""
+
+import base64
+import json
+import math
+import struct
+from pathlib import Path
+from typing import List, Optional, Tuple
+import logging
+
+from base_loader import BaseLoader, LoaderRegistry
+from data_structures import (
+    SceneData, Mesh, Material, Vertex, Texture,
+    TransmissionLayer
+)
+
+
+logger = logging.getLogger(__name__)
+
+
+# componentType -> (struct format, byte size, max value of normalized integers)
+COMPONENT_TYPES = {
+    5120: ('b', 1, 127.0),
+    5121: ('B', 1, 255.0),
+    5122: ('h', 2, 32767.0),
+    5123: ('H', 2, 65535.0),
+    5125: ('I', 4, None),
+    5126: ('f', 4, None),
+}
+
+# accessor type -> component count
+TYPE_SIZES = {
+    'SCALAR': 1, 'VEC2': 2, 'VEC3': 3, 'VEC4': 4,
+    'MAT2': 4, 'MAT3': 9, 'MAT4': 16,
+}
+
+# primitive.mode
+MODE_TRIANGLES = 4
+MODE_TRIANGLE_STRIP = 5
+MODE_TRIANGLE_FAN = 6
+
+GLB_MAGIC = 0x46546C67  # 'glTF'
+GLB_CHUNK_JSON = 0x4E4F534A
+GLB_CHUNK_BIN = 0x004E4942
+
+IDENTITY = [[1.0, 0.0, 0.0, 0.0], [0.0, 1.0, 0.0, 0.0], [0.0, 0.0, 1.0, 0.0], [0.0, 0.0, 0.0, 1.0]]
+
+
+def _mat_mul(a: List[List[float]], b: List[List[float]]) -> List[List[float]]:
+    """4x4 row-major product"""
+    return [[sum(a[r][k] * b[k][c] for k in range(4)) for c in range(4)] for r in range(4)]
+
+
+def _normalize(v: List[float], fallback: List[float]) -> List[float]:
+    length = math.sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2])
+    if length < 1e-12:
+        return list(fallback)
+    return [v[0] / length, v[1] / length, v[2] / length]
+
+
+@LoaderRegistry.register('.gltf', '.glb')
+class GltfLoader(BaseLoader):
+    """
+    Loader for glTF 2.0 scenes.
+    Supports KHR_materials_transmission, KHR_materials_ior and KHR_materials_emissive_strength;
+    other extensions (clearcoat, specular, texture transforms) are ignored.
+    """
+
+    def supports_advanced_materials(self) -> bool:
+        """Transmission is the only layer the binary format carries"""
+        return True
+
+    def load(self) -> SceneData:
+        """Load glTF/GLB file"""
+        logger.info(f"Parsing glTF file: {self.filepath}")
+
+        self.gltf, glb_binary = self._read_document()
+        self.buffers = self._read_buffers(glb_binary)
+
+        # Textures first: materials reference them by index into scene.textures
+        texture_paths = self._extract_images()
+        self.scene.materials = self._extract_materials(texture_paths)
+        self.scene.textures = [Texture(path=path) for path in self.texture_list]
+        logger.info(f"Collected {len(self.scene.textures)} unique textures")
+
+        self.scene.meshes = self._extract_meshes()
+
+        # Validate and log statistics
+        self.validate_scene()
+        self.log_statistics()
+
+        return self.scene
+
+    # ------------------------------------------------------------------
+    # Document and buffers
+    # ------------------------------------------------------------------
+
+    def _read_document(self) -> Tuple[dict, Optional[bytes]]:
+        """Read the JSON document (and the BIN chunk of a .glb)"""
+        data = self.filepath.read_bytes()
+        if len(data) >= 12 and struct.unpack_from('<I', data, 0)[0] == GLB_MAGIC:
+            _, version, length = struct.unpack_from('<III', data, 0)
+            if version != 2:
+                raise ValueError(f"Unsupported GLB version: {version}")
+
+            document = None
+            binary = None
+            offset = 12
+            while offset + 8 <= length:
+                chunk_length, chunk_type = struct.unpack_from('<II', data, offset)
+                chunk = data[offset + 8:offset + 8 + chunk_length]
+                if chunk_type == GLB_CHUNK_JSON:
+                    document = json.loads(chunk.decode('utf-8'))
+                elif chunk_type == GLB_CHUNK_BIN and binary is None:
+                    binary = chunk
+                offset += 8 + chunk_length
+            if document is None:
+                raise ValueError("GLB file has no JSON chunk")
+            return document, binary
+
+        return json.loads(data.decode('utf-8')), None
+
+    def _read_uri(self, uri: str) -> bytes:
+        """Read a buffer or image URI (data URI or path relative to the glTF file)"""
+        if uri.startswith('data:'):
+            header, _, payload = uri.partition(',')
+            if ';base64' in header:
+                return base64.b64decode(payload)
+            from urllib.parse import unquote_to_bytes
+            return unquote_to_bytes(payload)
+        from urllib.parse import unquote
+        return (self.filepath.parent / unquote(uri)).read_bytes()
+
+    def _read_buffers(self, glb_binary: Optional[bytes]) -> List[bytes]:
+        """Load every buffer; a buffer without uri is the GLB BIN chunk"""
+        buffers = []
+        for index, buffer in enumerate(self.gltf.get('buffers', [])):
+            if 'uri' in buffer:
+                buffers.append(self._read_uri(buffer['uri']))
+            elif glb_binary is not None:
+                buffers.append(glb_binary)
+            else:
+                raise ValueError(f"Buffer {index} has no uri and the file is not a GLB")
+        return buffers
+
+    def _buffer_view_bytes(self, view_index: int) -> Tuple[bytes, int, Optional[int]]:
+        """(buffer bytes, byte offset, byte stride) of a bufferView"""
+        view = self.gltf['bufferViews'][view_index]
+        return self.buffers[view['buffer']], view.get('byteOffset', 0), view.get('byteStride')
+
+    def _read_accessor(self, accessor_index: int) -> List[tuple]:
+        """Read an accessor as a list of component tuples (floats for normalized integers)"""
+        accessor = self.gltf['accessors'][accessor_index]
+        component_format, component_size, normalized_max = COMPONENT_TYPES[accessor['componentType']]
+        components = TYPE_SIZES[accessor['type']]
+        count = accessor['count']
+        element = struct.Struct('<' + component_format * components)
+
+        if 'bufferView' in accessor:
+            buffer, view_offset, stride = self._buffer_view_bytes(accessor['bufferView'])
+            offset = view_offset + accessor.get('byteOffset', 0)
+            stride = stride or element.size
+            if stride == element.size:
+                values = list(element.iter_unpack(buffer[offset:offset + count * element.size]))
+            else:
+                # Interleaved vertex data
+                values = [element.unpack_from(buffer, offset + i * stride) for i in range(count)]
+        else:
+            values = [(0,) * components] * count
+
+        if 'sparse' in accessor:
+            sparse = accessor['sparse']
+            indices_desc = sparse['indices']
+            index_format = COMPONENT_TYPES[indices_desc['componentType']][0]
+            buffer, view_offset, _ = self._buffer_view_bytes(indices_desc['bufferView'])
+            indices = struct.unpack_from(f"<{sparse['count']}{index_format}", buffer,
+                                         view_offset + indices_desc.get('byteOffset', 0))
+            values_desc = sparse['values']
+            buffer, view_offset, _ = self._buffer_view_bytes(values_desc['bufferView'])
+            base = view_offset + values_desc.get('byteOffset', 0)
+            for i, index in enumerate(indices):
+                values[index] = element.unpack_from(buffer, base + i * element.size)
+
+        if accessor.get('normalized', False) and normalized_max is not None:
+            return [tuple(max(c / normalized_max, -1.0) for c in value) for value in values]
+        return values
+
+    # ------------------------------------------------------------------
+    # Images and materials
+    # ------------------------------------------------------------------
+
+    def _extract_images(self) -> List[str]:
+        """Resolve every image to a file path; embedded images are written next to the glTF file"""
+        paths = []
+        for index, image in enumerate(self.gltf.get('images', [])):
+            uri = image.get('uri')
+            if uri and not uri.startswith('data:'):
+                from urllib.parse import unquote
+                path = self.filepath.parent / unquote(uri)
+                if path.exists():
+                    paths.append(str(path.resolve()))
+                else:
+                    logger.warning(f"Texture not found: {path}")
+                    paths.append("")
+                continue
+
+            # Data URI or bufferView: the renderer loads textures from files
+            if uri:
+                data = self._read_uri(uri)
+                mime = uri[5:].split(';')[0].split(',')[0]
+            else:
+                buffer, offset, _ = self._buffer_view_bytes(image['bufferView'])
+                view = self.gltf['bufferViews'][image['bufferView']]
+                data = buffer[offset:offset + view['byteLength']]
+                mime = image.get('mimeType', '')
+            extension = '.jpg' if 'jpeg' in mime else '.png'
+            image_dir = self.filepath.parent / f"{self.filepath.stem}_images"
+            image_dir.mkdir(exist_ok=True)
+            path = image_dir / f"image_{index}{extension}"
+            path.write_bytes(data)
+            paths.append(str(path.resolve()))
+        return paths
+
+    def _extract_materials(self, image_paths: List[str]) -> List[Material]:
+        """Map glTF metallic-roughness materials to renderer materials"""
+        self.texture_list = []  # Unique texture paths
+        texture_map = {}        # Path -> index mapping
+
+        def add_texture(texture_info: Optional[dict]) -> int:
+            """Add the image of a textureInfo to the list and return its index"""
+            if not texture_info:
+                return -1
+            textures = self.gltf.get('textures', [])
+            texture_index = texture_info.get('index', -1)
+            if texture_index < 0 or texture_index >= len(textures):
+                return -1
+            source = textures[texture_index].get('source')
+            if source is None or source >= len(image_paths) or not image_paths[source]:
+                return -1
+            path = image_paths[source]
+            if path not in texture_map:
+                texture_map[path] = len(self.texture_list)
+                self.texture_list.append(path)
+            return texture_map[path]
+
+        materials = []
+        for index, gltf_material in enumerate(self.gltf.get('materials', [])):
+            material = Material(name=gltf_material.get('name', f"material_{index}"))
+            pbr = gltf_material.get('pbrMetallicRoughness', {})
+            extensions = gltf_material.get('extensions', {})
+
+            base_color = pbr.get('baseColorFactor', [1.0, 1.0, 1.0, 1.0])
+            material.base_color = [float(c) for c in base_color[:3]]
+            material.metallic = float(pbr.get('metallicFactor', 1.0))
+            material.roughness = float(pbr.get('roughnessFactor', 1.0))
+            if gltf_material.get('alphaMode', 'OPAQUE') == 'BLEND':
+                material.opacity = float(base_color[3])
+
+            emissive_strength = float(extensions.get('KHR_materials_emissive_strength', {}).get('emissiveStrength', 1.0))
+            material.emission = [float(c) * emissive_strength for c in gltf_material.get('emissiveFactor', [0.0, 0.0, 0.0])]
+
+            if 'KHR_materials_ior' in extensions:
+                material.ior = float(extensions['KHR_materials_ior'].get('ior', 1.5))
+
+            transmission = extensions.get('KHR_materials_transmission')
+            if transmission and float(transmission.get('transmissionFactor', 0.0)) > 0.0:
+                material.transmission = TransmissionLayer(
+                    strength=float(transmission['transmissionFactor']),
+                    roughness=material.roughness,
+                    depth=0.0,
+                    color=list(material.base_color),
+                    texture_index=-1
+                )
+                logger.debug(f"  Transmission layer added (strength: {material.transmission.strength:.2f})")
+
+            material.base_color_texture = add_texture(pbr.get('baseColorTexture'))
+            material.normal_texture = add_texture(gltf_material.get('normalTexture'))
+            material.metallic_roughness_texture = add_texture(pbr.get('metallicRoughnessTexture'))
+            material.emission_texture = add_texture(gltf_material.get('emissiveTexture'))
+
+            materials.append(material)
+
+        # Primitives without a material
+        self.default_material_index = len(materials)
+        materials.append(Material(name="default"))
+        return materials
+
+    # ------------------------------------------------------------------
+    # Geometry
+    # ------------------------------------------------------------------
+
+    @staticmethod
+    def _node_matrix(node: dict) -> List[List[float]]:
+        """Local transform of a node (column-major matrix or TRS) as a row-major 4x4"""
+        if 'matrix' in node:
+            m = [float(v) for v in node['matrix']]
+            return [[m[c * 4 + r] for c in range(4)] for r in range(4)]
+
+        tx, ty, tz = node.get('translation', [0.0, 0.0, 0.0])
+        x, y, z, w = node.get('rotation', [0.0, 0.0, 0.0, 1.0])
+        sx, sy, sz = node.get('scale', [1.0, 1.0, 1.0])
+        rotation = [
+            [1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w)],
+            [2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w)],
+            [2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y)],
+        ]
+        # T * R * S
+        return [
+            [rotation[0][0] * sx, rotation[0][1] * sy, rotation[0][2] * sz, tx],
+            [rotation[1][0] * sx, rotation[1][1] * sy, rotation[1][2] * sz, ty],
+            [rotation[2][0] * sx, rotation[2][1] * sy, rotation[2][2] * sz, tz],
+            [0.0, 0.0, 0.0, 1.0],
+        ]
+
+    def _mesh_nodes(self) -> List[Tuple[int, List[List[float]]]]:
+        """(mesh index, world transform) of every mesh node of the default scene"""
+        nodes = self.gltf.get('nodes', [])
+        scenes = self.gltf.get('scenes', [])
+        if scenes:
+            roots = scenes[self.gltf.get('scene', 0)].get('nodes', [])
+        else:
+            # No scene: every node that is nobody's child is a root
+            children = {child for node in nodes for child in node.get('children', [])}
+            roots = [i for i in range(len(nodes)) if i not in children]
+
+        result = []
+        stack = [(root, IDENTITY) for root in reversed(roots)]
+        while stack:
+            node_index, parent = stack.pop()
+            node = nodes[node_index]
+            world = _mat_mul(parent, self._node_matrix(node))
+            if 'mesh' in node:
+                result.append((node['mesh'], world))
+            for child in reversed(node.get('children', [])):
+                stack.append((child, world))
+        return result
+
+    @staticmethod
+    def _triangle_indices(indices: List[int], mode: int) -> Optional[List[int]]:
+        """Triangle list of a primitive (None for points and lines)"""
+        if mode == MODE_TRIANGLES:
+            return indices[:len(indices) - len(indices) % 3]
+        if mode == MODE_TRIANGLE_STRIP:
+            triangles = []
+            for i in range(len(indices) - 2):
+                a, b, c = indices[i], indices[i + 1], indices[i + 2]
+                triangles.extend((a, b, c) if i % 2 == 0 else (b, a, c))
+            return triangles
+        if mode == MODE_TRIANGLE_FAN:
+            triangles = []
+            for i in range(1, len(indices) - 1):
+                triangles.extend((indices[0], indices[i], indices[i + 1]))
+            return triangles
+        return None
+
+    @staticmethod
+    def _compute_normals(positions: List[tuple], indices: List[int]) -> List[List[float]]:
+        """Area-weighted vertex normals for primitives without NORMAL"""
+        normals = [[0.0, 0.0, 0.0] for _ in positions]
+        for t in range(0, len(indices), 3):
+            i0, i1, i2 = indices[t], indices[t + 1], indices[t + 2]
+            p0, p1, p2 = positions[i0], positions[i1], positions[i2]
+            e1 = [p1[k] - p0[k] for k in range(3)]
+            e2 = [p2[k] - p0[k] for k in range(3)]
+            face = [e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]]
+            for i in (i0, i1, i2):
+                for k in range(3):
+                    normals[i][k] += face[k]
+        return [_normalize(n, [0.0, 0.0, 1.0]) for n in normals]
+
+    def _extract_meshes(self) -> List[Mesh]:
+        """Bake every primitive of every mesh node into a world-space mesh"""
+        meshes = []
+        gltf_meshes = self.gltf.get('meshes', [])
+
+        for mesh_index, world in self._mesh_nodes():
+            gltf_mesh = gltf_meshes[mesh_index]
+            m = world
+            # Normals use the cofactor matrix (inverse transpose up to scale); a mirroring
+            # transform also reverses the triangle winding
+            cofactor = [
+                [m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0]],
+                [m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][1] * m[2][0] - m[0][0] * m[2][1]],
+                [m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0]],
+            ]
+            determinant = m[0][0] * cofactor[0][0] + m[0][1] * cofactor[0][1] + m[0][2] * cofactor[0][2]
+            flip_winding = determinant < 0.0
+
+            def transform_point(p):
+                return [m[r][0] * p[0] + m[r][1] * p[1] + m[r][2] * p[2] + m[r][3] for r in range(3)]
+
+            def transform_vector(v, matrix):
+                return [matrix[r][0] * v[0] + matrix[r][1] * v[1] + matrix[r][2] * v[2] for r in range(3)]
+
+            for primitive_index, primitive in enumerate(gltf_mesh.get('primitives', [])):
+                attributes = primitive.get('attributes', {})
+                if 'POSITION' not in attributes:
+                    continue
+
+                positions = self._read_accessor(attributes['POSITION'])
+                vertex_count = len(positions)
+                if 'indices' in primitive:
+                    indices = [value[0] for value in self._read_accessor(primitive['indices'])]
+                else:
+                    indices = list(range(vertex_count))
+                indices = self._triangle_indices(indices, primitive.get('mode', MODE_TRIANGLES))
+                if not indices:
+                    logger.warning(f"Skipping non-triangle primitive {primitive_index} of mesh {mesh_index}")
+                    continue
+
+                if 'NORMAL' in attributes:
+                    normals = self._read_accessor(attributes['NORMAL'])
+                else:
+                    normals = self._compute_normals(positions, indices)
+                texcoords = (self._read_accessor(attributes['TEXCOORD_0'])
+                             if 'TEXCOORD_0' in attributes else [(0.0, 0.0)] * vertex_count)
+                # Tangent handedness (w) has no slot in the vertex format
+                tangents = self._read_accessor(attributes['TANGENT']) if 'TANGENT' in attributes else None
+
+                vertices = []
+                for i in range(vertex_count):
+                    normal = _normalize(transform_vector(normals[i], cofactor), [0.0, 0.0, 1.0])
+                    tangent = (_normalize(transform_vector(tangents[i], m), [1.0, 0.0, 0.0])
+                               if tangents is not None else [1.0, 0.0, 0.0])
+                    vertices.append(Vertex(
+                        position=transform_point(positions[i]),
+                        normal=normal,
+                        texcoord=[float(texcoords[i][0]), float(texcoords[i][1])],
+                        tangent=tangent
+                    ))
+                if flip_winding:
+                    for t in range(0, len(indices), 3):
+                        indices[t + 1], indices[t + 2] = indices[t + 2], indices[t + 1]
+
+                material_index = primitive.get('material', self.default_material_index)
+                name = gltf_mesh.get('name', f"mesh_{mesh_index}")
+                meshes.append(Mesh(
+                    name=f"{name}_{primitive_index}" if len(gltf_mesh['primitives']) > 1 else name,
+                    vertices=vertices,
+                    indices=list(indices),
+                    material_index=material_index
+                ))
+                logger.debug(f"  {name}: {vertex_count} vertices, material {material_index}")
+
+        return meshes
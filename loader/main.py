@@ -10,6 +10,7 @@ Usage:
 Examples:
     python main.py model.obj scene.acg
     python main.py model.blend scene.acg
+    python main.py model.gltf scene.acg
 """
 
 import sys
@@ -24,6 +25,7 @@ from data_structures import SceneData
 
 # Import all loaders to trigger registration
 import wavefront_loader
+import gltf_loader
 
 # Try to import bpy_loader (optional, only needed for .blend files)
 try:
@@ -0,0 +1,96 @@
+// Environment map importance sampling: builds the piecewise-constant 2D distribution on the GPU
+// Weight of texel (x, y) = luminance * sin(theta) (equirectangular rows shrink toward the poles).
+// RowCdfCS (one group per row) writes each row's normalized inclusive CDF and its unnormalized sum,
+// then MarginalCdfCS (one group) turns the row sums into the marginal CDF over rows.
+// Sampling and pdf evaluation live in Raytracing.hlsl (SampleEnvironment / EnvironmentPdf).
+
+Texture2D<float4> g_environmentMap : register(t0);
+RWStructuredBuffer<float> g_conditionalCdf : register(u0);  // width * height
+RWStructuredBuffer<float> g_marginalCdf : register(u1);     // height + 1: CDF over rows, [height] = total weight
+
+cbuffer CdfConstants : register(b0)
+{
+    uint2 mapSize;
+};
+
+static const uint ROW_THREADS = 256;
+static const uint MARGINAL_THREADS = 1024;
+static const float PI = 3.14159265359f;
+
+groupshared float g_partialSums[MARGINAL_THREADS];
+
+float TexelWeight(uint x, uint y)
+{
+    float3 color = g_environmentMap.Load(int3(x, y, 0)).rgb;
+    float sinTheta = sin(PI * (float(y) + 0.5) / float(mapSize.y));
+    return max(dot(color, float3(0.2126, 0.7152, 0.0722)), 0.0) * sinTheta;
+}
+
+// Inclusive Hillis-Steele scan of g_partialSums[0..count); every thread of the group must call it
+void ScanPartialSums(uint threadIndex, uint count)
+{
+    for (uint offset = 1; offset < count; offset <<= 1) {
+        GroupMemoryBarrierWithGroupSync();
+        float addend = threadIndex >= offset ? g_partialSums[threadIndex - offset] : 0.0;
+        GroupMemoryBarrierWithGroupSync();
+        g_partialSums[threadIndex] += addend;
+    }
+    GroupMemoryBarrierWithGroupSync();
+}
+
+[numthreads(ROW_THREADS, 1, 1)]
+void RowCdfCS(uint3 groupId : SV_GroupID, uint3 groupThreadId : SV_GroupThreadID)
+{
+    uint y = groupId.x;
+    uint threadIndex = groupThreadId.x;
+    uint texelsPerThread = (mapSize.x + ROW_THREADS - 1) / ROW_THREADS;
+    uint first = threadIndex * texelsPerThread;
+    uint last = min(first + texelsPerThread, mapSize.x);
+
+    // Each thread sums a contiguous run of texels, the runs are scanned in group shared memory
+    float localSum = 0.0;
+    for (uint x = first; x < last; ++x) {
+        localSum += TexelWeight(x, y);
+    }
+    g_partialSums[threadIndex] = localSum;
+    ScanPartialSums(threadIndex, ROW_THREADS);
+
+    float rowSum = g_partialSums[ROW_THREADS - 1];
+    float running = g_partialSums[threadIndex] - localSum;
+    uint rowStart = y * mapSize.x;
+    for (uint x = first; x < last; ++x) {
+        running += TexelWeight(x, y);
+        // Black rows stay uniform so the CDF remains valid; the marginal never picks them
+        g_conditionalCdf[rowStart + x] = rowSum > 0.0 ? running / rowSum : float(x + 1) / float(mapSize.x);
+    }
+    if (threadIndex == 0) {
+        g_marginalCdf[y] = rowSum;
+    }
+}
+
+[numthreads(MARGINAL_THREADS, 1, 1)]
+void MarginalCdfCS(uint3 groupThreadId : SV_GroupThreadID)
+{
+    uint threadIndex = groupThreadId.x;
+    uint rowsPerThread = (mapSize.y + MARGINAL_THREADS - 1) / MARGINAL_THREADS;
+    uint first = threadIndex * rowsPerThread;
+    uint last = min(first + rowsPerThread, mapSize.y);
+
+    float localSum = 0.0;
+    for (uint y = first; y < last; ++y) {
+        localSum += g_marginalCdf[y];
+    }
+    g_partialSums[threadIndex] = localSum;
+    ScanPartialSums(threadIndex, MARGINAL_THREADS);
+
+    float total = g_partialSums[MARGINAL_THREADS - 1];
+    float running = g_partialSums[threadIndex] - localSum;
+    // Row sums are replaced in place: each thread reads a row before overwriting it
+    for (uint y = first; y < last; ++y) {
+        running += g_marginalCdf[y];
+        g_marginalCdf[y] = total > 0.0 ? running / total : float(y + 1) / float(mapSize.y);
+    }
+    if (threadIndex == 0) {
+        g_marginalCdf[mapSize.y] = total;
+    }
+}
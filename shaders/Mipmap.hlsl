@@ -0,0 +1,27 @@
+// Mip generation: one dispatch per level, level N = 2x2 box filter of level N-1
+// Same taps as Texture::GenerateMipmaps (odd trailing rows/columns dropped, a dimension of 1 repeats
+// its texel), so GPU and CPU generated chains match. Recorded by Renderer::GenerateMipsOnGpu.
+
+Texture2D<float4> g_source : register(t0);         // Level N-1 (single-mip view)
+RWTexture2D<float4> g_destination : register(u0);  // Level N
+
+cbuffer MipConstants : register(b0)
+{
+    uint2 destinationSize;
+};
+
+[numthreads(8, 8, 1)]
+void DownsampleCS(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    if (any(dispatchThreadId.xy >= destinationSize)) {
+        return;
+    }
+    uint2 sourceSize;
+    g_source.GetDimensions(sourceSize.x, sourceSize.y);
+    
+    uint2 p0 = dispatchThreadId.xy * 2;
+    uint2 p1 = min(p0 + 1, sourceSize - 1);
+    float4 sum = g_source.Load(int3(p0, 0)) + g_source.Load(int3(p1.x, p0.y, 0)) +
+                 g_source.Load(int3(p0.x, p1.y, 0)) + g_source.Load(int3(p1, 0));
+    g_destination[dispatchThreadId.xy] = sum * 0.25;
+}
@@ -26,6 +26,22 @@ float Random(inout uint state) {
     return float(state) / 4294967296.0;
 }
 
+// Owen scrambling by hashing (Burley 2020, "Practical Hash-based Owen Scrambling"). The Laine-Karras
+// permutation only lets bits flow upward, so on reversed bits it is a nested uniform scramble
+uint LaineKarrasPermutation(uint x, uint seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Owen scramble of a 0.32 fixed-point value (or a sample index: shuffles the sequence, keeping its strata)
+uint NestedUniformScramble(uint x, uint seed) {
+    return reversebits(LaineKarrasPermutation(reversebits(x), seed));
+}
+
 // Generate random float2
 float2 Random2D(inout uint state) {
     return float2(Random(state), Random(state));
@@ -1,8 +1,9 @@
 #include "Structures.hlsli"
 #include "Random.hlsli"
 
-// Payload structure for ray tracing
-struct RadiancePayload
+// Path state of one sample while it is shaded (RayGen locals, unpacked by the hit and miss shaders).
+// Between shader stages it travels as the compact RadiancePayload below
+struct PathState
 {
     float3 radiance;      // Accumulated radiance from emission
     float3 throughput;    // Path throughput
@@ -13,8 +14,176 @@ struct RadiancePayload
     // Medium tracking (IOR stack) for nested refractive media
     float iorStack[4];    // Small stack for nested IORs (stack[0] = 1.0 = air)
     uint iorStackTop;     // Current top index
+    // Ray cone for texture LOD (Akenine-Moller et al., "Texture Level of Detail Strategies for Real-Time Ray Tracing")
+    float coneWidth;      // Cone width at the ray origin
+    float coneSpread;     // Cone spread angle (radians)
+    // Next-event estimation: light sample prepared by a diffuse hit, traced by RayGen from nextOrigin
+    float3 shadowDirection;
+    float shadowDistance; // 0 = no light sample
+    float3 shadowRadiance;   // Contribution if unoccluded (throughput, BSDF, MIS weight and pdf applied)
+    float bsdfPdf;        // Solid-angle pdf of the ray that led here; 0 after the camera or a delta lobe
+    bool lastBounce;      // Set by RayGen: no BSDF ray follows, so light samples take the full weight
+    // Denoiser guides of the first hit (or miss), set on the primary ray only and summed by RayGen
+    float3 firstHitAlbedo;
+    float3 firstHitNormal;
+};
+
+// TraceRay payload, 88 bytes instead of PathState's 144: payload size sets the ray stack every bounce pays for.
+// Throughput is half precision, directions are octahedral 16:16, and the IOR stack keeps only the entries
+// above air as halves, read back only while a transmissive medium is on the stack. The first-hit albedo
+// is unorm 10:10:10 with bit 30 set when a normal was recorded (misses have none)
+struct RadiancePayload
+{
+    float3 radiance;
+    uint nextDirection;      // Octahedral
+    float3 nextOrigin;
+    uint rngState;
+    uint2 throughputFlags;   // half r, g | half b, flags (bit 0 terminated, bit 1 lastBounce, bits 2-3 iorStackTop)
+    uint2 iorStack;          // half iorStack[1], iorStack[2] | iorStack[3]
+    float coneWidth;
+    float coneSpread;
+    float bsdfPdf;
+    float shadowDistance;
+    float3 shadowRadiance;
+    uint shadowDirection;    // Octahedral
+    uint firstHitAlbedo;     // unorm 10:10:10 | has-normal bit
+    uint firstHitNormal;     // Octahedral
+};
+
+// Shadow rays only need to know whether anything is in the way
+struct ShadowPayload
+{
+    bool visible;
 };
 
+// Hit record for ShadeHit, filled from the DXR intrinsics (ClosestHit) or from a RayQuery (inline path)
+struct SurfaceHit
+{
+    uint primitiveIndex;     // InstanceID() + PrimitiveIndex(): triangle in the unified index buffer
+    uint materialIndex;      // GetMaterialIndex(InstanceIndex(), PrimitiveIndex())
+    float2 barycentrics;
+    float3 rayOrigin;
+    float3 rayDirection;
+    float t;
+    float3x3 objectToWorld;
+    float3x3 worldToObject;
+};
+
+uint EncodeOctahedral(float3 n)
+{
+    n /= max(abs(n.x) + abs(n.y) + abs(n.z), 1e-20);
+    float2 e = n.xy;
+    if (n.z < 0.0) {
+        e = (1.0 - abs(n.yx)) * select(n.xy >= 0.0, float2(1.0, 1.0), float2(-1.0, -1.0));
+    }
+    uint2 q = uint2(round(saturate(e * 0.5 + 0.5) * 65535.0));
+    return q.x | (q.y << 16);
+}
+
+float3 DecodeOctahedral(uint packed)
+{
+    float2 e = float2(packed & 0xFFFF, packed >> 16) / 65535.0 * 2.0 - 1.0;
+    float3 n = float3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = saturate(-n.z);
+    n.xy += select(n.xy >= 0.0, -fold.xx, fold.xx);
+    return normalize(n);
+}
+
+// Vertex UVs are stored as two halves (VertexAttributes.texCoord)
+float2 DecodeTexCoord(uint packed)
+{
+    return f16tof32(uint2(packed & 0xFFFF, packed >> 16));
+}
+
+RadiancePayload PackPayload(PathState state)
+{
+    RadiancePayload payload;
+    payload.radiance = state.radiance;
+    payload.nextDirection = EncodeOctahedral(state.nextDirection);
+    payload.nextOrigin = state.nextOrigin;
+    payload.rngState = state.rngState;
+    uint flags = (state.terminated ? 1u : 0u) | (state.lastBounce ? 2u : 0u) | (min(state.iorStackTop, 3u) << 2);
+    payload.throughputFlags = uint2(f32tof16(state.throughput.r) | (f32tof16(state.throughput.g) << 16),
+                                    f32tof16(state.throughput.b) | (flags << 16));
+    payload.iorStack = uint2(0, 0);
+    if (state.iorStackTop > 0) {
+        payload.iorStack = uint2(f32tof16(state.iorStack[1]) | (f32tof16(state.iorStack[2]) << 16),
+                                 f32tof16(state.iorStack[3]));
+    }
+    payload.coneWidth = state.coneWidth;
+    payload.coneSpread = state.coneSpread;
+    payload.bsdfPdf = state.bsdfPdf;
+    payload.shadowDistance = state.shadowDistance;
+    payload.shadowRadiance = state.shadowRadiance;
+    payload.shadowDirection = EncodeOctahedral(state.shadowDirection);
+    uint3 albedo = uint3(round(saturate(state.firstHitAlbedo) * 1023.0));
+    bool hasNormal = any(state.firstHitNormal != 0.0);
+    payload.firstHitAlbedo = albedo.r | (albedo.g << 10) | (albedo.b << 20) | (hasNormal ? (1u << 30) : 0u);
+    payload.firstHitNormal = hasNormal ? EncodeOctahedral(state.firstHitNormal) : 0u;
+    return payload;
+}
+
+PathState UnpackPayload(RadiancePayload payload)
+{
+    PathState state;
+    state.radiance = payload.radiance;
+    state.nextDirection = DecodeOctahedral(payload.nextDirection);
+    state.nextOrigin = payload.nextOrigin;
+    state.rngState = payload.rngState;
+    state.throughput = float3(f16tof32(payload.throughputFlags.x), f16tof32(payload.throughputFlags.x >> 16),
+                              f16tof32(payload.throughputFlags.y));
+    uint flags = payload.throughputFlags.y >> 16;
+    state.terminated = (flags & 1u) != 0;
+    state.lastBounce = (flags & 2u) != 0;
+    state.iorStackTop = (flags >> 2) & 3u;
+    state.iorStack[0] = 1.0f;
+    state.iorStack[1] = 1.0f;
+    state.iorStack[2] = 1.0f;
+    state.iorStack[3] = 1.0f;
+    if (state.iorStackTop > 0) {
+        state.iorStack[1] = f16tof32(payload.iorStack.x);
+        state.iorStack[2] = f16tof32(payload.iorStack.x >> 16);
+        state.iorStack[3] = f16tof32(payload.iorStack.y);
+    }
+    state.coneWidth = payload.coneWidth;
+    state.coneSpread = payload.coneSpread;
+    state.bsdfPdf = payload.bsdfPdf;
+    state.shadowDistance = payload.shadowDistance;
+    state.shadowRadiance = payload.shadowRadiance;
+    state.shadowDirection = DecodeOctahedral(payload.shadowDirection);
+    state.firstHitAlbedo = float3(payload.firstHitAlbedo & 0x3FF, (payload.firstHitAlbedo >> 10) & 0x3FF,
+                                  (payload.firstHitAlbedo >> 20) & 0x3FF) / 1023.0;
+    state.firstHitNormal = (payload.firstHitAlbedo & (1u << 30)) != 0 ? DecodeOctahedral(payload.firstHitNormal)
+                                                                      : float3(0, 0, 0);
+    return state;
+}
+
+// Material classes, one specialized hit group each (order of the branches in ShadeSurface).
+// Must match Renderer::GetMaterialClass, which picks the hit group of each BLAS
+static const uint MATERIAL_CLASS_EMISSIVE = 0;
+static const uint MATERIAL_CLASS_TRANSMISSION = 1;
+static const uint MATERIAL_CLASS_MIRROR = 2;
+static const uint MATERIAL_CLASS_DIFFUSE = 3;
+
+uint GetMaterialClass(Material mat)
+{
+    if (dot(mat.emission.rgb, float3(1, 1, 1)) > 0.01) {
+        return MATERIAL_CLASS_EMISSIVE;
+    }
+    if ((mat.layerFlags & LAYER_TRANSMISSION) != 0) {
+        return MATERIAL_CLASS_TRANSMISSION;
+    }
+    if (mat.metallic > 0.9 && mat.roughness < 0.1) {
+        return MATERIAL_CLASS_MIRROR;
+    }
+    return MATERIAL_CLASS_DIFFUSE;
+}
+
+// Shading shared by the DXR shaders and the inline RayQuery path (defined after RayGen)
+void ShadeHit(inout PathState payload, SurfaceHit hit);
+void ShadeSurface(inout PathState payload, SurfaceHit hit, Material mat, uint materialClass);
+void ShadeMiss(inout PathState payload, float3 rayDir);
+
 // Global root signature
 // #define GlobalRootSignature \
 //     "DescriptorTable(UAV(u0))," /* Output texture */ \
@@ -24,41 +193,139 @@ struct RadiancePayload
 //     "SRV(t3)," /* Textures */ \
 //     "CBV(b0)"  /* Scene constants */
 
+// Ray cone spread after a diffuse bounce (radians); coarse on purpose, indirect lookups tolerate blur
+static const float DIFFUSE_CONE_SPREAD = 0.1f;
+
+static const float PI = 3.14159265359f;
+
 // Scene constants
 cbuffer SceneConstantBuffer : register(b0)
 {
     float4x4 cameraToWorld;
-    float4x4 projectionToCamera;
+    uint2 tileOffset;        // Full-image pixel of DispatchRaysIndex (0, 0), non-zero for bucket rendering
+    uint2 imageSize;         // Full image resolution (the dispatch may cover a single bucket)
     uint frameIndex;
     uint maxBounces;
     float environmentLightIntensity;
-    float _padding;
+    uint useVirtualTextures;  // 1 = base color comes from the virtual texture cache (t5/t6)
     // cameraParams: x = FOV (degrees), y = aspectRatio, z = aperture, w = focusDistance
     float4 cameraParams;
     // Sun (directional) parameters
     float4 sunDirIntensity; // xyz = direction (toward light), w = intensity
     float4 sunColorEnabled; // rgb = color, a = enabled (0 or 1)
+    uint samplesPerDispatch; // Samples traced per pixel by one DispatchRays, starting at frameIndex
+    // Adaptive sampling: a pixel stops once the relative standard error of its luminance
+    // drops below adaptiveThreshold after at least adaptiveMinSamples samples (threshold 0 = off)
+    float adaptiveThreshold;
+    uint adaptiveMinSamples;
+    // Next-event estimation over the emissive triangles in g_lights (lightCount 0 = off)
+    uint lightCount;
+    float lightTotalPower;   // Sum of luminance(emission) * area over the list
+    uint environmentSampling; // 1 = g_envConditionalCdf/g_envMarginalCdf are bound (EnvironmentCDF.hlsl)
+    uint russianRouletteDepth; // Bounces before Russian roulette may end a path (0 = off)
+    uint samplerType;        // SAMPLER_PCG or SAMPLER_SOBOL (g_samplerTables)
 }
 
-// Raytracing output
+// Raytracing output (rgb = radiance sum, a = sample count)
 RWTexture2D<float4> g_output : register(u0);
 
+// Adaptive sampling: per-pixel luminance moments (x = sum, y = sum of squares)
+// and the number of pixels still sampled by the current batch
+RWTexture2D<float2> g_luminanceMoments : register(u2);
+RWBuffer<uint> g_activePixelCount : register(u3);
+
+// Denoiser guide AOVs of the first hit, summed per sample like g_output (alpha unused)
+RWTexture2D<float4> g_aovAlbedo : register(u4);
+RWTexture2D<float4> g_aovNormal : register(u5);
+
 // Acceleration structure
 RaytracingAccelerationStructure g_scene : register(t0);
 
 // Geometry data
-StructuredBuffer<Vertex> g_vertices : register(t1);
+StructuredBuffer<float3> g_positions : register(t1);  // Object-space positions (also the BLAS vertex stream)
+StructuredBuffer<VertexAttributes> g_vertexAttributes : register(t15);  // Quantized normal + UV per vertex
 Buffer<uint> g_indices : register(t1, space1); // Typed buffer for indices
-Buffer<uint> g_triangleMaterialIndices : register(t1, space2); // Typed buffer for material indices
+Buffer<uint> g_triangleMaterialIndices : register(t1, space2); // Per-face material ids, multi-material meshes only
+Buffer<uint> g_instanceMaterials : register(t16);  // Per TLAS instance: material id, or per-face offset (flagged)
 StructuredBuffer<Material> g_materials : register(t2);  // Structured buffer for materials
-Texture2DArray<float4> g_textures : register(t3);  // Standard texture array (fallback)
 Texture2D<float4> g_environmentMap : register(t4);  // HDR environment map
 Texture2D<float4> g_virtualTextureCache : register(t5);  // Virtual Texture physical page cache
-Texture2DArray<uint> g_indirectionTexture : register(t6);  // Virtual Texture indirection lookup
+Buffer<uint> g_indirectionTexture : register(t6);  // Virtual Texture indirection lookup (one entry per tile, all levels)
+StructuredBuffer<VirtualTextureInfo> g_vtTextureInfo : register(t9);  // Virtual Texture per-texture layout
+RWBuffer<uint> g_vtFeedback : register(u1);  // Virtual Texture tile requests (1 = tile was sampled)
 StructuredBuffer<MaterialExtendedData> g_materialLayers : register(t7);  // Extended material layers
-StructuredBuffer<float2> g_textureScales : register(t8);  // UV scale factors for resampled textures
+StructuredBuffer<EmissiveLight> g_lights : register(t10);  // Emissive triangles + alias table
+StructuredBuffer<float> g_envConditionalCdf : register(t11);  // Per-row inclusive CDFs of the environment map
+StructuredBuffer<float> g_envMarginalCdf : register(t12);     // Inclusive CDF over rows, [height] = total weight
+StructuredBuffer<uint> g_alphaMaskBits : register(t13);       // 1-bit cutout masks, bit set = opaque texel
+StructuredBuffer<AlphaMask> g_alphaMasks : register(t14);     // Per-material mask location (width 0 = no mask)
+StructuredBuffer<uint> g_samplerTables : register(t17);       // Sobol generator matrices, then the blue-noise tile ranks
 SamplerState g_sampler : register(s0);
 
+// Sample generators (samplerType): white noise from the PCG hash, or an Owen-scrambled Sobol sequence shared
+// by all pixels and dithered per pixel with a blue-noise tile (Georgiev & Fajardo, "Blue-noise Dithered Sampling")
+#define SAMPLER_PCG   0
+#define SAMPLER_SOBOL 1
+static const uint SOBOL_DIMENSIONS = 4;                          // SamplingUtils::SOBOL_DIMENSIONS
+static const uint BLUE_NOISE_TABLE_OFFSET = SOBOL_DIMENSIONS * 32;
+static const uint BLUE_NOISE_SIZE = 64;                          // Tile size, BLUE_NOISE_TILE_SIZE in Renderer.cpp
+static const uint BLUE_NOISE_RANK_SHIFT = 20;                    // Rank in [0, 64 * 64) to 0.32 fixed point
+
+// Fixed dimensions of each bounce, so a decision always draws from the same stream whatever
+// the earlier bounces consumed. Consecutive groups of SOBOL_DIMENSIONS share one Sobol point
+static const uint DIM_CAMERA_JITTER = 0;     // 2D, bounce 0 only
+static const uint DIM_BSDF = 2;              // 2D: diffuse direction
+static const uint DIM_LOBE = 4;              // Fresnel reflection/refraction choice
+static const uint DIM_LIGHT_CHOICE = 5;      // Environment or emitter light sample
+static const uint DIM_LIGHT_SELECT = 6;      // 2D: emitter and alias test, or environment row and texel
+static const uint DIM_LIGHT_POINT = 8;       // 2D: point on the emitter or inside the environment texel
+static const uint DIM_TEXTURE = 10;          // Stochastic virtual texture level
+static const uint DIM_ROULETTE = 11;         // Russian roulette
+static const uint DIMENSIONS_PER_BOUNCE = 12;
+
+// Sampler state carried in rngState: the PCG hash state, or for Sobol the sample index in the upper
+// 24 bits and the bounce in the lower 8
+uint InitSamplerState(uint2 pixel, uint sampleIndex)
+{
+    if (samplerType == SAMPLER_SOBOL) {
+        return sampleIndex << 8;
+    }
+    return InitRNG(pixel, sampleIndex, sampleIndex * 17);
+}
+
+// Called by RayGen before each bounce (PCG simply keeps advancing)
+void SetSamplerBounce(inout uint state, uint bounce)
+{
+    if (samplerType == SAMPLER_SOBOL) {
+        state = (state & ~0xFFu) | min(bounce, 255u);
+    }
+}
+
+// Sample in [0, 1) of one dimension (DIM_*) of the current bounce
+float SampleDimension(inout uint state, uint dimension)
+{
+    if (samplerType != SAMPLER_SOBOL) {
+        return Random(state);
+    }
+    uint dim = (state & 0xFFu) * DIMENSIONS_PER_BOUNCE + dimension;
+    // Each group of dimensions walks the sequence in its own shuffled order, which decorrelates the groups
+    uint index = NestedUniformScramble(state >> 8, PCGHash(dim / SOBOL_DIMENSIONS + 0x9E3779B9u));
+    uint matrixOffset = (dim % SOBOL_DIMENSIONS) * 32;
+    uint value = 0;
+    for (uint bit = 0; index != 0; index >>= 1, ++bit) {
+        if (index & 1u) {
+            value ^= g_samplerTables[matrixOffset + bit];
+        }
+    }
+    value = NestedUniformScramble(value, PCGHash(dim * 0x68E31DA4u + 0x1B56C4E9u));
+    
+    // Toroidal shift by the pixel's blue-noise rank; the tile moves along the R2 sequence per dimension
+    uint2 tileOffset2D = uint2(frac(float2(0.7548777, 0.5698403) * float(dim)) * BLUE_NOISE_SIZE);
+    uint2 texel = (DispatchRaysIndex().xy + tileOffset + tileOffset2D) % BLUE_NOISE_SIZE;
+    value += g_samplerTables[BLUE_NOISE_TABLE_OFFSET + texel.y * BLUE_NOISE_SIZE + texel.x] << BLUE_NOISE_RANK_SHIFT;
+    return float(value >> 8) * (1.0 / 16777216.0);  // 24 bits: never rounds up to 1
+}
+
 // Convert ray direction to equirectangular UV coordinates
 float2 DirectionToEquirectangularUV(float3 dir)
 {
@@ -88,75 +355,394 @@ void CreateOrthonormalBasis(float3 normal, out float3 tangent, out float3 bitang
 }
 
 // Virtual Texture sampling helper
-// Returns texture color using indirection-based lookup for virtual textures
-float4 SampleVirtualTexture(int texIndex, float2 uv, float2 textureSize)
+// Returns texture color using indirection-based lookup for virtual textures.
+// Every lookup marks its tile in the feedback buffer; the CPU reads the requests back
+// after each batch and streams missing tiles into the physical cache.
+// lodBase: ray cone footprint term (log2), excluding the texture resolution
+// lodRand: uniform random number, dithers between the two nearest levels (stochastic trilinear)
+float4 SampleVirtualTexture(int texIndex, float2 uv, float lodBase, float lodRand)
 {
     // Virtual Texture system: 256x256 tile size
-    const float TILE_SIZE = 256.0;
+    const uint TILE_SIZE = 256;
+    
+    VirtualTextureInfo info = g_vtTextureInfo[texIndex];
     
-    // Calculate which virtual tile this UV falls into
-    float2 pixelCoords = uv * textureSize;
-    float2 tileCoords = pixelCoords / TILE_SIZE;
-    uint2 tileXY = uint2(floor(tileCoords));
+    // Ray cone LOD: log2 of texels covered per footprint side at level 0
+    float lod = lodBase + 0.5 * log2(float(info.width) * float(info.height));
+    uint desiredLevel = (uint)clamp(floor(lod + lodRand), 0.0, float(info.mipCount - 1));
     
-    // Lookup physical page index from indirection texture
-    uint physicalPageIndex = g_indirectionTexture.Load(int4(tileXY.x, tileXY.y, texIndex, 0));
+    // Physical page cache layout: pages arranged in a square grid
+    uint cacheWidth, cacheHeight;
+    g_virtualTextureCache.GetDimensions(cacheWidth, cacheHeight);
+    uint cacheTilesPerRow = cacheWidth / TILE_SIZE;
     
-    // Check if tile is resident (0xFFFFFFFF = not loaded)
-    if (physicalPageIndex == 0xFFFFFFFF)
+    // Tiles are stored level by level (finest first), same order as the feedback buffer
+    float2 wrappedUV = frac(uv); // wrap like the texture array sampler
+    uint levelOffset = 0;
+    bool requested = false;
+    for (uint level = 0; level < info.mipCount; ++level)
     {
-        // Tile not resident, return magenta for debugging
-        return float4(1.0, 0.0, 1.0, 1.0);
+        uint levelWidth = max(1u, info.width >> level);
+        uint levelHeight = max(1u, info.height >> level);
+        uint numTilesX = (levelWidth + TILE_SIZE - 1) / TILE_SIZE;
+        uint numTilesY = (levelHeight + TILE_SIZE - 1) / TILE_SIZE;
+        
+        if (level >= desiredLevel)
+        {
+            // Calculate which virtual tile this UV falls into
+            float2 pixelCoords = wrappedUV * float2(levelWidth, levelHeight);
+            uint2 tileXY = min(uint2(floor(pixelCoords / TILE_SIZE)), uint2(numTilesX - 1, numTilesY - 1));
+            uint tileIndex = info.feedbackOffset + levelOffset + tileXY.y * numTilesX + tileXY.x;
+            
+            // Request the tile at the desired level only (plain store: every writer stores the same value)
+            if (!requested)
+            {
+                g_vtFeedback[tileIndex] = 1;
+                requested = true;
+            }
+            
+            // Lookup physical page index (0xFFFFFFFF = not loaded, try the next coarser level)
+            uint physicalPageIndex = g_indirectionTexture[tileIndex];
+            if (physicalPageIndex != 0xFFFFFFFF)
+            {
+                // Clamp half a texel inside the page so bilinear filtering never reads a neighbouring page
+                float2 inTilePixels = clamp(pixelCoords - float2(tileXY * TILE_SIZE), 0.5, TILE_SIZE - 0.5);
+                uint pageX = physicalPageIndex % cacheTilesPerRow;
+                uint pageY = physicalPageIndex / cacheTilesPerRow;
+                
+                // Convert page coordinates to pixel coordinates, add in-tile offset, then normalize
+                float2 cachePixelCoords = float2(pageX, pageY) * TILE_SIZE + inTilePixels;
+                float2 cacheUV = cachePixelCoords / float2(cacheWidth, cacheHeight);
+                return g_virtualTextureCache.SampleLevel(g_sampler, cacheUV, 0);
+            }
+        }
+        levelOffset += numTilesX * numTilesY;
     }
     
-    // Calculate in-tile UV coordinates
-    float2 inTileUV = frac(tileCoords);
+    // No level is resident yet, use the texture's average color
+    return info.fallbackColor;
+}
+
+// Primary rays start with a zero cone width; every hit widens it by t * spread before the next ray
+bool IsPrimaryRay(PathState payload)
+{
+    return payload.coneWidth == 0.0f;
+}
+
+// First hit (or miss) of each sample records the denoiser guides in the path state; RayGen sums them over
+// the dispatch's samples, so the AOVs share g_output's sample count and are written once per dispatch
+void RecordFirstHitAOVs(inout PathState payload, bool primaryRay, float3 albedo, float3 normal)
+{
+    if (primaryRay) {
+        payload.firstHitAlbedo = saturate(albedo);
+        payload.firstHitNormal = normal;
+    }
+}
+
+float Luminance(float3 color)
+{
+    return dot(color, float3(0.2126, 0.7152, 0.0722));
+}
+
+// MIS weight of technique A against B (beta = 2, as Sampler::PowerHeuristic)
+float PowerHeuristic(float pdfA, float pdfB)
+{
+    float a = pdfA * pdfA;
+    float b = pdfB * pdfB;
+    return a / max(a + b, 1e-20);
+}
+
+// Solid-angle pdf of light sampling for a point on an emitter seen at distance t. The selection pmf is
+// luminance * area / total power and the point is uniform over the area, so the area cancels out
+float EmissiveLightPdf(float3 emission, float t, float cosLight)
+{
+    return Luminance(emission) * t * t / (lightTotalPower * max(cosLight, 1e-6));
+}
+
+// Probability that a light sample goes to the environment map instead of the emissive triangles
+float EnvironmentSelectProbability()
+{
+    if (environmentSampling == 0) {
+        return 0.0;
+    }
+    uint width, height;
+    g_environmentMap.GetDimensions(width, height);
+    if (g_envMarginalCdf[height] <= 0.0) {
+        return 0.0;  // Black map
+    }
+    return lightCount > 0 ? 0.5 : 1.0;
+}
+
+// Solid-angle pdf of importance sampling texel (x, y): the texel's CDF steps give its probability,
+// spread uniformly over the texel in uv (2 PI * PI steradians per unit uv area, scaled by sin(theta))
+float EnvironmentTexelPdf(uint x, uint y, uint width, uint height, float sinTheta)
+{
+    float marginal = g_envMarginalCdf[y] - (y > 0 ? g_envMarginalCdf[y - 1] : 0.0);
+    uint rowStart = y * width;
+    float conditional = g_envConditionalCdf[rowStart + x] - (x > 0 ? g_envConditionalCdf[rowStart + x - 1] : 0.0);
+    return marginal * conditional * float(width * height) / (2.0 * PI * PI * max(sinTheta, 1e-6));
+}
+
+float EnvironmentPdf(float3 dir)
+{
+    uint width, height;
+    g_environmentMap.GetDimensions(width, height);
+    float2 uv = DirectionToEquirectangularUV(dir);
+    uint x = min(uint(uv.x * width), width - 1);
+    uint y = min(uint(uv.y * height), height - 1);
+    return EnvironmentTexelPdf(x, y, width, height, sqrt(saturate(1.0 - dir.y * dir.y)));
+}
+
+// First index in [first, first + count) whose inclusive CDF value exceeds u
+uint SearchConditionalCdf(uint first, uint count, float u)
+{
+    uint lo = 0;
+    uint hi = count - 1;
+    while (lo < hi) {
+        uint mid = (lo + hi) / 2;
+        if (g_envConditionalCdf[first + mid] > u) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+uint SearchMarginalCdf(uint count, float u)
+{
+    uint lo = 0;
+    uint hi = count - 1;
+    while (lo < hi) {
+        uint mid = (lo + hi) / 2;
+        if (g_envMarginalCdf[mid] > u) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// Next-event estimation toward the environment map: a row from the marginal CDF, a texel from its
+// conditional CDF, a uniform point inside the texel. Mirrors PrepareLightSample; selectProbability is
+// EnvironmentSelectProbability()
+void PrepareEnvironmentSample(inout PathState payload, float3 normal, float3 geometricNormal, float selectProbability)
+{
+    uint width, height;
+    g_environmentMap.GetDimensions(width, height);
+    uint y = SearchMarginalCdf(height, SampleDimension(payload.rngState, DIM_LIGHT_SELECT));
+    uint x = SearchConditionalCdf(y * width, width, SampleDimension(payload.rngState, DIM_LIGHT_SELECT + 1));
+    float u = (float(x) + SampleDimension(payload.rngState, DIM_LIGHT_POINT)) / float(width);
+    float v = (float(y) + SampleDimension(payload.rngState, DIM_LIGHT_POINT + 1)) / float(height);
+    
+    // Inverse of DirectionToEquirectangularUV
+    float phi = v * PI;
+    float theta = (u - 0.5) * 2.0 * PI;
+    float sinPhi = sin(phi);
+    float3 dir = float3(sinPhi * cos(theta), cos(phi), sinPhi * sin(theta));
+    
+    float cosSurface = dot(normal, dir);
+    float envPdf = EnvironmentTexelPdf(x, y, width, height, sinPhi) * selectProbability;
+    if (cosSurface <= 0.0 || dot(geometricNormal, dir) <= 0.0 || envPdf <= 0.0) {
+        return;
+    }
+    
+    float3 envColor = g_environmentMap.SampleLevel(g_sampler, float2(u, v), 0).rgb * environmentLightIntensity;
+    float weight = payload.lastBounce ? 1.0 : PowerHeuristic(envPdf, cosSurface / PI);
+    payload.shadowRadiance = payload.throughput * envColor * (cosSurface / PI * weight / envPdf);
+    payload.shadowDirection = dir;
+    payload.shadowDistance = 10000.0;  // TMax of the camera and bounce rays: unoccluded means Miss
+}
+
+// Next-event estimation for a Lambertian lobe: pick an emitter with the alias table, a uniform point on it,
+// and leave the weighted contribution in the payload for RayGen's shadow ray from payload.nextOrigin.
+// payload.throughput already includes the albedo; the BRDF is albedo / PI.
+// selectProbability is the share of light samples that go to the emitters (the rest sample the environment)
+void PrepareLightSample(inout PathState payload, float3 normal, float3 geometricNormal, float selectProbability)
+{
+    uint index = min(uint(SampleDimension(payload.rngState, DIM_LIGHT_SELECT) * lightCount), lightCount - 1);
+    EmissiveLight light = g_lights[index];
+    if (SampleDimension(payload.rngState, DIM_LIGHT_SELECT + 1) >= light.probability) {
+        light = g_lights[light.alias];
+    }
     
-    // Physical page cache layout: tiles arranged in a grid
-    // Each page is 256x256, cache is arranged as sqrt(numPages) x sqrt(numPages)
-    // For 2304 pages: 48 x 48 grid (12288x12288 texture = 576MB)
-    const uint CACHE_TILES_PER_ROW = 48;  // sqrt(2304) = 48
-    uint pageX = physicalPageIndex % CACHE_TILES_PER_ROW;
-    uint pageY = physicalPageIndex / CACHE_TILES_PER_ROW;
+    // Uniform point on the triangle
+    float su = sqrt(SampleDimension(payload.rngState, DIM_LIGHT_POINT));
+    float r2 = SampleDimension(payload.rngState, DIM_LIGHT_POINT + 1);
+    float3 lightPos = light.p0 + light.edge1 * (su * (1.0 - r2)) + light.edge2 * (su * r2);
     
-    // Calculate final UV in physical cache texture
-    // Convert page coordinates to pixel coordinates, add in-tile offset, then normalize
-    float2 cachePixelCoords = float2(pageX, pageY) * TILE_SIZE + inTileUV * TILE_SIZE;
-    float2 cacheUV = cachePixelCoords / (CACHE_TILES_PER_ROW * TILE_SIZE);
+    float3 toLight = lightPos - payload.nextOrigin;
+    float distSq = dot(toLight, toLight);
+    float dist = sqrt(distSq);
+    float3 dir = toLight / max(dist, 1e-8);
+    float cosSurface = dot(normal, dir);
+    float cosLight = abs(dot(normalize(cross(light.edge1, light.edge2)), dir));  // Emitters are two-sided
+    if (cosSurface <= 0.0 || dot(geometricNormal, dir) <= 0.0 || cosLight <= 1e-6 || light.area <= 0.0) {
+        return;
+    }
     
-    // Sample from physical cache
-    return g_virtualTextureCache.SampleLevel(g_sampler, cacheUV, 0);
+    float lightPdf = light.pmf * distSq / (light.area * cosLight) * selectProbability;
+    float weight = payload.lastBounce ? 1.0 : PowerHeuristic(lightPdf, cosSurface / PI);
+    payload.shadowRadiance = payload.throughput * light.emission * (cosSurface / PI * weight / lightPdf);
+    payload.shadowDirection = dir;
+    payload.shadowDistance = dist * 0.999;  // Stop short of the emitter itself
+}
+
+// Convergence test from the accumulated moments: relative standard error of the mean luminance
+bool IsPixelConverged(uint2 pixel)
+{
+    float sampleCount = g_output[pixel].a;
+    if (adaptiveThreshold <= 0.0 || sampleCount < float(max(adaptiveMinSamples, 2u))) {
+        return false;
+    }
+    float2 moments = g_luminanceMoments[pixel];
+    float mean = moments.x / sampleCount;
+    float variance = max(0.0, moments.y / sampleCount - mean * mean) * sampleCount / (sampleCount - 1.0);
+    float standardError = sqrt(variance / sampleCount);
+    // The error is relative to the pixel's brightness, with a floor so black pixels converge too
+    return standardError <= adaptiveThreshold * max(mean, 0.01);
+}
+
+// Hit groups per BLAS slot in the shader table: radiance rays use record 0, shadow rays record 1
+static const uint HIT_GROUP_RADIANCE = 0;
+static const uint HIT_GROUP_SHADOW = 1;
+
+// g_instanceMaterials entries with this bit index g_triangleMaterialIndices (INSTANCE_MATERIAL_PER_FACE in Renderer.cpp)
+static const uint INSTANCE_MATERIAL_PER_FACE = 0x80000000u;
+
+// Material of a hit: single-material meshes resolve it from the instance alone, only meshes with
+// per-face materials take the extra dependent load
+uint GetMaterialIndex(uint instanceIndex, uint geometryPrimitiveIndex)
+{
+    uint entry = g_instanceMaterials[instanceIndex];
+    if ((entry & INSTANCE_MATERIAL_PER_FACE) != 0) {
+        return g_triangleMaterialIndices[(entry & ~INSTANCE_MATERIAL_PER_FACE) + geometryPrimitiveIndex];
+    }
+    return entry;
+}
+
+// Alpha cutout of a candidate hit: only meshes with a masked material are built without the opaque
+// flag, so this runs for hair cards and foliage alone. Nearest texel of the 1-bit mask, wrapped like g_sampler
+bool AlphaTestPasses(uint materialIndex, uint primitiveIndex, float2 hitBarycentrics)
+{
+    AlphaMask mask = g_alphaMasks[materialIndex];
+    if (mask.width == 0) {
+        return true;
+    }
+    float2 uv0 = DecodeTexCoord(g_vertexAttributes[g_indices[primitiveIndex * 3 + 0]].texCoord);
+    float2 uv1 = DecodeTexCoord(g_vertexAttributes[g_indices[primitiveIndex * 3 + 1]].texCoord);
+    float2 uv2 = DecodeTexCoord(g_vertexAttributes[g_indices[primitiveIndex * 3 + 2]].texCoord);
+    float2 uv = uv0 + hitBarycentrics.x * (uv1 - uv0) + hitBarycentrics.y * (uv2 - uv0);
+    uint2 size = uint2(mask.width, mask.height);
+    uint2 texel = min(uint2(frac(uv) * float2(size)), size - 1);
+    uint bit = texel.y * mask.width + texel.x;
+    return (g_alphaMaskBits[mask.offset + bit / 32] & (1u << (bit % 32))) != 0;
+}
+
+#if INLINE_RAY_QUERY
+// Inline traversal (DXR 1.1, selected at pipeline creation): the whole path stays in RayGen, no shader
+// table dispatch per bounce. Opaque geometry commits in hardware; the loop only sees alpha-tested candidates
+void TraceRadianceRay(RayDesc ray, inout PathState payload)
+{
+    RayQuery<RAY_FLAG_NONE> query;
+    query.TraceRayInline(g_scene, RAY_FLAG_NONE, 0xFF, ray);
+    while (query.Proceed()) {
+        if (AlphaTestPasses(GetMaterialIndex(query.CandidateInstanceIndex(), query.CandidatePrimitiveIndex()),
+                            query.CandidateInstanceID() + query.CandidatePrimitiveIndex(),
+                            query.CandidateTriangleBarycentrics())) {
+            query.CommitNonOpaqueTriangleHit();
+        }
+    }
+    if (query.CommittedStatus() == COMMITTED_TRIANGLE_HIT) {
+        SurfaceHit hit;
+        hit.primitiveIndex = query.CommittedInstanceID() + query.CommittedPrimitiveIndex();
+        hit.materialIndex = GetMaterialIndex(query.CommittedInstanceIndex(), query.CommittedPrimitiveIndex());
+        hit.barycentrics = query.CommittedTriangleBarycentrics();
+        hit.rayOrigin = query.WorldRayOrigin();
+        hit.rayDirection = query.WorldRayDirection();
+        hit.t = query.CommittedRayT();
+        hit.objectToWorld = (float3x3)query.CommittedObjectToWorld3x4();
+        hit.worldToObject = (float3x3)query.CommittedWorldToObject3x4();
+        ShadeHit(payload, hit);
+    } else {
+        ShadeMiss(payload, normalize(ray.Direction));
+    }
+}
+
+bool TraceShadowRay(RayDesc ray)
+{
+    RayQuery<RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH> query;
+    query.TraceRayInline(g_scene, RAY_FLAG_NONE, 0xFF, ray);
+    while (query.Proceed()) {
+        if (AlphaTestPasses(GetMaterialIndex(query.CandidateInstanceIndex(), query.CandidatePrimitiveIndex()),
+                            query.CandidateInstanceID() + query.CandidatePrimitiveIndex(),
+                            query.CandidateTriangleBarycentrics())) {
+            query.CommitNonOpaqueTriangleHit();
+        }
+    }
+    return query.CommittedStatus() == COMMITTED_NOTHING;
+}
+#else
+#if SHADER_EXECUTION_REORDERING
+// Shader Execution Reordering (SM 6.9, selected at pipeline creation): after traversal, threads are regrouped
+// by ShadeHit's branch and material before the closest-hit shader runs, so a wave shades one material
+// instead of diverging across glass, mirror and textured diffuse after the first bounce.
+// Hint = 2-bit material class above the low bits of the material index
+static const uint COHERENCE_HINT_BITS = 16;
+
+uint CoherenceHint(dx::HitObject hitObject)
+{
+    if (!hitObject.IsHit()) {
+        return MATERIAL_CLASS_EMISSIVE << (COHERENCE_HINT_BITS - 2);  // Misses share a bucket with emitters: both end the path
+    }
+    uint materialIndex = GetMaterialIndex(hitObject.GetInstanceIndex(), hitObject.GetPrimitiveIndex());
+    uint branch = GetMaterialClass(g_materials[materialIndex]);
+    uint materialBits = COHERENCE_HINT_BITS - 2;
+    return (branch << materialBits) | (materialIndex & ((1u << materialBits) - 1));
+}
+
+void TraceRadianceRay(RayDesc ray, inout PathState payload)
+{
+    RadiancePayload packed = PackPayload(payload);
+    dx::HitObject hitObject = dx::HitObject::TraceRay(g_scene, RAY_FLAG_NONE, 0xFF, HIT_GROUP_RADIANCE, 0, 0, ray, packed);
+    dx::MaybeReorderThread(hitObject, CoherenceHint(hitObject), COHERENCE_HINT_BITS);
+    dx::HitObject::Invoke(hitObject, packed);
+    payload = UnpackPayload(packed);
 }
+#else
+void TraceRadianceRay(RayDesc ray, inout PathState payload)
+{
+    RadiancePayload packed = PackPayload(payload);
+    TraceRay(g_scene, RAY_FLAG_NONE, 0xFF, HIT_GROUP_RADIANCE, 0, 0, ray, packed);
+    payload = UnpackPayload(packed);
+}
+#endif
+
+// Any-hit visibility test through the shadow miss shader (miss index 1)
+bool TraceShadowRay(RayDesc ray)
+{
+    ShadowPayload shadowPayload;
+    shadowPayload.visible = false;
+    TraceRay(g_scene, RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH | RAY_FLAG_SKIP_CLOSEST_HIT_SHADER,
+             0xFF, HIT_GROUP_SHADOW, 0, 1, ray, shadowPayload);
+    return shadowPayload.visible;
+}
+#endif
 
 [shader("raygeneration")]
 void RayGen()
 {
-    uint2 dispatchIdx = DispatchRaysIndex().xy;
-    uint2 renderTargetSize = DispatchRaysDimensions().xy;
+    uint2 dispatchIdx = DispatchRaysIndex().xy;     // Pixel in the accumulation texture
+    uint2 pixelIdx = tileOffset + dispatchIdx;      // Pixel in the full image (camera rays, RNG seed)
+    uint2 renderTargetSize = imageSize;
 
-    // Initialize RNG for this pixel with per-sample variation
-    // CRITICAL: Each sample must have different seed to generate different random sequences
-    uint rngState = InitRNG(dispatchIdx, frameIndex, frameIndex * 17);
-    
-    // Subpixel jitter for anti-aliasing: sample uniformly inside pixel
-    // Use per-pixel RNG to produce two independent jitter offsets in [0,1)
-    // This implements industry-standard random subpixel sampling for AA.
-    float jitterX = Random(rngState);
-    float jitterY = Random(rngState);
-    float2 pixelCenter = (float2)dispatchIdx + float2(jitterX, jitterY);
-    float2 uv = pixelCenter / (float2)renderTargetSize; // [0,1]
-    
     // Simple pinhole camera model
     // FOV is provided by CPU via cameraParams.x (degrees). Use cameraParams.y for aspect ratio.
     float aspectRatio = cameraParams.y;
     float fov = cameraParams.x * 3.14159265 / 180.0; // convert degrees -> radians
     float tanHalfFov = tan(fov * 0.5);
     
-    // NDC coordinates ([-1,1] range)
-    float2 ndc = uv * 2.0 - 1.0;
-    ndc.x *= aspectRatio * tanHalfFov;
-    ndc.y *= -tanHalfFov; // Flip Y
-    
     // Get camera basis from cameraToWorld matrix (ROW-MAJOR in HLSL)
     // Matrix is transposed on CPU, so in HLSL:
     // Row 0 = Right axis, Row 1 = Up axis, Row 2 = -Forward axis, Row 3 = Position
@@ -165,68 +751,172 @@ void RayGen()
     float3 cameraForward = -cameraToWorld[2].xyz;  // Third row, camera looks along -Z
     float3 origin = cameraToWorld[3].xyz;          // Fourth row - position
     
-    // Build ray direction: forward + horizontal offset + vertical offset
-    float3 direction = normalize(cameraForward + ndc.x * cameraRight + ndc.y * cameraUp);
-
-    // Path tracing with multiple bounces
-    float3 radiance = float3(0, 0, 0);
-    float3 throughput = float3(1, 1, 1);
-    
-    RayDesc ray;
-    ray.Origin = origin;
-    ray.Direction = normalize(direction);
-    ray.TMin = 0.001f;
-    ray.TMax = 10000.0f;
+    // Converged pixels skip the whole dispatch; the CPU ends the bucket once no pixel is left
+    if (IsPixelConverged(dispatchIdx)) {
+        return;
+    }
+    // One atomic per wave instead of per pixel
+    uint activeLanes = WaveActiveCountBits(true);
+    if (WaveIsFirstLane()) {
+        InterlockedAdd(g_activePixelCount[0], activeLanes);
+    }
     
-    // Initialize payload for path tracing
-    RadiancePayload payload;
-    payload.radiance = float3(0, 0, 0);
-    payload.throughput = throughput;
-    payload.nextOrigin = float3(0, 0, 0);
-    payload.nextDirection = float3(0, 0, 0);
-    payload.rngState = rngState;
-    payload.terminated = false;
-    // Initialize medium stack (start in air)
-    payload.iorStack[0] = 1.0f;
-    payload.iorStackTop = 0;
-    
-    // Iterative path tracing (multiple bounces)
-    for (uint bounce = 0; bounce < maxBounces && !payload.terminated; bounce++) {
-        // Trace ray
-        TraceRay(g_scene, RAY_FLAG_NONE, 0xFF, 0, 0, 0, ray, payload);
+    // Samples of this dispatch are summed in registers, the output and AOV UAVs are touched once
+    float3 radianceSum = float3(0, 0, 0);
+    float2 momentsSum = float2(0, 0);
+    float3 albedoSum = float3(0, 0, 0);
+    float3 normalSum = float3(0, 0, 0);
+    for (uint sampleOffset = 0; sampleOffset < samplesPerDispatch; ++sampleOffset) {
+        uint sampleIndex = frameIndex + sampleOffset;
         
-        // If path terminated, we're done
-        if (payload.terminated) {
-            break;
-        }
+        // Initialize RNG for this pixel with per-sample variation
+        // CRITICAL: Each sample must have different seed to generate different random sequences
+        uint rngState = InitSamplerState(pixelIdx, sampleIndex);
         
-        // Prepare next ray
-        ray.Origin = payload.nextOrigin;
-        ray.Direction = payload.nextDirection;
+        // Subpixel jitter for anti-aliasing: sample uniformly inside pixel
+        // Use per-pixel RNG to produce two independent jitter offsets in [0,1)
+        // This implements industry-standard random subpixel sampling for AA.
+        float jitterX = SampleDimension(rngState, DIM_CAMERA_JITTER);
+        float jitterY = SampleDimension(rngState, DIM_CAMERA_JITTER + 1);
+        float2 pixelCenter = (float2)pixelIdx + float2(jitterX, jitterY);
+        float2 uv = pixelCenter / (float2)renderTargetSize; // [0,1]
+        
+        // NDC coordinates ([-1,1] range)
+        float2 ndc = uv * 2.0 - 1.0;
+        ndc.x *= aspectRatio * tanHalfFov;
+        ndc.y *= -tanHalfFov; // Flip Y
+        
+        // Build ray direction: forward + horizontal offset + vertical offset
+        float3 direction = normalize(cameraForward + ndc.x * cameraRight + ndc.y * cameraUp);
+        
+        RayDesc ray;
+        ray.Origin = origin;
+        ray.Direction = normalize(direction);
         ray.TMin = 0.001f;
         ray.TMax = 10000.0f;
+        
+        // Initialize payload for path tracing
+        PathState payload;
+        payload.radiance = float3(0, 0, 0);
+        payload.throughput = float3(1, 1, 1);
+        payload.nextOrigin = float3(0, 0, 0);
+        payload.nextDirection = float3(0, 0, 0);
+        payload.rngState = rngState;
+        payload.terminated = false;
+        // Initialize medium stack (start in air)
+        payload.iorStack[0] = 1.0f;
+        payload.iorStackTop = 0;
+        // Primary ray cone: one pixel's angular footprint
+        payload.coneWidth = 0.0f;
+        payload.coneSpread = atan(2.0 * tanHalfFov / float(renderTargetSize.y));
+        payload.shadowDirection = float3(0, 0, 0);
+        payload.shadowDistance = 0.0f;
+        payload.shadowRadiance = float3(0, 0, 0);
+        payload.bsdfPdf = 0.0f;  // Emitters seen directly are not light sampled
+        payload.lastBounce = false;
+        payload.firstHitAlbedo = float3(0, 0, 0);
+        payload.firstHitNormal = float3(0, 0, 0);
+        
+        // Iterative path tracing (multiple bounces)
+        for (uint bounce = 0; bounce < maxBounces && !payload.terminated; bounce++) {
+            // Trace ray
+            payload.lastBounce = bounce + 1 == maxBounces;
+            SetSamplerBounce(payload.rngState, bounce);
+            TraceRadianceRay(ray, payload);
+            if (bounce == 0) {
+                albedoSum += payload.firstHitAlbedo;
+                normalSum += payload.firstHitNormal;
+            }
+            
+            // Light sample of the hit
+            if (payload.shadowDistance > 0.0) {
+                RayDesc shadowRay;
+                shadowRay.Origin = payload.nextOrigin;
+                shadowRay.Direction = payload.shadowDirection;
+                shadowRay.TMin = 0.001f;
+                shadowRay.TMax = payload.shadowDistance;
+                if (TraceShadowRay(shadowRay)) {
+                    payload.radiance += payload.shadowRadiance;
+                }
+                payload.shadowDistance = 0.0f;
+            }
+            
+            // If path terminated, we're done
+            if (payload.terminated) {
+                break;
+            }
+            
+            // Russian roulette: survive with the throughput's largest component (capped so bright
+            // glass paths still end eventually) and compensate the survivors, which keeps the estimate unbiased
+            if (russianRouletteDepth > 0 && bounce + 1 >= russianRouletteDepth) {
+                float survival = min(max(max(payload.throughput.r, payload.throughput.g), payload.throughput.b), 0.95);
+                if (SampleDimension(payload.rngState, DIM_ROULETTE) >= survival) {
+                    break;
+                }
+                payload.throughput /= survival;
+            }
+            
+            // Prepare next ray
+            ray.Origin = payload.nextOrigin;
+            ray.Direction = payload.nextDirection;
+            ray.TMin = 0.001f;
+            ray.TMax = 10000.0f;
+        }
+        
+        // Final radiance is accumulated in payload
+        radianceSum += payload.radiance;
+        float sampleLuminance = dot(payload.radiance, float3(0.2126, 0.7152, 0.0722));
+        momentsSum += float2(sampleLuminance, sampleLuminance * sampleLuminance);
     }
-    
-    // Final radiance is accumulated in payload
-    radiance = payload.radiance;
 
-    // Simple additive accumulation - each sample adds its contribution
+    // Simple additive accumulation - each dispatch adds the sum of its samples (alpha counts them)
     // The final division by sample count happens on CPU during readback
     // This avoids read-modify-write race conditions in the shader
-    g_output[dispatchIdx] += float4(radiance, 1.0);
+    g_output[dispatchIdx] += float4(radianceSum, float(samplesPerDispatch));
+    g_luminanceMoments[dispatchIdx] += momentsSum;
+    g_aovAlbedo[dispatchIdx] += float4(albedoSum, 0.0);
+    g_aovNormal[dispatchIdx] += float4(normalSum, 0.0);
 }
 
 [shader("miss")]
 void Miss(inout RadiancePayload payload)
 {
-    float3 rayDir = normalize(WorldRayDirection());
-    
-    // Sample environment map using equirectangular mapping
+    PathState state = UnpackPayload(payload);
+    ShadeMiss(state, normalize(WorldRayDirection()));
+    payload = PackPayload(state);
+}
+
+void ShadeMiss(inout PathState payload, float3 rayDir)
+{
+    // After a diffuse bounce the environment could also have been light sampled, so the BSDF ray
+    // only gets its MIS share
+    float envWeight = 1.0;
+    bool lightSampled = false;
+    if (payload.bsdfPdf > 0.0) {
+        float selectProbability = EnvironmentSelectProbability();
+        if (selectProbability > 0.0) {
+            envWeight = PowerHeuristic(payload.bsdfPdf, selectProbability * EnvironmentPdf(rayDir));
+            lightSampled = true;
+        }
+    }
+
+    // Sample environment map using equirectangular mapping. Ray cone LOD: the cone's angular spread
+    // over the angle of one texel at the equator, so primary rays stay on level 0. When MIS combines
+    // this ray with light samples, both must see level 0, the level the sampling CDF is built from
     float2 envUV = DirectionToEquirectangularUV(rayDir);
-    float4 envColor = g_environmentMap.SampleLevel(g_sampler, envUV, 0);
+    float envLod = 0.0;
+    if (!lightSampled) {
+        uint envWidth, envHeight, envMipCount;
+        g_environmentMap.GetDimensions(0, envWidth, envHeight, envMipCount);
+        envLod = max(log2(max(payload.coneSpread * float(envWidth) / (2.0 * PI), 1e-8)), 0.0);
+    }
+    float4 envColor = g_environmentMap.SampleLevel(g_sampler, envUV, envLod);
     
     // Apply environment light intensity and add to radiance
-    payload.radiance += payload.throughput * envColor.rgb * environmentLightIntensity;
+    payload.radiance += payload.throughput * envColor.rgb * environmentLightIntensity * envWeight;
+    
+    // Background seen directly: its color is the albedo guide, no normal
+    RecordFirstHitAOVs(payload, IsPrimaryRay(payload), envColor.rgb * environmentLightIntensity, float3(0, 0, 0));
 
     // Add directional sun contribution for rays that reach infinity.
     // We evaluate sun radiance along the ray direction; if the ray direction
@@ -248,18 +938,108 @@ void Miss(inout RadiancePayload payload)
     payload.terminated = true;
 }
 
+[shader("miss")]
+void ShadowMiss(inout ShadowPayload payload)
+{
+    payload.visible = true;
+}
+
+// Any-hit cutout of the alpha-tested hit groups (opaque meshes have no any-hit and skip it in traversal)
+[shader("anyhit")]
+void AnyHitAlphaTest(inout RadiancePayload payload, in BuiltInTriangleIntersectionAttributes attribs)
+{
+    if (!AlphaTestPasses(GetMaterialIndex(InstanceIndex(), PrimitiveIndex()), InstanceID() + PrimitiveIndex(), attribs.barycentrics)) {
+        IgnoreHit();
+    }
+}
+
+[shader("anyhit")]
+void ShadowAnyHitAlphaTest(inout ShadowPayload payload, in BuiltInTriangleIntersectionAttributes attribs)
+{
+    if (!AlphaTestPasses(GetMaterialIndex(InstanceIndex(), PrimitiveIndex()), InstanceID() + PrimitiveIndex(), attribs.barycentrics)) {
+        IgnoreHit();
+    }
+}
+
+SurfaceHit GetSurfaceHit(BuiltInTriangleIntersectionAttributes attribs)
+{
+    // Each instance's BLAS covers one mesh; InstanceID() holds that mesh's first triangle
+    // in the unified index buffer
+    SurfaceHit hit;
+    hit.primitiveIndex = InstanceID() + PrimitiveIndex();
+    hit.materialIndex = GetMaterialIndex(InstanceIndex(), PrimitiveIndex());
+    hit.barycentrics = attribs.barycentrics;
+    hit.rayOrigin = WorldRayOrigin();
+    hit.rayDirection = WorldRayDirection();
+    hit.t = RayTCurrent();
+    hit.objectToWorld = (float3x3)ObjectToWorld3x4();
+    hit.worldToObject = (float3x3)WorldToObject3x4();
+    return hit;
+}
+
+// Uber shader (hit group "HitGroup"): meshes whose triangles use several materials
 [shader("closesthit")]
 void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAttributes attribs)
 {
-    // Get primitive and material
-    uint primitiveIndex = PrimitiveIndex();
-    uint materialIndex = g_triangleMaterialIndices[primitiveIndex];
-    Material mat = g_materials[materialIndex];
+    PathState state = UnpackPayload(payload);
+    ShadeHit(state, GetSurfaceHit(attribs));
+    payload = PackPayload(state);
+}
+
+// Specialized hit groups: the BLAS has a single material, passed in the hit group record
+// (local root constants), and the class is a literal so only its branch of ShadeSurface is compiled
+cbuffer LocalMaterial : register(b1)
+{
+    Material g_localMaterial;
+};
+
+[shader("closesthit")]
+void ClosestHitEmissive(inout RadiancePayload payload, in BuiltInTriangleIntersectionAttributes attribs)
+{
+    PathState state = UnpackPayload(payload);
+    ShadeSurface(state, GetSurfaceHit(attribs), g_localMaterial, MATERIAL_CLASS_EMISSIVE);
+    payload = PackPayload(state);
+}
+
+[shader("closesthit")]
+void ClosestHitTransmission(inout RadiancePayload payload, in BuiltInTriangleIntersectionAttributes attribs)
+{
+    PathState state = UnpackPayload(payload);
+    ShadeSurface(state, GetSurfaceHit(attribs), g_localMaterial, MATERIAL_CLASS_TRANSMISSION);
+    payload = PackPayload(state);
+}
+
+[shader("closesthit")]
+void ClosestHitMirror(inout RadiancePayload payload, in BuiltInTriangleIntersectionAttributes attribs)
+{
+    PathState state = UnpackPayload(payload);
+    ShadeSurface(state, GetSurfaceHit(attribs), g_localMaterial, MATERIAL_CLASS_MIRROR);
+    payload = PackPayload(state);
+}
+
+[shader("closesthit")]
+void ClosestHitDiffuse(inout RadiancePayload payload, in BuiltInTriangleIntersectionAttributes attribs)
+{
+    PathState state = UnpackPayload(payload);
+    ShadeSurface(state, GetSurfaceHit(attribs), g_localMaterial, MATERIAL_CLASS_DIFFUSE);
+    payload = PackPayload(state);
+}
+
+void ShadeHit(inout PathState payload, SurfaceHit hit)
+{
+    // Per-triangle material, class chosen at run time
+    Material mat = g_materials[hit.materialIndex];
+    ShadeSurface(payload, hit, mat, GetMaterialClass(mat));
+}
+
+void ShadeSurface(inout PathState payload, SurfaceHit hit, Material mat, uint materialClass)
+{
+    uint primitiveIndex = hit.primitiveIndex;
     
     // Compute hit point
-    float3 rayOrigin = WorldRayOrigin();
-    float3 rayDir = WorldRayDirection();
-    float t = RayTCurrent();
+    float3 rayOrigin = hit.rayOrigin;
+    float3 rayDir = hit.rayDirection;
+    float t = hit.t;
     float3 hitPos = rayOrigin + t * rayDir;
     
     // Fetch vertex positions and normals
@@ -267,32 +1047,46 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
     uint i1 = g_indices[primitiveIndex * 3 + 1];
     uint i2 = g_indices[primitiveIndex * 3 + 2];
     
-    float3 v0 = g_vertices[i0].position;
-    float3 v1 = g_vertices[i1].position;
-    float3 v2 = g_vertices[i2].position;
+    float3 v0 = g_positions[i0];
+    float3 v1 = g_positions[i1];
+    float3 v2 = g_positions[i2];
+    
+    VertexAttributes a0 = g_vertexAttributes[i0];
+    VertexAttributes a1 = g_vertexAttributes[i1];
+    VertexAttributes a2 = g_vertexAttributes[i2];
     
-    float3 n0 = g_vertices[i0].normal;
-    float3 n1 = g_vertices[i1].normal;
-    float3 n2 = g_vertices[i2].normal;
+    float3 n0 = DecodeOctahedral(a0.normal);
+    float3 n1 = DecodeOctahedral(a1.normal);
+    float3 n2 = DecodeOctahedral(a2.normal);
     
-    float2 uv0 = g_vertices[i0].texCoord;
-    float2 uv1 = g_vertices[i1].texCoord;
-    float2 uv2 = g_vertices[i2].texCoord;
+    float2 uv0 = DecodeTexCoord(a0.texCoord);
+    float2 uv1 = DecodeTexCoord(a1.texCoord);
+    float2 uv2 = DecodeTexCoord(a2.texCoord);
     
-    float3 barycentrics = float3(1.0 - attribs.barycentrics.x - attribs.barycentrics.y, 
-                                  attribs.barycentrics.x, 
-                                  attribs.barycentrics.y);
+    float3 barycentrics = float3(1.0 - hit.barycentrics.x - hit.barycentrics.y, 
+                                  hit.barycentrics.x, 
+                                  hit.barycentrics.y);
     
     // Interpolate texture coordinates
     float2 texCoord = uv0 * barycentrics.x + uv1 * barycentrics.y + uv2 * barycentrics.z;
     
+    // Propagate the ray cone to the hit point; the next ray starts with this width
+    bool primaryHit = IsPrimaryRay(payload);
+    float coneWidthAtHit = payload.coneWidth + t * payload.coneSpread;
+    payload.coneWidth = coneWidthAtHit;
+    
     // Calculate true geometric normal from triangle edges
     float3 edge1 = v1 - v0;
     float3 edge2 = v2 - v0;
-    float3 faceNormal = normalize(cross(edge1, edge2));
+    float3 faceNormal = cross(edge1, edge2);
     
     // Interpolated shading normal
-    float3 interpolatedNormal = normalize(n0 * barycentrics.x + n1 * barycentrics.y + n2 * barycentrics.z);
+    float3 interpolatedNormal = n0 * barycentrics.x + n1 * barycentrics.y + n2 * barycentrics.z;
+    
+    // Object space -> world space (inverse transpose handles non-uniform instance scale)
+    float3x3 worldToObject = hit.worldToObject;
+    faceNormal = normalize(mul(faceNormal, worldToObject));
+    interpolatedNormal = normalize(mul(interpolatedNormal, worldToObject));
     
     // Ensure face normal points away from the ray (outward from the surface)
     if (dot(faceNormal, rayDir) > 0.0) {
@@ -309,12 +1103,29 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
     }
     normal = normalize(normal);
     
-    // Add emission from this surface
-    payload.radiance += payload.throughput * mat.emission.rgb;
+    // Texture LOD from the ray cone footprint: 0.5*log2(uv area / world area) + log2(width / |cos|)
+    // The texture resolution term is added per texture in SampleVirtualTexture
+    float3x3 objectToWorld = hit.objectToWorld;
+    float worldArea = length(cross(mul(objectToWorld, edge1), mul(objectToWorld, edge2)));
+    float2 duv1 = uv1 - uv0;
+    float2 duv2 = uv2 - uv0;
+    float uvArea = abs(duv1.x * duv2.y - duv2.x * duv1.y);
+    float lodBase = 0.5 * log2(max(uvArea, 1e-12) / max(worldArea, 1e-12)) +
+                    log2(max(coneWidthAtHit, 1e-8) / max(abs(dot(faceNormal, rayDir)), 0.05));
+    
+    // Add emission from this surface. Emitters in the light list were also reachable by the previous
+    // diffuse hit's light sample, so a BSDF-sampled hit only gets its MIS share
+    float emissionWeight = 1.0;
+    if (materialClass == MATERIAL_CLASS_EMISSIVE && lightCount > 0 && payload.bsdfPdf > 0.0) {
+        float lightPdf = EmissiveLightPdf(mat.emission.rgb, t, abs(dot(faceNormal, rayDir))) *
+                         (1.0 - EnvironmentSelectProbability());
+        emissionWeight = PowerHeuristic(payload.bsdfPdf, lightPdf);
+    }
+    payload.radiance += payload.throughput * mat.emission.rgb * emissionWeight;
     
     // If this is an emissive surface, terminate the path
-    float emissionMagnitude = dot(mat.emission.rgb, float3(1, 1, 1));
-    if (emissionMagnitude > 0.01) {
+    if (materialClass == MATERIAL_CLASS_EMISSIVE) {
+        RecordFirstHitAOVs(payload, primaryHit, mat.emission.rgb, normal);
         payload.terminated = true;
         return;
     }
@@ -326,10 +1137,11 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
     // ========== MATERIAL TYPE CLASSIFICATION ==========
     // New PBR material system: use layer flags and properties
     // Check for transmission layer (glass/transparent materials)
-    bool hasTransmission = (mat.layerFlags & LAYER_TRANSMISSION) != 0;
-    
     // Handle refractive/transmissive materials
-    if (hasTransmission) {
+    if (materialClass == MATERIAL_CLASS_TRANSMISSION) {
+        // Specular surfaces use their tint as the guide (OIDN treats it like a constant albedo)
+        RecordFirstHitAOVs(payload, primaryHit, mat.baseColor, normal);
+        
         // Glass material with reflection and refraction
         float ior = mat.ior;
         float3 N = normal;
@@ -356,7 +1168,7 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         float fresnel = F0 + (1.0 - F0) * pow(1.0 - cosI, 5.0);
         
         // Russian roulette between reflection and refraction
-        float rand = Random(payload.rngState);
+        float rand = SampleDimension(payload.rngState, DIM_LOBE);
 
         // Use opacity for transmission: opacity=1 is opaque, opacity=0 is fully transmissive
         // For transmission, we want the inverse: trans = 1 - opacity
@@ -370,6 +1182,7 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         // Compute small offset to avoid self-intersections
         float eps = 0.001f;
         float3 offset = geometricNormal * eps;
+        payload.bsdfPdf = 0.0f;  // Delta lobes: an emitter hit next takes its full emission
 
         if (rand < fresnel || k < 0.0) {
             // Total internal reflection or Fresnel reflection
@@ -413,9 +1226,10 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         return;
     }
     // Handle mirror/reflective materials (high metallic, low roughness)
-    else if (mat.metallic > 0.9 && mat.roughness < 0.1) {
+    else if (materialClass == MATERIAL_CLASS_MIRROR) {
         // Perfect mirror reflection
         float3 reflectDir = reflect(rayDir, normal);
+        RecordFirstHitAOVs(payload, primaryHit, mat.baseColor, normal);
         
         // Use base color as reflectance for metallic surfaces
         float3 reflectance = mat.baseColor;
@@ -424,6 +1238,7 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         payload.throughput *= reflectance;
         payload.nextOrigin = hitPos + geometricNormal * 0.001;
         payload.nextDirection = reflectDir;
+        payload.bsdfPdf = 0.0f;
         return;
     }
     // Handle standard diffuse materials (illum 0, 1, 2, default)
@@ -437,9 +1252,21 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         // Sample texture if available (texture overrides base albedo)
         if (mat.baseColorTexIdx >= 0) {
             int texIndex = mat.baseColorTexIdx;
-            float4 texColor = g_textures.SampleLevel(g_sampler, float3(texCoord, texIndex), 0);
+            // Branch instead of ?: so the feedback write only happens in virtual texture mode
+            float4 texColor;
+            if (useVirtualTextures != 0) {
+                texColor = SampleVirtualTexture(texIndex, texCoord, lodBase, SampleDimension(payload.rngState, DIM_TEXTURE));
+            } else {
+                // Bindless: the material holds the absolute heap index of the texture's SRV
+                Texture2D<float4> texture = ResourceDescriptorHeap[NonUniformResourceIndex(texIndex)];
+                uint width, height, mipCount;
+                texture.GetDimensions(0, width, height, mipCount);
+                float lod = lodBase + 0.5 * log2(float(width) * float(height));
+                texColor = texture.SampleLevel(g_sampler, texCoord, lod);
+            }
             albedo = texColor.rgb;
         }
+        RecordFirstHitAOVs(payload, primaryHit, albedo, normal);
         
         // For path tracing with cosine-weighted sampling:
         // BRDF = albedo / PI
@@ -447,9 +1274,9 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         // Combined factor: (albedo / PI) * cosTheta / (cosTheta / PI) = albedo
         payload.throughput *= albedo;
         
-        // Russian roulette path termination
+        // Without Russian roulette (RayGen), end paths whose throughput is negligible
         float maxThroughput = max(max(payload.throughput.r, payload.throughput.g), payload.throughput.b);
-        if (maxThroughput < 0.001) {
+        if (russianRouletteDepth == 0 && maxThroughput < 0.001) {
             payload.terminated = true;
             return;
         }
@@ -458,8 +1285,8 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         float3 tangent, bitangent;
         CreateOrthonormalBasis(normal, tangent, bitangent);
         
-        float r1 = Random(payload.rngState);
-        float r2 = Random(payload.rngState);
+        float r1 = SampleDimension(payload.rngState, DIM_BSDF);
+        float r2 = SampleDimension(payload.rngState, DIM_BSDF + 1);
         
         float sinTheta = sqrt(r1);
         float cosTheta = sqrt(1.0 - r1);
@@ -470,6 +1297,17 @@ void ClosestHit(inout RadiancePayload payload, in BuiltInTriangleIntersectionAtt
         
         payload.nextOrigin = hitPos + geometricNormal * 0.001;
         payload.nextDirection = worldDir;
+        payload.bsdfPdf = cosTheta / PI;
+        // Diffuse bounces blur the footprint: widen the cone (glass/mirror keep their spread)
+        payload.coneSpread = max(payload.coneSpread, DIFFUSE_CONE_SPREAD);
+        
+        // Direct light from the environment or the emissive triangles, traced by RayGen
+        float envProbability = EnvironmentSelectProbability();
+        if (envProbability > 0.0 && SampleDimension(payload.rngState, DIM_LIGHT_CHOICE) < envProbability) {
+            PrepareEnvironmentSample(payload, normal, geometricNormal, envProbability);
+        } else if (lightCount > 0) {
+            PrepareLightSample(payload, normal, geometricNormal, 1.0 - envProbability);
+        }
         return;
     }
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+// Resolve pass: accumulated radiance -> compact output image
+// The accumulation alpha holds each pixel's own sample count (adaptive sampling), so pixels are
+// averaged individually. HDR output (RGBA16F, denoiser input) stays linear; display output
+// (RGBA8) is exposed and tone mapped. Must match ApplyToneMapping in Renderer.cpp.
+// With resolveAOVs the first-hit albedo/normal sums are averaged into the denoiser guide images.
+
+RWTexture2D<float4> g_accumulation : register(u0);
+RWTexture2D<float4> g_resolved : register(u1);  // Format comes from the bound UAV
+RWTexture2D<float4> g_aovAlbedo : register(u2);
+RWTexture2D<float4> g_aovNormal : register(u3);
+RWTexture2D<float4> g_resolvedAlbedo : register(u4);
+RWTexture2D<float4> g_resolvedNormal : register(u5);
+
+cbuffer ResolveConstants : register(b0)
+{
+    uint2 outputSize;
+    float exposure;        // Linear multiplier (2^EV)
+    uint toneMapOperator;  // 0 = clamp, 1 = Reinhard, 2 = ACES (Narkowicz fit)
+    uint hdrOutput;        // 1 = write the linear average
+    uint resolveAOVs;      // 1 = also write the albedo/normal guides (u2-u5 bound)
+};
+
+float3 ToneMap(float3 color)
+{
+    color *= exposure;
+    if (toneMapOperator == 1) {
+        color = color / (1.0 + color);
+    } else if (toneMapOperator == 2) {
+        color = (color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14);
+    }
+    return saturate(color);
+}
+
+[numthreads(8, 8, 1)]
+void ResolveCS(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint2 pixel = dispatchThreadId.xy;
+    if (any(pixel >= outputSize)) {
+        return;
+    }
+
+    float4 accumulated = g_accumulation[pixel];
+    float invSamples = accumulated.a > 0.0 ? 1.0 / accumulated.a : 0.0;
+    float3 color = accumulated.rgb * invSamples;
+    g_resolved[pixel] = float4(hdrOutput != 0 ? color : ToneMap(color), 1.0);
+
+    if (resolveAOVs != 0) {
+        g_resolvedAlbedo[pixel] = float4(g_aovAlbedo[pixel].rgb * invSamples, 1.0);
+        g_resolvedNormal[pixel] = float4(g_aovNormal[pixel].rgb * invSamples, 1.0);
+    }
+}
+
+// Tone map an already averaged (e.g. denoised) linear image: u0 holds the HDR input, u1 the display target
+[numthreads(8, 8, 1)]
+void ToneMapCS(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint2 pixel = dispatchThreadId.xy;
+    if (any(pixel >= outputSize)) {
+        return;
+    }
+
+    g_resolved[pixel] = float4(ToneMap(g_accumulation[pixel].rgb), 1.0);
+}
@@ -2,12 +2,11 @@
 #ifndef STRUCTURES_HLSLI
 #define STRUCTURES_HLSLI
 
-struct Vertex {
-    float3 position;  // 12 bytes
-    float3 normal;    // 12 bytes
-    float2 texCoord;  // 8 bytes
-    float3 tangent;   // 12 bytes
-    float _pad;       // 4 bytes padding -> total 48 bytes (aligned to 16)
+// Shading attributes of a vertex (8 bytes, matches GPUVertexAttributes in Renderer.cpp).
+// Positions are a separate float3 stream, the one the BLAS is built from
+struct VertexAttributes {
+    uint normal;      // 0-3: Octahedral normal, 2 x unorm16 (DecodeOctahedral)
+    uint texCoord;    // 4-7: UV as 2 x half
 };
 
 // ============================================================================
@@ -136,6 +135,32 @@ struct Light {
     uint padding[2];
 };
 
+// ============================================================================
+// Emissive triangle of the light list (64 bytes, matches Renderer::GPULight)
+// World space; entries double as the alias table for power-proportional selection
+// ============================================================================
+struct EmissiveLight {
+    float3 p0;                  // 0-11: First vertex
+    uint alias;                 // 12-15: Entry taken when the probability test fails
+    float3 edge1;               // 16-27: p1 - p0
+    float probability;          // 28-31: Alias table threshold
+    float3 edge2;               // 32-43: p2 - p0
+    float pmf;                  // 44-47: Selection probability, luminance(emission) * area / total power
+    float3 emission;            // 48-59: Emitted radiance (two-sided)
+    float area;                 // 60-63: World-space area
+};
+
+// ============================================================================
+// Alpha cutout mask of a material (16 bytes, matches Renderer::AlphaMaskInfo)
+// 1 bit per base color texel (alpha >= 0.5), row-major in the mask bit buffer
+// ============================================================================
+struct AlphaMask {
+    uint offset;                // 0-3: First 32-bit word of the mask
+    uint width;                 // 4-7: Mask size in texels (0 = no mask, always opaque)
+    uint height;                // 8-11
+    uint _pad;                  // 12-15
+};
+
 struct BVHNode {
     float3 bboxMin; float _pad0;
     float3 bboxMax; float _pad1;
@@ -190,4 +215,15 @@ struct Camera {
     float focusDistance;
 };
 
+// ============================================================================
+// Virtual Texture Info (32 bytes, matches VirtualTextureSystem::GPUTextureInfo)
+// ============================================================================
+struct VirtualTextureInfo {
+    uint width;                 // 0-3: Texture width in pixels
+    uint height;                // 4-7: Texture height in pixels
+    uint mipCount;              // 8-11: Mip levels in the tile set (finest first)
+    uint feedbackOffset;        // 12-15: First feedback entry of this texture
+    float4 fallbackColor;       // 16-31: Average color, used while a tile is not resident
+};
+
 #endif // STRUCTURES_HLSLI
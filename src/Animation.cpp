@@ -0,0 +1,128 @@
+#include "Animation.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+namespace ACG {
+
+// Uniform Catmull-Rom segment between p1 and p2
+static glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float u) {
+    const float u2 = u * u;
+    const float u3 = u2 * u;
+    return 0.5f * (2.0f * p1 + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2 +
+                   (3.0f * p1 - p0 - 3.0f * p2 + p3) * u3);
+}
+
+// Index of the last key at or before time (keys sorted, at least one)
+template <typename Key>
+static size_t FindSegment(const std::vector<Key>& keys, float time) {
+    auto it = std::upper_bound(keys.begin(), keys.end(), time,
+                               [](float t, const Key& key) { return t < key.time; });
+    return it == keys.begin() ? 0 : static_cast<size_t>(it - keys.begin()) - 1;
+}
+
+template <typename Key>
+static void InsertSorted(std::vector<Key>& keys, const Key& key) {
+    auto it = std::upper_bound(keys.begin(), keys.end(), key.time,
+                               [](float t, const Key& other) { return t < other.time; });
+    keys.insert(it, key);
+}
+
+int AnimationSequence::GetFrameCount() const {
+    if (m_frameCount > 0) {
+        return m_frameCount;
+    }
+    float lastTime = m_cameraKeys.empty() ? 0.0f : m_cameraKeys.back().time;
+    for (const auto& track : m_instanceTracks) {
+        if (!track.second.empty()) {
+            lastTime = std::max(lastTime, track.second.back().time);
+        }
+    }
+    return std::max(1, static_cast<int>(std::floor(lastTime * m_fps + 0.5f)) + 1);
+}
+
+void AnimationSequence::AddCameraKeyframe(const CameraKeyframe& key) {
+    InsertSorted(m_cameraKeys, key);
+}
+
+void AnimationSequence::AddInstanceKeyframe(uint32_t instanceIndex, const TransformKeyframe& key) {
+    InsertSorted(m_instanceTracks[instanceIndex], key);
+}
+
+void AnimationSequence::SetTurntable(float revolutions, const glm::vec3& target, float radius, float height) {
+    m_turntable = true;
+    m_turntableRevolutions = revolutions;
+    m_turntableTarget = target;
+    m_turntableRadius = radius;
+    m_turntableHeight = height;
+}
+
+CameraKeyframe AnimationSequence::SampleCamera(float time) const {
+    CameraKeyframe result;
+    result.time = time;
+    if (m_turntable) {
+        // Frame count as the period, so a looped playback does not show the first pose twice
+        const float fraction = time * m_fps / static_cast<float>(GetFrameCount());
+        const float angle = 2.0f * 3.14159265358979f * m_turntableRevolutions * fraction;
+        result.position = m_turntableTarget + glm::vec3(m_turntableRadius * std::sin(angle), m_turntableHeight,
+                                                        m_turntableRadius * std::cos(angle));
+        result.target = m_turntableTarget;
+        return result;
+    }
+    if (m_cameraKeys.empty()) {
+        return result;
+    }
+
+    const size_t i = FindSegment(m_cameraKeys, time);
+    const CameraKeyframe& k1 = m_cameraKeys[i];
+    if (i + 1 >= m_cameraKeys.size() || time <= k1.time) {
+        return k1;
+    }
+    const CameraKeyframe& k0 = m_cameraKeys[i > 0 ? i - 1 : i];
+    const CameraKeyframe& k2 = m_cameraKeys[i + 1];
+    const CameraKeyframe& k3 = m_cameraKeys[std::min(i + 2, m_cameraKeys.size() - 1)];
+    const float u = (time - k1.time) / std::max(k2.time - k1.time, 1e-6f);
+    result.position = CatmullRom(k0.position, k1.position, k2.position, k3.position, u);
+    result.target = CatmullRom(k0.target, k1.target, k2.target, k3.target, u);
+    result.fov = (k1.fov > 0.0f && k2.fov > 0.0f) ? k1.fov + (k2.fov - k1.fov) * u : k1.fov;
+    return result;
+}
+
+glm::mat4 AnimationSequence::SampleInstance(uint32_t instanceIndex, float time) const {
+    auto track = m_instanceTracks.find(instanceIndex);
+    if (track == m_instanceTracks.end() || track->second.empty()) {
+        return glm::mat4(1.0f);
+    }
+    const std::vector<TransformKeyframe>& keys = track->second;
+    const size_t i = FindSegment(keys, time);
+    TransformKeyframe key = keys[i];
+    if (i + 1 < keys.size() && time > key.time) {
+        const TransformKeyframe& next = keys[i + 1];
+        const float u = (time - key.time) / std::max(next.time - key.time, 1e-6f);
+        key.translation = glm::mix(key.translation, next.translation, u);
+        key.rotation = glm::mix(key.rotation, next.rotation, u);
+        key.scale = glm::mix(key.scale, next.scale, u);
+    }
+
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), key.translation);
+    transform = glm::rotate(transform, glm::radians(key.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    transform = glm::rotate(transform, glm::radians(key.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    transform = glm::rotate(transform, glm::radians(key.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    return glm::scale(transform, key.scale);
+}
+
+std::string AnimationSequence::GetFramePath(const std::string& outputPath, int frame) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%04d", frame);
+    std::filesystem::path p = std::filesystem::u8path(outputPath);
+    std::filesystem::path extension = p.extension();
+    p.replace_extension();
+    p += suffix;
+    p += extension;
+    return p.u8string();
+}
+
+} // namespace ACG
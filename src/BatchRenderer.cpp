@@ -0,0 +1,670 @@
+#include "BatchRenderer.h"
+#include "Renderer.h"
+#include "ImageWriter.h"
+#include "Camera.h"
+#include "Animation.h"
+
+#include <stb_image.h>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace ACG {
+
+// Default reference quality for time-to-PSNR when the job names no reference image
+static const int REFERENCE_SAMPLES_FACTOR = 16;
+
+static int ParseInt(const std::string& key, const std::string& value) {
+    try {
+        size_t used = 0;
+        int result = std::stoi(value, &used);
+        if (used == value.size()) {
+            return result;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::runtime_error("Invalid integer for " + key + ": " + value);
+}
+
+static float ParseFloat(const std::string& key, const std::string& value) {
+    try {
+        size_t used = 0;
+        float result = std::stof(value, &used);
+        if (used == value.size()) {
+            return result;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::runtime_error("Invalid number for " + key + ": " + value);
+}
+
+// Exactly expected comma separated numbers, e.g. "0,1,5"
+static void ParseFloatList(const std::string& key, const std::string& value, float* values, int expected) {
+    std::stringstream stream(value);
+    std::string component;
+    int count = 0;
+    while (std::getline(stream, component, ',')) {
+        if (count == expected) {
+            count++;
+            break;
+        }
+        values[count++] = ParseFloat(key, component);
+    }
+    if (count != expected) {
+        throw std::runtime_error(key + " expects " + std::to_string(expected) + " comma separated values: " + value);
+    }
+}
+
+static glm::vec3 ParseVec3(const std::string& key, const std::string& value) {
+    float v[3];
+    ParseFloatList(key, value, v, 3);
+    return glm::vec3(v[0], v[1], v[2]);
+}
+
+// "x,y,z,tx,ty,tz": camera position followed by the look-at target
+static void ParseCamera(const std::string& value, glm::vec3& position, glm::vec3& target) {
+    float v[6];
+    ParseFloatList("camera (position, target)", value, v, 6);
+    position = glm::vec3(v[0], v[1], v[2]);
+    target = glm::vec3(v[3], v[4], v[5]);
+}
+
+// key=value tokens separated by whitespace; "..." keeps spaces in a value
+static std::vector<std::pair<std::string, std::string>> SplitKeyValues(const std::string& line, const std::string& location) {
+    std::vector<std::pair<std::string, std::string>> tokens;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        pos = line.find_first_not_of(" \t\r", pos);
+        if (pos == std::string::npos) {
+            break;
+        }
+        size_t equals = line.find('=', pos);
+        if (equals == std::string::npos) {
+            throw std::runtime_error(location + ": expected key=value");
+        }
+        std::string key = line.substr(pos, equals - pos);
+        std::string value;
+        pos = equals + 1;
+        if (pos < line.size() && line[pos] == '"') {
+            size_t close = line.find('"', pos + 1);
+            if (close == std::string::npos) {
+                throw std::runtime_error(location + ": unterminated quote");
+            }
+            value = line.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+        } else {
+            size_t end = line.find_first_of(" \t\r", pos);
+            value = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+            pos = end == std::string::npos ? line.size() : end;
+        }
+        tokens.emplace_back(key, value);
+    }
+    return tokens;
+}
+
+static bool IsBlankOrComment(const std::string& line) {
+    size_t start = line.find_first_not_of(" \t\r");
+    return start == std::string::npos || line[start] == '#';
+}
+
+static std::string ResolvePath(const std::string& path, const std::string& baseDirectory) {
+    if (path.empty() || baseDirectory.empty()) {
+        return path;
+    }
+    std::filesystem::path p = std::filesystem::u8path(path);
+    if (p.is_absolute()) {
+        return path;
+    }
+    return (std::filesystem::u8path(baseDirectory) / p).lexically_normal().u8string();
+}
+
+// "out/cloud.ppm" + ".spp4" -> "out/cloud.spp4.ppm"
+static std::string AppendToStem(const std::string& path, const std::string& suffix) {
+    std::filesystem::path p = std::filesystem::u8path(path);
+    std::filesystem::path extension = p.extension();
+    p.replace_extension();
+    p += suffix;
+    p += extension;
+    return p.u8string();
+}
+
+const char* BatchRenderer::GetUsage() {
+    return
+        "Usage:\n"
+        "  ACG_Project --headless --scene <file> --output <file> [options]\n"
+        "  ACG_Project --headless --jobs <job file>\n"
+        "  ACG_Project --benchmark <job file> [--report <file.json>]\n"
+        "Options (job file keys without the dashes):\n"
+        "  --scene <file>           Scene to load (kept resident while consecutive jobs use it)\n"
+        "  --output <file>          .exr writes EXR, anything else PPM\n"
+        "  --env <file>             Environment map (HDR/EXR)\n"
+        "  --width <n> --height <n> Resolution (default 1280x720)\n"
+        "  --spp <n>                Samples per pixel (default 64)\n"
+        "  --bounces <n>            Maximum bounces (default 5)\n"
+        "  --camera x,y,z,tx,ty,tz  Camera position and target (default 0,1,3,0,1,0)\n"
+        "  --fov <degrees>          Vertical field of view (default 60)\n"
+        "  --stats <file.json>      Write the frame statistics of the render\n"
+        "  --animation <file>       Render the keyframed sequence of the file, one numbered output per frame\n"
+        "  --psnr <dB>              Benchmark: measure time-to-PSNR against the reference\n"
+        "  --reference <file.ppm>   Benchmark: reference image (default: rendered at 16x spp)\n"
+        "  --reference-spp <n>      Benchmark: samples per pixel of the rendered reference\n"
+        "  --multi-gpu              Split the buckets of every render across all DXR adapters\n"
+        "  --verbose                Also print per-bucket, streaming and texture progress\n";
+}
+
+void BatchRenderer::ApplyOption(RenderJob& job, const std::string& key, const std::string& value, const std::string& baseDirectory) {
+    if (key == "scene") {
+        job.scenePath = ResolvePath(value, baseDirectory);
+    } else if (key == "output") {
+        job.outputPath = ResolvePath(value, baseDirectory);
+    } else if (key == "env") {
+        job.environmentMapPath = ResolvePath(value, baseDirectory);
+    } else if (key == "stats") {
+        job.statsPath = ResolvePath(value, baseDirectory);
+    } else if (key == "animation") {
+        job.animationPath = ResolvePath(value, baseDirectory);
+    } else if (key == "reference") {
+        job.referencePath = ResolvePath(value, baseDirectory);
+    } else if (key == "width") {
+        job.width = ParseInt(key, value);
+    } else if (key == "height") {
+        job.height = ParseInt(key, value);
+    } else if (key == "spp") {
+        job.samplesPerPixel = ParseInt(key, value);
+    } else if (key == "bounces") {
+        job.maxBounces = ParseInt(key, value);
+    } else if (key == "reference-spp") {
+        job.referenceSamples = ParseInt(key, value);
+    } else if (key == "psnr") {
+        job.psnrTarget = ParseFloat(key, value);
+    } else if (key == "fov") {
+        job.fov = ParseFloat(key, value);
+    } else if (key == "camera") {
+        ParseCamera(value, job.cameraPosition, job.cameraTarget);
+    } else {
+        throw std::runtime_error("Unknown option: " + key);
+    }
+
+    if (job.width < 1 || job.height < 1 || job.samplesPerPixel < 1 || job.maxBounces < 1) {
+        throw std::runtime_error("Resolution, spp and bounces must be at least 1 (" + key + "=" + value + ")");
+    }
+}
+
+BatchRenderer::Options BatchRenderer::ParseArguments(const std::vector<std::string>& args) {
+    Options options;
+    RenderJob job;
+    bool hasJobOptions = false;
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--headless") {
+            continue;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            throw std::runtime_error("Unexpected argument: " + arg);
+        }
+        // Flags handled by main() before the renderer is created
+        if (arg == "--inline-rayquery" || arg == "--no-ser" || arg == "--multi-gpu" || arg == "--verbose") {
+            continue;
+        }
+        if (i + 1 >= args.size()) {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        const std::string& value = args[++i];
+        if (arg == "--jobs" || arg == "--benchmark") {
+            std::vector<RenderJob> fileJobs = LoadJobFile(value);
+            options.jobs.insert(options.jobs.end(), fileJobs.begin(), fileJobs.end());
+            options.benchmark |= (arg == "--benchmark");
+        } else if (arg == "--report") {
+            options.reportPath = value;
+        } else {
+            ApplyOption(job, arg.substr(2), value, std::string());
+            hasJobOptions = true;
+        }
+    }
+
+    if (hasJobOptions) {
+        options.jobs.push_back(job);
+    }
+    if (options.jobs.empty()) {
+        throw std::runtime_error("No render jobs given");
+    }
+    for (const RenderJob& entry : options.jobs) {
+        if (entry.scenePath.empty()) {
+            throw std::runtime_error("Every job needs a scene");
+        }
+        if (entry.outputPath.empty() && !options.benchmark) {
+            throw std::runtime_error("Job for " + entry.scenePath + " needs an output path");
+        }
+    }
+    return options;
+}
+
+std::vector<RenderJob> BatchRenderer::LoadJobFile(const std::string& path) {
+    std::ifstream file(std::filesystem::u8path(path));
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open job file: " + path);
+    }
+    const std::string baseDirectory = std::filesystem::u8path(path).parent_path().u8string();
+
+    std::vector<RenderJob> jobs;
+    RenderJob job;  // Carries over from line to line
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (IsBlankOrComment(line)) {
+            continue;
+        }
+        const std::string location = path + ":" + std::to_string(lineNumber);
+        for (const auto& token : SplitKeyValues(line, location)) {
+            try {
+                ApplyOption(job, token.first, token.second, baseDirectory);
+            } catch (const std::exception& e) {
+                throw std::runtime_error(location + ": " + e.what());
+            }
+        }
+        jobs.push_back(job);
+        // A new line names its own output; the camera and everything else carry over
+        job.outputPath.clear();
+        job.statsPath.clear();
+        job.animationPath.clear();
+    }
+    std::cout << "Loaded " << jobs.size() << " job(s) from " << path << std::endl;
+    return jobs;
+}
+
+BatchRenderer::BatchRenderer(Renderer& renderer)
+    : m_renderer(renderer)
+    , m_lastLoadMs(0.0)
+{
+}
+
+int BatchRenderer::Run(const Options& options) {
+    std::vector<BenchmarkResult> results;
+    int failed = 0;
+
+    for (size_t i = 0; i < options.jobs.size(); ++i) {
+        const RenderJob& job = options.jobs[i];
+        std::cout << "=== Job " << (i + 1) << "/" << options.jobs.size() << ": " << job.scenePath << " ===" << std::endl;
+        try {
+            if (options.benchmark) {
+                BenchmarkResult result = Benchmark(job);
+                PrintResult(result);
+                results.push_back(result);
+            } else {
+                Prepare(job);
+                if (job.animationPath.empty()) {
+                    Render(job, job.outputPath, job.samplesPerPixel);
+                } else {
+                    RenderAnimation(job);
+                }
+                if (!job.statsPath.empty()) {
+                    m_renderer.SaveFrameStats(job.statsPath);
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Job " << (i + 1) << " failed: " << e.what() << std::endl;
+            failed++;
+        }
+    }
+
+    m_renderer.WaitForOutputFiles();
+    if (options.benchmark && !options.reportPath.empty() && !WriteReport(options.reportPath, results)) {
+        failed++;
+    }
+    std::cout << (options.jobs.size() - failed) << "/" << options.jobs.size() << " job(s) completed" << std::endl;
+    return failed;
+}
+
+void BatchRenderer::Prepare(const RenderJob& job) {
+    // LoadSceneAsync keeps the resident GPU resources when the file content did not change
+    const auto loadStart = std::chrono::steady_clock::now();
+    m_renderer.LoadSceneAsync(job.scenePath);
+    m_lastLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+    if (job.environmentMapPath != m_environmentMapPath) {
+        if (job.environmentMapPath.empty()) {
+            m_renderer.ClearEnvironmentMap();
+        } else {
+            m_renderer.SetEnvironmentMap(job.environmentMapPath);
+        }
+        m_environmentMapPath = job.environmentMapPath;
+    }
+
+    Camera* camera = m_renderer.GetCamera();
+    camera->SetPosition(job.cameraPosition);
+    camera->SetTarget(job.cameraTarget);
+    camera->SetFOV(job.fov);
+}
+
+void BatchRenderer::Render(const RenderJob& job, const std::string& outputPath, int samplesPerPixel) {
+    std::filesystem::path parent = std::filesystem::u8path(outputPath).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    m_renderer.OnResize(job.width, job.height);
+    m_renderer.RenderToFile(outputPath, samplesPerPixel, job.maxBounces);
+}
+
+void BatchRenderer::RenderAnimation(const RenderJob& job) {
+    const AnimationSequence sequence = LoadAnimationFile(job.animationPath);
+    std::filesystem::path parent = std::filesystem::u8path(job.outputPath).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    m_renderer.OnResize(job.width, job.height);
+    m_renderer.RenderSequence(sequence, job.outputPath, job.samplesPerPixel, job.maxBounces);
+}
+
+AnimationSequence BatchRenderer::LoadAnimationFile(const std::string& path) {
+    std::ifstream file(std::filesystem::u8path(path));
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open animation file: " + path);
+    }
+
+    AnimationSequence sequence;
+    bool turntable = false;
+    bool hasFrameCount = false;
+    float fov = 0.0f;  // Camera keys without fov keep the previous key's
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (IsBlankOrComment(line)) {
+            continue;
+        }
+        const std::string location = path + ":" + std::to_string(lineNumber);
+        const std::vector<std::pair<std::string, std::string>> tokens = SplitKeyValues(line, location);
+        // The first key names the line: camera=<time>, instance=<index>, turntable=<revolutions> or settings
+        const std::string& kind = tokens.front().first;
+        try {
+            if (kind == "camera") {
+                CameraKeyframe key;
+                key.time = ParseFloat("camera", tokens.front().second);
+                key.fov = fov;
+                for (size_t i = 1; i < tokens.size(); ++i) {
+                    const std::string& name = tokens[i].first;
+                    if (name == "position") {
+                        key.position = ParseVec3(name, tokens[i].second);
+                    } else if (name == "target") {
+                        key.target = ParseVec3(name, tokens[i].second);
+                    } else if (name == "fov") {
+                        key.fov = ParseFloat(name, tokens[i].second);
+                    } else {
+                        throw std::runtime_error("Unknown camera key option: " + name);
+                    }
+                }
+                fov = key.fov;
+                sequence.AddCameraKeyframe(key);
+            } else if (kind == "instance") {
+                const int index = ParseInt("instance", tokens.front().second);
+                if (index < 0) {
+                    throw std::runtime_error("Invalid instance index: " + tokens.front().second);
+                }
+                TransformKeyframe key;
+                for (size_t i = 1; i < tokens.size(); ++i) {
+                    const std::string& name = tokens[i].first;
+                    if (name == "time") {
+                        key.time = ParseFloat(name, tokens[i].second);
+                    } else if (name == "translate") {
+                        key.translation = ParseVec3(name, tokens[i].second);
+                    } else if (name == "rotate") {
+                        key.rotation = ParseVec3(name, tokens[i].second);
+                    } else if (name == "scale") {
+                        key.scale = ParseVec3(name, tokens[i].second);
+                    } else {
+                        throw std::runtime_error("Unknown instance key option: " + name);
+                    }
+                }
+                sequence.AddInstanceKeyframe(static_cast<uint32_t>(index), key);
+            } else if (kind == "turntable") {
+                const float revolutions = ParseFloat("turntable", tokens.front().second);
+                glm::vec3 target(0.0f, 1.0f, 0.0f);
+                float radius = 3.0f;
+                float height = 0.0f;
+                for (size_t i = 1; i < tokens.size(); ++i) {
+                    const std::string& name = tokens[i].first;
+                    if (name == "target") {
+                        target = ParseVec3(name, tokens[i].second);
+                    } else if (name == "radius") {
+                        radius = ParseFloat(name, tokens[i].second);
+                    } else if (name == "height") {
+                        height = ParseFloat(name, tokens[i].second);
+                    } else {
+                        throw std::runtime_error("Unknown turntable option: " + name);
+                    }
+                }
+                sequence.SetTurntable(revolutions, target, radius, height);
+                turntable = true;
+            } else {
+                for (const auto& token : tokens) {
+                    if (token.first == "fps") {
+                        const float fps = ParseFloat(token.first, token.second);
+                        if (fps <= 0.0f) {
+                            throw std::runtime_error("fps must be positive");
+                        }
+                        sequence.SetFramesPerSecond(fps);
+                    } else if (token.first == "frames") {
+                        const int frames = ParseInt(token.first, token.second);
+                        if (frames < 1) {
+                            throw std::runtime_error("frames must be at least 1");
+                        }
+                        sequence.SetFrameCount(frames);
+                        hasFrameCount = true;
+                    } else {
+                        throw std::runtime_error("Unknown animation option: " + token.first);
+                    }
+                }
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error(location + ": " + e.what());
+        }
+    }
+    if (turntable && !hasFrameCount) {
+        throw std::runtime_error(path + ": a turntable needs frames=<count>");
+    }
+    std::cout << "Loaded animation from " << path << ": " << sequence.GetFrameCount() << " frames" << std::endl;
+    return sequence;
+}
+
+double BatchRenderer::ComputePSNR(const std::string& imagePath, const std::string& referencePath) {
+    int width = 0, height = 0, channels = 0;
+    int refWidth = 0, refHeight = 0, refChannels = 0;
+    stbi_uc* image = stbi_load(imagePath.c_str(), &width, &height, &channels, 3);
+    stbi_uc* reference = stbi_load(referencePath.c_str(), &refWidth, &refHeight, &refChannels, 3);
+
+    double psnr = -1.0;
+    if (image && reference && width == refWidth && height == refHeight) {
+        double squaredError = 0.0;
+        const size_t count = static_cast<size_t>(width) * height * 3;
+        for (size_t i = 0; i < count; ++i) {
+            const double diff = static_cast<double>(image[i]) - static_cast<double>(reference[i]);
+            squaredError += diff * diff;
+        }
+        const double mse = squaredError / static_cast<double>(count);
+        // Identical images: report a finite ceiling instead of infinity
+        psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 100.0;
+    } else {
+        std::cerr << "PSNR: cannot compare " << imagePath << " with " << referencePath << std::endl;
+    }
+
+    stbi_image_free(image);
+    stbi_image_free(reference);
+    return psnr;
+}
+
+BatchRenderer::BenchmarkResult BatchRenderer::Benchmark(const RenderJob& job) {
+    BenchmarkResult result;
+    result.scene = job.scenePath;
+    result.width = job.width;
+    result.height = job.height;
+    result.samplesPerPixel = job.samplesPerPixel;
+    result.psnrTarget = job.psnrTarget;
+
+    // Without an output path the images go to benchmark/<scene name>.ppm next to the working directory
+    std::string outputPath = job.outputPath;
+    if (outputPath.empty()) {
+        std::filesystem::path scene = std::filesystem::u8path(job.scenePath);
+        outputPath = (std::filesystem::path("benchmark") / (scene.parent_path().filename().u8string() + "_" +
+                      scene.stem().u8string() + ".ppm")).u8string();
+    }
+
+    Prepare(job);
+    result.loadMs = m_lastLoadMs;
+    Render(job, outputPath, job.samplesPerPixel);
+
+    // Load phases keep their totals until the next load; texture upload ranges complete on the copy queue
+    // during the render and are collected by its last publish. A resident scene was not loaded for this
+    // job, so its load phases cost nothing here
+    FrameStats stats = m_renderer.GetFrameStats();
+    const FrameStats::Phase& asBuild = stats.phases[static_cast<uint32_t>(RenderPhase::AccelerationStructureBuild)];
+    const FrameStats::Phase& upload = stats.phases[static_cast<uint32_t>(RenderPhase::TextureUpload)];
+    result.sceneReused = m_renderer.WasLastLoadReused();
+    if (!result.sceneReused) {
+        result.importMs = stats.sceneLoad.totalMs;
+        result.accelerationStructureMs = asBuild.gpuMs > 0.0 ? asBuild.gpuMs : asBuild.cpuMs;
+        result.textureUploadMs = upload.gpuMs > 0.0 ? upload.gpuMs : upload.cpuMs;
+    }
+    result.renderMs = stats.renderMs;
+    result.pathTracingMs = stats.phases[static_cast<uint32_t>(RenderPhase::PathTracing)].gpuMs;
+    result.raysPerSecond = stats.raysPerSecond;
+    if (!job.statsPath.empty()) {
+        m_renderer.SaveFrameStats(job.statsPath);
+    }
+
+    if (job.psnrTarget <= 0.0f) {
+        return result;
+    }
+    if (ImageWriter::GetFileFormat(outputPath) != ImageWriter::FileFormat::PPM) {
+        std::cerr << "Time-to-PSNR needs PPM output, skipped for " << outputPath << std::endl;
+        return result;
+    }
+
+    std::string referencePath = job.referencePath;
+    if (referencePath.empty()) {
+        const int referenceSamples = job.referenceSamples > 0 ? job.referenceSamples : job.samplesPerPixel * REFERENCE_SAMPLES_FACTOR;
+        referencePath = AppendToStem(outputPath, ".reference");
+        std::cout << "Rendering reference at " << referenceSamples << " spp" << std::endl;
+        Render(job, referencePath, referenceSamples);
+    }
+    m_renderer.WaitForOutputFiles();
+
+    // Each step is a render from scratch, so its wall time is the time to reach its quality
+    const double finalPsnr = ComputePSNR(outputPath, referencePath);
+    for (int spp = 1; spp < job.samplesPerPixel; spp *= 2) {
+        const std::string stepPath = AppendToStem(outputPath, ".spp" + std::to_string(spp));
+        Render(job, stepPath, spp);
+        const double stepRenderMs = m_renderer.GetFrameStats().renderMs;
+        m_renderer.WaitForOutputFiles();
+        const double psnr = ComputePSNR(stepPath, referencePath);
+        result.psnrCurve.push_back({ spp, psnr });
+        if (psnr >= job.psnrTarget) {
+            result.timeToPsnrMs = stepRenderMs;
+            result.samplesToPsnr = spp;
+            break;
+        }
+    }
+    result.psnrCurve.push_back({ job.samplesPerPixel, finalPsnr });
+    if (result.timeToPsnrMs < 0.0 && finalPsnr >= job.psnrTarget) {
+        result.timeToPsnrMs = result.renderMs;
+        result.samplesToPsnr = job.samplesPerPixel;
+    }
+    return result;
+}
+
+void BatchRenderer::PrintResult(const BenchmarkResult& result) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Benchmark " << result.scene << " (" << result.width << "x" << result.height << ", "
+              << result.samplesPerPixel << " spp)" << std::endl;
+    if (result.sceneReused) {
+        std::cout << "  Load: " << result.loadMs << " ms (resident scene reused)" << std::endl;
+    } else {
+        std::cout << "  Load: " << result.loadMs << " ms (import " << result.importMs << " ms, texture upload "
+                  << result.textureUploadMs << " ms)" << std::endl;
+    }
+    std::cout << "  AS build: " << result.accelerationStructureMs << " ms" << std::endl;
+    std::cout << "  Render: " << result.renderMs << " ms (path tracing " << result.pathTracingMs << " ms GPU, "
+              << std::setprecision(2) << result.raysPerSecond / 1.0e6 << " M camera rays/s)" << std::endl;
+    if (result.psnrTarget > 0.0f && !result.psnrCurve.empty()) {
+        std::cout << std::setprecision(1);
+        for (const auto& point : result.psnrCurve) {
+            std::cout << "    " << point.first << " spp: " << point.second << " dB" << std::endl;
+        }
+        if (result.timeToPsnrMs >= 0.0) {
+            std::cout << "  Time to " << result.psnrTarget << " dB: " << result.timeToPsnrMs << " ms ("
+                      << result.samplesToPsnr << " spp)" << std::endl;
+        } else {
+            std::cout << "  " << result.psnrTarget << " dB not reached" << std::endl;
+        }
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+bool BatchRenderer::WriteReport(const std::string& path, const std::vector<BenchmarkResult>& results) {
+    std::filesystem::path parent = std::filesystem::u8path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream file(std::filesystem::u8path(path));
+    if (!file.is_open()) {
+        std::cerr << "Failed to open benchmark report: " << path << std::endl;
+        return false;
+    }
+
+    // Scene paths are written as given; backslashes are escaped for JSON
+    auto escape = [](const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '\\' || c == '"') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    };
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        file << "    {\n";
+        file << "      \"scene\": \"" << escape(r.scene) << "\",\n";
+        file << "      \"resolution\": [" << r.width << ", " << r.height << "],\n";
+        file << "      \"samplesPerPixel\": " << r.samplesPerPixel << ",\n";
+        file << "      \"loadMs\": " << r.loadMs << ",\n";
+        file << "      \"sceneReused\": " << (r.sceneReused ? "true" : "false") << ",\n";
+        file << "      \"importMs\": " << r.importMs << ",\n";
+        file << "      \"textureUploadMs\": " << r.textureUploadMs << ",\n";
+        file << "      \"accelerationStructureMs\": " << r.accelerationStructureMs << ",\n";
+        file << "      \"renderMs\": " << r.renderMs << ",\n";
+        file << "      \"pathTracingMs\": " << r.pathTracingMs << ",\n";
+        file << "      \"mraysPerSecond\": " << r.raysPerSecond / 1.0e6 << ",\n";
+        file << "      \"psnrTarget\": " << r.psnrTarget << ",\n";
+        file << "      \"timeToPsnrMs\": " << r.timeToPsnrMs << ",\n";
+        file << "      \"samplesToPsnr\": " << r.samplesToPsnr << ",\n";
+        file << "      \"psnr\": [";
+        for (size_t p = 0; p < r.psnrCurve.size(); ++p) {
+            file << (p > 0 ? ", " : "") << "{ \"spp\": " << r.psnrCurve[p].first << ", \"dB\": " << r.psnrCurve[p].second << " }";
+        }
+        file << "]\n";
+        file << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write benchmark report: " << path << std::endl;
+        return false;
+    }
+    std::cout << "Benchmark report written: " << path << std::endl;
+    return true;
+}
+
+} // namespace ACG
@@ -1,5 +1,7 @@
 #include "Denoiser.h"
+#include "Logger.h"
 #include <OpenImageDenoise/oidn.hpp>
+#include <cstring>
 #include <iostream>
 
 namespace ACG {
@@ -7,9 +9,73 @@ namespace ACG {
 class Denoiser::Impl {
 public:
     oidn::DeviceRef device;
+    // 过滤器在初始化时创建并跨帧复用; 只有图像参数变化时才需要重新 commit
     oidn::FilterRef filter;
+    oidn::FilterRef albedoFilter;   // 引导图预滤波
+    oidn::FilterRef normalFilter;
+    std::vector<float> albedo;      // 预滤波后的引导图 (RGB float, 主机内存可访问时)
+    std::vector<float> normal;
+
+    // GPU设备通常不能直接访问主机内存, 主机图像经由设备缓冲区中转
+    bool systemMemorySupported = true;
+    enum StagingSlot { StagingColor, StagingAlbedo, StagingNormal, StagingOutput, StagingCount };
+    oidn::BufferRef staging[StagingCount];
+
+    // 导入的 D3D12 共享缓冲区
+    oidn::BufferRef sharedBuffer;
+
+    // 上次提交到过滤器的共享缓冲区布局; 相同时跳过 setImage/commit
+    struct SharedLayout {
+        size_t offsets[4];
+        size_t pixelByteStride;
+        size_t rowByteStride;
+        int width;
+        int height;
+    };
+    SharedLayout sharedLayout = {};
+    bool sharedLayoutCommitted = false;
+
+    // 把主机图像绑定到过滤器; upload 为 false 时只分配 (输出图像)
+    void BindHostImage(oidn::FilterRef& target, const char* name, StagingSlot slot, const void* data,
+                       oidn::Format format, int width, int height,
+                       size_t pixelByteStride, size_t rowByteStride, size_t byteSize, bool upload) {
+        if (systemMemorySupported) {
+            target.setImage(name, const_cast<void*>(data), format, width, height, 0, pixelByteStride, rowByteStride);
+            return;
+        }
+        if (!staging[slot] || staging[slot].getSize() < byteSize) {
+            staging[slot] = device.newBuffer(byteSize);
+        }
+        if (upload) {
+            staging[slot].write(0, byteSize, data);
+        }
+        target.setImage(name, staging[slot], format, width, height, 0, pixelByteStride, rowByteStride);
+    }
+
+    // 把中转的输出图像复制回主机
+    void ReadHostImage(StagingSlot slot, void* data, size_t byteSize) {
+        if (!systemMemorySupported) {
+            staging[slot].read(0, byteSize, data);
+        }
+    }
 };
 
+// 取出设备错误; 有错误时写入message
+static bool HasDeviceError(oidn::DeviceRef& device, const char* context, std::string& message) {
+    const char* errorMessage;
+    if (device.getError(errorMessage) != oidn::Error::None) {
+        message = std::string(context) + ": " + errorMessage;
+        std::cerr << message << std::endl;
+        return true;
+    }
+    return false;
+}
+
+// 带步长图像实际覆盖的字节数 (最后一行不含行尾填充)
+static size_t StridedImageSize(int width, int height, size_t pixelByteStride, size_t rowByteStride) {
+    return rowByteStride * (height - 1) + pixelByteStride * width;
+}
+
 Denoiser::Denoiser() 
     : m_impl(std::make_unique<Impl>())
     , m_initialized(false)
@@ -20,15 +86,46 @@ Denoiser::~Denoiser() {
     if (m_impl && m_impl->filter) {
         m_impl->filter = nullptr;
     }
+    if (m_impl) {
+        m_impl->albedoFilter = nullptr;
+        m_impl->normalFilter = nullptr;
+        m_impl->sharedBuffer = nullptr;
+        for (oidn::BufferRef& buffer : m_impl->staging) {
+            buffer = nullptr;
+        }
+    }
     if (m_impl && m_impl->device) {
         m_impl->device = nullptr;
     }
 }
 
-bool Denoiser::Initialize() {
+bool Denoiser::Initialize(const uint8_t* adapterLuid) {
     try {
+        // 优先选择与渲染适配器相同的GPU, 图像可以留在显存中
+        if (adapterLuid) {
+            const int physicalDeviceCount = oidn::getNumPhysicalDevices();
+            for (int i = 0; i < physicalDeviceCount; ++i) {
+                oidn::PhysicalDeviceRef physicalDevice(i);
+                if (!physicalDevice.get<bool>("luidSupported")) {
+                    continue;
+                }
+                oidn::LUID luid = physicalDevice.get<oidn::LUID>("luid");
+                if (std::memcmp(luid.bytes, adapterLuid, sizeof(luid.bytes)) == 0) {
+                    m_impl->device = physicalDevice.newDevice();
+                    std::cout << "OIDN using physical device " << i << ": "
+                              << physicalDevice.get<std::string>("name") << std::endl;
+                    break;
+                }
+            }
+            if (!m_impl->device) {
+                std::cout << "OIDN: no device matches the render adapter, using the default device" << std::endl;
+            }
+        }
+
         // 创建OIDN设备（自动选择最佳设备）
-        m_impl->device = oidn::newDevice();
+        if (!m_impl->device) {
+            m_impl->device = oidn::newDevice();
+        }
         m_impl->device.commit();
 
         // 检查设备是否成功创建
@@ -39,6 +136,14 @@ bool Denoiser::Initialize() {
             return false;
         }
 
+        m_impl->systemMemorySupported = m_impl->device.get<bool>("systemMemorySupported");
+        m_impl->filter = m_impl->device.newFilter("RT");
+        m_impl->albedoFilter = m_impl->device.newFilter("RT");
+        m_impl->normalFilter = m_impl->device.newFilter("RT");
+        if (HasDeviceError(m_impl->device, "OIDN filter creation failed", m_errorMessage)) {
+            return false;
+        }
+
         std::cout << "OIDN initialized successfully" << std::endl;
         m_initialized = true;
         return true;
@@ -69,27 +174,35 @@ bool Denoiser::Denoise(
     }
 
     try {
-        // 创建降噪过滤器
-        m_impl->filter = m_impl->device.newFilter("RT");
+        // 复用降噪过滤器, 图像参数每次重新设置
+        m_impl->sharedLayoutCommitted = false;
+        const size_t pixelByteStride = sizeof(float) * 3;
+        const size_t rowByteStride = pixelByteStride * width;
+        const size_t imageSize = rowByteStride * height;
 
         // 设置输入图像
-        m_impl->filter.setImage("color", const_cast<float*>(input), 
-                                oidn::Format::Float3, width, height);
+        m_impl->BindHostImage(m_impl->filter, "color", Impl::StagingColor, input,
+                              oidn::Format::Float3, width, height, pixelByteStride, rowByteStride, imageSize, true);
         
         // 设置输出图像
-        m_impl->filter.setImage("output", output, 
-                                oidn::Format::Float3, width, height);
+        m_impl->BindHostImage(m_impl->filter, "output", Impl::StagingOutput, output,
+                              oidn::Format::Float3, width, height, pixelByteStride, rowByteStride, imageSize, false);
 
         // 如果提供了albedo和normal，使用它们提高降噪质量
         if (albedo) {
-            m_impl->filter.setImage("albedo", const_cast<float*>(albedo),
-                                    oidn::Format::Float3, width, height);
+            m_impl->BindHostImage(m_impl->filter, "albedo", Impl::StagingAlbedo, albedo,
+                                  oidn::Format::Float3, width, height, pixelByteStride, rowByteStride, imageSize, true);
+        } else {
+            m_impl->filter.unsetImage("albedo");
         }
 
         if (normal) {
-            m_impl->filter.setImage("normal", const_cast<float*>(normal),
-                                    oidn::Format::Float3, width, height);
+            m_impl->BindHostImage(m_impl->filter, "normal", Impl::StagingNormal, normal,
+                                  oidn::Format::Float3, width, height, pixelByteStride, rowByteStride, imageSize, true);
+        } else {
+            m_impl->filter.unsetImage("normal");
         }
+        m_impl->filter.set("cleanAux", false);
 
         // 设置HDR模式（对于路径追踪渲染）
         m_impl->filter.set("hdr", true);
@@ -99,6 +212,7 @@ bool Denoiser::Denoise(
 
         // 执行降噪
         m_impl->filter.execute();
+        m_impl->ReadHostImage(Impl::StagingOutput, output, imageSize);
 
         // 检查错误
         const char* errorMessage;
@@ -108,7 +222,215 @@ bool Denoiser::Denoise(
             return false;
         }
 
-        std::cout << "Image denoised successfully (" << width << "x" << height << ")" << std::endl;
+        ACG_LOG_DEBUG("Image denoised successfully (" << width << "x" << height << ")");
+        return true;
+
+    } catch (const std::exception& e) {
+        m_errorMessage = std::string("OIDN denoising exception: ") + e.what();
+        std::cerr << m_errorMessage << std::endl;
+        return false;
+    }
+}
+
+bool Denoiser::DenoiseHalf(
+    const void* input,
+    const void* albedo,
+    const void* normal,
+    size_t pixelByteStride,
+    size_t rowByteStride,
+    float* output,
+    int width,
+    int height
+) {
+    if (!m_initialized) {
+        m_errorMessage = "Denoiser not initialized";
+        return false;
+    }
+
+    if (!input || !output || width <= 0 || height <= 0) {
+        m_errorMessage = "Invalid input parameters";
+        return false;
+    }
+
+    try {
+        m_impl->sharedLayoutCommitted = false;
+        const bool guided = albedo && normal;
+        const size_t inputSize = StridedImageSize(width, height, pixelByteStride, rowByteStride);
+        const size_t outputPixelStride = sizeof(float) * 3;
+        const size_t outputSize = outputPixelStride * width * height;
+
+        // OIDN读取带步长的半精度输入, 不需要先在CPU上重新打包
+        m_impl->BindHostImage(m_impl->filter, "color", Impl::StagingColor, input,
+                              oidn::Format::Half3, width, height, pixelByteStride, rowByteStride, inputSize, true);
+        m_impl->BindHostImage(m_impl->filter, "output", Impl::StagingOutput, output,
+                              oidn::Format::Float3, width, height, outputPixelStride, outputPixelStride * width, outputSize, false);
+
+        // 引导图先单独降噪 (路径追踪的首次命中仍有抗锯齿/景深噪声), 主过滤器才能信任它们 (cleanAux)
+        // 主机内存可直接访问时预滤波输出到紧密排列的 float 数组, 否则在中转缓冲区内原地预滤波
+        if (guided) {
+            const bool inPlace = !m_impl->systemMemorySupported;
+            const size_t pixelCount = static_cast<size_t>(width) * height;
+            auto prefilter = [&](oidn::FilterRef& auxFilter, const char* name, Impl::StagingSlot slot,
+                                 const void* aux, std::vector<float>& filtered) {
+                m_impl->BindHostImage(auxFilter, name, slot, aux,
+                                      oidn::Format::Half3, width, height, pixelByteStride, rowByteStride, inputSize, true);
+                if (inPlace) {
+                    auxFilter.setImage("output", m_impl->staging[slot], oidn::Format::Half3, width, height,
+                                       0, pixelByteStride, rowByteStride);
+                    m_impl->filter.setImage(name, m_impl->staging[slot], oidn::Format::Half3, width, height,
+                                            0, pixelByteStride, rowByteStride);
+                } else {
+                    filtered.resize(pixelCount * 3);
+                    auxFilter.setImage("output", filtered.data(), oidn::Format::Float3, width, height);
+                    m_impl->filter.setImage(name, filtered.data(), oidn::Format::Float3, width, height);
+                }
+                auxFilter.commit();
+                auxFilter.execute();
+            };
+            prefilter(m_impl->albedoFilter, "albedo", Impl::StagingAlbedo, albedo, m_impl->albedo);
+            prefilter(m_impl->normalFilter, "normal", Impl::StagingNormal, normal, m_impl->normal);
+            m_impl->filter.set("cleanAux", true);
+        } else {
+            m_impl->filter.unsetImage("albedo");
+            m_impl->filter.unsetImage("normal");
+            m_impl->filter.set("cleanAux", false);
+        }
+        m_impl->filter.set("hdr", true);
+        m_impl->filter.commit();
+        m_impl->filter.execute();
+        m_impl->ReadHostImage(Impl::StagingOutput, output, outputSize);
+
+        const char* errorMessage;
+        if (m_impl->device.getError(errorMessage) != oidn::Error::None) {
+            m_errorMessage = std::string("OIDN denoising failed: ") + errorMessage;
+            std::cerr << m_errorMessage << std::endl;
+            return false;
+        }
+
+        ACG_LOG_DEBUG("Image denoised successfully (" << width << "x" << height << ", half input"
+                      << (guided ? ", albedo/normal guided" : "") << ")");
+        return true;
+
+    } catch (const std::exception& e) {
+        m_errorMessage = std::string("OIDN denoising exception: ") + e.what();
+        std::cerr << m_errorMessage << std::endl;
+        return false;
+    }
+}
+
+bool Denoiser::SupportsD3D12SharedBuffers() const {
+    if (!m_initialized) {
+        return false;
+    }
+    oidn::ExternalMemoryTypeFlags types = m_impl->device.get<oidn::ExternalMemoryTypeFlags>("externalMemoryTypes");
+    return static_cast<bool>(types & oidn::ExternalMemoryTypeFlag::D3D12Resource);
+}
+
+bool Denoiser::ImportD3D12SharedBuffer(void* sharedHandle, size_t byteSize) {
+    if (!m_initialized) {
+        m_errorMessage = "Denoiser not initialized";
+        return false;
+    }
+
+    ReleaseSharedBuffer();
+    m_impl->sharedBuffer = m_impl->device.newBuffer(oidn::ExternalMemoryTypeFlag::D3D12Resource,
+                                                    sharedHandle, nullptr, byteSize);
+    if (HasDeviceError(m_impl->device, "OIDN shared buffer import failed", m_errorMessage)) {
+        m_impl->sharedBuffer = nullptr;
+        return false;
+    }
+
+    std::cout << "OIDN imported D3D12 shared buffer (" << (byteSize / (1024 * 1024)) << " MB)" << std::endl;
+    return true;
+}
+
+void Denoiser::ReleaseSharedBuffer() {
+    // 过滤器仍引用旧缓冲区时先解除 (下次降噪会重新设置图像)
+    if (m_impl->sharedLayoutCommitted) {
+        m_impl->filter.unsetImage("color");
+        m_impl->filter.unsetImage("albedo");
+        m_impl->filter.unsetImage("normal");
+        m_impl->filter.unsetImage("output");
+        m_impl->albedoFilter.unsetImage("albedo");
+        m_impl->albedoFilter.unsetImage("output");
+        m_impl->normalFilter.unsetImage("normal");
+        m_impl->normalFilter.unsetImage("output");
+        m_impl->sharedLayoutCommitted = false;
+    }
+    m_impl->sharedBuffer = nullptr;
+}
+
+bool Denoiser::DenoiseSharedHalf(
+    size_t colorOffset,
+    size_t albedoOffset,
+    size_t normalOffset,
+    size_t outputOffset,
+    size_t pixelByteStride,
+    size_t rowByteStride,
+    int width,
+    int height
+) {
+    if (!m_initialized || !m_impl->sharedBuffer) {
+        m_errorMessage = "Denoiser has no shared buffer";
+        return false;
+    }
+
+    if (width <= 0 || height <= 0) {
+        m_errorMessage = "Invalid input parameters";
+        return false;
+    }
+
+    try {
+        // 布局不变 (同尺寸的分块/帧) 时直接复用已提交的过滤器
+        Impl::SharedLayout layout = { { colorOffset, albedoOffset, normalOffset, outputOffset },
+                                      pixelByteStride, rowByteStride, width, height };
+        if (!m_impl->sharedLayoutCommitted || std::memcmp(&layout, &m_impl->sharedLayout, sizeof(layout)) != 0) {
+            const oidn::BufferRef& buffer = m_impl->sharedBuffer;
+
+            // 引导图原地预滤波
+            m_impl->albedoFilter.setImage("albedo", buffer, oidn::Format::Half3, width, height,
+                                          albedoOffset, pixelByteStride, rowByteStride);
+            m_impl->albedoFilter.setImage("output", buffer, oidn::Format::Half3, width, height,
+                                          albedoOffset, pixelByteStride, rowByteStride);
+            m_impl->albedoFilter.commit();
+
+            m_impl->normalFilter.setImage("normal", buffer, oidn::Format::Half3, width, height,
+                                          normalOffset, pixelByteStride, rowByteStride);
+            m_impl->normalFilter.setImage("output", buffer, oidn::Format::Half3, width, height,
+                                          normalOffset, pixelByteStride, rowByteStride);
+            m_impl->normalFilter.commit();
+
+            m_impl->filter.setImage("color", buffer, oidn::Format::Half3, width, height,
+                                    colorOffset, pixelByteStride, rowByteStride);
+            m_impl->filter.setImage("albedo", buffer, oidn::Format::Half3, width, height,
+                                    albedoOffset, pixelByteStride, rowByteStride);
+            m_impl->filter.setImage("normal", buffer, oidn::Format::Half3, width, height,
+                                    normalOffset, pixelByteStride, rowByteStride);
+            m_impl->filter.setImage("output", buffer, oidn::Format::Half3, width, height,
+                                    outputOffset, pixelByteStride, rowByteStride);
+            m_impl->filter.set("cleanAux", true);
+            m_impl->filter.set("hdr", true);
+            m_impl->filter.commit();
+
+            if (HasDeviceError(m_impl->device, "OIDN filter setup failed", m_errorMessage)) {
+                m_impl->sharedLayoutCommitted = false;
+                return false;
+            }
+            m_impl->sharedLayout = layout;
+            m_impl->sharedLayoutCommitted = true;
+        }
+
+        // 三个过滤器在设备队列上依次执行, 最后同步一次
+        m_impl->albedoFilter.executeAsync();
+        m_impl->normalFilter.executeAsync();
+        m_impl->filter.executeAsync();
+        m_impl->device.sync();
+
+        if (HasDeviceError(m_impl->device, "OIDN denoising failed", m_errorMessage)) {
+            return false;
+        }
+
+        ACG_LOG_DEBUG("Image denoised on device (" << width << "x" << height << ", shared buffer)");
         return true;
 
     } catch (const std::exception& e) {
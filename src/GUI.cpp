@@ -3,6 +3,7 @@
 #include "Renderer.h"
 #include "Camera.h"
 #include "Scene.h"
+#include "Logger.h"
 #include "imgui.h"
 #include <commdlg.h>
 #include <thread>
@@ -13,6 +14,7 @@
 #include <sstream>
 #include <cmath>
 #include <chrono>
+#include <filesystem>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <glm/gtx/rotate_vector.hpp>
@@ -29,7 +31,6 @@ static std::mutex g_renderMutex;
 static std::unique_ptr<std::thread> g_renderThread;
 
 // Scene loading tracking
-static std::string g_lastLoadedScene;
 static std::string g_lastLoadedEnvMap;
 
 void InitializeGUIState(GUIState& state, const std::string& exeDirectory) {
@@ -271,17 +272,59 @@ void RenderSettingsWindow(ACG::Renderer* renderer, GUIState& state, HWND hwnd) {
     ImGui::Text("Output Resolution");
     ImGui::InputInt("Width", &state.width);
     ImGui::InputInt("Height", &state.height);
+    if (ImGui::InputInt("Bucket Size (0 = auto)", &state.bucketSize)) {
+        if (state.bucketSize < 0) state.bucketSize = 0;
+        renderer->SetBucketSize(state.bucketSize);
+    }
     
     ImGui::Separator();
     ImGui::Text("Sampling");
     if (ImGui::InputInt("Samples Per Pixel", &state.samplesPerPixel)) {
         if (state.samplesPerPixel < 1) state.samplesPerPixel = 1;
+        renderer->SetSamplesPerPixel(state.samplesPerPixel);  // Also the target of the live preview
+    }
+    
+    if (ImGui::InputInt("Samples Per Dispatch", &state.samplesPerDispatch)) {
+        if (state.samplesPerDispatch < 1) state.samplesPerDispatch = 1;
+        renderer->SetSamplesPerDispatch(state.samplesPerDispatch);
+    }
+    
+    bool adaptiveChanged = ImGui::Checkbox("Adaptive Sampling", &state.adaptiveSampling);
+    if (state.adaptiveSampling) {
+        adaptiveChanged |= ImGui::SliderFloat("Noise Threshold", &state.adaptiveThreshold, 0.001f, 0.1f, "%.3f");
+        if (ImGui::InputInt("Min Samples", &state.adaptiveMinSamples)) {
+            if (state.adaptiveMinSamples < 2) state.adaptiveMinSamples = 2;
+            adaptiveChanged = true;
+        }
+    }
+    if (adaptiveChanged) {
+        renderer->SetAdaptiveSampling(state.adaptiveSampling ? state.adaptiveThreshold : 0.0f, state.adaptiveMinSamples);
     }
     
     if (ImGui::InputInt("Max Bounces", &state.maxBounces)) {
         if (state.maxBounces < 1) state.maxBounces = 1;
         renderer->SetMaxBounces(state.maxBounces);
     }
+    if (ImGui::InputInt("Roulette Depth", &state.russianRouletteDepth)) {
+        if (state.russianRouletteDepth < 0) state.russianRouletteDepth = 0;
+        renderer->SetRussianRouletteDepth(state.russianRouletteDepth);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Bounces before low-throughput paths are stopped by Russian roulette.\n0 = off (paths run to Max Bounces)");
+    }
+    if (ImGui::Combo("Sampler", &state.samplerType, "PCG (white noise)\0Sobol (blue noise)\0")) {
+        renderer->SetSamplerType(static_cast<ACG::SamplerType>(state.samplerType));
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Sobol spreads the error of low sample counts as blue noise across pixels");
+    }
+    
+    // Applied by the GPU resolve pass to the preview and to the output image
+    bool toneMapChanged = ImGui::Combo("Tone Mapping", &state.toneMapOperator, "Clamp\0Reinhard\0ACES\0");
+    toneMapChanged |= ImGui::SliderFloat("Exposure (EV)", &state.exposureEV, -5.0f, 5.0f, "%.1f");
+    if (toneMapChanged) {
+        renderer->SetToneMapping(static_cast<ACG::ToneMapOperator>(state.toneMapOperator), state.exposureEV);
+    }
     
     ImGui::Separator();
     ImGui::Text("Lighting");
@@ -380,13 +423,23 @@ void RenderSettingsWindow(ACG::Renderer* renderer, GUIState& state, HWND hwnd) {
     ImGui::SameLine();
     if (ImGui::Button("Browse##Output")) {
         std::string path = SaveFileDialog(hwnd,
-            "PPM Image\0*.ppm\0All Files\0*.*\0\0",
+            "PPM Image\0*.ppm\0OpenEXR Image\0*.exr\0All Files\0*.*\0\0",
             "Save Output Image");
         if (!path.empty()) {
             strncpy_s(state.outputPath, path.c_str(), sizeof(state.outputPath) - 1);
         }
     }
     
+    // Only used for .exr output paths
+    bool exrOptionsChanged = ImGui::Combo("EXR Compression", &state.exrCompression, "ZIP\0PIZ\0");
+    exrOptionsChanged |= ImGui::Checkbox("EXR AOV Layers", &state.exrAovLayers);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Also store the first-hit albedo and normal as EXR layers");
+    }
+    if (exrOptionsChanged) {
+        renderer->SetExrOptions(static_cast<ACG::ExrCompression>(state.exrCompression), state.exrAovLayers);
+    }
+    
     ImGui::Checkbox("Auto-render on load", &state.autoRenderOnLoad);
     
     ImGui::End();
@@ -441,15 +494,13 @@ void RenderControlsWindow(ACG::Renderer* renderer, GUIState& state) {
                 std::cout << "Starting async load and render..." << std::endl;
                 std::cout.flush();
                 
-                // Check if scene needs to be loaded
-                bool needsSceneLoad = (g_lastLoadedScene != modelPathStr);
                 // Environment map needs update if: path changed (including empty->non-empty or non-empty->empty)
                 bool needsEnvMapLoad = (g_lastLoadedEnvMap != envMapPathStr);
                 
                 // Record start time
                 auto startTime = std::chrono::steady_clock::now();
                 
-                g_renderThread = std::make_unique<std::thread>([renderer, modelPathStr, outputPathStr, envMapPathStr, samples, bounces, renderWidth, renderHeight, needsSceneLoad, needsEnvMapLoad, startTime, &state]() {
+                g_renderThread = std::make_unique<std::thread>([renderer, modelPathStr, outputPathStr, envMapPathStr, samples, bounces, renderWidth, renderHeight, needsEnvMapLoad, startTime, &state]() {
                     try {
                         // Set rendering flags at the start
                         g_isRendering.store(true);
@@ -457,23 +508,18 @@ void RenderControlsWindow(ACG::Renderer* renderer, GUIState& state) {
                         g_totalSamples.store(samples);
                         g_currentSample.store(0);
                         
-                        // Only load scene if it hasn't been loaded yet or path changed
-                        if (needsSceneLoad) {
-                            std::cout << "[Async] Loading scene: " << modelPathStr << std::endl;
-                            std::cout.flush();
-                            
-                            auto sceneLoadStart = std::chrono::steady_clock::now();
-                            
-                            // Use Python loader (automatically handles all formats)
-                            renderer->LoadSceneAsync(modelPathStr);
-                            
-                            auto sceneLoadEnd = std::chrono::steady_clock::now();
-                            auto sceneLoadDuration = std::chrono::duration_cast<std::chrono::milliseconds>(sceneLoadEnd - sceneLoadStart);
-                            state.modelLoadTime = sceneLoadDuration.count() / 1000.0f;
-                        } else {
-                            std::cout << "[Async] Using already loaded scene" << std::endl;
-                            std::cout.flush();
-                        }
+                        // Renderer reuses resident GPU resources when the scene file content is unchanged
+                        std::cout << "[Async] Loading scene: " << modelPathStr << std::endl;
+                        std::cout.flush();
+                        
+                        auto sceneLoadStart = std::chrono::steady_clock::now();
+                        
+                        // Use Python loader (automatically handles all formats)
+                        renderer->LoadSceneAsync(modelPathStr);
+                        
+                        auto sceneLoadEnd = std::chrono::steady_clock::now();
+                        auto sceneLoadDuration = std::chrono::duration_cast<std::chrono::milliseconds>(sceneLoadEnd - sceneLoadStart);
+                        state.modelLoadTime = sceneLoadDuration.count() / 1000.0f;
                         
                         // Handle environment map
                         if (envMapPathStr.empty()) {
@@ -538,18 +584,16 @@ void RenderControlsWindow(ACG::Renderer* renderer, GUIState& state) {
                         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
                         state.lastRenderTime = duration.count() / 1000.0f;  // Convert to seconds
                         
-                        // Load rendered image for display
-                        if (LoadPPMToTexture(outputPathStr, renderer, state)) {
-                            std::cout << "Render result loaded for display" << std::endl;
+                        // Load rendered image for display (PPM only; the file is finished in the background)
+                        if (ACG::ImageWriter::GetFileFormat(outputPathStr) == ACG::ImageWriter::FileFormat::PPM) {
+                            renderer->WaitForOutputFiles();
+                            if (LoadPPMToTexture(outputPathStr, renderer, state)) {
+                                std::cout << "Render result loaded for display" << std::endl;
+                            }
                         }
                         
                         std::lock_guard<std::mutex> lock(g_renderMutex);
                         g_renderResultMessage = "Rendering complete!\nOutput saved to:\n" + outputPathStr;
-                        
-                        // Update last loaded scene
-                        if (needsSceneLoad) {
-                            g_lastLoadedScene = modelPathStr;
-                        }
                     }
                     catch (const std::exception& e) {
                         std::lock_guard<std::mutex> lock(g_renderMutex);
@@ -592,6 +636,16 @@ void RenderControlsWindow(ACG::Renderer* renderer, GUIState& state) {
         ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.0f, 1.0f), "Rendering in background...");
     }
     
+    // Live preview keeps accumulating in the window until Samples Per Pixel is reached
+    if (ImGui::Checkbox("Live Preview", &state.interactivePreview)) {
+        renderer->SetInteractivePreview(state.interactivePreview);
+    }
+    if (state.interactivePreview && !g_isRendering.load()) {
+        ImGui::SameLine();
+        int previewSamples = renderer->GetPreviewSamples();
+        ImGui::Text("%d / %d spp", previewSamples < state.samplesPerPixel ? previewSamples : state.samplesPerPixel, state.samplesPerPixel);
+    }
+    
     // Show timing information below Start button
     ImGui::Separator();
     
@@ -776,24 +830,63 @@ void RenderResultWindow(ACG::Renderer* renderer, GUIState& state) {
     ImGui::End();
 }
 
-void RenderLogWindow(const std::vector<std::string>& logMessages) {
+void RenderLogWindow() {
     ImGui::Begin("Log Details");
     
     static bool autoScroll = true;
+    static int shownLevel = static_cast<int>(ACG::LogLevel::Trace);
+    // Copy of the Logger's capped history and the indices passing the level filter
+    static std::vector<ACG::Logger::Line> lines;
+    static uint64_t linesVersion = 0;
+    static std::vector<int> shownLines;
     
     ImGui::Checkbox("Auto-scroll", &autoScroll);
     ImGui::SameLine();
     if (ImGui::Button("Clear")) {
-        // Cannot clear const vector, just skip
+        ACG::Logger::Get().ClearHistory();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100.0f);
+    const bool filterChanged = ImGui::Combo("Level", &shownLevel, "Trace\0Debug\0Info\0Warning\0Error\0");
+    const uint64_t dropped = ACG::Logger::Get().GetDroppedCount();
+    if (dropped > 0) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%llu lines dropped)", static_cast<unsigned long long>(dropped));
+    }
+    
+    // Rebuilt only when lines arrived or the filter changed
+    if (ACG::Logger::Get().CopyHistory(lines, linesVersion) || filterChanged) {
+        shownLines.clear();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (static_cast<int>(lines[i].level) >= shownLevel) {
+                shownLines.push_back(static_cast<int>(i));
+            }
+        }
     }
     
     ImGui::Separator();
     ImGui::BeginChild("LogScrolling", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
     
-    // 显示实际的日志内容
-    for (const auto& msg : logMessages) {
-        ImGui::TextUnformatted(msg.c_str());
+    // 只绘制可见的行
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(shownLines.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            const ACG::Logger::Line& line = lines[shownLines[row]];
+            const bool highlighted = line.level >= ACG::LogLevel::Warning;
+            if (highlighted) {
+                ImGui::PushStyleColor(ImGuiCol_Text, line.level == ACG::LogLevel::Error ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f)
+                                                                                          : ImVec4(1.0f, 0.8f, 0.3f, 1.0f));
+            } else if (line.level < ACG::LogLevel::Info) {
+                ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled));
+            }
+            ImGui::TextUnformatted(line.text.c_str());
+            if (line.level != ACG::LogLevel::Info) {
+                ImGui::PopStyleColor();
+            }
+        }
     }
+    clipper.End();
     
     if (autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
         ImGui::SetScrollHereY(1.0f);
@@ -803,14 +896,124 @@ void RenderLogWindow(const std::vector<std::string>& logMessages) {
     ImGui::End();
 }
 
+void RenderProfilerWindow(ACG::Renderer* renderer, GUIState& state) {
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    
+    const ACG::FrameStats stats = renderer->GetFrameStats();
+    if (stats.width > 0) {
+        ImGui::Text("Last render: %ux%u, %u spp, %.1f ms", stats.width, stats.height, stats.samplesPerPixel, stats.renderMs);
+        ImGui::Text("Camera rays: %.2f M/s (%llu paths)", stats.raysPerSecond / 1.0e6,
+                    static_cast<unsigned long long>(stats.pathSamples));
+    } else {
+        ImGui::Text("No offline render yet");
+    }
+    
+    if (ImGui::BeginTable("Phases", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("Ranges");
+        ImGui::TableHeadersRow();
+        for (uint32_t phase = 0; phase < ACG::RENDER_PHASE_COUNT; ++phase) {
+            const ACG::FrameStats::Phase& timing = stats.phases[phase];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(ACG::Renderer::GetRenderPhaseName(static_cast<ACG::RenderPhase>(phase)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", timing.gpuMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", timing.cpuMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", timing.ranges);
+        }
+        ImGui::EndTable();
+    }
+    
+    if (ImGui::TreeNode("Scene Load (CPU)")) {
+        const ACG::Scene::LoadTimings& load = stats.sceneLoad;
+        ImGui::Text("Conversion: %.1f ms", load.conversionMs);
+        ImGui::Text("Import: %.1f ms", load.importMs);
+        ImGui::Text("  Materials: %.1f ms", load.materialsMs);
+        ImGui::Text("  Textures: %.1f ms", load.texturesMs);
+        ImGui::Text("  Geometry: %.1f ms", load.geometryMs);
+        ImGui::Text("Total: %.1f ms", load.totalMs);
+        ImGui::TreePop();
+    }
+    
+    if (ImGui::TreeNode("Video Memory")) {
+        const ACG::FrameStats::Memory& memory = stats.memory;
+        auto toMB = [](uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+        ImGui::Text("Geometry: %.1f MB", toMB(memory.geometry));
+        ImGui::Text("Textures: %.1f MB", toMB(memory.textures));
+        ImGui::Text("Environment: %.1f MB", toMB(memory.environment));
+        ImGui::Text("Acceleration structures: %.1f MB", toMB(memory.accelerationStructures));
+        ImGui::Text("Render targets: %.1f MB", toMB(memory.renderTargets));
+        ImGui::Text("Other: %.1f MB", toMB(memory.other));
+        ImGui::Separator();
+        ImGui::Text("Process usage: %.1f / %.1f MB budget", toMB(memory.adapterUsage), toMB(memory.adapterBudget));
+        ImGui::TreePop();
+    }
+    
+    // Stats are saved next to the output image (output.ppm -> output.stats.json)
+    static std::string lastSavedPath;
+    if (ImGui::Button("Save JSON")) {
+        std::filesystem::path statsPath = state.outputPath[0] != '\0' ? std::filesystem::path(state.outputPath)
+                                                                         : std::filesystem::path("frame_stats");
+        statsPath.replace_extension(".stats.json");
+        lastSavedPath = renderer->SaveFrameStats(statsPath.string()) ? statsPath.string() : "Failed to write " + statsPath.string();
+    }
+    if (!lastSavedPath.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(lastSavedPath.c_str());
+    }
+    
+    ImGui::End();
+}
+
 // Main GUI rendering function
+void UpdateViewportNavigation(ACG::Renderer* renderer, GUIState& state) {
+    ImGuiIO& io = ImGui::GetIO();
+    ACG::Camera* camera = renderer->GetCamera();
+    if (!camera || g_isRendering.load() || io.WantCaptureMouse || !ImGui::IsMouseDown(ImGuiMouseButton_Right)) {
+        return;
+    }
+    
+    // Camera changes restart the preview accumulation on their own
+    const float rotateSpeed = 0.005f;  // Radians per pixel
+    if (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f) {
+        camera->Rotate(io.MouseDelta.x * rotateSpeed, io.MouseDelta.y * rotateSpeed);
+    }
+    
+    glm::vec3 move(0.0f);
+    if (ImGui::IsKeyDown(ImGuiKey_W)) move += camera->GetDirection();
+    if (ImGui::IsKeyDown(ImGuiKey_S)) move -= camera->GetDirection();
+    if (ImGui::IsKeyDown(ImGuiKey_D)) move += camera->GetRight();
+    if (ImGui::IsKeyDown(ImGuiKey_A)) move -= camera->GetRight();
+    if (ImGui::IsKeyDown(ImGuiKey_E)) move += glm::vec3(0.0f, 1.0f, 0.0f);
+    if (ImGui::IsKeyDown(ImGuiKey_Q)) move -= glm::vec3(0.0f, 1.0f, 0.0f);
+    if (move != glm::vec3(0.0f)) {
+        const float moveSpeed = ImGui::IsKeyDown(ImGuiKey_LeftShift) ? 5.0f : 1.0f;  // Units per second
+        camera->Move(glm::normalize(move) * moveSpeed * io.DeltaTime);
+    }
+    
+    // Orbit sliders in the camera window re-read the new view
+    state.cameraAnglesInitialized = false;
+}
+
 void RenderGUI(ACG::Renderer* renderer, GUIState& state, HWND hwnd) {
     // Initialize environment light on first call
     if (!state.envLightInitialized) {
         renderer->SetEnvironmentLightIntensity(state.envLightIntensity);
+        renderer->SetSamplesPerPixel(state.samplesPerPixel);
+        renderer->SetMaxBounces(state.maxBounces);
+        renderer->SetRussianRouletteDepth(state.russianRouletteDepth);
+        renderer->SetSamplerType(static_cast<ACG::SamplerType>(state.samplerType));
+        renderer->SetInteractivePreview(state.interactivePreview);
         state.envLightInitialized = true;
     }
     
+    UpdateViewportNavigation(renderer, state);
+    
     // Show render status popup
     if (state.showRenderStatus) {
         ImGui::OpenPopup("Render Status");
@@ -828,10 +1031,9 @@ void RenderGUI(ACG::Renderer* renderer, GUIState& state, HWND hwnd) {
     RenderControlsWindow(renderer, state);
     RenderCameraWindow(renderer, state);
     RenderResultWindow(renderer, state);
+    RenderProfilerWindow(renderer, state);
     
-    if (state.pLogMessages) {
-        RenderLogWindow(*state.pLogMessages);
-    }
+    RenderLogWindow();
 }
 
 } // namespace GUI
@@ -0,0 +1,144 @@
+#include "GpuProfiler.h"
+#include "DX12Helper.h"
+#include <iostream>
+
+namespace ACG {
+
+GpuProfiler::GpuProfiler()
+    : m_timestamps(nullptr)
+    , m_frequency(0)
+    , m_maxRanges(0)
+    , m_nextSlot(0)
+    , m_unsubmittedRanges(0)
+    , m_overflowWarned(false)
+{
+}
+
+GpuProfiler::~GpuProfiler() {
+    Shutdown();
+}
+
+void GpuProfiler::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, D3D12_QUERY_HEAP_TYPE type,
+                             UINT phaseCount, UINT maxRanges) {
+    Shutdown();
+
+    ThrowIfFailed(queue->GetTimestampFrequency(&m_frequency), "Failed to query timestamp frequency");
+
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type = type;
+    heapDesc.Count = maxRanges * 2;
+    ThrowIfFailed(device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&m_queryHeap)), "Failed to create timestamp query heap");
+
+    CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(static_cast<UINT64>(heapDesc.Count) * sizeof(UINT64));
+    ThrowIfFailed(device->CreateCommittedResource(
+        &readbackHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_readbackBuffer)
+    ), "Failed to create timestamp readback buffer");
+    m_readbackBuffer->SetName(L"Timestamp Readback");
+
+    // Read only after the fence of a range completed, so the buffer can stay mapped
+    void* mappedData = nullptr;
+    ThrowIfFailed(m_readbackBuffer->Map(0, nullptr, &mappedData), "Failed to map timestamp readback buffer");
+    m_timestamps = static_cast<const UINT64*>(mappedData);
+
+    m_maxRanges = maxRanges;
+    m_phaseMs.assign(phaseCount, 0.0);
+    m_phaseRanges.assign(phaseCount, 0);
+}
+
+void GpuProfiler::Shutdown() {
+    if (m_readbackBuffer) {
+        m_readbackBuffer->Unmap(0, nullptr);
+    }
+    m_readbackBuffer.Reset();
+    m_queryHeap.Reset();
+    m_timestamps = nullptr;
+    m_maxRanges = 0;
+    m_nextSlot = 0;
+    m_ranges.clear();
+    m_unsubmittedRanges = 0;
+    m_overflowWarned = false;
+}
+
+UINT GpuProfiler::BeginRange(ID3D12GraphicsCommandList* cmdList, UINT phase) {
+    if (!m_queryHeap || phase >= m_phaseMs.size()) {
+        return INVALID_RANGE;
+    }
+    if (m_ranges.size() >= m_maxRanges) {
+        Collect();
+        if (m_ranges.size() >= m_maxRanges) {
+            // Every slot belongs to work that has not finished yet: this range goes untimed
+            if (!m_overflowWarned) {
+                std::cerr << "GpuProfiler: all " << m_maxRanges << " query slots in flight, skipping ranges" << std::endl;
+                m_overflowWarned = true;
+            }
+            return INVALID_RANGE;
+        }
+    }
+
+    Range range = {};
+    range.phase = phase;
+    range.slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % m_maxRanges;
+    m_ranges.push_back(range);
+    m_unsubmittedRanges++;
+
+    cmdList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, range.slot * 2);
+    return range.slot;
+}
+
+void GpuProfiler::EndRange(ID3D12GraphicsCommandList* cmdList, UINT range) {
+    if (range == INVALID_RANGE || !m_queryHeap) {
+        return;
+    }
+    cmdList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, range * 2 + 1);
+    cmdList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, range * 2, 2,
+                              m_readbackBuffer.Get(), static_cast<UINT64>(range) * 2 * sizeof(UINT64));
+}
+
+void GpuProfiler::Submit(ID3D12Fence* fence, UINT64 fenceValue) {
+    for (size_t i = m_ranges.size() - m_unsubmittedRanges; i < m_ranges.size(); ++i) {
+        m_ranges[i].fence = fence;
+        m_ranges[i].fenceValue = fenceValue;
+    }
+    m_unsubmittedRanges = 0;
+}
+
+void GpuProfiler::DiscardUnsubmitted() {
+    // Slots are handed out in order, so the newest ones are given back
+    for (; m_unsubmittedRanges > 0; --m_unsubmittedRanges) {
+        m_ranges.pop_back();
+        m_nextSlot = (m_nextSlot + m_maxRanges - 1) % m_maxRanges;
+    }
+}
+
+void GpuProfiler::Collect() {
+    // Submissions on one queue complete in order
+    while (m_ranges.size() > m_unsubmittedRanges) {
+        const Range& range = m_ranges.front();
+        if (range.fence->GetCompletedValue() < range.fenceValue) {
+            break;
+        }
+        const UINT64 begin = m_timestamps[range.slot * 2];
+        const UINT64 end = m_timestamps[range.slot * 2 + 1];
+        if (end > begin && m_frequency > 0) {
+            m_phaseMs[range.phase] += static_cast<double>(end - begin) * 1000.0 / static_cast<double>(m_frequency);
+        }
+        m_phaseRanges[range.phase]++;
+        m_ranges.pop_front();
+    }
+}
+
+void GpuProfiler::ResetPhase(UINT phase) {
+    if (phase < m_phaseMs.size()) {
+        m_phaseMs[phase] = 0.0;
+        m_phaseRanges[phase] = 0;
+    }
+}
+
+} // namespace ACG
@@ -0,0 +1,311 @@
+#include "ImageWriter.h"
+
+#include <OpenEXR/ImfChannelList.h>
+#include <OpenEXR/ImfFrameBuffer.h>
+#include <OpenEXR/ImfHeader.h>
+#include <OpenEXR/ImfOutputFile.h>
+#include <OpenEXR/ImfStdIO.h>
+#include <OpenEXR/ImfThreading.h>
+#include <Imath/ImathVec.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace ACG {
+
+struct ImageWriter::Job {
+    struct Rows {
+        int count;
+        std::vector<uint8_t> rgb;
+        std::vector<float> planes;
+    };
+
+    std::string path;
+    int width = 0;
+    int height = 0;
+    FileFormat format = FileFormat::PPM;
+    bool aovLayers = false;
+    ExrCompression compression = ExrCompression::Zip;
+    std::ofstream file;  // Opened by Begin on the caller's thread
+
+    // Guarded by ImageWriter::m_mutex
+    std::deque<Rows> pendingRows;
+    bool ended = false;
+    bool aborted = false;
+};
+
+ImageWriter::FileFormat ImageWriter::GetFileFormat(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos) {
+        std::string ext = path.substr(dot + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(::tolower(c)); });
+        if (ext == "exr") {
+            return FileFormat::EXR;
+        }
+    }
+    return FileFormat::PPM;
+}
+
+ImageWriter::ImageWriter()
+    : m_shutdown(false)
+    , m_lastJobMs(0.0)
+{
+    // OpenEXR compresses line blocks on its global thread pool
+    Imf::setGlobalThreadCount(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    m_worker = std::thread(&ImageWriter::WorkerLoop, this);
+}
+
+ImageWriter::~ImageWriter() {
+    End();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_workAvailable.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void ImageWriter::Begin(const std::string& path, int width, int height, FileFormat format,
+                        bool aovLayers, ExrCompression compression) {
+    if (width <= 0 || height <= 0) {
+        throw std::runtime_error("Invalid output image size");
+    }
+    End();
+
+    auto job = std::make_shared<Job>();
+    job->path = path;
+    job->width = width;
+    job->height = height;
+    job->format = format;
+    job->aovLayers = format == FileFormat::EXR && aovLayers;
+    job->compression = compression;
+
+    // A job still writing the same file has to finish before the file is reopened
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobFinished.wait(lock, [&]() {
+            return std::none_of(m_jobs.begin(), m_jobs.end(), [&](const std::shared_ptr<Job>& queued) {
+                return queued->path == path;
+            });
+        });
+    }
+
+    job->file.open(path, std::ios::binary);
+    if (!job->file.is_open()) {
+        throw std::runtime_error("Failed to open output file: " + path);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+        m_openJob = job;
+    }
+    m_workAvailable.notify_all();
+}
+
+void ImageWriter::WriteRows(int rows, std::vector<uint8_t> rgb) {
+    QueueRows(rows, &rgb, nullptr);
+}
+
+void ImageWriter::WriteRows(int rows, std::vector<float> planes) {
+    QueueRows(rows, nullptr, &planes);
+}
+
+void ImageWriter::QueueRows(int rows, std::vector<uint8_t>* rgb, std::vector<float>* planes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_openJob) {
+            throw std::runtime_error("ImageWriter::WriteRows called without an open job");
+        }
+        if ((rgb != nullptr) != (m_openJob->format == FileFormat::PPM)) {
+            throw std::runtime_error("ImageWriter::WriteRows data does not match the file format");
+        }
+        Job::Rows queued;
+        queued.count = rows;
+        if (rgb) {
+            queued.rgb = std::move(*rgb);
+        } else {
+            queued.planes = std::move(*planes);
+        }
+        m_openJob->pendingRows.push_back(std::move(queued));
+    }
+    m_workAvailable.notify_all();
+}
+
+void ImageWriter::End() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_openJob) {
+            return;
+        }
+        m_openJob->ended = true;
+        m_openJob.reset();
+    }
+    m_workAvailable.notify_all();
+}
+
+void ImageWriter::Abort() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_openJob) {
+            return;
+        }
+        m_openJob->aborted = true;
+        m_openJob->ended = true;
+        m_openJob.reset();
+    }
+    m_workAvailable.notify_all();
+}
+
+void ImageWriter::WaitIdle() {
+    End();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobFinished.wait(lock, [this]() { return m_jobs.empty(); });
+}
+
+std::string ImageWriter::GetLastError() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastError;
+}
+
+double ImageWriter::GetLastJobMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastJobMs;
+}
+
+void ImageWriter::WorkerLoop() {
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [this]() { return m_shutdown || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                return;  // Shutdown with nothing left to write
+            }
+            job = m_jobs.front();
+        }
+
+        ProcessJob(*job);
+        if (job->aborted) {
+            // Incomplete image
+            if (job->file.is_open()) {
+                job->file.close();
+            }
+            std::remove(job->path.c_str());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.pop_front();
+        }
+        m_jobFinished.notify_all();
+    }
+}
+
+void ImageWriter::ProcessJob(Job& job) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration waitTime(0);  // Idle until the renderer delivered the next rows
+
+    // Waits for the next rows; false once the job has ended and everything was consumed
+    auto nextRows = [&](Job::Rows& rows) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto waitStart = std::chrono::steady_clock::now();
+        m_workAvailable.wait(lock, [&]() { return !job.pendingRows.empty() || job.ended; });
+        waitTime += std::chrono::steady_clock::now() - waitStart;
+        if (job.aborted || job.pendingRows.empty()) {
+            return false;
+        }
+        rows = std::move(job.pendingRows.front());
+        job.pendingRows.pop_front();
+        return true;
+    };
+
+    try {
+        Job::Rows rows;
+        if (job.format == FileFormat::PPM) {
+            job.file << "P6\n" << job.width << " " << job.height << "\n255\n";
+            while (nextRows(rows)) {
+                job.file.write(reinterpret_cast<const char*>(rows.rgb.data()),
+                               static_cast<std::streamsize>(job.width) * rows.count * 3);
+            }
+            job.file.close();
+            if (!job.file) {
+                throw std::runtime_error("Failed to write output file: " + job.path);
+            }
+        } else {
+            Imf::Header header(job.width, job.height);
+            header.compression() = job.compression == ExrCompression::Piz ? Imf::PIZ_COMPRESSION : Imf::ZIP_COMPRESSION;
+
+            // Channel name -> (plane, component) of the queued rows
+            struct ChannelSource {
+                const char* name;
+                int plane;
+                int component;
+            };
+            std::vector<ChannelSource> channels = { { "R", 0, 0 }, { "G", 0, 1 }, { "B", 0, 2 } };
+            if (job.aovLayers) {
+                channels.insert(channels.end(), {
+                    { "albedo.R", 1, 0 }, { "albedo.G", 1, 1 }, { "albedo.B", 1, 2 },
+                    { "normal.X", 2, 0 }, { "normal.Y", 2, 1 }, { "normal.Z", 2, 2 } });
+            }
+            for (const ChannelSource& channel : channels) {
+                header.channels().insert(channel.name, Imf::Channel(Imf::HALF));
+            }
+
+            {
+                Imf::StdOFStream stream(job.file, job.path.c_str());
+                Imf::OutputFile output(stream, header, Imf::globalThreadCount());
+
+                // Rows arrive top to bottom, matching the default INCREASING_Y line order
+                int y = 0;
+                while (nextRows(rows)) {
+                    const size_t planeFloats = static_cast<size_t>(job.width) * rows.count * 3;
+                    Imf::FrameBuffer frameBuffer;
+                    for (const ChannelSource& channel : channels) {
+                        const float* base = rows.planes.data() + channel.plane * planeFloats + channel.component;
+                        frameBuffer.insert(channel.name, Imf::Slice::Make(
+                            Imf::FLOAT, base, Imath::V2i(0, y), job.width, rows.count,
+                            sizeof(float) * 3, sizeof(float) * 3 * job.width));
+                    }
+                    output.setFrameBuffer(frameBuffer);
+                    output.writePixels(rows.count);  // float slices are converted to half channels
+                    y += rows.count;
+                }
+            }  // OutputFile finishes the line offset table here
+            job.file.close();
+            if (!job.file) {
+                throw std::runtime_error("Failed to write output file: " + job.path);
+            }
+        }
+
+        if (job.aborted) {
+            return;
+        }
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_lastJobMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime - waitTime).count();
+        }
+        std::cout << "Image written: " << job.path << " (" << duration.count() << " ms)" << std::endl;
+    } catch (const std::exception& e) {
+        std::string error = std::string("Failed to write image ") + job.path + ": " + e.what();
+        std::cerr << error << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_lastError = error;
+        }
+        // Drop what is still queued, the job ends as usual
+        Job::Rows rows;
+        while (nextRows(rows)) {
+        }
+    }
+}
+
+} // namespace ACG
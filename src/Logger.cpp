@@ -0,0 +1,214 @@
+#include "Logger.h"
+
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+namespace ACG {
+
+// The writer sleeps this long whenever the queue ran empty; lines reach the file and the GUI within it
+static const std::chrono::milliseconds WRITER_INTERVAL(5);
+
+Logger& Logger::Get() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : m_ring(new Slot[RING_CAPACITY])
+    , m_enqueuePos(0)
+    , m_dequeuePos(0)
+    , m_minLevel(static_cast<uint32_t>(LogLevel::Info))
+    , m_dropped(0)
+    , m_running(false)
+    , m_historyVersion(0)
+{
+    for (size_t i = 0; i < RING_CAPACITY; ++i) {
+        m_ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    Stop();
+}
+
+void Logger::Start(const std::string& filePath) {
+    if (m_running.load()) {
+        return;
+    }
+    if (!filePath.empty()) {
+        m_file.open(filePath, std::ios::out | std::ios::trunc);
+        if (!m_file.is_open()) {
+            std::cerr << "Failed to open log file: " << filePath << std::endl;
+        }
+    }
+    m_running.store(true);
+    m_writer = std::thread(&Logger::WriterLoop, this);
+}
+
+void Logger::Stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    // A Write that saw m_running before the exchange can push after the writer's last pass; the
+    // writer is gone, so this thread is the only consumer now
+    std::vector<Line> batch;
+    Line line;
+    while (TryPop(line)) {
+        batch.push_back(std::move(line));
+    }
+    WriteBatch(batch);
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+}
+
+void Logger::Write(LogLevel level, std::string text) {
+    Line line;
+    line.level = level;
+    line.time = std::chrono::system_clock::now();
+    line.text = std::move(text);
+
+    if (!m_running.load(std::memory_order_acquire)) {
+        WriteDirect(line);
+        return;
+    }
+    while (!TryPush(line)) {
+        // Stopped while waiting: nobody will empty the ring any more, so print the line instead
+        if (!m_running.load(std::memory_order_acquire)) {
+            WriteDirect(line);
+            return;
+        }
+        // Full: the hot path never waits for progress messages, but warnings and errors are kept
+        if (level < LogLevel::Warning) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool Logger::TryPush(Line& line) {
+    // Bounded MPMC queue (Vyukov): a slot is free for position pos when its sequence equals pos,
+    // and holds the line of position pos once its sequence is pos + 1
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_ring[pos & (RING_CAPACITY - 1)];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (difference == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.line = std::move(line);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;  // The writer has not consumed this slot of the previous lap yet
+        } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Logger::TryPop(Line& line) {
+    Slot& slot = m_ring[m_dequeuePos & (RING_CAPACITY - 1)];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(m_dequeuePos + 1) < 0) {
+        return false;
+    }
+    line = std::move(slot.line);
+    slot.sequence.store(m_dequeuePos + RING_CAPACITY, std::memory_order_release);
+    m_dequeuePos++;
+    return true;
+}
+
+void Logger::WriterLoop() {
+    std::vector<Line> batch;
+    for (;;) {
+        // Stop() clears m_running after the last Write it has to keep, so one more pass drains the queue
+        const bool running = m_running.load(std::memory_order_acquire);
+        Line line;
+        while (TryPop(line)) {
+            batch.push_back(std::move(line));
+        }
+
+        if (!batch.empty()) {
+            WriteBatch(batch);
+        } else if (!running) {
+            break;
+        } else {
+            std::this_thread::sleep_for(WRITER_INTERVAL);
+        }
+    }
+}
+
+void Logger::WriteBatch(std::vector<Line>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    if (m_file.is_open()) {
+        for (const Line& entry : batch) {
+            const std::time_t time = std::chrono::system_clock::to_time_t(entry.time);
+            struct tm timeinfo;
+            localtime_s(&timeinfo, &time);
+            char timeStr[32];
+            strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
+            m_file << "[" << timeStr << "] ";
+            if (entry.level != LogLevel::Info) {
+                m_file << "[" << GetLevelName(entry.level) << "] ";
+            }
+            m_file << entry.text << '\n';
+        }
+        m_file.flush();
+    }
+
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    for (Line& entry : batch) {
+        m_history.push_back(std::move(entry));
+    }
+    while (m_history.size() > HISTORY_CAPACITY) {
+        m_history.pop_front();
+    }
+    m_historyVersion++;
+    batch.clear();
+}
+
+void Logger::WriteDirect(const Line& line) const {
+    // C stdio, not std::cout / std::cerr: a LogRedirector on those streams would feed the line back into Write
+    std::FILE* stream = line.level >= LogLevel::Warning ? stderr : stdout;
+    std::fwrite(line.text.data(), 1, line.text.size(), stream);
+    std::fputc('\n', stream);
+    std::fflush(stream);
+}
+
+bool Logger::CopyHistory(std::vector<Line>& lines, uint64_t& version) const {
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    if (version == m_historyVersion) {
+        return false;
+    }
+    lines.assign(m_history.begin(), m_history.end());
+    version = m_historyVersion;
+    return true;
+}
+
+void Logger::ClearHistory() {
+    std::lock_guard<std::mutex> lock(m_historyMutex);
+    m_history.clear();
+    m_historyVersion++;
+}
+
+const char* Logger::GetLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "trace";
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warning: return "warning";
+        case LogLevel::Error: return "error";
+    }
+    return "?";
+}
+
+} // namespace ACG
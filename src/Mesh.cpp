@@ -5,6 +5,11 @@ namespace ACG {
 
 Mesh::Mesh() 
     : m_materialIndex(-1)
+    , m_hasPackedRange(false)
+    , m_packedFirstVertex(0)
+    , m_packedFirstIndex(0)
+    , m_packedVertexCount(0)
+    , m_packedIndexCount(0)
     , m_bboxMin(0.0f)
     , m_bboxMax(0.0f)
 {
@@ -21,6 +26,22 @@ void Mesh::SetIndices(const std::vector<uint32_t>& indices) {
     m_indices = indices;
 }
 
+void Mesh::SetPackedRange(uint64_t firstVertex, uint32_t vertexCount, uint64_t firstIndex, uint32_t indexCount) {
+    m_hasPackedRange = true;
+    m_packedFirstVertex = firstVertex;
+    m_packedVertexCount = vertexCount;
+    m_packedFirstIndex = firstIndex;
+    m_packedIndexCount = indexCount;
+}
+
+uint32_t Mesh::GetVertexCount() const {
+    return m_hasPackedRange ? m_packedVertexCount : static_cast<uint32_t>(m_vertices.size());
+}
+
+uint32_t Mesh::GetIndexCount() const {
+    return m_hasPackedRange ? m_packedIndexCount : static_cast<uint32_t>(m_indices.size());
+}
+
 std::shared_ptr<Mesh> Mesh::CreateSphere(float radius, int segments) {
     // TODO: Generate sphere mesh
     auto mesh = std::make_shared<Mesh>();
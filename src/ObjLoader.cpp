@@ -0,0 +1,638 @@
+#include "ObjLoader.h"
+#include "SceneLoader.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace ACG {
+
+namespace {
+
+// 小于此大小的文件不拆分解析任务
+constexpr uint64_t MIN_CHUNK_BYTES = 1 << 20;
+
+/**
+ * @brief Face corner as written in the file
+ * 0 = component absent, otherwise a 1-based global index. Components flagged in
+ * relativeMask hold a chunk-local index (may be negative), resolved once the chunk's base offset is known.
+ */
+struct ObjCorner {
+    int32_t v = 0;
+    int32_t vt = 0;
+    int32_t vn = 0;
+    uint8_t relativeMask = 0;  // bit0 = v, bit1 = vt, bit2 = vn
+};
+
+struct ObjMaterialSpan {
+    std::string material;
+    size_t firstFace;
+};
+
+// 一个解析线程的输出
+struct ObjChunk {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;
+    std::vector<uint32_t> faceStarts;       // 每个面在corners中的起始位置
+    std::vector<ObjMaterialSpan> spans;     // usemtl切换点; 首个span之前的面沿用上一块的材质
+    std::vector<std::string> materialLibs;
+};
+
+struct FaceRange {
+    size_t chunk;
+    size_t firstFace;
+    size_t endFace;
+};
+
+struct ObjMaterialDesc {
+    std::string name;
+    glm::vec3 diffuse = glm::vec3(0.8f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    glm::vec3 emissive = glm::vec3(0.0f);
+    glm::vec3 transmissionFilter = glm::vec3(1.0f);
+    float shininess = 0.0f;
+    float dissolve = 1.0f;
+    float opticalDensity = 1.0f;
+    int illum = 2;
+    bool hasSpecular = false;
+    std::string diffuseMap;
+    std::string normalMap;
+    std::string metallicRoughnessMap;
+    std::string emissionMap;
+};
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* SkipSpaces(const char* p, const char* end) {
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// 不依赖区域设置和结尾'\0'的浮点解析 (映射内存没有终止符)
+const char* ParseFloat(const char* p, const char* end, float& out) {
+    p = SkipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    double value = 0.0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10.0 + (*p - '0');
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value += (*p - '0') * scale;
+            scale *= 0.1;
+            ++p;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = (*p == '-');
+            ++p;
+        }
+        int exponent = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            exponent = exponent * 10 + (*p - '0');
+            ++p;
+        }
+        value *= std::pow(10.0, negativeExponent ? -exponent : exponent);
+    }
+
+    out = static_cast<float>(negative ? -value : value);
+    return p;
+}
+
+const char* ParseInt(const char* p, const char* end, int64_t& out) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    int64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+    out = negative ? -value : value;
+    return p;
+}
+
+// 负数索引相对于当前已读的元素数, 在块内先转换为局部索引 (可能指向之前的块)
+int32_t EncodeIndex(int64_t index, size_t localCount, uint8_t bit, uint8_t& relativeMask) {
+    if (index < 0) {
+        relativeMask |= bit;
+        return static_cast<int32_t>(static_cast<int64_t>(localCount) + index);
+    }
+    return static_cast<int32_t>(index);
+}
+
+std::string TrimmedRest(const char* p, const char* end) {
+    p = SkipSpaces(p, end);
+    while (end > p && IsSpace(end[-1])) {
+        --end;
+    }
+    return std::string(p, end);
+}
+
+bool StartsWithKeyword(const char* p, const char* end, const char* keyword, size_t length) {
+    return static_cast<size_t>(end - p) > length &&
+           std::memcmp(p, keyword, length) == 0 && IsSpace(p[length]);
+}
+
+void ParseChunk(const char* begin, const char* end, ObjChunk& chunk) {
+    const char* line = begin;
+    while (line < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char* p = SkipSpaces(line, lineEnd);
+
+        if (p + 1 < lineEnd && p[0] == 'v' && IsSpace(p[1])) {
+            glm::vec3 position;
+            p = ParseFloat(p + 2, lineEnd, position.x);
+            p = ParseFloat(p, lineEnd, position.y);
+            ParseFloat(p, lineEnd, position.z);
+            chunk.positions.push_back(position);
+        } else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 't' && IsSpace(p[2])) {
+            glm::vec2 texCoord;
+            p = ParseFloat(p + 3, lineEnd, texCoord.x);
+            ParseFloat(p, lineEnd, texCoord.y);
+            chunk.texCoords.push_back(texCoord);
+        } else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2])) {
+            glm::vec3 normal;
+            p = ParseFloat(p + 3, lineEnd, normal.x);
+            p = ParseFloat(p, lineEnd, normal.y);
+            ParseFloat(p, lineEnd, normal.z);
+            chunk.normals.push_back(normal);
+        } else if (p + 1 < lineEnd && p[0] == 'f' && IsSpace(p[1])) {
+            chunk.faceStarts.push_back(static_cast<uint32_t>(chunk.corners.size()));
+            p += 2;
+            while (true) {
+                p = SkipSpaces(p, lineEnd);
+                if (p >= lineEnd || *p == '#') {
+                    break;
+                }
+                ObjCorner corner;
+                int64_t index = 0;
+                p = ParseInt(p, lineEnd, index);
+                corner.v = EncodeIndex(index, chunk.positions.size(), 1, corner.relativeMask);
+                if (p < lineEnd && *p == '/') {
+                    ++p;
+                    if (p < lineEnd && *p != '/') {
+                        p = ParseInt(p, lineEnd, index);
+                        corner.vt = EncodeIndex(index, chunk.texCoords.size(), 2, corner.relativeMask);
+                    }
+                    if (p < lineEnd && *p == '/') {
+                        ++p;
+                        p = ParseInt(p, lineEnd, index);
+                        corner.vn = EncodeIndex(index, chunk.normals.size(), 4, corner.relativeMask);
+                    }
+                }
+                // 跳过无法识别的字符, 避免死循环
+                while (p < lineEnd && !IsSpace(*p)) {
+                    ++p;
+                }
+                chunk.corners.push_back(corner);
+            }
+            if (chunk.corners.size() - chunk.faceStarts.back() < 3) {
+                // 点/线元素不参与渲染
+                chunk.corners.resize(chunk.faceStarts.back());
+                chunk.faceStarts.pop_back();
+            }
+        } else if (StartsWithKeyword(p, lineEnd, "usemtl", 6)) {
+            chunk.spans.push_back({ TrimmedRest(p + 6, lineEnd), chunk.faceStarts.size() });
+        } else if (StartsWithKeyword(p, lineEnd, "mtllib", 6)) {
+            chunk.materialLibs.push_back(TrimmedRest(p + 6, lineEnd));
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+// 纹理选项 (如 "-bm 1.0 file.png") 之后的最后一个字段为文件名
+std::string ResolveTexturePath(const std::string& value, const std::filesystem::path& baseDir) {
+    size_t start = value.find_last_of(" \t");
+    std::string filename = (start == std::string::npos) ? value : value.substr(start + 1);
+    if (filename.empty()) {
+        return "";
+    }
+    std::filesystem::path texPath = baseDir / filename;
+    if (!std::filesystem::exists(texPath)) {
+        std::cerr << "Warning: Texture not found: " << texPath.string() << std::endl;
+        return "";
+    }
+    return std::filesystem::absolute(texPath).lexically_normal().string();
+}
+
+void ParseMaterialLibrary(const std::filesystem::path& mtlPath, std::vector<ObjMaterialDesc>& materials) {
+    std::ifstream file(mtlPath);
+    if (!file.is_open()) {
+        std::cerr << "Warning: Material library not found: " << mtlPath.string() << std::endl;
+        return;
+    }
+
+    std::filesystem::path baseDir = mtlPath.parent_path();
+    ObjMaterialDesc* current = nullptr;
+    std::string line;
+    while (std::getline(file, line)) {
+        // 去掉行内注释 (wavefront_loader.py 会改写MTL文件来实现, 这里解析时直接忽略)
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.resize(comment);
+        }
+        const char* p = SkipSpaces(line.data(), line.data() + line.size());
+        const char* end = line.data() + line.size();
+        if (p >= end) {
+            continue;
+        }
+        const char* keyEnd = p;
+        while (keyEnd < end && !IsSpace(*keyEnd)) {
+            ++keyEnd;
+        }
+        std::string key(p, keyEnd);
+
+        if (key == "newmtl") {
+            materials.emplace_back();
+            current = &materials.back();
+            current->name = TrimmedRest(keyEnd, end);
+            continue;
+        }
+        if (!current) {
+            continue;
+        }
+
+        auto readVec3 = [&](glm::vec3& out) {
+            const char* q = ParseFloat(keyEnd, end, out.x);
+            q = SkipSpaces(q, end);
+            if (q >= end) {
+                out.y = out.z = out.x;  // 单值写法 "Kd 0.5"
+                return;
+            }
+            q = ParseFloat(q, end, out.y);
+            ParseFloat(q, end, out.z);
+        };
+        auto readFloat = [&]() {
+            float value = 0.0f;
+            ParseFloat(keyEnd, end, value);
+            return value;
+        };
+
+        if (key == "Kd") {
+            readVec3(current->diffuse);
+        } else if (key == "Ks") {
+            readVec3(current->specular);
+            current->hasSpecular = true;
+        } else if (key == "Ke") {
+            readVec3(current->emissive);
+        } else if (key == "Tf") {
+            readVec3(current->transmissionFilter);
+        } else if (key == "Ns") {
+            current->shininess = readFloat();
+        } else if (key == "d") {
+            current->dissolve = readFloat();
+        } else if (key == "Tr") {
+            current->dissolve = 1.0f - readFloat();
+        } else if (key == "Ni") {
+            current->opticalDensity = readFloat();
+        } else if (key == "illum") {
+            current->illum = static_cast<int>(readFloat());
+        } else if (key == "map_Kd") {
+            current->diffuseMap = ResolveTexturePath(TrimmedRest(keyEnd, end), baseDir);
+        } else if (key == "norm" || key == "map_Bump" || key == "map_bump" || key == "bump") {
+            current->normalMap = ResolveTexturePath(TrimmedRest(keyEnd, end), baseDir);
+        } else if (key == "map_Pm" || key == "map_Pr") {
+            current->metallicRoughnessMap = ResolveTexturePath(TrimmedRest(keyEnd, end), baseDir);
+        } else if (key == "map_Ke") {
+            current->emissionMap = ResolveTexturePath(TrimmedRest(keyEnd, end), baseDir);
+        }
+    }
+}
+
+// Phong -> PBR 近似, 规则与 wavefront_loader.py::_extract_materials 一致
+std::shared_ptr<Material> ConvertMaterial(const ObjMaterialDesc& desc) {
+    auto material = std::make_shared<Material>();
+    material->SetName(desc.name);
+
+    const bool isMirror = (desc.illum == 5);
+    const bool isGlass = (desc.illum == 7);
+
+    material->SetBaseColor(isMirror && desc.hasSpecular ? desc.specular : desc.diffuse);
+
+    float specIntensity = (desc.specular.r + desc.specular.g + desc.specular.b) / 3.0f;
+    bool hasSpecular = desc.hasSpecular && specIntensity > 0.01f;
+    if (desc.hasSpecular) {
+        if (isMirror) {
+            material->SetMetallic(1.0f);
+        } else if (specIntensity > 0.5f) {
+            material->SetMetallic(std::min(specIntensity, 1.0f));
+        }
+    }
+
+    if (isMirror) {
+        material->SetRoughness(0.0f);
+    } else if (!hasSpecular) {
+        material->SetRoughness(1.0f);
+    } else if (desc.shininess > 0.0f) {
+        material->SetSpecularExponent(desc.shininess);
+    } else {
+        material->SetRoughness(1.0f);
+    }
+
+    material->SetEmission(desc.emissive);
+
+    float transmissionStrength = 0.0f;
+    if (isGlass) {
+        material->SetOpacity(0.1f);
+        transmissionStrength = 0.9f;
+    } else {
+        material->SetOpacity(desc.dissolve);
+        if (desc.dissolve < 0.99f) {
+            transmissionStrength = 1.0f - desc.dissolve;
+        }
+    }
+    if (transmissionStrength > 0.0f) {
+        TransmissionLayer layer;
+        layer.strength = transmissionStrength;
+        layer.roughness = material->GetRoughness();
+        layer.depth = 0.0f;
+        layer.textureIdx = -1;
+        layer.color = desc.transmissionFilter;
+        material->SetTransmissionLayer(layer);
+    }
+
+    if (desc.opticalDensity > 1.0f) {
+        material->SetIOR(desc.opticalDensity);
+    }
+    return material;
+}
+
+struct CornerKey {
+    uint32_t v, vt, vn;
+    bool operator==(const CornerKey& other) const {
+        return v == other.v && vt == other.vt && vn == other.vn;
+    }
+};
+
+struct CornerKeyHash {
+    size_t operator()(const CornerKey& key) const {
+        uint64_t h = key.v * 0x9E3779B97F4A7C15ULL;
+        h ^= (key.vt + 0x7F4A7C15ULL) * 0xC2B2AE3D27D4EB4FULL;
+        h ^= (key.vn + 0x165667B1ULL) * 0x165667B19E3779F9ULL;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+constexpr uint32_t NO_INDEX = 0xFFFFFFFFu;
+
+} // namespace
+
+bool ObjLoader::CanLoad(const std::string& filepath) {
+    std::string extension = std::filesystem::path(filepath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".obj";
+}
+
+std::unique_ptr<Scene> ObjLoader::Load(const std::string& filepath) {
+    MappedFile mapped;
+    if (!mapped.Open(filepath)) {
+        throw std::runtime_error("Failed to open OBJ file: " + filepath);
+    }
+    const char* data = reinterpret_cast<const char*>(mapped.GetData());
+    const uint64_t size = mapped.GetSize();
+
+    // 1. 按行边界切块并行解析
+    size_t chunkCount = static_cast<size_t>(std::min<uint64_t>(
+        std::max(1u, std::thread::hardware_concurrency()) * 4, size / MIN_CHUNK_BYTES + 1));
+    std::vector<const char*> bounds(chunkCount + 1);
+    bounds[0] = data;
+    bounds[chunkCount] = data + size;
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const char* p = std::max(bounds[i - 1], data + size * i / chunkCount);
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', data + size - p));
+        bounds[i] = newline ? newline + 1 : data + size;
+    }
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    ParallelFor(chunkCount, [&](size_t i) {
+        ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    // 2. 合并顶点属性, 块内局部索引需要加上之前各块的数量
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<size_t> positionBase(chunkCount), texCoordBase(chunkCount), normalBase(chunkCount);
+    {
+        size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+        for (size_t i = 0; i < chunkCount; ++i) {
+            positionBase[i] = positionCount;
+            texCoordBase[i] = texCoordCount;
+            normalBase[i] = normalCount;
+            positionCount += chunks[i].positions.size();
+            texCoordCount += chunks[i].texCoords.size();
+            normalCount += chunks[i].normals.size();
+        }
+        positions.reserve(positionCount);
+        texCoords.reserve(texCoordCount);
+        normals.reserve(normalCount);
+        for (auto& chunk : chunks) {
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            std::vector<glm::vec3>().swap(chunk.positions);
+            std::vector<glm::vec2>().swap(chunk.texCoords);
+            std::vector<glm::vec3>().swap(chunk.normals);
+        }
+    }
+
+    // 转换为0基全局索引, 越界时报错
+    ParallelFor(chunkCount, [&](size_t i) {
+        auto resolve = [](int32_t encoded, bool relative, size_t base, size_t count, const char* what) -> uint32_t {
+            if (!relative && encoded == 0) {
+                return NO_INDEX;
+            }
+            int64_t index = relative ? static_cast<int64_t>(base) + encoded : static_cast<int64_t>(encoded) - 1;
+            if (index < 0 || static_cast<uint64_t>(index) >= count) {
+                throw std::runtime_error(std::string("OBJ face references missing ") + what);
+            }
+            return static_cast<uint32_t>(index);
+        };
+        for (auto& corner : chunks[i].corners) {
+            if (!(corner.relativeMask & 1) && corner.v == 0) {
+                throw std::runtime_error("OBJ face corner has no vertex index");
+            }
+            corner.v = static_cast<int32_t>(resolve(corner.v, (corner.relativeMask & 1) != 0, positionBase[i], positions.size(), "vertex"));
+            corner.vt = static_cast<int32_t>(resolve(corner.vt, (corner.relativeMask & 2) != 0, texCoordBase[i], texCoords.size(), "texcoord"));
+            corner.vn = static_cast<int32_t>(resolve(corner.vn, (corner.relativeMask & 4) != 0, normalBase[i], normals.size(), "normal"));
+        }
+    });
+
+    // 3. 材质库
+    std::filesystem::path objDir = std::filesystem::path(filepath).parent_path();
+    auto scene = std::make_unique<Scene>();
+    std::vector<ObjMaterialDesc> materialDescs;
+    for (const auto& chunk : chunks) {
+        for (const auto& lib : chunk.materialLibs) {
+            ParseMaterialLibrary(objDir / lib, materialDescs);
+            scene->AddSourceFile((objDir / lib).string());
+        }
+    }
+    if (materialDescs.empty()) {
+        std::cerr << "Warning: No materials found in OBJ file, adding default material" << std::endl;
+        materialDescs.emplace_back();
+        materialDescs.back().name = "default";
+    }
+
+    std::unordered_map<std::string, uint32_t> materialMap;
+    std::vector<std::string> texturePaths;
+    std::unordered_map<std::string, int32_t> textureMap;
+    std::vector<std::array<int32_t, 4>> materialTexIndices;
+    auto addTexture = [&](const std::string& path) -> int32_t {
+        if (path.empty()) {
+            return -1;
+        }
+        auto it = textureMap.find(path);
+        if (it != textureMap.end()) {
+            return it->second;
+        }
+        int32_t index = static_cast<int32_t>(texturePaths.size());
+        textureMap.emplace(path, index);
+        texturePaths.push_back(path);
+        return index;
+    };
+    for (const auto& desc : materialDescs) {
+        materialMap.emplace(desc.name, static_cast<uint32_t>(materialMap.size()));
+        scene->AddMaterial(ConvertMaterial(desc));
+        materialTexIndices.push_back({ addTexture(desc.diffuseMap), addTexture(desc.normalMap),
+                                       addTexture(desc.metallicRoughnessMap), addTexture(desc.emissionMap) });
+    }
+
+    std::vector<std::shared_ptr<Texture>> textures;
+    SceneLoader::LoadTextureFiles(scene.get(), texturePaths, textures);
+    SceneLoader::BindMaterialTextures(scene.get(), textures, materialTexIndices);
+
+    // 4. 按材质分组面 (usemtl的状态跨块延续; 未知材质归入0号, 与Python加载器一致)
+    std::vector<std::vector<FaceRange>> materialFaces(materialDescs.size());
+    uint32_t currentMaterial = 0;
+    for (size_t c = 0; c < chunkCount; ++c) {
+        const ObjChunk& chunk = chunks[c];
+        size_t faceCursor = 0;
+        for (const auto& span : chunk.spans) {
+            if (span.firstFace > faceCursor) {
+                materialFaces[currentMaterial].push_back({ c, faceCursor, span.firstFace });
+            }
+            auto it = materialMap.find(span.material);
+            currentMaterial = (it != materialMap.end()) ? it->second : 0;
+            faceCursor = span.firstFace;
+        }
+        if (chunk.faceStarts.size() > faceCursor) {
+            materialFaces[currentMaterial].push_back({ c, faceCursor, chunk.faceStarts.size() });
+        }
+    }
+
+    // 5. 每个材质并行构建一个网格
+    std::vector<std::shared_ptr<Mesh>> meshes(materialDescs.size());
+    ParallelFor(materialDescs.size(), [&](size_t m) {
+        if (materialFaces[m].empty()) {
+            return;
+        }
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::unordered_map<CornerKey, uint32_t, CornerKeyHash> vertexMap;
+
+        auto makeVertex = [&](const ObjCorner& corner) {
+            Vertex vertex;
+            vertex.position = positions[corner.v];
+            vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+            vertex.texCoord = (static_cast<uint32_t>(corner.vt) != NO_INDEX) ? texCoords[corner.vt] : glm::vec2(0.0f);
+            vertex.tangent = glm::vec3(1.0f, 0.0f, 0.0f);  // OBJ不提供切线
+            return vertex;
+        };
+
+        for (const FaceRange& range : materialFaces[m]) {
+            const ObjChunk& chunk = chunks[range.chunk];
+            for (size_t f = range.firstFace; f < range.endFace; ++f) {
+                size_t cornerBegin = chunk.faceStarts[f];
+                size_t cornerEnd = (f + 1 < chunk.faceStarts.size()) ? chunk.faceStarts[f + 1] : chunk.corners.size();
+
+                // 多边形按扇形三角化
+                for (size_t k = cornerBegin + 1; k + 1 < cornerEnd; ++k) {
+                    const ObjCorner* tri[3] = { &chunk.corners[cornerBegin], &chunk.corners[k], &chunk.corners[k + 1] };
+                    glm::vec3 faceNormal = glm::cross(positions[tri[1]->v] - positions[tri[0]->v],
+                                                      positions[tri[2]->v] - positions[tri[0]->v]);
+                    float faceNormalLength = glm::length(faceNormal);
+                    faceNormal = faceNormalLength > 1e-6f ? faceNormal / faceNormalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+                    for (const ObjCorner* corner : tri) {
+                        if (static_cast<uint32_t>(corner->vn) == NO_INDEX) {
+                            // 无法线: 使用面法线且不与其他面共享顶点
+                            Vertex vertex = makeVertex(*corner);
+                            vertex.normal = faceNormal;
+                            indices.push_back(static_cast<uint32_t>(vertices.size()));
+                            vertices.push_back(vertex);
+                            continue;
+                        }
+                        CornerKey key = { static_cast<uint32_t>(corner->v), static_cast<uint32_t>(corner->vt),
+                                          static_cast<uint32_t>(corner->vn) };
+                        auto inserted = vertexMap.emplace(key, static_cast<uint32_t>(vertices.size()));
+                        if (inserted.second) {
+                            Vertex vertex = makeVertex(*corner);
+                            vertex.normal = normals[corner->vn];
+                            vertices.push_back(vertex);
+                        }
+                        indices.push_back(inserted.first->second);
+                    }
+                }
+            }
+        }
+        if (indices.empty()) {
+            return;
+        }
+
+        auto mesh = std::make_shared<Mesh>();
+        mesh->SetName(materialDescs[m].name);
+        mesh->SetMaterialIndex(static_cast<int>(m));
+        mesh->SetVertices(vertices);
+        mesh->SetIndices(indices);
+        mesh->ComputeBoundingBox();
+        meshes[m] = mesh;
+    });
+
+    for (auto& mesh : meshes) {
+        if (mesh) {
+            scene->AddMesh(mesh);
+        }
+    }
+
+    std::cout << "[OBJ] Parsed " << positions.size() << " positions in " << chunkCount
+              << " chunks, " << scene->GetMeshes().size() << " meshes, "
+              << texturePaths.size() << " unique textures" << std::endl;
+    return scene;
+}
+
+} // namespace ACG
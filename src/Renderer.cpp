@@ -1,10 +1,17 @@
 #include "Renderer.h"
 #include "DX12Helper.h"
+#include "Logger.h"
+#include "Parallel.h"
+#include "Sampler.h"
+#include "ShaderCache.h"
+#include "ScopedTimer.h"
+#include "TextureCompression.h"
 #include "imgui.h"
 #include "imgui_impl_dx12.h"
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <thread>
 #include <chrono>
 #include <dxcapi.h>
@@ -13,6 +20,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <cstddef>
+#include <cwchar>
+#include <deque>
+#include <filesystem>
+#include <DirectXPackedVector.h>
 
 // PIX support for GPU debugging (DEBUG only)
 #if defined(_DEBUG) && defined(USE_PIX)
@@ -38,11 +52,221 @@
 
 namespace ACG {
 
+    // 所有场景纹理共用一种格式: BC7保留RGBA全部通道, 任意用途的贴图都可用同一种采样方式
+    static const BlockFormat TEXTURE_FORMAT = BlockFormat::BC7;
+
+    // Texture descriptors follow the fixed slots of the shader-visible heap (m_srvIndex_Textures onward);
+    // larger texture sets go through the virtual texture system
+    static const UINT MAX_BINDLESS_TEXTURES = 8192;
+    static const int MAX_TEXTURES_PER_BATCH = 64;
+
+    // GPU mip generation views after the bindless range: per pass the SRV of level N-1, then the UAV of level N
+    static const UINT MIP_VIEW_DESCRIPTORS = 32;
+    static const UINT MIPMAP_GROUP_SIZE = 8;  // Must match numthreads in Mipmap.hlsl
+
+    // Serialized ID3D12PipelineLibrary in the shader cache directory (compute pipelines only:
+    // DXR state objects cannot be stored in a library, their DXIL comes from the shader cache)
+    static const char* PIPELINE_LIBRARY_FILE = "pipelines.bin";
+    // Additional adapters (multi-GPU) keep their own library, a shared one would be rebuilt by every device
+    static std::string GetPipelineLibraryFile(UINT adapterIndex) {
+        return adapterIndex == 0 ? PIPELINE_LIBRARY_FILE : "pipelines_adapter" + std::to_string(adapterIndex) + ".bin";
+    }
+
+    // GPU size of a scene texture: mip 0 in whole 4x4 blocks (required for BC resources), then a full
+    // chain with the level sizes of Texture::GenerateMipmaps
+    struct TextureExtent {
+        UINT width;
+        UINT height;
+        UINT mipLevels;
+    };
+
+    static TextureExtent GetTextureExtent(const Texture& texture, float scale) {
+        const UINT maxDimension = D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION;
+        UINT width = static_cast<UINT>(std::max(1.0f, std::round(texture.GetWidth() * scale)));
+        UINT height = static_cast<UINT>(std::max(1.0f, std::round(texture.GetHeight() * scale)));
+        width = std::min((width + 3) & ~3u, maxDimension);
+        height = std::min((height + 3) & ~3u, maxDimension);
+        UINT mipLevels = 1 + static_cast<UINT>(std::floor(std::log2(static_cast<float>(std::max(width, height)))));
+        return { width, height, mipLevels };
+    }
+
+    static size_t GetTextureChainSize(const TextureExtent& extent) {
+        return TextureCompressor::GetCompressedChainSize(TEXTURE_FORMAT, extent.width, extent.height, extent.mipLevels);
+    }
+
+    // Bilinear resample of an 8-bit texture to RGBA8; grayscale is expanded, missing alpha is 255
+    static std::vector<BYTE> ResampleRGBA8(const Texture& texture, UINT dstWidth, UINT dstHeight) {
+        const unsigned char* srcData = texture.GetRawData();
+        const int srcWidth = texture.GetWidth();
+        const int srcHeight = texture.GetHeight();
+        const int srcChannels = texture.GetChannels();
+        std::vector<BYTE> rgba(static_cast<size_t>(dstWidth) * dstHeight * 4, 0);
+        for (UINT y = 0; y < dstHeight; ++y) {
+            for (UINT x = 0; x < dstWidth; ++x) {
+                // Calculate source coordinates (bilinear interpolation)
+                float srcX = (static_cast<float>(x) + 0.5f) * srcWidth / dstWidth - 0.5f;
+                float srcY = (static_cast<float>(y) + 0.5f) * srcHeight / dstHeight - 0.5f;
+                
+                int x0 = static_cast<int>(std::floor(srcX));
+                int y0 = static_cast<int>(std::floor(srcY));
+                int x1 = std::min(x0 + 1, srcWidth - 1);
+                int y1 = std::min(y0 + 1, srcHeight - 1);
+                x0 = std::max(x0, 0);
+                y0 = std::max(y0, 0);
+                
+                float fx = srcX - x0;
+                float fy = srcY - y0;
+                
+                // Sample 4 neighboring pixels
+                for (int c = 0; c < 4; ++c) {
+                    float val00, val10, val01, val11;
+                    
+                    if (c < srcChannels || (srcChannels == 1 && c < 3)) {
+                        // Own channel, or grayscale replicated to RGB
+                        int channel = c < srcChannels ? c : 0;
+                        val00 = srcData[(y0 * srcWidth + x0) * srcChannels + channel];
+                        val10 = srcData[(y0 * srcWidth + x1) * srcChannels + channel];
+                        val01 = srcData[(y1 * srcWidth + x0) * srcChannels + channel];
+                        val11 = srcData[(y1 * srcWidth + x1) * srcChannels + channel];
+                    } else if (c == 3) {
+                        // Alpha channel
+                        val00 = val10 = val01 = val11 = 255.0f;
+                    } else {
+                        val00 = val10 = val01 = val11 = 0.0f;
+                    }
+                    
+                    // Bilinear interpolation
+                    float val0 = val00 * (1.0f - fx) + val10 * fx;
+                    float val1 = val01 * (1.0f - fx) + val11 * fx;
+                    float val = val0 * (1.0f - fy) + val1 * fy;
+                    
+                    rgba[(static_cast<size_t>(y) * dstWidth + x) * 4 + c] = static_cast<BYTE>(std::min(std::max(val, 0.0f), 255.0f));
+                }
+            }
+        }
+        return rgba;
+    }
+    
+    // Staging ring for texture and tile uploads; a texture batch uses at most half of it
+    static const UINT64 UPLOAD_RING_SIZE = 256ull * 1024 * 1024;
+
+    // Bucket rendering: frames above BUCKET_AUTO_PIXELS are split into DEFAULT_BUCKET_SIZE tiles,
+    // each rendered with BUCKET_DENOISE_OVERLAP extra pixels per side for the denoiser
+    static const UINT64 BUCKET_AUTO_PIXELS = 4096ull * 4096;
+    static const UINT DEFAULT_BUCKET_SIZE = 1024;
+    static const UINT BUCKET_DENOISE_OVERLAP = 32;
+    // With several GPUs every frame is bucketed, small enough that the buckets balance across devices
+    static const UINT MULTI_GPU_BUCKET_SIZE = 256;
+
+    // Miss shader table entries: radiance rays use index 0, shadow rays index 1
+    static const UINT SBT_MISS_SHADER_COUNT = 2;
+
+    // Hit groups of Raytracing.hlsl: the first four are indexed by material class (MATERIAL_CLASS_*), then
+    // the ClosestHit uber shader for meshes with several materials and the alpha-tested groups.
+    // Each BLAS slot gets a radiance and a shadow record: identifier + MaterialData
+    struct HitGroupExports {
+        const wchar_t* hitGroup;
+        const wchar_t* closestHit;  // nullptr = none
+        const wchar_t* anyHit;
+    };
+    static const HitGroupExports HIT_GROUPS[] = {
+        { L"HitGroupEmissive", L"ClosestHitEmissive", nullptr },
+        { L"HitGroupTransmission", L"ClosestHitTransmission", nullptr },
+        { L"HitGroupMirror", L"ClosestHitMirror", nullptr },
+        { L"HitGroupDiffuse", L"ClosestHitDiffuse", nullptr },
+        { L"HitGroup", L"ClosestHit", nullptr },
+        { L"HitGroupAlphaTest", L"ClosestHit", L"AnyHitAlphaTest" },
+        { L"ShadowHitGroupAlphaTest", nullptr, L"ShadowAnyHitAlphaTest" } };
+    static const UINT HIT_GROUP_MIXED = 4;
+    static const UINT HIT_GROUP_ALPHA_TEST = 5;
+    static const UINT HIT_GROUP_SHADOW_ALPHA_TEST = 6;
+    // Records per BLAS slot (HIT_GROUP_RADIANCE / HIT_GROUP_SHADOW in Raytracing.hlsl); opaque meshes
+    // use a null shadow record, shadow rays skip closest hit so nothing runs for them
+    static const UINT SBT_RAY_TYPE_COUNT = 2;
+
+    // Per-instance material table entry flag (INSTANCE_MATERIAL_PER_FACE in Raytracing.hlsl):
+    // the low bits are an offset into the per-face material buffer instead of a material id
+    static const uint32_t INSTANCE_MATERIAL_PER_FACE = 0x80000000u;
+
+    // Blue-noise dither tile of the Sobol sampler (BLUE_NOISE_SIZE / BLUE_NOISE_RANK_SHIFT in Raytracing.hlsl)
+    static const uint32_t BLUE_NOISE_TILE_SIZE = 64;
+
+    // Same encoding as EncodeOctahedral in Raytracing.hlsl: two unorm16, x in the low half
+    static uint32_t EncodeOctahedralNormal(const float normal[3]) {
+        float length1 = std::max(std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]), 1e-20f);
+        float x = normal[0] / length1;
+        float y = normal[1] / length1;
+        if (normal[2] < 0.0f) {
+            float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        auto quantize = [](float e) {
+            return static_cast<uint32_t>(std::round(std::min(std::max(e * 0.5f + 0.5f, 0.0f), 1.0f) * 65535.0f));
+        };
+        return quantize(x) | (quantize(y) << 16);
+    }
+
+    // Same tests and order as GetMaterialClass in Raytracing.hlsl
+    static UINT GetMaterialClass(const MaterialData& material) {
+        glm::vec3 emission = material.GetEmission();
+        if (emission.r + emission.g + emission.b > 0.01f) return 0;
+        if ((material.GetLayerFlags() & LAYER_TRANSMISSION) != 0) return 1;
+        if (material.GetMetallic() > 0.9f && material.GetRoughness() < 0.1f) return 2;
+        return 3;
+    }
+
+    // Interactive preview: samples traced per frame, and the accumulation length up to which
+    // newly streamed virtual texture tiles restart it (fallback colors would otherwise persist)
+    static const int PREVIEW_SAMPLES_PER_FRAME = 1;
+    static const int PREVIEW_VT_RESTART_SAMPLES = 16;
+
+    // Profiler phase ids are the RenderPhase values
+    static UINT PhaseIndex(RenderPhase phase) {
+        return static_cast<UINT>(phase);
+    }
+
+    // Video memory held by a resource; upload/readback heaps live in system memory and reserved
+    // resources (virtual textures, counted through their tile pool) have no memory of their own
+    static UINT64 GetDeviceLocalBytes(ID3D12Device* device, ID3D12Resource* resource) {
+        if (!resource) {
+            return 0;
+        }
+        D3D12_HEAP_PROPERTIES heapProperties = {};
+        if (FAILED(resource->GetHeapProperties(&heapProperties, nullptr)) || heapProperties.Type != D3D12_HEAP_TYPE_DEFAULT) {
+            return 0;
+        }
+        D3D12_RESOURCE_DESC desc = resource->GetDesc();
+        return device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+    }
+
+    // CPU version of the resolve pass display transform (shaders/Resolve.hlsl), used for denoised buckets
+    static float ApplyToneMapping(float value, ToneMapOperator op, float exposure) {
+        value *= exposure;
+        if (op == ToneMapOperator::Reinhard) {
+            value = value / (1.0f + value);
+        } else if (op == ToneMapOperator::ACES) {
+            value = (value * (2.51f * value + 0.03f)) / (value * (2.43f * value + 0.59f) + 0.14f);
+        }
+        return std::min(1.0f, std::max(0.0f, value));
+    }
+
+    // Rounds like the resolve pass's store to a UNORM target, so CPU and GPU buckets match to the bit
+    static uint8_t ToneMapToUnorm8(float value, ToneMapOperator op, float exposure) {
+        return static_cast<uint8_t>(ApplyToneMapping(value, op, exposure) * 255.0f + 0.5f);
+    }
+
     Renderer::Renderer(UINT width, UINT height) :
         m_width(width),
         m_height(height),
         m_frameIndex(0),
         m_fenceValue(0),
+        m_copyAllocatorSubmissions{ 0, 0 },
+        m_copyAllocatorIndex(0),
+        m_copyFenceValue(0),
+        m_copyFenceWaited(0),
+        m_geometryCopyFenceValue(0),
         m_rtvDescriptorSize(0),
         m_hwnd(nullptr),
         m_dxrSupported(false),
@@ -57,13 +281,12 @@ namespace ACG {
         m_offlineFenceValue(0),
         m_offlineFenceEvent(nullptr),
         m_stopRenderRequested(false),
-        m_useVirtualTextures(false)
+        m_useVirtualTextures(false),
+        m_tlasInstanceCount(0),
+        m_mappedInstanceDescs(nullptr)
     {
-        // 初始化OIDN降噪器
+        // OIDN降噪器在 OnInit 中选定适配器后初始化
         m_denoiser = std::make_unique<Denoiser>();
-        if (!m_denoiser->Initialize()) {
-            std::cerr << "Warning: Failed to initialize denoiser: " << m_denoiser->GetError() << std::endl;
-        }
     }
 
     Renderer::~Renderer() {
@@ -76,19 +299,62 @@ namespace ACG {
     void Renderer::OnInit(HWND hwnd) {
         m_hwnd = hwnd;
         InitPipeline(hwnd);
+
+        // 初始化OIDN降噪器: 优先使用与渲染相同的GPU
+        DXGI_ADAPTER_DESC1 adapterDesc = {};
+        m_adapter->GetDesc1(&adapterDesc);
+        if (!m_denoiser->Initialize(reinterpret_cast<const uint8_t*>(&adapterDesc.AdapterLuid))) {
+            std::cerr << "Warning: Failed to initialize denoiser: " << m_denoiser->GetError() << std::endl;
+        }
+
         CheckRaytracingSupport();
         if (m_dxrSupported) {
+            OpenPipelineLibrary();
             CreateRaytracingPipeline();
+            CreateResolvePipeline();
+            CreateEnvironmentCdfPipeline();
+            CreateMipmapPipeline();
+            SavePipelineLibrary();
         } else {
             std::cerr << "WARNING: DirectX Raytracing is not supported on this device!" << std::endl;
             std::cerr << "The application will run without ray tracing." << std::endl;
         }
+
+        if (m_multiGpu && m_dxrSupported) {
+            CreatePeerRenderers();
+        }
+    }
+
+    bool Renderer::IsSceneResident(const std::string& path, uint64_t contentHash) const {
+        // Same file content as the last successful load, GPU resources still alive, and the material
+        // libraries and textures it referenced unchanged on disk
+        return m_scene && m_topLevelAS && contentHash != 0 &&
+               contentHash == m_residentSceneHash && path == m_residentScenePath &&
+               Scene::ComputeFileStamp(m_scene->GetSourceFiles()) == m_residentSourceFilesStamp;
     }
 
     void Renderer::LoadScene(const std::string& path) {
+        std::lock_guard<std::mutex> sceneLock(m_sceneMutex);
+        m_previewResetRequested = true;
         try {
+            uint64_t contentHash = Scene::ComputeFileHash(path);
+            m_lastLoadReused = IsSceneResident(path, contentHash);
+            if (m_lastLoadReused) {
+                std::cout << "Scene unchanged, reusing resident GPU resources" << std::endl;
+                return;
+            }
+            m_residentSceneHash = 0;
+            m_gpuProfiler.DiscardUnsubmitted();  // Ranges of lists abandoned by a failed load
+            m_copyProfiler.DiscardUnsubmitted();
+            ResetPhaseStats(RenderPhase::AccelerationStructureBuild);
+            ResetPhaseStats(RenderPhase::TextureUpload);
+            
+            // Compressed textures are cached next to the scene file
+            TextureCompressor::SetCacheDirectory(TextureCompressor::GetCacheDirectoryForScene(path));
+            
             m_scene = std::make_unique<Scene>();
             m_scene->LoadFromFile(path);
+            m_workStats.sceneLoad = m_scene->GetLoadTimings();
             
             // Prepare command list for resource creation
             WaitForGpu(); // Ensure GPU is idle
@@ -100,13 +366,23 @@ namespace ACG {
             CreateAccelerationStructures(m_commandList.Get());
             CreateShaderBindingTable();
             
-            // Execute and wait
+            // Execute and wait (BLAS builds read the geometry copied on the copy queue)
             ThrowIfFailed(m_commandList->Close(), "Failed to close command list");
+            QueueWaitForCopies(m_geometryCopyFenceValue);
             ID3D12CommandList* lists[] = { m_commandList.Get() };
             m_commandQueue->ExecuteCommandLists(1, lists);
+            m_gpuProfiler.Submit(m_fence.Get(), m_fenceValue);  // The value WaitForGpu signals
             WaitForGpu();
             
+            // Compact BLAS now that their sizes are known, then drop the scratch pool
+            CompactBottomLevelAS();
+            
+            m_residentScenePath = path;
+            m_residentSceneHash = contentHash;
+            m_residentSourceFilesStamp = Scene::ComputeFileStamp(m_scene->GetSourceFiles());
+            PublishFrameStats();
             std::cout << "Scene loaded successfully" << std::endl;
+            LoadPeerScenes(path);
         } catch (const std::runtime_error& e) {
             std::cerr << "Failed to load scene: " << e.what() << std::endl;
             throw;
@@ -120,7 +396,28 @@ namespace ACG {
     }
 
     void Renderer::LoadSceneAsync(const std::string& path) {
+        std::lock_guard<std::mutex> sceneLock(m_sceneMutex);
+        m_previewResetRequested = true;
         try {
+            // Skip the whole reload (parse, upload, AS build) when the file content is unchanged,
+            // e.g. re-rendering the same scene with a different camera or environment map
+            uint64_t contentHash = Scene::ComputeFileHash(path);
+            m_lastLoadReused = IsSceneResident(path, contentHash);
+            if (m_lastLoadReused) {
+                char hashStr[32];
+                sprintf_s(hashStr, "%016llX", static_cast<unsigned long long>(contentHash));
+                std::cout << "[Async] Scene unchanged (hash " << hashStr 
+                          << "), reusing resident buffers, textures and acceleration structures" << std::endl;
+                std::cout.flush();
+                return;
+            }
+            m_residentSceneHash = 0;
+            m_gpuProfiler.DiscardUnsubmitted();  // Ranges of lists abandoned by a failed load
+            m_copyProfiler.DiscardUnsubmitted();
+            ResetPhaseStats(RenderPhase::AccelerationStructureBuild);
+            ResetPhaseStats(RenderPhase::TextureUpload);
+            TextureCompressor::SetCacheDirectory(TextureCompressor::GetCacheDirectoryForScene(path));
+            
             std::cout << "[Async] Loading scene from file..." << std::endl;
             std::cout.flush();
             
@@ -130,6 +427,7 @@ namespace ACG {
             if (!loadSuccess) {
                 throw std::runtime_error("Scene loading failed");
             }
+            m_workStats.sceneLoad = m_scene->GetLoadTimings();
             
             // Display loading statistics
             const auto& stats = m_scene->GetLoadStats();
@@ -173,16 +471,26 @@ namespace ACG {
             CreateAccelerationStructures(loadCommandList.Get());
             CreateShaderBindingTable();
             
-            // Now close and execute the command list
+            // Now close and execute the command list (BLAS builds wait for the geometry copies)
             ThrowIfFailed(loadCommandList->Close(), "Failed to close load command list");
+            QueueWaitForCopies(m_geometryCopyFenceValue);
             ID3D12CommandList* lists[] = { loadCommandList.Get() };
             m_commandQueue->ExecuteCommandLists(1, lists);
+            m_gpuProfiler.Submit(m_fence.Get(), m_fenceValue);  // The value WaitForGpu signals
             
             // Wait for all GPU operations to complete
             WaitForGpu();
             
+            // Compact BLAS now that their sizes are known, then drop the scratch pool
+            CompactBottomLevelAS();
+            
+            m_residentScenePath = path;
+            m_residentSceneHash = contentHash;
+            m_residentSourceFilesStamp = Scene::ComputeFileStamp(m_scene->GetSourceFiles());
+            PublishFrameStats();
             std::cout << "[Async] Scene loaded successfully" << std::endl;
             std::cout.flush();
+            LoadPeerScenes(path);
         } catch (const std::runtime_error& e) {
             std::cerr << "[Async] Failed to load scene: " << e.what() << std::endl;
             std::cerr.flush();
@@ -206,6 +514,9 @@ namespace ACG {
             ~RenderGuard() { flag.store(false); }
         };
         RenderGuard guard(m_isRendering);
+        // The accumulation texture is shared with the interactive preview, which restarts afterwards
+        std::lock_guard<std::mutex> sceneLock(m_sceneMutex);
+        m_previewResetRequested = true;
         
         try {
             m_stopRenderRequested = false;
@@ -218,15 +529,332 @@ namespace ACG {
             if (!m_scene || m_scene->GetMeshes().empty()) {
                 throw std::runtime_error("Scene is not loaded or is empty.");
             }
+            if (!m_resolvePipelineState) {
+                throw std::runtime_error("Resolve pipeline is not available.");
+            }
+            const auto renderStart = std::chrono::steady_clock::now();
+
+            // Bucket layout, shared by all devices: the frame is rendered, read back, denoised and written tile by tile
+            const UINT bucketSize = GetEffectiveBucketSize();
+            const UINT coreWidth = bucketSize > 0 ? std::min(bucketSize, m_width) : m_width;
+            const UINT coreHeight = bucketSize > 0 ? std::min(bucketSize, m_height) : m_height;
+            
+            // The file extension picks the format: EXR stores the linear radiance (optionally with AOV layers), PPM 8-bit pixels
+            const ImageWriter::FileFormat fileFormat = ImageWriter::GetFileFormat(outputPath);
+            const bool hdrFile = fileFormat == ImageWriter::FileFormat::EXR;
+            const bool aovLayers = hdrFile && m_exrAovLayers;
+
+            // Finished bucket rows are handed to the image writer, only the rows being rendered are kept in memory;
+            // encoding and disk I/O run on its worker thread while the next rows render
+            m_imageWriter.Begin(outputPath, static_cast<int>(m_width), static_cast<int>(m_height), fileFormat, aovLayers, m_exrCompression);
+            struct ImageJobGuard {
+                ImageWriter& writer;
+                ~ImageJobGuard() { writer.Abort(); }  // No-op once the job was ended
+            } imageJobGuard = { m_imageWriter };
+            TileScheduler scheduler(m_imageWriter, m_width, m_height, coreWidth, coreHeight, hdrFile, aovLayers ? 3 : 1);
+            // The last bucket's worker uses the scheduler: finished before it goes out of scope, also on errors
+            struct PendingBucketGuard {
+                Renderer& renderer;
+                ~PendingBucketGuard() { renderer.DiscardPendingBucket(); }
+            } pendingBucketGuard = { *this };
+
+            const bool completed = RenderFrame(scheduler, fileFormat, samplesPerPixel, maxBounces, nullptr);
+            FinishPendingBucket();
+            if (!completed) {
+                m_imageWriter.Abort();  // Incomplete image
+                return;
+            }
+            if (!scheduler.IsComplete()) {
+                throw std::runtime_error("Offline render finished with missing buckets");
+            }
+            m_accumulatedSamples = samplesPerPixel;
+
+            m_imageWriter.End();
+            // Throughput of all devices together; their dispatches overlap, so it is measured over the wall time
+            m_workStats.renderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart).count();
+            PublishFrameStats();
+            const FrameStats stats = GetFrameStats();
+            std::cout << "Render complete: " << outputPath << " (" << (hdrFile ? "EXR" : "PPM")
+                      << " encoded in the background)" << std::endl;
+            std::cout << "  Path tracing " << static_cast<int>(stats.phases[PhaseIndex(RenderPhase::PathTracing)].gpuMs)
+                      << " ms GPU, " << (stats.raysPerSecond / 1.0e6) << " M camera rays/s, total "
+                      << static_cast<int>(stats.renderMs) << " ms";
+            if (stats.deviceCount > 1) {
+                std::cout << " on " << stats.deviceCount << " GPUs";
+            }
+            std::cout << std::endl;
+        }
+        catch (const com_exception& e) {
+            char errMsg[512];
+            sprintf_s(errMsg, "RenderToFile DirectX error (HRESULT: 0x%08X): %s", e.get_result(), e.what());
+            std::cerr << errMsg << std::endl;
+            throw std::runtime_error(errMsg);
+        }
+        catch (const std::exception& e) {
+            std::string errMsg = std::string("RenderToFile exception: ") + (e.what() ? e.what() : "Unknown error");
+            std::cerr << errMsg << std::endl;
+            throw std::runtime_error(errMsg);
+        }
+        catch (...) {
+            std::cerr << "RenderToFile: Unknown exception caught" << std::endl;
+            throw std::runtime_error("Unknown error in RenderToFile");
+        }
+    }
+
+    void Renderer::RenderSequence(const AnimationSequence& sequence, const std::string& outputPath, int samplesPerPixel, int maxBounces) {
+        // RAII guard to ensure m_isRendering is always cleared
+        struct RenderGuard {
+            std::atomic<bool>& flag;
+            RenderGuard(std::atomic<bool>& f) : flag(f) { flag.store(true); }
+            ~RenderGuard() { flag.store(false); }
+        };
+        RenderGuard guard(m_isRendering);
+        std::lock_guard<std::mutex> sceneLock(m_sceneMutex);
+        m_previewResetRequested = true;
+
+        try {
+            m_stopRenderRequested = false;
+            const int frameCount = sequence.GetFrameCount();
+            std::cout << "Starting sequence render: " << frameCount << " frames at " << sequence.GetFramesPerSecond()
+                      << " fps, " << m_width << "x" << m_height << ", Samples: " << samplesPerPixel
+                      << ", Bounces: " << maxBounces << std::endl;
+
+            if (!m_scene || m_scene->GetMeshes().empty()) {
+                throw std::runtime_error("Scene is not loaded or is empty.");
+            }
+            if (!m_resolvePipelineState) {
+                throw std::runtime_error("Resolve pipeline is not available.");
+            }
+
+            // Keys animate on top of the transforms from the scene file, which are restored afterwards
+            // (the next render refits the TLAS back)
+            std::vector<std::pair<uint32_t, glm::mat4>> baseTransforms;
+            for (const auto& track : sequence.GetInstanceTracks()) {
+                if (track.first >= m_scene->GetInstances().size()) {
+                    throw std::runtime_error("Animated instance " + std::to_string(track.first) + " does not exist (the scene has " +
+                                             std::to_string(m_scene->GetInstances().size()) + " instances)");
+                }
+                baseTransforms.emplace_back(track.first, m_scene->GetInstances()[track.first].transform);
+            }
+            struct TransformRestoreGuard {
+                Scene& scene;
+                const std::vector<std::pair<uint32_t, glm::mat4>>& transforms;
+                ~TransformRestoreGuard() {
+                    for (const auto& base : transforms) {
+                        if (scene.GetInstances()[base.first].transform != base.second) {
+                            scene.SetInstanceTransform(base.first, base.second);
+                        }
+                    }
+                }
+            } transformRestoreGuard = { *m_scene, baseTransforms };
+
+            const auto sequenceStart = std::chrono::steady_clock::now();
+            const UINT bucketSize = GetEffectiveBucketSize();
+            const UINT coreWidth = bucketSize > 0 ? std::min(bucketSize, m_width) : m_width;
+            const UINT coreHeight = bucketSize > 0 ? std::min(bucketSize, m_height) : m_height;
+            const ImageWriter::FileFormat fileFormat = ImageWriter::GetFileFormat(outputPath);
+            const bool hdrFile = fileFormat == ImageWriter::FileFormat::EXR;
+            const bool aovLayers = hdrFile && m_exrAovLayers;
+
+            // Frame N is still finishing its last bucket (and encoding) while frame N + 1 renders,
+            // so its scheduler lives until the next frame opens its file
+            struct ImageJobGuard {
+                ImageWriter& writer;
+                ~ImageJobGuard() { writer.Abort(); }  // No-op once the job was ended
+            } imageJobGuard = { m_imageWriter };
+            std::unique_ptr<TileScheduler> previousFrame;
+            std::unique_ptr<TileScheduler> currentFrame;
+            struct PendingBucketGuard {
+                Renderer& renderer;
+                ~PendingBucketGuard() { renderer.DiscardPendingBucket(); }
+            } pendingBucketGuard = { *this };
+
+            auto endPreviousFrame = [&]() {
+                if (!previousFrame) {
+                    return;
+                }
+                if (!previousFrame->IsComplete()) {
+                    throw std::runtime_error("Sequence frame finished with missing buckets");
+                }
+                m_imageWriter.End();
+                previousFrame.reset();
+            };
+
+            uint64_t pathSamples = 0;
+            for (int frame = 0; frame < frameCount; ++frame) {
+                const float time = sequence.GetFrameTime(frame);
+                const std::string framePath = AnimationSequence::GetFramePath(outputPath, frame);
+                std::cout << "Frame " << (frame + 1) << "/" << frameCount << " (t = " << time << " s): " << framePath << std::endl;
+
+                // Between frames only the camera constants and the animated instances change: BLAS, textures and
+                // pipelines stay resident and the TLAS is refit in place
+                if (sequence.HasCameraAnimation()) {
+                    const CameraKeyframe key = sequence.SampleCamera(time);
+                    m_camera.SetPosition(key.position);
+                    m_camera.SetTarget(key.target);
+                    if (key.fov > 0.0f) {
+                        m_camera.SetFOV(key.fov);
+                    }
+                }
+                for (const auto& base : baseTransforms) {
+                    const glm::mat4 transform = base.second * sequence.SampleInstance(base.first, time);
+                    if (transform != m_scene->GetInstances()[base.first].transform) {
+                        m_scene->SetInstanceTransform(base.first, transform);
+                    }
+                }
+
+                currentFrame = std::make_unique<TileScheduler>(m_imageWriter, m_width, m_height, coreWidth, coreHeight,
+                                                               hdrFile, aovLayers ? 3 : 1);
+                // The file is opened once the previous frame received its last rows: right away for the first
+                // frame (an invalid path fails before anything renders), otherwise when this frame delivers its first bucket
+                bool opened = false;
+                auto openFrame = [&]() {
+                    endPreviousFrame();
+                    m_imageWriter.Begin(framePath, static_cast<int>(m_width), static_cast<int>(m_height), fileFormat, aovLayers, m_exrCompression);
+                    opened = true;
+                };
+                std::function<void()> beforeFirstBucket;
+                if (frame == 0) {
+                    openFrame();
+                } else {
+                    beforeFirstBucket = openFrame;
+                }
+
+                const bool completed = RenderFrame(*currentFrame, fileFormat, samplesPerPixel, maxBounces, beforeFirstBucket);
+                pathSamples += m_workStats.pathSamples;
+                if (!completed) {
+                    // Earlier frames are kept, the interrupted one is deleted
+                    FinishPendingBucket();
+                    if (!opened) {
+                        endPreviousFrame();
+                    }
+                    m_imageWriter.Abort();
+                    std::cout << "Sequence stopped at frame " << (frame + 1) << "/" << frameCount << std::endl;
+                    return;
+                }
+                previousFrame = std::move(currentFrame);
+            }
+            FinishPendingBucket();
+            endPreviousFrame();
+            m_accumulatedSamples = samplesPerPixel;
+
+            // FrameStats describe the last frame; the summary covers the whole sequence
+            const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sequenceStart).count();
+            std::cout << "Sequence complete: " << frameCount << " frames in " << static_cast<int>(totalMs) << " ms ("
+                      << static_cast<int>(totalMs / frameCount) << " ms per frame, "
+                      << (totalMs > 0.0 ? static_cast<double>(pathSamples) / totalMs / 1.0e3 : 0.0) << " M camera rays/s)" << std::endl;
+        }
+        catch (const com_exception& e) {
+            char errMsg[512];
+            sprintf_s(errMsg, "RenderSequence DirectX error (HRESULT: 0x%08X): %s", e.get_result(), e.what());
+            std::cerr << errMsg << std::endl;
+            throw std::runtime_error(errMsg);
+        }
+        catch (const std::exception& e) {
+            std::string errMsg = std::string("RenderSequence exception: ") + (e.what() ? e.what() : "Unknown error");
+            std::cerr << errMsg << std::endl;
+            throw std::runtime_error(errMsg);
+        }
+        catch (...) {
+            std::cerr << "RenderSequence: Unknown exception caught" << std::endl;
+            throw std::runtime_error("Unknown error in RenderSequence");
+        }
+    }
+
+    bool Renderer::RenderFrame(TileScheduler& scheduler, ImageWriter::FileFormat fileFormat, int samplesPerPixel, int maxBounces,
+                               const std::function<void()>& beforeFirstBucket) {
+        if (!m_peers.empty() && beforeFirstBucket) {
+            // Peers deliver buckets from the start: the previous frame has to be complete before they begin
+            FinishPendingBucket();
+            beforeFirstBucket();
+        }
+
+        // Multi-GPU: the other devices pull buckets from the same scheduler on their own threads
+        std::vector<std::thread> peerThreads;
+        std::vector<std::exception_ptr> peerErrors(m_peers.size());
+        for (size_t i = 0; i < m_peers.size(); ++i) {
+            Renderer* peer = m_peers[i].get();
+            CopyRenderSettingsTo(*peer);
+            peerThreads.emplace_back([peer, &scheduler, &peerErrors, i, fileFormat, samplesPerPixel, maxBounces]() {
+                try {
+                    std::lock_guard<std::mutex> peerLock(peer->m_sceneMutex);
+                    peer->RenderTiles(scheduler, fileFormat, samplesPerPixel, maxBounces, nullptr);
+                    peer->FinishPendingBucket();
+                } catch (...) {
+                    // Buckets it had taken are lost, so the frame cannot complete
+                    peer->DiscardPendingBucket();
+                    peerErrors[i] = std::current_exception();
+                    scheduler.Abort();
+                }
+            });
+        }
+        // The threads use the scheduler: they are joined before it goes out of scope, also when this device throws
+        struct PeerThreadGuard {
+            std::vector<std::thread>& threads;
+            TileScheduler& scheduler;
+            void Join() {
+                for (auto& thread : threads) {
+                    if (thread.joinable()) {
+                        thread.join();
+                    }
+                }
+            }
+            ~PeerThreadGuard() { scheduler.Abort(); Join(); }
+        } peerThreadGuard = { peerThreads, scheduler };
+
+        RenderTiles(scheduler, fileFormat, samplesPerPixel, maxBounces, m_peers.empty() ? beforeFirstBucket : nullptr);
+        peerThreadGuard.Join();
+        for (size_t i = 0; i < peerErrors.size(); ++i) {
+            if (peerErrors[i]) {
+                try {
+                    std::rethrow_exception(peerErrors[i]);
+                } catch (const std::exception& e) {
+                    throw std::runtime_error(std::string("Render device ") + std::to_string(i + 1) + " failed: " + e.what());
+                }
+            }
+        }
+
+        for (const auto& peer : m_peers) {
+            m_workStats.pathSamples += peer->GetFrameStats().pathSamples;
+        }
+        m_workStats.deviceCount = static_cast<uint32_t>(1 + m_peers.size());
+        return !scheduler.IsAborted();
+    }
+
+    void Renderer::RenderTiles(TileScheduler& scheduler, ImageWriter::FileFormat fileFormat, int samplesPerPixel, int maxBounces,
+                               const std::function<void()>& beforeFirstBucket) {
+        try {
+            // Render phases start over with every render; load phases (and TLAS refits) add up until the next load
+            const auto renderStart = std::chrono::steady_clock::now();
+            m_gpuProfiler.DiscardUnsubmitted();
+            ResetPhaseStats(RenderPhase::PathTracing);
+            ResetPhaseStats(RenderPhase::Readback);
+            ResetPhaseStats(RenderPhase::Denoise);
+            m_workStats.width = m_width;
+            m_workStats.height = m_height;
+            m_workStats.samplesPerPixel = static_cast<uint32_t>(samplesPerPixel);
+            m_workStats.pathSamples = 0;
+            m_workStats.deviceCount = 1;
+            auto publishRenderStats = [&]() {
+                m_workStats.renderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart).count();
+                PublishFrameStats();
+            };
+            
+            // Texture uploads may still run on the copy queue; the first DispatchRays waits for them on the GPU
+            QueueWaitForCopies(m_copyFenceValue);
 
             // Create independent command resources for offline rendering
-            if (!m_offlineCommandAllocator) {
-                std::cout << "Creating offline command allocator..." << std::endl;
-                HRESULT hr = m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_offlineCommandAllocator));
-                if (FAILED(hr)) {
-                    char errMsg[256];
-                    sprintf_s(errMsg, "Failed to create offline command allocator (HRESULT: 0x%08X)", hr);
-                    throw std::runtime_error(errMsg);
+            // Batches rotate through several allocators, so the next batch is recorded while earlier ones run
+            for (UINT i = 0; i < OFFLINE_BATCHES_IN_FLIGHT; ++i) {
+                if (!m_offlineCommandAllocators[i]) {
+                    std::cout << "Creating offline command allocator " << i << "..." << std::endl;
+                    HRESULT hr = m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_offlineCommandAllocators[i]));
+                    if (FAILED(hr)) {
+                        char errMsg[256];
+                        sprintf_s(errMsg, "Failed to create offline command allocator (HRESULT: 0x%08X)", hr);
+                        throw std::runtime_error(errMsg);
+                    }
+                    m_offlineAllocatorFences[i] = 0;
                 }
             }
             
@@ -246,590 +874,692 @@ namespace ACG {
             }
 
             // Reset and get command list
-            std::cout << "Resetting command allocator..." << std::endl;
-            HRESULT hr = m_offlineCommandAllocator->Reset();
+            ACG_LOG_DEBUG("Resetting command allocator...");
+            UINT allocatorIndex = 0;
+            WaitForOfflineFence(m_offlineAllocatorFences[allocatorIndex]);
+            HRESULT hr = m_offlineCommandAllocators[allocatorIndex]->Reset();
             if (FAILED(hr)) {
                 char errMsg[256];
                 sprintf_s(errMsg, "Failed to reset offline command allocator (HRESULT: 0x%08X)", hr);
                 throw std::runtime_error(errMsg);
             }
             
-            Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> renderCommandList;
-            std::cout << "Creating command list..." << std::endl;
-            hr = m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_offlineCommandAllocator.Get(), nullptr, IID_PPV_ARGS(&renderCommandList));
-            if (FAILED(hr)) {
-                char errMsg[256];
-                sprintf_s(errMsg, "Failed to create command list (HRESULT: 0x%08X)", hr);
-                throw std::runtime_error(errMsg);
+            // Created once and reset by every render (sequences record hundreds of them)
+            if (!m_offlineCommandList) {
+                std::cout << "Creating command list..." << std::endl;
+                hr = m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_offlineCommandAllocators[allocatorIndex].Get(), nullptr, IID_PPV_ARGS(&m_offlineCommandList));
+                if (FAILED(hr)) {
+                    char errMsg[256];
+                    sprintf_s(errMsg, "Failed to create command list (HRESULT: 0x%08X)", hr);
+                    throw std::runtime_error(errMsg);
+                }
+            } else {
+                ThrowIfFailed(m_offlineCommandList->Reset(m_offlineCommandAllocators[allocatorIndex].Get(), nullptr),
+                              "Failed to reset offline command list");
             }
+            Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> renderCommandList = m_offlineCommandList;
             
-            // Set pipeline state
-            renderCommandList->SetPipelineState1(m_dxrStateObject.Get());
-            renderCommandList->SetComputeRootSignature(m_raytracingGlobalRootSignature.Get());
-
-            // Set heaps
-            ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
-            renderCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+            // Instance transforms changed since the last build: refit TLAS, BLAS stay cached
+            RefitTopLevelAS(renderCommandList.Get());
+
+            // Pipeline, heaps and root parameters 0-9
+            BindRaytracingRootArguments(renderCommandList.Get());
+
+            // Bucket layout of the scheduler; buckets are rendered with an overlap border so the denoiser
+            // sees context across seams
+            const UINT coreWidth = scheduler.GetCoreWidth();
+            const UINT coreHeight = scheduler.GetCoreHeight();
+            const UINT tilesX = scheduler.GetTilesX();
+            const UINT tilesY = scheduler.GetTilesY();
+            const int tileCount = scheduler.GetTileCount();
+            const bool denoiseBuckets = m_denoiser && m_denoiser->IsInitialized();
+            const UINT overlap = (tileCount > 1 && denoiseBuckets) ? BUCKET_DENOISE_OVERLAP : 0;
+            const UINT maxTileWidth = std::min(m_width, coreWidth + 2 * overlap);
+            const UINT maxTileHeight = std::min(m_height, coreHeight + 2 * overlap);
+            if (tileCount > 1) {
+                std::cout << "Bucket rendering: " << tilesX << "x" << tilesY << " tiles of " << coreWidth << "x" << coreHeight
+                          << " (overlap " << overlap << " px)" << std::endl;
+            }
 
-            // DEBUG: Print binding info
-            // Set root arguments
-            // Root parameter 0: UAV table (output texture at index 0)
-            D3D12_GPU_DESCRIPTOR_HANDLE uavHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            uavHandle.ptr += m_uavIndex_Output * m_srvUavDescriptorSize;
-            renderCommandList->SetComputeRootDescriptorTable(0, uavHandle);
-            
-            // Root parameter 1: TLAS (direct SRV, not a table)
-            renderCommandList->SetComputeRootShaderResourceView(1, m_topLevelAS->GetGPUVirtualAddress());
-            
-            // Root parameter 2: Vertices SRV table (index 1)
-            D3D12_GPU_DESCRIPTOR_HANDLE verticesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            verticesHandle.ptr += m_srvIndex_Vertices * m_srvUavDescriptorSize;
-            renderCommandList->SetComputeRootDescriptorTable(2, verticesHandle);
-            
-            // Root parameter 3: Indices SRV table (index 2)
-            D3D12_GPU_DESCRIPTOR_HANDLE indicesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            indicesHandle.ptr += m_srvIndex_Indices * m_srvUavDescriptorSize;
-            renderCommandList->SetComputeRootDescriptorTable(3, indicesHandle);
-            
-            // Root parameter 4: Triangle materials SRV table (index 3)
-            D3D12_GPU_DESCRIPTOR_HANDLE triMatHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            triMatHandle.ptr += 3 * m_srvUavDescriptorSize;
-            renderCommandList->SetComputeRootDescriptorTable(4, triMatHandle);
-            
-            // Root parameter 5: Materials SRV (direct root descriptor)
-            D3D12_GPU_VIRTUAL_ADDRESS materialsAddress = m_materialBuffer->GetGPUVirtualAddress();
-            renderCommandList->SetComputeRootShaderResourceView(5, materialsAddress);
-            
-            // Root parameter 10: Material Layers SRV table (bind to descriptor slot 5)
-            D3D12_GPU_DESCRIPTOR_HANDLE layersHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            layersHandle.ptr += m_srvIndex_MaterialLayers * m_srvUavDescriptorSize;
-            renderCommandList->SetComputeRootDescriptorTable(10, layersHandle);
+            // The accumulation target only has to hold one bucket
+            EnsureOutputTexture(maxTileWidth, maxTileHeight);
             
-            // Root parameter 6: Textures SRV table (t3, bind to descriptor slot 5)
-            D3D12_GPU_DESCRIPTOR_HANDLE texturesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            texturesHandle.ptr += 5 * m_srvUavDescriptorSize; // slot 5 for texture array
-            renderCommandList->SetComputeRootDescriptorTable(6, texturesHandle);
-            
-            // Root parameter 7: Environment map SRV table (t4, bind to descriptor slot 6)
-            D3D12_GPU_DESCRIPTOR_HANDLE envMapHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            envMapHandle.ptr += 6 * m_srvUavDescriptorSize; // slot 6 for environment map
-            renderCommandList->SetComputeRootDescriptorTable(7, envMapHandle);
-            
-            // Root parameter 8: Virtual Texture Cache SRV table (bind to descriptor slot 7, t5)
-            if (m_useVirtualTextures) {
-                D3D12_GPU_DESCRIPTOR_HANDLE vtCacheHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                vtCacheHandle.ptr += 7 * m_srvUavDescriptorSize; // slot 7 for virtual texture cache
-                renderCommandList->SetComputeRootDescriptorTable(8, vtCacheHandle);
-                
-                // Also bind indirection texture immediately
-                D3D12_GPU_DESCRIPTOR_HANDLE indirectionHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                indirectionHandle.ptr += 8 * m_srvUavDescriptorSize; // slot 8 for indirection texture
-                renderCommandList->SetComputeRootDescriptorTable(9, indirectionHandle);
-            }
-            
-            // Root parameter 11: Texture Scales SRV table (t8, bind to descriptor slot 9)
-            D3D12_GPU_DESCRIPTOR_HANDLE scalesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-            scalesHandle.ptr += 9 * m_srvUavDescriptorSize; // slot 9 for texture scales
-            renderCommandList->SetComputeRootDescriptorTable(11, scalesHandle);
-
-            // Root parameter 12: Camera constants (32-bit constants)
-            // Compute camera matrices
-            glm::vec3 pos = m_camera.GetPosition();
-            glm::vec3 dir = m_camera.GetDirection();
-            glm::vec3 right = m_camera.GetRight();
-            glm::vec3 up = m_camera.GetUp();
-            
-            // Build camera-to-world matrix (view inverse)
-            // GLM matrices are COLUMN-MAJOR, so mat[i] is the i-th COLUMN
-            glm::mat4 cameraToWorld = glm::mat4(1.0f);
-            cameraToWorld[0] = glm::vec4(right, 0.0f);      // X axis (column 0)
-            cameraToWorld[1] = glm::vec4(up, 0.0f);         // Y axis (column 1)
-            cameraToWorld[2] = glm::vec4(-dir, 0.0f);       // Z axis (column 2) - camera looks along -Z
-            cameraToWorld[3] = glm::vec4(pos, 1.0f);        // Translation (column 3)
-            
-            // Transpose for row-major HLSL (DirectX uses row-major by default)
-            cameraToWorld = glm::transpose(cameraToWorld);
-            
-            // Get projection matrix and invert it, then transpose
-            glm::mat4 projMatrix = m_camera.GetProjectionMatrix();
-            glm::mat4 projInverse = glm::transpose(glm::inverse(projMatrix));
-            
-            CameraConstants cameraConstants;
-            cameraConstants.viewInverse = cameraToWorld;
-            cameraConstants.projInverse = projInverse;
-            cameraConstants.frameIndex = static_cast<uint32_t>(m_accumulatedSamples);
-            cameraConstants.maxBounces = static_cast<uint32_t>(m_maxBounces);
-            cameraConstants.environmentLightIntensity = m_environmentLightIntensity;
-            cameraConstants.padding = 0.0f;
-            cameraConstants.cameraParams = glm::vec4(
-                m_camera.GetFOV(),
-                static_cast<float>(m_width) / static_cast<float>(m_height),
-                m_camera.GetAperture(),
-                m_camera.GetFocusDistance()
-            );
-            cameraConstants.sunDirIntensity = glm::vec4(m_sunDirection, m_sunIntensity);
-            cameraConstants.sunColorEnabled = glm::vec4(m_sunColor, 1.0f);  // Always 1.0, controlled by intensity
+            const bool hdrFile = fileFormat == ImageWriter::FileFormat::EXR;
+            const bool aovLayers = hdrFile && scheduler.GetImageLayers() > 1;
+            const UINT imageLayers = aovLayers ? 3 : 1;
+
+            // Buckets are averaged on the GPU and only the compact result is read back:
+            // linear half floats for the denoiser and EXR output, otherwise the final tone mapped 8-bit pixels
+            const bool hdrResolve = denoiseBuckets || hdrFile;
+            const DXGI_FORMAT resolveFormat = hdrResolve ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+            const UINT resolveBytesPerPixel = hdrResolve ? 8 : 4;
+            EnsureResolveTarget(m_resolveTexture, m_uavIndex_Resolve, resolveFormat, maxTileWidth, maxTileHeight, L"Offline Resolve");
+            // The denoiser is guided by the first-hit albedo and normal, resolved and read back alongside
+            // (also when they are written as EXR layers)
+            const bool resolveAOVs = denoiseBuckets || aovLayers;
+            if (resolveAOVs) {
+                EnsureResolveTarget(m_resolveAlbedoTexture, m_uavIndex_ResolveAlbedo, resolveFormat, maxTileWidth, maxTileHeight, L"Offline Resolve Albedo");
+                EnsureResolveTarget(m_resolveNormalTexture, m_uavIndex_ResolveNormal, resolveFormat, maxTileWidth, maxTileHeight, L"Offline Resolve Normal");
+            }
+            ID3D12Resource* resolvedImages[] = { m_resolveTexture.Get(), m_resolveAlbedoTexture.Get(), m_resolveNormalTexture.Get() };
+            const UINT resolvedImageCount = resolveAOVs ? 3 : 1;
+
+            // Color, albedo and normal images follow each other, each at a placement-aligned offset
+            D3D12_RESOURCE_DESC tileDesc = CD3DX12_RESOURCE_DESC::Tex2D(resolveFormat, maxTileWidth, maxTileHeight, 1, 1);
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT maxImageFootprint;
+            UINT64 imageSize;
+            m_device->GetCopyableFootprints(&tileDesc, 0, 1, 0, &maxImageFootprint, nullptr, nullptr, &imageSize);
+            const UINT64 imageStride = (imageSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) /
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT * D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+
+            // GPU-resident denoising: the images are copied into a buffer OIDN imports (plus one for its output),
+            // denoised and tone mapped in VRAM, and only the final 8-bit pixels are read back.
+            // For EXR output the denoised linear image (and the guides for AOV layers) is read back instead
+            const bool gpuDenoise = denoiseBuckets && EnsureDenoiseSharedBuffer(imageStride * (resolvedImageCount + 1));
+            const bool gpuToneMap = gpuDenoise && !hdrFile;
+            if (gpuToneMap) {
+                EnsureResolveTarget(m_toneMappedTexture, m_uavIndex_ToneMapped, DXGI_FORMAT_R8G8B8A8_UNORM,
+                                    maxTileWidth, maxTileHeight, L"Offline Tone Mapped");
+            }
+            if (gpuDenoise) {
+                std::cout << "Denoising buckets on the GPU (shared D3D12 buffer)" << std::endl;
+            }
+            const UINT readbackImageCount = gpuToneMap ? 1 : (gpuDenoise ? imageLayers : resolvedImageCount);
+            const DXGI_FORMAT readbackFormat = gpuToneMap ? DXGI_FORMAT_R8G8B8A8_UNORM : resolveFormat;
+            const UINT readbackBytesPerPixel = gpuToneMap ? 4 : resolveBytesPerPixel;
+
+            // Root parameter 10: Camera constants (32-bit constants)
+            CameraConstants cameraConstants = BuildCameraConstants(m_width, m_height, maxBounces);
+            cameraConstants.samplesPerDispatch = static_cast<uint32_t>(std::min(m_samplesPerDispatch, samplesPerPixel));
             
-            // Set root constants (CameraConstants size in DWORDs) - ROOT PARAMETER 12
-            renderCommandList->SetComputeRoot32BitConstants(12, sizeof(CameraConstants) / 4, &cameraConstants, 0);
+            // Only frameIndex (and samplesPerDispatch of a final partial dispatch) changes per dispatch,
+            // the other constants are set once per command list
+            const UINT frameIndexConstantOffset = static_cast<UINT>(offsetof(CameraConstants, frameIndex) / 4);
+            const UINT samplesPerDispatchConstantOffset = static_cast<UINT>(offsetof(CameraConstants, samplesPerDispatch) / 4);
 
             // Dispatch rays with accumulation
-            D3D12_DISPATCH_RAYS_DESC dispatchDesc = {};
-            dispatchDesc.RayGenerationShaderRecord.StartAddress = m_sbtBuffer->GetGPUVirtualAddress() + m_sbtRayGenOffset;
-            dispatchDesc.RayGenerationShaderRecord.SizeInBytes = m_sbtEntrySize;
-            dispatchDesc.MissShaderTable.StartAddress = m_sbtBuffer->GetGPUVirtualAddress() + m_sbtMissOffset;
-            dispatchDesc.MissShaderTable.SizeInBytes = m_sbtEntrySize; // Assuming one miss shader
-            dispatchDesc.MissShaderTable.StrideInBytes = m_sbtEntrySize;
-            dispatchDesc.HitGroupTable.StartAddress = m_sbtBuffer->GetGPUVirtualAddress() + m_sbtHitGroupOffset;
-            dispatchDesc.HitGroupTable.SizeInBytes = m_sbtEntrySize; // Single hit group for all geometry
-            dispatchDesc.HitGroupTable.StrideInBytes = m_sbtEntrySize;
-            dispatchDesc.Width = m_width;
-            dispatchDesc.Height = m_height;
-            dispatchDesc.Depth = 1;
+            D3D12_DISPATCH_RAYS_DESC dispatchDesc = GetDispatchRaysDesc();
+
+            // Create readback buffer, sized for the largest bucket and reused by all of them
+            D3D12_RESOURCE_DESC readbackTileDesc = CD3DX12_RESOURCE_DESC::Tex2D(readbackFormat, maxTileWidth, maxTileHeight, 1, 1);
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT maxFootprint;
+            UINT64 readbackSize;
+            m_device->GetCopyableFootprints(&readbackTileDesc, 0, 1, 0, &maxFootprint, nullptr, nullptr, &readbackSize);
+            const UINT64 readbackImageStride = (readbackSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) /
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT * D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+            readbackSize = readbackImageStride * readbackImageCount;
+
+            // Buckets alternate between two readback buffers (kept across renders). A buffer is written again two
+            // buckets later, when the worker of its bucket has finished (buckets are finished one after another)
+            for (UINT i = 0; i < BUCKET_READBACK_BUFFERS; ++i) {
+                if (m_bucketReadbackBuffers[i] && m_bucketReadbackSizes[i] >= readbackSize) {
+                    continue;
+                }
+                ACG_LOG_DEBUG("Creating readback buffer " << i << " (" << readbackSize << " bytes, " << readbackImageCount << " x "
+                              << readbackBytesPerPixel << " bytes per pixel)...");
+                // A pending bucket keeps its own reference to the buffer it maps
+                m_bucketReadbackBuffers[i].Reset();
+                m_bucketReadbackSizes[i] = 0;
+                HRESULT hrReadback = m_device->CreateCommittedResource(
+                    &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+                    D3D12_HEAP_FLAG_NONE,
+                    &CD3DX12_RESOURCE_DESC::Buffer(readbackSize),
+                    D3D12_RESOURCE_STATE_COPY_DEST,
+                    nullptr,
+                    IID_PPV_ARGS(&m_bucketReadbackBuffers[i]));
+                
+                if (FAILED(hrReadback)) {
+                    char errorMsg[256];
+                    sprintf_s(errorMsg, "Failed to create readback buffer (HRESULT: 0x%08X, size: %llu bytes)", hrReadback, readbackSize);
+                    ThrowIfFailed(hrReadback, errorMsg);
+                }
+                m_bucketReadbackSizes[i] = readbackSize;
+            }
+            bool denoiserWarned = false;
+            m_bucketDenoiseWarned = false;
 
-            std::cout << "Starting progressive rendering loop..." << std::endl;
+            // Render in batches to allow progress updates
+            // Submit GPU work about every 10 samples, rounded up to whole dispatches
+            const int samplesPerDispatch = static_cast<int>(cameraConstants.samplesPerDispatch);
+            const int batchSize = (10 + samplesPerDispatch - 1) / samplesPerDispatch * samplesPerDispatch;
+            ACG_LOG_DEBUG("Samples per dispatch: " << samplesPerDispatch << ", samples per batch: " << batchSize);
             
-            // PIX: Mark render loop start
-            PIXBeginEvent(renderCommandList.Get(), PIX_COLOR_INDEX(1), "Path Tracing Loop");
-            
-            // Clear output texture before first sample to ensure clean start
-            D3D12_RECT clearRect = { 0, 0, (LONG)m_width, (LONG)m_height };
-            float clearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
-            renderCommandList->ClearUnorderedAccessViewFloat(
-                m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(),
-                CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_Output, m_srvUavDescriptorSize),
-                m_outputTexture.Get(),
-                clearColor,
-                1, &clearRect
-            );
+            // Virtual textures: restart after the first batch of a bucket at most this many times while tiles stream in
+            const int MAX_VT_WARMUP_RESTARTS = 3;
             
-            // Barrier after clear
-            D3D12_RESOURCE_BARRIER initialBarrier = {};
-            initialBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-            initialBarrier.UAV.pResource = m_outputTexture.Get();
-            renderCommandList->ResourceBarrier(1, &initialBarrier);
+            // Submitted batches, polled for progress and convergence
+            struct SubmittedBatch {
+                UINT64 fence;
+                int samples;          // Accumulated samples of the bucket once it completes
+                UINT allocatorIndex;  // Slot of its active pixel count readback
+            };
+            std::deque<SubmittedBatch> batchesInFlight;
+            const bool adaptiveSampling = cameraConstants.adaptiveThreshold > 0.0f;
+            // Batch carrying the VT feedback readback (0 = none); the single readback buffer allows one in flight
+            UINT64 feedbackFence = 0;
+
+            D3D12_RECT clearRect = { 0, 0, 0, 0 };
             
-            // Reset accumulated samples counter
+            // Reset accumulated samples counter (whole-frame progress: buckets done on all devices plus this one's share)
             m_accumulatedSamples = 0;
+            auto reportProgress = [&](int tileSamples) {
+                m_accumulatedSamples = static_cast<int>((static_cast<int64_t>(scheduler.GetCompletedTileCount()) * samplesPerPixel + tileSamples) / tileCount);
+            };
 
-            // Render in batches to allow progress updates
-            const int batchSize = 10; // Execute GPU work every 10 samples
-            
-            for (int sampleIdx = 0; sampleIdx < samplesPerPixel; ++sampleIdx) {
-                // Check if stop was requested
-                if (m_stopRenderRequested) {
-                    std::cout << "Render stopped by user at sample " << (sampleIdx + 1) << "/" << samplesPerPixel << std::endl;
-                    std::cout.flush();
-                    renderCommandList->Close();
-                    return;
-                }
+            std::cout << "Starting progressive rendering loop..." << std::endl;
+
+            bool firstTile = true;
+            bool firstDelivery = true;
+            for (int tileIndex = scheduler.AcquireTile(); tileIndex >= 0; tileIndex = scheduler.AcquireTile()) {
+                const UINT tileX = static_cast<UINT>(tileIndex) % tilesX;
+                const UINT tileY = static_cast<UINT>(tileIndex) / tilesX;
+                const UINT coreX = tileX * coreWidth;
+                const UINT coreY = tileY * coreHeight;
+                const UINT coreW = std::min(coreWidth, m_width - coreX);
+                const UINT coreH = std::min(coreHeight, m_height - coreY);
+                const UINT renderX = coreX > overlap ? coreX - overlap : 0;
+                const UINT renderY = coreY > overlap ? coreY - overlap : 0;
+                const UINT renderW = std::min(m_width, coreX + coreW + overlap) - renderX;
+                const UINT renderH = std::min(m_height, coreY + coreH + overlap) - renderY;
                 
-                // Progress output with flush to ensure visibility
-                if (sampleIdx == 0 || (sampleIdx + 1) % 10 == 0 || sampleIdx == samplesPerPixel - 1) {
-                    std::cout << "  Sample " << (sampleIdx + 1) << "/" << samplesPerPixel << " starting..." << std::endl;
-                    std::cout.flush();
+                // Start the bucket on the next allocator (the first one continues the setup list)
+                if (!firstTile) {
+                    allocatorIndex = (allocatorIndex + 1) % OFFLINE_BATCHES_IN_FLIGHT;
+                    WaitForOfflineFence(m_offlineAllocatorFences[allocatorIndex]);
+                    ThrowIfFailed(m_offlineCommandAllocators[allocatorIndex]->Reset());
+                    ThrowIfFailed(renderCommandList->Reset(m_offlineCommandAllocators[allocatorIndex].Get(), nullptr));
+                    
+                    // Requests of the previous bucket (already completed) stream in before the tables are bound
+                    if (m_useVirtualTextures && feedbackFence != 0 && m_offlineFence->GetCompletedValue() >= feedbackFence) {
+                        feedbackFence = 0;
+                        m_virtualTextureSystem.UpdateStreaming(renderCommandList.Get());
+                    }
+                    BindRaytracingRootArguments(renderCommandList.Get());
+                }
+                firstTile = false;
+
+                // Readback buffer of this bucket; the previous bucket may still be finishing in the other one
+                const UINT readbackBufferIndex = m_bucketReadbackIndex;
+                m_bucketReadbackIndex = (m_bucketReadbackIndex + 1) % BUCKET_READBACK_BUFFERS;
+                if (m_pendingBucket.valid() && m_pendingBucketBuffer == readbackBufferIndex) {
+                    FinishPendingBucket();
+                }
+                Microsoft::WRL::ComPtr<ID3D12Resource> readbackBuffer = m_bucketReadbackBuffers[readbackBufferIndex];
+                if (tileCount > 1) {
+                    ACG_LOG_DEBUG(" Bucket " << (tileIndex + 1) << "/" << tileCount << ": " << renderW << "x" << renderH
+                                  << " at (" << renderX << ", " << renderY << ")");
                 }
                 
-                // Update camera constants with current sample index
-                CameraConstants cameraConstants;
-                cameraConstants.viewInverse = cameraToWorld;
-                cameraConstants.projInverse = projInverse;
-                cameraConstants.frameIndex = static_cast<uint32_t>(sampleIdx); // Current sample index for accumulation
-                cameraConstants.maxBounces = static_cast<uint32_t>(maxBounces);
-                cameraConstants.environmentLightIntensity = m_environmentLightIntensity;
-                cameraConstants.padding = 0.0f;
-                cameraConstants.cameraParams = glm::vec4(
-                    m_camera.GetFOV(),
-                    static_cast<float>(m_width) / static_cast<float>(m_height),
-                    m_camera.GetAperture(),
-                    m_camera.GetFocusDistance()
-                );
-                cameraConstants.sunDirIntensity = glm::vec4(m_sunDirection, m_sunIntensity);
-                cameraConstants.sunColorEnabled = glm::vec4(m_sunColor, 1.0f);  // Always 1.0, controlled by intensity
-                renderCommandList->SetComputeRoot32BitConstants(12, sizeof(CameraConstants) / 4, &cameraConstants, 0);
-                
-                // PIX: Mark individual sample
-                PIXBeginEvent(renderCommandList.Get(), PIX_COLOR_INDEX(2), "Sample %d", sampleIdx + 1);
+                // The pixel offset keeps RNG seeds and camera rays identical to a full-frame render
+                cameraConstants.tileOffset = glm::uvec2(renderX, renderY);
+                renderCommandList->SetComputeRoot32BitConstants(10, sizeof(CameraConstants) / 4, &cameraConstants, 0);
+                dispatchDesc.Width = renderW;
+                dispatchDesc.Height = renderH;
                 
-                // Dispatch rays for this sample
-                renderCommandList->DispatchRays(&dispatchDesc);
+                // PIX: Mark render loop start
+                PIXBeginEvent(renderCommandList.Get(), PIX_COLOR_INDEX(1), "Path Tracing Loop");
                 
-                PIXEndEvent(renderCommandList.Get());
+                // Clear output texture before first sample to ensure clean start
+                clearRect = { 0, 0, (LONG)renderW, (LONG)renderH };
+                ClearAccumulation(renderCommandList.Get(), clearRect);
                 
-                // Add UAV barrier to ensure this sample completes before next
-                D3D12_RESOURCE_BARRIER uavBarrier = {};
-                uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-                uavBarrier.UAV.pResource = m_outputTexture.Get();
-                renderCommandList->ResourceBarrier(1, &uavBarrier);
+                // Readback footprint of this bucket inside the shared buffer
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = maxFootprint;
+                footprint.Footprint.Width = renderW;
+                footprint.Footprint.Height = renderH;
+                // Layout of each image inside the denoiser's shared buffer
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT imageFootprint = maxImageFootprint;
+                imageFootprint.Footprint.Width = renderW;
+                imageFootprint.Footprint.Height = renderH;
                 
-                // Execute GPU work periodically to allow progress updates
-                bool isLastSample = (sampleIdx == samplesPerPixel - 1);
-                bool shouldExecute = ((sampleIdx + 1) % batchSize == 0) || isLastSample;
+                int vtWarmupRestarts = 0;
+                bool tileConverged = false;
+                batchesInFlight.clear();
+                // Timestamp range of the batch being recorded, opened by its first dispatch
+                UINT batchRange = GpuProfiler::INVALID_RANGE;
+                bool batchRangeOpen = false;
                 
-                if (shouldExecute) {
-                    // Close and execute command list
-                    ThrowIfFailed(renderCommandList->Close());
-                    ID3D12CommandList* lists[] = { renderCommandList.Get() };
-                    m_commandQueue->ExecuteCommandLists(1, lists);
+                for (int sampleIdx = 0; sampleIdx < samplesPerPixel; ) {
+                    // Check if stop was requested (here or, for another device, through the scheduler)
+                    if (m_stopRenderRequested || scheduler.IsAborted()) {
+                        std::cout << "Render stopped at sample " << (sampleIdx + 1) << "/" << samplesPerPixel << std::endl;
+                        std::cout.flush();
+                        renderCommandList->Close();
+                        // Allocators stay owned by the batches already submitted until they finish
+                        WaitForOfflineFence(m_offlineFenceValue - 1);
+                        scheduler.Abort();  // RenderToFile aborts the incomplete image
+                        m_gpuProfiler.DiscardUnsubmitted();  // The closed list is never executed
+                        publishRenderStats();
+                        return;
+                    }
                     
-                    // Signal and wait for GPU
-                    const UINT64 currentFence = m_offlineFenceValue;
-                    ThrowIfFailed(m_commandQueue->Signal(m_offlineFence.Get(), currentFence));
-                    m_offlineFenceValue++;
+                    // The last dispatch may trace fewer samples
+                    const int dispatchSamples = std::min(samplesPerDispatch, samplesPerPixel - sampleIdx);
                     
-                    if (m_offlineFence->GetCompletedValue() < currentFence) {
-                        ThrowIfFailed(m_offlineFence->SetEventOnCompletion(currentFence, m_offlineFenceEvent));
-                        WaitForSingleObject(m_offlineFenceEvent, INFINITE);
+                    if (sampleIdx % batchSize == 0 || sampleIdx + dispatchSamples == samplesPerPixel) {
+                        ACG_LOG_TRACE("  Samples " << (sampleIdx + 1) << "-" << (sampleIdx + dispatchSamples)
+                                      << "/" << samplesPerPixel << " starting...");
                     }
                     
-                    // Update progress counter AFTER GPU completes
-                    m_accumulatedSamples = sampleIdx + 1;
+                    // First sample index of this dispatch, for accumulation
+                    renderCommandList->SetComputeRoot32BitConstant(10, static_cast<UINT>(sampleIdx), frameIndexConstantOffset);
+                    if (dispatchSamples != samplesPerDispatch) {
+                        renderCommandList->SetComputeRoot32BitConstant(10, static_cast<UINT>(dispatchSamples), samplesPerDispatchConstantOffset);
+                    }
                     
-                    // If not last sample, reset command list for next batch
-                    if (!isLastSample) {
-                        ThrowIfFailed(m_offlineCommandAllocator->Reset());
-                        ThrowIfFailed(renderCommandList->Reset(m_offlineCommandAllocator.Get(), nullptr));
-                        
-                        // Re-setup pipeline state
-                        renderCommandList->SetPipelineState1(m_dxrStateObject.Get());
-                        renderCommandList->SetComputeRootSignature(m_raytracingGlobalRootSignature.Get());
-                        
-                        // Set descriptor heaps
-                        ID3D12DescriptorHeap* descriptorHeaps[] = { m_srvUavHeap.Get() };
-                        renderCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-                        
-                        // Re-bind all resources
-                        // Root parameter 0: Output UAV
-                        D3D12_GPU_DESCRIPTOR_HANDLE uavHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        uavHandle.ptr += m_uavIndex_Output * m_srvUavDescriptorSize;
-                        renderCommandList->SetComputeRootDescriptorTable(0, uavHandle);
-                        
-                        // Root parameter 1: TLAS
-                        renderCommandList->SetComputeRootShaderResourceView(1, m_topLevelAS->GetGPUVirtualAddress());
-                        
-                        // Root parameter 2: Vertices SRV table
-                        D3D12_GPU_DESCRIPTOR_HANDLE verticesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        verticesHandle.ptr += m_srvIndex_Vertices * m_srvUavDescriptorSize;
-                        renderCommandList->SetComputeRootDescriptorTable(2, verticesHandle);
-                        
-                        // Root parameter 3: Indices SRV table
-                        D3D12_GPU_DESCRIPTOR_HANDLE indicesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        indicesHandle.ptr += m_srvIndex_Indices * m_srvUavDescriptorSize;
-                        renderCommandList->SetComputeRootDescriptorTable(3, indicesHandle);
-                        
-                        // Root parameter 4: Triangle materials SRV table
-                        D3D12_GPU_DESCRIPTOR_HANDLE triMatHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        triMatHandle.ptr += 3 * m_srvUavDescriptorSize;
-                        renderCommandList->SetComputeRootDescriptorTable(4, triMatHandle);
-                        
-                        // Root parameter 5: Materials SRV
-                        D3D12_GPU_VIRTUAL_ADDRESS materialsAddress = m_materialBuffer->GetGPUVirtualAddress();
-                        renderCommandList->SetComputeRootShaderResourceView(5, materialsAddress);
-                        
-                        // Root parameter 10: Material Layers SRV table
-                        D3D12_GPU_DESCRIPTOR_HANDLE layersHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        layersHandle.ptr += m_srvIndex_MaterialLayers * m_srvUavDescriptorSize;
-                        renderCommandList->SetComputeRootDescriptorTable(10, layersHandle);
-                        
-                        // Root parameter 6: Textures SRV table (t3, bound to descriptor slot 5)
-                        D3D12_GPU_DESCRIPTOR_HANDLE texturesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        texturesHandle.ptr += 5 * m_srvUavDescriptorSize; // slot 5 for textures
-                        renderCommandList->SetComputeRootDescriptorTable(6, texturesHandle);
+                    // PIX: Mark individual dispatch
+                    PIXBeginEvent(renderCommandList.Get(), PIX_COLOR_INDEX(2), "Samples %d-%d", sampleIdx + 1, sampleIdx + dispatchSamples);
+                    
+                    // Dispatch rays for these samples
+                    if (!batchRangeOpen) {
+                        batchRange = m_gpuProfiler.BeginRange(renderCommandList.Get(), PhaseIndex(RenderPhase::PathTracing));
+                        batchRangeOpen = true;
+                    }
+                    renderCommandList->DispatchRays(&dispatchDesc);
+                    m_workStats.pathSamples += static_cast<uint64_t>(renderW) * renderH * dispatchSamples;
+                    
+                    PIXEndEvent(renderCommandList.Get());
+                    
+                    // Add UAV barrier to ensure this dispatch completes before next
+                    D3D12_RESOURCE_BARRIER uavBarrier = {};
+                    uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+                    uavBarrier.UAV.pResource = m_outputTexture.Get();
+                    renderCommandList->ResourceBarrier(1, &uavBarrier);
+                    
+                    sampleIdx += dispatchSamples;
+                    
+                    // Submit GPU work periodically to allow progress updates
+                    // A converged bucket ends after this dispatch, whose pixels all exited early
+                    bool isLastSample = (sampleIdx == samplesPerPixel) || tileConverged;
+                    bool shouldExecute = (sampleIdx % batchSize == 0) || isLastSample;
+                    
+                    if (shouldExecute) {
+                        m_gpuProfiler.EndRange(renderCommandList.Get(), batchRange);
+                        batchRangeOpen = false;
                         
-                        // Root parameter 7: Environment map SRV table (t4, bind to descriptor slot 6)
-                        D3D12_GPU_DESCRIPTOR_HANDLE envMapHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        envMapHandle.ptr += 6 * m_srvUavDescriptorSize; // slot 6 for environment map
-                        renderCommandList->SetComputeRootDescriptorTable(7, envMapHandle);
+                        if (adaptiveSampling) {
+                            RecordActivePixelReadback(renderCommandList.Get(), allocatorIndex);
+                        }
                         
-                        // Root parameter 8: Virtual Texture Cache SRV table (t5, bind to descriptor slot 7)
-                        if (m_useVirtualTextures) {
-                            D3D12_GPU_DESCRIPTOR_HANDLE vtCacheHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                            vtCacheHandle.ptr += 7 * m_srvUavDescriptorSize; // slot 7 for virtual texture cache
-                            renderCommandList->SetComputeRootDescriptorTable(8, vtCacheHandle);
+                        // Tile requests of this batch ride along with its fence.
+                        // While a readback is in flight, requests keep accumulating for the next one
+                        bool recordFeedback = m_useVirtualTextures && feedbackFence == 0;
+                        if (recordFeedback) {
+                            m_virtualTextureSystem.RecordFeedbackReadback(renderCommandList.Get());
                         }
                         
-                        // Root parameter 9: Indirection Texture SRV table (t6, bind to descriptor slot 8)
-                        if (m_useVirtualTextures) {
-                            D3D12_GPU_DESCRIPTOR_HANDLE indirectionHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                            indirectionHandle.ptr += 8 * m_srvUavDescriptorSize; // slot 8 for indirection texture
-                            renderCommandList->SetComputeRootDescriptorTable(9, indirectionHandle);
+                        // The bucket's readback rides along with its last batch
+                        if (isLastSample) {
+                            PIXEndEvent(renderCommandList.Get());  // End "Path Tracing Loop"
+                            const UINT readbackRange = m_gpuProfiler.BeginRange(renderCommandList.Get(), PhaseIndex(RenderPhase::Readback));
+                            
+                            // Average (and for 8-bit output tone map) the bucket on the GPU
+                            RecordResolve(renderCommandList.Get(), m_uavIndex_Resolve, renderW, renderH, hdrResolve, resolveAOVs);
+                            
+                            for (UINT image = 0; image < resolvedImageCount; ++image) {
+                                D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                                    resolvedImages[image],
+                                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                    D3D12_RESOURCE_STATE_COPY_SOURCE
+                                );
+                                renderCommandList->ResourceBarrier(1, &barrier);
+                                
+                                // GPU denoising keeps the images in VRAM, otherwise they are read back
+                                D3D12_TEXTURE_COPY_LOCATION dst = {};
+                                dst.pResource = gpuDenoise ? m_denoiseSharedBuffer.Get() : readbackBuffer.Get();
+                                dst.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                                dst.PlacedFootprint = gpuDenoise ? imageFootprint : footprint;
+                                dst.PlacedFootprint.Offset = image * (gpuDenoise ? imageStride : readbackImageStride);
+                                
+                                D3D12_TEXTURE_COPY_LOCATION src = {};
+                                src.pResource = resolvedImages[image];
+                                src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                                src.SubresourceIndex = 0;
+                                
+                                D3D12_BOX srcBox = { 0, 0, 0, renderW, renderH, 1 };
+                                renderCommandList->CopyTextureRegion(&dst, 0, 0, 0, &src, &srcBox);
+                                
+                                // Transition back to UAV
+                                barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                                    resolvedImages[image],
+                                    D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+                                );
+                                renderCommandList->ResourceBarrier(1, &barrier);
+                            }
+                            m_gpuProfiler.EndRange(renderCommandList.Get(), readbackRange);
                         }
                         
-                        // Root parameter 11: Texture Scales SRV table (t8, bind to descriptor slot 9)
-                        D3D12_GPU_DESCRIPTOR_HANDLE scalesHandle = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
-                        scalesHandle.ptr += 9 * m_srvUavDescriptorSize; // slot 9 for texture scales
-                        renderCommandList->SetComputeRootDescriptorTable(11, scalesHandle);
+                        // Close and execute command list
+                        ThrowIfFailed(renderCommandList->Close());
+                        ID3D12CommandList* lists[] = { renderCommandList.Get() };
+                        m_commandQueue->ExecuteCommandLists(1, lists);
+                        m_uploadRing.Submit(m_commandQueue.Get());  // Tile uploads recorded by UpdateStreaming
                         
-                        // Root parameter 12: Camera constants (need to update frameIndex for next batch)
-                        // Note: Next batch starts at sampleIdx + 1
-                        CameraConstants nextCameraConstants;
-                        nextCameraConstants.viewInverse = cameraToWorld;
-                        nextCameraConstants.projInverse = projInverse;
-                        nextCameraConstants.frameIndex = static_cast<uint32_t>(sampleIdx + 1); // Next sample index
-                        nextCameraConstants.maxBounces = static_cast<uint32_t>(maxBounces);
-                        nextCameraConstants.environmentLightIntensity = m_environmentLightIntensity;
-                        nextCameraConstants.padding = 0.0f;
-                        nextCameraConstants.cameraParams = glm::vec4(
-                            m_camera.GetFOV(),
-                            static_cast<float>(m_width) / static_cast<float>(m_height),
-                            m_camera.GetAperture(),
-                            m_camera.GetFocusDistance()
-                        );
-                        nextCameraConstants.sunDirIntensity = glm::vec4(m_sunDirection, m_sunIntensity);
-                        nextCameraConstants.sunColorEnabled = glm::vec4(m_sunColor, 1.0f);  // Always 1.0, controlled by intensity
+                        // Signal without waiting: the CPU records the next batch while this one runs
+                        const UINT64 batchFence = m_offlineFenceValue;
+                        ThrowIfFailed(m_commandQueue->Signal(m_offlineFence.Get(), batchFence));
+                        m_offlineFenceValue++;
+                        m_offlineAllocatorFences[allocatorIndex] = batchFence;
+                        m_gpuProfiler.Submit(m_offlineFence.Get(), batchFence);
+                        batchesInFlight.push_back({ batchFence, sampleIdx, allocatorIndex });
+                        if (recordFeedback) {
+                            feedbackFence = batchFence;
+                        }
                         
-                        renderCommandList->SetComputeRoot32BitConstants(12, sizeof(CameraConstants) / 4, &nextCameraConstants, 0);
+                        // Update progress counter from the batches the GPU has completed
+                        const UINT64 completedFence = m_offlineFence->GetCompletedValue();
+                        while (!batchesInFlight.empty() && batchesInFlight.front().fence <= completedFence) {
+                            const SubmittedBatch& batch = batchesInFlight.front();
+                            reportProgress(batch.samples);
+                            // No pixel was still sampled by this batch: every later dispatch would exit at once
+                            if (adaptiveSampling && !tileConverged && ReadActivePixelCount(batch.allocatorIndex) == 0) {
+                                tileConverged = true;
+                                ACG_LOG_DEBUG("  All pixels converged after " << batch.samples << " samples");
+                            }
+                            batchesInFlight.pop_front();
+                        }
+                        m_gpuProfiler.Collect();  // Frees the query slots of completed batches
                         
-                        PIXBeginEvent(renderCommandList.Get(), PIX_COLOR_INDEX(1), "Path Tracing Loop");
+                        // If not last sample, start the next batch on the next allocator
+                        if (!isLastSample) {
+                            // Blocks only when OFFLINE_BATCHES_IN_FLIGHT batches are queued ahead of the CPU
+                            allocatorIndex = (allocatorIndex + 1) % OFFLINE_BATCHES_IN_FLIGHT;
+                            WaitForOfflineFence(m_offlineAllocatorFences[allocatorIndex]);
+                            ThrowIfFailed(m_offlineCommandAllocators[allocatorIndex]->Reset());
+                            ThrowIfFailed(renderCommandList->Reset(m_offlineCommandAllocators[allocatorIndex].Get(), nullptr));
+                            
+                            // Stream in the tiles the readback batch missed (recorded before the VT tables are bound).
+                            // Samples of the first batches used fallback colors for those tiles, so
+                            // accumulation restarts a bounded number of times while the working set loads.
+                            // Only this warmup waits for the readback; afterwards it is picked up once completed
+                            bool restartAccumulation = false;
+                            if (m_useVirtualTextures && feedbackFence != 0) {
+                                bool vtWarmup = sampleIdx <= batchSize && vtWarmupRestarts < MAX_VT_WARMUP_RESTARTS;
+                                if (vtWarmup) {
+                                    WaitForOfflineFence(feedbackFence);
+                                }
+                                if (m_offlineFence->GetCompletedValue() >= feedbackFence) {
+                                    feedbackFence = 0;
+                                    uint32_t streamedTiles = m_virtualTextureSystem.UpdateStreaming(renderCommandList.Get());
+                                    if (streamedTiles > 0 && vtWarmup) {
+                                        vtWarmupRestarts++;
+                                        restartAccumulation = true;
+                                        ACG_LOG_DEBUG("  Restarting accumulation after streaming " << streamedTiles
+                                                      << " virtual texture tiles (" << vtWarmupRestarts << "/" << MAX_VT_WARMUP_RESTARTS << ")");
+                                    }
+                                }
+                            }
+                            
+                            // Root arguments do not carry over between command lists
+                            BindRaytracingRootArguments(renderCommandList.Get());
+                            renderCommandList->SetComputeRoot32BitConstants(10, sizeof(CameraConstants) / 4, &cameraConstants, 0);
+                            
+                            if (restartAccumulation) {
+                                ClearAccumulation(renderCommandList.Get(), clearRect);
+                                
+                                sampleIdx = 0;  // The next batch starts again at sample 0
+                                reportProgress(0);
+                                batchesInFlight.clear();  // Samples of the discarded accumulation
+                            }
+                        }
                     }
                 }
-            }
-            
-            PIXEndEvent(renderCommandList.Get());  // End "Path Tracing Loop"
-            
-            std::cout << "All samples dispatched successfully" << std::endl;
-            std::cout.flush();
-
-            // Create new command list for readback operations
-            ThrowIfFailed(m_offlineCommandAllocator->Reset());
-            ThrowIfFailed(renderCommandList->Reset(m_offlineCommandAllocator.Get(), nullptr));
-
-            // Transition output texture to copy source
-            std::cout << "Transitioning output texture..." << std::endl;
-            D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-                m_outputTexture.Get(),
-                D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-                D3D12_RESOURCE_STATE_COPY_SOURCE
-            );
-            renderCommandList->ResourceBarrier(1, &barrier);
-
-            // Create readback buffer
-            std::cout << "Creating readback buffer..." << std::endl;
-            D3D12_RESOURCE_DESC textureDesc = m_outputTexture->GetDesc();
-            UINT64 textureSize;
-            m_device->GetCopyableFootprints(&textureDesc, 0, 1, 0, nullptr, nullptr, nullptr, &textureSize);
-            
-            std::cout << "Texture size for readback: " << textureSize << " bytes" << std::endl;
-            std::cout << "Texture format: " << textureDesc.Format 
-                      << ", Width: " << textureDesc.Width 
-                      << ", Height: " << textureDesc.Height << std::endl;
-
-            Microsoft::WRL::ComPtr<ID3D12Resource> readbackBuffer;
-            HRESULT hrReadback = m_device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
-                D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(textureSize),
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                nullptr,
-                IID_PPV_ARGS(&readbackBuffer));
-            
-            if (FAILED(hrReadback)) {
-                char errorMsg[256];
-                sprintf_s(errorMsg, "Failed to create readback buffer (HRESULT: 0x%08X, size: %llu bytes)", hrReadback, textureSize);
-                ThrowIfFailed(hrReadback, errorMsg);
-            }
-
-            // Copy texture to readback buffer
-            std::cout << "Copying to readback buffer..." << std::endl;
-            D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
-            m_device->GetCopyableFootprints(&textureDesc, 0, 1, 0, &footprint, nullptr, nullptr, nullptr);
-        
-        D3D12_TEXTURE_COPY_LOCATION dst = {};
-        dst.pResource = readbackBuffer.Get();
-        dst.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        dst.PlacedFootprint = footprint;
-
-        D3D12_TEXTURE_COPY_LOCATION src = {};
-        src.pResource = m_outputTexture.Get();
-        src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        src.SubresourceIndex = 0;
-
-            renderCommandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-
-            // Transition back to UAV
-            std::cout << "Transitioning back to UAV..." << std::endl;
-            barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-                m_outputTexture.Get(),
-                D3D12_RESOURCE_STATE_COPY_SOURCE,
-                D3D12_RESOURCE_STATE_UNORDERED_ACCESS
-            );
-            renderCommandList->ResourceBarrier(1, &barrier);
-
-            // Execute readback command list
-            std::cout << "Closing command list..." << std::endl;
-            hr = renderCommandList->Close();
-            if (FAILED(hr)) {
-                char errMsg[256];
-                sprintf_s(errMsg, "Failed to close render command list (HRESULT: 0x%08X)", hr);
-                throw std::runtime_error(errMsg);
-            }
-            
-            std::cout << "Executing readback command list..." << std::endl;
-            ID3D12CommandList* lists[] = { renderCommandList.Get() };
-            m_commandQueue->ExecuteCommandLists(1, lists);
-            
-            // Wait for readback to complete
-            std::cout << "Waiting for GPU readback..." << std::endl;
-            std::cout.flush();
-            
-            const UINT64 fence = m_offlineFenceValue;
-            hr = m_commandQueue->Signal(m_offlineFence.Get(), fence);
-            if (FAILED(hr)) {
-                char errMsg[256];
-                sprintf_s(errMsg, "Failed to signal fence (HRESULT: 0x%08X)", hr);
-                throw std::runtime_error(errMsg);
-            }
-            std::cout << "Fence signaled: " << fence << std::endl;
-            std::cout.flush();
-            m_offlineFenceValue++;
-            
-            // Check current fence value
-            UINT64 currentValue = m_offlineFence->GetCompletedValue();
-            std::cout << "Current fence value: " << currentValue << ", waiting for: " << fence << std::endl;
-            std::cout.flush();
-            
-            if (currentValue < fence) {
-                std::cout << "GPU not done yet, setting event..." << std::endl;
-                std::cout.flush();
-                
-                hr = m_offlineFence->SetEventOnCompletion(fence, m_offlineFenceEvent);
-                if (FAILED(hr)) {
-                    char errMsg[256];
-                    sprintf_s(errMsg, "Failed to set fence event (HRESULT: 0x%08X)", hr);
-                    throw std::runtime_error(errMsg);
-                }
                 
-                std::cout << "Waiting for fence event..." << std::endl;
-                std::cout.flush();
-                
-                // Wait with timeout (5 seconds instead of 10)
-                DWORD waitResult = WaitForSingleObject(m_offlineFenceEvent, 5000);
-                if (waitResult == WAIT_TIMEOUT) {
-                    std::cerr << "ERROR: GPU wait timeout after 5 seconds!" << std::endl;
-                    std::cerr << "Current fence value: " << m_offlineFence->GetCompletedValue() << std::endl;
-                    std::cerr.flush();
-                    // Force cleanup and throw
-                    if (readbackBuffer) {
-                        readbackBuffer->Release();
-                        readbackBuffer = nullptr;
+                // Wait for the bucket's last batch, which also holds its readback copy
+                WaitForOfflineFence(m_offlineFenceValue - 1);
+
+                // GPU denoising: OIDN works on the shared buffer, then the result (or the noisy color if it
+                // failed) is tone mapped on the GPU and read back as 8-bit pixels, or read back as is for EXR
+                bool denoised = false;
+                if (gpuDenoise) {
+                    {
+                        ScopedTimer denoiseTimer(m_workStats.phases[PhaseIndex(RenderPhase::Denoise)].cpuMs);
+                        denoised = m_denoiser->DenoiseSharedHalf(
+                            0,
+                            static_cast<size_t>(imageStride),
+                            static_cast<size_t>(2 * imageStride),
+                            static_cast<size_t>(3 * imageStride),
+                            resolveBytesPerPixel,
+                            imageFootprint.Footprint.RowPitch,
+                            static_cast<int>(renderW),
+                            static_cast<int>(renderH)
+                        );
                     }
-                    throw std::runtime_error("GPU timeout - render operation took too long");
-                } else if (waitResult == WAIT_OBJECT_0) {
-                    std::cout << "GPU work completed successfully" << std::endl;
-                    std::cout.flush();
-                } else {
-                    std::cerr << "ERROR: WaitForSingleObject failed with result: " << waitResult << std::endl;
-                    std::cerr.flush();
-                    throw std::runtime_error("GPU wait failed unexpectedly");
+                    if (!denoised && !denoiserWarned) {
+                        std::cerr << "Denoising failed: " << m_denoiser->GetError() << std::endl;
+                        std::cout << "Saving original (non-denoised) image" << std::endl;
+                        denoiserWarned = true;
+                    }
+                    
+                    allocatorIndex = (allocatorIndex + 1) % OFFLINE_BATCHES_IN_FLIGHT;
+                    WaitForOfflineFence(m_offlineAllocatorFences[allocatorIndex]);
+                    ThrowIfFailed(m_offlineCommandAllocators[allocatorIndex]->Reset());
+                    ThrowIfFailed(renderCommandList->Reset(m_offlineCommandAllocators[allocatorIndex].Get(), nullptr));
+                    const UINT readbackRange = m_gpuProfiler.BeginRange(renderCommandList.Get(), PhaseIndex(RenderPhase::Readback));
+                    
+                    if (hdrFile) {
+                        // Linear output: the images share the readback buffer's layout, so plain buffer copies suffice
+                        const UINT64 sharedOffsets[] = { denoised ? 3 * imageStride : 0, imageStride, 2 * imageStride };
+                        const UINT64 imageBytes = static_cast<UINT64>(imageFootprint.Footprint.RowPitch) * (renderH - 1) +
+                                                  static_cast<UINT64>(renderW) * resolveBytesPerPixel;
+                        for (UINT image = 0; image < readbackImageCount; ++image) {
+                            renderCommandList->CopyBufferRegion(readbackBuffer.Get(), image * readbackImageStride,
+                                                                m_denoiseSharedBuffer.Get(), sharedOffsets[image], imageBytes);
+                        }
+                    } else {
+                        // Shared buffer -> HDR resolve texture (its alpha is ignored by the tone map)
+                        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                            m_resolveTexture.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST);
+                        renderCommandList->ResourceBarrier(1, &barrier);
+                        D3D12_TEXTURE_COPY_LOCATION sharedSrc = {};
+                        sharedSrc.pResource = m_denoiseSharedBuffer.Get();
+                        sharedSrc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                        sharedSrc.PlacedFootprint = imageFootprint;
+                        sharedSrc.PlacedFootprint.Offset = denoised ? 3 * imageStride : 0;
+                        D3D12_TEXTURE_COPY_LOCATION resolveDst = {};
+                        resolveDst.pResource = m_resolveTexture.Get();
+                        resolveDst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                        resolveDst.SubresourceIndex = 0;
+                        renderCommandList->CopyTextureRegion(&resolveDst, 0, 0, 0, &sharedSrc, nullptr);
+                        barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                            m_resolveTexture.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                        renderCommandList->ResourceBarrier(1, &barrier);
+                    
+                        RecordToneMap(renderCommandList.Get(), m_uavIndex_Resolve, m_uavIndex_ToneMapped, renderW, renderH);
+                    
+                        barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                            m_toneMappedTexture.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+                        renderCommandList->ResourceBarrier(1, &barrier);
+                        D3D12_TEXTURE_COPY_LOCATION readbackDst = {};
+                        readbackDst.pResource = readbackBuffer.Get();
+                        readbackDst.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                        readbackDst.PlacedFootprint = footprint;
+                        D3D12_TEXTURE_COPY_LOCATION toneMappedSrc = {};
+                        toneMappedSrc.pResource = m_toneMappedTexture.Get();
+                        toneMappedSrc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                        toneMappedSrc.SubresourceIndex = 0;
+                        D3D12_BOX toneMappedBox = { 0, 0, 0, renderW, renderH, 1 };
+                        renderCommandList->CopyTextureRegion(&readbackDst, 0, 0, 0, &toneMappedSrc, &toneMappedBox);
+                        barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                            m_toneMappedTexture.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                        renderCommandList->ResourceBarrier(1, &barrier);
+                    }
+                    m_gpuProfiler.EndRange(renderCommandList.Get(), readbackRange);
+                    
+                    ThrowIfFailed(renderCommandList->Close());
+                    ID3D12CommandList* lists[] = { renderCommandList.Get() };
+                    m_commandQueue->ExecuteCommandLists(1, lists);
+                    const UINT64 toneMapFence = m_offlineFenceValue;
+                    ThrowIfFailed(m_commandQueue->Signal(m_offlineFence.Get(), toneMapFence));
+                    m_offlineFenceValue++;
+                    m_offlineAllocatorFences[allocatorIndex] = toneMapFence;
+                    m_gpuProfiler.Submit(m_offlineFence.Get(), toneMapFence);
+                    WaitForOfflineFence(toneMapFence);
                 }
-            } else {
-                std::cout << "GPU already completed" << std::endl;
-                std::cout.flush();
-            }
-
-            // Read back data and save to PPM
-            std::cout << "Reading back data..." << std::endl;
-            void* mappedData;
-            ThrowIfFailed(readbackBuffer->Map(0, nullptr, &mappedData), "Failed to map readback buffer");
-
-            const float* pixels = static_cast<const float*>(mappedData); // Now reading float data
-
-            // 准备降噪数据
-            std::vector<float> inputImage(m_width * m_height * 3);
-            std::vector<float> denoisedImage(m_width * m_height * 3);
-            float invSamples = 1.0f / static_cast<float>(samplesPerPixel);
 
-            // 从GPU数据复制到输入图像（RGBA -> RGB，并平均采样）
-            std::cout << "Preparing image for denoising..." << std::endl;
-            for (UINT y = 0; y < m_height; ++y) {
-                const float* row = reinterpret_cast<const float*>(
-                    reinterpret_cast<const uint8_t*>(pixels) + y * footprint.Footprint.RowPitch
-                );
-                for (UINT x = 0; x < m_width; ++x) {
-                    const float* pixel = row + x * 4; // RGBA
-                    size_t idx = (y * m_width + x) * 3;
-                    inputImage[idx + 0] = pixel[0] * invSamples; // R
-                    inputImage[idx + 1] = pixel[1] * invSamples; // G
-                    inputImage[idx + 2] = pixel[2] * invSamples; // B
+                if (!denoiseBuckets && !denoiserWarned) {
+                    std::cout << "Denoiser not available, saving original image" << std::endl;
+                    denoiserWarned = true;
                 }
-            }
 
-            // 执行降噪
-            bool denoised = false;
-            if (m_denoiser && m_denoiser->IsInitialized()) {
-                std::cout << "Denoising image..." << std::endl;
-                denoised = m_denoiser->Denoise(
-                    inputImage.data(),
-                    denoisedImage.data(),
-                    m_width,
-                    m_height
-                );
-                if (!denoised) {
-                    std::cerr << "Denoising failed: " << m_denoiser->GetError() << std::endl;
-                    std::cout << "Saving original (non-denoised) image" << std::endl;
+                // The GPU is done with this bucket: it is read back, denoised (CPU denoiser) and converted on a worker
+                // while the next bucket renders. One bucket finishes at a time (the denoiser is not reentrant), and the
+                // previous one may belong to the previous frame of a sequence, so it is delivered before this one
+                FinishPendingBucket();
+                if (firstDelivery) {
+                    firstDelivery = false;
+                    if (beforeFirstBucket) {
+                        beforeFirstBucket();
+                    }
                 }
-            } else {
-                std::cout << "Denoiser not available, saving original image" << std::endl;
-            }
-
-            // 使用降噪后的图像（如果降噪成功）或原始图像
-            const float* finalImage = denoised ? denoisedImage.data() : inputImage.data();
-
-            // Write PPM file
-            std::cout << "Writing PPM file..." << std::endl;
-            std::ofstream file(outputPath, std::ios::binary);
-            if (!file.is_open()) {
-                readbackBuffer->Unmap(0, nullptr);
-                throw std::runtime_error("Failed to open output file: " + outputPath);
-            }
-
-            file << "P6\n" << m_width << " " << m_height << "\n255\n";
+                Denoiser* denoiser = (denoiseBuckets && !gpuDenoise) ? m_denoiser.get() : nullptr;
+                const ToneMapOperator toneMapOperator = m_toneMapOperator;
+                const float exposure = m_exposure;
+                const size_t rowPitch = footprint.Footprint.RowPitch;
+                TileScheduler* bucketScheduler = &scheduler;
+                m_pendingBucketBuffer = readbackBufferIndex;
+                m_pendingBucket = std::async(std::launch::async, [=]() {
+                    BucketFinishResult result;
+
+                    // Read back data
+                    void* mappedData;
+                    CD3DX12_RANGE readRange(0, static_cast<SIZE_T>((readbackImageCount - 1) * readbackImageStride +
+                                                                   static_cast<UINT64>(rowPitch) * renderH));
+                    ThrowIfFailed(readbackBuffer->Map(0, &readRange, &mappedData), "Failed to map readback buffer");
+                    const uint8_t* resolvedRows = static_cast<const uint8_t*>(mappedData);
+
+                    // 执行降噪 (含重叠边, 只保留中心区域); OIDN 直接读取 RGBA16F 回读数据, 以反照率/法线为引导
+                    std::vector<float> denoisedImage;
+                    bool cpuDenoised = false;
+                    if (denoiser) {
+                        ScopedTimer denoiseTimer(result.denoiseMs);
+                        denoisedImage.resize(static_cast<size_t>(renderW) * renderH * 3);
+                        cpuDenoised = denoiser->DenoiseHalf(
+                            resolvedRows,
+                            resolvedRows + readbackImageStride,
+                            resolvedRows + 2 * readbackImageStride,
+                            resolveBytesPerPixel,
+                            rowPitch,
+                            denoisedImage.data(),
+                            static_cast<int>(renderW),
+                            static_cast<int>(renderH)
+                        );
+                        if (!cpuDenoised) {
+                            result.denoiseError = denoiser->GetError();
+                        }
+                    }
 
-            // 将float图像转换为8位并写入
-            for (UINT y = 0; y < m_height; ++y) {
-                for (UINT x = 0; x < m_width; ++x) {
-                    size_t idx = (y * m_width + x) * 3;
-                    float r = finalImage[idx + 0];
-                    float g = finalImage[idx + 1];
-                    float b = finalImage[idx + 2];
-                    
-                    // Clamp and convert to 8-bit
-                    uint8_t rgb[3];
-                    rgb[0] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, r * 255.0f)));
-                    rgb[1] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, g * 255.0f)));
-                    rgb[2] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, b * 255.0f)));
-                    
-                    file.write(reinterpret_cast<const char*>(rgb), 3);
-                }
+                    // 写入当前分块 (EXR: 线性 float 平面, PPM: RGB 8位), 只保留中心区域
+                    ScopedTimer conversionTimer(result.conversionMs);
+                    const size_t planeFloats = static_cast<size_t>(coreW) * coreH * 3;
+                    std::vector<uint8_t> tilePixels(hdrFile ? 0 : planeFloats);
+                    std::vector<float> tilePlanes(hdrFile ? planeFloats * imageLayers : 0);
+                    if (hdrFile) {
+                        for (UINT y = 0; y < coreH; ++y) {
+                            const UINT srcY = coreY - renderY + y;
+                            const UINT srcX = coreX - renderX;
+                            float* dstRow = tilePlanes.data() + static_cast<size_t>(y) * coreW * 3;
+                            for (UINT image = 0; image < imageLayers; ++image) {
+                                float* dstPlaneRow = dstRow + image * planeFloats;
+                                if (image == 0 && cpuDenoised) {
+                                    const float* srcRow = denoisedImage.data() + (static_cast<size_t>(srcY) * renderW + srcX) * 3;
+                                    std::copy(srcRow, srcRow + coreW * 3, dstPlaneRow);
+                                    continue;
+                                }
+                                // Half float readback: color (denoised on the GPU or noisy), then albedo and normal
+                                const uint16_t* srcRow = reinterpret_cast<const uint16_t*>(
+                                    resolvedRows + image * readbackImageStride + srcY * rowPitch) + static_cast<size_t>(srcX) * 4;
+                                for (UINT x = 0; x < coreW; ++x) {
+                                    for (UINT c = 0; c < 3; ++c) {
+                                        dstPlaneRow[x * 3 + c] = DirectX::PackedVector::XMConvertHalfToFloat(srcRow[x * 4 + c]);
+                                    }
+                                }
+                            }
+                        }
+                    } else {
+                        for (UINT y = 0; y < coreH; ++y) {
+                            const UINT srcY = coreY - renderY + y;
+                            const UINT srcX = coreX - renderX;
+                            uint8_t* dstRow = tilePixels.data() + static_cast<size_t>(y) * coreW * 3;
+                            if (cpuDenoised) {
+                                // Denoised linear floats: same display transform as the resolve pass
+                                const float* srcRow = denoisedImage.data() + (static_cast<size_t>(srcY) * renderW + srcX) * 3;
+                                for (UINT i = 0; i < coreW * 3; ++i) {
+                                    dstRow[i] = ToneMapToUnorm8(srcRow[i], toneMapOperator, exposure);
+                                }
+                            } else if (denoiser) {
+                                // Denoising failed: convert the half float resolve
+                                const uint16_t* srcRow = reinterpret_cast<const uint16_t*>(resolvedRows + srcY * rowPitch) + static_cast<size_t>(srcX) * 4;
+                                for (UINT x = 0; x < coreW; ++x) {
+                                    for (UINT c = 0; c < 3; ++c) {
+                                        float value = DirectX::PackedVector::XMConvertHalfToFloat(srcRow[x * 4 + c]);
+                                        dstRow[x * 3 + c] = ToneMapToUnorm8(value, toneMapOperator, exposure);
+                                    }
+                                }
+                            } else {
+                                // Already tone mapped RGBA8 (resolve or GPU denoise path): drop alpha
+                                const uint8_t* srcRow = resolvedRows + srcY * rowPitch + static_cast<size_t>(srcX) * 4;
+                                for (UINT x = 0; x < coreW; ++x) {
+                                    dstRow[x * 3 + 0] = srcRow[x * 4 + 0];
+                                    dstRow[x * 3 + 1] = srcRow[x * 4 + 1];
+                                    dstRow[x * 3 + 2] = srcRow[x * 4 + 2];
+                                }
+                            }
+                        }
+                    }
+                    CD3DX12_RANGE writeRange(0, 0);
+                    readbackBuffer->Unmap(0, &writeRange);
+
+                    // The scheduler queues the row of buckets for the writer once all of its buckets arrived
+                    bucketScheduler->SubmitTile(tileIndex, tilePixels.data(), tilePlanes.data());
+                    return result;
+                });
+                reportProgress(0);
+                publishRenderStats();
             }
 
-            file.close();
-            readbackBuffer->Unmap(0, nullptr);
-
-            std::cout << "Render complete: " << outputPath << std::endl;
+            ACG_LOG_DEBUG("All buckets of this device dispatched");
+            publishRenderStats();
         }
         catch (const com_exception& e) {
+            // Keep the HRESULT when the error crosses the thread of another device
             char errMsg[512];
-            sprintf_s(errMsg, "RenderToFile DirectX error (HRESULT: 0x%08X): %s", e.get_result(), e.what());
-            std::cerr << errMsg << std::endl;
+            sprintf_s(errMsg, "DirectX error on adapter %u (HRESULT: 0x%08X): %s", m_adapterIndex, e.get_result(), e.what());
             throw std::runtime_error(errMsg);
         }
-        catch (const std::exception& e) {
-            std::string errMsg = std::string("RenderToFile exception: ") + (e.what() ? e.what() : "Unknown error");
-            std::cerr << errMsg << std::endl;
-            throw std::runtime_error(errMsg);
+    }
+
+
+    void Renderer::FinishPendingBucket() {
+        if (!m_pendingBucket.valid()) {
+            return;
         }
-        catch (...) {
-            std::cerr << "RenderToFile: Unknown exception caught" << std::endl;
-            throw std::runtime_error("Unknown error in RenderToFile");
+        const BucketFinishResult result = m_pendingBucket.get();
+        m_workStats.phases[PhaseIndex(RenderPhase::Denoise)].cpuMs += result.denoiseMs;
+        m_workStats.phases[PhaseIndex(RenderPhase::Readback)].cpuMs += result.conversionMs;
+        if (!result.denoiseError.empty() && !m_bucketDenoiseWarned) {
+            std::cerr << "Denoising failed: " << result.denoiseError << std::endl;
+            std::cout << "Saving original (non-denoised) image" << std::endl;
+            m_bucketDenoiseWarned = true;
         }
     }
 
+    void Renderer::DiscardPendingBucket() {
+        try {
+            FinishPendingBucket();
+        } catch (...) {
+            // Already unwinding from the error that stopped the render
+        }
+    }
 
     void Renderer::InitPipeline(HWND hwnd) {
         CreateDevice();
         CreateCommandQueueAndList();
-        CreateSwapChain(hwnd);
+        // Multi-GPU peers only render offline and have no window
+        if (hwnd) {
+            CreateSwapChain(hwnd);
+        }
         CreateDescriptorHeaps();
         CreateRenderTargets();
 
@@ -840,6 +1570,18 @@ namespace ACG {
         if (m_fenceEvent == nullptr) {
             ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
         }
+        
+        m_uploadRing.Initialize(m_device.Get(), UPLOAD_RING_SIZE);
+        
+        // Timestamp profilers are part of every build; copy queues only take timestamps when the device says so
+        m_gpuProfiler.Initialize(m_device.Get(), m_commandQueue.Get(), D3D12_QUERY_HEAP_TYPE_TIMESTAMP, RENDER_PHASE_COUNT);
+        D3D12_FEATURE_DATA_D3D12_OPTIONS3 options3 = {};
+        if (SUCCEEDED(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS3, &options3, sizeof(options3))) &&
+            options3.CopyQueueTimestampQueriesSupported) {
+            m_copyProfiler.Initialize(m_device.Get(), m_copyQueue.Get(), D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP, RENDER_PHASE_COUNT);
+        } else {
+            std::cout << "Copy queue timestamps not supported, texture uploads are timed on the CPU only" << std::endl;
+        }
 
         std::cout << "DX12 pipeline initialized successfully" << std::endl;
     }
@@ -853,7 +1595,15 @@ namespace ACG {
             std::cout << "D3D12 Debug Layer enabled" << std::endl;
         }
 #endif
-        m_adapter = GetAdapter(false);
+        if (m_adapterIndex == 0) {
+            m_adapter = GetAdapter(false);
+        } else {
+            std::vector<Microsoft::WRL::ComPtr<IDXGIAdapter4>> adapters = EnumerateHardwareAdapters();
+            if (m_adapterIndex >= adapters.size()) {
+                throw std::runtime_error("Adapter " + std::to_string(m_adapterIndex) + " not found");
+            }
+            m_adapter = adapters[m_adapterIndex];
+        }
         ThrowIfFailed(D3D12CreateDevice(m_adapter.Get(), D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&m_device)));
     }
 
@@ -878,6 +1628,25 @@ namespace ACG {
             nullptr, 
             IID_PPV_ARGS(&m_commandList)));
         ThrowIfFailed(m_commandList->Close());
+
+        // Dedicated copy queue for scene uploads
+        D3D12_COMMAND_QUEUE_DESC copyQueueDesc = {};
+        copyQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        copyQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+        ThrowIfFailed(m_device->CreateCommandQueue(&copyQueueDesc, IID_PPV_ARGS(&m_copyQueue)), "Failed to create copy queue");
+        m_copyQueue->SetName(L"Upload Copy Queue");
+        for (auto& allocator : m_copyCommandAllocators) {
+            ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator)),
+                "Failed to create copy command allocator");
+        }
+        ThrowIfFailed(m_device->CreateCommandList(
+            0,
+            D3D12_COMMAND_LIST_TYPE_COPY,
+            m_copyCommandAllocators[0].Get(),
+            nullptr,
+            IID_PPV_ARGS(&m_copyCommandList)), "Failed to create copy command list");
+        ThrowIfFailed(m_copyCommandList->Close());
+        ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_copyFence)), "Failed to create copy fence");
     }
 
     void Renderer::CreateSwapChain(HWND hwnd) {
@@ -892,6 +1661,8 @@ namespace ACG {
         swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
         swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
         swapChainDesc.SampleDesc.Count = 1;
+        // Frame pacing: the render loop waits until the previous frame is on screen before starting the next
+        swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
 
         Microsoft::WRL::ComPtr<IDXGISwapChain1> swapChain;
         ThrowIfFailed(factory->CreateSwapChainForHwnd(
@@ -906,6 +1677,10 @@ namespace ACG {
         ThrowIfFailed(factory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
         ThrowIfFailed(swapChain.As(&m_swapChain));
         m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+        
+        // One queued frame: input (camera moves) is sampled right before the frame that shows it
+        ThrowIfFailed(m_swapChain->SetMaximumFrameLatency(1), "Failed to set maximum frame latency");
+        m_frameLatencyWaitableObject = m_swapChain->GetFrameLatencyWaitableObject();
 
         std::cout << "SwapChain created successfully" << std::endl;
     }
@@ -921,7 +1696,7 @@ namespace ACG {
 
         // Create SRV/UAV heap for DXR (raytracing resources)
         D3D12_DESCRIPTOR_HEAP_DESC srvUavHeapDesc = {};
-        srvUavHeapDesc.NumDescriptors = 15; // UAV(output) + SRV(TLAS, vertices, indices, triangleMaterials, materials, materialLayers, textures, environment map, virtual texture cache, indirection texture)
+        srvUavHeapDesc.NumDescriptors = m_srvIndex_Textures + MAX_BINDLESS_TEXTURES + MIP_VIEW_DESCRIPTORS; // UAV(output) + SRV(TLAS, vertices, indices, triangleMaterials, materials, unused, environment map, virtual texture cache, materialLayers, unused, VT indirection, VT info, VT feedback) + UAV(luminance moments, active pixel count, preview display, offline resolve, albedo/normal AOV sums, resolved albedo/normal, tone mapped bucket) + SRV(environment conditional/marginal CDF, alpha mask bits/info, vertex attributes, instance materials, sampler tables) + bindless scene textures + mip generation views
         srvUavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         srvUavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
         ThrowIfFailed(m_device->CreateDescriptorHeap(&srvUavHeapDesc, IID_PPV_ARGS(&m_srvUavHeap)));
@@ -937,6 +1712,9 @@ namespace ACG {
     }
 
     void Renderer::CreateRenderTargets() {
+        if (!m_swapChain) {
+            return;
+        }
         D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
 
         for (UINT i = 0; i < FrameCount; i++) {
@@ -955,7 +1733,33 @@ namespace ACG {
         try {
             std::cout << "Compiling shader library..." << std::endl;
             // Compile shader library
-            m_raytracingShaderLibrary = CompileShader(L"shaders/Raytracing.hlsl");
+            if (m_inlineRayQuery && m_raytracingTier < D3D12_RAYTRACING_TIER_1_1) {
+                std::cerr << "Inline RayQuery needs DXR Tier 1.1, using the shader table path" << std::endl;
+                m_inlineRayQuery = false;
+            }
+            std::vector<std::wstring> defines;
+            if (m_inlineRayQuery) {
+                defines.push_back(L"INLINE_RAY_QUERY=1");
+                std::cout << "Ray tracing mode: inline RayQuery" << std::endl;
+            }
+            
+            // SER reorders TraceRay hits, so it does not apply to the inline path
+            m_shaderExecutionReordering = m_shaderExecutionReordering && m_shaderModel69 && !m_inlineRayQuery;
+            if (m_shaderExecutionReordering) {
+                try {
+                    std::vector<std::wstring> serDefines = defines;
+                    serDefines.push_back(L"SHADER_EXECUTION_REORDERING=1");
+                    m_raytracingShaderLibrary = CompileShader(L"shaders/Raytracing.hlsl", L"", L"lib_6_9", serDefines);
+                    std::cout << "Shader Execution Reordering enabled (coherence hint: shading branch + material)" << std::endl;
+                } catch (const std::exception& e) {
+                    // e.g. a DXC without SM 6.9 support
+                    std::cerr << "Shader Execution Reordering unavailable: " << e.what() << std::endl;
+                    m_shaderExecutionReordering = false;
+                }
+            }
+            if (!m_shaderExecutionReordering) {
+                m_raytracingShaderLibrary = CompileShader(L"shaders/Raytracing.hlsl", L"", L"lib_6_6", defines);
+            }
             
             if (!m_raytracingShaderLibrary) {
                 throw std::runtime_error("Shader compilation returned null");
@@ -975,28 +1779,43 @@ namespace ACG {
             libdxil.BytecodeLength = m_raytracingShaderLibrary->GetBufferSize();
             libdxil.pShaderBytecode = m_raytracingShaderLibrary->GetBufferPointer();
             lib->SetDXILLibrary(&libdxil);
-            const WCHAR* shaderExports[] = { L"RayGen", L"Miss", L"ClosestHit" };
+            const WCHAR* shaderExports[] = { L"RayGen", L"Miss", L"ShadowMiss", L"ClosestHit",
+                L"ClosestHitEmissive", L"ClosestHitTransmission", L"ClosestHitMirror", L"ClosestHitDiffuse",
+                L"AnyHitAlphaTest", L"ShadowAnyHitAlphaTest" };
             lib->DefineExports(shaderExports);
 
-            // 2. Hit Group
-            auto hitGroup = raytracingPipeline.CreateSubobject<CD3DX12_HIT_GROUP_SUBOBJECT>();
-            hitGroup->SetClosestHitShaderImport(L"ClosestHit");
-            hitGroup->SetHitGroupExport(L"HitGroup");
-            hitGroup->SetHitGroupType(D3D12_HIT_GROUP_TYPE_TRIANGLES);
+            // 2. Hit Groups: one per material class, the uber shader and the alpha-tested groups
+            for (const HitGroupExports& exports : HIT_GROUPS) {
+                auto hitGroup = raytracingPipeline.CreateSubobject<CD3DX12_HIT_GROUP_SUBOBJECT>();
+                if (exports.closestHit) {
+                    hitGroup->SetClosestHitShaderImport(exports.closestHit);
+                }
+                if (exports.anyHit) {
+                    hitGroup->SetAnyHitShaderImport(exports.anyHit);
+                }
+                hitGroup->SetHitGroupExport(exports.hitGroup);
+                hitGroup->SetHitGroupType(D3D12_HIT_GROUP_TYPE_TRIANGLES);
+            }
 
             // 3. Shader Config
             auto shaderConfig = raytracingPipeline.CreateSubobject<CD3DX12_RAYTRACING_SHADER_CONFIG_SUBOBJECT>();
-            // RadiancePayload layout in HLSL:
-            //   float3 radiance;      // 12
-            //   float3 throughput;    // 12
-            //   float3 nextOrigin;    // 12
-            //   float3 nextDirection; // 12
-            //   uint   rngState;      // 4
-            //   bool   terminated;    // 4 (HLSL bool is 4 bytes)
-            //   float  iorStack[4];   // 16
-            //   uint   iorStackTop;   // 4
-            // Total = 76 bytes
-            UINT payloadSize = (4 * 3 * sizeof(float)) + (2 * sizeof(UINT)) + (4 * sizeof(float)) + sizeof(UINT);
+            // RadiancePayload layout in HLSL (packed, the hit/miss shaders unpack it into PathState):
+            //   float3 radiance;        // 12
+            //   uint   nextDirection;   // 4 (octahedral)
+            //   float3 nextOrigin;      // 12
+            //   uint   rngState;        // 4
+            //   uint2  throughputFlags; // 8 (half3 throughput + flags)
+            //   uint2  iorStack;        // 8 (3 halves)
+            //   float  coneWidth;       // 4
+            //   float  coneSpread;      // 4
+            //   float  bsdfPdf;         // 4
+            //   float  shadowDistance;  // 4
+            //   float3 shadowRadiance;  // 12
+            //   uint   shadowDirection; // 4 (octahedral)
+            //   uint   firstHitAlbedo;  // 4 (unorm 10:10:10 + has-normal bit)
+            //   uint   firstHitNormal;  // 4 (octahedral)
+            // Total = 88 bytes (ShadowPayload is a single bool and fits)
+            UINT payloadSize = (3 * 3 * sizeof(float)) + (5 * sizeof(UINT)) + (4 * sizeof(UINT)) + (4 * sizeof(float));
             UINT attributeSize = 2 * sizeof(float); // BuiltInTriangleIntersectionAttributes: float2 barycentrics
             shaderConfig->Config(payloadSize, attributeSize);
 
@@ -1004,6 +1823,15 @@ namespace ACG {
             auto globalRootSignature = raytracingPipeline.CreateSubobject<CD3DX12_GLOBAL_ROOT_SIGNATURE_SUBOBJECT>();
             globalRootSignature->SetRootSignature(m_raytracingGlobalRootSignature.Get());
 
+            // 5. Local Root Signature: the hit group record carries the BLAS material (b1)
+            auto localRootSignature = raytracingPipeline.CreateSubobject<CD3DX12_LOCAL_ROOT_SIGNATURE_SUBOBJECT>();
+            localRootSignature->SetRootSignature(m_raytracingMaterialLocalRootSignature.Get());
+            auto localRootSignatureAssociation = raytracingPipeline.CreateSubobject<CD3DX12_SUBOBJECT_TO_EXPORTS_ASSOCIATION_SUBOBJECT>();
+            localRootSignatureAssociation->SetSubobjectToAssociate(*localRootSignature);
+            for (const HitGroupExports& exports : HIT_GROUPS) {
+                localRootSignatureAssociation->AddExport(exports.hitGroup);
+            }
+
             // 7. Pipeline Config
             auto pipelineConfig = raytracingPipeline.CreateSubobject<CD3DX12_RAYTRACING_PIPELINE_CONFIG_SUBOBJECT>();
             UINT maxRecursionDepth = 1; // No recursion - iterative path tracing in RayGen
@@ -1043,6 +1871,13 @@ namespace ACG {
         }
 
         m_dxrSupported = true;
+        m_raytracingTier = features.RaytracingTier;
+        
+        // SM 6.9 (HitObject, MaybeReorderThread); the value is D3D_SHADER_MODEL_6_9 of newer SDK headers.
+        // Runtimes that don't know the model fail the query, which leaves SER off
+        D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = { static_cast<D3D_SHADER_MODEL>(0x69) };
+        m_shaderModel69 = SUCCEEDED(m_device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))) &&
+                          shaderModel.HighestShaderModel >= static_cast<D3D_SHADER_MODEL>(0x69);
         std::cout << "DirectX Raytracing supported (Tier ";
         switch (features.RaytracingTier) {
             case D3D12_RAYTRACING_TIER_1_0:
@@ -1058,26 +1893,19 @@ namespace ACG {
         std::cout << ")" << std::endl;
     }
 
-    Microsoft::WRL::ComPtr<IDxcBlob> Renderer::CompileShader(const std::wstring& filename) {
+    Microsoft::WRL::ComPtr<IDxcBlob> Renderer::CompileShader(const std::wstring& filename, const std::wstring& entryPoint,
+                                                           const std::wstring& target, const std::vector<std::wstring>& defines) {
         // Initialize DXC compiler
         Microsoft::WRL::ComPtr<IDxcUtils> utils;
         Microsoft::WRL::ComPtr<IDxcCompiler3> compiler;
         ThrowIfFailed(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils)));
         ThrowIfFailed(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler)));
 
-        // Create default include handler
-        Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler;
-        ThrowIfFailed(utils->CreateDefaultIncludeHandler(&includeHandler));
-
-        // Load shader source
-        Microsoft::WRL::ComPtr<IDxcBlobEncoding> sourceBlob;
-        ThrowIfFailed(utils->LoadFile(filename.c_str(), nullptr, &sourceBlob));
-
         // Compile arguments
         std::vector<LPCWSTR> arguments = {
             filename.c_str(),
-            L"-E", L"",  // No entry point for library
-            L"-T", L"lib_6_6",  // Shader model 6.6 for GeometryIndex() support
+            L"-E", entryPoint.c_str(),  // Empty for libraries
+            L"-T", target.c_str(),      // lib_6_6 by default: shader model 6.6 for GeometryIndex() support
             L"-I", L"shaders",  // Include directory
             L"-HV", L"2021",
 #ifdef _DEBUG
@@ -1087,6 +1915,52 @@ namespace ACG {
             L"-O3",
 #endif
         };
+        // Payload access qualifiers are on by default from SM 6.7; the payload structs don't declare them.
+        // Compare the version numerically: as strings, "lib_6_10" sorts below "lib_6_7"
+        unsigned major = 0, minor = 0;
+        if (target.rfind(L"lib_", 0) == 0 && swscanf_s(target.c_str() + 4, L"%u_%u", &major, &minor) == 2 &&
+            (major > 6 || (major == 6 && minor >= 7))) {
+            arguments.push_back(L"-disable-payload-qualifiers");
+        }
+        for (const std::wstring& define : defines) {
+            arguments.push_back(L"-D");
+            arguments.push_back(define.c_str());
+        }
+
+        // DXIL cache key: the source with all its includes, the arguments and the compiler build
+        uint64_t cacheKey = ShaderCache::HashSourceTree(std::filesystem::path(filename), "shaders");
+        for (LPCWSTR argument : arguments) {
+            cacheKey = ShaderCache::Hash(argument, wcslen(argument) * sizeof(wchar_t), cacheKey);
+        }
+        Microsoft::WRL::ComPtr<IDxcVersionInfo> versionInfo;
+        if (SUCCEEDED(compiler.As(&versionInfo))) {
+            UINT32 version[2] = {};
+            versionInfo->GetVersion(&version[0], &version[1]);
+            cacheKey = ShaderCache::Hash(version, sizeof(version), cacheKey);
+        }
+        Microsoft::WRL::ComPtr<IDxcVersionInfo2> commitInfo;
+        char* commitHash = nullptr;
+        UINT32 commitCount = 0;
+        if (SUCCEEDED(compiler.As(&commitInfo)) && SUCCEEDED(commitInfo->GetCommitInfo(&commitCount, &commitHash)) && commitHash) {
+            cacheKey = ShaderCache::Hash(commitHash, strlen(commitHash), cacheKey);
+            CoTaskMemFree(commitHash);
+        }
+        
+        std::vector<uint8_t> cachedDxil;
+        if (ShaderCache::LoadShader(cacheKey, cachedDxil)) {
+            Microsoft::WRL::ComPtr<IDxcBlobEncoding> cachedBlob;
+            ThrowIfFailed(utils->CreateBlob(cachedDxil.data(), static_cast<UINT32>(cachedDxil.size()), DXC_CP_ACP, &cachedBlob));
+            std::wcout << L"Shader loaded from cache: " << filename << std::endl;
+            return cachedBlob;
+        }
+
+        // Create default include handler
+        Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler;
+        ThrowIfFailed(utils->CreateDefaultIncludeHandler(&includeHandler));
+
+        // Load shader source
+        Microsoft::WRL::ComPtr<IDxcBlobEncoding> sourceBlob;
+        ThrowIfFailed(utils->LoadFile(filename.c_str(), nullptr, &sourceBlob));
 
         DxcBuffer sourceBuffer = {};
         sourceBuffer.Ptr = sourceBlob->GetBufferPointer();
@@ -1115,26 +1989,157 @@ namespace ACG {
 
         Microsoft::WRL::ComPtr<IDxcBlob> shader;
         result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&shader), nullptr);
+        if (shader) {
+            ShaderCache::StoreShader(cacheKey, shader->GetBufferPointer(), shader->GetBufferSize());
+        }
         
         std::wcout << L"Shader compiled successfully: " << filename << std::endl;
         return shader;
     }
 
+    bool Renderer::PrecompileShaders() {
+        // Every variant the pipelines may request (keep in sync with the Create*Pipeline functions)
+        struct ShaderVariant {
+            const wchar_t* filename;
+            const wchar_t* entryPoint;
+            const wchar_t* target;
+            std::vector<std::wstring> defines;
+            bool optional;  // Needs a newer DXC than the minimum (SM 6.9)
+        };
+        const ShaderVariant variants[] = {
+            { L"shaders/Raytracing.hlsl", L"", L"lib_6_6", {}, false },
+            { L"shaders/Raytracing.hlsl", L"", L"lib_6_6", { L"INLINE_RAY_QUERY=1" }, false },
+            { L"shaders/Raytracing.hlsl", L"", L"lib_6_9", { L"SHADER_EXECUTION_REORDERING=1" }, true },
+            { L"shaders/Resolve.hlsl", L"ResolveCS", L"cs_6_6", {}, false },
+            { L"shaders/Resolve.hlsl", L"ToneMapCS", L"cs_6_6", {}, false },
+            { L"shaders/EnvironmentCDF.hlsl", L"RowCdfCS", L"cs_6_6", {}, false },
+            { L"shaders/EnvironmentCDF.hlsl", L"MarginalCdfCS", L"cs_6_6", {}, false },
+            { L"shaders/Mipmap.hlsl", L"DownsampleCS", L"cs_6_6", {}, false },
+        };
+        
+        bool succeeded = true;
+        for (const ShaderVariant& variant : variants) {
+            try {
+                CompileShader(variant.filename, variant.entryPoint, variant.target, variant.defines);
+            } catch (const std::exception& e) {
+                std::wcerr << L"Failed to precompile " << variant.filename << L" (" << variant.target << L")" << std::endl;
+                std::cerr << "  " << e.what() << std::endl;
+                succeeded = succeeded && variant.optional;
+            }
+        }
+        return succeeded;
+    }
+
+    void Renderer::OpenPipelineLibrary() {
+        m_pipelineLibrary.Reset();
+        m_pipelineLibraryData.clear();
+        m_pipelineLibraryDirty = false;
+        
+        D3D12_FEATURE_DATA_SHADER_CACHE shaderCache = {};
+        Microsoft::WRL::ComPtr<ID3D12Device1> device1;
+        if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shaderCache, sizeof(shaderCache))) ||
+            !(shaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY) || FAILED(m_device.As(&device1))) {
+            std::cout << "Pipeline library not supported, compute pipelines are created from bytecode" << std::endl;
+            return;
+        }
+        
+        // The library reads from the serialized data for its whole lifetime, so the member keeps it
+        if (ShaderCache::LoadBlob(GetPipelineLibraryFile(m_adapterIndex), m_pipelineLibraryData)) {
+            HRESULT hr = device1->CreatePipelineLibrary(m_pipelineLibraryData.data(), m_pipelineLibraryData.size(),
+                                                        IID_PPV_ARGS(&m_pipelineLibrary));
+            if (SUCCEEDED(hr)) {
+                std::cout << "Pipeline library loaded (" << m_pipelineLibraryData.size() / 1024 << " KB)" << std::endl;
+                return;
+            }
+            // Driver or adapter changed since it was written (D3D12_ERROR_DRIVER_VERSION_MISMATCH / ADAPTER_NOT_FOUND)
+            char message[128];
+            sprintf_s(message, "Pipeline library is stale (HRESULT: 0x%08X), rebuilding", hr);
+            std::cout << message << std::endl;
+            m_pipelineLibraryData.clear();
+        }
+        if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_pipelineLibrary)))) {
+            m_pipelineLibrary.Reset();
+        }
+    }
+
+    HRESULT Renderer::CreateComputePipeline(const wchar_t* name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+                                            Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipeline) {
+        // Entries are named after the bytecode, so an edited shader adds an entry instead of mismatching the old one
+        wchar_t entryName[128];
+        swprintf_s(entryName, L"%s_%016llx", name, static_cast<unsigned long long>(
+            ShaderCache::Hash(desc.CS.pShaderBytecode, desc.CS.BytecodeLength)));
+        if (m_pipelineLibrary && SUCCEEDED(m_pipelineLibrary->LoadComputePipeline(entryName, &desc, IID_PPV_ARGS(&pipeline)))) {
+            return S_OK;
+        }
+        
+        HRESULT hr = m_device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipeline));
+        if (SUCCEEDED(hr) && m_pipelineLibrary && SUCCEEDED(m_pipelineLibrary->StorePipeline(entryName, pipeline.Get()))) {
+            m_pipelineLibraryDirty = true;
+        }
+        return hr;
+    }
+
+    void Renderer::SavePipelineLibrary() {
+        if (!m_pipelineLibrary || !m_pipelineLibraryDirty) {
+            return;
+        }
+        std::vector<uint8_t> data(m_pipelineLibrary->GetSerializedSize());
+        if (SUCCEEDED(m_pipelineLibrary->Serialize(data.data(), data.size()))) {
+            ShaderCache::StoreBlob(GetPipelineLibraryFile(m_adapterIndex), data.data(), data.size());
+            std::cout << "Pipeline library saved (" << data.size() / 1024 << " KB)" << std::endl;
+        }
+        m_pipelineLibraryDirty = false;
+    }
+
     void Renderer::CreateRaytracingRootSignature() {
         // Create a root signature with global resources
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[12];  // Extended for Texture Scales
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[11];  // Entries 6 and 9 unused: textures are bindless, the VT ranges have their own table
         ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0); // u0: output texture
         ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0); // t0: acceleration structure
-        ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1, 0); // t1 space0: vertices
+        ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1, 0); // t1 space0: vertex positions
         ranges[3].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1, 1); // t1 space1: indices
-        ranges[4].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1, 2); // t1 space2: triangle material indices
+        ranges[4].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1, 2); // t1 space2: per-face material indices
         ranges[5].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2); // t2: materials
-        ranges[6].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 3); // t3: textures (texture array)
         ranges[7].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 4); // t4: environment map
         ranges[8].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 5); // t5: virtual texture cache
-        ranges[9].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 6); // t6: indirection texture
         ranges[10].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 7); // t7: material layers
-        ranges[11].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 8); // t8: texture scales
+
+        // Virtual texture table (descriptor slots 10-12, contiguous)
+        CD3DX12_DESCRIPTOR_RANGE1 vtRanges[3];
+        vtRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 6); // t6: indirection texture
+        vtRanges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 9); // t9: per-texture info
+        vtRanges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 1); // u1: tile request feedback
+
+        // Adaptive sampling table (descriptor slots 13-14, contiguous)
+        CD3DX12_DESCRIPTOR_RANGE1 adaptiveRanges[2];
+        adaptiveRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 2); // u2: luminance moments
+        adaptiveRanges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 3); // u3: active pixel count
+
+        // Denoiser guide AOV table (descriptor slots 17-18, contiguous)
+        CD3DX12_DESCRIPTOR_RANGE1 aovRanges[1];
+        aovRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 2, 4); // u4: albedo sum, u5: normal sum
+
+        // Environment importance sampling table (descriptor slots 22-23, contiguous)
+        CD3DX12_DESCRIPTOR_RANGE1 envCdfRanges[1];
+        envCdfRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 11); // t11: conditional CDF, t12: marginal CDF
+
+        // Vertex streams: positions in slot 1, quantized attributes in slot 26 (offset from the table start)
+        CD3DX12_DESCRIPTOR_RANGE1 vertexRanges[2];
+        vertexRanges[0] = ranges[2];
+        vertexRanges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 15, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE,
+            m_srvIndex_VertexAttributes - m_srvIndex_Vertices); // t15: normal + UV
+
+        // Material ids: per-face buffer in slot 3, per-instance table in slot 27
+        CD3DX12_DESCRIPTOR_RANGE1 materialIndexRanges[2];
+        materialIndexRanges[0] = ranges[4];
+        materialIndexRanges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 16, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE,
+            m_srvIndex_InstanceMaterials - m_srvIndex_TriangleMaterials); // t16: per-instance material id
+
+        // Lookup tables: alpha cutouts in slots 24-25, sampler tables in slot 28
+        CD3DX12_DESCRIPTOR_RANGE1 alphaMaskRanges[2];
+        alphaMaskRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 13); // t13: mask bits, t14: per-material mask info
+        alphaMaskRanges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 17, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE,
+            m_srvIndex_SamplerTables - m_srvIndex_AlphaMasks); // t17: Sobol matrices + blue-noise ranks
 
         // Static sampler for texture sampling (with WRAP address mode for tiling)
         CD3DX12_STATIC_SAMPLER_DESC samplerDesc(
@@ -1144,25 +2149,29 @@ namespace ACG {
             D3D12_TEXTURE_ADDRESS_MODE_WRAP,       // addressV
             D3D12_TEXTURE_ADDRESS_MODE_WRAP);      // addressW
 
-        CD3DX12_ROOT_PARAMETER1 rootParameters[13];  // Extended for Texture Scales
+        // Scene textures have no table: the shader indexes their SRVs straight from the heap (SM 6.6 ResourceDescriptorHeap)
+        CD3DX12_ROOT_PARAMETER1 rootParameters[16];  // Extended for adaptive sampling, denoiser AOVs, lights and alpha masks
         rootParameters[0].InitAsDescriptorTable(1, &ranges[0]); // Output UAV
         rootParameters[1].InitAsShaderResourceView(0); // Acceleration structure (SRV)
-        rootParameters[2].InitAsDescriptorTable(1, &ranges[2]); // Vertices (t1, space0)
+        rootParameters[2].InitAsDescriptorTable(_countof(vertexRanges), vertexRanges); // Positions (t1), attributes (t15)
         rootParameters[3].InitAsDescriptorTable(1, &ranges[3]); // Indices (t1, space1)
-        rootParameters[4].InitAsDescriptorTable(1, &ranges[4]); // Triangle material indices (t1, space2)
+        rootParameters[4].InitAsDescriptorTable(_countof(materialIndexRanges), materialIndexRanges); // Per-face (t1, space2), per-instance (t16) material ids
         rootParameters[5].InitAsShaderResourceView(2); // Materials (t2) - ROOT DESCRIPTOR
-        rootParameters[6].InitAsDescriptorTable(1, &ranges[6]); // Textures (t3)
-        rootParameters[7].InitAsDescriptorTable(1, &ranges[7]); // Environment map (t4)
-        rootParameters[8].InitAsDescriptorTable(1, &ranges[8]); // Virtual texture cache (t5)
-        rootParameters[9].InitAsDescriptorTable(1, &ranges[9]); // Indirection texture (t6)
-        rootParameters[10].InitAsDescriptorTable(1, &ranges[10]); // Material layers (t7)
-        rootParameters[11].InitAsDescriptorTable(1, &ranges[11]); // Texture scales (t8)
+        rootParameters[6].InitAsDescriptorTable(1, &ranges[7]); // Environment map (t4)
+        rootParameters[7].InitAsDescriptorTable(1, &ranges[8]); // Virtual texture cache (t5)
+        rootParameters[8].InitAsDescriptorTable(_countof(vtRanges), vtRanges); // Indirection (t6), VT info (t9), feedback (u1)
+        rootParameters[9].InitAsDescriptorTable(1, &ranges[10]); // Material layers (t7)
         // Scene constants (b0): view and projection matrices
-        rootParameters[12].InitAsConstants(sizeof(CameraConstants) / 4, 0);
+        rootParameters[10].InitAsConstants(sizeof(CameraConstants) / 4, 0);
+        rootParameters[11].InitAsDescriptorTable(_countof(adaptiveRanges), adaptiveRanges); // Moments (u2), active pixel count (u3)
+        rootParameters[12].InitAsDescriptorTable(_countof(aovRanges), aovRanges); // Albedo (u4), normal (u5) AOV sums
+        rootParameters[13].InitAsShaderResourceView(10); // Emissive light list (t10) - ROOT DESCRIPTOR
+        rootParameters[14].InitAsDescriptorTable(_countof(envCdfRanges), envCdfRanges); // Environment CDFs (t11, t12)
+        rootParameters[15].InitAsDescriptorTable(_countof(alphaMaskRanges), alphaMaskRanges); // Alpha masks (t13, t14), sampler tables (t17)
 
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
         rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 1, &samplerDesc,
-            D3D12_ROOT_SIGNATURE_FLAG_NONE);
+            D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED);
 
         Microsoft::WRL::ComPtr<ID3DBlob> signature;
         Microsoft::WRL::ComPtr<ID3DBlob> error;
@@ -1172,9 +2181,276 @@ namespace ACG {
             signature->GetBufferSize(), IID_PPV_ARGS(&m_raytracingGlobalRootSignature)),
             "Failed to create root signature");
             
+        // Local root signature of the hit groups: MaterialData as 16 root constants
+        CD3DX12_ROOT_PARAMETER1 localParameters[1];
+        localParameters[0].InitAsConstants(sizeof(MaterialData) / sizeof(uint32_t), 1); // b1: g_localMaterial
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC localSignatureDesc;
+        localSignatureDesc.Init_1_1(_countof(localParameters), localParameters, 0, nullptr,
+            D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE);
+        signature.Reset();
+        error.Reset();
+        ThrowIfFailed(D3D12SerializeVersionedRootSignature(&localSignatureDesc, &signature, &error),
+            "Failed to serialize local root signature");
+        ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(),
+            signature->GetBufferSize(), IID_PPV_ARGS(&m_raytracingMaterialLocalRootSignature)),
+            "Failed to create local root signature");
+            
         std::cout << "Root signature created (with Material Layers + Virtual Texture support)" << std::endl;
     }
 
+    void Renderer::CreateResolvePipeline() {
+        try {
+            Microsoft::WRL::ComPtr<IDxcBlob> resolveShader = CompileShader(L"shaders/Resolve.hlsl", L"ResolveCS", L"cs_6_6");
+            Microsoft::WRL::ComPtr<IDxcBlob> toneMapShader = CompileShader(L"shaders/Resolve.hlsl", L"ToneMapCS", L"cs_6_6");
+            
+            CD3DX12_DESCRIPTOR_RANGE1 ranges[3];
+            ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0); // u0: accumulation texture
+            ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 1); // u1: display texture
+            ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 4, 2); // u2-u5: AOV sums, resolved AOVs (slots 17-20)
+            
+            CD3DX12_ROOT_PARAMETER1 rootParameters[4];
+            rootParameters[0].InitAsDescriptorTable(1, &ranges[0]);
+            rootParameters[1].InitAsDescriptorTable(1, &ranges[1]);
+            rootParameters[2].InitAsConstants(6, 0); // b0: output size, exposure, operator, HDR flag, AOV flag
+            rootParameters[3].InitAsDescriptorTable(1, &ranges[2]);
+            
+            CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+            rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+            
+            Microsoft::WRL::ComPtr<ID3DBlob> signature;
+            Microsoft::WRL::ComPtr<ID3DBlob> error;
+            ThrowIfFailed(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, &error),
+                "Failed to serialize resolve root signature");
+            ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(),
+                signature->GetBufferSize(), IID_PPV_ARGS(&m_resolveRootSignature)),
+                "Failed to create resolve root signature");
+            
+            D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+            psoDesc.pRootSignature = m_resolveRootSignature.Get();
+            psoDesc.CS.pShaderBytecode = resolveShader->GetBufferPointer();
+            psoDesc.CS.BytecodeLength = resolveShader->GetBufferSize();
+            ThrowIfFailed(CreateComputePipeline(L"ResolveCS", psoDesc, m_resolvePipelineState),
+                "Failed to create resolve pipeline state");
+            
+            psoDesc.CS.pShaderBytecode = toneMapShader->GetBufferPointer();
+            psoDesc.CS.BytecodeLength = toneMapShader->GetBufferSize();
+            ThrowIfFailed(CreateComputePipeline(L"ToneMapCS", psoDesc, m_toneMapPipelineState),
+                "Failed to create tone map pipeline state");
+            
+            std::cout << "Resolve pipeline created successfully" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to create resolve pipeline: " << e.what() << " (interactive preview disabled)" << std::endl;
+            m_resolvePipelineState.Reset();
+            m_toneMapPipelineState.Reset();
+        }
+    }
+
+    void Renderer::CreateEnvironmentCdfPipeline() {
+        try {
+            Microsoft::WRL::ComPtr<IDxcBlob> rowShader = CompileShader(L"shaders/EnvironmentCDF.hlsl", L"RowCdfCS", L"cs_6_6");
+            Microsoft::WRL::ComPtr<IDxcBlob> marginalShader = CompileShader(L"shaders/EnvironmentCDF.hlsl", L"MarginalCdfCS", L"cs_6_6");
+            
+            CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
+            ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0); // t0: environment map (slot 6)
+            
+            CD3DX12_ROOT_PARAMETER1 rootParameters[4];
+            rootParameters[0].InitAsDescriptorTable(1, &ranges[0]);
+            rootParameters[1].InitAsUnorderedAccessView(0); // u0: conditional CDF
+            rootParameters[2].InitAsUnorderedAccessView(1); // u1: marginal CDF
+            rootParameters[3].InitAsConstants(2, 0);        // b0: map size
+            
+            CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+            rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+            
+            Microsoft::WRL::ComPtr<ID3DBlob> signature;
+            Microsoft::WRL::ComPtr<ID3DBlob> error;
+            ThrowIfFailed(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, &error),
+                "Failed to serialize environment CDF root signature");
+            ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(),
+                signature->GetBufferSize(), IID_PPV_ARGS(&m_envCdfRootSignature)),
+                "Failed to create environment CDF root signature");
+            
+            D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+            psoDesc.pRootSignature = m_envCdfRootSignature.Get();
+            psoDesc.CS.pShaderBytecode = rowShader->GetBufferPointer();
+            psoDesc.CS.BytecodeLength = rowShader->GetBufferSize();
+            ThrowIfFailed(CreateComputePipeline(L"RowCdfCS", psoDesc, m_envRowCdfPipelineState),
+                "Failed to create environment row CDF pipeline state");
+            
+            psoDesc.CS.pShaderBytecode = marginalShader->GetBufferPointer();
+            psoDesc.CS.BytecodeLength = marginalShader->GetBufferSize();
+            ThrowIfFailed(CreateComputePipeline(L"MarginalCdfCS", psoDesc, m_envMarginalCdfPipelineState),
+                "Failed to create environment marginal CDF pipeline state");
+            
+            std::cout << "Environment CDF pipeline created successfully" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to create environment CDF pipeline: " << e.what() << " (environment importance sampling disabled)" << std::endl;
+            m_envRowCdfPipelineState.Reset();
+            m_envMarginalCdfPipelineState.Reset();
+        }
+    }
+
+    void Renderer::CreateMipmapPipeline() {
+        try {
+            Microsoft::WRL::ComPtr<IDxcBlob> downsampleShader = CompileShader(L"shaders/Mipmap.hlsl", L"DownsampleCS", L"cs_6_6");
+            
+            CD3DX12_DESCRIPTOR_RANGE1 ranges[2];
+            ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0); // t0: level N-1
+            ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0); // u0: level N
+            
+            CD3DX12_ROOT_PARAMETER1 rootParameters[2];
+            rootParameters[0].InitAsDescriptorTable(_countof(ranges), ranges);
+            rootParameters[1].InitAsConstants(2, 0);  // b0: level N size
+            
+            CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+            rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+            
+            Microsoft::WRL::ComPtr<ID3DBlob> signature;
+            Microsoft::WRL::ComPtr<ID3DBlob> error;
+            ThrowIfFailed(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, &error),
+                "Failed to serialize mipmap root signature");
+            ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(),
+                signature->GetBufferSize(), IID_PPV_ARGS(&m_mipmapRootSignature)),
+                "Failed to create mipmap root signature");
+            
+            D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+            psoDesc.pRootSignature = m_mipmapRootSignature.Get();
+            psoDesc.CS.pShaderBytecode = downsampleShader->GetBufferPointer();
+            psoDesc.CS.BytecodeLength = downsampleShader->GetBufferSize();
+            ThrowIfFailed(CreateComputePipeline(L"DownsampleCS", psoDesc, m_mipmapPipelineState),
+                "Failed to create mipmap pipeline state");
+            
+            std::cout << "Mipmap pipeline created successfully" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to create mipmap pipeline: " << e.what() << " (mipmaps generated on the CPU)" << std::endl;
+            m_mipmapPipelineState.Reset();
+        }
+    }
+
+    void Renderer::GenerateMipsOnGpu(ID3D12GraphicsCommandList4* cmdList, ID3D12Resource* texture) {
+        D3D12_RESOURCE_DESC desc = texture->GetDesc();
+        if (desc.MipLevels < 2) {
+            return;
+        }
+        if (2u * (desc.MipLevels - 1) > MIP_VIEW_DESCRIPTORS) {
+            throw std::runtime_error("Too many mip levels for the mip generation views");
+        }
+        
+        ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
+        cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+        cmdList->SetComputeRootSignature(m_mipmapRootSignature.Get());
+        cmdList->SetPipelineState(m_mipmapPipelineState.Get());
+        
+        const UINT firstView = m_srvIndex_Textures + MAX_BINDLESS_TEXTURES;
+        for (UINT level = 1; level < desc.MipLevels; ++level) {
+            // Every pass has its own view pair: the views are read when the GPU executes the list
+            const UINT viewIndex = firstView + 2 * (level - 1);
+            D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+            srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            srvDesc.Format = desc.Format;
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            srvDesc.Texture2D.MostDetailedMip = level - 1;
+            srvDesc.Texture2D.MipLevels = 1;
+            m_device->CreateShaderResourceView(texture, &srvDesc,
+                CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), viewIndex, m_srvUavDescriptorSize));
+            
+            D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+            uavDesc.Format = desc.Format;
+            uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+            uavDesc.Texture2D.MipSlice = level;
+            m_device->CreateUnorderedAccessView(texture, nullptr, &uavDesc,
+                CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), viewIndex + 1, m_srvUavDescriptorSize));
+            
+            const UINT levelSize[2] = { std::max(1u, static_cast<UINT>(desc.Width) >> level), std::max(1u, desc.Height >> level) };
+            cmdList->SetComputeRootDescriptorTable(0, CD3DX12_GPU_DESCRIPTOR_HANDLE(
+                m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), viewIndex, m_srvUavDescriptorSize));
+            cmdList->SetComputeRoot32BitConstants(1, 2, levelSize, 0);
+            cmdList->Dispatch((levelSize[0] + MIPMAP_GROUP_SIZE - 1) / MIPMAP_GROUP_SIZE,
+                              (levelSize[1] + MIPMAP_GROUP_SIZE - 1) / MIPMAP_GROUP_SIZE, 1);
+            
+            // The next pass reads this level
+            auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(texture,
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE, level);
+            cmdList->ResourceBarrier(1, &barrier);
+        }
+    }
+
+    void Renderer::BuildEnvironmentCdf(ID3D12GraphicsCommandList4* cmdList, UINT width, UINT height) {
+        m_envImportanceSampling = false;
+        m_envConditionalCdf.Reset();
+        m_envMarginalCdf.Reset();
+        if (!m_envRowCdfPipelineState || !m_envMarginalCdfPipelineState) {
+            return;
+        }
+        
+        CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+        auto conditionalDesc = CD3DX12_RESOURCE_DESC::Buffer(
+            static_cast<UINT64>(width) * height * sizeof(float), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &conditionalDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_envConditionalCdf)
+        ), "Failed to create environment conditional CDF");
+        m_envConditionalCdf->SetName(L"Environment Conditional CDF");
+        
+        auto marginalDesc = CD3DX12_RESOURCE_DESC::Buffer(
+            static_cast<UINT64>(height + 1) * sizeof(float), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &marginalDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_envMarginalCdf)
+        ), "Failed to create environment marginal CDF");
+        m_envMarginalCdf->SetName(L"Environment Marginal CDF");
+        
+        ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
+        cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+        cmdList->SetComputeRootSignature(m_envCdfRootSignature.Get());
+        cmdList->SetComputeRootDescriptorTable(0, CD3DX12_GPU_DESCRIPTOR_HANDLE(
+            m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), 6, m_srvUavDescriptorSize));
+        cmdList->SetComputeRootUnorderedAccessView(1, m_envConditionalCdf->GetGPUVirtualAddress());
+        cmdList->SetComputeRootUnorderedAccessView(2, m_envMarginalCdf->GetGPUVirtualAddress());
+        const UINT mapSize[2] = { width, height };
+        cmdList->SetComputeRoot32BitConstants(3, 2, mapSize, 0);
+        
+        // One group per row, then a single group scans the row sums
+        cmdList->SetPipelineState(m_envRowCdfPipelineState.Get());
+        cmdList->Dispatch(height, 1, 1);
+        auto rowSumsBarrier = CD3DX12_RESOURCE_BARRIER::UAV(m_envMarginalCdf.Get());
+        cmdList->ResourceBarrier(1, &rowSumsBarrier);
+        cmdList->SetPipelineState(m_envMarginalCdfPipelineState.Get());
+        cmdList->Dispatch(1, 1, 1);
+        
+        D3D12_RESOURCE_BARRIER barriers[2] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_envConditionalCdf.Get(),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_envMarginalCdf.Get(),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+        };
+        cmdList->ResourceBarrier(_countof(barriers), barriers);
+        
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+        srvDesc.Buffer.StructureByteStride = sizeof(float);
+        srvDesc.Buffer.NumElements = width * height;
+        CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_srvIndex_EnvCdf, m_srvUavDescriptorSize);
+        m_device->CreateShaderResourceView(m_envConditionalCdf.Get(), &srvDesc, srvHandle);
+        srvDesc.Buffer.NumElements = height + 1;
+        srvHandle.Offset(1, m_srvUavDescriptorSize);
+        m_device->CreateShaderResourceView(m_envMarginalCdf.Get(), &srvDesc, srvHandle);
+        
+        m_envImportanceSampling = true;
+        std::cout << "  ✓ Environment CDF build recorded (" << width << "x" << height << " conditional, "
+                  << height << " marginal)" << std::endl;
+    }
+
 // Sun setter implementations (moved from header for logging)
 void ACG::Renderer::SetSunDirection(const glm::vec3& dir) {
     m_sunDirection = glm::normalize(dir);
@@ -1188,6 +2464,11 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
     m_sunIntensity = intensity;
 }
 
+void ACG::Renderer::SetToneMapping(ToneMapOperator op, float exposureEV) {
+    m_toneMapOperator = op;
+    m_exposure = std::pow(2.0f, exposureEV);
+}
+
     void Renderer::CreateAccelerationStructures(ID3D12GraphicsCommandList4* cmdList) {
         if (!m_dxrSupported) {
             std::cout << "Skipping AS creation: DXR not supported" << std::endl;
@@ -1207,6 +2488,8 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         }
 
         std::cout << "Building acceleration structures..." << std::endl;
+        ScopedTimer cpuTimer(m_workStats.phases[PhaseIndex(RenderPhase::AccelerationStructureBuild)].cpuMs);
+        const UINT gpuRange = m_gpuProfiler.BeginRange(cmdList, PhaseIndex(RenderPhase::AccelerationStructureBuild));
         
         // CRITICAL: Ensure vertex and index data are fully uploaded before building AS
         // The buffers were transitioned to GENERIC_READ in CreateDefaultBuffer
@@ -1218,192 +2501,591 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         copyBarriers[1].UAV.pResource = nullptr;
         cmdList->ResourceBarrier(1, &copyBarriers[0]);
         
-        // INDUSTRY STANDARD: Single geometry descriptor with unified vertex/index buffers
-        // This is the recommended approach for static scenes in production engines
-        // (Unity, Unreal, and most ray tracers use this method)
-        
-        // Count total triangles and vertices
-        UINT totalTriangles = 0;
-        UINT totalVertices = 0;
-        for (const auto& mesh : m_scene->GetMeshes()) {
-            totalTriangles += static_cast<UINT>(mesh->GetIndices().size() / 3);
-            totalVertices += static_cast<UINT>(mesh->GetVertices().size());
+        // One BLAS per unique mesh over its range of the unified vertex/index buffers.
+        // Repeated meshes become additional TLAS instances, so their geometry is built only once.
+        const auto& sceneMeshes = m_scene->GetMeshes();
+        if (m_meshRanges.size() != sceneMeshes.size()) {
+            throw std::runtime_error("Mesh geometry ranges are out of date (CreateShaderResources must run first)");
         }
 
-        std::cout << "  Creating single unified geometry descriptor:" << std::endl;
-        std::cout << "    Total: " << totalTriangles << " triangles, " 
-                  << totalVertices << " vertices" << std::endl;
-        
-        // Single geometry descriptor encompassing all meshes
-        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
-        geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-        geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
-        
-        // Unified vertex buffer (all meshes, global indices)
-        geometryDesc.Triangles.Transform3x4 = 0;
-        geometryDesc.Triangles.VertexBuffer.StartAddress = m_vertexBuffer->GetGPUVirtualAddress();
-        geometryDesc.Triangles.VertexBuffer.StrideInBytes = 48;
-        geometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-        geometryDesc.Triangles.VertexCount = totalVertices;
-        
-        // Unified index buffer (global indices, already offset by baseVertex)
-        geometryDesc.Triangles.IndexBuffer = m_indexBuffer->GetGPUVirtualAddress();
-        geometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
-        geometryDesc.Triangles.IndexCount = totalTriangles * 3;
+        if (m_scene->GetInstances().empty()) {
+            for (size_t i = 0; i < sceneMeshes.size(); ++i) {
+                m_scene->AddInstance(static_cast<uint32_t>(i));
+            }
+        }
 
         try {
-            // Build Bottom Level AS (BLAS) with single geometry
-            
-            // Get required sizes for BLAS
-            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS blasInputs = {};
-            blasInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
-            blasInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-            blasInputs.NumDescs = 1;  // Single unified geometry
-            blasInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-            blasInputs.pGeometryDescs = &geometryDesc;
+            // Map each scene mesh to a BLAS slot (meshes sharing a range share a BLAS)
+            m_bottomLevelAS.clear();
+            m_meshBlasIndex.assign(sceneMeshes.size(), -1);
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs;
+            std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> blasInputsList;
+            std::unordered_map<UINT, int> blasByFirstIndex;
+            UINT totalTriangles = 0;
+            UINT totalVertices = 0;
+
+            for (size_t i = 0; i < sceneMeshes.size(); ++i) {
+                const MeshGeometryRange& range = m_meshRanges[i];
+                if (range.indexCount == 0) {
+                    continue;
+                }
+                auto existing = blasByFirstIndex.find(range.firstIndex);
+                if (existing != blasByFirstIndex.end()) {
+                    m_meshBlasIndex[i] = existing->second;
+                    continue;
+                }
+
+                D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
+                geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+                // Opaque meshes skip any-hit in traversal; alpha-tested ones run the cutout any-hit
+                geometryDesc.Flags = range.alphaTested ? D3D12_RAYTRACING_GEOMETRY_FLAG_NONE : D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+                geometryDesc.Triangles.Transform3x4 = 0;
+                // Indices are stored with baseVertex already applied, so the vertex buffer starts at
+                // the beginning of the unified buffer and VertexCount covers the mesh's highest index.
+                geometryDesc.Triangles.VertexBuffer.StartAddress = m_vertexBuffer->GetGPUVirtualAddress();
+                geometryDesc.Triangles.VertexBuffer.StrideInBytes = 3 * sizeof(float);  // Position stream
+                geometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+                geometryDesc.Triangles.VertexCount = range.baseVertex + range.vertexCount;
+                geometryDesc.Triangles.IndexBuffer = m_indexBuffer->GetGPUVirtualAddress() + 
+                                                     static_cast<UINT64>(range.firstIndex) * sizeof(uint32_t);
+                geometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+                geometryDesc.Triangles.IndexCount = range.indexCount;
+
+                m_meshBlasIndex[i] = static_cast<int>(geometryDescs.size());
+                blasByFirstIndex[range.firstIndex] = m_meshBlasIndex[i];
+                geometryDescs.push_back(geometryDesc);
+                totalTriangles += range.indexCount / 3;
+                totalVertices += range.vertexCount;
+            }
 
-            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO blasPrebuildInfo = {};
-            m_device->GetRaytracingAccelerationStructurePrebuildInfo(&blasInputs, &blasPrebuildInfo);
+            std::cout << "  Building " << geometryDescs.size() << " BLAS (" << totalTriangles << " unique triangles, "
+                      << totalVertices << " unique vertices)" << std::endl;
+
+            // Prebuild info for every BLAS; builds are serialized through one pooled scratch buffer
+            UINT64 maxScratchSize = 0;
+            std::vector<UINT64> blasBufferSizes;
+            for (const auto& geometryDesc : geometryDescs) {
+                D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS blasInputs = {};
+                blasInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+                blasInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE |
+                                   D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
+                blasInputs.NumDescs = 1;
+                blasInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+                blasInputs.pGeometryDescs = &geometryDesc;
+
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO blasPrebuildInfo = {};
+                m_device->GetRaytracingAccelerationStructurePrebuildInfo(&blasInputs, &blasPrebuildInfo);
+
+                maxScratchSize = std::max(maxScratchSize, (blasPrebuildInfo.ScratchDataSizeInBytes + 255) & ~255ULL);
+                blasBufferSizes.push_back((blasPrebuildInfo.ResultDataMaxSizeInBytes + 255) & ~255ULL);
+                blasInputsList.push_back(blasInputs);
+            }
 
-            // Align scratch buffer size
-            UINT64 scratchBufferSize = (blasPrebuildInfo.ScratchDataSizeInBytes + 255) & ~255;
-            UINT64 blasBufferSize = (blasPrebuildInfo.ResultDataMaxSizeInBytes + 255) & ~255;
+            ID3D12Resource* blasScratch = maxScratchSize > 0 ? AcquireScratchBuffer(maxScratchSize) : nullptr;
 
-            // Create scratch buffer for BLAS build (save as member to keep alive)
-            HRESULT hr = m_device->CreateCommittedResource(
+            // Compacted sizes are written by the builds and read back in CompactBottomLevelAS()
+            const UINT64 postbuildStride = sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+            const UINT64 postbuildSize = std::max<UINT64>(postbuildStride * blasInputsList.size(), postbuildStride);
+            ThrowIfFailed(m_device->CreateCommittedResource(
                 &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
                 D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(scratchBufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
-                D3D12_RESOURCE_STATE_COMMON,
+                &CD3DX12_RESOURCE_DESC::Buffer(postbuildSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
                 nullptr,
-                IID_PPV_ARGS(&m_blasScratchBuffer));
-            if (FAILED(hr)) {
-                char errorMsg[512];
-                if (hr == DXGI_ERROR_DEVICE_REMOVED) {
-                    HRESULT removedReason = m_device->GetDeviceRemovedReason();
-                    sprintf_s(errorMsg, "Failed to create BLAS scratch buffer - Device Removed (HRESULT: 0x%08X, Removed Reason: 0x%08X)", hr, removedReason);
-                } else {
-                    sprintf_s(errorMsg, "Failed to create BLAS scratch buffer (HRESULT: 0x%08X)", hr);
+                IID_PPV_ARGS(&m_blasCompactedSizeBuffer)),
+                "Failed to create BLAS compacted size buffer");
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(postbuildSize),
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                nullptr,
+                IID_PPV_ARGS(&m_blasCompactedSizeReadback)),
+                "Failed to create BLAS compacted size readback buffer");
+
+            D3D12_RESOURCE_BARRIER uavBarrier = {};
+            uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+
+            for (size_t b = 0; b < blasInputsList.size(); ++b) {
+                Microsoft::WRL::ComPtr<ID3D12Resource> blas;
+                ThrowIfFailed(m_device->CreateCommittedResource(
+                    &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+                    D3D12_HEAP_FLAG_NONE,
+                    &CD3DX12_RESOURCE_DESC::Buffer(blasBufferSizes[b], D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+                    D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
+                    nullptr,
+                    IID_PPV_ARGS(&blas)), 
+                    "Failed to create BLAS buffer");
+
+                D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC blasDesc = {};
+                blasDesc.Inputs = blasInputsList[b];
+                blasDesc.ScratchAccelerationStructureData = blasScratch->GetGPUVirtualAddress();
+                blasDesc.DestAccelerationStructureData = blas->GetGPUVirtualAddress();
+
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildDesc = {};
+                postbuildDesc.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+                postbuildDesc.DestBuffer = m_blasCompactedSizeBuffer->GetGPUVirtualAddress() + b * postbuildStride;
+                cmdList->BuildRaytracingAccelerationStructure(&blasDesc, 1, &postbuildDesc);
+
+                // Scratch is shared, so each build must finish before the next one reuses it
+                uavBarrier.UAV.pResource = blasScratch;
+                cmdList->ResourceBarrier(1, &uavBarrier);
+
+                m_bottomLevelAS.push_back(blas);
+            }
+
+            // All BLAS complete before TLAS build reads them
+            uavBarrier.UAV.pResource = nullptr;
+            cmdList->ResourceBarrier(1, &uavBarrier);
+
+            // Copy compacted sizes to the readback heap (consumed after the caller executes the list)
+            cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_blasCompactedSizeBuffer.Get(),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+            cmdList->CopyResource(m_blasCompactedSizeReadback.Get(), m_blasCompactedSizeBuffer.Get());
+
+            // Build Top Level AS (TLAS) - one instance per MeshInstance with a valid BLAS
+            m_tlasInstanceCount = 0;
+            for (const auto& instance : m_scene->GetInstances()) {
+                if (instance.meshIndex < m_meshBlasIndex.size() && m_meshBlasIndex[instance.meshIndex] >= 0) {
+                    m_tlasInstanceCount++;
                 }
-                std::cerr << errorMsg << std::endl;
-                throw std::runtime_error(errorMsg);
             }
+            if (m_tlasInstanceCount == 0) {
+                throw std::runtime_error("Scene has no instances with triangle geometry");
+            }
+
+            // Upload heap instance buffer stays mapped so transform-only changes can refit in place
+            if (m_instanceDescBuffer && m_mappedInstanceDescs) {
+                m_instanceDescBuffer->Unmap(0, nullptr);
+                m_mappedInstanceDescs = nullptr;
+            }
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * m_tlasInstanceCount),
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_PPV_ARGS(&m_instanceDescBuffer)),
+                "Failed to create TLAS instance buffer");
+            ThrowIfFailed(m_instanceDescBuffer->Map(0, nullptr, reinterpret_cast<void**>(&m_mappedInstanceDescs)),
+                "Failed to map TLAS instance buffer");
+            WriteInstanceDescs();
+
+            // Material id per TLAS instance (InstanceIndex()): the range's single material, or
+            // INSTANCE_MATERIAL_PER_FACE | offset into the per-face buffer. Fixed until the next scene load
+            std::vector<uint32_t> instanceMaterials;
+            instanceMaterials.reserve(m_tlasInstanceCount);
+            for (const auto& instance : m_scene->GetInstances()) {
+                if (instance.meshIndex < m_meshBlasIndex.size() && m_meshBlasIndex[instance.meshIndex] >= 0) {
+                    const MeshGeometryRange& range = m_meshRanges[instance.meshIndex];
+                    instanceMaterials.push_back(range.materialIndex != UINT_MAX ? range.materialIndex
+                                                                                : INSTANCE_MATERIAL_PER_FACE | range.faceMaterialOffset);
+                }
+            }
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint32_t) * instanceMaterials.size()),
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_PPV_ARGS(&m_instanceMaterialBuffer)),
+                "Failed to create instance material buffer");
+            void* mappedInstanceMaterials = nullptr;
+            ThrowIfFailed(m_instanceMaterialBuffer->Map(0, nullptr, &mappedInstanceMaterials),
+                "Failed to map instance material buffer");
+            std::memcpy(mappedInstanceMaterials, instanceMaterials.data(), sizeof(uint32_t) * instanceMaterials.size());
+            m_instanceMaterialBuffer->Unmap(0, nullptr);
+            D3D12_SHADER_RESOURCE_VIEW_DESC instanceMaterialSrv = {};
+            instanceMaterialSrv.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+            instanceMaterialSrv.Format = DXGI_FORMAT_R32_UINT;
+            instanceMaterialSrv.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            instanceMaterialSrv.Buffer.NumElements = static_cast<UINT>(instanceMaterials.size());
+            CD3DX12_CPU_DESCRIPTOR_HANDLE instanceMaterialHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(),
+                m_srvIndex_InstanceMaterials, m_srvUavDescriptorSize);
+            m_device->CreateShaderResourceView(m_instanceMaterialBuffer.Get(), &instanceMaterialSrv, instanceMaterialHandle);
+
+            // Light list: every instance contributes its mesh's emitters. The count is fixed by the
+            // instances, so refits only rewrite positions and weights (at least one entry keeps the SRV valid)
+            m_lightCount = 0;
+            for (const auto& instance : m_scene->GetInstances()) {
+                if (instance.meshIndex < m_meshBlasIndex.size() && m_meshBlasIndex[instance.meshIndex] >= 0) {
+                    m_lightCount += m_meshRanges[instance.meshIndex].emitterCount;
+                }
+            }
+            if (m_lightBuffer && m_mappedLights) {
+                m_lightBuffer->Unmap(0, nullptr);
+                m_mappedLights = nullptr;
+            }
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(sizeof(GPULight) * std::max<UINT>(m_lightCount, 1)),
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_PPV_ARGS(&m_lightBuffer)),
+                "Failed to create light list buffer");
+            m_lightBuffer->SetName(L"Emissive Light List");
+            ThrowIfFailed(m_lightBuffer->Map(0, nullptr, reinterpret_cast<void**>(&m_mappedLights)),
+                "Failed to map light list buffer");
+            WriteLightList();
+
+            // Get TLAS prebuild info (ALLOW_UPDATE enables cheap refits when only transforms change)
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS tlasInputs = GetTopLevelASInputs(false);
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO tlasPrebuildInfo = {};
+            m_device->GetRaytracingAccelerationStructurePrebuildInfo(&tlasInputs, &tlasPrebuildInfo);
+
+            m_tlasBuildScratchSize = (tlasPrebuildInfo.ScratchDataSizeInBytes + 255) & ~255ULL;
+            UINT64 tlasUpdateScratchSize = (std::max<UINT64>(tlasPrebuildInfo.UpdateScratchDataSizeInBytes, 1) + 255) & ~255ULL;
+            UINT64 tlasBufferSize = (tlasPrebuildInfo.ResultDataMaxSizeInBytes + 255) & ~255ULL;
+
+            // Refits outlive the load, so their (small) scratch is a dedicated buffer instead of the pool
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(tlasUpdateScratchSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&m_tlasScratchBuffer)));
 
-            // Create BLAS buffer
+            // Create TLAS buffer
             ThrowIfFailed(m_device->CreateCommittedResource(
                 &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
                 D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(blasBufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+                &CD3DX12_RESOURCE_DESC::Buffer(tlasBufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
                 D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
                 nullptr,
-                IID_PPV_ARGS(&m_bottomLevelAS)), 
-                "Failed to create BLAS buffer");
+                IID_PPV_ARGS(&m_topLevelAS)));
+
+            BuildTopLevelAS(cmdList, false);
+            m_scene->ClearInstanceTransformsDirty();
+            m_gpuProfiler.EndRange(cmdList, gpuRange);
+
+            // Create SRV for TLAS (descriptor index 4)
+            D3D12_SHADER_RESOURCE_VIEW_DESC srvTLASDesc = {};
+            srvTLASDesc.ViewDimension = D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE;
+            srvTLASDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            srvTLASDesc.RaytracingAccelerationStructure.Location = m_topLevelAS->GetGPUVirtualAddress();
+            
+            D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = m_srvUavHeap->GetCPUDescriptorHandleForHeapStart();
+            UINT descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            D3D12_CPU_DESCRIPTOR_HANDLE tlasSrvHandle = { srvHandle.ptr + descriptorSize * 4 };
+            m_device->CreateShaderResourceView(nullptr, &srvTLASDesc, tlasSrvHandle);
+
+            // Note: Do NOT close or execute here - caller will handle command list execution
+            // and then call CompactBottomLevelAS() once the GPU has finished
+
+            std::cout << "Acceleration structures built successfully: "
+                      << m_bottomLevelAS.size() << " BLAS, "
+                      << m_tlasInstanceCount << " instances" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to create acceleration structures: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+    void Renderer::WriteInstanceDescs() {
+        if (!m_mappedInstanceDescs || !m_scene) return;
+
+        UINT slot = 0;
+        for (const auto& instance : m_scene->GetInstances()) {
+            if (instance.meshIndex >= m_meshBlasIndex.size() || m_meshBlasIndex[instance.meshIndex] < 0) {
+                continue;
+            }
+            const MeshGeometryRange& range = m_meshRanges[instance.meshIndex];
+            UINT firstTriangle = range.firstIndex / 3;
+            if (firstTriangle > 0xFFFFFF) {
+                // InstanceID is 24 bits; the shader adds it to PrimitiveIndex() to address per-triangle data
+                throw std::runtime_error("Triangle offset exceeds 24-bit InstanceID range");
+            }
+
+            D3D12_RAYTRACING_INSTANCE_DESC desc = {};
+            // glm is column-major; DXR expects a row-major 3x4 object-to-world matrix
+            for (int row = 0; row < 3; ++row) {
+                for (int col = 0; col < 4; ++col) {
+                    desc.Transform[row][col] = instance.transform[col][row];
+                }
+            }
+            desc.InstanceID = firstTriangle;
+            desc.InstanceMask = 0xFF;
+            desc.InstanceContributionToHitGroupIndex = m_meshBlasIndex[instance.meshIndex] * SBT_RAY_TYPE_COUNT;  // Hit group records of the BLAS
+            desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
+            desc.AccelerationStructure = m_bottomLevelAS[m_meshBlasIndex[instance.meshIndex]]->GetGPUVirtualAddress();
+            m_mappedInstanceDescs[slot++] = desc;
+        }
+    }
+
+    void Renderer::WriteLightList() {
+        if (!m_mappedLights || !m_scene) return;
+
+        // World-space triangles in instance order; the alias table is weighted by emitted power
+        std::vector<GPULight> lights;
+        std::vector<float> weights;
+        lights.reserve(m_lightCount);
+        weights.reserve(m_lightCount);
+        for (const auto& instance : m_scene->GetInstances()) {
+            if (instance.meshIndex >= m_meshBlasIndex.size() || m_meshBlasIndex[instance.meshIndex] < 0) {
+                continue;
+            }
+            const MeshGeometryRange& range = m_meshRanges[instance.meshIndex];
+            for (UINT e = range.firstEmitter; e < range.firstEmitter + range.emitterCount; ++e) {
+                const EmissiveTriangle& emitter = m_emissiveTriangles[e];
+                GPULight light = {};
+                light.p0 = glm::vec3(instance.transform * glm::vec4(emitter.p0, 1.0f));
+                light.edge1 = glm::vec3(instance.transform * glm::vec4(emitter.p1, 1.0f)) - light.p0;
+                light.edge2 = glm::vec3(instance.transform * glm::vec4(emitter.p2, 1.0f)) - light.p0;
+                light.emission = emitter.emission;
+                light.area = 0.5f * glm::length(glm::cross(light.edge1, light.edge2));
+                lights.push_back(light);
+                // Must match the pdf ClosestHit evaluates for MIS when a BSDF ray hits this triangle
+                weights.push_back(glm::dot(emitter.emission, glm::vec3(0.2126f, 0.7152f, 0.0722f)) * light.area);
+            }
+        }
+        if (lights.size() != m_lightCount) {
+            throw std::runtime_error("Light list is out of date (instances changed without an AS rebuild)");
+        }
+
+        std::vector<float> probabilities;
+        std::vector<uint32_t> aliases;
+        std::vector<float> pmf;
+        SamplingUtils::BuildAliasTable(weights, probabilities, aliases, pmf);
+        double totalPower = 0.0;
+        for (size_t i = 0; i < lights.size(); ++i) {
+            lights[i].alias = aliases[i];
+            lights[i].probability = probabilities[i];
+            lights[i].pmf = pmf[i];
+            totalPower += weights[i];
+        }
+        m_lightTotalPower = static_cast<float>(totalPower);
+        if (!lights.empty()) {
+            memcpy(m_mappedLights, lights.data(), sizeof(GPULight) * lights.size());
+        }
+    }
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS Renderer::GetTopLevelASInputs(bool performUpdate) const {
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS tlasInputs = {};
+        tlasInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+        tlasInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE |
+                           D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+        if (performUpdate) {
+            tlasInputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+        }
+        tlasInputs.NumDescs = m_tlasInstanceCount;
+        tlasInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        tlasInputs.InstanceDescs = m_instanceDescBuffer->GetGPUVirtualAddress();
+        return tlasInputs;
+    }
 
-            // Build BLAS
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC blasDesc = {};
-        blasDesc.Inputs = blasInputs;
-        blasDesc.ScratchAccelerationStructureData = m_blasScratchBuffer->GetGPUVirtualAddress();
-        blasDesc.DestAccelerationStructureData = m_bottomLevelAS->GetGPUVirtualAddress();
+    void Renderer::BuildTopLevelAS(ID3D12GraphicsCommandList4* cmdList, bool performUpdate) {
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC tlasDesc = {};
+        tlasDesc.Inputs = GetTopLevelASInputs(performUpdate);
+        tlasDesc.DestAccelerationStructureData = m_topLevelAS->GetGPUVirtualAddress();
+        if (performUpdate) {
+            tlasDesc.SourceAccelerationStructureData = m_topLevelAS->GetGPUVirtualAddress();
+            tlasDesc.ScratchAccelerationStructureData = m_tlasScratchBuffer->GetGPUVirtualAddress();
+        } else {
+            tlasDesc.ScratchAccelerationStructureData = AcquireScratchBuffer(m_tlasBuildScratchSize)->GetGPUVirtualAddress();
+        }
 
-        cmdList->BuildRaytracingAccelerationStructure(&blasDesc, 0, nullptr);
+        cmdList->BuildRaytracingAccelerationStructure(&tlasDesc, 0, nullptr);
 
-        // UAV barrier for BLAS
+        // UAV barrier for TLAS
         D3D12_RESOURCE_BARRIER uavBarrier = {};
         uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-        uavBarrier.UAV.pResource = m_bottomLevelAS.Get();
+        uavBarrier.UAV.pResource = m_topLevelAS.Get();
         cmdList->ResourceBarrier(1, &uavBarrier);
+    }
 
-        // Build Top Level AS (TLAS)
-        D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
-        // Identity transform (3x4 matrix in row-major)
-        // Initialize ALL elements to avoid garbage values
-        memset(&instanceDesc.Transform, 0, sizeof(instanceDesc.Transform));
-        instanceDesc.Transform[0][0] = 1.0f;
-        instanceDesc.Transform[1][1] = 1.0f;
-        instanceDesc.Transform[2][2] = 1.0f;
-        instanceDesc.InstanceID = 0;
-        instanceDesc.InstanceMask = 0xFF;
-        instanceDesc.InstanceContributionToHitGroupIndex = 0;
-        instanceDesc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-        instanceDesc.AccelerationStructure = m_bottomLevelAS->GetGPUVirtualAddress();
-
-        // Upload instance descriptor (save as member to keep alive)
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(sizeof(D3D12_RAYTRACING_INSTANCE_DESC)),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_instanceDescBuffer)));
-
-        void* mappedData;
-        m_instanceDescBuffer->Map(0, nullptr, &mappedData);
-        memcpy(mappedData, &instanceDesc, sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
-        m_instanceDescBuffer->Unmap(0, nullptr);
+    void Renderer::RefitTopLevelAS(ID3D12GraphicsCommandList4* cmdList) {
+        if (!m_topLevelAS || !m_scene || !m_scene->AreInstanceTransformsDirty()) return;
 
-        // Get TLAS prebuild info
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS tlasInputs = {};
-        tlasInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
-        tlasInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-        tlasInputs.NumDescs = 1;
-        tlasInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-        tlasInputs.InstanceDescs = m_instanceDescBuffer->GetGPUVirtualAddress();
+        // Only transforms changed: BLAS stay cached, TLAS is updated in place (ALLOW_UPDATE)
+        // Caller guarantees the GPU is done with the previous TLAS contents (renders are serialized)
+        ScopedTimer cpuTimer(m_workStats.phases[PhaseIndex(RenderPhase::AccelerationStructureBuild)].cpuMs);
+        const UINT gpuRange = m_gpuProfiler.BeginRange(cmdList, PhaseIndex(RenderPhase::AccelerationStructureBuild));
+        WriteInstanceDescs();
+        WriteLightList();
+        BuildTopLevelAS(cmdList, true);
+        m_gpuProfiler.EndRange(cmdList, gpuRange);
 
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO tlasPrebuildInfo = {};
-        m_device->GetRaytracingAccelerationStructurePrebuildInfo(&tlasInputs, &tlasPrebuildInfo);
+        m_scene->ClearInstanceTransformsDirty();
+        ACG_LOG_DEBUG("TLAS refit: " << m_tlasInstanceCount << " instances");
+    }
 
-        UINT64 tlasScratchSize = (tlasPrebuildInfo.ScratchDataSizeInBytes + 255) & ~255;
-        UINT64 tlasBufferSize = (tlasPrebuildInfo.ResultDataMaxSizeInBytes + 255) & ~255;
+    ID3D12Resource* Renderer::AcquireScratchBuffer(UINT64 size) {
+        // One pooled scratch buffer serves every build recorded during a load. Growing it retires the
+        // old buffer instead of releasing it, because already-recorded builds may still reference it.
+        if (m_scratchPoolBuffer && m_scratchPoolSize >= size) {
+            return m_scratchPoolBuffer.Get();
+        }
+        if (m_scratchPoolBuffer) {
+            m_retiredScratchBuffers.push_back(m_scratchPoolBuffer);
+        }
 
-        // Create TLAS scratch buffer (save as member to keep alive)
-        ThrowIfFailed(m_device->CreateCommittedResource(
+        HRESULT hr = m_device->CreateCommittedResource(
             &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
             D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(tlasScratchSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+            &CD3DX12_RESOURCE_DESC::Buffer(size, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
             D3D12_RESOURCE_STATE_COMMON,
             nullptr,
-            IID_PPV_ARGS(&m_tlasScratchBuffer)));
+            IID_PPV_ARGS(&m_scratchPoolBuffer));
+        if (FAILED(hr)) {
+            char errorMsg[512];
+            if (hr == DXGI_ERROR_DEVICE_REMOVED) {
+                HRESULT removedReason = m_device->GetDeviceRemovedReason();
+                sprintf_s(errorMsg, "Failed to create AS scratch buffer - Device Removed (HRESULT: 0x%08X, Removed Reason: 0x%08X)", hr, removedReason);
+            } else {
+                sprintf_s(errorMsg, "Failed to create AS scratch buffer (HRESULT: 0x%08X)", hr);
+            }
+            std::cerr << errorMsg << std::endl;
+            throw std::runtime_error(errorMsg);
+        }
+        m_scratchPoolSize = size;
+        return m_scratchPoolBuffer.Get();
+    }
 
-        // Create TLAS buffer
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(tlasBufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
-            D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
+    void Renderer::ReleaseScratchPool() {
+        // Only call once the GPU has finished every build that used the pool
+        m_scratchPoolBuffer.Reset();
+        m_scratchPoolSize = 0;
+        m_retiredScratchBuffers.clear();
+    }
+
+    void Renderer::CompactBottomLevelAS() {
+        // Expects the build command list from CreateAccelerationStructures() to have completed on the GPU
+        if (!m_blasCompactedSizeReadback || m_bottomLevelAS.empty()) {
+            ReleaseScratchPool();
+            return;
+        }
+
+        ScopedTimer cpuTimer(m_workStats.phases[PhaseIndex(RenderPhase::AccelerationStructureBuild)].cpuMs);
+        std::vector<UINT64> compactedSizes(m_bottomLevelAS.size());
+        {
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC* sizes = nullptr;
+            CD3DX12_RANGE readRange(0, sizeof(*sizes) * m_bottomLevelAS.size());
+            ThrowIfFailed(m_blasCompactedSizeReadback->Map(0, &readRange, reinterpret_cast<void**>(&sizes)),
+                "Failed to map BLAS compacted size readback");
+            for (size_t b = 0; b < m_bottomLevelAS.size(); ++b) {
+                compactedSizes[b] = (sizes[b].CompactedSizeInBytes + 255) & ~255ULL;
+            }
+            CD3DX12_RANGE writeRange(0, 0);
+            m_blasCompactedSizeReadback->Unmap(0, &writeRange);
+        }
+
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> compactAllocator;
+        ThrowIfFailed(m_device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(&compactAllocator)),
+            "Failed to create compaction command allocator");
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> compactCommandList;
+        ThrowIfFailed(m_device->CreateCommandList(
+            0,
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            compactAllocator.Get(),
             nullptr,
-            IID_PPV_ARGS(&m_topLevelAS)));
+            IID_PPV_ARGS(&compactCommandList)),
+            "Failed to create compaction command list");
+        const UINT gpuRange = m_gpuProfiler.BeginRange(compactCommandList.Get(), PhaseIndex(RenderPhase::AccelerationStructureBuild));
+
+        UINT64 originalBytes = 0;
+        UINT64 compactedBytes = 0;
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> compactedBLAS;
+        compactedBLAS.reserve(m_bottomLevelAS.size());
+        for (size_t b = 0; b < m_bottomLevelAS.size(); ++b) {
+            Microsoft::WRL::ComPtr<ID3D12Resource> compacted;
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(compactedSizes[b], D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+                D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
+                nullptr,
+                IID_PPV_ARGS(&compacted)),
+                "Failed to create compacted BLAS buffer");
 
-        // Build TLAS
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC tlasDesc = {};
-        tlasDesc.Inputs = tlasInputs;
-        tlasDesc.ScratchAccelerationStructureData = m_tlasScratchBuffer->GetGPUVirtualAddress();
-        tlasDesc.DestAccelerationStructureData = m_topLevelAS->GetGPUVirtualAddress();
+            compactCommandList->CopyRaytracingAccelerationStructure(
+                compacted->GetGPUVirtualAddress(),
+                m_bottomLevelAS[b]->GetGPUVirtualAddress(),
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
 
-        cmdList->BuildRaytracingAccelerationStructure(&tlasDesc, 0, nullptr);
+            originalBytes += m_bottomLevelAS[b]->GetDesc().Width;
+            compactedBytes += compactedSizes[b];
+            compactedBLAS.push_back(compacted);
+        }
 
-        // UAV barrier for TLAS
-        uavBarrier.UAV.pResource = m_topLevelAS.Get();
-        cmdList->ResourceBarrier(1, &uavBarrier);
+        D3D12_RESOURCE_BARRIER uavBarrier = {};
+        uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        uavBarrier.UAV.pResource = nullptr;
+        compactCommandList->ResourceBarrier(1, &uavBarrier);
+
+        // BLAS addresses changed, so the TLAS is rebuilt (not refit) against the compacted copies.
+        // The uncompacted BLAS stay alive in oldBLAS until the GPU is done with the copies.
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> oldBLAS;
+        oldBLAS.swap(m_bottomLevelAS);
+        m_bottomLevelAS = std::move(compactedBLAS);
+        WriteInstanceDescs();
+        BuildTopLevelAS(compactCommandList.Get(), false);
+        m_gpuProfiler.EndRange(compactCommandList.Get(), gpuRange);
+
+        ThrowIfFailed(compactCommandList->Close(), "Failed to close compaction command list");
+        ID3D12CommandList* lists[] = { compactCommandList.Get() };
+        m_commandQueue->ExecuteCommandLists(1, lists);
+        m_gpuProfiler.Submit(m_fence.Get(), m_fenceValue);  // The value WaitForGpu signals
+        WaitForGpu();
 
-        // Create SRV for TLAS (descriptor index 4)
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvTLASDesc = {};
-        srvTLASDesc.ViewDimension = D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE;
-        srvTLASDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvTLASDesc.RaytracingAccelerationStructure.Location = m_topLevelAS->GetGPUVirtualAddress();
-        
-        D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = m_srvUavHeap->GetCPUDescriptorHandleForHeapStart();
-        UINT descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-        D3D12_CPU_DESCRIPTOR_HANDLE tlasSrvHandle = { srvHandle.ptr + descriptorSize * 4 };
-        m_device->CreateShaderResourceView(nullptr, &srvTLASDesc, tlasSrvHandle);
+        oldBLAS.clear();
+        m_blasCompactedSizeBuffer.Reset();
+        m_blasCompactedSizeReadback.Reset();
+        ReleaseScratchPool();
 
-        // Note: Do NOT close or execute here - caller will handle command list execution
+        std::cout << "BLAS compaction: " << (originalBytes / (1024 * 1024)) << " MB -> "
+                  << (compactedBytes / (1024 * 1024)) << " MB" << std::endl;
+    }
 
-        std::cout << "Acceleration structures built successfully: "
-                  << totalTriangles << " triangles, "
-                  << totalVertices << " vertices (single unified geometry)" << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "Failed to create acceleration structures: " << e.what() << std::endl;
-            throw;
+    void Renderer::BuildAlphaMasks() {
+        // Cutout masks: 1 bit per base color texel (alpha >= 0.5), one per texture and shared by its materials.
+        // Textures without transparent texels get no mask, so their meshes stay opaque in the BLAS
+        const auto& materials = m_scene->GetMaterials();
+        m_alphaMaskInfos.assign(materials.size(), AlphaMaskInfo{});
+        m_alphaMaskBits.clear();
+        std::unordered_map<const Texture*, AlphaMaskInfo> maskByTexture;
+        size_t cutoutMaterials = 0;
+        for (size_t i = 0; i < materials.size(); ++i) {
+            std::shared_ptr<Texture> texture = materials[i]->GetBaseColorTexture();
+            // Glass treats its alpha as transmission, HDR textures carry no cutout
+            if (!texture || texture->IsHDR() || texture->GetChannels() != 4 || !texture->GetRawData() ||
+                materials[i]->HasLayer(LAYER_TRANSMISSION)) {
+                continue;
+            }
+            auto cached = maskByTexture.find(texture.get());
+            if (cached == maskByTexture.end()) {
+                AlphaMaskInfo info = {};
+                const size_t texelCount = static_cast<size_t>(texture->GetWidth()) * texture->GetHeight();
+                const unsigned char* texels = texture->GetRawData();
+                std::vector<uint32_t> bits((texelCount + 31) / 32, 0);
+                bool hasHoles = false;
+                for (size_t texel = 0; texel < texelCount; ++texel) {
+                    if (texels[texel * 4 + 3] >= 128) {
+                        bits[texel / 32] |= 1u << (texel % 32);
+                    } else {
+                        hasHoles = true;
+                    }
+                }
+                if (hasHoles) {
+                    info.offset = static_cast<uint32_t>(m_alphaMaskBits.size());
+                    info.width = static_cast<uint32_t>(texture->GetWidth());
+                    info.height = static_cast<uint32_t>(texture->GetHeight());
+                    m_alphaMaskBits.insert(m_alphaMaskBits.end(), bits.begin(), bits.end());
+                }
+                cached = maskByTexture.emplace(texture.get(), info).first;
+            }
+            m_alphaMaskInfos[i] = cached->second;
+            if (cached->second.width > 0) {
+                ++cutoutMaterials;
+            }
+        }
+        if (cutoutMaterials > 0) {
+            std::cout << "Alpha cutout materials: " << cutoutMaterials << " (" << maskByTexture.size() << " textures scanned, "
+                      << (m_alphaMaskBits.size() * sizeof(uint32_t) / 1024) << " KB of mask bits)" << std::endl;
         }
     }
 
@@ -1413,6 +3095,9 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
 
         // Note: Command list should be ready (opened) by caller
         // Do NOT reset allocator here - it may be in use
+        
+        // The previous scene's copy queue uploads may still be reading its resources
+        m_uploadRing.WaitIdle();
 
         // Flatten vertices and indices from all meshes into single buffers
         struct GPUVertex { 
@@ -1422,59 +3107,243 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
             float tangent[3];  // Must match HLSL Vertex struct
             float _pad;        // Padding to align to 16 bytes (44 -> 48)
         };
+        static_assert(sizeof(GPUVertex) == 48, "GPUVertex must match the .acg v2 packed vertex stride");
+        // Shading attributes on the GPU (matches VertexAttributes in Structures.hlsli); positions are a
+        // separate float3 stream shared with the BLAS build
+        struct GPUVertexAttributes {
+            uint32_t normal;    // Octahedral, 2 x unorm16
+            uint32_t texCoord;  // 2 x half
+        };
+        static_assert(sizeof(GPUVertexAttributes) == 8, "GPUVertexAttributes must match the HLSL VertexAttributes and .acg v3 layouts");
         std::vector<GPUVertex> vertices;
         std::vector<uint32_t> indices;
         std::vector<uint32_t> triangleMaterialIndices; // Material index per triangle
 
-        for (const auto& mesh : m_scene->GetMeshes()) {
-            const auto& meshVerts = mesh->GetVertices();
-            const auto& meshIdx = mesh->GetIndices();
-            uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
-            int meshMaterialIdx = mesh->GetMaterialIndex();
-            std::cout << "Mesh: " << meshVerts.size() << " vertices, " << meshIdx.size()/3 << " triangles, materialIndex=" << meshMaterialIdx << std::endl;
-            
-            // append vertices
-            for (const auto& v : meshVerts) {
-                GPUVertex outV = {};
-                outV.position[0] = v.position.x; outV.position[1] = v.position.y; outV.position[2] = v.position.z;
-                outV.normal[0] = v.normal.x; outV.normal[1] = v.normal.y; outV.normal[2] = v.normal.z;
-                outV.texCoord[0] = v.texCoord.x; outV.texCoord[1] = v.texCoord.y;
-                outV.tangent[0] = 0.0f; outV.tangent[1] = 0.0f; outV.tangent[2] = 0.0f;
-                outV._pad = 0.0f;
-                vertices.push_back(outV);
-            }
-            // append indices with base offset
-            for (uint32_t idx : meshIdx) {
-                indices.push_back(baseVertex + idx);
-            }
-            // Store material index for each triangle in this mesh
-            uint32_t numTriangles = static_cast<uint32_t>(meshIdx.size() / 3);
-            for (uint32_t i = 0; i < numTriangles; i++) {
-                triangleMaterialIndices.push_back(meshMaterialIdx);
-            }
-        }
-
-        // Create GPU buffers using helper CreateDefaultBuffer
-        // CRITICAL: Upload buffers MUST be kept alive until GPU executes the copy!
-        size_t vertexBufferSize = sizeof(GPUVertex) * vertices.size();
+        // Source pointers for the upload: either the flattened vectors or the mapped .acg chunks.
+        // positionData / attributeData are the GPU streams; vertexData is 48-byte input still to quantize
+        const float* positionData = nullptr;
+        const void* attributeData = nullptr;
+        const void* vertexData = nullptr;
+        const void* indexData = nullptr;
+        const void* triangleMaterialData = nullptr;
+        UINT vertexCount = 0;
+        UINT indexCount = 0;
+        UINT triangleCount = 0;
+
+        const auto& sceneMeshes = m_scene->GetMeshes();
+        m_meshRanges.assign(sceneMeshes.size(), MeshGeometryRange{});
+
+        if (const PackedGeometry* packed = m_scene->GetPackedGeometry()) {
+            // v3 chunks are GPU-ready: copied once, straight from the file mapping into the upload heaps.
+            // v2 files hold 48-byte vertices, quantized below like imported meshes
+            if (!packed->positions && packed->vertexStride != sizeof(GPUVertex)) {
+                throw std::runtime_error("Packed vertex stride does not match GPU vertex layout");
+            }
+            for (size_t meshIndex = 0; meshIndex < sceneMeshes.size(); ++meshIndex) {
+                const auto& mesh = sceneMeshes[meshIndex];
+                m_meshRanges[meshIndex].baseVertex = static_cast<UINT>(mesh->GetPackedFirstVertex());
+                m_meshRanges[meshIndex].vertexCount = mesh->GetVertexCount();
+                m_meshRanges[meshIndex].firstIndex = static_cast<UINT>(mesh->GetPackedFirstIndex());
+                m_meshRanges[meshIndex].indexCount = mesh->GetIndexCount();
+            }
+            positionData = packed->positions;
+            attributeData = packed->attributes;
+            vertexData = packed->vertices;
+            indexData = packed->indices;
+            triangleMaterialData = packed->triangleMaterials;
+            vertexCount = static_cast<UINT>(packed->vertexCount);
+            indexCount = static_cast<UINT>(packed->indexCount);
+            triangleCount = static_cast<UINT>(packed->triangleCount);
+            std::cout << "Using packed geometry: " << sceneMeshes.size() << " meshes" << std::endl;
+        } else {
+            // Each unique Mesh is uploaded once; repeated pointers share the same range (and BLAS)
+            std::unordered_map<const Mesh*, size_t> uploadedMeshes;
+
+            for (size_t meshIndex = 0; meshIndex < sceneMeshes.size(); ++meshIndex) {
+                const auto& mesh = sceneMeshes[meshIndex];
+                auto uploaded = uploadedMeshes.find(mesh.get());
+                if (uploaded != uploadedMeshes.end()) {
+                    m_meshRanges[meshIndex] = m_meshRanges[uploaded->second];
+                    continue;
+                }
+                uploadedMeshes[mesh.get()] = meshIndex;
+
+                const auto& meshVerts = mesh->GetVertices();
+                const auto& meshIdx = mesh->GetIndices();
+                uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+                m_meshRanges[meshIndex].baseVertex = baseVertex;
+                m_meshRanges[meshIndex].vertexCount = static_cast<UINT>(meshVerts.size());
+                m_meshRanges[meshIndex].firstIndex = static_cast<UINT>(indices.size());
+                m_meshRanges[meshIndex].indexCount = static_cast<UINT>(meshIdx.size() / 3 * 3);
+                int meshMaterialIdx = mesh->GetMaterialIndex();
+                std::cout << "Mesh: " << meshVerts.size() << " vertices, " << meshIdx.size()/3 << " triangles, materialIndex=" << meshMaterialIdx << std::endl;
+                
+                // append vertices
+                for (const auto& v : meshVerts) {
+                    GPUVertex outV = {};
+                    outV.position[0] = v.position.x; outV.position[1] = v.position.y; outV.position[2] = v.position.z;
+                    outV.normal[0] = v.normal.x; outV.normal[1] = v.normal.y; outV.normal[2] = v.normal.z;
+                    outV.texCoord[0] = v.texCoord.x; outV.texCoord[1] = v.texCoord.y;
+                    outV.tangent[0] = 0.0f; outV.tangent[1] = 0.0f; outV.tangent[2] = 0.0f;
+                    outV._pad = 0.0f;
+                    vertices.push_back(outV);
+                }
+                // append indices with base offset
+                for (uint32_t idx : meshIdx) {
+                    indices.push_back(baseVertex + idx);
+                }
+                // Store material index for each triangle in this mesh
+                uint32_t numTriangles = static_cast<uint32_t>(meshIdx.size() / 3);
+                for (uint32_t i = 0; i < numTriangles; i++) {
+                    triangleMaterialIndices.push_back(meshMaterialIdx);
+                }
+            }
+            vertexData = vertices.data();
+            indexData = indices.data();
+            triangleMaterialData = triangleMaterialIndices.data();
+            vertexCount = static_cast<UINT>(vertices.size());
+            indexCount = static_cast<UINT>(indices.size());
+            triangleCount = static_cast<UINT>(triangleMaterialIndices.size());
+        }
+
+        // Quantize imported (and .acg v2) vertices into the GPU streams: 12-byte positions + 8-byte
+        // attributes instead of 48-byte records (the tangent and padding were never read)
+        std::vector<float> positions;
+        std::vector<GPUVertexAttributes> attributes;
+        if (!positionData && vertexCount > 0) {
+            positions.resize(static_cast<size_t>(vertexCount) * 3);
+            attributes.resize(vertexCount);
+            const GPUVertex* source = static_cast<const GPUVertex*>(vertexData);
+            const size_t chunkSize = 64 * 1024;
+            ParallelFor((static_cast<size_t>(vertexCount) + chunkSize - 1) / chunkSize, [&](size_t chunk) {
+                size_t end = std::min<size_t>(vertexCount, (chunk + 1) * chunkSize);
+                for (size_t v = chunk * chunkSize; v < end; ++v) {
+                    std::memcpy(&positions[v * 3], source[v].position, 3 * sizeof(float));
+                    attributes[v].normal = EncodeOctahedralNormal(source[v].normal);
+                    attributes[v].texCoord = DirectX::PackedVector::XMConvertFloatToHalf(source[v].texCoord[0]) |
+                        (static_cast<uint32_t>(DirectX::PackedVector::XMConvertFloatToHalf(source[v].texCoord[1])) << 16);
+                }
+            });
+            positionData = positions.data();
+            attributeData = attributes.data();
+        }
+
+        // Geometry goes through the copy queue; the BLAS build waits for it with m_geometryCopyFenceValue.
+        // Textures are decoded meanwhile, so this copy overlaps the CPU work below
+        BeginCopyCommands();
+        size_t vertexBufferSize = static_cast<size_t>(vertexCount) * 3 * sizeof(float);
         if (vertexBufferSize > 0) {
-            m_vertexBuffer = CreateDefaultBuffer(m_device.Get(), cmdList, vertices.data(), vertexBufferSize, m_vertexUpload);
-            std::cout << "Vertex buffer created: " << vertices.size() << " vertices (" << vertexBufferSize << " bytes)" << std::endl;
+            m_vertexBuffer = CreateBufferOnCopyQueue(positionData, vertexBufferSize);
+            size_t attributeBufferSize = static_cast<size_t>(vertexCount) * sizeof(GPUVertexAttributes);
+            m_vertexAttributeBuffer = CreateBufferOnCopyQueue(attributeData, attributeBufferSize);
+            std::cout << "Vertex buffers created: " << vertexCount << " vertices (" << vertexBufferSize << " bytes positions + "
+                      << attributeBufferSize << " bytes attributes, was " << sizeof(GPUVertex) * static_cast<size_t>(vertexCount)
+                      << " bytes)" << std::endl;
         }
 
-        size_t indexBufferSize = sizeof(uint32_t) * indices.size();
+        size_t indexBufferSize = sizeof(uint32_t) * static_cast<size_t>(indexCount);
         if (indexBufferSize > 0) {
-            m_indexBuffer = CreateDefaultBuffer(m_device.Get(), cmdList, indices.data(), indexBufferSize, m_indexUpload);
-            std::cout << "Index buffer created: " << indices.size() << " indices (" << indexBufferSize << " bytes)" << std::endl;
+            m_indexBuffer = CreateBufferOnCopyQueue(indexData, indexBufferSize);
+            std::cout << "Index buffer created: " << indexCount << " indices (" << indexBufferSize << " bytes)" << std::endl;
+        }
+
+        // Material lookup per unique range: a single-material range keeps its index in the range (and the
+        // per-instance table), only ranges with per-face materials copy their triangles' ids into the
+        // per-face buffer. The same pass picks the hit group: specialized class or uber, alpha-tested or not
+        BuildAlphaMasks();
+        std::vector<uint32_t> faceMaterials;
+        {
+            const uint32_t* triangleMaterialArray = static_cast<const uint32_t*>(triangleMaterialData);
+            std::unordered_map<UINT, size_t> materialRangeByFirstIndex;
+            for (MeshGeometryRange& range : m_meshRanges) {
+                auto scanned = materialRangeByFirstIndex.find(range.firstIndex);
+                if (scanned != materialRangeByFirstIndex.end()) {
+                    range.materialIndex = m_meshRanges[scanned->second].materialIndex;
+                    range.faceMaterialOffset = m_meshRanges[scanned->second].faceMaterialOffset;
+                    range.alphaTested = m_meshRanges[scanned->second].alphaTested;
+                    continue;
+                }
+                materialRangeByFirstIndex[range.firstIndex] = static_cast<size_t>(&range - m_meshRanges.data());
+                const UINT firstTriangle = range.firstIndex / 3;
+                const UINT endTriangle = (range.firstIndex + range.indexCount) / 3;
+                range.materialIndex = firstTriangle < endTriangle ? triangleMaterialArray[firstTriangle] : UINT_MAX;
+                for (UINT triangle = firstTriangle; triangle < endTriangle; ++triangle) {
+                    uint32_t materialIndex = triangleMaterialArray[triangle];
+                    if (materialIndex != range.materialIndex) {
+                        range.materialIndex = UINT_MAX;  // Several materials: uber hit group
+                    }
+                    if (materialIndex < m_alphaMaskInfos.size() && m_alphaMaskInfos[materialIndex].width > 0) {
+                        range.alphaTested = true;
+                    }
+                }
+                if (range.materialIndex == UINT_MAX && firstTriangle < endTriangle) {
+                    range.faceMaterialOffset = static_cast<UINT>(faceMaterials.size());
+                    faceMaterials.insert(faceMaterials.end(), triangleMaterialArray + firstTriangle, triangleMaterialArray + endTriangle);
+                }
+            }
         }
+        if (faceMaterials.empty()) {
+            faceMaterials.push_back(0);  // Keeps the SRV valid when every mesh has a single material
+        }
+
+        // Create the per-face material buffer (ranges with several materials only)
+        const UINT faceMaterialCount = static_cast<UINT>(faceMaterials.size());
+        m_triangleMaterialBuffer = CreateBufferOnCopyQueue(faceMaterials.data(), sizeof(uint32_t) * faceMaterials.size());
+        std::cout << "Per-face material buffer created: " << faceMaterialCount << " of " << triangleCount
+                  << " triangles (the rest use per-instance material ids)" << std::endl;
 
-        // Create triangle material index buffer (one material ID per triangle)
-        size_t triangleMaterialBufferSize = sizeof(uint32_t) * triangleMaterialIndices.size();
-        if (triangleMaterialBufferSize > 0) {
-            m_triangleMaterialBuffer = CreateDefaultBuffer(m_device.Get(), cmdList, 
-                triangleMaterialIndices.data(), triangleMaterialBufferSize, m_triangleMaterialUpload);
-            std::cout << "Triangle material buffer created: " << triangleMaterialIndices.size() << " triangles" << std::endl;
+        m_geometryCopyFenceValue = SubmitCopyCommands();
+        
+        // Next-event estimation light sources: emissive triangles of every unique range (object space).
+        // Same emission threshold as ClosestHit, so exactly the triangles that end paths are sampled
+        m_emissiveTriangles.clear();
+        {
+            const auto& sceneMaterials = m_scene->GetMaterials();
+            const uint32_t* indexArray = static_cast<const uint32_t*>(indexData);
+            const uint32_t* triangleMaterialArray = static_cast<const uint32_t*>(triangleMaterialData);
+            std::unordered_map<UINT, size_t> emitterRangeByFirstIndex;
+            for (MeshGeometryRange& range : m_meshRanges) {
+                auto scanned = emitterRangeByFirstIndex.find(range.firstIndex);
+                if (scanned != emitterRangeByFirstIndex.end()) {
+                    range.firstEmitter = m_meshRanges[scanned->second].firstEmitter;
+                    range.emitterCount = m_meshRanges[scanned->second].emitterCount;
+                    continue;
+                }
+                emitterRangeByFirstIndex[range.firstIndex] = static_cast<size_t>(&range - m_meshRanges.data());
+                range.firstEmitter = static_cast<UINT>(m_emissiveTriangles.size());
+                for (UINT triangle = range.firstIndex / 3; triangle < (range.firstIndex + range.indexCount) / 3; ++triangle) {
+                    uint32_t materialIndex = triangleMaterialArray[triangle];
+                    if (materialIndex >= sceneMaterials.size()) {
+                        continue;
+                    }
+                    glm::vec3 emission = sceneMaterials[materialIndex]->GetEmission();
+                    if (emission.r + emission.g + emission.b <= 0.01f) {
+                        continue;
+                    }
+                    EmissiveTriangle emitter;
+                    const float* p0 = positionData + static_cast<size_t>(indexArray[triangle * 3 + 0]) * 3;
+                    const float* p1 = positionData + static_cast<size_t>(indexArray[triangle * 3 + 1]) * 3;
+                    const float* p2 = positionData + static_cast<size_t>(indexArray[triangle * 3 + 2]) * 3;
+                    emitter.p0 = glm::vec3(p0[0], p0[1], p0[2]);
+                    emitter.p1 = glm::vec3(p1[0], p1[1], p1[2]);
+                    emitter.p2 = glm::vec3(p2[0], p2[1], p2[2]);
+                    emitter.emission = emission;
+                    m_emissiveTriangles.push_back(emitter);
+                }
+                range.emitterCount = static_cast<UINT>(m_emissiveTriangles.size()) - range.firstEmitter;
+            }
         }
+        if (!m_emissiveTriangles.empty()) {
+            std::cout << "Emissive triangles for light sampling: " << m_emissiveTriangles.size() << std::endl;
+        }
+        
+        // The flattened copies are in the upload ring now; release them before texture uploads
+        std::vector<GPUVertex>().swap(vertices);
+        std::vector<float>().swap(positions);
+        std::vector<GPUVertexAttributes>().swap(attributes);
+        std::vector<uint32_t>().swap(indices);
+        std::vector<uint32_t>().swap(triangleMaterialIndices);
+        std::vector<uint32_t>().swap(faceMaterials);
 
         // Create GPU-side material buffer
         std::vector<MaterialData> materialsCPU;
@@ -1555,30 +3424,25 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
             std::cout << "Uploading " << textures.size() << " textures to GPU..." << std::endl;
             
             // **STEP 1: Pre-calculate total texture requirements**
+            // Every texture keeps its own size and a full mip chain, so the estimate is the sum of the chains
             int totalTextures = static_cast<int>(textures.size());
-            UINT maxWidth = 0;
-            UINT maxHeight = 0;
+            size_t textureBytes = 0;
             for (const auto& tex : textures) {
-                maxWidth = std::max(maxWidth, static_cast<UINT>(tex->GetWidth()));
-                maxHeight = std::max(maxHeight, static_cast<UINT>(tex->GetHeight()));
+                textureBytes += GetTextureChainSize(GetTextureExtent(*tex, 1.0f));
             }
-            
-            // Calculate memory requirements
-            size_t arrayMemoryMB = (size_t)maxWidth * maxHeight * 4 * totalTextures / (1024 * 1024);
+            size_t textureMemoryMB = textureBytes / (1024 * 1024);
             std::cout << "  Total textures: " << totalTextures << std::endl;
-            std::cout << "  Max dimensions: " << maxWidth << "x" << maxHeight << std::endl;
-            std::cout << "  Estimated VRAM (Texture Array): " << arrayMemoryMB << " MB" << std::endl;
+            std::cout << "  Estimated VRAM (bindless textures with mips): " << textureMemoryMB << " MB" << std::endl;
             
             // **DECISION POINT: Use Virtual Textures for very large texture sets**
             // Virtual Textures use DX12 Tiled Resources for on-demand streaming
-            const size_t MAX_TEXTURE_ARRAY_VRAM_MB = 2048;  // 2GB limit for conventional arrays
-            const UINT MAX_TEXTURE_DIMENSION = 2048;  // Max dimension per texture in array
+            const size_t MAX_TEXTURE_VRAM_MB = 2048;  // 2GB limit for resident textures
             
             bool useVirtualTextures = false;
             
-            if (arrayMemoryMB > MAX_TEXTURE_ARRAY_VRAM_MB) {
-                std::cout << "  ⚠ Texture array would require " << arrayMemoryMB << " MB (exceeds " 
-                          << MAX_TEXTURE_ARRAY_VRAM_MB << " MB limit)" << std::endl;
+            if (textureMemoryMB > MAX_TEXTURE_VRAM_MB || totalTextures > static_cast<int>(MAX_BINDLESS_TEXTURES)) {
+                std::cout << "  ⚠ Resident textures would require " << textureMemoryMB << " MB in " << totalTextures
+                          << " descriptors (limits " << MAX_TEXTURE_VRAM_MB << " MB, " << MAX_BINDLESS_TEXTURES << ")" << std::endl;
                 std::cout << "  Attempting to use Virtual Texture System..." << std::endl;
                 
                 // Try to initialize Virtual Texture System
@@ -1587,7 +3451,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
                 vtConfig.maxPhysicalPages = 4096;  // 256MB physical memory
                 vtConfig.maxVirtualTextures = 1024;
                 
-                if (m_virtualTextureSystem.Initialize(m_device.Get(), vtConfig)) {
+                if (m_virtualTextureSystem.Initialize(m_device.Get(), vtConfig, &m_uploadRing)) {
                     std::cout << "  ✓ Virtual Texture System initialized successfully" << std::endl;
                     
                     // Add each texture to virtual texture system
@@ -1604,8 +3468,9 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
                     if (allTexturesAdded) {
                         // Upload all tiles
                         if (m_virtualTextureSystem.UploadAllTiles(cmdList, m_commandQueue.Get())) {
-                            // Create indirection texture
-                            if (m_virtualTextureSystem.CreateIndirectionTexture(cmdList, m_commandQueue.Get())) {
+                            // Create indirection texture and the tile request feedback buffer
+                            if (m_virtualTextureSystem.CreateIndirectionTexture(cmdList, m_commandQueue.Get()) &&
+                                m_virtualTextureSystem.CreateFeedbackResources(m_commandQueue.Get())) {
                                 // Set flag BEFORE creating SRVs so the function doesn't early-return
                                 useVirtualTextures = true;
                                 m_useVirtualTextures = true;
@@ -1615,7 +3480,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
                                 
                                 std::cout << "  ✓ Virtual Texture System ready" << std::endl;
                             } else {
-                                std::cerr << "  ✗ Failed to create indirection texture" << std::endl;
+                                std::cerr << "  ✗ Failed to create indirection texture or feedback buffer" << std::endl;
                             }
                         } else {
                             std::cerr << "  ✗ Failed to upload tiles" << std::endl;
@@ -1628,193 +3493,108 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
                 }
             }
             
-            // **FALLBACK: Use conventional texture array with downsampling**
+            // **FALLBACK: Use resident textures, scaled down uniformly if they exceed the budget**
+            float dimensionScale = 1.0f;
             if (!useVirtualTextures) {
                 m_useVirtualTextures = false;
-                
-                // Apply aggressive downsampling if needed
-                bool needsDownsampling = false;
-                if (maxWidth > MAX_TEXTURE_DIMENSION || maxHeight > MAX_TEXTURE_DIMENSION) {
-                    needsDownsampling = true;
+                if (totalTextures > static_cast<int>(MAX_BINDLESS_TEXTURES)) {
+                    throw std::runtime_error("Scene has " + std::to_string(totalTextures) + " textures, more than the " +
+                        std::to_string(MAX_BINDLESS_TEXTURES) + " bindless descriptors, and virtual textures are unavailable");
                 }
-                if (arrayMemoryMB > MAX_TEXTURE_ARRAY_VRAM_MB) {
-                    needsDownsampling = true;
-                }
-                
-                if (needsDownsampling) {
-                    float memoryRatio = static_cast<float>(MAX_TEXTURE_ARRAY_VRAM_MB) / static_cast<float>(arrayMemoryMB);
-                    float dimensionScale = std::sqrt(std::min(memoryRatio, 1.0f));
+                if (textureMemoryMB > MAX_TEXTURE_VRAM_MB) {
+                    float memoryRatio = static_cast<float>(MAX_TEXTURE_VRAM_MB) / static_cast<float>(textureMemoryMB);
+                    dimensionScale = std::sqrt(std::min(memoryRatio, 1.0f));
                     
-                    UINT targetMaxWidth = static_cast<UINT>(maxWidth * dimensionScale);
-                    UINT targetMaxHeight = static_cast<UINT>(maxHeight * dimensionScale);
-                    
-                    targetMaxWidth = std::min(targetMaxWidth, MAX_TEXTURE_DIMENSION);
-                    targetMaxHeight = std::min(targetMaxHeight, MAX_TEXTURE_DIMENSION);
-                    targetMaxWidth = std::max(targetMaxWidth, 256U);
-                    targetMaxHeight = std::max(targetMaxHeight, 256U);
-                    
-                    std::cout << "  Downsampling textures: " << maxWidth << "x" << maxHeight 
-                              << " -> " << targetMaxWidth << "x" << targetMaxHeight << std::endl;
-                    std::cout << "    Scale factor: " << (dimensionScale * 100.0f) << "%" << std::endl;
-                    
-                    maxWidth = targetMaxWidth;
-                    maxHeight = targetMaxHeight;
-                    
-                    size_t newMemoryMB = (size_t)maxWidth * maxHeight * 4 * totalTextures / (1024 * 1024);
-                    std::cout << "    New estimated VRAM: " << newMemoryMB << " MB" << std::endl;
+                    size_t newBytes = 0;
+                    for (const auto& tex : textures) {
+                        newBytes += GetTextureChainSize(GetTextureExtent(*tex, dimensionScale));
+                    }
+                    std::cout << "  Downsampling textures to " << (dimensionScale * 100.0f) << "% of their size" << std::endl;
+                    std::cout << "    New estimated VRAM: " << newBytes / (1024 * 1024) << " MB" << std::endl;
                 }
             }
             
-            // **STEP 2: Create texture array resource**
+            // **STEP 2: Create one texture resource and heap descriptor per texture**
             if (!useVirtualTextures) {
-                if (m_textureAtlas == nullptr) {
-                D3D12_RESOURCE_DESC texArrayDesc = {};
-                texArrayDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-                texArrayDesc.Width = maxWidth;
-                texArrayDesc.Height = maxHeight;
-                texArrayDesc.DepthOrArraySize = static_cast<UINT16>(totalTextures);
-                texArrayDesc.MipLevels = 1;
-                texArrayDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-                texArrayDesc.SampleDesc.Count = 1;
-                texArrayDesc.SampleDesc.Quality = 0;
-                texArrayDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-                texArrayDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-                
-                CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
-                ThrowIfFailed(m_device->CreateCommittedResource(
-                    &defaultHeapProps,
-                    D3D12_HEAP_FLAG_NONE,
-                    &texArrayDesc,
-                    D3D12_RESOURCE_STATE_COPY_DEST,
-                    nullptr,
-                    IID_PPV_ARGS(&m_textureAtlas)
-                ));
-                m_textureAtlas->SetName(L"Texture Array");
-                std::cout << "  ✓ Texture array created: " << maxWidth << "x" << maxHeight 
-                          << " x " << totalTextures << " slices" << std::endl;
-            }
+                CreateBindlessTextures(textures, dimensionScale);
             
             // **STEP 3: Batch upload data**
-            const int MAX_TEXTURES_PER_BATCH = 64;
+            // Batches are staged in the upload ring. A batch uses at most half of it, so the next
+            // batch is encoded on the CPU while the GPU still copies the previous one
+            const UINT64 batchBudget = m_uploadRing.GetCapacity() / 2;
+            std::vector<int> batchStarts;
+            std::vector<UINT64> batchBytes;
+            for (int i = 0; i < totalTextures; ++i) {
+                UINT64 uploadSize = GetRequiredIntermediateSize(m_textures[i].Get(), 0, m_textures[i]->GetDesc().MipLevels);
+                if (batchStarts.empty() || i - batchStarts.back() >= MAX_TEXTURES_PER_BATCH ||
+                    batchBytes.back() + uploadSize > batchBudget) {
+                    batchStarts.push_back(i);
+                    batchBytes.push_back(0);
+                }
+                batchBytes.back() += uploadSize;
+            }
+            batchStarts.push_back(totalTextures);
             
-            // Collect UV scale factors for all textures
-            std::vector<glm::vec2> uvScales;
-            uvScales.reserve(totalTextures);
+            int numBatches = static_cast<int>(batchBytes.size());
+            if (numBatches > 1) {
+                std::cout << "  Using BATCH UPLOAD (" << numBatches << " batches)" << std::endl;
+            }
             
-            if (totalTextures > MAX_TEXTURES_PER_BATCH) {
-                std::cout << "  Using BATCH UPLOAD (" << MAX_TEXTURES_PER_BATCH 
-                          << " textures per batch)" << std::endl;
+            ScopedTimer uploadTimer(m_workStats.phases[PhaseIndex(RenderPhase::TextureUpload)].cpuMs);
+            for (int batchIdx = 0; batchIdx < numBatches; ++batchIdx) {
+                int batchStart = batchStarts[batchIdx];
+                int batchEnd = batchStarts[batchIdx + 1];
+                int batchSize = batchEnd - batchStart;
                 
-                int numBatches = (totalTextures + MAX_TEXTURES_PER_BATCH - 1) / MAX_TEXTURES_PER_BATCH;
+                if (numBatches > 1) {
+                    ACG_LOG_DEBUG("  [Batch " << (batchIdx + 1) << "/" << numBatches << "] "
+                                  << "Uploading textures " << batchStart << "-" << (batchEnd - 1)
+                                  << " (" << batchSize << " textures)");
+                }
                 
-                for (int batchIdx = 0; batchIdx < numBatches; ++batchIdx) {
-                    int batchStart = batchIdx * MAX_TEXTURES_PER_BATCH;
-                    int batchEnd = std::min(batchStart + MAX_TEXTURES_PER_BATCH, totalTextures);
-                    int batchSize = batchEnd - batchStart;
-                    
-                    std::cout << "  [Batch " << (batchIdx + 1) << "/" << numBatches << "] "
-                              << "Uploading textures " << batchStart << "-" << (batchEnd - 1) 
-                              << " (" << batchSize << " textures)" << std::endl;
-                    
-                    std::vector<std::shared_ptr<Texture>> batchTextures(
-                        textures.begin() + batchStart,
-                        textures.begin() + batchEnd
-                    );
+                std::vector<std::shared_ptr<Texture>> batchTextures(
+                    textures.begin() + batchStart,
+                    textures.begin() + batchEnd
+                );
+                
+                try {
+                    // Upload this batch on the copy queue. Encoding the next batch overlaps this copy;
+                    // the ring fence tracks when its staging space is free
+                    BeginCopyCommands();
+                    const UINT gpuRange = m_copyProfiler.BeginRange(m_copyCommandList.Get(), PhaseIndex(RenderPhase::TextureUpload));
+                    UploadTextureBatchData(m_copyCommandList.Get(), batchTextures, batchStart);
+                    m_copyProfiler.EndRange(m_copyCommandList.Get(), gpuRange);
+                    SubmitCopyCommands();
+                    if (batchBytes[batchIdx] > m_uploadRing.GetCapacity()) {
+                        m_uploadRing.WaitIdle();  // m_textureUpload is reused by the next batch
+                    }
                     
-                    try {
-                        // Create independent command list for this batch
-                        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> batchAllocator;
-                        ThrowIfFailed(m_device->CreateCommandAllocator(
-                            D3D12_COMMAND_LIST_TYPE_DIRECT,
-                            IID_PPV_ARGS(&batchAllocator)),
-                            "Failed to create batch allocator");
-                        
-                        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> tempBatchList;
-                        ThrowIfFailed(m_device->CreateCommandList(
-                            0,
-                            D3D12_COMMAND_LIST_TYPE_DIRECT,
-                            batchAllocator.Get(),
-                            nullptr,
-                            IID_PPV_ARGS(&tempBatchList)),
-                            "Failed to create batch command list");
-                        
-                        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> batchCmdList;
-                        ThrowIfFailed(tempBatchList.As(&batchCmdList),
-                            "Failed to query batch command list interface");
-                        
-                        // Upload this batch (collect UV scales)
-                        UploadTextureBatchData(batchCmdList.Get(), batchTextures, batchStart, maxWidth, maxHeight, &uvScales);
-                        
-                        // Execute and wait for this batch
-                        ThrowIfFailed(batchCmdList->Close(), "Failed to close batch command list");
-                        ID3D12CommandList* lists[] = { batchCmdList.Get() };
-                        m_commandQueue->ExecuteCommandLists(1, lists);
-                        WaitForGpu();
-                        
-                        std::cout << "    ✓ Batch " << (batchIdx + 1) << " completed" << std::endl;
-                    } catch (const std::exception& e) {
-                        std::cerr << "    ✗ Batch " << (batchIdx + 1) << " failed: " << e.what() << std::endl;
-                        throw;
+                    if (numBatches > 1) {
+                        ACG_LOG_DEBUG("    ✓ Batch " << (batchIdx + 1) << " submitted");
                     }
+                } catch (const std::exception& e) {
+                    std::cerr << "    ✗ Batch " << (batchIdx + 1) << " failed: " << e.what() << std::endl;
+                    throw;
                 }
-            } else {
-                // Small texture set, upload all at once using caller's cmdList
-                UploadTextureBatchData(cmdList, textures, 0, maxWidth, maxHeight, &uvScales);
             }
             
-            // **STEP 4: Transition resource state (after all batches complete)**
-            auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-                m_textureAtlas.Get(),
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-            );
-            cmdList->ResourceBarrier(1, &barrier);
-            
-            // **STEP 5: Create SRV (once, after all uploads)**
-            D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-            srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-            srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-            srvDesc.Texture2DArray.MostDetailedMip = 0;
-            srvDesc.Texture2DArray.MipLevels = 1;
-            srvDesc.Texture2DArray.FirstArraySlice = 0;
-            srvDesc.Texture2DArray.ArraySize = totalTextures;
-            
-            D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = m_srvUavHeap->GetCPUDescriptorHandleForHeapStart();
-            UINT descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-            D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandle = { srvHandle.ptr + descriptorSize * 5 };
-            
-            m_device->CreateShaderResourceView(m_textureAtlas.Get(), &srvDesc, textureSrvHandle);
+            // **STEP 4: No transition needed**
+            // The textures decay to COMMON after the copy queue work and are implicitly promoted to a
+            // shader resource state by the first DispatchRays (which waits on m_copyFence)
             
-            std::cout << "  ✓ All textures uploaded and SRV created" << std::endl;
-            
-            // **STEP 6: Upload UV scale factors to GPU**
-            // CRITICAL: Root signature requires this buffer, so create even if empty
-            if (uvScales.empty()) {
-                // Create dummy buffer with default scale (1.0, 1.0)
-                uvScales.push_back(glm::vec2(1.0f, 1.0f));
-                std::cout << "  No UV scales collected, using default (1.0, 1.0)" << std::endl;
+            // **STEP 5: Point the materials straight at the heap descriptors**
+            for (MaterialData& matData : materialsCPU) {
+                float* indices = &matData.texIndices.x;
+                for (int slot = 0; slot < 4; ++slot) {
+                    int32_t texIndex;
+                    std::memcpy(&texIndex, &indices[slot], sizeof(int32_t));
+                    texIndex = texIndex >= 0 && texIndex < totalTextures ? static_cast<int32_t>(m_srvIndex_Textures) + texIndex : -1;
+                    std::memcpy(&indices[slot], &texIndex, sizeof(int32_t));
+                }
             }
             
-            size_t scalesBufferSize = sizeof(glm::vec2) * uvScales.size();
-            std::cout << "  Creating texture scales buffer: " << uvScales.size() << " scales (" << scalesBufferSize << " bytes)" << std::endl;
-            
-            m_textureScalesBuffer = CreateDefaultBuffer(m_device.Get(), cmdList, uvScales.data(), scalesBufferSize, m_textureScalesUpload);
-            
-            // Create SRV for scales buffer (slot 9 for t8)
-            D3D12_SHADER_RESOURCE_VIEW_DESC scalesSrvDesc = {};
-            scalesSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-            scalesSrvDesc.Format = DXGI_FORMAT_UNKNOWN;
-            scalesSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-            scalesSrvDesc.Buffer.FirstElement = 0;
-            scalesSrvDesc.Buffer.NumElements = static_cast<UINT>(uvScales.size());
-            scalesSrvDesc.Buffer.StructureByteStride = sizeof(glm::vec2);
-            scalesSrvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-            
-            D3D12_CPU_DESCRIPTOR_HANDLE scalesSrvHandle = { srvHandle.ptr + descriptorSize * 9 };
-            m_device->CreateShaderResourceView(m_textureScalesBuffer.Get(), &scalesSrvDesc, scalesSrvHandle);
-            
-            std::cout << "  ✓ Texture scales buffer created at slot 9 (t8)" << std::endl;
+            std::cout << "  ✓ All textures uploaded, descriptors at heap slots " << m_srvIndex_Textures << "-"
+                      << (m_srvIndex_Textures + totalTextures - 1) << std::endl;
             
             } // end if (!useVirtualTextures)
         } // end if (!textures.empty())
@@ -1826,6 +3606,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         const auto& materialLayers = m_scene->GetMaterialLayers();
         
         // **CREATE MATERIAL BUFFER**
+        m_hitGroupMaterials = materialsCPU;  // Hit group records embed the material of single-material meshes
         size_t materialBufferSize = sizeof(GPUMaterial) * materialsCPU.size();
         std::cout << "Creating material buffer: " << materialsCPU.size() << " materials, " 
                   << materialBufferSize << " bytes total, " << sizeof(GPUMaterial) << " bytes per material." << std::endl;
@@ -1889,17 +3670,19 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         D3D12_CPU_DESCRIPTOR_HANDLE uavHandle = srvHandle;
         m_device->CreateUnorderedAccessView(m_outputTexture.Get(), nullptr, &uavDesc, uavHandle);
 
-        // Create SRV for vertex buffer (structured buffer)
-        m_srvIndex_Vertices = 1;
+        // Create SRVs for the vertex streams (structured buffers: float3 positions, packed attributes)
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
         srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
         srvDesc.Format = DXGI_FORMAT_UNKNOWN;
         srvDesc.Buffer.FirstElement = 0;
         srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.Buffer.NumElements = static_cast<UINT>(vertices.size());
-        srvDesc.Buffer.StructureByteStride = sizeof(GPUVertex);
+        srvDesc.Buffer.NumElements = vertexCount;
+        srvDesc.Buffer.StructureByteStride = 3 * sizeof(float);
         D3D12_CPU_DESCRIPTOR_HANDLE srvVertHandle = { srvHandle.ptr + m_srvUavDescriptorSize * m_srvIndex_Vertices };
         m_device->CreateShaderResourceView(m_vertexBuffer.Get(), &srvDesc, srvVertHandle);
+        srvDesc.Buffer.StructureByteStride = sizeof(GPUVertexAttributes);
+        D3D12_CPU_DESCRIPTOR_HANDLE srvAttributeHandle = { srvHandle.ptr + m_srvUavDescriptorSize * m_srvIndex_VertexAttributes };
+        m_device->CreateShaderResourceView(m_vertexAttributeBuffer.Get(), &srvDesc, srvAttributeHandle);
 
         // Create SRV for index buffer (typed buffer - don't set StructureByteStride)
         m_srvIndex_Indices = 2;
@@ -1908,19 +3691,19 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         srvIdxDesc.Format = DXGI_FORMAT_R32_UINT;
         srvIdxDesc.Buffer.FirstElement = 0;
         srvIdxDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvIdxDesc.Buffer.NumElements = static_cast<UINT>(indices.size());
+        srvIdxDesc.Buffer.NumElements = indexCount;
         // For typed buffers, StructureByteStride must be 0
         D3D12_CPU_DESCRIPTOR_HANDLE srvIdxHandle = { srvHandle.ptr + m_srvUavDescriptorSize * m_srvIndex_Indices };
         m_device->CreateShaderResourceView(m_indexBuffer.Get(), &srvIdxDesc, srvIdxHandle);
 
-        // Create SRV for triangle material indices (typed buffer)
-        UINT srvIndex_TriangleMaterials = 3;
+        // Create SRV for per-face material indices (typed buffer)
+        UINT srvIndex_TriangleMaterials = m_srvIndex_TriangleMaterials;
         D3D12_SHADER_RESOURCE_VIEW_DESC srvTriMatDesc = {};
         srvTriMatDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
         srvTriMatDesc.Format = DXGI_FORMAT_R32_UINT;
         srvTriMatDesc.Buffer.FirstElement = 0;
         srvTriMatDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvTriMatDesc.Buffer.NumElements = static_cast<UINT>(triangleMaterialIndices.size());
+        srvTriMatDesc.Buffer.NumElements = faceMaterialCount;
         D3D12_CPU_DESCRIPTOR_HANDLE srvTriMatHandle = { srvHandle.ptr + m_srvUavDescriptorSize * srvIndex_TriangleMaterials };
         m_device->CreateShaderResourceView(m_triangleMaterialBuffer.Get(), &srvTriMatDesc, srvTriMatHandle);
 
@@ -1943,7 +3726,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         
         // Create SRV for material layers (structured buffer)
         // CRITICAL: Root signature requires this, buffer always exists now (dummy if empty)
-        m_srvIndex_MaterialLayers = 5;  // Slot 5
+        m_srvIndex_MaterialLayers = 8;  // Slot 8 (slots 5 and 9 are unused, textures are bindless)
         UINT numLayers = materialLayers.empty() ? 1 : static_cast<UINT>(materialLayers.size());  // At least 1 (dummy)
         
         D3D12_SHADER_RESOURCE_VIEW_DESC srvLayerDesc = {};
@@ -1957,6 +3740,53 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         m_device->CreateShaderResourceView(m_materialLayersBuffer.Get(), &srvLayerDesc, srvLayerHandle);
         std::cout << "  Material layers SRV created as StructuredBuffer: " << numLayers << " layers, stride=" << sizeof(MaterialExtendedData) << " bytes" << std::endl;
 
+        // Create alpha mask buffers and SRVs (slots 24-25); dummies keep the root table valid without cutouts
+        {
+            uint32_t dummyBits = 0;
+            AlphaMaskInfo dummyInfo = {};
+            UINT maskWordCount = m_alphaMaskBits.empty() ? 1 : static_cast<UINT>(m_alphaMaskBits.size());
+            UINT maskInfoCount = m_alphaMaskInfos.empty() ? 1 : static_cast<UINT>(m_alphaMaskInfos.size());
+            m_alphaMaskBuffer = CreateDefaultBuffer(m_device.Get(), cmdList,
+                m_alphaMaskBits.empty() ? &dummyBits : m_alphaMaskBits.data(), sizeof(uint32_t) * maskWordCount, m_alphaMaskUpload);
+            m_alphaMaskInfoBuffer = CreateDefaultBuffer(m_device.Get(), cmdList,
+                m_alphaMaskInfos.empty() ? &dummyInfo : m_alphaMaskInfos.data(), sizeof(AlphaMaskInfo) * maskInfoCount, m_alphaMaskInfoUpload);
+            
+            D3D12_SHADER_RESOURCE_VIEW_DESC srvMaskDesc = {};
+            srvMaskDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+            srvMaskDesc.Format = DXGI_FORMAT_UNKNOWN;
+            srvMaskDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            srvMaskDesc.Buffer.NumElements = maskWordCount;
+            srvMaskDesc.Buffer.StructureByteStride = sizeof(uint32_t);
+            D3D12_CPU_DESCRIPTOR_HANDLE srvMaskHandle = { srvHandle.ptr + m_srvUavDescriptorSize * m_srvIndex_AlphaMasks };
+            m_device->CreateShaderResourceView(m_alphaMaskBuffer.Get(), &srvMaskDesc, srvMaskHandle);
+            srvMaskDesc.Buffer.NumElements = maskInfoCount;
+            srvMaskDesc.Buffer.StructureByteStride = sizeof(AlphaMaskInfo);
+            srvMaskHandle.ptr += m_srvUavDescriptorSize;
+            m_device->CreateShaderResourceView(m_alphaMaskInfoBuffer.Get(), &srvMaskDesc, srvMaskHandle);
+        }
+
+        // Sampler tables (slot 28): scene independent, so only the first load builds and uploads them
+        if (!m_samplerTableBuffer) {
+            std::vector<uint32_t> samplerTables;
+            std::vector<uint32_t> blueNoiseRanks;
+            SamplingUtils::BuildSobolMatrices(samplerTables);
+            SamplingUtils::BuildBlueNoiseRanks(BLUE_NOISE_TILE_SIZE, blueNoiseRanks);
+            samplerTables.insert(samplerTables.end(), blueNoiseRanks.begin(), blueNoiseRanks.end());
+            m_samplerTableBuffer = CreateDefaultBuffer(m_device.Get(), cmdList,
+                samplerTables.data(), sizeof(uint32_t) * samplerTables.size(), m_samplerTableUpload);
+            
+            D3D12_SHADER_RESOURCE_VIEW_DESC srvTableDesc = {};
+            srvTableDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+            srvTableDesc.Format = DXGI_FORMAT_UNKNOWN;
+            srvTableDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            srvTableDesc.Buffer.NumElements = static_cast<UINT>(samplerTables.size());
+            srvTableDesc.Buffer.StructureByteStride = sizeof(uint32_t);
+            D3D12_CPU_DESCRIPTOR_HANDLE srvTableHandle = { srvHandle.ptr + m_srvUavDescriptorSize * m_srvIndex_SamplerTables };
+            m_device->CreateShaderResourceView(m_samplerTableBuffer.Get(), &srvTableDesc, srvTableHandle);
+            std::cout << "  Sampler tables: " << SamplingUtils::SOBOL_DIMENSIONS << " Sobol dimensions, "
+                      << BLUE_NOISE_TILE_SIZE << "x" << BLUE_NOISE_TILE_SIZE << " blue-noise tile" << std::endl;
+        }
+
         // Transition output texture to UAV state
         cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_outputTexture.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
 
@@ -2029,7 +3859,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         envSrvDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
         envSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
         envSrvDesc.Texture2D.MostDetailedMip = 0;
-        envSrvDesc.Texture2D.MipLevels = 1;
+        envSrvDesc.Texture2D.MipLevels = m_environmentMap->GetDesc().MipLevels;
         
         D3D12_CPU_DESCRIPTOR_HANDLE envMapSrvHandle = { srvHandle.ptr + m_srvUavDescriptorSize * 6 };
         m_device->CreateShaderResourceView(m_environmentMap.Get(), &envSrvDesc, envMapSrvHandle);
@@ -2047,259 +3877,176 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
             throw std::runtime_error(errorMsg);
         }
 
-        std::cout << "Shader resources uploaded: vertices=" << vertices.size() << " indices=" << indices.size() << " materials=" << materialsCPU.size() << std::endl;
+        std::cout << "Shader resources uploaded: vertices=" << vertexCount << " indices=" << indexCount << " materials=" << materialsCPU.size() << std::endl;
     }
 
     // ==================== TEXTURE MANAGEMENT (CLEAN ARCHITECTURE) ====================
     
     /**
-     * @brief Create texture array resource (Step 1: Resource Allocation)
+     * @brief Create the bindless texture resources and descriptors (Step 1: Resource Allocation)
+     * One block-compressed texture per scene texture at its own size with a full mip chain.
+     * The SRV of texture i is heap slot m_srvIndex_Textures + i, where the material indices point.
      * This only allocates GPU memory, does not upload any data
      */
-    void Renderer::CreateTextureArrayResource(int totalTextures, UINT maxWidth, UINT maxHeight) {
-        if (m_textureAtlas != nullptr) {
-            std::cout << "  Warning: Texture array already exists, skipping creation" << std::endl;
-            return;
-        }
-        
-        std::cout << "  [Resource Allocation] Creating texture array: " 
-                  << maxWidth << "x" << maxHeight << " x " << totalTextures << " slices" << std::endl;
-        
-        D3D12_RESOURCE_DESC texArrayDesc = {};
-        texArrayDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-        texArrayDesc.Width = maxWidth;
-        texArrayDesc.Height = maxHeight;
-        texArrayDesc.DepthOrArraySize = static_cast<UINT16>(totalTextures);
-        texArrayDesc.MipLevels = 1;
-        texArrayDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        texArrayDesc.SampleDesc.Count = 1;
-        texArrayDesc.SampleDesc.Quality = 0;
-        texArrayDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-        texArrayDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    void Renderer::CreateBindlessTextures(const std::vector<std::shared_ptr<Texture>>& textures, float dimensionScale) {
+        std::cout << "  [Resource Allocation] Creating " << textures.size() << " bindless textures" << std::endl;
         
+        // Recreated per load: sizes and count follow the scene being loaded
+        m_textures.clear();
+        m_textures.reserve(textures.size());
+        const UINT descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
         CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &defaultHeapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &texArrayDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(&m_textureAtlas)
-        ), "Failed to create texture array");
-        
-        m_textureAtlas->SetName(L"Texture Array");
-        std::cout << "  ✓ Texture array resource created" << std::endl;
+        size_t totalBytes = 0;
+        for (size_t i = 0; i < textures.size(); ++i) {
+            TextureExtent extent = GetTextureExtent(*textures[i], dimensionScale);
+            D3D12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(TextureCompressor::GetDXGIFormat(TEXTURE_FORMAT),
+                extent.width, extent.height, 1, static_cast<UINT16>(extent.mipLevels));
+            
+            Microsoft::WRL::ComPtr<ID3D12Resource> texture;
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &defaultHeapProps,
+                D3D12_HEAP_FLAG_NONE,
+                &texDesc,
+                D3D12_RESOURCE_STATE_COMMON,  // Promoted by the copy queue, decays back to COMMON
+                nullptr,
+                IID_PPV_ARGS(&texture)
+            ), "Failed to create texture");
+            texture->SetName(L"Scene Texture");
+            
+            D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+            srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            srvDesc.Format = texDesc.Format;
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            srvDesc.Texture2D.MostDetailedMip = 0;
+            srvDesc.Texture2D.MipLevels = extent.mipLevels;
+            CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(),
+                m_srvIndex_Textures + static_cast<UINT>(i), descriptorSize);
+            m_device->CreateShaderResourceView(texture.Get(), &srvDesc, srvHandle);
+            
+            totalBytes += GetTextureChainSize(extent);
+            m_textures.push_back(texture);
+        }
+        std::cout << "  ✓ Bindless textures created: " << textures.size() << " ("
+                  << TextureCompressor::GetFormatName(TEXTURE_FORMAT) << ", " << totalBytes / (1024 * 1024) << " MB)" << std::endl;
     }
     
     /**
-     * @brief Upload texture data to existing texture array (Step 2: Data Upload)
-     * Assumes texture array resource was already created by CreateTextureArrayResource
+     * @brief Upload texture data to the bindless textures (Step 2: Data Upload)
+     * Assumes the resources were already created by CreateBindlessTextures.
+     * Data is staged in m_uploadRing; the caller must Submit the ring after executing cmdList
      */
-    void Renderer::UploadTextureBatchData(ID3D12GraphicsCommandList4* cmdList, 
+    void Renderer::UploadTextureBatchData(ID3D12GraphicsCommandList* cmdList, 
                                          const std::vector<std::shared_ptr<Texture>>& textures, 
-                                         int startIndex, UINT maxWidth, UINT maxHeight,
-                                         std::vector<glm::vec2>* outUvScales) {
+                                         int startIndex) {
         if (textures.empty()) {
             return;
         }
         
-        if (m_textureAtlas == nullptr) {
-            throw std::runtime_error("Texture array must be created before uploading data");
+        if (startIndex + textures.size() > m_textures.size()) {
+            throw std::runtime_error("Textures must be created before uploading data");
         }
         
-        std::cout << "  [Data Upload] Uploading " << textures.size() << " textures starting at index " << startIndex << std::endl;        // Calculate upload buffer size for this batch
-        const UINT64 uploadBufferSize = GetRequiredIntermediateSize(m_textureAtlas.Get(), startIndex, textures.size());
-        
-        // Create temporary upload buffer for this batch
-        CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
-        auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-        
-        Microsoft::WRL::ComPtr<ID3D12Resource> batchUploadBuffer;
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &uploadHeapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &uploadBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&batchUploadBuffer)
-        ), "Failed to create upload buffer");
+        std::cout << "  [Data Upload] Uploading " << textures.size() << " textures starting at index " << startIndex << std::endl;
         
-        // Prepare subresource data
-        std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-        std::vector<std::vector<BYTE>> textureData;
-        textureData.reserve(textures.size());
+        // Prepare subresource data: the whole mip chain of each texture, block-compressed.
+        // Each texture is independent, so chains are encoded in parallel; results are
+        // reused from the on-disk cache while the source image is unchanged.
+        std::vector<std::vector<BYTE>> textureData(textures.size());
+        std::atomic<int> cachedCount(0);
+        std::atomic<int> resampledCount(0);
+        std::atomic<size_t> encodedBytes(0);
         
-        for (size_t i = 0; i < textures.size(); ++i) {
+        ParallelFor(textures.size(), [&](size_t i) {
             const auto& tex = textures[i];
+            D3D12_RESOURCE_DESC desc = m_textures[startIndex + i]->GetDesc();
+            TextureExtent extent = { static_cast<UINT>(desc.Width), desc.Height, desc.MipLevels };
+            const size_t chainSize = GetTextureChainSize(extent);
+            encodedBytes += chainSize;
             
-            const unsigned char* srcData = tex->GetRawData();
-            int srcChannels = tex->GetChannels();
-            int srcWidth = tex->GetWidth();
-            int srcHeight = tex->GetHeight();
-            
-            // Target dimensions must match array size (all slices must be same size)
-            UINT dstWidth = maxWidth;
-            UINT dstHeight = maxHeight;
+            if (TextureCompressor::LoadCached(tex->GetSourcePath(), TEXTURE_FORMAT, extent.width, extent.height,
+                                              extent.mipLevels, textureData[i])) {
+                ++cachedCount;
+                return;
+            }
             
-            // Allocate texture buffer (full size, will be padded)
-            std::vector<BYTE> rgba(maxWidth * maxHeight * 4, 0);
+            // Mip 0 is the texture itself unless it had to be resized (block alignment, memory budget)
+            Texture resampled;
+            Texture* source = tex.get();
+            if (extent.width != static_cast<UINT>(tex->GetWidth()) || extent.height != static_cast<UINT>(tex->GetHeight())) {
+                ++resampledCount;
+                std::vector<BYTE> rgba = ResampleRGBA8(*tex, extent.width, extent.height);
+                resampled.Create(extent.width, extent.height, 4, rgba.data());
+                source = &resampled;
+            }
+            if (source->GetMipLevels() < static_cast<int>(extent.mipLevels)) {
+                source->GenerateAdaptiveMipmaps();  // Kept with the texture; the VT tiles use the same levels
+            }
             
-            // Resample texture using bilinear interpolation if size differs
-            if (dstWidth != static_cast<UINT>(srcWidth) || dstHeight != static_cast<UINT>(srcHeight)) {
-                std::cout << "    Resampling texture " << i << ": " << srcWidth << "x" << srcHeight 
-                          << " -> " << dstWidth << "x" << dstHeight << std::endl;
-                
-                // Record UV scale factor (original / resampled)
-                if (outUvScales) {
-                    float scaleU = static_cast<float>(srcWidth) / static_cast<float>(dstWidth);
-                    float scaleV = static_cast<float>(srcHeight) / static_cast<float>(dstHeight);
-                    outUvScales->push_back(glm::vec2(scaleU, scaleV));
-                }
-                
-                for (UINT y = 0; y < dstHeight; ++y) {
-                    for (UINT x = 0; x < dstWidth; ++x) {
-                        // Calculate source coordinates (bilinear interpolation)
-                        float srcX = (static_cast<float>(x) + 0.5f) * srcWidth / dstWidth - 0.5f;
-                        float srcY = (static_cast<float>(y) + 0.5f) * srcHeight / dstHeight - 0.5f;
-                        
-                        int x0 = static_cast<int>(std::floor(srcX));
-                        int y0 = static_cast<int>(std::floor(srcY));
-                        int x1 = std::min(x0 + 1, srcWidth - 1);
-                        int y1 = std::min(y0 + 1, srcHeight - 1);
-                        x0 = std::max(x0, 0);
-                        y0 = std::max(y0, 0);
-                        
-                        float fx = srcX - x0;
-                        float fy = srcY - y0;
-                        
-                        // Sample 4 neighboring pixels
-                        for (int c = 0; c < 4; ++c) {
-                            float val00, val10, val01, val11;
-                            
-                            if (c < srcChannels) {
-                                int idx00 = (y0 * srcWidth + x0) * srcChannels + c;
-                                int idx10 = (y0 * srcWidth + x1) * srcChannels + c;
-                                int idx01 = (y1 * srcWidth + x0) * srcChannels + c;
-                                int idx11 = (y1 * srcWidth + x1) * srcChannels + c;
-                                
-                                val00 = srcData[idx00];
-                                val10 = srcData[idx10];
-                                val01 = srcData[idx01];
-                                val11 = srcData[idx11];
-                            } else if (c == 3 && srcChannels < 4) {
-                                // Alpha channel
-                                val00 = val10 = val01 = val11 = 255.0f;
-                            } else if (srcChannels == 1 && c < 3) {
-                                // Grayscale to RGB
-                                int idx00 = (y0 * srcWidth + x0) * srcChannels;
-                                int idx10 = (y0 * srcWidth + x1) * srcChannels;
-                                int idx01 = (y1 * srcWidth + x0) * srcChannels;
-                                int idx11 = (y1 * srcWidth + x1) * srcChannels;
-                                
-                                val00 = srcData[idx00];
-                                val10 = srcData[idx10];
-                                val01 = srcData[idx01];
-                                val11 = srcData[idx11];
-                            } else {
-                                val00 = val10 = val01 = val11 = 0.0f;
-                            }
-                            
-                            // Bilinear interpolation
-                            float val0 = val00 * (1.0f - fx) + val10 * fx;
-                            float val1 = val01 * (1.0f - fx) + val11 * fx;
-                            float val = val0 * (1.0f - fy) + val1 * fy;
-                            
-                            int dstIdx = (y * maxWidth + x) * 4 + c;
-                            rgba[dstIdx] = static_cast<BYTE>(std::min(std::max(val, 0.0f), 255.0f));
-                        }
-                    }
-                }
-            } else {
-                // Direct copy (no resampling needed)
-                if (outUvScales) {
-                    outUvScales->push_back(glm::vec2(1.0f, 1.0f));  // No scaling
-                }
-                
-                for (int y = 0; y < srcHeight; ++y) {
-                    for (int x = 0; x < srcWidth; ++x) {
-                        int srcIdx = (y * srcWidth + x) * srcChannels;
-                        int dstIdx = (y * maxWidth + x) * 4;
-                        
-                        if (srcChannels >= 3) {
-                            rgba[dstIdx + 0] = srcData[srcIdx + 0];
-                            rgba[dstIdx + 1] = srcData[srcIdx + 1];
-                            rgba[dstIdx + 2] = srcData[srcIdx + 2];
-                            rgba[dstIdx + 3] = (srcChannels == 4) ? srcData[srcIdx + 3] : 255;
-                        } else if (srcChannels == 1) {
-                            rgba[dstIdx + 0] = srcData[srcIdx];
-                            rgba[dstIdx + 1] = srcData[srcIdx];
-                            rgba[dstIdx + 2] = srcData[srcIdx];
-                            rgba[dstIdx + 3] = 255;
-                        }
-                    }
-                }
+            textureData[i].clear();
+            textureData[i].reserve(chainSize);
+            for (UINT level = 0; level < extent.mipLevels; ++level) {
+                std::vector<uint8_t> blocks = TextureCompressor::Compress(TEXTURE_FORMAT, source->GetMipData(level),
+                    source->GetMipWidth(level), source->GetMipHeight(level), source->GetChannels(), false);
+                textureData[i].insert(textureData[i].end(), blocks.begin(), blocks.end());
+            }
+            TextureCompressor::StoreCached(tex->GetSourcePath(), TEXTURE_FORMAT, extent.width, extent.height,
+                                           extent.mipLevels, textureData[i]);
+        });
+        
+        if (resampledCount > 0) {
+            std::cout << "    Resampled " << resampledCount << " textures to whole blocks or the memory budget" << std::endl;
+        }
+        std::cout << "    Encoded " << textures.size() << " textures as " << TextureCompressor::GetFormatName(TEXTURE_FORMAT)
+                  << " (" << cachedCount << " from cache, " << (encodedBytes / 1024) << " KB)" << std::endl;
+        
+        for (size_t i = 0; i < textures.size(); ++i) {
+            ID3D12Resource* texture = m_textures[startIndex + i].Get();
+            D3D12_RESOURCE_DESC desc = texture->GetDesc();
+            std::vector<D3D12_SUBRESOURCE_DATA> subresources(desc.MipLevels);
+            size_t dataOffset = 0;
+            for (UINT level = 0; level < desc.MipLevels; ++level) {
+                UINT mipWidth = std::max(1u, static_cast<UINT>(desc.Width) >> level);
+                UINT mipHeight = std::max(1u, desc.Height >> level);
+                subresources[level].pData = textureData[i].data() + dataOffset;
+                subresources[level].RowPitch = TextureCompressor::GetRowPitch(TEXTURE_FORMAT, mipWidth);
+                subresources[level].SlicePitch = TextureCompressor::GetCompressedSize(TEXTURE_FORMAT, mipWidth, mipHeight);
+                dataOffset += subresources[level].SlicePitch;
             }
             
-            textureData.push_back(std::move(rgba));
+            // Stage in the upload ring (allocated after encoding, so waiting for ring space overlaps
+            // with the CPU work). The caller submits the ring after executing cmdList
+            const UINT64 uploadBufferSize = GetRequiredIntermediateSize(texture, 0, desc.MipLevels);
+            UploadRing::Allocation staging = m_uploadRing.Allocate(uploadBufferSize);
+            ID3D12Resource* uploadBuffer = staging.resource;
+            UINT64 uploadOffset = staging.offset;
+            if (!staging) {
+                // Too large for the ring (always alone in its batch): dedicated buffer, kept alive until the caller has waited
+                CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+                auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
+                ThrowIfFailed(m_device->CreateCommittedResource(
+                    &uploadHeapProps,
+                    D3D12_HEAP_FLAG_NONE,
+                    &uploadBufferDesc,
+                    D3D12_RESOURCE_STATE_GENERIC_READ,
+                    nullptr,
+                    IID_PPV_ARGS(&m_textureUpload)
+                ), "Failed to create upload buffer");
+                uploadBuffer = m_textureUpload.Get();
+                uploadOffset = 0;
+            }
             
-            D3D12_SUBRESOURCE_DATA subresource = {};
-            subresource.pData = textureData.back().data();
-            subresource.RowPitch = maxWidth * 4;
-            subresource.SlicePitch = subresource.RowPitch * maxHeight;
-            subresources.push_back(subresource);
+            // Upload to GPU
+            UpdateSubresources(cmdList, texture, uploadBuffer,
+                              uploadOffset, 0, desc.MipLevels, subresources.data());
         }
         
-        // Upload to GPU
-        UpdateSubresources(cmdList, m_textureAtlas.Get(), batchUploadBuffer.Get(),
-                          0, startIndex, static_cast<UINT>(subresources.size()), subresources.data());
-        
-        // Keep upload buffer alive (stored as member to prevent premature destruction)
-        m_textureUpload = batchUploadBuffer;
-        
         std::cout << "  ✓ Batch data uploaded to GPU" << std::endl;
     }
     
-    /**
-     * @brief Finalize texture array (Step 3: State Transition & Descriptor Creation)
-     * Transitions resource to shader-readable state and creates SRV
-     */
-    void Renderer::FinalizeTextureArray(ID3D12GraphicsCommandList4* cmdList, int totalTextures) {
-        if (m_textureAtlas == nullptr) {
-            throw std::runtime_error("Texture array must exist before finalization");
-        }
-        
-        std::cout << "  [Finalization] Transitioning texture array to shader resource state" << std::endl;
-        
-        // Transition resource state
-        auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            m_textureAtlas.Get(),
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-        );
-        cmdList->ResourceBarrier(1, &barrier);
-        
-        // Create SRV in descriptor heap (slot 5 for t3)
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-        srvDesc.Texture2DArray.MostDetailedMip = 0;
-        srvDesc.Texture2DArray.MipLevels = 1;
-        srvDesc.Texture2DArray.FirstArraySlice = 0;
-        srvDesc.Texture2DArray.ArraySize = totalTextures;
-        
-        D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = m_srvUavHeap->GetCPUDescriptorHandleForHeapStart();
-        UINT descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-        D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandle = { srvHandle.ptr + descriptorSize * 5 };
-        
-        m_device->CreateShaderResourceView(m_textureAtlas.Get(), &srvDesc, textureSrvHandle);
-        
-        std::cout << "  ✓ Texture array finalized: " << totalTextures << " textures ready for rendering" << std::endl;
-    }
-    
     /**
      * @brief Create Virtual Texture SRVs (for Virtual Texture System)
-     * Creates SRVs for physical page cache (t5) and indirection texture (t6)
+     * Creates SRVs for physical page cache (t5), indirection texture (t6), texture info (t9)
+     * and the tile request feedback UAV (u1)
      */
     void Renderer::CreateVirtualTextureSRVs() {
         if (!m_useVirtualTextures) {
@@ -2314,13 +4061,16 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         // Slot 7: Virtual Texture Cache (t5) - physical page cache
         D3D12_CPU_DESCRIPTOR_HANDLE virtualTextureCacheSrv = { srvHandle.ptr + descriptorSize * 7 };
         
-        // Slot 8: Indirection Texture (t6) - lookup table
-        D3D12_CPU_DESCRIPTOR_HANDLE indirectionTextureSrv = { srvHandle.ptr + descriptorSize * 8 };
+        // Slots 10-12: VT table (root parameter 8) - indirection (t6), texture info (t9), feedback (u1)
+        D3D12_CPU_DESCRIPTOR_HANDLE indirectionTextureSrv = { srvHandle.ptr + descriptorSize * 10 };
+        D3D12_CPU_DESCRIPTOR_HANDLE textureInfoSrv = { srvHandle.ptr + descriptorSize * 11 };
+        D3D12_CPU_DESCRIPTOR_HANDLE feedbackUav = { srvHandle.ptr + descriptorSize * 12 };
         
         // Call Virtual Texture System to create its SRVs
-        m_virtualTextureSystem.CreateShaderResourceView(m_device.Get(), virtualTextureCacheSrv, indirectionTextureSrv);
+        m_virtualTextureSystem.CreateShaderResourceView(m_device.Get(), virtualTextureCacheSrv, indirectionTextureSrv,
+                                                        textureInfoSrv, feedbackUav);
         
-        std::cout << "  ✓ Virtual Texture SRVs created (slots 7 and 8)" << std::endl;
+        std::cout << "  ✓ Virtual Texture SRVs created (slots 7, 10-12)" << std::endl;
     }
 
     // ==================== ENVIRONMENT MAP ====================
@@ -2333,18 +4083,27 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
 
         std::cout << "  Uploading HDR environment map: " << envMap->GetWidth() << "x" << envMap->GetHeight() << std::endl;
         
+        // Full mip chain: filled by the compute pass after the upload, or on the CPU when it is unavailable
+        const bool gpuMipmaps = m_gpuMipmaps && m_mipmapPipelineState;
+        const UINT16 mipLevels = static_cast<UINT16>(1 + std::floor(std::log2(static_cast<float>(
+            std::max(envMap->GetWidth(), envMap->GetHeight())))));
+        if (!gpuMipmaps && envMap->GetHDRMipLevels() < mipLevels) {
+            envMap->GenerateMipmaps();
+        }
+        const UINT uploadLevels = gpuMipmaps ? 1 : mipLevels;
+        
         // Create texture resource for environment map
         D3D12_RESOURCE_DESC texDesc = {};
         texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
         texDesc.Width = envMap->GetWidth();
         texDesc.Height = envMap->GetHeight();
         texDesc.DepthOrArraySize = 1;
-        texDesc.MipLevels = 1;
+        texDesc.MipLevels = mipLevels;
         texDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;  // HDR format
         texDesc.SampleDesc.Count = 1;
         texDesc.SampleDesc.Quality = 0;
         texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-        texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+        texDesc.Flags = gpuMipmaps ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
         
         CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
         ThrowIfFailed(m_device->CreateCommittedResource(
@@ -2358,7 +4117,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         m_environmentMap->SetName(L"Environment Map");
         
         // Create upload buffer
-        const UINT64 uploadBufferSize = GetRequiredIntermediateSize(m_environmentMap.Get(), 0, 1);
+        const UINT64 uploadBufferSize = GetRequiredIntermediateSize(m_environmentMap.Get(), 0, uploadLevels);
         
         CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
         auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
@@ -2374,46 +4133,65 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         ));
         
         // Prepare subresource data (convert to RGBA if needed)
-        const float* hdrData = envMap->GetHDRData();
         int channels = envMap->GetChannels();
         int width = envMap->GetWidth();
         int height = envMap->GetHeight();
         
-        std::vector<float> rgba(width * height * 4);
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                int srcIdx = (y * width + x) * channels;
-                int dstIdx = (y * width + x) * 4;
-                
-                if (channels >= 3) {
-                    rgba[dstIdx + 0] = hdrData[srcIdx + 0];
-                    rgba[dstIdx + 1] = hdrData[srcIdx + 1];
-                    rgba[dstIdx + 2] = hdrData[srcIdx + 2];
-                    rgba[dstIdx + 3] = (channels == 4) ? hdrData[srcIdx + 3] : 1.0f;
-                } else if (channels == 1) {
-                    rgba[dstIdx + 0] = hdrData[srcIdx];
-                    rgba[dstIdx + 1] = hdrData[srcIdx];
-                    rgba[dstIdx + 2] = hdrData[srcIdx];
-                    rgba[dstIdx + 3] = 1.0f;
+        std::vector<std::vector<float>> levelData(uploadLevels);
+        std::vector<D3D12_SUBRESOURCE_DATA> subresources(uploadLevels);
+        for (UINT level = 0; level < uploadLevels; ++level) {
+            const float* hdrData = envMap->GetHDRMipData(level);
+            int levelWidth = envMap->GetHDRMipWidth(level);
+            int levelHeight = envMap->GetHDRMipHeight(level);
+            
+            std::vector<float>& rgba = levelData[level];
+            rgba.resize(static_cast<size_t>(levelWidth) * levelHeight * 4);
+            for (int y = 0; y < levelHeight; ++y) {
+                for (int x = 0; x < levelWidth; ++x) {
+                    int srcIdx = (y * levelWidth + x) * channels;
+                    int dstIdx = (y * levelWidth + x) * 4;
+                    
+                    if (channels >= 3) {
+                        rgba[dstIdx + 0] = hdrData[srcIdx + 0];
+                        rgba[dstIdx + 1] = hdrData[srcIdx + 1];
+                        rgba[dstIdx + 2] = hdrData[srcIdx + 2];
+                        rgba[dstIdx + 3] = (channels == 4) ? hdrData[srcIdx + 3] : 1.0f;
+                    } else if (channels == 1) {
+                        rgba[dstIdx + 0] = hdrData[srcIdx];
+                        rgba[dstIdx + 1] = hdrData[srcIdx];
+                        rgba[dstIdx + 2] = hdrData[srcIdx];
+                        rgba[dstIdx + 3] = 1.0f;
+                    }
                 }
             }
+            
+            subresources[level].pData = rgba.data();
+            subresources[level].RowPitch = levelWidth * 4 * sizeof(float);
+            subresources[level].SlicePitch = subresources[level].RowPitch * levelHeight;
         }
         
-        D3D12_SUBRESOURCE_DATA subresource = {};
-        subresource.pData = rgba.data();
-        subresource.RowPitch = width * 4 * sizeof(float);
-        subresource.SlicePitch = subresource.RowPitch * height;
-        
         // Upload to GPU
-        UpdateSubresources(cmdList, m_environmentMap.Get(), envMapUpload.Get(), 0, 0, 1, &subresource);
+        UpdateSubresources(cmdList, m_environmentMap.Get(), envMapUpload.Get(), 0, 0, uploadLevels, subresources.data());
         
-        // Transition to shader resource
-        auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            m_environmentMap.Get(),
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-        );
-        cmdList->ResourceBarrier(1, &barrier);
+        // Transition to shader resource (non-pixel: read by the CDF compute pass and DXR)
+        if (gpuMipmaps) {
+            std::vector<D3D12_RESOURCE_BARRIER> barriers;
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(m_environmentMap.Get(),
+                D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE, 0));
+            for (UINT level = 1; level < mipLevels; ++level) {
+                barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(m_environmentMap.Get(),
+                    D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, level));
+            }
+            cmdList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+            GenerateMipsOnGpu(cmdList, m_environmentMap.Get());
+        } else {
+            auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                m_environmentMap.Get(),
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE
+            );
+            cmdList->ResourceBarrier(1, &barrier);
+        }
         
         // Create SRV in descriptor heap (slot 6 for environment map)
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
@@ -2421,7 +4199,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         srvDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
         srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
         srvDesc.Texture2D.MostDetailedMip = 0;
-        srvDesc.Texture2D.MipLevels = 1;
+        srvDesc.Texture2D.MipLevels = mipLevels;
         
         D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = m_srvUavHeap->GetCPUDescriptorHandleForHeapStart();
         UINT descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
@@ -2429,7 +4207,11 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         
         m_device->CreateShaderResourceView(m_environmentMap.Get(), &srvDesc, envMapSrvHandle);
         
-        std::cout << "  ✓ Environment map uploaded: " << width << "x" << height << std::endl;
+        // Importance sampling distribution, built on the same command list
+        BuildEnvironmentCdf(cmdList, static_cast<UINT>(width), static_cast<UINT>(height));
+        
+        std::cout << "  ✓ Environment map uploaded: " << width << "x" << height << ", " << mipLevels << " mips ("
+                  << (gpuMipmaps ? "GPU" : "CPU") << " generated)" << std::endl;
         
         // Return upload buffer to keep it alive until GPU finishes using it
         return envMapUpload;
@@ -2447,9 +4229,15 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
 
         void* rayGenID = stateObjectProps->GetShaderIdentifier(L"RayGen");
         void* missID = stateObjectProps->GetShaderIdentifier(L"Miss");
-        void* hitGroupID = stateObjectProps->GetShaderIdentifier(L"HitGroup");
+        void* shadowMissID = stateObjectProps->GetShaderIdentifier(L"ShadowMiss");
+        void* hitGroupIDs[_countof(HIT_GROUPS)];
+        bool hitGroupsFound = true;
+        for (UINT group = 0; group < _countof(HIT_GROUPS); ++group) {
+            hitGroupIDs[group] = stateObjectProps->GetShaderIdentifier(HIT_GROUPS[group].hitGroup);
+            hitGroupsFound = hitGroupsFound && hitGroupIDs[group];
+        }
 
-        if (!rayGenID || !missID || !hitGroupID) {
+        if (!rayGenID || !missID || !shadowMissID || !hitGroupsFound) {
             throw std::runtime_error("Failed to get shader identifiers");
         }
 
@@ -2467,9 +4255,23 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         // Calculate offsets
         m_sbtRayGenOffset = 0;
         m_sbtMissOffset = m_sbtRayGenOffset + shaderRecordAlignedSize;
-        m_sbtHitGroupOffset = m_sbtMissOffset + shaderRecordAlignedSize;
+        // Miss table: 0 = radiance (environment), 1 = shadow rays
+        m_sbtHitGroupOffset = m_sbtMissOffset + SBT_MISS_SHADER_COUNT * shaderRecordAlignedSize;
+        
+        // Hit group records (InstanceContributionToHitGroupIndex = BLAS slot): identifier + MaterialData,
+        // aligned to D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT (32)
+        m_sbtHitGroupStride = (shaderIdentifierSize + sizeof(MaterialData) + D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT - 1)
+                              & ~(D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT - 1);
+        UINT blasSlotCount = std::max<UINT>(static_cast<UINT>(m_bottomLevelAS.size()), 1);
+        m_sbtHitGroupCount = blasSlotCount * SBT_RAY_TYPE_COUNT;
+        std::vector<const MeshGeometryRange*> blasRanges(blasSlotCount, nullptr);
+        for (size_t mesh = 0; mesh < m_meshBlasIndex.size() && mesh < m_meshRanges.size(); ++mesh) {
+            if (m_meshBlasIndex[mesh] >= 0) {
+                blasRanges[m_meshBlasIndex[mesh]] = &m_meshRanges[mesh];
+            }
+        }
         
-        UINT sbtSize = m_sbtHitGroupOffset + shaderRecordAlignedSize;
+        UINT sbtSize = m_sbtHitGroupOffset + m_sbtHitGroupCount * m_sbtHitGroupStride;
 
         // Create SBT upload buffer
         ThrowIfFailed(m_device->CreateCommittedResource(
@@ -2487,18 +4289,47 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         // Write RayGen record
         memcpy(mappedData + m_sbtRayGenOffset, rayGenID, shaderIdentifierSize);
         
-        // Write Miss record
+        // Write Miss records
         memcpy(mappedData + m_sbtMissOffset, missID, shaderIdentifierSize);
+        memcpy(mappedData + m_sbtMissOffset + shaderRecordAlignedSize, shadowMissID, shaderIdentifierSize);
         
-        // Write HitGroup record
-        memcpy(mappedData + m_sbtHitGroupOffset, hitGroupID, shaderIdentifierSize);
+        // Write HitGroup records: single-material BLASes get their class's hit group, the rest the uber
+        // shader; alpha-tested BLASes run the cutout any-hit for both ray types
+        UINT classCounts[_countof(HIT_GROUPS)] = {};
+        for (UINT slot = 0; slot < blasSlotCount; ++slot) {
+            uint8_t* record = mappedData + m_sbtHitGroupOffset + slot * SBT_RAY_TYPE_COUNT * m_sbtHitGroupStride;
+            const MeshGeometryRange* range = blasRanges[slot];
+            UINT materialIndex = range ? range->materialIndex : UINT_MAX;
+            UINT group = HIT_GROUP_MIXED;
+            MaterialData material;
+            if (range && range->alphaTested) {
+                group = HIT_GROUP_ALPHA_TEST;
+            } else if (materialIndex < m_hitGroupMaterials.size()) {
+                material = m_hitGroupMaterials[materialIndex];
+                group = GetMaterialClass(material);
+            }
+            memcpy(record, hitGroupIDs[group], shaderIdentifierSize);
+            memcpy(record + shaderIdentifierSize, &material, sizeof(MaterialData));
+            ++classCounts[group];
+            
+            uint8_t* shadowRecord = record + m_sbtHitGroupStride;
+            memset(shadowRecord, 0, m_sbtHitGroupStride);  // Null identifier: no shader
+            if (range && range->alphaTested) {
+                memcpy(shadowRecord, hitGroupIDs[HIT_GROUP_SHADOW_ALPHA_TEST], shaderIdentifierSize);
+            }
+        }
         
         m_sbtBuffer->Unmap(0, nullptr);
 
         std::cout << "Shader Binding Table created: RayGen@" << m_sbtRayGenOffset 
                   << " Miss@" << m_sbtMissOffset 
                   << " HitGroup@" << m_sbtHitGroupOffset 
-                  << " EntrySize=" << m_sbtEntrySize << std::endl;
+                  << " EntrySize=" << m_sbtEntrySize
+                  << " HitGroupStride=" << m_sbtHitGroupStride << std::endl;
+        std::cout << "  Hit groups: emissive=" << classCounts[0] << " transmission=" << classCounts[1]
+                  << " mirror=" << classCounts[2] << " diffuse=" << classCounts[3]
+                  << " mixed=" << classCounts[HIT_GROUP_MIXED]
+                  << " alpha-tested=" << classCounts[HIT_GROUP_ALPHA_TEST] << std::endl;
     }
 
     void Renderer::OnUpdate() {
@@ -2516,9 +4347,19 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         
         // Normal rendering when not doing offline render
         try {
-            PopulateCommandList();
+            // Frame pacing: wait until the swap chain takes another frame instead of blocking in Present
+            if (m_frameLatencyWaitableObject) {
+                WaitForSingleObjectEx(m_frameLatencyWaitableObject, 1000, TRUE);
+            }
+            
+            // The preview is skipped (GUI only) while a worker thread loads a scene or environment map
+            std::unique_lock<std::mutex> sceneLock(m_sceneMutex, std::try_to_lock);
+            PopulateCommandList(sceneLock.owns_lock());
             ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
             m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+            if (sceneLock.owns_lock()) {
+                m_uploadRing.Submit(m_commandQueue.Get());  // Tile uploads recorded by the preview
+            }
             m_swapChain->Present(1, 0);
             MoveToNextFrame();
         } catch (...) {
@@ -2526,7 +4367,7 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         }
     }
 
-    void Renderer::PopulateCommandList() {
+    void Renderer::PopulateCommandList(bool drawPreview) {
         try {
             // Wait for GPU to finish with this frame's command allocator
             const UINT64 completedValue = m_fence->GetCompletedValue();
@@ -2541,42 +4382,35 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
             m_commandAllocators[m_frameIndex]->Reset();
             m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), nullptr);
 
-            // NO RAYTRACING - Only clear background and render ImGui
-            // All raytracing is done offline in RenderToFile()
-            
-            // Transition render target to render target state
-            D3D12_RESOURCE_BARRIER rtBarrier = {};
-            rtBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            rtBarrier.Transition.pResource = m_renderTargets[m_frameIndex].Get();
-            rtBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-            rtBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-            rtBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-            m_commandList->ResourceBarrier(1, &rtBarrier);
-            
-            // Clear render target to a dark gray background
+            ID3D12Resource* backBuffer = m_renderTargets[m_frameIndex].Get();
             D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
             rtvHandle.ptr += m_frameIndex * m_rtvDescriptorSize;
-            const float clearColor[] = { 0.1f, 0.1f, 0.1f, 1.0f };
-            m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-            
-            // Set render target for ImGui
-            m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
             
-            // Render ImGui
-            {
-            // Transition to render target
-            D3D12_RESOURCE_BARRIER barrier = {};
-            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            barrier.Transition.pResource = m_renderTargets[m_frameIndex].Get();
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-            barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-            m_commandList->ResourceBarrier(1, &barrier);
-
-            D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-            rtvHandle.ptr += m_frameIndex * m_rtvDescriptorSize;
-            const float clearColor[] = { 0.1f, 0.2f, 0.4f, 1.0f };
-            m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+            // Progressive path-traced preview behind the GUI; final quality renders still go through RenderToFile()
+            if (drawPreview && RecordPreview()) {
+                D3D12_RESOURCE_BARRIER toCopy[2] = {
+                    CD3DX12_RESOURCE_BARRIER::Transition(backBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_DEST),
+                    CD3DX12_RESOURCE_BARRIER::Transition(m_displayTexture.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE)
+                };
+                m_commandList->ResourceBarrier(_countof(toCopy), toCopy);
+                
+                // Same size and format as the back buffer
+                m_commandList->CopyResource(backBuffer, m_displayTexture.Get());
+                
+                D3D12_RESOURCE_BARRIER fromCopy[2] = {
+                    CD3DX12_RESOURCE_BARRIER::Transition(backBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_RENDER_TARGET),
+                    CD3DX12_RESOURCE_BARRIER::Transition(m_displayTexture.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+                };
+                m_commandList->ResourceBarrier(_countof(fromCopy), fromCopy);
+            } else {
+                // No scene to trace: clear to the background color
+                D3D12_RESOURCE_BARRIER rtBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                    backBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+                m_commandList->ResourceBarrier(1, &rtBarrier);
+                
+                const float clearColor[] = { 0.1f, 0.2f, 0.4f, 1.0f };
+                m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+            }
             
             // Render ImGui on top
             m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
@@ -2584,12 +4418,11 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
             m_commandList->SetDescriptorHeaps(1, imguiHeaps);
             ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), m_commandList.Get());
 
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-            m_commandList->ResourceBarrier(1, &barrier);
-        }
+            D3D12_RESOURCE_BARRIER presentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+                backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+            m_commandList->ResourceBarrier(1, &presentBarrier);
 
-        ThrowIfFailed(m_commandList->Close(), "Failed to close command list");
+            ThrowIfFailed(m_commandList->Close(), "Failed to close command list");
         
         } catch (const std::exception& e) {
             std::cerr << "[PopulateCommandList] Exception: " << e.what() << std::endl;
@@ -2600,14 +4433,90 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         }
     }
 
-
+    bool Renderer::RecordPreview() {
+        if (!m_interactivePreview || !m_dxrSupported || !m_dxrStateObject || !m_resolvePipelineState ||
+            !m_topLevelAS || !m_scene || m_scene->GetMeshes().empty()) {
+            return false;
+        }
+        
+        // The preview covers the back buffer, independent of the offline output resolution.
+        // Earlier frames have completed (MoveToNextFrame waits), so resizing may recreate the textures
+        const D3D12_RESOURCE_DESC backBufferDesc = m_renderTargets[m_frameIndex]->GetDesc();
+        const UINT width = static_cast<UINT>(backBufferDesc.Width);
+        const UINT height = backBufferDesc.Height;
+        EnsureOutputTexture(width, height);
+        // Swap chain format, so the resolved image is copied to the back buffer as is
+        EnsureResolveTarget(m_displayTexture, m_uavIndex_Display, DXGI_FORMAT_R8G8B8A8_UNORM, width, height, L"Preview Display");
+        
+        // Any change of camera (Rotate, Move, setters), lighting, bounces or size restarts the accumulation
+        CameraConstants constants = BuildCameraConstants(width, height, m_maxBounces);
+        constants.samplesPerDispatch = PREVIEW_SAMPLES_PER_FRAME;
+        constants.adaptiveThreshold = 0.0f;  // Every pixel keeps sampling
+        bool restart = m_previewResetRequested.exchange(false) ||
+                       std::memcmp(&constants, &m_previewConstants, sizeof(CameraConstants)) != 0;
+        
+        // Tiles requested by the last frame (already completed) stream in before the VT tables are bound
+        if (m_useVirtualTextures && m_previewFeedbackPending) {
+            m_previewFeedbackPending = false;
+            uint32_t streamedTiles = m_virtualTextureSystem.UpdateStreaming(m_commandList.Get());
+            if (streamedTiles > 0 && m_previewSamples <= PREVIEW_VT_RESTART_SAMPLES) {
+                restart = true;
+            }
+        }
+        if (restart) {
+            m_previewConstants = constants;
+            m_previewSamples = 0;
+        }
+        
+        PIXBeginEvent(m_commandList.Get(), PIX_COLOR_INDEX(3), "Interactive Preview");
+        
+        // Once converged only the resolve runs (tone mapping may still change)
+        if (m_previewSamples < std::max(m_samplesPerPixel, 1)) {
+            BindRaytracingRootArguments(m_commandList.Get());
+            m_commandList->SetComputeRoot32BitConstants(10, sizeof(CameraConstants) / 4, &constants, 0);
+            m_commandList->SetComputeRoot32BitConstant(10, static_cast<UINT>(m_previewSamples),
+                static_cast<UINT>(offsetof(CameraConstants, frameIndex) / 4));
+            
+            if (restart) {
+                ClearAccumulation(m_commandList.Get(), { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) });
+            }
+            
+            D3D12_DISPATCH_RAYS_DESC dispatchDesc = GetDispatchRaysDesc();
+            dispatchDesc.Width = width;
+            dispatchDesc.Height = height;
+            m_commandList->DispatchRays(&dispatchDesc);
+            m_previewSamples += PREVIEW_SAMPLES_PER_FRAME;
+            
+            D3D12_RESOURCE_BARRIER uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(m_outputTexture.Get());
+            m_commandList->ResourceBarrier(1, &uavBarrier);
+            
+            if (m_useVirtualTextures) {
+                m_virtualTextureSystem.RecordFeedbackReadback(m_commandList.Get());
+                m_previewFeedbackPending = true;
+            }
+        }
+        
+        RecordResolve(m_commandList.Get(), m_uavIndex_Display, width, height, false);
+        
+        PIXEndEvent(m_commandList.Get());
+        return true;
+    }
 
     void Renderer::OnDestroy() {
+        for (auto& peer : m_peers) {
+            peer->OnDestroy();
+        }
+        m_peers.clear();
         WaitForGpu();
+        m_uploadRing.WaitIdle();  // Copy queue uploads
         if (m_fenceEvent) {
             CloseHandle(m_fenceEvent);
             m_fenceEvent = nullptr;
         }
+        if (m_frameLatencyWaitableObject) {
+            CloseHandle(m_frameLatencyWaitableObject);
+            m_frameLatencyWaitableObject = nullptr;
+        }
         std::cout << "Renderer destroyed" << std::endl;
     }
 
@@ -2620,19 +4529,22 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         m_height = height;
 
         WaitForGpu();
+        if (!m_swapChain) {
+            return;  // Offline-only renderer (multi-GPU peer): targets are sized per render
+        }
 
         // Release old render targets
         for (UINT i = 0; i < FrameCount; i++) {
             m_renderTargets[i].Reset();
         }
 
-        // Resize swap chain buffers
+        // Resize swap chain buffers (flags must match the ones the swap chain was created with)
         ThrowIfFailed(m_swapChain->ResizeBuffers(
             FrameCount,
             m_width,
             m_height,
             DXGI_FORMAT_R8G8B8A8_UNORM,
-            0
+            DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT
         ));
 
         m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
@@ -2656,6 +4568,727 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         }
     }
 
+    void Renderer::BeginCopyCommands() {
+        // The allocator is reused once the copies it recorded two submissions ago are done
+        const UINT index = m_copyAllocatorIndex;
+        m_uploadRing.WaitForSubmission(m_copyAllocatorSubmissions[index]);
+        ThrowIfFailed(m_copyCommandAllocators[index]->Reset(), "Failed to reset copy command allocator");
+        ThrowIfFailed(m_copyCommandList->Reset(m_copyCommandAllocators[index].Get(), nullptr), "Failed to reset copy command list");
+    }
+
+    UINT64 Renderer::SubmitCopyCommands() {
+        ThrowIfFailed(m_copyCommandList->Close(), "Failed to close copy command list");
+        ID3D12CommandList* lists[] = { m_copyCommandList.Get() };
+        m_copyQueue->ExecuteCommandLists(1, lists);
+        m_copyAllocatorSubmissions[m_copyAllocatorIndex] = m_uploadRing.Submit(m_copyQueue.Get());
+        m_copyAllocatorIndex ^= 1;
+        ThrowIfFailed(m_copyQueue->Signal(m_copyFence.Get(), ++m_copyFenceValue), "Failed to signal copy fence");
+        m_copyProfiler.Submit(m_copyFence.Get(), m_copyFenceValue);
+        return m_copyFenceValue;
+    }
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> Renderer::CreateBufferOnCopyQueue(const void* data, UINT64 size) {
+        // Created in COMMON: buffers are promoted to COPY_DEST by the copy and decay back to COMMON
+        // when the copy queue finishes, so no barriers are needed on either queue
+        Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+        CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+        auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &defaultHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            IID_PPV_ARGS(&buffer)), "Failed to create default buffer");
+        
+        // Copied in chunks of at most half the ring; a full ring submits what is recorded so far
+        const UINT64 maxChunk = m_uploadRing.GetCapacity() / 2;
+        const uint8_t* src = static_cast<const uint8_t*>(data);
+        for (UINT64 offset = 0; offset < size;) {
+            const UINT64 chunk = std::min(maxChunk, size - offset);
+            UploadRing::Allocation staging = m_uploadRing.Allocate(chunk);
+            if (!staging) {
+                SubmitCopyCommands();
+                BeginCopyCommands();
+                staging = m_uploadRing.Allocate(chunk);
+                if (!staging) {
+                    throw std::runtime_error("Upload ring allocation failed");
+                }
+            }
+            memcpy(staging.cpuAddress, src + offset, static_cast<size_t>(chunk));
+            m_copyCommandList->CopyBufferRegion(buffer.Get(), offset, staging.resource, staging.offset, chunk);
+            offset += chunk;
+        }
+        return buffer;
+    }
+
+    void Renderer::QueueWaitForCopies(UINT64 copyFenceValue) {
+        if (copyFenceValue > m_copyFenceWaited) {
+            ThrowIfFailed(m_commandQueue->Wait(m_copyFence.Get(), copyFenceValue), "Failed to wait for copy queue");
+            m_copyFenceWaited = copyFenceValue;
+        }
+    }
+
+    const char* Renderer::GetRenderPhaseName(RenderPhase phase) {
+        switch (phase) {
+        case RenderPhase::AccelerationStructureBuild: return "AS build";
+        case RenderPhase::TextureUpload: return "Texture upload";
+        case RenderPhase::PathTracing: return "Path tracing";
+        case RenderPhase::Readback: return "Readback";
+        case RenderPhase::Denoise: return "Denoise";
+        case RenderPhase::FileWrite: return "File write";
+        default: return "Unknown";
+        }
+    }
+
+    void Renderer::ResetPhaseStats(RenderPhase phase) {
+        // Ranges that finished before the reset must not be added to the new totals later
+        m_gpuProfiler.Collect();
+        m_copyProfiler.Collect();
+        m_workStats.phases[PhaseIndex(phase)] = FrameStats::Phase();
+        m_gpuProfiler.ResetPhase(PhaseIndex(phase));
+        m_copyProfiler.ResetPhase(PhaseIndex(phase));
+    }
+
+    void Renderer::PublishFrameStats() {
+        m_gpuProfiler.Collect();
+        m_copyProfiler.Collect();
+
+        FrameStats stats = m_workStats;
+        for (UINT phase = 0; phase < RENDER_PHASE_COUNT; ++phase) {
+            stats.phases[phase].gpuMs = m_gpuProfiler.GetPhaseMs(phase) + m_copyProfiler.GetPhaseMs(phase);
+            stats.phases[phase].ranges = m_gpuProfiler.GetPhaseRangeCount(phase) + m_copyProfiler.GetPhaseRangeCount(phase);
+        }
+        // Throughput of the dispatches themselves; wall time when the batches could not be timed
+        // or ran on several GPUs at once
+        const double tracingMs = stats.phases[PhaseIndex(RenderPhase::PathTracing)].gpuMs;
+        const double throughputMs = tracingMs > 0.0 && stats.deviceCount == 1 ? tracingMs : stats.renderMs;
+        stats.raysPerSecond = throughputMs > 0.0 ? static_cast<double>(stats.pathSamples) * 1000.0 / throughputMs : 0.0;
+        stats.memory = MeasureMemory();
+
+        std::lock_guard<std::mutex> lock(m_frameStatsMutex);
+        m_frameStats = stats;
+    }
+
+    FrameStats::Memory Renderer::MeasureMemory() const {
+        FrameStats::Memory memory;
+        ID3D12Device* device = m_device.Get();
+        if (!device) {
+            return memory;
+        }
+        for (ID3D12Resource* buffer : { m_vertexBuffer.Get(), m_vertexAttributeBuffer.Get(), m_indexBuffer.Get(),
+                                        m_triangleBuffer.Get(), m_triangleMaterialBuffer.Get(), m_materialBuffer.Get(),
+                                        m_materialLayersBuffer.Get(), m_alphaMaskBuffer.Get(), m_alphaMaskInfoBuffer.Get() }) {
+            memory.geometry += GetDeviceLocalBytes(device, buffer);
+        }
+        for (const auto& texture : m_textures) {
+            memory.textures += GetDeviceLocalBytes(device, texture.Get());
+        }
+        if (m_useVirtualTextures) {
+            memory.textures += m_virtualTextureSystem.GetStatistics().physicalMemoryMB * 1024 * 1024;
+        }
+        for (ID3D12Resource* resource : { m_environmentMap.Get(), m_envConditionalCdf.Get(), m_envMarginalCdf.Get() }) {
+            memory.environment += GetDeviceLocalBytes(device, resource);
+        }
+        for (const auto& blas : m_bottomLevelAS) {
+            memory.accelerationStructures += GetDeviceLocalBytes(device, blas.Get());
+        }
+        for (const auto& scratch : m_retiredScratchBuffers) {
+            memory.accelerationStructures += GetDeviceLocalBytes(device, scratch.Get());
+        }
+        for (ID3D12Resource* resource : { m_topLevelAS.Get(), m_tlasScratchBuffer.Get(), m_scratchPoolBuffer.Get() }) {
+            memory.accelerationStructures += GetDeviceLocalBytes(device, resource);
+        }
+        for (ID3D12Resource* target : { m_outputTexture.Get(), m_luminanceMomentsTexture.Get(), m_aovAlbedoTexture.Get(),
+                                        m_aovNormalTexture.Get(), m_displayTexture.Get(), m_resolveTexture.Get(),
+                                        m_resolveAlbedoTexture.Get(), m_resolveNormalTexture.Get(), m_toneMappedTexture.Get(),
+                                        m_denoiseSharedBuffer.Get() }) {
+            memory.renderTargets += GetDeviceLocalBytes(device, target);
+        }
+        for (const auto& backBuffer : m_renderTargets) {
+            memory.renderTargets += GetDeviceLocalBytes(device, backBuffer.Get());
+        }
+        for (ID3D12Resource* resource : { m_samplerTableBuffer.Get(), m_sbtBuffer.Get(), m_activePixelCounter.Get() }) {
+            memory.other += GetDeviceLocalBytes(device, resource);
+        }
+        return memory;
+    }
+
+    FrameStats Renderer::GetFrameStats() const {
+        FrameStats stats;
+        {
+            std::lock_guard<std::mutex> lock(m_frameStatsMutex);
+            stats = m_frameStats;
+        }
+        // Files are finished by the writer thread after RenderToFile returned
+        stats.phases[PhaseIndex(RenderPhase::FileWrite)].cpuMs = m_imageWriter.GetLastJobMs();
+        DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+        if (m_adapter && SUCCEEDED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo))) {
+            stats.memory.adapterUsage = memoryInfo.CurrentUsage;
+            stats.memory.adapterBudget = memoryInfo.Budget;
+        }
+        return stats;
+    }
+
+    bool Renderer::SaveFrameStats(const std::string& path) const {
+        const FrameStats stats = GetFrameStats();
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open frame stats file: " << path << std::endl;
+            return false;
+        }
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\n";
+        file << "  \"resolution\": [" << stats.width << ", " << stats.height << "],\n";
+        file << "  \"samplesPerPixel\": " << stats.samplesPerPixel << ",\n";
+        file << "  \"pathSamples\": " << stats.pathSamples << ",\n";
+        file << "  \"renderMs\": " << stats.renderMs << ",\n";
+        file << "  \"raysPerSecond\": " << stats.raysPerSecond << ",\n";
+        file << "  \"phases\": [\n";
+        for (UINT phase = 0; phase < RENDER_PHASE_COUNT; ++phase) {
+            const FrameStats::Phase& timing = stats.phases[phase];
+            file << "    { \"name\": \"" << GetRenderPhaseName(static_cast<RenderPhase>(phase)) << "\", \"gpuMs\": " << timing.gpuMs
+                 << ", \"cpuMs\": " << timing.cpuMs << ", \"ranges\": " << timing.ranges << " }"
+                 << (phase + 1 < RENDER_PHASE_COUNT ? "," : "") << "\n";
+        }
+        file << "  ],\n";
+        const Scene::LoadTimings& load = stats.sceneLoad;
+        file << "  \"sceneLoad\": { \"conversionMs\": " << load.conversionMs << ", \"importMs\": " << load.importMs
+             << ", \"materialsMs\": " << load.materialsMs << ", \"texturesMs\": " << load.texturesMs
+             << ", \"geometryMs\": " << load.geometryMs << ", \"totalMs\": " << load.totalMs << " },\n";
+        const FrameStats::Memory& memory = stats.memory;
+        file << "  \"memoryBytes\": { \"geometry\": " << memory.geometry << ", \"textures\": " << memory.textures
+             << ", \"environment\": " << memory.environment << ", \"accelerationStructures\": " << memory.accelerationStructures
+             << ", \"renderTargets\": " << memory.renderTargets << ", \"other\": " << memory.other
+             << ", \"adapterUsage\": " << memory.adapterUsage << ", \"adapterBudget\": " << memory.adapterBudget << " }\n";
+        file << "}\n";
+
+        file.close();
+        if (!file) {
+            std::cerr << "Failed to write frame stats file: " << path << std::endl;
+            return false;
+        }
+        std::cout << "Frame stats written: " << path << std::endl;
+        return true;
+    }
+
+    void Renderer::CreatePeerRenderers() {
+        std::vector<Microsoft::WRL::ComPtr<IDXGIAdapter4>> adapters = EnumerateHardwareAdapters();
+        for (UINT i = 1; i < adapters.size(); ++i) {
+            DXGI_ADAPTER_DESC1 desc = {};
+            adapters[i]->GetDesc1(&desc);
+            std::cout << "Multi-GPU: initializing adapter " << i << " (" << desc.DedicatedVideoMemory / (1024 * 1024)
+                      << " MB dedicated memory)" << std::endl;
+
+            auto peer = std::make_unique<Renderer>(m_width, m_height);
+            peer->m_adapterIndex = i;
+            peer->m_inlineRayQuery = m_inlineRayQuery;
+            peer->m_shaderExecutionReordering = m_shaderExecutionReordering;
+            peer->m_gpuMipmaps = m_gpuMipmaps;
+            try {
+                peer->OnInit(nullptr);
+            } catch (const std::exception& e) {
+                std::cerr << "Multi-GPU: adapter " << i << " skipped: " << e.what() << std::endl;
+                continue;
+            }
+            if (!peer->m_dxrSupported || !peer->m_resolvePipelineState) {
+                std::cerr << "Multi-GPU: adapter " << i << " cannot path trace, skipped" << std::endl;
+                continue;
+            }
+            m_peers.push_back(std::move(peer));
+        }
+        std::cout << "Multi-GPU: offline renders use " << GetRenderDeviceCount() << " device(s)" << std::endl;
+    }
+
+    void Renderer::LoadPeerScenes(const std::string& path) {
+        // One after another: scene import shares process-wide state (texture cache directory, converter)
+        for (size_t i = 0; i < m_peers.size(); ) {
+            try {
+                m_peers[i]->LoadSceneAsync(path);
+                ++i;
+            } catch (const std::exception& e) {
+                // E.g. a card with less memory: the others keep rendering
+                std::cerr << "Multi-GPU: adapter " << m_peers[i]->m_adapterIndex << " failed to load the scene ("
+                          << e.what() << ") and is no longer used" << std::endl;
+                m_peers.erase(m_peers.begin() + i);
+            }
+        }
+    }
+
+    void Renderer::CopyRenderSettingsTo(Renderer& peer) const {
+        peer.OnResize(m_width, m_height);
+        peer.m_camera = m_camera;
+        peer.m_samplesPerDispatch = m_samplesPerDispatch;
+        peer.m_russianRouletteDepth = m_russianRouletteDepth;
+        peer.m_samplerType = m_samplerType;
+        peer.m_adaptiveThreshold = m_adaptiveThreshold;
+        peer.m_adaptiveMinSamples = m_adaptiveMinSamples;
+        peer.m_environmentLightIntensity = m_environmentLightIntensity;
+        peer.m_toneMapOperator = m_toneMapOperator;
+        peer.m_exposure = m_exposure;
+        peer.m_sunDirection = m_sunDirection;
+        peer.m_sunColor = m_sunColor;
+        peer.m_sunIntensity = m_sunIntensity;
+
+        // Instances moved since the load: the peer refits its TLAS like this device does
+        if (m_scene && peer.m_scene && peer.m_scene->GetInstances().size() == m_scene->GetInstances().size()) {
+            const std::vector<MeshInstance>& instances = m_scene->GetInstances();
+            for (size_t i = 0; i < instances.size(); ++i) {
+                if (peer.m_scene->GetInstances()[i].transform != instances[i].transform) {
+                    peer.m_scene->SetInstanceTransform(i, instances[i].transform);
+                }
+            }
+        }
+    }
+
+    UINT Renderer::GetEffectiveBucketSize() const {
+        if (m_bucketSize > 0) {
+            return static_cast<UINT>(m_bucketSize);
+        }
+        if (!m_peers.empty()) {
+            return MULTI_GPU_BUCKET_SIZE;
+        }
+        return static_cast<UINT64>(m_width) * m_height > BUCKET_AUTO_PIXELS ? DEFAULT_BUCKET_SIZE : 0;
+    }
+
+    void Renderer::EnsureOutputTexture(UINT width, UINT height) {
+        // Active pixel counter and its per-allocator readback slots, independent of the size
+        if (!m_activePixelCounter) {
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                nullptr,
+                IID_PPV_ARGS(&m_activePixelCounter)), "Failed to create active pixel counter");
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint32_t) * OFFLINE_BATCHES_IN_FLIGHT),
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                nullptr,
+                IID_PPV_ARGS(&m_activePixelReadback)), "Failed to create active pixel readback");
+
+            D3D12_UNORDERED_ACCESS_VIEW_DESC counterUavDesc = {};
+            counterUavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+            counterUavDesc.Format = DXGI_FORMAT_R32_UINT;
+            counterUavDesc.Buffer.NumElements = 1;
+            CD3DX12_CPU_DESCRIPTOR_HANDLE counterHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_ActivePixels, m_srvUavDescriptorSize);
+            m_device->CreateUnorderedAccessView(m_activePixelCounter.Get(), nullptr, &counterUavDesc, counterHandle);
+        }
+
+        if (m_outputTexture && m_luminanceMomentsTexture && m_aovAlbedoTexture && m_aovNormalTexture) {
+            // The scene upload creates the accumulation on its own, so the AOV size is checked as well
+            D3D12_RESOURCE_DESC currentDesc = m_outputTexture->GetDesc();
+            D3D12_RESOURCE_DESC aovDesc = m_aovAlbedoTexture->GetDesc();
+            if (currentDesc.Width == width && currentDesc.Height == height &&
+                aovDesc.Width == width && aovDesc.Height == height) {
+                return;
+            }
+        }
+
+        std::cout << "Creating accumulation texture " << width << "x" << height << "..." << std::endl;
+        D3D12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        m_outputTexture.Reset();
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &texDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_outputTexture)), "Failed to create output texture");
+
+        // Same descriptor slot, so the bound UAV table stays valid
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        uavDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        CD3DX12_CPU_DESCRIPTOR_HANDLE uavHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_Output, m_srvUavDescriptorSize);
+        m_device->CreateUnorderedAccessView(m_outputTexture.Get(), nullptr, &uavDesc, uavHandle);
+
+        // Luminance moments for adaptive sampling, same size as the accumulation
+        D3D12_RESOURCE_DESC momentsDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            DXGI_FORMAT_R32G32_FLOAT, width, height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        m_luminanceMomentsTexture.Reset();
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &momentsDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_luminanceMomentsTexture)), "Failed to create luminance moments texture");
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC momentsUavDesc = {};
+        momentsUavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        momentsUavDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+        CD3DX12_CPU_DESCRIPTOR_HANDLE momentsHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_Moments, m_srvUavDescriptorSize);
+        m_device->CreateUnorderedAccessView(m_luminanceMomentsTexture.Get(), nullptr, &momentsUavDesc, momentsHandle);
+
+        // Denoiser guide sums, written by the first hit of every sample
+        m_aovAlbedoTexture.Reset();
+        m_aovNormalTexture.Reset();
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &texDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_aovAlbedoTexture)), "Failed to create albedo AOV texture");
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &texDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_aovNormalTexture)), "Failed to create normal AOV texture");
+        CD3DX12_CPU_DESCRIPTOR_HANDLE albedoHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_AovAlbedo, m_srvUavDescriptorSize);
+        m_device->CreateUnorderedAccessView(m_aovAlbedoTexture.Get(), nullptr, &uavDesc, albedoHandle);
+        CD3DX12_CPU_DESCRIPTOR_HANDLE normalHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_AovNormal, m_srvUavDescriptorSize);
+        m_device->CreateUnorderedAccessView(m_aovNormalTexture.Get(), nullptr, &uavDesc, normalHandle);
+    }
+
+    void Renderer::EnsureResolveTarget(Microsoft::WRL::ComPtr<ID3D12Resource>& texture, UINT uavIndex, DXGI_FORMAT format,
+                                       UINT width, UINT height, const wchar_t* name) {
+        if (texture) {
+            D3D12_RESOURCE_DESC currentDesc = texture->GetDesc();
+            if (currentDesc.Width == width && currentDesc.Height == height && currentDesc.Format == format) {
+                return;
+            }
+        }
+        
+        D3D12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            format, width, height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        texture.Reset();
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &texDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&texture)), "Failed to create resolve texture");
+        texture->SetName(name);
+        
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        uavDesc.Format = format;
+        CD3DX12_CPU_DESCRIPTOR_HANDLE uavHandle(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), uavIndex, m_srvUavDescriptorSize);
+        m_device->CreateUnorderedAccessView(texture.Get(), nullptr, &uavDesc, uavHandle);
+    }
+
+    void Renderer::RecordResolve(ID3D12GraphicsCommandList4* cmdList, UINT uavIndex, UINT width, UINT height, bool hdrOutput,
+                                 bool resolveAOVs) {
+        cmdList->SetPipelineState(m_resolvePipelineState.Get());
+        cmdList->SetComputeRootSignature(m_resolveRootSignature.Get());
+        ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
+        cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+        
+        const D3D12_GPU_DESCRIPTOR_HANDLE heapStart = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
+        cmdList->SetComputeRootDescriptorTable(0, CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStart, m_uavIndex_Output, m_srvUavDescriptorSize));
+        cmdList->SetComputeRootDescriptorTable(1, CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStart, uavIndex, m_srvUavDescriptorSize));
+        cmdList->SetComputeRootDescriptorTable(3, CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStart, m_uavIndex_AovAlbedo, m_srvUavDescriptorSize));
+        
+        struct ResolveConstants {
+            UINT width;
+            UINT height;
+            float exposure;
+            UINT toneMapOperator;
+            UINT hdrOutput;
+            UINT resolveAOVs;
+        } constants = { width, height, m_exposure, static_cast<UINT>(m_toneMapOperator), hdrOutput ? 1u : 0u, resolveAOVs ? 1u : 0u };
+        cmdList->SetComputeRoot32BitConstants(2, sizeof(constants) / 4, &constants, 0);
+        cmdList->Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+    }
+
+    void Renderer::RecordToneMap(ID3D12GraphicsCommandList4* cmdList, UINT sourceUavIndex, UINT targetUavIndex, UINT width, UINT height) {
+        cmdList->SetPipelineState(m_toneMapPipelineState.Get());
+        cmdList->SetComputeRootSignature(m_resolveRootSignature.Get());
+        ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
+        cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+        
+        const D3D12_GPU_DESCRIPTOR_HANDLE heapStart = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
+        cmdList->SetComputeRootDescriptorTable(0, CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStart, sourceUavIndex, m_srvUavDescriptorSize));
+        cmdList->SetComputeRootDescriptorTable(1, CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStart, targetUavIndex, m_srvUavDescriptorSize));
+        
+        // Resolve constant layout; ToneMapCS ignores the HDR and AOV flags
+        struct ToneMapConstants {
+            UINT width;
+            UINT height;
+            float exposure;
+            UINT toneMapOperator;
+            UINT hdrOutput;
+            UINT resolveAOVs;
+        } constants = { width, height, m_exposure, static_cast<UINT>(m_toneMapOperator), 0u, 0u };
+        cmdList->SetComputeRoot32BitConstants(2, sizeof(constants) / 4, &constants, 0);
+        cmdList->Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+    }
+
+    bool Renderer::EnsureDenoiseSharedBuffer(UINT64 size) {
+        if (m_denoiseSharedBufferUnsupported || !m_toneMapPipelineState ||
+            !m_denoiser || !m_denoiser->SupportsD3D12SharedBuffers()) {
+            return false;
+        }
+        if (m_denoiseSharedBuffer && m_denoiseSharedBuffer->GetDesc().Width >= size) {
+            return true;
+        }
+        
+        m_denoiser->ReleaseSharedBuffer();
+        m_denoiseSharedBuffer.Reset();
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_SHARED,
+            &CD3DX12_RESOURCE_DESC::Buffer(size),
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            IID_PPV_ARGS(&m_denoiseSharedBuffer)), "Failed to create denoiser shared buffer");
+        m_denoiseSharedBuffer->SetName(L"Denoiser Shared Buffer");
+        
+        // The denoiser keeps its own reference to the memory, the NT handle is only needed for the import
+        HANDLE sharedHandle = nullptr;
+        ThrowIfFailed(m_device->CreateSharedHandle(m_denoiseSharedBuffer.Get(), nullptr, GENERIC_ALL, nullptr, &sharedHandle),
+            "Failed to create denoiser shared handle");
+        bool imported = m_denoiser->ImportD3D12SharedBuffer(sharedHandle, static_cast<size_t>(size));
+        CloseHandle(sharedHandle);
+        
+        if (!imported) {
+            std::cerr << "Denoiser cannot import D3D12 memory (" << m_denoiser->GetError()
+                      << "), denoising on the host" << std::endl;
+            m_denoiseSharedBuffer.Reset();
+            m_denoiseSharedBufferUnsupported = true;
+            return false;
+        }
+        return true;
+    }
+
+    void Renderer::ClearAccumulation(ID3D12GraphicsCommandList4* cmdList, const D3D12_RECT& rect) {
+        const float clearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        cmdList->ClearUnorderedAccessViewFloat(
+            CD3DX12_GPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), m_uavIndex_Output, m_srvUavDescriptorSize),
+            CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_Output, m_srvUavDescriptorSize),
+            m_outputTexture.Get(),
+            clearColor,
+            1, &rect
+        );
+        cmdList->ClearUnorderedAccessViewFloat(
+            CD3DX12_GPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), m_uavIndex_Moments, m_srvUavDescriptorSize),
+            CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_Moments, m_srvUavDescriptorSize),
+            m_luminanceMomentsTexture.Get(),
+            clearColor,
+            1, &rect
+        );
+        cmdList->ClearUnorderedAccessViewFloat(
+            CD3DX12_GPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), m_uavIndex_AovAlbedo, m_srvUavDescriptorSize),
+            CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_AovAlbedo, m_srvUavDescriptorSize),
+            m_aovAlbedoTexture.Get(),
+            clearColor,
+            1, &rect
+        );
+        cmdList->ClearUnorderedAccessViewFloat(
+            CD3DX12_GPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), m_uavIndex_AovNormal, m_srvUavDescriptorSize),
+            CD3DX12_CPU_DESCRIPTOR_HANDLE(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), m_uavIndex_AovNormal, m_srvUavDescriptorSize),
+            m_aovNormalTexture.Get(),
+            clearColor,
+            1, &rect
+        );
+
+        // Barrier after clear
+        D3D12_RESOURCE_BARRIER clearBarriers[4] = {};
+        clearBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        clearBarriers[0].UAV.pResource = m_outputTexture.Get();
+        clearBarriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        clearBarriers[1].UAV.pResource = m_luminanceMomentsTexture.Get();
+        clearBarriers[2].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        clearBarriers[2].UAV.pResource = m_aovAlbedoTexture.Get();
+        clearBarriers[3].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        clearBarriers[3].UAV.pResource = m_aovNormalTexture.Get();
+        cmdList->ResourceBarrier(_countof(clearBarriers), clearBarriers);
+    }
+
+    void Renderer::RecordActivePixelReadback(ID3D12GraphicsCommandList4* cmdList, UINT slot) {
+        D3D12_RESOURCE_BARRIER toCopySource = CD3DX12_RESOURCE_BARRIER::Transition(
+            m_activePixelCounter.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        cmdList->ResourceBarrier(1, &toCopySource);
+        cmdList->CopyBufferRegion(m_activePixelReadback.Get(), slot * sizeof(uint32_t), m_activePixelCounter.Get(), 0, sizeof(uint32_t));
+
+        // Reset for the next batch
+        D3D12_RESOURCE_BARRIER toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(
+            m_activePixelCounter.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+        cmdList->ResourceBarrier(1, &toCopyDest);
+        D3D12_WRITEBUFFERIMMEDIATE_PARAMETER zero = { m_activePixelCounter->GetGPUVirtualAddress(), 0 };
+        cmdList->WriteBufferImmediate(1, &zero, nullptr);
+
+        D3D12_RESOURCE_BARRIER toUav = CD3DX12_RESOURCE_BARRIER::Transition(
+            m_activePixelCounter.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        cmdList->ResourceBarrier(1, &toUav);
+    }
+
+    uint32_t Renderer::ReadActivePixelCount(UINT slot) {
+        void* data = nullptr;
+        CD3DX12_RANGE readRange(slot * sizeof(uint32_t), (slot + 1) * sizeof(uint32_t));
+        if (FAILED(m_activePixelReadback->Map(0, &readRange, &data))) {
+            return UINT32_MAX;  // Treated as "still active"
+        }
+        uint32_t count = static_cast<const uint32_t*>(data)[slot];
+        CD3DX12_RANGE writeRange(0, 0);
+        m_activePixelReadback->Unmap(0, &writeRange);
+        return count;
+    }
+
+    void Renderer::WaitForOfflineFence(UINT64 fenceValue) {
+        if (!m_offlineFence || m_offlineFence->GetCompletedValue() >= fenceValue) {
+            return;
+        }
+        ThrowIfFailed(m_offlineFence->SetEventOnCompletion(fenceValue, m_offlineFenceEvent), "Failed to set offline fence event");
+        WaitForSingleObject(m_offlineFenceEvent, INFINITE);
+    }
+
+    void Renderer::BindRaytracingRootArguments(ID3D12GraphicsCommandList4* cmdList) {
+        // Set pipeline state
+        cmdList->SetPipelineState1(m_dxrStateObject.Get());
+        cmdList->SetComputeRootSignature(m_raytracingGlobalRootSignature.Get());
+
+        // Set heaps
+        ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
+        cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+        const D3D12_GPU_DESCRIPTOR_HANDLE heapStart = m_srvUavHeap->GetGPUDescriptorHandleForHeapStart();
+
+        // Root parameter 0: UAV table (output texture at index 0)
+        D3D12_GPU_DESCRIPTOR_HANDLE uavHandle = heapStart;
+        uavHandle.ptr += m_uavIndex_Output * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(0, uavHandle);
+
+        // Root parameter 1: TLAS (direct SRV, not a table)
+        cmdList->SetComputeRootShaderResourceView(1, m_topLevelAS->GetGPUVirtualAddress());
+
+        // Root parameter 2: Vertex streams table (positions at index 1, attributes at index 26)
+        D3D12_GPU_DESCRIPTOR_HANDLE verticesHandle = heapStart;
+        verticesHandle.ptr += m_srvIndex_Vertices * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(2, verticesHandle);
+
+        // Root parameter 3: Indices SRV table (index 2)
+        D3D12_GPU_DESCRIPTOR_HANDLE indicesHandle = heapStart;
+        indicesHandle.ptr += m_srvIndex_Indices * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(3, indicesHandle);
+
+        // Root parameter 4: Material id table (per-face buffer at index 3, per-instance table at index 27)
+        D3D12_GPU_DESCRIPTOR_HANDLE triMatHandle = heapStart;
+        triMatHandle.ptr += m_srvIndex_TriangleMaterials * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(4, triMatHandle);
+
+        // Root parameter 5: Materials SRV (direct root descriptor)
+        cmdList->SetComputeRootShaderResourceView(5, m_materialBuffer->GetGPUVirtualAddress());
+
+        // Scene textures: no root parameter, materials index their SRVs (slots m_srvIndex_Textures+) in the heap
+
+        // Root parameter 6: Environment map SRV table (t4, bind to descriptor slot 6)
+        D3D12_GPU_DESCRIPTOR_HANDLE envMapHandle = heapStart;
+        envMapHandle.ptr += 6 * m_srvUavDescriptorSize; // slot 6 for environment map
+        cmdList->SetComputeRootDescriptorTable(6, envMapHandle);
+
+        if (m_useVirtualTextures) {
+            // Root parameter 7: Virtual Texture Cache SRV table (t5, bind to descriptor slot 7)
+            D3D12_GPU_DESCRIPTOR_HANDLE vtCacheHandle = heapStart;
+            vtCacheHandle.ptr += 7 * m_srvUavDescriptorSize; // slot 7 for virtual texture cache
+            cmdList->SetComputeRootDescriptorTable(7, vtCacheHandle);
+
+            // Root parameter 8: VT table (indirection, texture info, feedback UAV in slots 10-12)
+            D3D12_GPU_DESCRIPTOR_HANDLE indirectionHandle = heapStart;
+            indirectionHandle.ptr += 10 * m_srvUavDescriptorSize;
+            cmdList->SetComputeRootDescriptorTable(8, indirectionHandle);
+        }
+
+        // Root parameter 9: Material Layers SRV table (bind to descriptor slot 8)
+        D3D12_GPU_DESCRIPTOR_HANDLE layersHandle = heapStart;
+        layersHandle.ptr += m_srvIndex_MaterialLayers * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(9, layersHandle);
+
+        // Root parameter 11: Adaptive sampling table (u2 moments, u3 active pixel count in slots 13-14)
+        D3D12_GPU_DESCRIPTOR_HANDLE adaptiveHandle = heapStart;
+        adaptiveHandle.ptr += m_uavIndex_Moments * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(11, adaptiveHandle);
+
+        // Root parameter 12: Denoiser guide AOVs (u4 albedo, u5 normal in slots 17-18)
+        D3D12_GPU_DESCRIPTOR_HANDLE aovHandle = heapStart;
+        aovHandle.ptr += m_uavIndex_AovAlbedo * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(12, aovHandle);
+
+        // Root parameter 13: Emissive light list (t10, direct root descriptor)
+        cmdList->SetComputeRootShaderResourceView(13, m_lightBuffer->GetGPUVirtualAddress());
+
+        if (m_envImportanceSampling) {
+            // Root parameter 14: Environment CDFs (t11 conditional, t12 marginal in slots 22-23)
+            D3D12_GPU_DESCRIPTOR_HANDLE envCdfHandle = heapStart;
+            envCdfHandle.ptr += m_srvIndex_EnvCdf * m_srvUavDescriptorSize;
+            cmdList->SetComputeRootDescriptorTable(14, envCdfHandle);
+        }
+
+        // Root parameter 15: Alpha masks (t13 bits, t14 per-material info in slots 24-25), sampler tables (t17, slot 28)
+        D3D12_GPU_DESCRIPTOR_HANDLE alphaMaskHandle = heapStart;
+        alphaMaskHandle.ptr += m_srvIndex_AlphaMasks * m_srvUavDescriptorSize;
+        cmdList->SetComputeRootDescriptorTable(15, alphaMaskHandle);
+    }
+
+    Renderer::CameraConstants Renderer::BuildCameraConstants(UINT width, UINT height, int maxBounces) const {
+        // Compute camera matrices
+        glm::vec3 pos = m_camera.GetPosition();
+        glm::vec3 dir = m_camera.GetDirection();
+        glm::vec3 right = m_camera.GetRight();
+        glm::vec3 up = m_camera.GetUp();
+        
+        // Build camera-to-world matrix (view inverse)
+        // GLM matrices are COLUMN-MAJOR, so mat[i] is the i-th COLUMN
+        glm::mat4 cameraToWorld = glm::mat4(1.0f);
+        cameraToWorld[0] = glm::vec4(right, 0.0f);      // X axis (column 0)
+        cameraToWorld[1] = glm::vec4(up, 0.0f);         // Y axis (column 1)
+        cameraToWorld[2] = glm::vec4(-dir, 0.0f);       // Z axis (column 2) - camera looks along -Z
+        cameraToWorld[3] = glm::vec4(pos, 1.0f);        // Translation (column 3)
+        
+        // Transpose for row-major HLSL (DirectX uses row-major by default)
+        cameraToWorld = glm::transpose(cameraToWorld);
+        
+        CameraConstants cameraConstants;
+        cameraConstants.viewInverse = cameraToWorld;
+        cameraConstants.tileOffset = glm::uvec2(0, 0);
+        cameraConstants.imageSize = glm::uvec2(width, height);
+        cameraConstants.frameIndex = 0;
+        cameraConstants.maxBounces = static_cast<uint32_t>(maxBounces);
+        cameraConstants.environmentLightIntensity = m_environmentLightIntensity;
+        cameraConstants.useVirtualTextures = m_useVirtualTextures ? 1u : 0u;
+        cameraConstants.cameraParams = glm::vec4(
+            m_camera.GetFOV(),
+            static_cast<float>(width) / static_cast<float>(height),
+            m_camera.GetAperture(),
+            m_camera.GetFocusDistance()
+        );
+        cameraConstants.sunDirIntensity = glm::vec4(m_sunDirection, m_sunIntensity);
+        cameraConstants.sunColorEnabled = glm::vec4(m_sunColor, 1.0f);  // Always 1.0, controlled by intensity
+        cameraConstants.samplesPerDispatch = static_cast<uint32_t>(m_samplesPerDispatch);
+        cameraConstants.adaptiveThreshold = m_adaptiveThreshold;
+        cameraConstants.adaptiveMinSamples = static_cast<uint32_t>(m_adaptiveMinSamples);
+        // Zero total power (e.g. degenerate emitters) disables light sampling, BSDF hits still find them
+        cameraConstants.lightCount = m_lightTotalPower > 0.0f ? m_lightCount : 0u;
+        cameraConstants.lightTotalPower = m_lightTotalPower;
+        cameraConstants.environmentSampling = m_envImportanceSampling && m_environmentLightIntensity > 0.0f ? 1u : 0u;
+        cameraConstants.russianRouletteDepth = static_cast<uint32_t>(m_russianRouletteDepth);
+        cameraConstants.samplerType = static_cast<uint32_t>(m_samplerType);
+        return cameraConstants;
+    }
+
+    D3D12_DISPATCH_RAYS_DESC Renderer::GetDispatchRaysDesc() const {
+        D3D12_DISPATCH_RAYS_DESC dispatchDesc = {};
+        dispatchDesc.RayGenerationShaderRecord.StartAddress = m_sbtBuffer->GetGPUVirtualAddress() + m_sbtRayGenOffset;
+        dispatchDesc.RayGenerationShaderRecord.SizeInBytes = m_sbtEntrySize;
+        dispatchDesc.MissShaderTable.StartAddress = m_sbtBuffer->GetGPUVirtualAddress() + m_sbtMissOffset;
+        dispatchDesc.MissShaderTable.SizeInBytes = m_sbtEntrySize * SBT_MISS_SHADER_COUNT; // Radiance and shadow miss
+        dispatchDesc.MissShaderTable.StrideInBytes = m_sbtEntrySize;
+        dispatchDesc.HitGroupTable.StartAddress = m_sbtBuffer->GetGPUVirtualAddress() + m_sbtHitGroupOffset;
+        dispatchDesc.HitGroupTable.SizeInBytes = m_sbtHitGroupStride * m_sbtHitGroupCount; // Radiance + shadow record per BLAS
+        dispatchDesc.HitGroupTable.StrideInBytes = m_sbtHitGroupStride;
+        dispatchDesc.Depth = 1;
+        return dispatchDesc;
+    }
+
     void Renderer::MoveToNextFrame() {
         const UINT64 currentFenceValue = m_fenceValue;
         ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), currentFenceValue), "Failed to signal fence in MoveToNextFrame");
@@ -2672,6 +5305,8 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
     }
 
     void Renderer::SetEnvironmentMap(const std::string& path) {
+        std::lock_guard<std::mutex> sceneLock(m_sceneMutex);
+        m_previewResetRequested = true;
         std::cout << "Loading environment map from: " << path << std::endl;
         
         // Load HDR/EXR texture
@@ -2717,9 +5352,15 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         // Now it's safe to let envMapUploadBuffer be destroyed
         
         std::cout << "Environment map loaded successfully" << std::endl;
+
+        for (auto& peer : m_peers) {
+            peer->SetEnvironmentMap(path);
+        }
     }
 
     void Renderer::ClearEnvironmentMap() {
+        std::lock_guard<std::mutex> sceneLock(m_sceneMutex);
+        m_previewResetRequested = true;
         std::cout << "Clearing environment map" << std::endl;
         
         // Wait for GPU to finish using the resource
@@ -2727,8 +5368,15 @@ void ACG::Renderer::SetSunIntensity(float intensity) {
         
         // Release the environment map resource
         m_environmentMap.Reset();
+        m_envConditionalCdf.Reset();
+        m_envMarginalCdf.Reset();
+        m_envImportanceSampling = false;
         
         std::cout << "Environment map cleared" << std::endl;
+
+        for (auto& peer : m_peers) {
+            peer->ClearEnvironmentMap();
+        }
     }
 
 } // namespace ACG
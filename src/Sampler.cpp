@@ -1,5 +1,8 @@
 #include "Sampler.h"
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ACG {
 
@@ -251,6 +254,159 @@ glm::vec3 GGX_Sample(float u1, float u2, float roughness) {
     );
 }
 
+void BuildAliasTable(const std::vector<float>& weights, std::vector<float>& probabilities,
+                     std::vector<uint32_t>& aliases, std::vector<float>& pmf) {
+    const size_t n = weights.size();
+    probabilities.assign(n, 1.0f);
+    aliases.resize(n);
+    pmf.assign(n, n > 0 ? 1.0f / static_cast<float>(n) : 0.0f);
+    for (size_t i = 0; i < n; ++i) {
+        aliases[i] = static_cast<uint32_t>(i);
+    }
+
+    double total = 0.0;
+    for (float w : weights) {
+        total += std::max(w, 0.0f);
+    }
+    if (n == 0 || total <= 0.0) {
+        return;
+    }
+
+    // Scaled probabilities average 1; entries below donate their remainder to an alias above
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i) {
+        pmf[i] = static_cast<float>(std::max(weights[i], 0.0f) / total);
+        scaled[i] = std::max(weights[i], 0.0f) / total * static_cast<double>(n);
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+        uint32_t s = small.back(); small.pop_back();
+        uint32_t l = large.back(); large.pop_back();
+        probabilities[s] = static_cast<float>(scaled[s]);
+        aliases[s] = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        (scaled[l] < 1.0 ? small : large).push_back(l);
+    }
+    // Leftovers are 1 up to rounding
+    for (uint32_t i : small) probabilities[i] = 1.0f;
+    for (uint32_t i : large) probabilities[i] = 1.0f;
+}
+
+void BuildSobolMatrices(std::vector<uint32_t>& matrices) {
+    // Primitive polynomial degree, coefficients and initial direction numbers of dimensions 1..3
+    struct DirectionNumbers { uint32_t degree; uint32_t coefficients; uint32_t initial[3]; };
+    static const DirectionNumbers kDirections[SOBOL_DIMENSIONS - 1] = {
+        { 1, 0, { 1, 0, 0 } },
+        { 2, 1, { 1, 3, 0 } },
+        { 3, 1, { 1, 3, 1 } },
+    };
+    
+    matrices.assign(SOBOL_DIMENSIONS * 32, 0);
+    for (uint32_t bit = 0; bit < 32; ++bit) {
+        matrices[bit] = 1u << (31 - bit);
+    }
+    for (uint32_t d = 1; d < SOBOL_DIMENSIONS; ++d) {
+        const DirectionNumbers& dn = kDirections[d - 1];
+        uint32_t* v = &matrices[d * 32];
+        for (uint32_t bit = 0; bit < 32; ++bit) {
+            if (bit < dn.degree) {
+                v[bit] = dn.initial[bit] << (31 - bit);
+                continue;
+            }
+            v[bit] = v[bit - dn.degree] ^ (v[bit - dn.degree] >> dn.degree);
+            for (uint32_t k = 1; k < dn.degree; ++k) {
+                if ((dn.coefficients >> (dn.degree - 1 - k)) & 1u) {
+                    v[bit] ^= v[bit - k];
+                }
+            }
+        }
+    }
+}
+
+void BuildBlueNoiseRanks(uint32_t size, std::vector<uint32_t>& ranks) {
+    const uint32_t count = size * size;
+    ranks.assign(count, 0);
+    if (count == 0) {
+        return;
+    }
+    
+    // Gaussian energy of a point at toroidal offset (x, y), sigma 1.5 as in the paper
+    std::vector<float> kernel(count);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            float dx = static_cast<float>(std::min(x, size - x));
+            float dy = static_cast<float>(std::min(y, size - y));
+            kernel[y * size + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * 1.5f * 1.5f));
+        }
+    }
+    auto splat = [&](std::vector<float>& energy, uint32_t pixel, float sign) {
+        uint32_t px = pixel % size, py = pixel / size;
+        for (uint32_t y = 0; y < size; ++y) {
+            const float* row = &kernel[((y + size - py) % size) * size];
+            for (uint32_t x = 0; x < size; ++x) {
+                energy[y * size + x] += sign * row[(x + size - px) % size];
+            }
+        }
+    };
+    // Tightest cluster: the set pixel with the most energy; largest void: the empty pixel with the least
+    auto find = [&](const std::vector<uint8_t>& pattern, const std::vector<float>& energy, bool tightestCluster) {
+        uint32_t best = 0;
+        float bestEnergy = tightestCluster ? -1.0f : std::numeric_limits<float>::max();
+        for (uint32_t i = 0; i < count; ++i) {
+            if ((pattern[i] != 0) == tightestCluster &&
+                (tightestCluster ? energy[i] > bestEnergy : energy[i] < bestEnergy)) {
+                best = i;
+                bestEnergy = energy[i];
+            }
+        }
+        return best;
+    };
+    
+    // Initial binary pattern: 10% random points, relaxed by moving the tightest cluster into the largest void
+    std::vector<uint8_t> pattern(count, 0);
+    std::vector<float> energy(count, 0.0f);
+    std::mt19937 rng(0x5EED1234u);
+    const uint32_t initialCount = std::max(count / 10, 1u);
+    for (uint32_t placed = 0; placed < initialCount;) {
+        uint32_t pixel = rng() % count;
+        if (!pattern[pixel]) {
+            pattern[pixel] = 1;
+            splat(energy, pixel, 1.0f);
+            ++placed;
+        }
+    }
+    for (uint32_t iteration = 0; iteration < count; ++iteration) {
+        uint32_t cluster = find(pattern, energy, true);
+        pattern[cluster] = 0;
+        splat(energy, cluster, -1.0f);
+        uint32_t voidPixel = find(pattern, energy, false);
+        pattern[voidPixel] = 1;
+        splat(energy, voidPixel, 1.0f);
+        if (voidPixel == cluster) {
+            break;
+        }
+    }
+    
+    // Ranks of the initial points: removed from a copy tightest cluster first, so the lowest ranks stay spread out
+    std::vector<uint8_t> trial = pattern;
+    std::vector<float> trialEnergy = energy;
+    for (uint32_t rank = initialCount; rank-- > 0;) {
+        uint32_t cluster = find(trial, trialEnergy, true);
+        trial[cluster] = 0;
+        splat(trialEnergy, cluster, -1.0f);
+        ranks[cluster] = rank;
+    }
+    // Remaining ranks fill the largest void. With a Gaussian kernel the tightest cluster of empty pixels
+    // (the paper's third phase) is the same pixel, so one loop covers both halves
+    for (uint32_t rank = initialCount; rank < count; ++rank) {
+        uint32_t voidPixel = find(pattern, energy, false);
+        pattern[voidPixel] = 1;
+        splat(energy, voidPixel, 1.0f);
+        ranks[voidPixel] = rank;
+    }
+}
+
 } // namespace SamplingUtils
 
 } // namespace ACG
@@ -1,9 +1,14 @@
 #include "Scene.h"
 #include "SceneLoader.h"
+#include "ObjLoader.h"
 #include "Texture.h"
+#include "ScopedTimer.h"
+#include "ShaderCache.h"
+#include <cstdio>
 #include <iostream>
 #include <limits>
 #include <filesystem>
+#include <fstream>
 #include <set>
 
 #ifdef _WIN32
@@ -35,6 +40,46 @@ void Scene::AddLight(std::shared_ptr<Light> light) {
     m_lights.push_back(light);
 }
 
+void Scene::AddInstance(uint32_t meshIndex, const glm::mat4& transform) {
+    MeshInstance instance;
+    instance.meshIndex = meshIndex;
+    instance.transform = transform;
+    m_instances.push_back(instance);
+}
+
+void Scene::SetInstanceTransform(size_t instanceIndex, const glm::mat4& transform) {
+    if (instanceIndex >= m_instances.size()) {
+        return;
+    }
+    m_instances[instanceIndex].transform = transform;
+    m_instanceTransformsDirty = true;
+}
+
+uint64_t Scene::ComputeFileHash(const std::string& filename) {
+    // 0 = unreadable, never matches a resident scene
+    uint64_t hash = 0;
+    return ShaderCache::HashFile(filename, hash) ? hash : 0;
+}
+
+uint64_t Scene::ComputeFileStamp(const std::vector<std::string>& files) {
+    uint64_t stamp = ShaderCache::HASH_SEED;
+    for (const auto& file : files) {
+        stamp = ShaderCache::Hash(file.data(), file.size(), stamp);
+        std::error_code error;
+        const uint64_t size = std::filesystem::file_size(file, error);
+        if (error) {
+            continue;
+        }
+        const int64_t time = static_cast<int64_t>(std::filesystem::last_write_time(file, error).time_since_epoch().count());
+        if (error) {
+            continue;
+        }
+        stamp = ShaderCache::Hash(&size, sizeof(size), stamp);
+        stamp = ShaderCache::Hash(&time, sizeof(time), stamp);
+    }
+    return stamp;
+}
+
 bool Scene::LoadFromFile(const std::string& filename) {
     SceneLoadConfig config;
     return LoadFromFileEx(filename, config);
@@ -46,14 +91,18 @@ bool Scene::LoadFromFileEx(const std::string& filename, const SceneLoadConfig& c
     std::cout << "File: " << filename << std::endl;
     std::cout << "============================================" << std::endl;
     
+    m_loadTimings = LoadTimings();
+    ScopedTimer totalTimer(m_loadTimings.totalMs);
+    
     // Extract scene name from filename
     std::filesystem::path filePath(filename);
     m_name = filePath.stem().string();
     
     std::string loadPath = filename;
     
-    // 如果不是ACG文件，需要先转换为ACG
-    if (filePath.extension() != ".acg") {
+    // OBJ由进程内导入器直接解析; 其他格式(如.blend)仍需Python转换为ACG
+    const bool nativeImport = ObjLoader::CanLoad(filename);
+    if (!nativeImport && filePath.extension() != ".acg") {
         std::cout << "Converting model file to binary format..." << std::endl;
         std::cout << "Input format: " << filePath.extension().string() << std::endl;
         
@@ -70,89 +119,132 @@ bool Scene::LoadFromFileEx(const std::string& filename, const SceneLoadConfig& c
         // 生成临时ACG文件路径（使用bin/tmp目录）
         std::filesystem::path tempDir = exePath / "tmp";
         std::filesystem::create_directories(tempDir);
-        std::filesystem::path tempPath = tempDir / (filePath.stem().string() + ".acg");
-        
-        // 构建Python命令（使用虚拟环境中的Python）
-        std::filesystem::path loaderScript = exePath / "loader" / "main.py";
         std::filesystem::path absoluteObjPath = std::filesystem::absolute(filePath);
         
-        // 检查loader脚本是否存在
-        if (!std::filesystem::exists(loaderScript)) {
-            std::cerr << "ERROR: Loader script not found: " << loaderScript << std::endl;
-            std::cerr << "Please ensure loader directory exists in bin/" << std::endl;
-            return false;
-        }
+        // 缓存文件名带上源路径哈希, 避免不同目录下同名模型互相覆盖
+        char pathHash[17];
+        snprintf(pathHash, sizeof(pathHash), "%016llx",
+                 static_cast<unsigned long long>(std::hash<std::string>{}(absoluteObjPath.lexically_normal().string())));
+        std::filesystem::path tempPath = tempDir / (filePath.stem().string() + "_" + pathHash + ".acg");
+        std::filesystem::path partialPath = tempDir / (filePath.stem().string() + "_" + pathHash + ".partial.acg");
         
-        // 使用虚拟环境中的Python
-        std::filesystem::path venvPython = exePath / "loader" / ".venv" / "Scripts" / "python.exe";
-        std::string pythonExe;
+        // 转换结果比源文件新时直接复用
+        std::error_code cacheError;
+        auto sourceTime = std::filesystem::last_write_time(absoluteObjPath, cacheError);
+        bool cacheValid = !cacheError && std::filesystem::exists(tempPath) &&
+                          std::filesystem::last_write_time(tempPath, cacheError) >= sourceTime && !cacheError;
         
-        if (std::filesystem::exists(venvPython)) {
-            pythonExe = "\"" + venvPython.string() + "\"";
-            std::cout << "Using virtual environment Python: " << venvPython << std::endl;
+        if (cacheValid) {
+            std::cout << "Using cached conversion: " << tempPath << std::endl;
         } else {
-            pythonExe = "python";
-            std::cout << "WARNING: Virtual environment not found, using system Python" << std::endl;
-            std::cout << "Expected path: " << venvPython << std::endl;
-        }
+            ScopedTimer conversionTimer(m_loadTimings.conversionMs);
+            
+            // 构建Python命令（使用虚拟环境中的Python）
+            std::filesystem::path loaderScript = exePath / "loader" / "main.py";
+        
+            // 检查loader脚本是否存在
+            if (!std::filesystem::exists(loaderScript)) {
+                std::cerr << "ERROR: Loader script not found: " << loaderScript << std::endl;
+                std::cerr << "Please ensure loader directory exists in bin/" << std::endl;
+                return false;
+            }
         
-        std::string pythonCmd = pythonExe + " \"" + loaderScript.string() + "\" \"" + 
-                               absoluteObjPath.string() + "\" \"" + 
-                               tempPath.string() + "\" --binary";
+            // 使用虚拟环境中的Python
+            std::filesystem::path venvPython = exePath / "loader" / ".venv" / "Scripts" / "python.exe";
+            std::string pythonExe;
         
-        std::cout << "Running converter..." << std::endl;
-        std::cout << "Command: " << pythonCmd << std::endl;
-        std::cout << "Output file: " << tempPath << std::endl;
+            if (std::filesystem::exists(venvPython)) {
+                pythonExe = "\"" + venvPython.string() + "\"";
+                std::cout << "Using virtual environment Python: " << venvPython << std::endl;
+            } else {
+                pythonExe = "python";
+                std::cout << "WARNING: Virtual environment not found, using system Python" << std::endl;
+                std::cout << "Expected path: " << venvPython << std::endl;
+            }
+        
+            std::string pythonCmd = pythonExe + " \"" + loaderScript.string() + "\" \"" + 
+                                   absoluteObjPath.string() + "\" \"" + 
+                                   partialPath.string() + "\" --binary";
+        
+            std::cout << "Running converter..." << std::endl;
+            std::cout << "Command: " << pythonCmd << std::endl;
+            std::cout << "Output file: " << partialPath << std::endl;
         
 #ifdef _WIN32
-        // Windows: 重定向输出以捕获错误信息
-        std::string cmdWithRedirect = "cmd /c \"" + pythonCmd + " 2>&1\"";
+            // Windows: 重定向输出以捕获错误信息
+            std::string cmdWithRedirect = "cmd /c \"" + pythonCmd + " 2>&1\"";
         
-        FILE* pipe = _popen(cmdWithRedirect.c_str(), "r");
-        if (!pipe) {
-            std::cerr << "ERROR: Failed to start Python converter" << std::endl;
-            return false;
-        }
+            FILE* pipe = _popen(cmdWithRedirect.c_str(), "r");
+            if (!pipe) {
+                std::cerr << "ERROR: Failed to start Python converter" << std::endl;
+                return false;
+            }
         
-        char outputBuffer[256];
-        std::string output;
-        while (fgets(outputBuffer, sizeof(outputBuffer), pipe) != nullptr) {
-            output += outputBuffer;
-            std::cout << outputBuffer;  // 实时输出
-        }
+            char outputBuffer[256];
+            std::string output;
+            while (fgets(outputBuffer, sizeof(outputBuffer), pipe) != nullptr) {
+                output += outputBuffer;
+                std::cout << outputBuffer;  // 实时输出
+            }
         
-        int exitCode = _pclose(pipe);
+            int exitCode = _pclose(pipe);
         
-        if (exitCode != 0) {
-            std::cerr << "ERROR: Python converter failed with code " << exitCode << std::endl;
-            std::cerr << "Output: " << output << std::endl;
-            return false;
-        }
+            if (exitCode != 0) {
+                std::cerr << "ERROR: Python converter failed with code " << exitCode << std::endl;
+                std::cerr << "Output: " << output << std::endl;
+                return false;
+            }
 #else
-        int result = system(pythonCmd.c_str());
-        if (result != 0) {
-            std::cerr << "ERROR: Failed to convert OBJ to binary format" << std::endl;
-            return false;
-        }
+            int result = system(pythonCmd.c_str());
+            if (result != 0) {
+                std::cerr << "ERROR: Failed to convert model to binary format" << std::endl;
+                return false;
+            }
 #endif
         
-        if (!std::filesystem::exists(tempPath)) {
-            std::cerr << "ERROR: Converted file not found: " << tempPath << std::endl;
-            return false;
+            if (!std::filesystem::exists(partialPath)) {
+                std::cerr << "ERROR: Converted file not found: " << partialPath << std::endl;
+                return false;
+            }
+        
+            // 转换成功后再替换缓存, 中途失败不会留下看似有效的缓存文件
+            std::error_code renameError;
+            std::filesystem::rename(partialPath, tempPath, renameError);
+            if (renameError) {
+                std::cerr << "ERROR: Failed to store converted file: " << renameError.message() << std::endl;
+                return false;
+            }
+            std::cout << "Conversion complete: " << tempPath << std::endl;
         }
         
         loadPath = tempPath.string();
-        std::cout << "Conversion complete: " << loadPath << std::endl;
     }
     
     try {
-        // Load scene from binary file
-        auto loadedScene = SceneLoader::Load(loadPath);
+        // Load scene from binary file (or parse OBJ in-process)
+        std::unique_ptr<Scene> loadedScene;
+        double importMs = 0.0;
+        {
+            ScopedTimer importTimer(importMs);
+            loadedScene = nativeImport ? ObjLoader::Load(filename) : SceneLoader::Load(loadPath);
+        }
+        
+        // Phase timings recorded by the loader; conversion and the running total belong to this scene
+        const LoadTimings& loaderTimings = loadedScene->GetLoadTimings();
+        m_loadTimings.importMs = importMs;
+        m_loadTimings.materialsMs = loaderTimings.materialsMs;
+        m_loadTimings.texturesMs = loaderTimings.texturesMs;
+        m_loadTimings.geometryMs = loaderTimings.geometryMs;
         
         // Transfer data from loaded scene to this scene
         m_meshes = loadedScene->GetMeshes();
         m_materials = loadedScene->GetMaterials();
         m_lights = loadedScene->GetLights();
+        m_instances = loadedScene->GetInstances();
+        m_sourceFiles = loadedScene->GetSourceFiles();
+        if (const PackedGeometry* packed = loadedScene->GetPackedGeometry()) {
+            m_packedGeometry = *packed;
+        }
         
         // Post-processing
         ComputeBoundingBox();
@@ -170,6 +262,9 @@ bool Scene::LoadFromFileEx(const std::string& filename, const SceneLoadConfig& c
         std::cout << "  Textures: " << stats.totalTextures << std::endl;
         std::cout << "  Material Layers: " << stats.totalMaterialLayers << std::endl;
         std::cout << "  Memory: " << stats.estimatedMemoryMB << " MB" << std::endl;
+        std::cout << "  Import: " << static_cast<int>(m_loadTimings.importMs) << " ms (materials "
+                  << static_cast<int>(m_loadTimings.materialsMs) << ", textures " << static_cast<int>(m_loadTimings.texturesMs)
+                  << ", geometry " << static_cast<int>(m_loadTimings.geometryMs) << " ms)" << std::endl;
         std::cout << "  Bounding Box: [" << m_bboxMin.x << ", " << m_bboxMin.y << ", " << m_bboxMin.z 
                   << "] to [" << m_bboxMax.x << ", " << m_bboxMax.y << ", " << m_bboxMax.z << "]" << std::endl;
         std::cout << "============================================" << std::endl;
@@ -187,6 +282,12 @@ void Scene::ComputeBoundingBox() {
     m_bboxMax = glm::vec3(std::numeric_limits<float>::lowest());
     
     for (auto& mesh : m_meshes) {
+        if (mesh->HasPackedRange()) {
+            // Packed meshes carry their bounds from the file
+            m_bboxMin = glm::min(m_bboxMin, mesh->GetBBoxMin());
+            m_bboxMax = glm::max(m_bboxMax, mesh->GetBBoxMax());
+            continue;
+        }
         const auto& verts = mesh->GetVertices();
         for (const auto& v : verts) {
             m_bboxMin = glm::min(m_bboxMin, v.position);
@@ -205,8 +306,8 @@ void Scene::EstimateMemoryUsage() {
     size_t indexMemory = 0;
     
     for (const auto& mesh : m_meshes) {
-        int numVerts = static_cast<int>(mesh->GetVertices().size());
-        int numIndices = static_cast<int>(mesh->GetIndices().size());
+        int numVerts = static_cast<int>(mesh->GetVertexCount());
+        int numIndices = static_cast<int>(mesh->GetIndexCount());
         
         m_loadStats.totalVertices += numVerts;
         m_loadStats.totalTriangles += numIndices / 3;
@@ -0,0 +1,224 @@
+#include "ShaderCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <set>
+
+namespace ACG {
+
+namespace {
+
+const uint32_t CACHE_VERSION = 1;  // 文件布局变化时递增, 使旧缓存失效
+
+struct CacheHeader {
+    char magic[4];      // "ACGS"
+    uint32_t version;
+    uint64_t key;
+    uint64_t dataSize;
+};
+
+std::mutex g_cacheDirectoryMutex;
+std::string g_cacheDirectory = "shadercache";
+
+bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    data.resize(static_cast<size_t>(size));
+    return size == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), size));
+}
+
+std::filesystem::path GetShaderEntryPath(const std::string& directory, uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.dxil", static_cast<unsigned long long>(key));
+    return std::filesystem::path(directory) / name;
+}
+
+// Quoted or angled path of an #include line, empty if the line is not one
+std::string ParseInclude(const std::string& line) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 1, "#") != 0) {
+        return {};
+    }
+    size_t directive = line.find_first_not_of(" \t", start + 1);
+    if (directive == std::string::npos || line.compare(directive, 7, "include") != 0) {
+        return {};
+    }
+    size_t open = line.find_first_of("\"<", directive + 7);
+    if (open == std::string::npos) {
+        return {};
+    }
+    size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+    return close == std::string::npos ? std::string() : line.substr(open + 1, close - open - 1);
+}
+
+uint64_t HashFileRecursive(const std::filesystem::path& filename, const std::filesystem::path& includeDirectory,
+                           uint64_t hash, std::set<std::filesystem::path>& visited) {
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(filename, error);
+    if (error) {
+        canonical = filename.lexically_normal();
+    }
+    if (!visited.insert(canonical).second) {
+        return hash;  // Include guards: every file counts once
+    }
+
+    std::string name = filename.filename().string();
+    hash = ShaderCache::Hash(name.data(), name.size(), hash);
+    std::vector<uint8_t> contents;
+    if (!ReadFile(filename, contents)) {
+        return hash;
+    }
+    hash = ShaderCache::Hash(contents.data(), contents.size(), hash);
+
+    std::string text(contents.begin(), contents.end());
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = text.size();
+        }
+        std::string include = ParseInclude(text.substr(lineStart, lineEnd - lineStart));
+        if (!include.empty()) {
+            std::filesystem::path local = filename.parent_path() / include;
+            std::filesystem::path resolved = std::filesystem::exists(local, error) ? local : includeDirectory / include;
+            hash = HashFileRecursive(resolved, includeDirectory, hash, visited);
+        }
+        lineStart = lineEnd + 1;
+    }
+    return hash;
+}
+
+} // namespace
+
+void ShaderCache::SetCacheDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(g_cacheDirectoryMutex);
+    g_cacheDirectory = directory;
+}
+
+std::string ShaderCache::GetCacheDirectory() {
+    std::lock_guard<std::mutex> lock(g_cacheDirectoryMutex);
+    return g_cacheDirectory;
+}
+
+uint64_t ShaderCache::Hash(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;  // FNV prime
+    }
+    return hash;
+}
+
+bool ShaderCache::HashFile(const std::filesystem::path& filename, uint64_t& hash, uint64_t seed) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    hash = seed;
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hash = Hash(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+    return true;
+}
+
+// 先写临时文件再重命名, 中断的写入不会留下损坏的缓存项
+bool ShaderCache::WriteFileAtomically(const std::filesystem::path& path, const void* header, size_t headerSize,
+                                      const void* data, size_t size) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error) {
+        return false;
+    }
+    std::filesystem::path partialPath = path;
+    partialPath += ".partial";
+    {
+        std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        if (header) {
+            file.write(static_cast<const char*>(header), static_cast<std::streamsize>(headerSize));
+        }
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!file) {
+            file.close();
+            std::filesystem::remove(partialPath, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(partialPath, path, error);
+    if (error) {
+        std::filesystem::remove(partialPath, error);
+        return false;
+    }
+    return true;
+}
+
+uint64_t ShaderCache::HashSourceTree(const std::filesystem::path& filename, const std::filesystem::path& includeDirectory,
+                                     uint64_t seed) {
+    std::set<std::filesystem::path> visited;
+    return HashFileRecursive(filename, includeDirectory, seed, visited);
+}
+
+bool ShaderCache::LoadShader(uint64_t key, std::vector<uint8_t>& dxil) {
+    std::string directory = GetCacheDirectory();
+    if (directory.empty()) {
+        return false;
+    }
+
+    std::ifstream file(GetShaderEntryPath(directory, key), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    CacheHeader header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, "ACGS", 4) != 0 || header.version != CACHE_VERSION ||
+        header.key != key || header.dataSize == 0) {
+        return false;
+    }
+
+    dxil.resize(static_cast<size_t>(header.dataSize));
+    if (!file.read(reinterpret_cast<char*>(dxil.data()), static_cast<std::streamsize>(header.dataSize))) {
+        dxil.clear();
+        return false;
+    }
+    return true;
+}
+
+void ShaderCache::StoreShader(uint64_t key, const void* dxil, size_t size) {
+    std::string directory = GetCacheDirectory();
+    if (directory.empty() || !dxil || size == 0) {
+        return;
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, "ACGS", 4);
+    header.version = CACHE_VERSION;
+    header.key = key;
+    header.dataSize = size;
+    WriteFileAtomically(GetShaderEntryPath(directory, key), &header, sizeof(header), dxil, size);
+}
+
+bool ShaderCache::LoadBlob(const std::string& name, std::vector<uint8_t>& data) {
+    std::string directory = GetCacheDirectory();
+    return !directory.empty() && ReadFile(std::filesystem::path(directory) / name, data) && !data.empty();
+}
+
+void ShaderCache::StoreBlob(const std::string& name, const void* data, size_t size) {
+    std::string directory = GetCacheDirectory();
+    if (directory.empty() || !data || size == 0) {
+        return;
+    }
+    WriteFileAtomically(std::filesystem::path(directory) / name, nullptr, 0, data, size);
+}
+
+} // namespace ACG
@@ -1,8 +1,18 @@
 #include "Texture.h"
+#include "Parallel.h"
+#include "Logger.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <filesystem>
+#include <sstream>
+
+// SSE2 is part of x64, so the vector paths need no extra compiler flags
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_USE_SSE2 1
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -13,6 +23,262 @@
 
 namespace ACG {
 
+namespace {
+
+// 纹理可能在工作线程中解码, 每条日志整行写出, 避免与其他线程的输出交错
+template <typename... Args>
+void LogLine(std::ostream& stream, const Args&... args) {
+    std::ostringstream line;
+    (line << ... << args);
+    line << '\n';
+    stream << line.str();
+}
+
+// Mip levels with fewer texels than this are filtered on the calling thread
+constexpr size_t PARALLEL_MIP_TEXELS = 256 * 256;
+constexpr int MIP_ROWS_PER_TASK = 32;
+
+// Kaiser-windowed sinc for 2:1 reduction, taps at source offsets +-0.5 .. +-3.5 around the output texel
+constexpr int KAISER_TAPS = 8;
+constexpr float KAISER_ALPHA = 4.0f;
+
+// func(firstRow, lastRow) over the rows of an output level, split into bands for large levels
+template <typename Func>
+void ForEachRowBand(int width, int height, Func&& func) {
+    if (static_cast<size_t>(width) * height < PARALLEL_MIP_TEXELS) {
+        func(0, height);
+        return;
+    }
+    const int bandCount = (height + MIP_ROWS_PER_TASK - 1) / MIP_ROWS_PER_TASK;
+    ParallelFor(static_cast<size_t>(bandCount), [&](size_t band) {
+        int first = static_cast<int>(band) * MIP_ROWS_PER_TASK;
+        func(first, std::min(first + MIP_ROWS_PER_TASK, height));
+    });
+}
+
+// 2x2 box filter of one output row, rounded to nearest.
+// A source dimension of 1 repeats its texel instead of reading a second one
+void DownsampleRow(const unsigned char* row0, const unsigned char* row1, int srcWidth,
+                   unsigned char* dst, int dstWidth, int channels) {
+    const int right = srcWidth > 1 ? channels : 0;
+    int x = 0;
+#ifdef TEXTURE_USE_SSE2
+    if (channels == 4 && right == 4) {
+        // 4 output texels per iteration from 8 source texels of each row, summed in 16 bits
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(2);
+        for (; x + 4 <= dstWidth; x += 4) {
+            const __m128i* a = reinterpret_cast<const __m128i*>(row0 + x * 8);
+            const __m128i* b = reinterpret_cast<const __m128i*>(row1 + x * 8);
+            __m128i a0 = _mm_loadu_si128(a), a1 = _mm_loadu_si128(a + 1);
+            __m128i b0 = _mm_loadu_si128(b), b1 = _mm_loadu_si128(b + 1);
+            // Vertical sums of texel pairs (0,1) (2,3) (4,5) (6,7)
+            __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+            __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+            __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+            __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+            // Horizontal: the low 4 lanes of s + (s >> 64 bits) hold the texel pair sum
+            __m128i d0 = _mm_add_epi16(s01, _mm_srli_si128(s01, 8));
+            __m128i d1 = _mm_add_epi16(s23, _mm_srli_si128(s23, 8));
+            __m128i d2 = _mm_add_epi16(s45, _mm_srli_si128(s45, 8));
+            __m128i d3 = _mm_add_epi16(s67, _mm_srli_si128(s67, 8));
+            __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(d0, d1), bias), 2);
+            __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(d2, d3), bias), 2);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+    for (; x < dstWidth; ++x) {
+        const unsigned char* a = row0 + x * 2 * channels;
+        const unsigned char* b = row1 + x * 2 * channels;
+        for (int c = 0; c < channels; ++c) {
+            dst[x * channels + c] = static_cast<unsigned char>((a[c] + a[c + right] + b[c] + b[c + right] + 2) >> 2);
+        }
+    }
+}
+
+void DownsampleRow(const float* row0, const float* row1, int srcWidth,
+                   float* dst, int dstWidth, int channels) {
+    const int right = srcWidth > 1 ? channels : 0;
+    int x = 0;
+#ifdef TEXTURE_USE_SSE2
+    if (channels == 4 && right == 4) {
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        for (; x < dstWidth; ++x) {
+            const float* a = row0 + x * 8;
+            const float* b = row1 + x * 8;
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(a + 4)),
+                                    _mm_add_ps(_mm_loadu_ps(b), _mm_loadu_ps(b + 4)));
+            _mm_storeu_ps(dst + x * 4, _mm_mul_ps(sum, quarter));
+        }
+    }
+#endif
+    for (; x < dstWidth; ++x) {
+        const float* a = row0 + x * 2 * channels;
+        const float* b = row1 + x * 2 * channels;
+        for (int c = 0; c < channels; ++c) {
+            dst[x * channels + c] = (a[c] + a[c + right] + b[c] + b[c + right]) * 0.25f;
+        }
+    }
+}
+
+// Appends levels 1.. to a chain holding only level 0, each level the 2x2 box of the previous one
+template <typename Level>
+void BuildBoxChain(std::vector<Level>& levels, int channels, int levelCount) {
+    levels.reserve(levelCount);  // References to the previous level stay valid while appending
+    for (int level = 1; level < levelCount; ++level) {
+        const Level& src = levels[level - 1];
+        Level dst;
+        dst.width = std::max(1, src.width / 2);
+        dst.height = std::max(1, src.height / 2);
+        dst.data.resize(static_cast<size_t>(dst.width) * dst.height * channels);
+        
+        const size_t srcPitch = static_cast<size_t>(src.width) * channels;
+        const size_t dstPitch = static_cast<size_t>(dst.width) * channels;
+        ForEachRowBand(dst.width, dst.height, [&](int firstRow, int lastRow) {
+            for (int y = firstRow; y < lastRow; ++y) {
+                const auto* row0 = src.data.data() + static_cast<size_t>(y) * 2 * srcPitch;
+                const auto* row1 = src.height > 1 ? row0 + srcPitch : row0;
+                DownsampleRow(row0, row1, src.width, dst.data.data() + y * dstPitch, dst.width, channels);
+            }
+        });
+        levels.push_back(std::move(dst));
+    }
+}
+
+float BesselI0(float x) {
+    // Power series, converges quickly for the arguments used by the window
+    float sum = 1.0f;
+    float term = 1.0f;
+    for (int k = 1; k < 16; ++k) {
+        term *= (x * x) / (4.0f * k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+const float* KaiserWeights() {
+    struct Weights {
+        float value[KAISER_TAPS];
+        Weights() {
+            const float pi = 3.14159265358979f;
+            float total = 0.0f;
+            for (int i = 0; i < KAISER_TAPS; ++i) {
+                // Source offset from the output texel center; the 2:1 low-pass cuts off at half the source rate
+                float offset = i - KAISER_TAPS / 2 + 0.5f;
+                float t = 0.5f * offset;
+                float sinc = std::sin(pi * t) / (pi * t);
+                float r = offset / (KAISER_TAPS / 2);
+                value[i] = sinc * BesselI0(KAISER_ALPHA * std::sqrt(1.0f - r * r)) / BesselI0(KAISER_ALPHA);
+                total += value[i];
+            }
+            for (float& w : value) {
+                w /= total;
+            }
+        }
+    };
+    static const Weights weights;
+    return weights.value;
+}
+
+int WrapTexel(int i, int size, TextureWrap wrap) {
+    switch (wrap) {
+        case TextureWrap::Repeat:
+            return ((i % size) + size) % size;
+        case TextureWrap::Mirror: {
+            int period = 2 * size;
+            int m = ((i % period) + period) % period;
+            return m < size ? m : period - 1 - m;
+        }
+        default:
+            return std::clamp(i, 0, size - 1);
+    }
+}
+
+unsigned char StoreTexel(float value, unsigned char) {
+    return static_cast<unsigned char>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+}
+
+float StoreTexel(float value, float) {
+    return std::max(value, 0.0f);  // The sinc lobes may ring below zero
+}
+
+// Separable Kaiser reduction of src into the next level: horizontal pass into a float row buffer,
+// then a vertical pass over whole rows (contiguous multiply-adds the compiler vectorizes)
+template <typename T>
+void KaiserDownsample(const T* src, int srcWidth, int srcHeight, T* dst, int dstWidth, int dstHeight,
+                      int channels, TextureWrap wrap) {
+    const float* weights = KaiserWeights();
+    const size_t srcPitch = static_cast<size_t>(srcWidth) * channels;
+    const size_t dstPitch = static_cast<size_t>(dstWidth) * channels;
+    const bool filterX = srcWidth > 1;
+    const bool filterY = srcHeight > 1;
+    
+    std::vector<float> horizontal(dstPitch * srcHeight);
+    ForEachRowBand(dstWidth, srcHeight, [&](int firstRow, int lastRow) {
+        for (int y = firstRow; y < lastRow; ++y) {
+            const T* srcRow = src + y * srcPitch;
+            float* out = horizontal.data() + y * dstPitch;
+            for (int x = 0; x < dstWidth; ++x) {
+                for (int c = 0; c < channels; ++c) {
+                    float sum = 0.0f;
+                    if (filterX) {
+                        for (int k = 0; k < KAISER_TAPS; ++k) {
+                            int sx = WrapTexel(2 * x + k - KAISER_TAPS / 2 + 1, srcWidth, wrap);
+                            sum += weights[k] * static_cast<float>(srcRow[sx * channels + c]);
+                        }
+                    } else {
+                        sum = static_cast<float>(srcRow[c]);
+                    }
+                    out[x * channels + c] = sum;
+                }
+            }
+        }
+    });
+    
+    ForEachRowBand(dstWidth, dstHeight, [&](int firstRow, int lastRow) {
+        std::vector<float> accum(dstPitch);
+        for (int y = firstRow; y < lastRow; ++y) {
+            if (filterY) {
+                std::fill(accum.begin(), accum.end(), 0.0f);
+                for (int k = 0; k < KAISER_TAPS; ++k) {
+                    const float* row = horizontal.data() + WrapTexel(2 * y + k - KAISER_TAPS / 2 + 1, srcHeight, wrap) * dstPitch;
+                    const float w = weights[k];
+                    for (size_t i = 0; i < dstPitch; ++i) {
+                        accum[i] += w * row[i];
+                    }
+                }
+            } else {
+                std::copy(horizontal.begin(), horizontal.begin() + dstPitch, accum.begin());
+            }
+            T* out = dst + y * dstPitch;
+            for (size_t i = 0; i < dstPitch; ++i) {
+                out[i] = StoreTexel(accum[i], T());
+            }
+        }
+    });
+}
+
+template <typename Level>
+void BuildKaiserChain(std::vector<Level>& levels, int channels, int levelCount, TextureWrap wrap) {
+    levels.reserve(levelCount);
+    for (int level = 1; level < levelCount; ++level) {
+        const Level& src = levels[level - 1];
+        Level dst;
+        dst.width = std::max(1, src.width / 2);
+        dst.height = std::max(1, src.height / 2);
+        dst.data.resize(static_cast<size_t>(dst.width) * dst.height * channels);
+        KaiserDownsample(src.data.data(), src.width, src.height, dst.data.data(), dst.width, dst.height, channels, wrap);
+        levels.push_back(std::move(dst));
+    }
+}
+
+int FullMipCount(int width, int height) {
+    return 1 + static_cast<int>(std::floor(std::log2(std::max(std::max(width, height), 1))));
+}
+
+} // namespace
+
 Texture::Texture()
     : m_width(0)
     , m_height(0)
@@ -28,7 +294,7 @@ Texture::~Texture() {
 }
 
 bool Texture::LoadFromFile(const std::string& filename) {
-    std::cout << "Loading texture: " << filename << std::endl;
+    ACG_LOG_DEBUG("Loading texture: " << filename);
     
     // Check file extension for HDR/EXR
     std::string ext = filename.substr(filename.find_last_of('.') + 1);
@@ -44,31 +310,51 @@ bool Texture::LoadFromFile(const std::string& filename) {
     int width, height, channels;
     unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
     if (!data) {
-        std::cerr << "Failed to load texture: " << filename << std::endl;
-        std::cerr << "stbi_failure_reason: " << stbi_failure_reason() << std::endl;
+        LogLine(std::cerr, "Failed to load texture: ", filename);
+        LogLine(std::cerr, "stbi_failure_reason: ", stbi_failure_reason());
         return false;
     }
     
     Create(width, height, channels, data);
     stbi_image_free(data);
+    m_sourcePath = filename;
     
-    std::cout << "Loaded texture: " << width << "x" << height << " (" << channels << " channels)" << std::endl;
+    ACG_LOG_DEBUG("Loaded texture: " << width << "x" << height << " (" << channels << " channels)");
     return true;
 }
 
+size_t Texture::EstimateDecodedSize(const std::string& filename) {
+    std::string ext = filename.substr(filename.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    
+    if (ext == "exr") {
+        // EXR头部解析依赖tinyexr版本, 按压缩文件大小粗略估算 (解码为RGBA32F)
+        std::error_code error;
+        uintmax_t fileSize = std::filesystem::file_size(filename, error);
+        return error ? 0 : static_cast<size_t>(fileSize) * 4;
+    }
+    
+    int width, height, channels;
+    if (!stbi_info(filename.c_str(), &width, &height, &channels)) {
+        return 0;
+    }
+    size_t bytesPerChannel = (ext == "hdr") ? sizeof(float) : 1;
+    return static_cast<size_t>(width) * height * channels * bytesPerChannel;
+}
+
 bool Texture::LoadHDR(const std::string& filename) {
     int width, height, channels;
     float* data = stbi_loadf(filename.c_str(), &width, &height, &channels, 0);
     if (!data) {
-        std::cerr << "Failed to load HDR texture: " << filename << std::endl;
-        std::cerr << "stbi_failure_reason: " << stbi_failure_reason() << std::endl;
+        LogLine(std::cerr, "Failed to load HDR texture: ", filename);
+        LogLine(std::cerr, "stbi_failure_reason: ", stbi_failure_reason());
         return false;
     }
     
     CreateHDR(width, height, channels, data);
     stbi_image_free(data);
     
-    std::cout << "Loaded HDR texture: " << width << "x" << height << " (" << channels << " channels)" << std::endl;
+    ACG_LOG_DEBUG("Loaded HDR texture: " << width << "x" << height << " (" << channels << " channels)");
     return true;
 }
 
@@ -80,7 +366,7 @@ bool Texture::LoadEXR(const std::string& filename) {
     int ret = ::LoadEXR(&data, &width, &height, filename.c_str(), &err);  // Use global namespace
     if (ret != TINYEXR_SUCCESS) {
         if (err) {
-            std::cerr << "Failed to load EXR texture: " << err << std::endl;
+            LogLine(std::cerr, "Failed to load EXR texture: ", err);
             FreeEXRErrorMessage(err);
         }
         return false;
@@ -90,7 +376,7 @@ bool Texture::LoadEXR(const std::string& filename) {
     CreateHDR(width, height, 4, data);
     free(data);
     
-    std::cout << "Loaded EXR texture: " << width << "x" << height << " (4 channels)" << std::endl;
+    ACG_LOG_DEBUG("Loaded EXR texture: " << width << "x" << height << " (4 channels)");
     return true;
 }
 
@@ -200,55 +486,39 @@ glm::vec4 Texture::SampleTrilinear(float u, float v, float mipLevel) const {
 }
 
 void Texture::GenerateMipmaps() {
-    if (m_mipLevels.empty()) {
-        return;
+    // Rebuilt from level 0, so calling it again never stacks a second chain
+    if (!m_mipLevels.empty()) {
+        m_mipLevels.resize(1);
+        BuildBoxChain(m_mipLevels, m_channels, FullMipCount(m_mipLevels[0].width, m_mipLevels[0].height));
     }
-    
-    int levelCount = 1 + static_cast<int>(std::floor(std::log2(std::max(m_width, m_height))));
-    
-    for (int level = 1; level < levelCount; ++level) {
-        const MipLevel& prevLevel = m_mipLevels[level - 1];
-        int newWidth = std::max(1, prevLevel.width / 2);
-        int newHeight = std::max(1, prevLevel.height / 2);
-        
-        MipLevel newLevel;
-        newLevel.width = newWidth;
-        newLevel.height = newHeight;
-        newLevel.data.resize(newWidth * newHeight * m_channels);
-        
-        // Box filter downsampling
-        for (int y = 0; y < newHeight; ++y) {
-            for (int x = 0; x < newWidth; ++x) {
-                int sx = x * 2;
-                int sy = y * 2;
-                
-                for (int c = 0; c < m_channels; ++c) {
-                    int sum = 0;
-                    int count = 0;
-                    
-                    for (int dy = 0; dy < 2 && (sy + dy) < prevLevel.height; ++dy) {
-                        for (int dx = 0; dx < 2 && (sx + dx) < prevLevel.width; ++dx) {
-                            int srcIdx = ((sy + dy) * prevLevel.width + (sx + dx)) * m_channels + c;
-                            sum += prevLevel.data[srcIdx];
-                            count++;
-                        }
-                    }
-                    
-                    int dstIdx = (y * newWidth + x) * m_channels + c;
-                    newLevel.data[dstIdx] = static_cast<unsigned char>(sum / count);
-                }
-            }
-        }
-        
-        m_mipLevels.push_back(newLevel);
+    if (!m_hdrMipLevels.empty()) {
+        m_hdrMipLevels.resize(1);
+        BuildBoxChain(m_hdrMipLevels, m_channels, FullMipCount(m_hdrMipLevels[0].width, m_hdrMipLevels[0].height));
     }
     
-    std::cout << "Generated " << m_mipLevels.size() << " mipmap levels" << std::endl;
+    ACG_LOG_DEBUG("Generated " << std::max(m_mipLevels.size(), m_hdrMipLevels.size()) << " mipmap levels");
 }
 
 void Texture::GenerateAdaptiveMipmaps() {
-    // TODO: Implement adaptive mipmap generation algorithm
-    // This is a 2pts advanced feature
+    // Normal, roughness and other data maps keep the box filter: sinc ringing would overshoot
+    // their values, while color content keeps noticeably more detail with the Kaiser filter
+    const bool colorContent = m_type == TextureType::Color || m_type == TextureType::Emissive ||
+                              m_type == TextureType::Environment;
+    if (!colorContent) {
+        GenerateMipmaps();
+        return;
+    }
+    
+    if (!m_mipLevels.empty()) {
+        m_mipLevels.resize(1);
+        BuildKaiserChain(m_mipLevels, m_channels, FullMipCount(m_mipLevels[0].width, m_mipLevels[0].height), m_wrap);
+    }
+    if (!m_hdrMipLevels.empty()) {
+        m_hdrMipLevels.resize(1);
+        BuildKaiserChain(m_hdrMipLevels, m_channels, FullMipCount(m_hdrMipLevels[0].width, m_hdrMipLevels[0].height), m_wrap);
+    }
+    
+    ACG_LOG_DEBUG("Generated " << std::max(m_mipLevels.size(), m_hdrMipLevels.size()) << " Kaiser-filtered mipmap levels");
 }
 
 glm::vec2 Texture::ApplyWrap(float u, float v) const {
@@ -319,16 +589,29 @@ TextureManager& TextureManager::Instance() {
     return instance;
 }
 
+std::shared_ptr<Texture> TextureManager::FindCached(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto it = m_textures.find(filename);
+    if (it == m_textures.end()) {
+        return nullptr;
+    }
+    auto texture = it->second.lock();
+    if (!texture) {
+        m_textures.erase(it);  // 已无人引用
+    }
+    return texture;
+}
+
 std::shared_ptr<Texture> TextureManager::Load(const std::string& filename) {
     // Check if already loaded
-    auto it = m_textures.find(filename);
-    if (it != m_textures.end()) {
-        return it->second;
+    if (auto cached = FindCached(filename)) {
+        return cached;
     }
     
     // Load new texture
     auto texture = std::make_shared<Texture>();
     if (texture->LoadFromFile(filename)) {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
         m_textures[filename] = texture;
         return texture;
     }
@@ -336,7 +619,86 @@ std::shared_ptr<Texture> TextureManager::Load(const std::string& filename) {
     return nullptr;
 }
 
+void TextureManager::AcquireDecodeMemory(size_t bytes) {
+    std::unique_lock<std::mutex> lock(m_budgetMutex);
+    // 单个超出预算的纹理在没有其他解码任务时仍允许执行
+    m_budgetCondition.wait(lock, [&]() {
+        return m_decodeMemoryInFlight == 0 || m_decodeMemoryInFlight + bytes <= m_decodeMemoryBudget;
+    });
+    m_decodeMemoryInFlight += bytes;
+}
+
+void TextureManager::ReleaseDecodeMemory(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_budgetMutex);
+        m_decodeMemoryInFlight -= bytes;
+    }
+    m_budgetCondition.notify_all();
+}
+
+std::vector<std::shared_ptr<Texture>> TextureManager::LoadBatch(const std::vector<std::string>& filenames) {
+    std::vector<std::shared_ptr<Texture>> results(filenames.size());
+    
+    // 相同路径只解码一次, 已缓存的直接复用
+    std::map<std::string, std::vector<size_t>> slotsByPath;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        slotsByPath[filenames[i]].push_back(i);
+    }
+    std::vector<const std::pair<const std::string, std::vector<size_t>>*> pending;
+    for (const auto& entry : slotsByPath) {
+        if (auto cached = FindCached(entry.first)) {
+            for (size_t slot : entry.second) {
+                results[slot] = cached;
+            }
+        } else {
+            pending.push_back(&entry);
+        }
+    }
+    
+    size_t reused = filenames.size() - pending.size();
+    if (!pending.empty()) {
+        std::cout << "[Texture] Decoding " << pending.size() << " textures in parallel ("
+                  << reused << " reused)" << std::endl;
+    }
+    
+    // 每个任务只写自己的槽位, 材质绑定顺序不受解码完成顺序影响
+    ParallelFor(pending.size(), [&](size_t i) {
+        const std::string& path = pending[i]->first;
+        auto texture = std::make_shared<Texture>();
+        
+        if (!std::filesystem::exists(path)) {
+            LogLine(std::cerr, "Warning: Texture not found: ", path);
+        } else {
+            // stb解码缓冲 + Texture内部拷贝, 峰值约为解码大小的两倍
+            size_t decodeBytes = Texture::EstimateDecodedSize(path) * 2;
+            AcquireDecodeMemory(decodeBytes);
+            bool loaded = false;
+            try {
+                loaded = texture->LoadFromFile(path);
+            } catch (...) {
+                ReleaseDecodeMemory(decodeBytes);
+                throw;
+            }
+            ReleaseDecodeMemory(decodeBytes);
+            
+            if (loaded) {
+                std::lock_guard<std::mutex> lock(m_cacheMutex);
+                m_textures[path] = texture;
+            } else {
+                LogLine(std::cerr, "Error: Failed to load texture: ", path);
+            }
+        }
+        
+        for (size_t slot : pending[i]->second) {
+            results[slot] = texture;
+        }
+    });
+    
+    return results;
+}
+
 void TextureManager::Clear() {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
     m_textures.clear();
 }
 
@@ -0,0 +1,581 @@
+#include "TextureCompression.h"
+#include "Parallel.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+namespace ACG {
+
+namespace {
+
+// BC7 4位索引插值权重 (/64)
+const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+const uint32_t CACHE_VERSION = 2;  // 编码器或文件布局变化时递增, 使旧缓存失效
+
+struct CacheHeader {
+    char magic[4];      // "ACGT"
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;  // Levels stored back to back from width x height down
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t dataSize;
+};
+
+std::mutex g_cacheDirectoryMutex;
+std::string g_cacheDirectory;
+
+// Gather a 4x4 block as RGBA, clamping reads at the image edge
+void FetchBlock(const uint8_t* pixels, uint32_t width, uint32_t height, int channels,
+                uint32_t blockX, uint32_t blockY, uint8_t block[16][4]) {
+    for (uint32_t y = 0; y < 4; ++y) {
+        uint32_t srcY = std::min(blockY * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; ++x) {
+            uint32_t srcX = std::min(blockX * 4 + x, width - 1);
+            const uint8_t* p = pixels + (static_cast<size_t>(srcY) * width + srcX) * channels;
+            uint8_t* out = block[y * 4 + x];
+            if (channels >= 3) {
+                out[0] = p[0];
+                out[1] = p[1];
+                out[2] = p[2];
+                out[3] = (channels == 4) ? p[3] : 255;
+            } else {
+                out[0] = out[1] = out[2] = p[0];
+                out[3] = (channels == 2) ? p[1] : 255;
+            }
+        }
+    }
+}
+
+// Principal axis of the block colors (first `components` channels) by power iteration
+void ComputePrincipalAxis(const uint8_t block[16][4], int components, float mean[4], float axis[4]) {
+    for (int c = 0; c < 4; ++c) {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < components; ++c) {
+            mean[c] += block[i][c];
+        }
+    }
+    for (int c = 0; c < components; ++c) {
+        mean[c] /= 16.0f;
+    }
+
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i) {
+        float d[4];
+        for (int c = 0; c < components; ++c) {
+            d[c] = block[i][c] - mean[c];
+        }
+        for (int a = 0; a < components; ++a) {
+            for (int b = 0; b < components; ++b) {
+                cov[a][b] += d[a] * d[b];
+            }
+        }
+    }
+
+    float v[4];
+    for (int c = 0; c < components; ++c) {
+        v[c] = 1.0f;
+    }
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int a = 0; a < components; ++a) {
+            for (int b = 0; b < components; ++b) {
+                next[a] += cov[a][b] * v[b];
+            }
+            length += next[a] * next[a];
+        }
+        if (length < 1e-12f) {
+            break;  // 平坦块: 轴方向无关紧要
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < components; ++c) {
+            v[c] = next[c] / length;
+        }
+    }
+
+    float length = 0.0f;
+    for (int c = 0; c < components; ++c) {
+        length += v[c] * v[c];
+    }
+    length = std::sqrt(length);
+    for (int c = 0; c < components; ++c) {
+        axis[c] = v[c] / length;
+    }
+}
+
+// Endpoints at the extreme projections of the block onto its principal axis
+void ComputeAxisEndpoints(const uint8_t block[16][4], int components, float endpoint0[4], float endpoint1[4]) {
+    float mean[4], axis[4];
+    ComputePrincipalAxis(block, components, mean, axis);
+
+    float minT = 0.0f, maxT = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < components; ++c) {
+            t += (block[i][c] - mean[c]) * axis[c];
+        }
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    for (int c = 0; c < 4; ++c) {
+        endpoint0[c] = std::clamp(mean[c] + minT * axis[c], 0.0f, 255.0f);
+        endpoint1[c] = std::clamp(mean[c] + maxT * axis[c], 0.0f, 255.0f);
+    }
+}
+
+uint16_t PackRGB565(const float color[3]) {
+    uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+    uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+    uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void UnpackRGB565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void EncodeBC1(const uint8_t block[16][4], uint8_t* dst) {
+    float endpoint0[4], endpoint1[4];
+    ComputeAxisEndpoints(block, 3, endpoint0, endpoint1);
+
+    // c0 > c1 选择4色模式 (无透明)
+    uint16_t c0 = PackRGB565(endpoint1);
+    uint16_t c1 = PackRGB565(endpoint0);
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        UnpackRGB565(c0, palette[0]);
+        UnpackRGB565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int bestIndex = 0;
+            int bestError = INT32_MAX;
+            for (int p = 0; p < 4; ++p) {
+                int error = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = block[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    bestIndex = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(bestIndex) << (2 * i);
+        }
+    }
+
+    dst[0] = static_cast<uint8_t>(c0 & 0xFF);
+    dst[1] = static_cast<uint8_t>(c0 >> 8);
+    dst[2] = static_cast<uint8_t>(c1 & 0xFF);
+    dst[3] = static_cast<uint8_t>(c1 >> 8);
+    for (int b = 0; b < 4; ++b) {
+        dst[4 + b] = static_cast<uint8_t>(indices >> (8 * b));
+    }
+}
+
+void EncodeBC4(const uint8_t block[16][4], int channel, uint8_t* dst) {
+    int minValue = 255, maxValue = 0;
+    for (int i = 0; i < 16; ++i) {
+        minValue = std::min(minValue, static_cast<int>(block[i][channel]));
+        maxValue = std::max(maxValue, static_cast<int>(block[i][channel]));
+    }
+
+    // r0 > r1 选择8值插值模式; 平坦块全部使用索引0
+    dst[0] = static_cast<uint8_t>(maxValue);
+    dst[1] = static_cast<uint8_t>(minValue);
+    uint64_t indices = 0;
+    if (maxValue > minValue) {
+        int palette[8];
+        palette[0] = maxValue;
+        palette[1] = minValue;
+        for (int p = 2; p < 8; ++p) {
+            palette[p] = ((8 - p) * maxValue + (p - 1) * minValue + 3) / 7;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int bestIndex = 0;
+            int bestError = INT32_MAX;
+            for (int p = 0; p < 8; ++p) {
+                int error = std::abs(block[i][channel] - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    bestIndex = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+        }
+    }
+    for (int b = 0; b < 6; ++b) {
+        dst[2 + b] = static_cast<uint8_t>(indices >> (8 * b));
+    }
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* dst) : m_dst(dst), m_position(0) {}
+
+    void Write(uint32_t value, uint32_t bits) {
+        for (uint32_t i = 0; i < bits; ++i, ++m_position) {
+            if ((value >> i) & 1) {
+                m_dst[m_position >> 3] |= static_cast<uint8_t>(1 << (m_position & 7));
+            }
+        }
+    }
+
+private:
+    uint8_t* m_dst;
+    uint32_t m_position;
+};
+
+struct BC7Mode6Candidate {
+    int endpoints[2][4];  // 7-bit quantized
+    int pbits[2];
+    int indices[16];
+    int error;
+};
+
+// Index selection and squared error for a quantized mode 6 endpoint pair
+void EvaluateBC7Mode6(const uint8_t block[16][4], BC7Mode6Candidate& candidate) {
+    int e0[4], e1[4];
+    for (int c = 0; c < 4; ++c) {
+        e0[c] = (candidate.endpoints[0][c] << 1) | candidate.pbits[0];
+        e1[c] = (candidate.endpoints[1][c] << 1) | candidate.pbits[1];
+    }
+    int palette[16][4];
+    for (int p = 0; p < 16; ++p) {
+        for (int c = 0; c < 4; ++c) {
+            palette[p][c] = ((64 - BC7_WEIGHTS4[p]) * e0[c] + BC7_WEIGHTS4[p] * e1[c] + 32) >> 6;
+        }
+    }
+
+    candidate.error = 0;
+    for (int i = 0; i < 16; ++i) {
+        int bestIndex = 0;
+        int bestError = INT32_MAX;
+        for (int p = 0; p < 16; ++p) {
+            int error = 0;
+            for (int c = 0; c < 4; ++c) {
+                int d = block[i][c] - palette[p][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                bestIndex = p;
+            }
+        }
+        candidate.indices[i] = bestIndex;
+        candidate.error += bestError;
+    }
+}
+
+void QuantizeBC7Mode6(const float endpoint0[4], const float endpoint1[4], BC7Mode6Candidate& candidate) {
+    for (int c = 0; c < 4; ++c) {
+        candidate.endpoints[0][c] = std::clamp(static_cast<int>(std::lround((endpoint0[c] - candidate.pbits[0]) * 0.5f)), 0, 127);
+        candidate.endpoints[1][c] = std::clamp(static_cast<int>(std::lround((endpoint1[c] - candidate.pbits[1]) * 0.5f)), 0, 127);
+    }
+}
+
+void EncodeBC7(const uint8_t block[16][4], uint8_t* dst) {
+    float axisEndpoint0[4], axisEndpoint1[4];
+    ComputeAxisEndpoints(block, 4, axisEndpoint0, axisEndpoint1);
+
+    BC7Mode6Candidate best = {};
+    best.error = INT32_MAX;
+    for (int pbitCombination = 0; pbitCombination < 4; ++pbitCombination) {
+        BC7Mode6Candidate candidate = {};
+        candidate.pbits[0] = pbitCombination & 1;
+        candidate.pbits[1] = pbitCombination >> 1;
+        QuantizeBC7Mode6(axisEndpoint0, axisEndpoint1, candidate);
+        EvaluateBC7Mode6(block, candidate);
+        if (candidate.error < best.error) {
+            best = candidate;
+        }
+
+        // 按当前索引做一次最小二乘端点拟合
+        float a = 0.0f, b = 0.0f, d = 0.0f;
+        float x[4] = {}, y[4] = {};
+        for (int i = 0; i < 16; ++i) {
+            float t = BC7_WEIGHTS4[candidate.indices[i]] / 64.0f;
+            a += (1.0f - t) * (1.0f - t);
+            b += (1.0f - t) * t;
+            d += t * t;
+            for (int c = 0; c < 4; ++c) {
+                x[c] += (1.0f - t) * block[i][c];
+                y[c] += t * block[i][c];
+            }
+        }
+        float det = a * d - b * b;
+        if (std::fabs(det) < 1e-6f) {
+            continue;
+        }
+        float fitted0[4], fitted1[4];
+        for (int c = 0; c < 4; ++c) {
+            fitted0[c] = std::clamp((d * x[c] - b * y[c]) / det, 0.0f, 255.0f);
+            fitted1[c] = std::clamp((a * y[c] - b * x[c]) / det, 0.0f, 255.0f);
+        }
+        QuantizeBC7Mode6(fitted0, fitted1, candidate);
+        EvaluateBC7Mode6(block, candidate);
+        if (candidate.error < best.error) {
+            best = candidate;
+        }
+    }
+
+    // 锚点像素索引只存3位, 最高位必须为0: 否则交换端点并翻转索引
+    if (best.indices[0] >= 8) {
+        for (int c = 0; c < 4; ++c) {
+            std::swap(best.endpoints[0][c], best.endpoints[1][c]);
+        }
+        std::swap(best.pbits[0], best.pbits[1]);
+        for (int i = 0; i < 16; ++i) {
+            best.indices[i] = 15 - best.indices[i];
+        }
+    }
+
+    std::memset(dst, 0, 16);
+    BitWriter writer(dst);
+    writer.Write(1 << 6, 7);  // mode 6
+    for (int c = 0; c < 4; ++c) {
+        writer.Write(best.endpoints[0][c], 7);
+        writer.Write(best.endpoints[1][c], 7);
+    }
+    writer.Write(best.pbits[0], 1);
+    writer.Write(best.pbits[1], 1);
+    writer.Write(best.indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.Write(best.indices[i], 4);
+    }
+}
+
+bool GetSourceIdentity(const std::string& sourcePath, uint64_t& size, int64_t& time) {
+    std::error_code error;
+    size = std::filesystem::file_size(sourcePath, error);
+    if (error) {
+        return false;
+    }
+    auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error) {
+        return false;
+    }
+    time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+std::filesystem::path GetCacheEntryPath(const std::string& directory, const std::string& sourcePath,
+                                        BlockFormat format, uint32_t width, uint32_t height,
+                                        uint32_t mipLevels) {
+    std::error_code error;
+    std::filesystem::path absoluteSource = std::filesystem::absolute(sourcePath, error);
+    std::string key = absoluteSource.lexically_normal().string() + "|" +
+                      TextureCompressor::GetFormatName(format) + "|" +
+                      std::to_string(width) + "x" + std::to_string(height) + "|" +
+                      std::to_string(mipLevels);
+    char keyHash[32];
+    snprintf(keyHash, sizeof(keyHash), "%016llx",
+             static_cast<unsigned long long>(ShaderCache::Hash(key.data(), key.size())));
+    return std::filesystem::path(directory) /
+           (absoluteSource.stem().string() + "_" + keyHash + ".bc");
+}
+
+} // namespace
+
+DXGI_FORMAT TextureCompressor::GetDXGIFormat(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+        case BlockFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+        case BlockFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+        case BlockFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+const char* TextureCompressor::GetFormatName(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC4: return "BC4";
+        case BlockFormat::BC5: return "BC5";
+        case BlockFormat::BC7: return "BC7";
+    }
+    return "Unknown";
+}
+
+uint32_t TextureCompressor::GetBlockBytes(BlockFormat format) {
+    return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+}
+
+uint32_t TextureCompressor::GetRowPitch(BlockFormat format, uint32_t width) {
+    return ((width + 3) / 4) * GetBlockBytes(format);
+}
+
+size_t TextureCompressor::GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height) {
+    return static_cast<size_t>(GetRowPitch(format, width)) * ((height + 3) / 4);
+}
+
+size_t TextureCompressor::GetCompressedChainSize(BlockFormat format, uint32_t width, uint32_t height,
+                                                 uint32_t mipLevels) {
+    size_t size = 0;
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+        size += GetCompressedSize(format, std::max(1u, width >> level), std::max(1u, height >> level));
+    }
+    return size;
+}
+
+BlockFormat TextureCompressor::SelectFormat(TextureType type, int channels) {
+    switch (type) {
+        case TextureType::Normal:
+            return BlockFormat::BC5;
+        case TextureType::Roughness:
+        case TextureType::Metallic:
+        case TextureType::Height:
+        case TextureType::AO:
+            return (channels == 1) ? BlockFormat::BC4 : BlockFormat::BC1;
+        case TextureType::Emissive:
+            return BlockFormat::BC1;
+        default:
+            return BlockFormat::BC7;
+    }
+}
+
+std::vector<uint8_t> TextureCompressor::Compress(BlockFormat format, const uint8_t* pixels,
+                                                 uint32_t width, uint32_t height, int channels,
+                                                 bool parallel) {
+    if (!pixels || width == 0 || height == 0 || channels < 1 || channels > 4) {
+        return {};
+    }
+
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t blockBytes = GetBlockBytes(format);
+    std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+    auto encodeRow = [&](size_t blockY) {
+        uint8_t block[16][4];
+        uint8_t* dst = blocks.data() + blockY * blocksX * blockBytes;
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX, dst += blockBytes) {
+            FetchBlock(pixels, width, height, channels, blockX, static_cast<uint32_t>(blockY), block);
+            switch (format) {
+                case BlockFormat::BC1:
+                    EncodeBC1(block, dst);
+                    break;
+                case BlockFormat::BC4:
+                    EncodeBC4(block, 0, dst);
+                    break;
+                case BlockFormat::BC5:
+                    EncodeBC4(block, 0, dst);
+                    EncodeBC4(block, 1, dst + 8);
+                    break;
+                case BlockFormat::BC7:
+                    EncodeBC7(block, dst);
+                    break;
+            }
+        }
+    };
+
+    if (parallel) {
+        ParallelFor(blocksY, encodeRow);
+    } else {
+        for (uint32_t blockY = 0; blockY < blocksY; ++blockY) {
+            encodeRow(blockY);
+        }
+    }
+    return blocks;
+}
+
+void TextureCompressor::SetCacheDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(g_cacheDirectoryMutex);
+    g_cacheDirectory = directory;
+}
+
+std::string TextureCompressor::GetCacheDirectory() {
+    std::lock_guard<std::mutex> lock(g_cacheDirectoryMutex);
+    return g_cacheDirectory;
+}
+
+std::string TextureCompressor::GetCacheDirectoryForScene(const std::string& scenePath) {
+    std::filesystem::path path(scenePath);
+    return (path.parent_path() / (path.stem().string() + ".texcache")).string();
+}
+
+bool TextureCompressor::LoadCached(const std::string& sourcePath, BlockFormat format,
+                                   uint32_t width, uint32_t height, uint32_t mipLevels,
+                                   std::vector<uint8_t>& blocks) {
+    std::string directory = GetCacheDirectory();
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (directory.empty() || sourcePath.empty() || mipLevels == 0 ||
+        !GetSourceIdentity(sourcePath, sourceSize, sourceTime)) {
+        return false;
+    }
+
+    std::ifstream file(GetCacheEntryPath(directory, sourcePath, format, width, height, mipLevels), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    CacheHeader header = {};
+    const size_t expectedSize = GetCompressedChainSize(format, width, height, mipLevels);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, "ACGT", 4) != 0 || header.version != CACHE_VERSION ||
+        header.format != static_cast<uint32_t>(format) || header.width != width || header.height != height ||
+        header.mipLevels != mipLevels || header.sourceSize != sourceSize || header.sourceTime != sourceTime || header.dataSize != expectedSize) {
+        return false;
+    }
+
+    blocks.resize(expectedSize);
+    if (!file.read(reinterpret_cast<char*>(blocks.data()), static_cast<std::streamsize>(expectedSize))) {
+        blocks.clear();
+        return false;
+    }
+    return true;
+}
+
+void TextureCompressor::StoreCached(const std::string& sourcePath, BlockFormat format,
+                                    uint32_t width, uint32_t height, uint32_t mipLevels,
+                                    const std::vector<uint8_t>& blocks) {
+    std::string directory = GetCacheDirectory();
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (directory.empty() || sourcePath.empty() || mipLevels == 0 ||
+        blocks.size() != GetCompressedChainSize(format, width, height, mipLevels) ||
+        !GetSourceIdentity(sourcePath, sourceSize, sourceTime)) {
+        return;
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, "ACGT", 4);
+    header.version = CACHE_VERSION;
+    header.format = static_cast<uint32_t>(format);
+    header.width = width;
+    header.height = height;
+    header.mipLevels = mipLevels;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.dataSize = blocks.size();
+    ShaderCache::WriteFileAtomically(GetCacheEntryPath(directory, sourcePath, format, width, height, mipLevels),
+                                     &header, sizeof(header), blocks.data(), blocks.size());
+}
+
+} // namespace ACG
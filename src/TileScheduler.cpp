@@ -0,0 +1,96 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ACG {
+
+TileScheduler::TileScheduler(ImageWriter& writer, uint32_t width, uint32_t height, uint32_t coreWidth, uint32_t coreHeight,
+                             bool hdr, uint32_t imageLayers)
+    : m_writer(writer)
+    , m_width(width)
+    , m_height(height)
+    , m_coreWidth(std::max(1u, std::min(coreWidth, width)))
+    , m_coreHeight(std::max(1u, std::min(coreHeight, height)))
+    , m_tilesX((width + m_coreWidth - 1) / m_coreWidth)
+    , m_tilesY((height + m_coreHeight - 1) / m_coreHeight)
+    , m_hdr(hdr)
+    , m_imageLayers(hdr ? imageLayers : 1)
+    , m_nextTile(0)
+    , m_completedTiles(0)
+    , m_aborted(false)
+    , m_nextBandToWrite(0)
+{
+}
+
+int TileScheduler::AcquireTile() {
+    if (m_aborted.load()) {
+        return -1;
+    }
+    // Buckets are handed out row by row, so rows complete (and leave memory) roughly in order
+    const int tile = m_nextTile.fetch_add(1);
+    return tile < GetTileCount() ? tile : -1;
+}
+
+void TileScheduler::SubmitTile(int tileIndex, const uint8_t* pixels, const float* planes) {
+    if (tileIndex < 0 || tileIndex >= GetTileCount()) {
+        throw std::runtime_error("TileScheduler: invalid bucket index");
+    }
+    const uint32_t tileX = static_cast<uint32_t>(tileIndex) % m_tilesX;
+    const uint32_t tileY = static_cast<uint32_t>(tileIndex) / m_tilesX;
+    const uint32_t coreX = tileX * m_coreWidth;
+    const uint32_t coreY = tileY * m_coreHeight;
+    const uint32_t coreW = std::min(m_coreWidth, m_width - coreX);
+    const uint32_t coreH = std::min(m_coreHeight, m_height - coreY);
+    const size_t bandPixelCount = static_cast<size_t>(m_width) * coreH;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_aborted.load()) {
+        return;
+    }
+
+    Band& band = m_bands[tileY];
+    if (m_hdr) {
+        if (band.planes.empty()) {
+            band.planes.resize(bandPixelCount * 3 * m_imageLayers);
+        }
+        const size_t tilePlaneFloats = static_cast<size_t>(coreW) * coreH * 3;
+        for (uint32_t image = 0; image < m_imageLayers; ++image) {
+            for (uint32_t y = 0; y < coreH; ++y) {
+                const float* src = planes + image * tilePlaneFloats + static_cast<size_t>(y) * coreW * 3;
+                float* dst = band.planes.data() + image * bandPixelCount * 3 + (static_cast<size_t>(y) * m_width + coreX) * 3;
+                std::copy(src, src + coreW * 3, dst);
+            }
+        }
+    } else {
+        if (band.pixels.empty()) {
+            band.pixels.resize(bandPixelCount * 3);
+        }
+        for (uint32_t y = 0; y < coreH; ++y) {
+            const uint8_t* src = pixels + static_cast<size_t>(y) * coreW * 3;
+            std::copy(src, src + coreW * 3, band.pixels.data() + (static_cast<size_t>(y) * m_width + coreX) * 3);
+        }
+    }
+    band.tilesDone++;
+    m_completedTiles.fetch_add(1);
+
+    // Hand every complete row at the top of the image to the writer (the buffers move)
+    for (auto it = m_bands.find(m_nextBandToWrite); it != m_bands.end() && it->second.tilesDone == m_tilesX;
+         it = m_bands.find(m_nextBandToWrite)) {
+        const int rows = static_cast<int>(std::min(m_coreHeight, m_height - m_nextBandToWrite * m_coreHeight));
+        if (m_hdr) {
+            m_writer.WriteRows(rows, std::move(it->second.planes));
+        } else {
+            m_writer.WriteRows(rows, std::move(it->second.pixels));
+        }
+        m_bands.erase(it);
+        m_nextBandToWrite++;
+    }
+}
+
+bool TileScheduler::IsComplete() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextBandToWrite == m_tilesY;
+}
+
+} // namespace ACG
@@ -0,0 +1,177 @@
+#include "UploadRing.h"
+#include "DX12Helper.h"
+#include <iostream>
+
+namespace ACG {
+
+static UINT64 AlignUp(UINT64 value, UINT64 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+UploadRing::UploadRing()
+    : m_mappedData(nullptr)
+    , m_capacity(0)
+    , m_head(0)
+    , m_tail(0)
+    , m_submittedHead(0)
+    , m_fenceEvent(nullptr)
+    , m_nextSubmissionId(1)
+{
+}
+
+UploadRing::~UploadRing() {
+    Shutdown();
+}
+
+void UploadRing::Initialize(ID3D12Device* device, UINT64 capacity) {
+    Shutdown();
+
+    m_device = device;
+    m_capacity = AlignUp(capacity, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(m_capacity);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_buffer)
+    ), "Failed to create upload ring buffer");
+    m_buffer->SetName(L"Upload Ring");
+
+    // Upload heaps may stay mapped for the lifetime of the resource
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(m_buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedData)), "Failed to map upload ring buffer");
+
+    m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_fenceEvent == nullptr) {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()), "Failed to create upload ring fence event");
+    }
+
+    std::cout << "✓ Upload ring created (" << (m_capacity / (1024 * 1024)) << " MB)" << std::endl;
+}
+
+void UploadRing::Shutdown() {
+    if (!m_buffer) {
+        return;
+    }
+    WaitIdle();
+    m_buffer->Unmap(0, nullptr);
+    m_buffer.Reset();
+    m_mappedData = nullptr;
+    m_queueFences.clear();
+    m_device.Reset();
+    if (m_fenceEvent) {
+        CloseHandle(m_fenceEvent);
+        m_fenceEvent = nullptr;
+    }
+    m_capacity = 0;
+    m_head = m_tail = m_submittedHead = 0;
+    m_inFlight.clear();
+}
+
+UploadRing::Allocation UploadRing::Allocate(UINT64 size, UINT64 alignment) {
+    Allocation allocation;
+    if (!m_buffer || size == 0 || size > m_capacity) {
+        return allocation;
+    }
+
+    RetireCompleted();
+
+    // Allocations never straddle the end of the buffer: skip the remainder and wrap to 0
+    UINT64 start = AlignUp(m_head, alignment);
+    if (start % m_capacity + size > m_capacity) {
+        start = AlignUp(start, m_capacity);
+    }
+
+    // Ring full: wait for the oldest submissions to release their space
+    while (start + size - m_tail > m_capacity) {
+        if (m_inFlight.empty()) {
+            return allocation;
+        }
+        Wait(m_inFlight.front());
+        RetireCompleted();
+    }
+
+    m_head = start + size;
+    allocation.resource = m_buffer.Get();
+    allocation.offset = start % m_capacity;
+    allocation.cpuAddress = m_mappedData + allocation.offset;
+    return allocation;
+}
+
+UINT64 UploadRing::Submit(ID3D12CommandQueue* queue) {
+    if (!m_buffer) {
+        return 0;
+    }
+
+    size_t queueIndex = 0;
+    while (queueIndex < m_queueFences.size() && m_queueFences[queueIndex].queue != queue) {
+        queueIndex++;
+    }
+    if (queueIndex == m_queueFences.size()) {
+        QueueFence queueFence = { queue, nullptr, 0 };
+        ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&queueFence.fence)),
+            "Failed to create upload ring fence");
+        m_queueFences.push_back(queueFence);
+    }
+
+    QueueFence& queueFence = m_queueFences[queueIndex];
+    ThrowIfFailed(queue->Signal(queueFence.fence.Get(), ++queueFence.value), "Failed to signal upload ring fence");
+
+    // Recorded even without new allocations: callers also use ids to recycle command allocators
+    Submission submission = { m_nextSubmissionId++, queueIndex, queueFence.value, m_head };
+    m_inFlight.push_back(submission);
+    m_submittedHead = m_head;
+    return submission.id;
+}
+
+bool UploadRing::IsComplete(const Submission& submission) const {
+    return m_queueFences[submission.queueIndex].fence->GetCompletedValue() >= submission.fenceValue;
+}
+
+void UploadRing::Wait(const Submission& submission) {
+    if (IsComplete(submission)) {
+        return;
+    }
+    ID3D12Fence* fence = m_queueFences[submission.queueIndex].fence.Get();
+    ThrowIfFailed(fence->SetEventOnCompletion(submission.fenceValue, m_fenceEvent), "Failed to set upload ring fence event");
+    WaitForSingleObject(m_fenceEvent, INFINITE);
+}
+
+bool UploadRing::IsSubmissionComplete(UINT64 submissionId) const {
+    for (const auto& submission : m_inFlight) {
+        if (submission.id > submissionId) {
+            break;
+        }
+        if (!IsComplete(submission)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void UploadRing::WaitForSubmission(UINT64 submissionId) {
+    // Submissions retire in order, so everything up to the id is waited for
+    while (!m_inFlight.empty() && m_inFlight.front().id <= submissionId) {
+        Wait(m_inFlight.front());
+        RetireCompleted();
+    }
+}
+
+void UploadRing::WaitIdle() {
+    if (!m_inFlight.empty()) {
+        WaitForSubmission(m_inFlight.back().id);
+    }
+}
+
+void UploadRing::RetireCompleted() {
+    // In submission order: a later submission on a faster queue waits for earlier ones
+    while (!m_inFlight.empty() && IsComplete(m_inFlight.front())) {
+        m_tail = m_inFlight.front().head;
+        m_inFlight.pop_front();
+    }
+}
+
+} // namespace ACG
@@ -1,14 +1,32 @@
 #include "VirtualTextureSystem.h"
 #include "Texture.h"
 #include "DX12Helper.h"
+#include "TextureCompression.h"
+#include "Parallel.h"
+#include "UploadRing.h"
+#include "Logger.h"
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 
 namespace ACG {
 
+// Physical cache pages hold BC7 blocks (1 byte/pixel instead of 4 for RGBA8)
+static const BlockFormat PHYSICAL_CACHE_FORMAT = BlockFormat::BC7;
+
+// Physical cache page grid (must match SampleVirtualTexture in Raytracing.hlsl)
+static const uint32_t CACHE_TILES_PER_ROW = 48;  // sqrt(2304) = 48
+
 VirtualTextureSystem::VirtualTextureSystem()
     : m_supportsTiledResources(false)
     , m_tiledResourceTier(D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED)
+    , m_totalTiles(0)
+    , m_feedbackPending(false)
+    , m_feedbackFrame(0)
+    , m_uploadRing(nullptr)
+    , m_streamingUploadUsed(0)
+    , m_indirectionDirtyBegin(0)
+    , m_indirectionDirtyEnd(0)
 {
 }
 
@@ -16,6 +34,13 @@ VirtualTextureSystem::~VirtualTextureSystem() {
     // Cleanup resources
 }
 
+// Execute a closed command list and block until the GPU has finished it (also retires its ring space)
+void VirtualTextureSystem::ExecuteAndWait(ID3D12CommandQueue* commandQueue, ID3D12GraphicsCommandList* cmdList) {
+    ID3D12CommandList* cmdLists[] = { cmdList };
+    commandQueue->ExecuteCommandLists(1, cmdLists);
+    m_uploadRing->WaitForSubmission(m_uploadRing->Submit(commandQueue));
+}
+
 bool VirtualTextureSystem::CheckTiledResourcesSupport(ID3D12Device* device) {
     D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
     HRESULT hr = device->CheckFeatureSupport(
@@ -53,9 +78,27 @@ bool VirtualTextureSystem::CheckTiledResourcesSupport(ID3D12Device* device) {
     return false;
 }
 
-bool VirtualTextureSystem::Initialize(ID3D12Device* device, const VirtualTextureConfig& config) {
+bool VirtualTextureSystem::Initialize(ID3D12Device* device, const VirtualTextureConfig& config, UploadRing* uploadRing) {
     m_device = device;
     m_config = config;
+    m_uploadRing = uploadRing;
+    
+    // Drop everything from a previously loaded scene
+    m_virtualTextures.clear();
+    m_virtualTextureMetadata.clear();
+    m_physicalPages.clear();
+    m_freePhysicalPages = std::queue<uint32_t>();
+    m_indirectionBuffer.Reset();
+    m_indirectionData.clear();
+    m_indirectionDirtyBegin = m_indirectionDirtyEnd = 0;
+    m_feedbackBuffer.Reset();
+    m_feedbackReadback.Reset();
+    m_feedbackClearBuffer.Reset();
+    m_textureInfoBuffer.Reset();
+    m_streamingUploadUsed = 0;
+    m_pendingRequests.clear();
+    m_feedbackPending = false;
+    m_feedbackFrame = 0;
     
     std::cout << "[Virtual Texture] Initializing Virtual Texture System..." << std::endl;
     std::cout << "  Tile Size: " << config.tileSize << "x" << config.tileSize << std::endl;
@@ -92,21 +135,21 @@ bool VirtualTextureSystem::Initialize(ID3D12Device* device, const VirtualTexture
         return false;
     }
     
-    // Initialize physical page pool
-    m_physicalPages.resize(config.maxPhysicalPages);
-    for (uint32_t i = 0; i < config.maxPhysicalPages; ++i) {
-        m_physicalPages[i].isAllocated = false;
-        m_freePhysicalPages.push(i);
-    }
-    
     // Create physical cache texture: large texture to hold all physical pages
     // Use 48x48 grid for 2304 pages (enough for most scenes, less than 64x64 for 4096)
     // Each page is 256x256 pixels
-    // Total size: 12288x12288 pixels = 576MB (reasonable memory usage)
-    const uint32_t CACHE_TILES_PER_ROW = 48;  // sqrt(2304) = 48
-    const uint32_t actualCachePages = std::min(config.maxPhysicalPages, static_cast<uint32_t>(2304));
+    // Total size: 12288x12288 pixels = 144MB as BC7 (576MB if it were RGBA8)
+    const uint32_t actualCachePages = std::min(config.maxPhysicalPages, CACHE_TILES_PER_ROW * CACHE_TILES_PER_ROW);
     const uint32_t cacheTextureSize = CACHE_TILES_PER_ROW * config.tileSize;  // 48 * 256 = 12288
     
+    // Initialize physical page pool (only pages that fit in the cache grid)
+    m_physicalPages.resize(actualCachePages);
+    for (uint32_t i = 0; i < actualCachePages; ++i) {
+        m_physicalPages[i].isAllocated = false;
+        m_physicalPages[i].lastUsedFrame = 0;
+        m_freePhysicalPages.push(i);
+    }
+    
     std::cout << "  Creating physical cache for " << actualCachePages << " pages (" 
               << CACHE_TILES_PER_ROW << "x" << CACHE_TILES_PER_ROW << " grid)" << std::endl;
     
@@ -116,7 +159,7 @@ bool VirtualTextureSystem::Initialize(ID3D12Device* device, const VirtualTexture
     cacheDesc.Height = cacheTextureSize;
     cacheDesc.DepthOrArraySize = 1;
     cacheDesc.MipLevels = 1;
-    cacheDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    cacheDesc.Format = TextureCompressor::GetDXGIFormat(PHYSICAL_CACHE_FORMAT);
     cacheDesc.SampleDesc.Count = 1;
     cacheDesc.SampleDesc.Quality = 0;
     cacheDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
@@ -139,7 +182,10 @@ bool VirtualTextureSystem::Initialize(ID3D12Device* device, const VirtualTexture
     }
     
     m_physicalCacheTexture->SetName(L"Virtual Texture Physical Cache");
-    std::cout << "  Physical Cache Texture: " << cacheTextureSize << "x" << cacheTextureSize << " pixels" << std::endl;
+    std::cout << "  Physical Cache Texture: " << cacheTextureSize << "x" << cacheTextureSize << " pixels ("
+              << TextureCompressor::GetFormatName(PHYSICAL_CACHE_FORMAT) << ", "
+              << (TextureCompressor::GetCompressedSize(PHYSICAL_CACHE_FORMAT, cacheTextureSize, cacheTextureSize) / 1024 / 1024)
+              << " MB)" << std::endl;
     
     // Reserve space for virtual textures
     m_virtualTextures.reserve(config.maxVirtualTextures);
@@ -193,8 +239,12 @@ int32_t VirtualTextureSystem::AddVirtualTexture(const std::shared_ptr<Texture>&
     std::cout << "[Virtual Texture] Adding texture " << m_virtualTextures.size() 
               << ": " << width << "x" << height << std::endl;
     
-    // Calculate number of mip levels (for future LOD support)
-    uint32_t mipLevels = 1; // Start with base level only
+    // Mip chain (same sizes as Texture::GenerateMipmaps) down to the first level that fits in
+    // one tile; coarser lookups clamp to that level
+    uint32_t mipLevels = 1;
+    while (std::max(std::max(1u, width >> (mipLevels - 1)), std::max(1u, height >> (mipLevels - 1))) > m_config.tileSize) {
+        mipLevels++;
+    }
     
     // Create tiled resource
     try {
@@ -207,10 +257,6 @@ int32_t VirtualTextureSystem::AddVirtualTexture(const std::shared_ptr<Texture>&
     // Calculate tile layout
     uint32_t numTilesX = CalculateNumTiles(width, m_config.tileSize);
     uint32_t numTilesY = CalculateNumTiles(height, m_config.tileSize);
-    uint32_t totalTiles = numTilesX * numTilesY;
-    
-    std::cout << "  Tile Layout: " << numTilesX << "x" << numTilesY 
-              << " = " << totalTiles << " tiles" << std::endl;
     
     // Create metadata
     VirtualTextureMetadata metadata;
@@ -221,336 +267,217 @@ int32_t VirtualTextureSystem::AddVirtualTexture(const std::shared_ptr<Texture>&
     metadata.numTilesY = numTilesY;
     metadata.sourceTexture = texture;
     
-    // Initialize tiles
-    metadata.tiles.reserve(totalTiles);
-    for (uint32_t y = 0; y < numTilesY; ++y) {
-        for (uint32_t x = 0; x < numTilesX; ++x) {
-            VirtualTextureTile tile;
-            tile.textureIndex = static_cast<uint32_t>(m_virtualTextures.size() - 1);
-            tile.mipLevel = 0;
-            tile.tileX = x;
-            tile.tileY = y;
-            tile.isResident = false;
-            tile.physicalPageIndex = UINT32_MAX;
-            metadata.tiles.push_back(tile);
+    // Initialize tiles, level by level
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+        VirtualTextureMip mip;
+        mip.width = std::max(1u, width >> level);
+        mip.height = std::max(1u, height >> level);
+        mip.numTilesX = CalculateNumTiles(mip.width, m_config.tileSize);
+        mip.numTilesY = CalculateNumTiles(mip.height, m_config.tileSize);
+        mip.firstTile = static_cast<uint32_t>(metadata.tiles.size());
+        
+        for (uint32_t y = 0; y < mip.numTilesY; ++y) {
+            for (uint32_t x = 0; x < mip.numTilesX; ++x) {
+                VirtualTextureTile tile;
+                tile.textureIndex = static_cast<uint32_t>(m_virtualTextures.size() - 1);
+                tile.mipLevel = level;
+                tile.tileX = x;
+                tile.tileY = y;
+                tile.isResident = false;
+                tile.physicalPageIndex = UINT32_MAX;
+                metadata.tiles.push_back(tile);
+            }
         }
+        metadata.mips.push_back(std::move(mip));
     }
     
-    m_virtualTextureMetadata.push_back(metadata);
+    std::cout << "  Tile Layout: " << numTilesX << "x" << numTilesY << ", " << mipLevels
+              << " mip levels = " << metadata.tiles.size() << " tiles" << std::endl;
+    
+    m_virtualTextureMetadata.push_back(std::move(metadata));
     
     return static_cast<int32_t>(m_virtualTextures.size() - 1);
 }
 
 bool VirtualTextureSystem::UploadAllTiles(ID3D12GraphicsCommandList* cmdList, ID3D12CommandQueue* commandQueue) {
-    std::cout << "[Virtual Texture] Uploading all tiles to GPU..." << std::endl;
-    
-    // Clear any previous upload buffers
-    m_uploadBuffers.clear();
-    
-    // Create our own command allocator and list for batched uploads
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> batchAllocator;
-    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> batchCmdList;
-    
-    HRESULT hr = m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&batchAllocator));
-    if (FAILED(hr)) {
-        std::cerr << "  ✗ Failed to create command allocator for upload" << std::endl;
-        return false;
+    std::cout << "[Virtual Texture] Compressing textures and prefilling physical cache..." << std::endl;
+    
+    // Tile layout shared by the feedback and indirection buffers: textures in order,
+    // each texture's levels finest first
+    m_totalTiles = 0;
+    for (auto& metadata : m_virtualTextureMetadata) {
+        metadata.feedbackOffset = m_totalTiles;
+        m_totalTiles += static_cast<uint32_t>(metadata.tiles.size());
     }
-    
-    hr = m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, batchAllocator.Get(), nullptr, IID_PPV_ARGS(&batchCmdList));
-    if (FAILED(hr)) {
-        std::cerr << "  ✗ Failed to create command list for upload" << std::endl;
+    if (m_totalTiles == 0) {
+        std::cerr << "  ✗ No tiles to upload" << std::endl;
         return false;
     }
     
-    // Create fence for synchronization
-    Microsoft::WRL::ComPtr<ID3D12Fence> fence;
-    UINT64 fenceValue = 0;
-    HANDLE fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
-    
-    size_t totalTilesUploaded = 0;
-    const size_t MAX_TILES_PER_BATCH = 50;  // Execute GPU commands every 50 tiles to avoid memory buildup
-    std::vector<size_t> texturesInCurrentBatch;  // Track textures that need state transition back
-    
-    // Transition physical cache to COPY_DEST state once at the beginning
-    D3D12_RESOURCE_BARRIER cacheBarrier = {};
-    cacheBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    cacheBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    cacheBarrier.Transition.pResource = m_physicalCacheTexture.Get();
-    cacheBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COMMON;
-    cacheBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
-    cacheBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    batchCmdList->ResourceBarrier(1, &cacheBarrier);
+    m_indirectionData.assign(m_totalTiles, UINT32_MAX);
+    m_indirectionDirtyBegin = m_indirectionDirtyEnd = 0;
     
-    // NOTE: We don't clear the physical cache to avoid state tracking issues with CommandList reset.
-    // Uninitialized cache positions will contain undefined data, but all tiles we upload will have valid data.
-    // The indirection texture marks which tiles are resident (not 0xFFFFFFFF), so shader won't sample uninitialized areas.
-    
-    for (size_t texIdx = 0; texIdx < m_virtualTextureMetadata.size(); ++texIdx) {
+    // Compress every mip level once (or reuse the disk cache); streamed tiles are cut out of
+    // these blocks later, so they stay in system memory
+    std::atomic<size_t> compressedCount(0);
+    ParallelFor(m_virtualTextureMetadata.size(), [&](size_t texIdx) {
         auto& metadata = m_virtualTextureMetadata[texIdx];
         auto& sourceTexture = metadata.sourceTexture;
+        metadata.fallbackColor[0] = metadata.fallbackColor[1] = metadata.fallbackColor[2] = 0.5f;
+        metadata.fallbackColor[3] = 1.0f;
         
-        if (!sourceTexture || sourceTexture->GetWidth() == 0) {
-            std::cout << "  Skipping texture " << texIdx << ": invalid source" << std::endl;
-            continue;
-        }
-        
-        const unsigned char* srcData = sourceTexture->GetRawData();
-        if (!srcData) {
-            std::cerr << "  ✗ Texture " << texIdx << ": null source data" << std::endl;
-            continue;
+        const unsigned char* srcData = sourceTexture ? sourceTexture->GetRawData() : nullptr;
+        if (!srcData || sourceTexture->GetWidth() == 0) {
+            return;
         }
         
         int srcChannels = sourceTexture->GetChannels();
-        int srcWidth = sourceTexture->GetWidth();
-        int srcHeight = sourceTexture->GetHeight();
-        size_t srcDataSize = static_cast<size_t>(srcWidth) * srcHeight * srcChannels;
-        
-        std::cout << "  Uploading texture " << texIdx << ": " << srcWidth << "x" << srcHeight 
-                  << " (" << metadata.tiles.size() << " tiles)" << std::endl;
+        uint32_t srcWidth = sourceTexture->GetWidth();
+        uint32_t srcHeight = sourceTexture->GetHeight();
         
-        // No need for per-texture state transition anymore since we upload to physical cache
-        // Physical cache state transition will be done once at the beginning
-        
-        // Upload each tile
-        for (auto& tile : metadata.tiles) {
-            // Calculate tile source region
-            uint32_t tileStartX = tile.tileX * m_config.tileSize;
-            uint32_t tileStartY = tile.tileY * m_config.tileSize;
-            uint32_t tileEndX = std::min(tileStartX + m_config.tileSize, static_cast<uint32_t>(srcWidth));
-            uint32_t tileEndY = std::min(tileStartY + m_config.tileSize, static_cast<uint32_t>(srcHeight));
-            uint32_t tileActualWidth = tileEndX - tileStartX;
-            uint32_t tileActualHeight = tileEndY - tileStartY;
-            
-            // Allocate physical page
-            uint32_t physicalPageIndex = AllocatePhysicalPage();
-            if (physicalPageIndex == UINT32_MAX) {
-                std::cerr << "    ✗ Out of physical memory for tile " << tile.tileX << "," << tile.tileY << std::endl;
-                return false;
-            }
-            
-            // Note: We no longer use UpdateTileMappings since we're uploading directly to physical cache texture
-            // instead of using tiled resources
-            
-            // Prepare tile data (convert to RGBA and pad to tile size)
-            std::vector<BYTE> tileData(m_config.tileSize * m_config.tileSize * 4, 0);
-            
-            for (uint32_t y = 0; y < tileActualHeight; ++y) {
-                for (uint32_t x = 0; x < tileActualWidth; ++x) {
-                    uint32_t srcX = tileStartX + x;
-                    uint32_t srcY = tileStartY + y;
-                    
-                    // Boundary check
-                    if (srcX >= static_cast<uint32_t>(srcWidth) || srcY >= static_cast<uint32_t>(srcHeight)) {
-                        continue;
-                    }
-                    
-                    size_t srcIdx = static_cast<size_t>(srcY * srcWidth + srcX) * srcChannels;
-                    size_t dstIdx = static_cast<size_t>(y * m_config.tileSize + x) * 4;
-                    
-                    // Extra safety check
-                    if (srcIdx + srcChannels > srcDataSize) {
-                        continue;
-                    }
-                    
-                    if (srcChannels >= 3) {
-                        tileData[dstIdx + 0] = srcData[srcIdx + 0];
-                        tileData[dstIdx + 1] = srcData[srcIdx + 1];
-                        tileData[dstIdx + 2] = srcData[srcIdx + 2];
-                        tileData[dstIdx + 3] = (srcChannels == 4) ? srcData[srcIdx + 3] : 255;
-                    } else if (srcChannels == 1) {
-                        tileData[dstIdx + 0] = srcData[srcIdx];
-                        tileData[dstIdx + 1] = srcData[srcIdx];
-                        tileData[dstIdx + 2] = srcData[srcIdx];
-                        tileData[dstIdx + 3] = 255;
-                    }
-                }
-            }
-            
-            // DEBUG: Check tile data for first tile
-            if (texIdx == 0 && tile.tileX == 0 && tile.tileY == 0) {
-                uint32_t nonBlackPixels = 0;
-                for (size_t i = 0; i < tileData.size(); i += 4) {
-                    if (tileData[i] > 10 || tileData[i+1] > 10 || tileData[i+2] > 10) {
-                        nonBlackPixels++;
-                    }
-                }
-                std::cout << "    DEBUG: Texture 0 Tile[0,0] has " << nonBlackPixels << "/" << (tileData.size()/4) 
-                          << " non-black pixels, first pixel=(" << (int)tileData[0] << "," << (int)tileData[1] << "," << (int)tileData[2] << ")" << std::endl;
-            }
-            
-            // Upload tile data using UpdateSubresources
-            D3D12_SUBRESOURCE_DATA subresourceData = {};
-            subresourceData.pData = tileData.data();
-            subresourceData.RowPitch = m_config.tileSize * 4;
-            subresourceData.SlicePitch = subresourceData.RowPitch * m_config.tileSize;
-            
-            // Create temporary upload buffer
-            CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
-            auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(tileData.size());
-            
-            Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer;
-            HRESULT hr = m_device->CreateCommittedResource(
-                &uploadHeapProps,
-                D3D12_HEAP_FLAG_NONE,
-                &uploadBufferDesc,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&uploadBuffer)
-            );
-            
-            if (FAILED(hr)) {
-                std::cerr << "    ✗ Failed to create upload buffer for tile " << tile.tileX << "," << tile.tileY << std::endl;
-                FreePhysicalPage(physicalPageIndex);
-                continue;
-            }
-            
-            // Keep upload buffer alive until GPU finishes reading it
-            m_uploadBuffers.push_back(uploadBuffer);
-            
-            // Copy data to upload buffer
-            BYTE* pMappedData = nullptr;
-            CD3DX12_RANGE readRange(0, 0); // We're not reading from this buffer
-            hr = uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pMappedData));
-            if (FAILED(hr)) {
-                std::cerr << "    ✗ Failed to map upload buffer for tile " << tile.tileX << "," << tile.tileY << std::endl;
-                FreePhysicalPage(physicalPageIndex);
+        // Levels are keyed by their size in the disk cache; mips are only generated on a miss
+        bool compressed = false;
+        for (uint32_t level = 0; level < metadata.numMipLevels; ++level) {
+            auto& mip = metadata.mips[level];
+            if (TextureCompressor::LoadCached(sourceTexture->GetSourcePath(), PHYSICAL_CACHE_FORMAT, mip.width, mip.height, 1, mip.compressedBlocks)) {
                 continue;
             }
-            
-            memcpy(pMappedData, tileData.data(), tileData.size());
-            uploadBuffer->Unmap(0, nullptr);
-            
-            // Use CopyTextureRegion for tiled resources
-            D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
-            srcLocation.pResource = uploadBuffer.Get();
-            srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-            srcLocation.PlacedFootprint.Offset = 0;
-            srcLocation.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-            srcLocation.PlacedFootprint.Footprint.Width = m_config.tileSize;
-            srcLocation.PlacedFootprint.Footprint.Height = m_config.tileSize;
-            srcLocation.PlacedFootprint.Footprint.Depth = 1;
-            srcLocation.PlacedFootprint.Footprint.RowPitch = m_config.tileSize * 4;
-            
-            D3D12_TEXTURE_COPY_LOCATION dstLocation = {};
-            dstLocation.pResource = m_physicalCacheTexture.Get();  // Upload to physical cache, not virtual texture
-            dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-            dstLocation.SubresourceIndex = 0;  // Physical cache is a single 2D texture
-            
-            D3D12_BOX srcBox = {};
-            srcBox.left = 0;
-            srcBox.top = 0;
-            srcBox.right = tileActualWidth;
-            srcBox.bottom = tileActualHeight;
-            srcBox.front = 0;
-            srcBox.back = 1;
-            
-            // Calculate destination position in physical cache
-            const uint32_t CACHE_TILES_PER_ROW = 48;  // Must match shader and initialization
-            uint32_t pageX = physicalPageIndex % CACHE_TILES_PER_ROW;
-            uint32_t pageY = physicalPageIndex / CACHE_TILES_PER_ROW;
-            uint32_t dstX = pageX * m_config.tileSize;
-            uint32_t dstY = pageY * m_config.tileSize;
-            
-            batchCmdList->CopyTextureRegion(&dstLocation, dstX, dstY, 0, &srcLocation, &srcBox);
-            
-            // Update metadata
-            tile.isResident = true;
-            tile.physicalPageIndex = physicalPageIndex;
-            
-            m_physicalPages[physicalPageIndex].isAllocated = true;
-            m_physicalPages[physicalPageIndex].virtualTextureIndex = texIdx;
-            m_physicalPages[physicalPageIndex].mipLevel = tile.mipLevel;
-            m_physicalPages[physicalPageIndex].tileX = tile.tileX;
-            m_physicalPages[physicalPageIndex].tileY = tile.tileY;
-            
-            totalTilesUploaded++;
-            
-            // Execute batch and wait for GPU to finish before releasing upload buffers
-            if (totalTilesUploaded % MAX_TILES_PER_BATCH == 0) {
-                std::cout << "  Progress: " << totalTilesUploaded << " tiles uploaded, executing batch..." << std::endl;
-                
-                // Close and execute command list
-                batchCmdList->Close();
-                ID3D12CommandList* cmdLists[] = { batchCmdList.Get() };
-                commandQueue->ExecuteCommandLists(1, cmdLists);
-                
-                // Wait for GPU to finish
-                commandQueue->Signal(fence.Get(), ++fenceValue);
-                if (fence->GetCompletedValue() < fenceValue) {
-                    fence->SetEventOnCompletion(fenceValue, fenceEvent);
-                    WaitForSingleObject(fenceEvent, INFINITE);
-                }
-                
-                // Now safe to release upload buffers
-                m_uploadBuffers.clear();
-                texturesInCurrentBatch.clear();
-                
-                // Reset for next batch
-                batchAllocator->Reset();
-                batchCmdList->Reset(batchAllocator.Get(), nullptr);
-                
-                // Physical cache stays in COPY_DEST state, no need to transition again
+            if (sourceTexture->GetMipLevels() <= static_cast<int>(level)) {
+                sourceTexture->GenerateAdaptiveMipmaps();
             }
+            mip.compressedBlocks = TextureCompressor::Compress(PHYSICAL_CACHE_FORMAT, sourceTexture->GetMipData(level),
+                                                               mip.width, mip.height, srcChannels, false);
+            TextureCompressor::StoreCached(sourceTexture->GetSourcePath(), PHYSICAL_CACHE_FORMAT, mip.width, mip.height, 1, mip.compressedBlocks);
+            compressed = true;
+        }
+        if (compressed) {
+            compressedCount++;
         }
         
+        // Average color from a sparse grid of samples (grayscale expanded like the encoder)
+        const uint32_t step = std::max(1u, std::max(srcWidth, srcHeight) / 64);
+        double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+        size_t samples = 0;
+        for (uint32_t y = 0; y < srcHeight; y += step) {
+            for (uint32_t x = 0; x < srcWidth; x += step) {
+                const unsigned char* px = srcData + (static_cast<size_t>(y) * srcWidth + x) * srcChannels;
+                sum[0] += px[0];
+                sum[1] += srcChannels >= 3 ? px[1] : px[0];
+                sum[2] += srcChannels >= 3 ? px[2] : px[0];
+                sum[3] += srcChannels == 4 ? px[3] : (srcChannels == 2 ? px[1] : 255);
+                samples++;
+            }
+        }
+        for (int c = 0; c < 4; ++c) {
+            metadata.fallbackColor[c] = static_cast<float>(sum[c] / (samples * 255.0));
+        }
+    });
+    std::cout << "  Compressed " << compressedCount << " textures, "
+              << (m_virtualTextureMetadata.size() - compressedCount) << " from cache" << std::endl;
+    
+    if (!m_uploadRing || !m_uploadRing->IsInitialized()) {
+        std::cerr << "  ✗ No upload ring for tile uploads" << std::endl;
+        return false;
     }
     
-    // Always transition physical cache back to PIXEL_SHADER_RESOURCE at the end
-    std::cout << "  Finalizing physical cache state..." << std::endl;
+    // Create our own command allocators and list for batched uploads. Two allocators alternate,
+    // so the next flush is recorded while the GPU still copies the previous one
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> batchAllocators[2];
+    UINT64 allocatorFences[2] = { 0, 0 };
+    uint32_t currentAllocator = 0;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> batchCmdList;
     
-    // Check if command list is already closed (from last batch)
-    // If uploadBuffers is empty, we need to reset and create a new command list for the final barrier
-    if (m_uploadBuffers.empty()) {
-        batchAllocator->Reset();
-        batchCmdList->Reset(batchAllocator.Get(), nullptr);
+    HRESULT hr = S_OK;
+    for (auto& allocator : batchAllocators) {
+        hr = m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator));
+        if (FAILED(hr)) {
+            std::cerr << "  ✗ Failed to create command allocator for upload" << std::endl;
+            return false;
+        }
     }
     
-    // Transition physical cache to NON_PIXEL_SHADER_RESOURCE for DXR compute pipeline
-    D3D12_RESOURCE_BARRIER cacheBarrierFinal = {};
-    cacheBarrierFinal.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    cacheBarrierFinal.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    cacheBarrierFinal.Transition.pResource = m_physicalCacheTexture.Get();
-    cacheBarrierFinal.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-    cacheBarrierFinal.Transition.StateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-    cacheBarrierFinal.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    batchCmdList->ResourceBarrier(1, &cacheBarrierFinal);
-    
-    batchCmdList->Close();
-    ID3D12CommandList* cmdLists[] = { batchCmdList.Get() };
-    commandQueue->ExecuteCommandLists(1, cmdLists);
+    hr = m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, batchAllocators[0].Get(), nullptr, IID_PPV_ARGS(&batchCmdList));
+    if (FAILED(hr)) {
+        std::cerr << "  ✗ Failed to create command list for upload" << std::endl;
+        return false;
+    }
     
-    commandQueue->Signal(fence.Get(), ++fenceValue);
-    if (fence->GetCompletedValue() < fenceValue) {
-        fence->SetEventOnCompletion(fenceValue, fenceEvent);
-        WaitForSingleObject(fenceEvent, INFINITE);
+    // Physical cache is created in COPY_DEST. Prefill coarsest levels first, so every texture
+    // gets a low-resolution page before any texture gets full detail. Nothing has been requested
+    // yet, so no page is evicted here (all share LRU frame 0)
+    std::vector<std::pair<uint32_t, uint32_t>> prefillOrder;  // (depth from coarsest level, texture)
+    for (uint32_t texIdx = 0; texIdx < m_virtualTextureMetadata.size(); ++texIdx) {
+        for (uint32_t depth = 0; depth < m_virtualTextureMetadata[texIdx].numMipLevels; ++depth) {
+            prefillOrder.emplace_back(depth, texIdx);
+        }
     }
+    std::sort(prefillOrder.begin(), prefillOrder.end());
+    
+    // A flush stages at most half the ring, so staging never waits on its own unsubmitted tiles
+    const UINT64 tileBytes = TextureCompressor::GetCompressedSize(PHYSICAL_CACHE_FORMAT, m_config.tileSize, m_config.tileSize);
+    const uint32_t tilesPerFlush = static_cast<uint32_t>(std::max<UINT64>(1, m_uploadRing->GetCapacity() / (2 * tileBytes)));
+    m_streamingUploadUsed = 0;
     
-    m_uploadBuffers.clear();
+    size_t totalTilesUploaded = 0;
+    for (const auto& entry : prefillOrder) {
+        const uint32_t texIdx = entry.second;
+        const auto& metadata = m_virtualTextureMetadata[texIdx];
+        const auto& mip = metadata.mips[metadata.numMipLevels - 1 - entry.first];
+        
+        for (uint32_t i = 0; i < mip.numTilesX * mip.numTilesY && !m_freePhysicalPages.empty(); ++i) {
+            const auto& tile = metadata.tiles[mip.firstTile + i];
+            
+            // Flush without waiting; only the other allocator's previous flush must be done
+            if (m_streamingUploadUsed >= tilesPerFlush) {
+                batchCmdList->Close();
+                ID3D12CommandList* lists[] = { batchCmdList.Get() };
+                commandQueue->ExecuteCommandLists(1, lists);
+                allocatorFences[currentAllocator] = m_uploadRing->Submit(commandQueue);
+                currentAllocator ^= 1;
+                m_uploadRing->WaitForSubmission(allocatorFences[currentAllocator]);
+                batchAllocators[currentAllocator]->Reset();
+                batchCmdList->Reset(batchAllocators[currentAllocator].Get(), nullptr);
+                m_streamingUploadUsed = 0;
+                ACG_LOG_DEBUG("  Progress: " << totalTilesUploaded << " tiles uploaded");
+            }
+            
+            if (MakeTileResident(batchCmdList.Get(), texIdx, tile.mipLevel, tile.tileX, tile.tileY) == TileResidency::Resident) {
+                totalTilesUploaded++;
+            }
+        }
+        if (m_freePhysicalPages.empty()) {
+            break;
+        }
+    }
     
-    CloseHandle(fenceEvent);
+    // Transition physical cache to NON_PIXEL_SHADER_RESOURCE for DXR compute pipeline
+    auto cacheBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_physicalCacheTexture.Get(),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+    );
+    batchCmdList->ResourceBarrier(1, &cacheBarrier);
+    batchCmdList->Close();
+    ExecuteAndWait(commandQueue, batchCmdList.Get());
+    m_streamingUploadUsed = 0;
     
-    std::cout << "[Virtual Texture] ✓ All tiles uploaded successfully (" << totalTilesUploaded << " total)" << std::endl;
+    std::cout << "[Virtual Texture] ✓ Prefilled " << totalTilesUploaded << "/" << m_totalTiles << " tiles";
+    if (totalTilesUploaded < m_totalTiles) {
+        std::cout << " (" << (m_totalTiles - totalTilesUploaded) << " stream in on demand)";
+    }
+    std::cout << std::endl;
     return true;
 }
 
 bool VirtualTextureSystem::CreateIndirectionTexture(ID3D12GraphicsCommandList* cmdList, ID3D12CommandQueue* commandQueue) {
-    // Indirection texture: stores physical page index for each virtual tile
-    // Size: max texture tiles across all textures
-    uint32_t maxTilesX = 0;
-    uint32_t maxTilesY = 0;
-    
-    for (const auto& metadata : m_virtualTextureMetadata) {
-        maxTilesX = std::max(maxTilesX, metadata.numTilesX);
-        maxTilesY = std::max(maxTilesY, metadata.numTilesY);
-    }
-    
-    if (maxTilesX == 0 || maxTilesY == 0) {
+    // Indirection buffer: stores physical page index for each virtual tile of every level,
+    // in the same order as the feedback buffer (layout computed by UploadAllTiles).
+    // A flat buffer instead of a Texture2DArray, since per-texture mip chains differ in tile counts
+    if (m_indirectionData.empty()) {
         return false;
     }
     
-    std::cout << "[Virtual Texture] Creating indirection texture: " << maxTilesX << "x" << maxTilesY << std::endl;
+    std::cout << "[Virtual Texture] Creating indirection buffer: " << m_totalTiles << " tiles" << std::endl;
     
     // Create our own command allocator and list for upload
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> uploadAllocator;
@@ -568,147 +495,310 @@ bool VirtualTextureSystem::CreateIndirectionTexture(ID3D12GraphicsCommandList* c
         return false;
     }
     
-    // Create indirection texture (R32_UINT format to store page indices)
-    D3D12_RESOURCE_DESC indirectionDesc = {};
-    indirectionDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    indirectionDesc.Width = maxTilesX;
-    indirectionDesc.Height = maxTilesY;
-    indirectionDesc.DepthOrArraySize = static_cast<UINT16>(m_virtualTextureMetadata.size());
-    indirectionDesc.MipLevels = 1;
-    indirectionDesc.Format = DXGI_FORMAT_R32_UINT;
-    indirectionDesc.SampleDesc.Count = 1;
-    indirectionDesc.SampleDesc.Quality = 0;
-    indirectionDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-    indirectionDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-    
+    // Create indirection buffer (R32_UINT page indices)
+    const UINT64 bufferSize = m_indirectionData.size() * sizeof(uint32_t);
     CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    auto indirectionDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
     hr = m_device->CreateCommittedResource(
         &defaultHeapProps,
         D3D12_HEAP_FLAG_NONE,
         &indirectionDesc,
         D3D12_RESOURCE_STATE_COPY_DEST,
         nullptr,
-        IID_PPV_ARGS(&m_indirectionTexture)
+        IID_PPV_ARGS(&m_indirectionBuffer)
     );
     
     if (FAILED(hr)) {
-        std::cerr << "[Virtual Texture] ✗ Failed to create indirection texture" << std::endl;
+        std::cerr << "[Virtual Texture] ✗ Failed to create indirection buffer" << std::endl;
         return false;
     }
     
-    // Upload indirection data
-    // Need to align row pitch to 256 bytes for DX12
-    UINT rowPitchBytes = maxTilesX * sizeof(uint32_t);
-    UINT alignedRowPitch = (rowPitchBytes + 255) & ~255;
-    UINT alignedRowPitchInUints = alignedRowPitch / sizeof(uint32_t);
+    // DEBUG: Print first texture's indirection data
+    const auto& firstMetadata = m_virtualTextureMetadata[0];
+    ACG_LOG_TRACE("[Virtual Texture] Indirection data for texture 0:");
+    for (uint32_t y = 0; y < std::min(3u, firstMetadata.numTilesY); ++y) {
+        for (uint32_t x = 0; x < std::min(3u, firstMetadata.numTilesX); ++x) {
+            const uint32_t page = m_indirectionData[y * firstMetadata.numTilesX + x];
+            ACG_LOG_TRACE("  Tile[" << x << "," << y << "] = page " << page << (page == UINT32_MAX ? " (NOT RESIDENT)" : ""));
+        }
+    }
     
-    std::vector<uint32_t> indirectionData(alignedRowPitchInUints * maxTilesY * m_virtualTextureMetadata.size(), UINT32_MAX);
+    // Upload everything once; the buffer is created in COPY_DEST, so the update helper
+    // is recorded without its leading transition
+    m_indirectionDirtyBegin = 0;
+    m_indirectionDirtyEnd = m_totalTiles;
+    RecordIndirectionUpdate(uploadCmdList.Get(), false);
+    if (m_indirectionDirtyBegin != m_indirectionDirtyEnd) {
+        std::cerr << "[Virtual Texture] ✗ Indirection buffer does not fit in the upload ring" << std::endl;
+        return false;
+    }
     
-    for (size_t texIdx = 0; texIdx < m_virtualTextureMetadata.size(); ++texIdx) {
-        const auto& metadata = m_virtualTextureMetadata[texIdx];
-        size_t layerOffset = texIdx * alignedRowPitchInUints * maxTilesY;  // Use aligned pitch
-        
-        for (const auto& tile : metadata.tiles) {
-            if (tile.isResident) {
-                size_t idx = layerOffset + tile.tileY * alignedRowPitchInUints + tile.tileX;  // Use aligned pitch
-                indirectionData[idx] = tile.physicalPageIndex;
-            }
-        }
-        
-        // DEBUG: Print first texture's indirection data
-        if (texIdx == 0) {
-            std::cout << "[Virtual Texture] Indirection data for texture 0:" << std::endl;
-            for (uint32_t y = 0; y < std::min(3u, metadata.numTilesY); ++y) {
-                for (uint32_t x = 0; x < std::min(3u, metadata.numTilesX); ++x) {
-                    size_t idx = layerOffset + y * alignedRowPitchInUints + x;
-                    std::cout << "  Tile[" << x << "," << y << "] = page " << indirectionData[idx];
-                    if (indirectionData[idx] == UINT32_MAX) {
-                        std::cout << " (NOT RESIDENT)";
-                    }
-                    std::cout << std::endl;
-                }
-            }
-        }
+    // Execute and wait for GPU
+    uploadCmdList->Close();
+    ExecuteAndWait(commandQueue, uploadCmdList.Get());
+    
+    std::cout << "[Virtual Texture] ✓ Indirection buffer created" << std::endl;
+    return true;
+}
+
+bool VirtualTextureSystem::CreateFeedbackResources(ID3D12CommandQueue* commandQueue) {
+    const UINT64 feedbackSize = static_cast<UINT64>(m_totalTiles) * sizeof(uint32_t);
+    if (feedbackSize == 0) {
+        return false;
     }
     
-    // Create upload buffer
+    std::cout << "[Virtual Texture] Creating feedback buffer: " << m_totalTiles << " tiles ("
+              << (feedbackSize / 1024) << " KB)" << std::endl;
+    
+    // Feedback UAV (written by ClosestHit, one uint per virtual tile)
+    CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    auto feedbackDesc = CD3DX12_RESOURCE_DESC::Buffer(feedbackSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    HRESULT hr = m_device->CreateCommittedResource(
+        &defaultHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &feedbackDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_feedbackBuffer)
+    );
+    if (FAILED(hr)) {
+        std::cerr << "[Virtual Texture] ✗ Failed to create feedback buffer" << std::endl;
+        return false;
+    }
+    m_feedbackBuffer->SetName(L"Virtual Texture Feedback");
+    
+    // Readback copy of the last batch's requests
+    CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(feedbackSize);
+    hr = m_device->CreateCommittedResource(
+        &readbackHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_feedbackReadback)
+    );
+    if (FAILED(hr)) {
+        std::cerr << "[Virtual Texture] ✗ Failed to create feedback readback buffer" << std::endl;
+        return false;
+    }
+    
+    // Zeros to reset the feedback buffer after every readback (avoids a clear that needs a CPU descriptor)
     CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
-    auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(indirectionData.size() * sizeof(uint32_t));
+    hr = m_device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_feedbackClearBuffer)
+    );
+    if (FAILED(hr)) {
+        std::cerr << "[Virtual Texture] ✗ Failed to create feedback clear buffer" << std::endl;
+        return false;
+    }
     
-    Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer;
+    // Per-texture layout read by SampleVirtualTexture (small, read straight from the upload heap)
+    auto infoDesc = CD3DX12_RESOURCE_DESC::Buffer(m_virtualTextureMetadata.size() * sizeof(GPUTextureInfo));
     hr = m_device->CreateCommittedResource(
         &uploadHeapProps,
         D3D12_HEAP_FLAG_NONE,
-        &uploadBufferDesc,
+        &infoDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&uploadBuffer)
+        IID_PPV_ARGS(&m_textureInfoBuffer)
     );
+    if (FAILED(hr)) {
+        std::cerr << "[Virtual Texture] ✗ Failed to create texture info buffer" << std::endl;
+        return false;
+    }
     
-    if (SUCCEEDED(hr)) {
-        // Map upload buffer and copy data
-        BYTE* pMappedData = nullptr;
-        CD3DX12_RANGE readRange(0, 0);
-        hr = uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pMappedData));
-        if (SUCCEEDED(hr)) {
-            memcpy(pMappedData, indirectionData.data(), indirectionData.size() * sizeof(uint32_t));
-            uploadBuffer->Unmap(0, nullptr);
-            
-            // Copy each array slice separately
-            for (UINT slice = 0; slice < m_virtualTextureMetadata.size(); ++slice) {
-                // Calculate aligned row pitch (must be 256-byte aligned for DX12)
-                UINT rowPitchBytes = maxTilesX * sizeof(uint32_t);
-                UINT alignedRowPitch = (rowPitchBytes + 255) & ~255;  // Round up to 256-byte alignment
-                
-                D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
-                srcLocation.pResource = uploadBuffer.Get();
-                srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-                srcLocation.PlacedFootprint.Offset = slice * alignedRowPitch * maxTilesY;  // Use aligned pitch
-                srcLocation.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R32_UINT;
-                srcLocation.PlacedFootprint.Footprint.Width = maxTilesX;
-                srcLocation.PlacedFootprint.Footprint.Height = maxTilesY;
-                srcLocation.PlacedFootprint.Footprint.Depth = 1;
-                srcLocation.PlacedFootprint.Footprint.RowPitch = alignedRowPitch;
-                
-                D3D12_TEXTURE_COPY_LOCATION dstLocation = {};
-                dstLocation.pResource = m_indirectionTexture.Get();
-                dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-                dstLocation.SubresourceIndex = slice;
-                
-                uploadCmdList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
-            }
-            
-            // Transition to NON_PIXEL_SHADER_RESOURCE for DXR compute pipeline
-            auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-                m_indirectionTexture.Get(),
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
-            );
-            uploadCmdList->ResourceBarrier(1, &barrier);
-            
-            // Execute and wait for GPU
-            uploadCmdList->Close();
-            ID3D12CommandList* cmdLists[] = { uploadCmdList.Get() };
-            commandQueue->ExecuteCommandLists(1, cmdLists);
-            
-            // Create fence and wait
-            Microsoft::WRL::ComPtr<ID3D12Fence> fence;
-            HANDLE fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-            m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
-            
-            commandQueue->Signal(fence.Get(), 1);
-            fence->SetEventOnCompletion(1, fenceEvent);
-            WaitForSingleObject(fenceEvent, INFINITE);
-            CloseHandle(fenceEvent);
-            
-            // Now safe to let upload buffer go out of scope
+    CD3DX12_RANGE readRange(0, 0);
+    void* mapped = nullptr;
+    if (SUCCEEDED(m_feedbackClearBuffer->Map(0, &readRange, &mapped))) {
+        memset(mapped, 0, static_cast<size_t>(feedbackSize));
+        m_feedbackClearBuffer->Unmap(0, nullptr);
+    }
+    if (SUCCEEDED(m_textureInfoBuffer->Map(0, &readRange, &mapped))) {
+        GPUTextureInfo* infos = static_cast<GPUTextureInfo*>(mapped);
+        for (size_t i = 0; i < m_virtualTextureMetadata.size(); ++i) {
+            const auto& metadata = m_virtualTextureMetadata[i];
+            infos[i].width = metadata.width;
+            infos[i].height = metadata.height;
+            infos[i].mipCount = metadata.numMipLevels;
+            infos[i].feedbackOffset = metadata.feedbackOffset;
+            memcpy(infos[i].fallbackColor, metadata.fallbackColor, sizeof(infos[i].fallbackColor));
         }
+        m_textureInfoBuffer->Unmap(0, nullptr);
     }
     
-    std::cout << "[Virtual Texture] ✓ Indirection texture created" << std::endl;
+    // Zero the feedback buffer and leave it in UNORDERED_ACCESS for the first dispatch
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> cmdList;
+    ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)));
+    ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&cmdList)));
+    cmdList->CopyResource(m_feedbackBuffer.Get(), m_feedbackClearBuffer.Get());
+    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_feedbackBuffer.Get(),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+    );
+    cmdList->ResourceBarrier(1, &barrier);
+    cmdList->Close();
+    ExecuteAndWait(commandQueue, cmdList.Get());
+    
+    m_feedbackPending = false;
+    m_feedbackFrame = 0;
+    m_pendingRequests.clear();
+    
+    std::cout << "[Virtual Texture] ✓ Feedback resources created" << std::endl;
     return true;
 }
 
+void VirtualTextureSystem::RecordFeedbackReadback(ID3D12GraphicsCommandList* cmdList) {
+    if (!m_feedbackBuffer) {
+        return;
+    }
+    
+    D3D12_RESOURCE_BARRIER toCopySource = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_feedbackBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    cmdList->ResourceBarrier(1, &toCopySource);
+    cmdList->CopyResource(m_feedbackReadback.Get(), m_feedbackBuffer.Get());
+    
+    // Clear for the next batch, so every readback holds exactly one batch's requests
+    D3D12_RESOURCE_BARRIER toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_feedbackBuffer.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+    cmdList->ResourceBarrier(1, &toCopyDest);
+    cmdList->CopyResource(m_feedbackBuffer.Get(), m_feedbackClearBuffer.Get());
+    
+    D3D12_RESOURCE_BARRIER toUav = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_feedbackBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    cmdList->ResourceBarrier(1, &toUav);
+    
+    m_feedbackPending = true;
+}
+
+uint32_t VirtualTextureSystem::UpdateStreaming(ID3D12GraphicsCommandList* cmdList) {
+    if (!m_feedbackPending) {
+        return 0;
+    }
+    m_feedbackPending = false;
+    
+    const size_t feedbackSize = static_cast<size_t>(m_totalTiles) * sizeof(uint32_t);
+    void* feedbackData = nullptr;
+    CD3DX12_RANGE readRange(0, feedbackSize);
+    if (FAILED(m_feedbackReadback->Map(0, &readRange, &feedbackData))) {
+        std::cerr << "[Virtual Texture] ✗ Failed to map feedback readback" << std::endl;
+        return 0;
+    }
+    ProcessFeedback(feedbackData, feedbackSize);
+    CD3DX12_RANGE writeRange(0, 0);
+    m_feedbackReadback->Unmap(0, &writeRange);
+    
+    if (m_pendingRequests.empty()) {
+        return 0;
+    }
+    
+    auto toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_physicalCacheTexture.Get(),
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+        D3D12_RESOURCE_STATE_COPY_DEST
+    );
+    cmdList->ResourceBarrier(1, &toCopyDest);
+    
+    // Per-update budget; the staging memory itself is reclaimed by the ring's fences
+    m_streamingUploadUsed = 0;
+    uint32_t uploaded = 0;
+    size_t processed = 0;
+    for (; processed < m_pendingRequests.size(); ++processed) {
+        if (uploaded >= m_config.maxTileUploadsPerUpdate) {
+            break;
+        }
+        const uint32_t globalTile = m_pendingRequests[processed];
+        // Textures are ordered by feedbackOffset: find the last one starting at or before globalTile
+        auto it = std::upper_bound(m_virtualTextureMetadata.begin(), m_virtualTextureMetadata.end(), globalTile,
+            [](uint32_t value, const VirtualTextureMetadata& metadata) { return value < metadata.feedbackOffset; });
+        uint32_t texIdx = static_cast<uint32_t>(std::distance(m_virtualTextureMetadata.begin(), it) - 1);
+        const auto& tile = m_virtualTextureMetadata[texIdx].tiles[globalTile - it[-1].feedbackOffset];
+        
+        const TileResidency residency = MakeTileResident(cmdList, texIdx, tile.mipLevel, tile.tileX, tile.tileY);
+        if (residency == TileResidency::OutOfSpace) {
+            break;  // Upload ring full or every page is in use by this batch
+        }
+        if (residency == TileResidency::Resident) {
+            uploaded++;
+        }
+        // Invalid requests are dropped so they cannot hold back the ones behind them
+    }
+    m_pendingRequests.erase(m_pendingRequests.begin(), m_pendingRequests.begin() + processed);
+    
+    auto toShaderResource = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_physicalCacheTexture.Get(),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+    );
+    cmdList->ResourceBarrier(1, &toShaderResource);
+    
+    RecordIndirectionUpdate(cmdList, true);
+    
+    ACG_LOG_DEBUG("[Virtual Texture] Streamed " << uploaded << " tiles ("
+                  << m_pendingRequests.size() << " still pending, "
+                  << (m_physicalPages.size() - m_freePhysicalPages.size()) << "/" << m_physicalPages.size()
+                  << " pages in use)");
+    return uploaded;
+}
+
+void VirtualTextureSystem::SetIndirectionEntry(uint32_t virtualTextureIndex, uint32_t tileIndex, uint32_t pageIndex) {
+    if (m_indirectionData.empty()) {
+        return;
+    }
+    uint32_t idx = m_virtualTextureMetadata[virtualTextureIndex].feedbackOffset + tileIndex;
+    m_indirectionData[idx] = pageIndex;
+    if (m_indirectionDirtyBegin == m_indirectionDirtyEnd) {
+        m_indirectionDirtyBegin = idx;
+        m_indirectionDirtyEnd = idx + 1;
+    } else {
+        m_indirectionDirtyBegin = std::min(m_indirectionDirtyBegin, idx);
+        m_indirectionDirtyEnd = std::max(m_indirectionDirtyEnd, idx + 1);
+    }
+}
+
+void VirtualTextureSystem::RecordIndirectionUpdate(ID3D12GraphicsCommandList* cmdList, bool transition) {
+    if (!m_indirectionBuffer || !m_uploadRing || m_indirectionDirtyBegin == m_indirectionDirtyEnd) {
+        return;
+    }
+    
+    // Only the changed range is staged and copied; if the ring is full the range stays dirty
+    // and goes out with the next update
+    const size_t offset = static_cast<size_t>(m_indirectionDirtyBegin) * sizeof(uint32_t);
+    const size_t size = static_cast<size_t>(m_indirectionDirtyEnd - m_indirectionDirtyBegin) * sizeof(uint32_t);
+    UploadRing::Allocation staging = m_uploadRing->Allocate(size, sizeof(uint32_t));
+    if (!staging) {
+        return;
+    }
+    memcpy(staging.cpuAddress, m_indirectionData.data() + m_indirectionDirtyBegin, size);
+    m_indirectionDirtyBegin = m_indirectionDirtyEnd = 0;
+    
+    if (transition) {
+        auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            m_indirectionBuffer.Get(),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_COPY_DEST
+        );
+        cmdList->ResourceBarrier(1, &barrier);
+    }
+    
+    cmdList->CopyBufferRegion(m_indirectionBuffer.Get(), offset, staging.resource, staging.offset, size);
+    
+    // Transition to NON_PIXEL_SHADER_RESOURCE for DXR compute pipeline
+    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+        m_indirectionBuffer.Get(),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+    );
+    cmdList->ResourceBarrier(1, &barrier);
+}
+
 uint32_t VirtualTextureSystem::CalculateNumTiles(uint32_t dimension, uint32_t tileSize) const {
     return (dimension + tileSize - 1) / tileSize;
 }
@@ -721,7 +811,7 @@ uint32_t VirtualTextureSystem::AllocatePhysicalPage() {
             if (page.isAllocated) allocatedPages++;
         }
         std::cerr << "[Virtual Texture] ✗ Out of physical pages: " 
-                  << allocatedPages << "/" << m_config.maxPhysicalPages << " allocated" << std::endl;
+                  << allocatedPages << "/" << m_physicalPages.size() << " allocated" << std::endl;
         return UINT32_MAX;
     }
     
@@ -737,57 +827,111 @@ void VirtualTextureSystem::FreePhysicalPage(uint32_t pageIndex) {
     }
 }
 
-bool VirtualTextureSystem::MakeTileResident(ID3D12CommandQueue* commandQueue,
-                                            uint32_t virtualTextureIndex,
-                                            uint32_t mipLevel,
-                                            uint32_t tileX,
-                                            uint32_t tileY) {
-    if (virtualTextureIndex >= m_virtualTextures.size()) {
-        return false;
+uint32_t VirtualTextureSystem::EvictLeastRecentlyUsedPage() {
+    // Pages requested by the feedback being processed are never evicted
+    uint32_t victim = UINT32_MAX;
+    uint64_t oldestFrame = m_feedbackFrame;
+    for (uint32_t i = 0; i < m_physicalPages.size(); ++i) {
+        const auto& page = m_physicalPages[i];
+        if (page.isAllocated && page.lastUsedFrame < oldestFrame) {
+            oldestFrame = page.lastUsedFrame;
+            victim = i;
+        }
+    }
+    if (victim == UINT32_MAX) {
+        return UINT32_MAX;
     }
     
-    // Allocate physical page
-    uint32_t physicalPageIndex = AllocatePhysicalPage();
-    if (physicalPageIndex == UINT32_MAX) {
-        return false;
+    const auto& page = m_physicalPages[victim];
+    EvictTile(page.virtualTextureIndex, page.mipLevel, page.tileX, page.tileY);
+    return AllocatePhysicalPage();
+}
+
+VirtualTextureSystem::TileResidency VirtualTextureSystem::MakeTileResident(ID3D12GraphicsCommandList* cmdList,
+                                                                           uint32_t virtualTextureIndex,
+                                                                           uint32_t mipLevel,
+                                                                           uint32_t tileX,
+                                                                           uint32_t tileY) {
+    if (virtualTextureIndex >= m_virtualTextures.size()) {
+        return TileResidency::Invalid;
     }
     
     auto& metadata = m_virtualTextureMetadata[virtualTextureIndex];
-    uint32_t tileIndex = tileY * metadata.numTilesX + tileX;
+    if (mipLevel >= metadata.mips.size()) {
+        return TileResidency::Invalid;
+    }
+    const auto& mip = metadata.mips[mipLevel];
+    uint32_t tileIndex = mip.firstTile + tileY * mip.numTilesX + tileX;
     
-    if (tileIndex >= metadata.tiles.size()) {
-        FreePhysicalPage(physicalPageIndex);
-        return false;
+    if (tileX >= mip.numTilesX || tileY >= mip.numTilesY || mip.compressedBlocks.empty()) {
+        return TileResidency::Invalid;
     }
     
     auto& tile = metadata.tiles[tileIndex];
+    if (tile.isResident) {
+        return TileResidency::Resident;
+    }
     
-    // Map virtual tile to physical page using UpdateTileMappings
-    D3D12_TILED_RESOURCE_COORDINATE tileCoordinate = {};
-    tileCoordinate.X = tileX;
-    tileCoordinate.Y = tileY;
-    tileCoordinate.Z = 0;
-    tileCoordinate.Subresource = mipLevel;
-    
-    D3D12_TILE_REGION_SIZE tileRegionSize = {};
-    tileRegionSize.NumTiles = 1;
-    tileRegionSize.UseBox = FALSE;
-    
-    UINT heapRangeStartOffset = physicalPageIndex;
-    UINT rangeTileCount = 1;
-    
-    commandQueue->UpdateTileMappings(
-        m_virtualTextures[virtualTextureIndex].Get(),
-        1,
-        &tileCoordinate,
-        &tileRegionSize,
-        m_physicalMemoryHeap.Get(),
-        1,
-        nullptr, // Use default range flags
-        &heapRangeStartOffset,
-        &rangeTileCount,
-        D3D12_TILE_MAPPING_FLAG_NONE
-    );
+    if (!m_uploadRing) {
+        return TileResidency::OutOfSpace;
+    }
+    
+    // Stage the tile's block rows; tile edges fall on 4x4 block boundaries. Partial edge tiles
+    // replicate their last block column/row so bilinear filtering at the border stays in-texture
+    const uint32_t blockBytes = TextureCompressor::GetBlockBytes(PHYSICAL_CACHE_FORMAT);
+    const uint32_t textureRowPitch = TextureCompressor::GetRowPitch(PHYSICAL_CACHE_FORMAT, mip.width);
+    const uint32_t tileRowPitch = TextureCompressor::GetRowPitch(PHYSICAL_CACHE_FORMAT, m_config.tileSize);
+    const uint32_t tileBlocks = m_config.tileSize / 4;
+    const uint32_t textureBlocksWide = (mip.width + 3) / 4;
+    const uint32_t textureBlocksHigh = (mip.height + 3) / 4;
+    const uint32_t firstBlockX = tileX * tileBlocks;
+    const uint32_t firstBlockY = tileY * tileBlocks;
+    const uint32_t validBlocksWide = std::min(tileBlocks, textureBlocksWide - firstBlockX);
+    const uint32_t validBlocksHigh = std::min(tileBlocks, textureBlocksHigh - firstBlockY);
+    
+    // Staging first: a failed allocation must not evict a page
+    UploadRing::Allocation staging = m_uploadRing->Allocate(static_cast<UINT64>(tileRowPitch) * tileBlocks);
+    if (!staging) {
+        return TileResidency::OutOfSpace;
+    }
+    
+    // Allocate physical page, reusing the least recently used one when the cache is full
+    uint32_t physicalPageIndex = m_freePhysicalPages.empty() ? EvictLeastRecentlyUsedPage() : AllocatePhysicalPage();
+    if (physicalPageIndex == UINT32_MAX) {
+        return TileResidency::OutOfSpace;
+    }
+    
+    for (uint32_t blockY = 0; blockY < tileBlocks; ++blockY) {
+        const uint8_t* srcRow = mip.compressedBlocks.data() +
+            static_cast<size_t>(firstBlockY + std::min(blockY, validBlocksHigh - 1)) * textureRowPitch +
+            static_cast<size_t>(firstBlockX) * blockBytes;
+        uint8_t* dstRow = staging.cpuAddress + static_cast<size_t>(blockY) * tileRowPitch;
+        memcpy(dstRow, srcRow, static_cast<size_t>(validBlocksWide) * blockBytes);
+        for (uint32_t blockX = validBlocksWide; blockX < tileBlocks; ++blockX) {
+            memcpy(dstRow + blockX * blockBytes, srcRow + (validBlocksWide - 1) * blockBytes, blockBytes);
+        }
+    }
+    m_streamingUploadUsed++;
+    
+    D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
+    srcLocation.pResource = staging.resource;
+    srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    srcLocation.PlacedFootprint.Offset = staging.offset;
+    srcLocation.PlacedFootprint.Footprint.Format = TextureCompressor::GetDXGIFormat(PHYSICAL_CACHE_FORMAT);
+    srcLocation.PlacedFootprint.Footprint.Width = m_config.tileSize;
+    srcLocation.PlacedFootprint.Footprint.Height = m_config.tileSize;
+    srcLocation.PlacedFootprint.Footprint.Depth = 1;
+    srcLocation.PlacedFootprint.Footprint.RowPitch = tileRowPitch;
+    
+    D3D12_TEXTURE_COPY_LOCATION dstLocation = {};
+    dstLocation.pResource = m_physicalCacheTexture.Get();  // Upload to physical cache, not virtual texture
+    dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dstLocation.SubresourceIndex = 0;  // Physical cache is a single 2D texture
+    
+    // Calculate destination position in physical cache
+    uint32_t pageX = physicalPageIndex % CACHE_TILES_PER_ROW;
+    uint32_t pageY = physicalPageIndex / CACHE_TILES_PER_ROW;
+    cmdList->CopyTextureRegion(&dstLocation, pageX * m_config.tileSize, pageY * m_config.tileSize, 0, &srcLocation, nullptr);
     
     // Update metadata
     tile.isResident = true;
@@ -798,12 +942,13 @@ bool VirtualTextureSystem::MakeTileResident(ID3D12CommandQueue* commandQueue,
     m_physicalPages[physicalPageIndex].mipLevel = mipLevel;
     m_physicalPages[physicalPageIndex].tileX = tileX;
     m_physicalPages[physicalPageIndex].tileY = tileY;
+    m_physicalPages[physicalPageIndex].lastUsedFrame = m_feedbackFrame;
     
-    return true;
+    SetIndirectionEntry(virtualTextureIndex, tileIndex, physicalPageIndex);
+    return TileResidency::Resident;
 }
 
-void VirtualTextureSystem::EvictTile(ID3D12CommandQueue* commandQueue,
-                                    uint32_t virtualTextureIndex,
+void VirtualTextureSystem::EvictTile(uint32_t virtualTextureIndex,
                                     uint32_t mipLevel,
                                     uint32_t tileX,
                                     uint32_t tileY) {
@@ -812,11 +957,14 @@ void VirtualTextureSystem::EvictTile(ID3D12CommandQueue* commandQueue,
     }
     
     auto& metadata = m_virtualTextureMetadata[virtualTextureIndex];
-    uint32_t tileIndex = tileY * metadata.numTilesX + tileX;
-    
-    if (tileIndex >= metadata.tiles.size()) {
+    if (mipLevel >= metadata.mips.size()) {
+        return;
+    }
+    const auto& mip = metadata.mips[mipLevel];
+    if (tileX >= mip.numTilesX || tileY >= mip.numTilesY) {
         return;
     }
+    uint32_t tileIndex = mip.firstTile + tileY * mip.numTilesX + tileX;
     
     auto& tile = metadata.tiles[tileIndex];
     
@@ -824,32 +972,9 @@ void VirtualTextureSystem::EvictTile(ID3D12CommandQueue* commandQueue,
         return;
     }
     
-    // Unmap tile
-    D3D12_TILED_RESOURCE_COORDINATE tileCoordinate = {};
-    tileCoordinate.X = tileX;
-    tileCoordinate.Y = tileY;
-    tileCoordinate.Z = 0;
-    tileCoordinate.Subresource = mipLevel;
-    
-    D3D12_TILE_REGION_SIZE tileRegionSize = {};
-    tileRegionSize.NumTiles = 1;
-    tileRegionSize.UseBox = FALSE;
-    
-    commandQueue->UpdateTileMappings(
-        m_virtualTextures[virtualTextureIndex].Get(),
-        1,
-        &tileCoordinate,
-        &tileRegionSize,
-        nullptr, // Null heap unmaps the tile
-        0,
-        nullptr,
-        nullptr,
-        nullptr,
-        D3D12_TILE_MAPPING_FLAG_NONE
-    );
-    
-    // Free physical page
+    // Free physical page; the page content is simply overwritten by the next tile
     FreePhysicalPage(tile.physicalPageIndex);
+    SetIndirectionEntry(virtualTextureIndex, tileIndex, UINT32_MAX);
     
     tile.isResident = false;
     tile.physicalPageIndex = UINT32_MAX;
@@ -857,7 +982,9 @@ void VirtualTextureSystem::EvictTile(ID3D12CommandQueue* commandQueue,
 
 void VirtualTextureSystem::CreateShaderResourceView(ID3D12Device* device,
                                                     D3D12_CPU_DESCRIPTOR_HANDLE srvHandle,
-                                                    D3D12_CPU_DESCRIPTOR_HANDLE indirectionSrvHandle) {
+                                                    D3D12_CPU_DESCRIPTOR_HANDLE indirectionSrvHandle,
+                                                    D3D12_CPU_DESCRIPTOR_HANDLE textureInfoSrvHandle,
+                                                    D3D12_CPU_DESCRIPTOR_HANDLE feedbackUavHandle) {
     std::cout << "[VT] CreateShaderResourceView called" << std::endl;
     
     // Create SRV for physical cache texture
@@ -866,7 +993,7 @@ void VirtualTextureSystem::CreateShaderResourceView(ID3D12Device* device,
         
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
         srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        srvDesc.Format = TextureCompressor::GetDXGIFormat(PHYSICAL_CACHE_FORMAT);
         srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
         srvDesc.Texture2D.MostDetailedMip = 0;
         srvDesc.Texture2D.MipLevels = 1;
@@ -877,24 +1004,44 @@ void VirtualTextureSystem::CreateShaderResourceView(ID3D12Device* device,
         std::cerr << "[VT]   ✗ ERROR: Physical cache texture is NULL!" << std::endl;
     }
     
-    // Create SRV for indirection texture
-    if (m_indirectionTexture) {
+    // Create typed SRV for the indirection buffer (t6)
+    if (m_indirectionBuffer) {
         std::cout << "[VT]   Creating indirection SRV at descriptor " << indirectionSrvHandle.ptr 
-                  << " (264 slices)" << std::endl;
+                  << " (" << m_totalTiles << " entries)" << std::endl;
         
         D3D12_SHADER_RESOURCE_VIEW_DESC indirectionSrvDesc = {};
         indirectionSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
         indirectionSrvDesc.Format = DXGI_FORMAT_R32_UINT;
-        indirectionSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-        indirectionSrvDesc.Texture2DArray.MostDetailedMip = 0;
-        indirectionSrvDesc.Texture2DArray.MipLevels = 1;
-        indirectionSrvDesc.Texture2DArray.FirstArraySlice = 0;
-        indirectionSrvDesc.Texture2DArray.ArraySize = static_cast<UINT>(m_virtualTextureMetadata.size());
+        indirectionSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+        indirectionSrvDesc.Buffer.FirstElement = 0;
+        indirectionSrvDesc.Buffer.NumElements = m_totalTiles;
         
-        device->CreateShaderResourceView(m_indirectionTexture.Get(), &indirectionSrvDesc, indirectionSrvHandle);
+        device->CreateShaderResourceView(m_indirectionBuffer.Get(), &indirectionSrvDesc, indirectionSrvHandle);
         std::cout << "[VT]   ✓ Indirection SRV created" << std::endl;
     } else {
-        std::cerr << "[VT]   ✗ ERROR: Indirection texture is NULL!" << std::endl;
+        std::cerr << "[VT]   ✗ ERROR: Indirection buffer is NULL!" << std::endl;
+    }
+    
+    // Create SRV for per-texture info (t9) and UAV for tile requests (u1)
+    if (m_textureInfoBuffer && m_feedbackBuffer) {
+        D3D12_SHADER_RESOURCE_VIEW_DESC infoSrvDesc = {};
+        infoSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        infoSrvDesc.Format = DXGI_FORMAT_UNKNOWN;  // Structured buffer
+        infoSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+        infoSrvDesc.Buffer.FirstElement = 0;
+        infoSrvDesc.Buffer.NumElements = static_cast<UINT>(m_virtualTextureMetadata.size());
+        infoSrvDesc.Buffer.StructureByteStride = sizeof(GPUTextureInfo);
+        device->CreateShaderResourceView(m_textureInfoBuffer.Get(), &infoSrvDesc, textureInfoSrvHandle);
+        
+        D3D12_UNORDERED_ACCESS_VIEW_DESC feedbackUavDesc = {};
+        feedbackUavDesc.Format = DXGI_FORMAT_R32_UINT;
+        feedbackUavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+        feedbackUavDesc.Buffer.FirstElement = 0;
+        feedbackUavDesc.Buffer.NumElements = m_totalTiles;
+        device->CreateUnorderedAccessView(m_feedbackBuffer.Get(), nullptr, &feedbackUavDesc, feedbackUavHandle);
+        std::cout << "[VT]   ✓ Texture info SRV and feedback UAV created" << std::endl;
+    } else {
+        std::cerr << "[VT]   ✗ ERROR: Feedback resources are NULL!" << std::endl;
     }
     
     std::cout << "[VT] ✓ All VT SRVs created successfully" << std::endl;
@@ -903,14 +1050,17 @@ void VirtualTextureSystem::CreateShaderResourceView(ID3D12Device* device,
 VirtualTextureSystem::Statistics VirtualTextureSystem::GetStatistics() const {
     Statistics stats = {};
     stats.numVirtualTextures = static_cast<uint32_t>(m_virtualTextures.size());
-    stats.totalPhysicalPages = m_config.maxPhysicalPages;
-    stats.usedPhysicalPages = m_config.maxPhysicalPages - static_cast<uint32_t>(m_freePhysicalPages.size());
+    stats.totalPhysicalPages = static_cast<uint32_t>(m_physicalPages.size());
+    stats.usedPhysicalPages = stats.totalPhysicalPages - static_cast<uint32_t>(m_freePhysicalPages.size());
     
-    stats.physicalMemoryMB = (static_cast<uint64_t>(m_config.maxPhysicalPages) * 65536) / (1024 * 1024);
+    stats.physicalMemoryMB = (static_cast<uint64_t>(stats.totalPhysicalPages) *
+        TextureCompressor::GetCompressedSize(PHYSICAL_CACHE_FORMAT, m_config.tileSize, m_config.tileSize)) / (1024 * 1024);
     
     uint64_t totalVirtualMemBytes = 0;
     for (const auto& metadata : m_virtualTextureMetadata) {
-        totalVirtualMemBytes += static_cast<uint64_t>(metadata.width) * metadata.height * 4; // RGBA
+        for (const auto& mip : metadata.mips) {
+            totalVirtualMemBytes += TextureCompressor::GetCompressedSize(PHYSICAL_CACHE_FORMAT, mip.width, mip.height);
+        }
     }
     stats.totalVirtualMemoryMB = totalVirtualMemBytes / (1024 * 1024);
     
@@ -918,9 +1068,26 @@ VirtualTextureSystem::Statistics VirtualTextureSystem::GetStatistics() const {
 }
 
 void VirtualTextureSystem::ProcessFeedback(const void* feedbackData, size_t dataSize) {
-    // TODO: Implement feedback-driven streaming
-    // This would analyze which tiles are actually being rendered
-    // and prioritize loading those tiles
+    // Advance the LRU clock: pages touched now must survive this update's evictions
+    m_feedbackFrame++;
+    m_pendingRequests.clear();
+    
+    const uint32_t* requests = static_cast<const uint32_t*>(feedbackData);
+    const size_t numEntries = std::min(dataSize / sizeof(uint32_t), static_cast<size_t>(m_totalTiles));
+    for (const auto& metadata : m_virtualTextureMetadata) {
+        const size_t end = std::min(numEntries, static_cast<size_t>(metadata.feedbackOffset) + metadata.tiles.size());
+        for (size_t i = metadata.feedbackOffset; i < end; ++i) {
+            if (requests[i] == 0) {
+                continue;
+            }
+            const auto& tile = metadata.tiles[i - metadata.feedbackOffset];
+            if (tile.isResident) {
+                m_physicalPages[tile.physicalPageIndex].lastUsedFrame = m_feedbackFrame;
+            } else {
+                m_pendingRequests.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
 }
 
 VirtualTextureSystem::VirtualTextureInfo VirtualTextureSystem::GetTextureInfo(uint32_t virtualTextureIndex) const {
@@ -1,6 +1,8 @@
 ﻿#define WIN32_LEAN_AND_MEAN
 #define UNICODE
 #include <Windows.h>
+#include <shellapi.h>
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <string>
@@ -14,8 +16,10 @@
 #include <mutex>
 #include <memory>
 #include "Renderer.h"
+#include "BatchRenderer.h"
 #include "Camera.h"
 #include "Scene.h"
+#include "Logger.h"
 #include "LogRedirector.h"
 #include "GUI.h"
 #include "imgui.h"
@@ -37,26 +41,10 @@ static GUI::GUIState g_guiState;
 ACG::Renderer* g_pRenderer = nullptr;
 bool g_ImGuiInitialized = false;
 
-// Global log message storage
-std::vector<std::string> g_logMessages;
-std::ofstream g_logFile;
+// std::cout / std::cerr capture into ACG::Logger (file and Log Details window)
 ACG::LogRedirector* g_coutRedirector = nullptr;
 ACG::LogRedirector* g_cerrRedirector = nullptr;
 
-void AddLogMessage(const std::string& msg) {
-    g_logMessages.push_back(msg);
-    if (g_logFile.is_open()) {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        struct tm timeinfo;
-        localtime_s(&timeinfo, &time_t);
-        char timeStr[100];
-        strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
-        g_logFile << "[" << timeStr << "] " << msg << std::endl;
-        g_logFile.flush();
-    }
-}
-
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -88,6 +76,72 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
 }
 
+static std::string WideToUtf8(const wchar_t* text) {
+    int sizeNeeded = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    std::string result(sizeNeeded, 0);
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, &result[0], sizeNeeded, nullptr, nullptr);
+    result.pop_back(); // Remove null terminator
+    return result;
+}
+
+// Command line tokens after the executable name, split like argv
+static std::vector<std::string> GetCommandLineArguments() {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        args.push_back(WideToUtf8(argv[i]));
+    }
+    LocalFree(argv);
+    return args;
+}
+
+// Whole-token match, as BatchRenderer::ParseArguments: a path containing a flag's name does not set it
+static bool HasFlag(const std::vector<std::string>& args, const char* flag) {
+    return std::find(args.begin(), args.end(), flag) != args.end();
+}
+
+// --headless / --benchmark: render the jobs of the command line without GUI and exit
+// Returns 0 when every job succeeded, 1 when one failed and 2 for invalid arguments
+static int RunHeadless(ACG::Renderer& renderer, HINSTANCE hInstance, const wchar_t* className,
+                       const std::vector<std::string>& args) {
+    // WIN32 subsystem: print to the calling console unless stdout is already redirected to a file or pipe
+    HANDLE stdOut = GetStdHandle(STD_OUTPUT_HANDLE);
+    if ((stdOut == nullptr || stdOut == INVALID_HANDLE_VALUE) && AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+        freopen_s(&stream, "CONOUT$", "w", stderr);
+    }
+    
+    ACG::BatchRenderer::Options options;
+    try {
+        options = ACG::BatchRenderer::ParseArguments(args);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl << ACG::BatchRenderer::GetUsage() << std::endl;
+        return 2;
+    }
+    
+    // The swap chain needs a window; it is never shown
+    HWND hwnd = CreateWindowEx(0, className, L"ACG Project - Headless", WS_OVERLAPPEDWINDOW,
+                               CW_USEDEFAULT, CW_USEDEFAULT, 1280, 720, nullptr, nullptr, hInstance, &renderer);
+    if (hwnd == nullptr) {
+        std::cerr << "Window creation failed" << std::endl;
+        return 1;
+    }
+    
+    int result = 1;
+    try {
+        renderer.OnInit(hwnd);
+        ACG::BatchRenderer batch(renderer);
+        result = batch.Run(options) == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "EXCEPTION CAUGHT: " << e.what() << std::endl;
+    }
+    renderer.OnDestroy();
+    DestroyWindow(hwnd);
+    return result;
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     // Get executable directory for default output path
     wchar_t exePath[MAX_PATH];
@@ -97,11 +151,14 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     std::wstring exeDirWStr = exePathWStr.substr(0, lastSlash);
     
     // Convert to UTF-8 string
-    int sizeNeeded = WideCharToMultiByte(CP_UTF8, 0, exeDirWStr.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    std::string exeDirStr(sizeNeeded, 0);
-    WideCharToMultiByte(CP_UTF8, 0, exeDirWStr.c_str(), -1, &exeDirStr[0], sizeNeeded, nullptr, nullptr);
-    exeDirStr.pop_back(); // Remove null terminator
-    g_exeDirectory = exeDirStr;
+    g_exeDirectory = WideToUtf8(exeDirWStr.c_str());
+    
+    const std::vector<std::string> args = GetCommandLineArguments();
+    
+    // --precompile-shaders: fill the DXIL cache (shadercache/) and exit; used by the precompile_shaders build target
+    if (HasFlag(args, "--precompile-shaders")) {
+        return ACG::Renderer::PrecompileShaders() ? 0 : 1;
+    }
     
     const wchar_t CLASS_NAME[] = L"ACG DXR Window Class";
 
@@ -122,6 +179,26 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     }
 
     ACG::Renderer renderer(1280, 720);
+    // --inline-rayquery: trace paths with DXR 1.1 RayQuery in RayGen (chosen when the pipeline is created)
+    if (HasFlag(args, "--inline-rayquery")) {
+        renderer.SetInlineRayQuery(true);
+    }
+    // --no-ser: keep Shader Execution Reordering off even where SM 6.9 is available
+    if (HasFlag(args, "--no-ser")) {
+        renderer.SetShaderExecutionReordering(false);
+    }
+    // --multi-gpu: offline renders also use every other DXR adapter (created in OnInit)
+    if (HasFlag(args, "--multi-gpu")) {
+        renderer.SetMultiGpu(true);
+    }
+    // --verbose: also log per-bucket, streaming and texture progress (Debug builds add per-pass Trace lines)
+    if (HasFlag(args, "--verbose")) {
+        ACG::Logger::Get().SetMinLevel(ACG::LogLevel::Debug);
+    }
+    
+    if (HasFlag(args, "--headless") || HasFlag(args, "--benchmark")) {
+        return RunHeadless(renderer, hInstance, CLASS_NAME, args);
+    }
 
     RECT windowRect = { 0, 0, 1280, 720 };
     AdjustWindowRect(&windowRect, WS_OVERLAPPEDWINDOW, FALSE);
@@ -152,15 +229,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     }
 
     try {
-        // Open log file
-        g_logFile.open("renderer.log", std::ios::out | std::ios::trunc);
-        if (g_logFile.is_open()) {
-            AddLogMessage("Log file opened successfully");
-        }
+        // Start the log writer (opens the log file)
+        ACG::Logger::Get().Start("renderer.log");
+        ACG::Logger::Get().Write(ACG::LogLevel::Info, "Log file opened successfully");
         
         // Set up log redirection (redirect std::cout and std::cerr to log)
-        g_coutRedirector = new ACG::LogRedirector(std::cout, AddLogMessage);
-        g_cerrRedirector = new ACG::LogRedirector(std::cerr, AddLogMessage);
+        g_coutRedirector = new ACG::LogRedirector(std::cout, ACG::LogLevel::Info);
+        g_cerrRedirector = new ACG::LogRedirector(std::cerr, ACG::LogLevel::Error);
         
         std::cout << "Initializing renderer..." << std::endl;
         renderer.OnInit(hwnd);
@@ -198,7 +273,6 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
         
         // Initialize GUI state
         GUI::InitializeGUIState(g_guiState, g_exeDirectory);
-        g_guiState.pLogMessages = &g_logMessages;
         
         ShowWindow(hwnd, nCmdShow);
         std::cout << "Window shown, entering main loop..." << std::endl;
@@ -261,9 +335,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
             delete g_cerrRedirector;
             g_cerrRedirector = nullptr;
         }
-        if (g_logFile.is_open()) {
-            g_logFile.close();
-        }
+        ACG::Logger::Get().Stop();
         
         FreeConsole();
         return static_cast<char>(msg.wParam);
@@ -271,7 +343,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     catch (const std::exception& e) {
         std::cerr << "EXCEPTION CAUGHT: " << e.what() << std::endl;
         std::string errorMsg = std::string("Fatal error: ") + e.what();
-        AddLogMessage(errorMsg);
+        ACG::Logger::Get().Write(ACG::LogLevel::Error, errorMsg);
         MessageBoxA(nullptr, e.what(), "Error", MB_OK | MB_ICONERROR);
         renderer.OnDestroy();
         
@@ -291,9 +363,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
             delete g_cerrRedirector;
             g_cerrRedirector = nullptr;
         }
-        if (g_logFile.is_open()) {
-            g_logFile.close();
-        }
+        ACG::Logger::Get().Stop();
         
         FreeConsole();
         return -1;
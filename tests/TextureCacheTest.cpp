@@ -0,0 +1,90 @@
+/*
+ * Texture cache round trip
+ * 将一条完整的压缩mip链写入 .texcache 并读回, 确认与同尺寸的单层条目互不覆盖
+ */
+
+#include "TextureCompression.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace ACG;
+
+namespace {
+
+int g_failures = 0;
+
+void Check(bool condition, const char* message) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", message);
+        g_failures++;
+    }
+}
+
+} // namespace
+
+int main() {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "acg_texcache_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // Only the source file's size and modification time are read
+    const std::string sourcePath = (directory / "source.png").string();
+    {
+        std::ofstream source(sourcePath, std::ios::binary);
+        source << "not really a png";
+    }
+    TextureCompressor::SetCacheDirectory((directory / "cache").string());
+    std::filesystem::create_directories(directory / "cache");
+
+    const BlockFormat format = BlockFormat::BC7;
+    const uint32_t width = 64;
+    const uint32_t height = 32;
+    const uint32_t mipLevels = 7;  // 64x32 down to 1x1
+
+    std::vector<uint8_t> chain(TextureCompressor::GetCompressedChainSize(format, width, height, mipLevels));
+    for (size_t i = 0; i < chain.size(); ++i) {
+        chain[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    Check(chain.size() > TextureCompressor::GetCompressedSize(format, width, height),
+          "a chain is larger than its first level");
+
+    TextureCompressor::StoreCached(sourcePath, format, width, height, mipLevels, chain);
+    std::vector<uint8_t> loaded;
+    Check(TextureCompressor::LoadCached(sourcePath, format, width, height, mipLevels, loaded),
+          "the stored chain is found");
+    Check(loaded == chain, "the loaded chain matches the stored one");
+
+    // The virtual texture system stores single levels of the same size under the same source
+    std::vector<uint8_t> level(TextureCompressor::GetCompressedSize(format, width, height), 0xAB);
+    TextureCompressor::StoreCached(sourcePath, format, width, height, 1, level);
+    loaded.clear();
+    Check(TextureCompressor::LoadCached(sourcePath, format, width, height, 1, loaded) && loaded == level,
+          "the single level is found");
+    loaded.clear();
+    Check(TextureCompressor::LoadCached(sourcePath, format, width, height, mipLevels, loaded) && loaded == chain,
+          "the chain survives storing a single level");
+
+    // Blocks that do not match the level count are not stored
+    std::vector<uint8_t> truncated(chain.begin(), chain.end() - 16);
+    TextureCompressor::StoreCached(sourcePath, format, width, height, mipLevels + 1, truncated);
+    Check(!TextureCompressor::LoadCached(sourcePath, format, width, height, mipLevels + 1, loaded),
+          "a chain of the wrong size is rejected");
+
+    // Touching the source invalidates its entries
+    {
+        std::ofstream source(sourcePath, std::ios::binary | std::ios::app);
+        source << " any more";
+    }
+    Check(!TextureCompressor::LoadCached(sourcePath, format, width, height, mipLevels, loaded),
+          "a changed source misses the cache");
+
+    TextureCompressor::SetCacheDirectory("");
+    std::filesystem::remove_all(directory);
+
+    if (g_failures == 0) {
+        std::printf("Texture cache round trip passed\n");
+    }
+    return g_failures == 0 ? 0 : 1;
+}